@@ -8,6 +8,7 @@ set(BASE_UNIX_AND_DARWIN_SRC
     src/unix/dir.cpp
     src/unix/dlunix.cpp
     src/unix/epolldispatcher.cpp
+    src/unix/iouringdispatcher.cpp
     src/unix/evtloopunix.cpp
     src/unix/fdiounix.cpp
     src/unix/snglinst.cpp
@@ -583,6 +583,9 @@ endforeach()
 wx_check_funcs(fsync
                snprintf vsnprintf strnlen strtoull
                setpriority
+               posix_spawn
+               posix_spawn_file_actions_addclosefrom_np
+               posix_spawn_file_actions_addchdir_np
                gettimeofday
                )
 
@@ -641,6 +644,9 @@ else()
         set(wxUSE_SELECT_DISPATCHER ON)
     endif()
     check_include_file(sys/epoll.h wxUSE_EPOLL_DISPATCHER)
+    if(wxUSE_EPOLL_DISPATCHER)
+        check_include_file(linux/io_uring.h HAVE_LINUX_IO_URING_H)
+    endif()
 endif()
 check_include_file(sys/select.h HAVE_SYS_SELECT_H)
 
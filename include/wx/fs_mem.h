@@ -15,6 +15,7 @@
 
 #include "wx/filesys.h"
 
+#include "wx/arrstr.h"
 #include "wx/hashmap.h"
 
 class wxMemoryFSFile;
@@ -24,6 +25,33 @@ WX_DECLARE_STRING_HASH_MAP(wxMemoryFSFile *, wxMemoryFSHash);
     #include "wx/bitmap.h"
 #endif // wxUSE_GUI
 
+// ----------------------------------------------------------------------------
+// wxMemoryFSStatistics: information about the memory FS usage
+// ----------------------------------------------------------------------------
+
+struct wxMemoryFSStatistics
+{
+    wxMemoryFSStatistics()
+    {
+        hits =
+        misses =
+        evictions = 0;
+        filesCount =
+        totalSize = 0;
+    }
+
+    // number of successful and failed OpenFile() calls
+    unsigned long hits,
+                  misses;
+
+    // number of files removed because the size limit was exceeded
+    unsigned long evictions;
+
+    // number of files currently stored and their total size in bytes
+    size_t filesCount,
+           totalSize;
+};
+
 // ----------------------------------------------------------------------------
 // wxMemoryFSHandlerBase
 // ----------------------------------------------------------------------------
@@ -49,6 +77,16 @@ public:
     // Remove file from memory FS and free occupied memory
     static void RemoveFile(const wxString& filename);
 
+    // Limit the total size of the stored files: when it is exceeded, the
+    // least recently used files are removed. 0 means no limit (default).
+    static void SetMaxSize(size_t size);
+    static size_t GetMaxSize();
+
+    // Get the usage statistics or reset the counters of the hits, misses and
+    // evictions.
+    static wxMemoryFSStatistics GetStatistics();
+    static void ResetStatistics();
+
     virtual bool CanOpen(const wxString& location) wxOVERRIDE;
     virtual wxFSFile* OpenFile(wxFileSystem& fs, const wxString& location) wxOVERRIDE;
     virtual wxString FindFirst(const wxString& spec, int flags = 0) wxOVERRIDE;
@@ -59,16 +97,19 @@ protected:
     // error and returns false if it does exist
     static bool CheckDoesntExist(const wxString& filename);
 
-    // the hash map indexed by the names of the files stored in the memory FS
-    static wxMemoryFSHash m_Hash;
+    // add the given file unless a file with the same name already exists, in
+    // which case an error is logged, the file is deleted and false returned
+    static bool DoAddFile(const wxString& filename, wxMemoryFSFile *file);
 
-    // the file name currently being searched for, i.e. the argument of the
-    // last FindFirst() call or empty string if FindFirst() hasn't been called
-    // yet
-    wxString m_findArgument;
+    // the hash map indexed by the names of the files stored in the memory FS,
+    // it must only be accessed while holding the lock used by the functions
+    // above as they can be called from any thread
+    static wxMemoryFSHash m_Hash;
 
-    // iterator into m_Hash used by FindFirst/Next(), possibly m_Hash.end()
-    wxMemoryFSHash::const_iterator m_findIter;
+    // the names of the files matching the argument of the last FindFirst()
+    // call and the index of the next one to be returned by FindNext()
+    wxArrayString m_findResults;
+    size_t m_findIndex;
 };
 
 // ----------------------------------------------------------------------------
@@ -20,6 +20,7 @@
 #include "wx/filename.h"
 #include "wx/dir.h"
 #include "wx/hashmap.h"
+#include "wx/vector.h"
 
 #define wxTRACE_FSWATCHER "fswatcher"
 
@@ -51,7 +52,11 @@ enum
     wxFSW_EVENT_ALL = wxFSW_EVENT_CREATE | wxFSW_EVENT_DELETE |
                          wxFSW_EVENT_RENAME | wxFSW_EVENT_MODIFY |
                          wxFSW_EVENT_ACCESS | wxFSW_EVENT_ATTRIB |
-                         wxFSW_EVENT_WARNING | wxFSW_EVENT_ERROR
+                         wxFSW_EVENT_WARNING | wxFSW_EVENT_ERROR,
+
+    // not a real change type but the type of the events carrying several
+    // changes at once, only used if batching is enabled
+    wxFSW_EVENT_BATCH = 0x100
 #if defined(wxHAS_INOTIFY) || defined(wxHAVE_FSEVENTS_FILE_NOTIFICATIONS)
     ,wxFSW_EVENT_UNMOUNT = 0x2000
 #endif
@@ -74,6 +79,36 @@ enum wxFSWWarningType
     wxFSW_WARNING_OVERFLOW
 };
 
+/**
+ * Information about a single change, several of them are carried by the
+ * events of wxFSW_EVENT_BATCH type.
+ */
+class wxFileSystemWatcherChange
+{
+public:
+    wxFileSystemWatcherChange(int changeType = 0,
+                              const wxFileName& path = wxFileName(),
+                              const wxFileName& newPath = wxFileName()) :
+        m_changeType(changeType),
+        m_path(path),
+        m_newPath(newPath)
+    {
+    }
+
+    int GetChangeType() const { return m_changeType; }
+    void SetChangeType(int changeType) { m_changeType = changeType; }
+
+    const wxFileName& GetPath() const { return m_path; }
+    const wxFileName& GetNewPath() const { return m_newPath; }
+
+private:
+    int m_changeType;
+    wxFileName m_path;
+    wxFileName m_newPath;
+};
+
+typedef wxVector<wxFileSystemWatcherChange> wxFileSystemWatcherChanges;
+
 /**
  * Event containing information about file system change.
  */
@@ -159,6 +194,23 @@ public:
         return m_changeType;
     }
 
+    /**
+     * Returns all the changes carried by a wxFSW_EVENT_BATCH event, this is
+     * empty for all the other events.
+     */
+    const wxFileSystemWatcherChanges& GetChanges() const
+    {
+        return m_changes;
+    }
+
+    /**
+     * Adds a change to a wxFSW_EVENT_BATCH event.
+     */
+    void AddChange(const wxFileSystemWatcherChange& change)
+    {
+        m_changes.push_back(change);
+    }
+
     virtual wxEvent* Clone() const wxOVERRIDE
     {
         wxFileSystemWatcherEvent* evt = new wxFileSystemWatcherEvent(*this);
@@ -166,6 +218,19 @@ public:
         evt->m_path = wxFileName(m_path.GetFullPath().Clone());
         evt->m_newPath = wxFileName(m_newPath.GetFullPath().Clone());
         evt->m_warningType = m_warningType;
+
+        // As above, ensure the copies don't share the string data.
+        for ( size_t n = 0; n < m_changes.size(); n++ )
+        {
+            const wxFileSystemWatcherChange& change = m_changes[n];
+            evt->m_changes[n] = wxFileSystemWatcherChange
+                                (
+                                    change.GetChangeType(),
+                                    wxFileName(change.GetPath().GetFullPath().Clone()),
+                                    wxFileName(change.GetNewPath().GetFullPath().Clone())
+                                );
+        }
+
         return evt;
     }
 
@@ -204,6 +269,7 @@ protected:
     wxFileName m_path;
     wxFileName m_newPath;
     wxString m_errorMsg;
+    wxFileSystemWatcherChanges m_changes;
 private:
     wxDECLARE_DYNAMIC_CLASS_NO_ASSIGN(wxFileSystemWatcherEvent);
 };
@@ -358,6 +424,27 @@ public:
             m_owner = handler;
     }
 
+    /**
+     * Delays the notifications about the changes by the given time, merging
+     * all the changes to the same path happening during it into a single
+     * event. Returns false if this is not supported.
+     */
+    virtual bool SetCoalescingDelay(int milliseconds);
+
+    /**
+     * Enables delivering all changes detected at once, or during the
+     * coalescing delay, in a single wxFSW_EVENT_BATCH event. Returns false if
+     * this is not supported.
+     */
+    virtual bool EnableBatching(bool enable = true);
+
+    /**
+     * Enables rescanning the watched directories which may have been affected
+     * by the events lost due to an overflow. Returns false if this is not
+     * supported.
+     */
+    virtual bool EnableOverflowRecovery(bool enable = true);
+
 
     // This is a semi-private function used by wxWidgets itself only.
     //
@@ -366,6 +453,12 @@ public:
     bool AddAny(const wxFileName& path, int events, wxFSWPathType type,
                 const wxString& filespec = wxString());
 
+    // Same as AddAny() but takes an already canonical path, as returned by
+    // GetCanonicalPath().
+    bool AddCanonicalPath(const wxString& canonical, int events,
+                          wxFSWPathType type,
+                          const wxString& filespec = wxString());
+
 protected:
 
     static wxString GetCanonicalPath(const wxFileName& path)
@@ -18,6 +18,8 @@
 #include "wx/image.h"
 #include "wx/animdecod.h"
 #include "wx/dynarray.h"
+#include "wx/buffer.h"
+#include "wx/vector.h"
 
 // internal utility used to store a frame in 8bit-per-pixel format
 class GIFImage;
@@ -52,7 +54,9 @@ public:
     wxGIFDecoder();
     ~wxGIFDecoder();
 
-    // get data of current frame
+    // get data of current frame, decoding it if necessary: the returned
+    // pointer is only valid until the frame is removed from the cache, which
+    // can happen when any other frame is decoded
     unsigned char* GetData(unsigned int frame) const;
     unsigned char* GetPalette(unsigned int frame) const;
     unsigned int GetNcolours(unsigned int frame) const;
@@ -74,6 +78,11 @@ public:
     // free all internal frames
     void Destroy();
 
+    // the frames are decoded when they're used and only this number of the
+    // most recently used ones is kept in memory (0 means to keep all of them)
+    void SetMaxCachedFrames(unsigned int frames);
+    unsigned int GetMaxCachedFrames() const { return m_maxCachedFrames; }
+
     // implementation of wxAnimationDecoder's pure virtuals
     virtual bool Load( wxInputStream& stream ) wxOVERRIDE
         { return LoadGIF(stream) == wxGIF_OK; }
@@ -91,20 +100,25 @@ protected:
         // modifies current stream position (see wxAnimationDecoder::CanRead)
 
 private:
-    int getcode(wxInputStream& stream, int bits, int abfin);
-    wxGIFErrorCode dgif(wxInputStream& stream,
-                        GIFImage *img, int interl, int bits);
+    wxGIFErrorCode dgif(GIFImage *img) const;
+
+    // decode the frame unless it's already cached and make it the most
+    // recently used one
+    wxGIFErrorCode DecodeFrame(unsigned int frame) const;
+
+    // remove the least recently used frames exceeding the cache size
+    void TrimCache() const;
 
 
     // array of all frames
     wxArrayPtrVoid m_frames;
 
-    // decoder state vars
-    int           m_restbits;       // remaining valid bits
-    unsigned int  m_restbyte;       // remaining bytes in this block
-    unsigned int  m_lastbyte;       // last byte read
-    unsigned char m_buffer[256];    // buffer for reading
-    unsigned char *m_bufp;          // pointer to next byte in buffer
+    // compressed data of all frames, without the sub-block size bytes
+    wxMemoryBuffer m_lzwData;
+
+    // the decoded frames, the most recently used one first
+    mutable wxVector<unsigned int> m_cachedFrames;
+    unsigned int m_maxCachedFrames;
 
     wxDECLARE_NO_COPY_CLASS(wxGIFDecoder);
 };
@@ -39,6 +39,9 @@
 #define wxIMAGE_OPTION_MAX_WIDTH             wxString(wxS("MaxWidth"))
 #define wxIMAGE_OPTION_MAX_HEIGHT            wxString(wxS("MaxHeight"))
 
+#define wxIMAGE_OPTION_MIN_WIDTH             wxString(wxS("MinWidth"))
+#define wxIMAGE_OPTION_MIN_HEIGHT            wxString(wxS("MinHeight"))
+
 #define wxIMAGE_OPTION_ORIGINAL_WIDTH        wxString(wxS("OriginalWidth"))
 #define wxIMAGE_OPTION_ORIGINAL_HEIGHT       wxString(wxS("OriginalHeight"))
 
@@ -83,6 +86,22 @@ enum wxImageAlphaBlendMode
     wxIMAGE_ALPHA_BLEND_COMPOSE = 1
 };
 
+// Constants for wxImage::SetPixelFormat() specifying how the pixel data is
+// stored in memory.
+enum wxImagePixelFormat
+{
+    // Default format: 3 bytes per pixel for RGB data and an optional separate
+    // array with 1 byte per pixel for alpha.
+    wxIMAGE_PIXEL_FORMAT_RGB = 0,
+
+    // 4 bytes per pixel in R, G, B, A order, alpha is not premultiplied.
+    wxIMAGE_PIXEL_FORMAT_RGBA = 1,
+
+    // 32 bit native-endian values with alpha in the upper 8 bits followed by
+    // premultiplied red, green and blue, i.e. the same as CAIRO_FORMAT_ARGB32.
+    wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED = 2
+};
+
 // alpha channel values: fully transparent, default threshold separating
 // transparent pixels from opaque for a few functions dealing with alpha and
 // fully opaque
@@ -334,6 +353,10 @@ public:
     bool Create( const wxSize& sz, unsigned char* data, unsigned char* alpha, bool static_data = false )
         { return Create(sz.GetWidth(), sz.GetHeight(), data, alpha, static_data); }
 
+    // Create an image storing its pixels in the given format, if clear is
+    // true, all pixels are initialized to transparent black.
+    bool Create( int width, int height, wxImagePixelFormat format, bool clear = true );
+
     void Destroy();
 
     // initialize the image data with zeroes
@@ -375,6 +398,9 @@ public:
     wxImage BlurHorizontal(int radius) const;
     wxImage BlurVertical(int radius) const;
 
+    // blur the image using Gaussian kernel with the given standard deviation
+    wxImage GaussianBlur(double sigma) const;
+
     wxImage ShrinkBy( int xFactor , int yFactor ) const ;
 
     // rescales the image in place
@@ -411,6 +437,10 @@ public:
     // Convert to disabled (dimmed) image.
     wxImage ConvertToDisabled(unsigned char brightness = 255) const;
 
+    // Return the image with the lightness of all pixels changed, see
+    // wxColour::ChangeLightness().
+    wxImage ChangeLightness(int alpha) const;
+
     // these routines are slow but safe
     void SetRGB( int x, int y, unsigned char r, unsigned char g, unsigned char b );
     void SetRGB( const wxRect& rect, unsigned char r, unsigned char g, unsigned char b );
@@ -510,11 +540,20 @@ public:
     void SetData( unsigned char *data, int new_width, int new_height, bool static_data=false );
 
     unsigned char *GetAlpha() const;    // may return NULL!
-    bool HasAlpha() const { return GetAlpha() != NULL; }
+    bool HasAlpha() const;
     void SetAlpha(unsigned char *alpha = NULL, bool static_data=false);
     void InitAlpha();
     void ClearAlpha();
 
+    // change the format used for storing the pixel data in memory, GetData()
+    // and GetAlpha() convert it back to wxIMAGE_PIXEL_FORMAT_RGB when needed
+    bool SetPixelFormat(wxImagePixelFormat format);
+    wxImagePixelFormat GetPixelFormat() const;
+
+    // return the pixel data in the format returned by GetPixelFormat() with
+    // 4*GetWidth() bytes per row, or NULL if the image uses the RGB format
+    unsigned char *GetPixels() const;
+
     // return true if this pixel is masked or has alpha less than specified
     // threshold
     bool IsTransparent(int x, int y,
@@ -577,6 +616,12 @@ public:
     static HSVValue RGBtoHSV(const RGBValue& rgb);
     static RGBValue HSVtoRGB(const HSVValue& hsv);
 
+    // Set the maximal number of threads used for processing big images, 0
+    // means to use as many threads as there are CPUs and 1 disables the use
+    // of multiple threads.
+    static void SetMaxThreads(int threads);
+    static int GetMaxThreads();
+
 #if WXWIN_COMPATIBILITY_2_8
     wxDEPRECATED_CONSTRUCTOR(
         wxImage(const wxString& name, long type, int index = -1)
@@ -670,6 +715,10 @@ private:
     // modified versions of this image.
     wxImage MakeEmptyClone(int flags = Clone_SameOrientation) const;
 
+    // Convert the pixel data to RGB format if it's currently stored in
+    // another one, this is used by all functions working with RGB data.
+    void EnsureRGBFormat() const;
+
 #if wxUSE_STREAMS
     // read the image from the specified stream updating image type if
     // successful
@@ -20,6 +20,8 @@
 #include "wx/image.h"
 #include "wx/versioninfo.h"
 
+#define wxIMAGE_OPTION_JPEG_FAST_IDCT   wxString(wxS("JpegFastIDCT"))
+
 class WXDLLIMPEXP_CORE wxJPEGHandler: public wxImageHandler
 {
 public:
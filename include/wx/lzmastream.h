@@ -23,6 +23,9 @@ namespace wxPrivate
 // Private wrapper for lzma_stream struct.
 struct wxLZMAStream;
 
+// Private data used by wxLZMAInputStream for seeking.
+struct wxLZMASeekData;
+
 // Common part of input and output LZMA streams: this is just an implementation
 // detail and is not part of the public API.
 class WXDLLIMPEXP_BASE wxLZMAData
@@ -34,6 +37,7 @@ protected:
     wxLZMAStream* m_stream;
     wxUint8* m_streamBuf;
     wxFileOffset m_pos;
+    int m_threads;
 
     wxDECLARE_NO_COPY_CLASS(wxLZMAData);
 };
@@ -60,15 +64,40 @@ public:
         Init();
     }
 
+    virtual ~wxLZMAInputStream();
+
+    // Use the given number of threads (0 for as many as CPUs) for decoding,
+    // must be called before reading anything.
+    bool SetThreadCount(int threads);
+    int GetThreadCount() const { return m_threads; }
+
+    // Read the index of the xz data from the seekable parent stream, making
+    // this stream seekable too.
+    bool LoadIndex();
+
     char Peek() wxOVERRIDE { return wxInputStream::Peek(); }
-    wxFileOffset GetLength() const wxOVERRIDE { return wxInputStream::GetLength(); }
+    wxFileOffset GetLength() const wxOVERRIDE;
+    bool IsSeekable() const wxOVERRIDE { return m_seek != NULL; }
 
 protected:
     size_t OnSysRead(void *buffer, size_t size) wxOVERRIDE;
     wxFileOffset OnSysTell() const wxOVERRIDE { return m_pos; }
+    wxFileOffset OnSysSeek(wxFileOffset pos, wxSeekMode mode) wxOVERRIDE;
 
 private:
     void Init();
+
+    // Initialize the decoder to decode the block containing the current
+    // position of the index iterator.
+    bool StartBlock();
+
+    // Decode and discard the given number of bytes.
+    bool Skip(wxFileOffset count);
+
+    wxPrivate::wxLZMASeekData* m_seek;
+
+    // Position of the start of the compressed data in the parent stream.
+    wxFileOffset m_parentStart;
 };
 
 // ----------------------------------------------------------------------------
@@ -93,6 +122,12 @@ public:
 
     virtual ~wxLZMAOutputStream() { Close(); }
 
+    // Use the given number of threads (0 for as many as CPUs) for encoding
+    // blocks of the given size (0 for default) concurrently, must be called
+    // before writing anything.
+    bool SetThreadCount(int threads, size_t blockSize = 0);
+    int GetThreadCount() const { return m_threads; }
+
     void Sync() wxOVERRIDE { DoFlush(false); }
     bool Close() wxOVERRIDE;
     wxFileOffset GetLength() const wxOVERRIDE { return m_pos; }
@@ -115,6 +150,8 @@ private:
     // Run LZMA_FINISH (if argument is true) or LZMA_FULL_FLUSH, return true on
     // success or false on error.
     bool DoFlush(bool finish);
+
+    int m_level;
 };
 
 // ----------------------------------------------------------------------------
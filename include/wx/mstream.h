@@ -26,11 +26,13 @@ public:
     wxMemoryInputStream(const wxMemoryOutputStream& stream);
     wxMemoryInputStream(wxInputStream& stream,
                         wxFileOffset lenFile = wxInvalidOffset)
+        : m_dataOwner(NULL)
     {
         InitFromStream(stream, lenFile);
     }
     wxMemoryInputStream(wxMemoryInputStream& stream)
-        : wxInputStream()
+        : wxInputStream(),
+          m_dataOwner(NULL)
     {
         InitFromStream(stream, wxInvalidOffset);
     }
@@ -55,8 +57,16 @@ private:
     // common part of ctors taking wxInputStream
     void InitFromStream(wxInputStream& stream, wxFileOffset lenFile);
 
+    // helper of InitFromStream() sharing the data of a mapped file stream
+    bool InitFromMappedStream(wxInputStream& stream, wxFileOffset lenFile);
+
     size_t m_length;
 
+    // if non-NULL, the object owning the memory we use and which we hold a
+    // reference to, otherwise the memory is owned by m_i_streambuf or the
+    // caller
+    wxRefCounter *m_dataOwner;
+
     // copy ctor is implemented above: it copies the other stream in this one
     wxDECLARE_ABSTRACT_CLASS(wxMemoryInputStream);
     wxDECLARE_NO_ASSIGN_CLASS(wxMemoryInputStream);
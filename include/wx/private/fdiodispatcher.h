@@ -19,15 +19,29 @@ enum wxFDIODispatcherEntryFlags
     wxFDIO_INPUT = 1,
     wxFDIO_OUTPUT = 2,
     wxFDIO_EXCEPTION = 4,
-    wxFDIO_ALL = wxFDIO_INPUT | wxFDIO_OUTPUT | wxFDIO_EXCEPTION
+    wxFDIO_ALL = wxFDIO_INPUT | wxFDIO_OUTPUT | wxFDIO_EXCEPTION,
+
+    // this flag can be combined with the ones above by the handlers which
+    // always read or write until EAGAIN, as they will only be notified when
+    // the descriptor state changes; it's ignored by wxSelectDispatcher
+    wxFDIO_EDGE_TRIGGERED = 8
 };
 
-// base class for wxSelectDispatcher and wxEpollDispatcher
+// base class for wxSelectDispatcher, wxEpollDispatcher and wxIOUringDispatcher
 class WXDLLIMPEXP_BASE wxFDIODispatcher
 {
 public:
     enum { TIMEOUT_INFINITE = -1 };
 
+    // the kinds of dispatchers which can be created by Create()
+    enum Kind
+    {
+        Kind_Default,   // epoll if available, select otherwise
+        Kind_Select,
+        Kind_Epoll,
+        Kind_IOUring
+    };
+
     // return the global dispatcher to be used for IO events, can be NULL only
     // if wxSelectDispatcher wasn't compiled into the library at all as
     // creating it never fails
@@ -35,6 +49,19 @@ public:
     // don't delete the returned pointer
     static wxFDIODispatcher *Get();
 
+    // set the kind of the dispatcher returned by Get(), this can only be done
+    // before it is called for the first time and returns false otherwise
+    //
+    // if this function is not called, WXFDIO_DISPATCHER environment variable
+    // is checked for "select", "epoll" or "io_uring" value
+    static bool SetDefaultKind(Kind kind);
+
+    // create a new dispatcher of the given kind, falling back to epoll and
+    // then select if it can't be created
+    //
+    // the caller should delete the returned pointer
+    static wxFDIODispatcher *Create(Kind kind = Kind_Default);
+
     // if we have any registered handlers, check for any pending events to them
     // and dispatch them -- this is used from wxX11 and wxDFB event loops
     // implementation
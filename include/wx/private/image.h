@@ -0,0 +1,28 @@
+///////////////////////////////////////////////////////////////////////////////
+// Name:        wx/private/image.h
+// Purpose:     Helpers for processing big images in parallel
+// Author:      wxWidgets team
+// Created:     2020-10-19
+// Copyright:   (c) 2020 wxWidgets development team
+// Licence:     wxWindows licence
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _WX_PRIVATE_IMAGE_H_
+#define _WX_PRIVATE_IMAGE_H_
+
+#include "wx/defs.h"
+
+// Function processing the rows in [y0, y1) range of an image.
+typedef void (*wxImageRowsFunc)(const void *data, int y0, int y1);
+
+// Return the number of threads used by wxProcessImageRows() for the given
+// number of rows and pixels, taking wxImage::SetMaxThreads() into account.
+WXDLLIMPEXP_CORE int wxGetImageRowsThreads(int height, size_t pixels);
+
+// Call the given function for all rows in [0, height) range, possibly in
+// parallel if the number of pixels processed is big enough. The function may
+// be called from several threads at once for disjoint ranges of rows.
+WXDLLIMPEXP_CORE void wxProcessImageRows(wxImageRowsFunc func, const void *data,
+                                         int height, size_t pixels);
+
+#endif // _WX_PRIVATE_IMAGE_H_
@@ -42,6 +42,7 @@
 
 #include "wx/socket.h"
 #include "wx/private/sckaddr.h"
+#include "wx/filefn.h"
 
 #include <stddef.h>
 
@@ -182,6 +183,7 @@ public:
     // creating the socket
     void SetTimeout(unsigned long millisec);
     void SetReusable() { m_reusable = true; }
+    void SetReusablePort() { m_reusablePort = true; }
     void SetBroadcast() { m_broadcast = true; }
     void DontDoBind() { m_dobind = false; }
     void SetInitialSocketBuffers(int recv, int send)
@@ -256,6 +258,20 @@ public:
     int Read(void *buffer, int size);
     int Write(const void *buffer, int size);
 
+    // scatter/gather versions of the functions above, they may use only
+    // some of the buffers on the platforms not supporting this natively
+    int ReadV(const wxSocketBuffer *buffers, int count);
+    int WriteV(const wxSocketBuffer *buffers, int count);
+
+#ifdef __LINUX__
+    // send up to size bytes from the given file descriptor, starting at the
+    // given offset unless it's a pipe, directly from the kernel
+    //
+    // returns the number of bytes sent, 0 at the end of file or -1 on error,
+    // the error is wxSOCKET_INVOP if this is not supported for this fd
+    int SendFile(int fd, wxFileOffset offset, int size, bool isPipe);
+#endif // __LINUX__
+
     // basically a wrapper for select(): returns the condition of the socket,
     // blocking for not longer than timeout if it is specified (otherwise just
     // poll without blocking at all)
@@ -311,6 +327,7 @@ public:
     bool m_stream;
     bool m_establishing;
     bool m_reusable;
+    bool m_reusablePort;
     bool m_broadcast;
     bool m_dobind;
 
@@ -364,6 +381,9 @@ private:
     int SendStream(const void *buffer, int size);
     int SendDgram(const void *buffer, int size);
 
+    // called when 0 bytes are received from a stream socket
+    void OnStreamClosed();
+
 
     // set in ctor and never changed except that it's reset to NULL when the
     // socket is shut down
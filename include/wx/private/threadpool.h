@@ -0,0 +1,172 @@
+///////////////////////////////////////////////////////////////////////////////
+// Name:        wx/private/threadpool.h
+// Purpose:     wxThreadPool: simple pool of worker threads
+// Author:      wxWidgets team
+// Created:     2020-10-07
+// Copyright:   (c) 2020 wxWidgets development team
+// Licence:     wxWindows licence
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _WX_PRIVATE_THREADPOOL_H_
+#define _WX_PRIVATE_THREADPOOL_H_
+
+#include "wx/defs.h"
+
+#if wxUSE_THREADS
+
+#include "wx/msgqueue.h"
+#include "wx/thread.h"
+#include "wx/vector.h"
+
+// ----------------------------------------------------------------------------
+// wxThreadPoolTask: base class for the tasks executed by wxThreadPool
+// ----------------------------------------------------------------------------
+
+class wxThreadPoolTask
+{
+public:
+    wxThreadPoolTask() : m_doneCond(m_doneMutex), m_done(false) { }
+    virtual ~wxThreadPoolTask() { }
+
+    // Check if the task has been executed, without blocking.
+    bool IsDone() const
+    {
+        wxMutexLocker lock(m_doneMutex);
+        return m_done;
+    }
+
+    // Block until the task is executed.
+    void Wait()
+    {
+        wxMutexLocker lock(m_doneMutex);
+        while ( !m_done )
+            m_doneCond.Wait();
+    }
+
+protected:
+    // This function is called from one of the pool threads and must not use
+    // any GUI functions nor log anything.
+    virtual void Run() = 0;
+
+private:
+    void Execute()
+    {
+        Run();
+
+        wxMutexLocker lock(m_doneMutex);
+        m_done = true;
+        m_doneCond.Broadcast();
+    }
+
+    mutable wxMutex m_doneMutex;
+    wxCondition m_doneCond;
+    bool m_done;
+
+    friend class wxThreadPool;
+
+    wxDECLARE_NO_COPY_CLASS(wxThreadPoolTask);
+};
+
+// ----------------------------------------------------------------------------
+// wxThreadPool: executes the submitted tasks using a fixed number of threads
+// ----------------------------------------------------------------------------
+
+class wxThreadPool
+{
+public:
+    // Create the pool with the given number of threads, 0 means to use as
+    // many threads as there are CPUs in the system.
+    explicit wxThreadPool(int threads = 0)
+    {
+        if ( threads <= 0 )
+            threads = GetDefaultThreadCount();
+
+        for ( int n = 0; n < threads; n++ )
+        {
+            Worker * const worker = new Worker(m_queue);
+            if ( worker->Run() != wxTHREAD_NO_ERROR )
+            {
+                delete worker;
+                break;
+            }
+
+            m_workers.push_back(worker);
+        }
+    }
+
+    // Waits until all the tasks already submitted are executed.
+    ~wxThreadPool()
+    {
+        for ( size_t n = 0; n < m_workers.size(); n++ )
+            m_queue.Post(NULL);
+
+        for ( size_t n = 0; n < m_workers.size(); n++ )
+        {
+            m_workers[n]->Wait();
+            delete m_workers[n];
+        }
+    }
+
+    // Return the number of threads really used by the pool, if none could be
+    // created, the tasks are executed synchronously by Submit().
+    int GetThreadCount() const { return static_cast<int>(m_workers.size()); }
+
+    // Queue the task for execution by one of the threads. The task is not
+    // owned by the pool and must remain alive until it is executed, which can
+    // be checked using its Wait() or IsDone() method.
+    void Submit(wxThreadPoolTask *task)
+    {
+        if ( m_workers.empty() )
+            Execute(task);
+        else
+            m_queue.Post(task);
+    }
+
+    static int GetDefaultThreadCount()
+    {
+        const int count = wxThread::GetCPUCount();
+        return count > 0 ? count : 1;
+    }
+
+private:
+    typedef wxMessageQueue<wxThreadPoolTask *> Queue;
+
+    static void Execute(wxThreadPoolTask *task) { task->Execute(); }
+
+    class Worker : public wxThread
+    {
+    public:
+        explicit Worker(Queue& queue)
+            : wxThread(wxTHREAD_JOINABLE),
+              m_queue(queue)
+        {
+        }
+
+    protected:
+        virtual ExitCode Entry() wxOVERRIDE
+        {
+            for ( ;; )
+            {
+                wxThreadPoolTask *task = NULL;
+                if ( m_queue.Receive(task) != wxMSGQUEUE_NO_ERROR || !task )
+                    break;
+
+                wxThreadPool::Execute(task);
+            }
+
+            return NULL;
+        }
+
+    private:
+        Queue& m_queue;
+    };
+
+    Queue m_queue;
+    wxVector<Worker *> m_workers;
+
+    wxDECLARE_NO_COPY_CLASS(wxThreadPool);
+};
+
+#endif // wxUSE_THREADS
+
+#endif // _WX_PRIVATE_THREADPOOL_H_
@@ -10,9 +10,11 @@
 #ifndef _WX_PRIVATE_WEBREQUEST_H_
 #define _WX_PRIVATE_WEBREQUEST_H_
 
+#include "wx/atomic.h"
 #include "wx/ffile.h"
 #include "wx/hashmap.h"
 #include "wx/scopedptr.h"
+#include "wx/time.h"
 
 #include "wx/private/refcountermt.h"
 
@@ -69,6 +71,15 @@ public:
 
     wxWebRequest::Storage GetStorage() const { return m_storage; }
 
+    // Returns false if the sink is not supported by this backend, otherwise
+    // takes ownership of it and switches to Storage_None.
+    bool SetDataSink(wxScopedPtr<wxWebRequestSink>& sink);
+
+    wxWebRequestSink* GetDataSink() const { return m_dataSink.get(); }
+
+    void SetProgressInterval(int milliseconds)
+        { m_progressInterval = milliseconds; }
+
     // Precondition for this method checked by caller: current state is idle.
     virtual void Start() = 0;
 
@@ -76,6 +87,9 @@ public:
     // cancelled.
     void Cancel();
 
+    // Can be called from any thread, calls DoResume() in the main one.
+    void Resume();
+
     virtual wxWebResponseImplPtr GetResponse() const = 0;
 
     virtual wxWebAuthChallengeImplPtr GetAuthChallenge() const = 0;
@@ -108,6 +122,8 @@ public:
 
     void ProcessStateEvent(wxWebRequest::State state, const wxString& failMsg);
 
+    void ProcessProgressEvent();
+
 protected:
     wxString m_method;
     wxWebRequest::Storage m_storage;
@@ -123,6 +139,10 @@ protected:
 
     bool WasCancelled() const { return m_cancelled; }
 
+    // Must be overridden to return true by the backends implementing pausing
+    // the transfer when the data sink returns Result_Pause.
+    virtual bool SupportsDataSink() const { return false; }
+
     // Call SetState() with either State_Failed or State_Completed appropriate
     // for the response status.
     void SetFinalStateFromStatus();
@@ -131,12 +151,22 @@ private:
     // Called from public Cancel() at most once per object.
     virtual void DoCancel() = 0;
 
+    // Called from Resume() in the main thread only.
+    virtual void DoResume() { }
+
     wxWebSession& m_session;
     wxEvtHandler* const m_handler;
     const int m_id;
     wxWebRequest::State m_state;
     wxFileOffset m_bytesReceived;
     wxCharBuffer m_dataText;
+    wxScopedPtr<wxWebRequestSink> m_dataSink;
+
+    // Progress events are sent at most once per m_progressInterval and only
+    // if the previously sent event has been already processed.
+    int m_progressInterval;
+    wxMilliClock_t m_lastProgress;
+    wxAtomicInt m_progressPending;
 
     // Initially false, set to true after the first call to Cancel().
     bool m_cancelled;
@@ -241,6 +271,16 @@ public:
 
     const wxWebRequestHeaderMap& GetHeaders() const { return m_headers; }
 
+    // Connection management options are not supported by default, the
+    // backends supporting them override these functions to return true.
+    virtual bool SetMaxConnectionsPerHost(int WXUNUSED(count)) { return false; }
+    virtual bool SetMaxConnections(int WXUNUSED(count)) { return false; }
+    virtual bool EnableMultiplexing(bool WXUNUSED(enable)) { return false; }
+    virtual bool SetKeepAlive(int WXUNUSED(idle), int WXUNUSED(interval))
+        { return false; }
+    virtual bool SetMaxIdleTime(int WXUNUSED(seconds)) { return false; }
+    virtual bool EnableSharedCache(bool WXUNUSED(enable)) { return false; }
+
     virtual wxWebSessionHandle GetNativeHandle() const = 0;
 
 protected:
@@ -79,9 +79,14 @@ public:
     // Method called from libcurl callback
     size_t CURLOnRead(char* buffer, size_t size);
 
+protected:
+    bool SupportsDataSink() const wxOVERRIDE { return true; }
+
 private:
     void DoCancel() wxOVERRIDE;
 
+    void DoResume() wxOVERRIDE;
+
     wxWebSessionCURL& m_sessionImpl;
 
     CURL* m_handle;
@@ -148,6 +153,16 @@ public:
         return (wxWebSessionHandle)m_handle;
     }
 
+    bool SetMaxConnectionsPerHost(int count) wxOVERRIDE;
+    bool SetMaxConnections(int count) wxOVERRIDE;
+    bool EnableMultiplexing(bool enable) wxOVERRIDE;
+    bool SetKeepAlive(int idle, int interval) wxOVERRIDE;
+    bool SetMaxIdleTime(int seconds) wxOVERRIDE;
+    bool EnableSharedCache(bool enable) wxOVERRIDE;
+
+    // Apply the session connection options to the easy handle of a new request.
+    void SetupRequestHandle(CURL* curl) const;
+
     bool StartRequest(wxWebRequestCURL& request);
 
     void CancelRequest(wxWebRequestCURL* request);
@@ -160,6 +175,9 @@ public:
 private:
     static int TimerCallback(CURLM*, long, void*);
     static int SocketCallback(CURL*, curl_socket_t, int, void*, void*);
+    static void ShareLockCallback(CURL*, curl_lock_data, curl_lock_access,
+                                  void*);
+    static void ShareUnlockCallback(CURL*, curl_lock_data, void*);
 
     void ProcessTimerCallback(long);
     void TimeoutNotification(wxTimerEvent&);
@@ -170,6 +188,7 @@ private:
     void FailRequest(CURL*, const wxString&);
     void StopActiveTransfer(CURL*);
     void RemoveActiveSocket(CURL*);
+    void ApplyMultiOptions();
 
     WX_DECLARE_HASH_MAP(CURL*, wxWebRequestCURL*, wxPointerHash, \
                         wxPointerEqual, TransferSet);
@@ -184,6 +203,24 @@ private:
     wxTimer m_timeoutTimer;
     CURLM* m_handle;
 
+    // Connection options, negative values mean that the option is not set
+    // and libcurl default is used.
+    long m_maxConnectionsPerHost;
+    long m_maxConnections;
+    long m_multiplexing;
+    long m_keepAliveIdle;
+    long m_keepAliveInterval;
+    long m_maxIdleTime;
+
+    // Share handle created by EnableSharedCache(), may be NULL, and whether
+    // it should be used for the new requests.
+    CURLSH* m_share;
+    bool m_useShare;
+
+    // Locks protecting the data shared using m_share, indexed by
+    // curl_lock_data.
+    wxCriticalSection m_shareLocks[CURL_LOCK_DATA_LAST];
+
     static int ms_activeSessions;
     static unsigned int ms_runtimeVersion;
 
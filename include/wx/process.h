@@ -99,6 +99,16 @@ public:
     bool IsInputAvailable() const;
     bool IsErrorAvailable() const;
 
+    // call this before passing the object to wxExecute() to have the child
+    // process stdout (and stderr if err is non-NULL) written to the given
+    // streams as soon as it's available instead of making it available via
+    // GetInputStream() (and GetErrorStream()), the streams are not owned
+    //
+    // this is currently only implemented under Unix
+    void SetOutputSink(wxOutputStream *out, wxOutputStream *err = NULL);
+    wxOutputStream *GetOutputSink() const { return m_outputSink; }
+    wxOutputStream *GetErrorSink() const { return m_errorSink; }
+
     // implementation only (for wxExecute)
     //
     // NB: the streams passed here should correspond to the child process
@@ -139,6 +149,10 @@ protected:
     wxInputStream  *m_inputStream,
                    *m_errorStream;
     wxOutputStream *m_outputStream;
+
+    // the streams receiving the child process stdout and stderr, not owned
+    wxOutputStream *m_outputSink,
+                   *m_errorSink;
 #endif // wxUSE_STREAMS
 
     bool m_redirect;
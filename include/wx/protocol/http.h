@@ -17,6 +17,11 @@
 #include "wx/hashmap.h"
 #include "wx/protocol/protocol.h"
 #include "wx/buffer.h"
+#include "wx/vector.h"
+
+#if wxUSE_THREADS
+    #include "wx/thread.h"
+#endif
 
 class WXDLLIMPEXP_NET wxHTTP : public wxProtocol
 {
@@ -41,8 +46,19 @@ public:
                      const wxString& data,
                      const wxMBConv& conv = wxConvUTF8);
     bool SetPostBuffer(const wxString& contentType, const wxMemoryBuffer& data);
+
+    // takes ownership of the stream, if the size is not specified, the data
+    // is sent using chunked transfer encoding
+    bool SetPostStream(const wxString& contentType,
+                       wxInputStream *stream,
+                       wxFileOffset size = wxInvalidOffset);
     void SetProxyMode(bool on);
 
+    // keep the connection open after the response is read to reuse it for
+    // the next request
+    void SetKeepAlive(bool on = true) { m_keepAlive = on; }
+    bool IsKeepAlive() const { return m_keepAlive; }
+
     /* Cookies */
     wxString GetCookie(const wxString& cookie) const;
     bool HasCookies() const { return m_cookies.size() > 0; }
@@ -60,6 +76,21 @@ protected:
     void SendHeaders();
     bool ParseHeaders();
 
+    // read everything available from the socket, waiting only if there is
+    // nothing to read yet
+    wxUint32 ReadAvailable(void *buffer, wxUint32 size);
+
+    // read data until the given terminator into the buffer, the data after
+    // it is pushed back into the socket; fails if the terminator is not
+    // found in the first maxSize bytes
+    bool ReadUntil(const char *terminator, wxMemoryBuffer& buf, size_t maxSize);
+
+    // send the request body from m_postStream
+    bool SendPostStream();
+
+    // called by the input stream when it is destroyed
+    void OnStreamDone(bool complete);
+
     wxString GenerateAuthString(const wxString& user, const wxString& pass) const;
 
     // find the header in m_headers
@@ -85,11 +116,59 @@ protected:
     wxString       m_contentType;
     int m_http_response;
 
+    wxInputStream *m_postStream;
+    wxFileOffset m_postStreamSize;
+
+    // the value of Host header to use for the requests
+    wxString m_hostHeader;
+
+    // the raw status line and headers of the last response
+    wxMemoryBuffer m_responseHead;
+
+    bool m_keepAlive,
+         m_reusable;
+
+    friend class wxHTTPStream;
+
     wxDECLARE_DYNAMIC_CLASS(wxHTTP);
     DECLARE_PROTOCOL(wxHTTP)
     wxDECLARE_NO_COPY_CLASS(wxHTTP);
 };
 
+// Pool of wxHTTP objects connected to the same server, allowing to reuse the
+// persistent connections for several requests.
+class WXDLLIMPEXP_NET wxHTTPConnectionPool
+{
+public:
+    wxHTTPConnectionPool(const wxString& host,
+                         unsigned short port = 0,
+                         size_t maxIdle = 4);
+    ~wxHTTPConnectionPool();
+
+    // get an idle connection or create a new one, may return NULL only if
+    // the host name couldn't be resolved
+    wxHTTP *Acquire();
+
+    // give back the object returned by Acquire() after destroying the stream
+    // returned by its GetInputStream(), it is deleted if it can't be reused
+    void Release(wxHTTP *http);
+
+    size_t GetIdleCount() const;
+
+private:
+    const wxString m_host;
+    const unsigned short m_port;
+    const size_t m_maxIdle;
+
+    wxVector<wxHTTP *> m_idle;
+
+#if wxUSE_THREADS
+    mutable wxCriticalSection m_cs;
+#endif // wxUSE_THREADS
+
+    wxDECLARE_NO_COPY_CLASS(wxHTTPConnectionPool);
+};
+
 #endif // wxUSE_PROTOCOL_HTTP
 
 #endif // _WX_HTTP_H
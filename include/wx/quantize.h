@@ -32,6 +32,9 @@ class WXDLLIMPEXP_FWD_CORE wxPalette;
 #define wxQUANTIZE_INCLUDE_WINDOWS_COLOURS      0x01
 #define wxQUANTIZE_RETURN_8BIT_DATA             0x02
 #define wxQUANTIZE_FILL_DESTINATION_IMAGE       0x04
+#define wxQUANTIZE_NO_DITHER                    0x08
+#define wxQUANTIZE_ORDERED_DITHER               0x10
+#define wxQUANTIZE_USE_PALETTE                  0x20
 
 class WXDLLIMPEXP_CORE wxQuantize: public wxObject
 {
@@ -69,6 +72,11 @@ public:
     // fills out_rows with indexes into palette (which is also stored into palette variable)
     static void DoQuantize(unsigned w, unsigned h, unsigned char **in_rows, unsigned char **out_rows, unsigned char *palette, int desiredNoColours);
 
+    // Same as above, but the dithering used can be selected using the flags
+    // and, if wxQUANTIZE_USE_PALETTE is specified, the palette is used as the
+    // input containing desiredNoColours colours to map the image to.
+    static void DoQuantize(unsigned w, unsigned h, unsigned char **in_rows, unsigned char **out_rows, unsigned char *palette, int desiredNoColours, int flags);
+
 };
 
 #endif
@@ -77,6 +77,10 @@ public:
     // for now.
     void Compress(bool on);
 
+    // Return true if the data is transferred using shared memory instead of
+    // the socket for this connection, see wxTCPClient::SetSharedMemorySize().
+    bool UsesSharedMemory() const;
+
 
 protected:
     virtual bool DoExecute(const void *data, size_t size, wxIPCFormat format) wxOVERRIDE;
@@ -150,7 +154,15 @@ public:
     // Callbacks to CLIENT - override at will
     virtual wxConnectionBase *OnMakeConnection() wxOVERRIDE;
 
+    // Use a shared memory block with rings of the given size for each
+    // direction for the connections made to the local servers if possible,
+    // 0 (default) disables the use of shared memory.
+    void SetSharedMemorySize(size_t size) { m_sharedMemorySize = size; }
+    size_t GetSharedMemorySize() const { return m_sharedMemorySize; }
+
 private:
+    size_t m_sharedMemorySize;
+
     wxDECLARE_DYNAMIC_CLASS(wxTCPClient);
 };
 
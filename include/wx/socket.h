@@ -22,8 +22,11 @@
 #include "wx/event.h"
 #include "wx/sckaddr.h"
 #include "wx/list.h"
+#include "wx/vector.h"
+#include "wx/filefn.h"     // for wxFileOffset and wxInvalidOffset
 
 class wxSocketImpl;
+class WXDLLIMPEXP_FWD_BASE wxFile;
 
 // ------------------------------------------------------------------------
 // Types and constants
@@ -90,7 +93,8 @@ enum
     wxSOCKET_BLOCK          = 0x0010,
     wxSOCKET_REUSEADDR      = 0x0020,
     wxSOCKET_BROADCAST      = 0x0040,
-    wxSOCKET_NOBIND         = 0x0080
+    wxSOCKET_NOBIND         = 0x0080,
+    wxSOCKET_REUSEPORT      = 0x0100
 };
 
 typedef int wxSocketFlags;
@@ -106,6 +110,23 @@ enum wxSocketType
 };
 
 
+// One of the buffers used by wxSocketBase::ReadV() and WriteV().
+struct wxSocketBuffer
+{
+    wxSocketBuffer() : data(NULL), size(0) { }
+    wxSocketBuffer(void *data_, wxUint32 size_) : data(data_), size(size_) { }
+
+    // the data is never modified when the buffer is used with WriteV()
+    wxSocketBuffer(const void *data_, wxUint32 size_)
+        : data(const_cast<void *>(data_)), size(size_)
+    {
+    }
+
+    void *data;
+    wxUint32 size;
+};
+
+
 // event
 class WXDLLIMPEXP_FWD_NET wxSocketEvent;
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_NET, wxEVT_SOCKET, wxSocketEvent);
@@ -158,6 +179,18 @@ public:
     wxSocketBase& Write(const void *buffer, wxUint32 nbytes);
     wxSocketBase& WriteMsg(const void *buffer, wxUint32 nbytes);
 
+    // scatter/gather IO: same as Read() and Write() but using several buffers
+    wxSocketBase& ReadV(const wxSocketBuffer *buffers, size_t count);
+    wxSocketBase& WriteV(const wxSocketBuffer *buffers, size_t count);
+
+#if wxUSE_FILE
+    // send the given part of the file, or everything from offset until the
+    // end of the file if size is wxInvalidOffset
+    wxSocketBase& SendFile(wxFile& file,
+                           wxFileOffset offset = 0,
+                           wxFileOffset size = wxInvalidOffset);
+#endif // wxUSE_FILE
+
     // all Wait() functions wait until their condition is satisfied or the
     // timeout expires; if seconds == -1 (default) then m_timeout value is used
     //
@@ -244,6 +277,16 @@ private:
     wxUint32 DoRead(void* buffer, wxUint32 nbytes);
     wxUint32 DoWrite(const void *buffer, wxUint32 nbytes);
 
+    // versions of the functions above using several buffers, the buffers
+    // array is modified by them
+    wxUint32 DoReadV(wxSocketBuffer *buffers, size_t count);
+    wxUint32 DoWriteV(wxSocketBuffer *buffers, size_t count);
+
+#if wxUSE_FILE
+    // returns the number of bytes sent
+    wxFileOffset DoSendFile(wxFile& file, wxFileOffset offset, wxFileOffset size);
+#endif // wxUSE_FILE
+
     // wait until the given flags are set for this socket or the given timeout
     // (or m_timeout) expires
     //
@@ -309,6 +352,9 @@ private:
 
     friend class wxSocketReadGuard;
     friend class wxSocketWriteGuard;
+    friend class wxSocketServerPool;
+    friend class wxSocketPoolWorker;
+    friend class wxHTTP;
 
     wxDECLARE_CLASS(wxSocketBase);
     wxDECLARE_NO_COPY_CLASS(wxSocketBase);
@@ -335,6 +381,80 @@ public:
 };
 
 
+// --------------------------------------------------------------------------
+// wxSocketServerPool
+// --------------------------------------------------------------------------
+
+// This class uses the FD IO dispatchers which only exist under Unix.
+#if wxUSE_THREADS && defined(__UNIX__)
+    #define wxHAS_SOCKET_SERVER_POOL
+#endif
+
+#ifdef wxHAS_SOCKET_SERVER_POOL
+
+class wxSocketPoolWorker;
+
+// Server accepting connections and handling the events for them in several
+// worker threads, each of them using its own FD IO dispatcher.
+//
+// The events for the sockets are sent to the handler from the worker threads.
+class WXDLLIMPEXP_NET wxSocketServerPool
+{
+public:
+    // threads == 0 means to use as many threads as there are CPUs, the flags
+    // are used for the accepted sockets except for wxSOCKET_REUSEPORT which
+    // makes each thread use its own listening socket if possible
+    wxSocketServerPool(const wxSockAddress& addr,
+                       int threads = 0,
+                       wxSocketFlags flags = wxSOCKET_NONE);
+    ~wxSocketServerPool();
+
+    bool IsOk() const { return !m_workers.empty(); }
+    bool GetLocal(wxSockAddress& addr) const;
+
+    int GetThreadCount() const { return static_cast<int>(m_workers.size()); }
+
+    // true if each thread has its own listening socket
+    bool UsesReusePort() const { return m_reusePort; }
+
+    // these functions must be called before Start()
+    void SetEventHandler(wxEvtHandler& handler, int id = wxID_ANY);
+    void SetNotify(wxSocketEventFlags flags);
+
+    // start accepting connections, this can be done only once
+    bool Start();
+
+    // stop accepting connections and close all of them, the pool becomes
+    // invalid after calling this
+    void Stop();
+
+    // close the given accepted socket and delete it once all its pending
+    // events are processed, must be called from the thread handling it
+    void CloseConnection(wxSocketBase *socket);
+
+    // total number of the connections currently open
+    int GetConnectionCount() const;
+
+private:
+    wxVector<wxSocketPoolWorker *> m_workers;
+    wxSockAddress *m_local;
+
+    wxEvtHandler *m_handler;
+    int m_id;
+    wxSocketEventFlags m_notify;
+
+    bool m_reusePort;
+    bool m_started;
+
+    // number of the workers whose threads were successfully started
+    size_t m_numStarted;
+
+    wxDECLARE_NO_COPY_CLASS(wxSocketServerPool);
+};
+
+#endif // wxHAS_SOCKET_SERVER_POOL
+
+
 // --------------------------------------------------------------------------
 // wxSocketClient
 // --------------------------------------------------------------------------
@@ -43,6 +43,20 @@ enum wxStreamError
 
 const int wxEOF = -1;
 
+// ----------------------------------------------------------------------------
+// wxIOVec: buffer descriptor used by scatter/gather I/O functions
+// ----------------------------------------------------------------------------
+
+struct wxIOVec
+{
+    wxIOVec() : data(NULL), size(0) { }
+    wxIOVec(const void *data_, size_t size_)
+        : data(const_cast<void *>(data_)), size(size_) { }
+
+    void *data;
+    size_t size;
+};
+
 // ============================================================================
 // base stream classes: wxInputStream and wxOutputStream
 // ============================================================================
@@ -136,6 +150,16 @@ public:
     // when EOF is reached or an error occurs
     wxInputStream& Read(wxOutputStream& streamOut);
 
+    // read data into several buffers at once, filling them in order
+    //
+    // this is equivalent to calling Read() for each of the buffers in turn,
+    // but may be more efficient, and LastRead() returns the total number of
+    // bytes read into all of them
+    //
+    // NB: the derived classes overriding Read() must override this function
+    //     as well
+    virtual wxInputStream& ReadV(const wxIOVec *vec, size_t count);
+
 
     // status functions
     // ----------------
@@ -200,6 +224,10 @@ protected:
     // read
     virtual size_t OnSysRead(void *buffer, size_t size) = 0;
 
+    // do read data into several buffers, the default implementation simply
+    // calls OnSysRead() for each of them while it reads all the data
+    virtual size_t OnSysReadV(const wxIOVec *vec, size_t count);
+
     // write-back buffer support
     // -------------------------
 
@@ -238,6 +266,13 @@ public:
     void PutC(char c);
     virtual wxOutputStream& Write(const void *buffer, size_t size);
 
+    // write the contents of several buffers at once, this is equivalent to
+    // calling Write() for each of them but may be more efficient
+    //
+    // NB: the derived classes overriding Write() must override this function
+    //     as well
+    virtual wxOutputStream& WriteV(const wxIOVec *vec, size_t count);
+
     // This is ReadAll() equivalent for Write(): it either writes exactly the
     // given number of bytes or returns false, unlike Write() which can write
     // less data than requested but still return without error.
@@ -261,6 +296,10 @@ protected:
     // virtual)
     virtual size_t OnSysWrite(const void *buffer, size_t bufsize);
 
+    // write the data of several buffers, the default implementation simply
+    // calls OnSysWrite() for each of them while it writes all the data
+    virtual size_t OnSysWriteV(const wxIOVec *vec, size_t count);
+
     friend class wxStreamBuffer;
 
     wxDECLARE_ABSTRACT_CLASS(wxOutputStream);
@@ -458,6 +497,11 @@ public:
     virtual size_t Write(const void *buffer, size_t size);
     size_t Write(wxStreamBuffer *buf);
 
+    // Write the contents of several buffers: if they don't fit into the
+    // buffer, the buffered data and the new data are written to the stream
+    // at once without copying the latter into the buffer.
+    size_t WriteV(const wxIOVec *vec, size_t count);
+
     virtual char Peek();
     virtual char GetChar();
     virtual void PutChar(char c);
@@ -485,6 +529,12 @@ public:
     void Fixed(bool fixed) { m_fixed = fixed; }
     void Flushable(bool f) { m_flushable = f; }
 
+    // Allow the buffer allocated by this object to grow up to the given size
+    // while the stream is accessed sequentially, it shrinks back to its
+    // original size when the stream is seeked. 0 disables growing.
+    void SetMaxBufferSize(size_t size) { m_buffer_maxsize = size; }
+    size_t GetMaxBufferSize() const { return m_buffer_maxsize; }
+
     bool FlushBuffer();
     bool FillBuffer();
     size_t GetDataLeft();
@@ -523,12 +573,32 @@ protected:
     // free the buffer (always safe to call)
     void FreeBuffer();
 
+    // grow the buffer if it's being used sequentially and it's allowed to
+    // grow, must be only called when it doesn't contain any data
+    void GrowIfSequential();
+
+    // shrink the buffer back to its initial size if it had been grown
+    void ShrinkIfGrown();
+
+    // change the size of the owned buffer preserving its contents
+    void ResizeBuffer(size_t new_size);
+
+    // read data directly into the provided buffer, bypassing this one
+    size_t ReadDirectly(void *buffer, size_t size);
+
     // the buffer itself: the pointers to its start and end and the current
     // position in the buffer
     char *m_buffer_start,
          *m_buffer_end,
          *m_buffer_pos;
 
+    // the allocated size of the buffer, which may be greater than the size of
+    // the data in it if the last read didn't fill it entirely, the size it had
+    // initially and the maximal size it can grow to
+    size_t m_buffer_size,
+           m_buffer_initsize,
+           m_buffer_maxsize;
+
     // the stream we're associated with
     wxStreamBase *m_stream;
 
@@ -538,7 +608,8 @@ protected:
     // flags
     bool m_destroybuf,      // deallocate buffer?
          m_fixed,
-         m_flushable;
+         m_flushable,
+         m_sequential;      // was the buffer entirely used the last time?
 
 
     wxDECLARE_NO_ASSIGN_CLASS(wxStreamBuffer);
@@ -554,7 +625,8 @@ public:
     // create a buffered stream on top of the specified low-level stream
     //
     // if a non NULL buffer is given to the stream, it will be deleted by it,
-    // otherwise a default 1KB buffer will be used
+    // otherwise a default 1KB buffer, growing up to 64KB when the stream is
+    // used sequentially, will be used
     wxBufferedInputStream(wxInputStream& stream,
                           wxStreamBuffer *buffer = NULL);
 
@@ -568,6 +640,7 @@ public:
 
     virtual char Peek() wxOVERRIDE;
     virtual wxInputStream& Read(void *buffer, size_t size) wxOVERRIDE;
+    virtual wxInputStream& ReadV(const wxIOVec *vec, size_t count) wxOVERRIDE;
 
     // Position functions
     virtual wxFileOffset SeekI(wxFileOffset pos, wxSeekMode mode = wxFromStart) wxOVERRIDE;
@@ -598,7 +671,8 @@ public:
     // create a buffered stream on top of the specified low-level stream
     //
     // if a non NULL buffer is given to the stream, it will be deleted by it,
-    // otherwise a default 1KB buffer will be used
+    // otherwise a default 1KB buffer, growing up to 64KB when the stream is
+    // used sequentially, will be used
     wxBufferedOutputStream(wxOutputStream& stream,
                            wxStreamBuffer *buffer = NULL);
 
@@ -610,6 +684,7 @@ public:
     virtual ~wxBufferedOutputStream();
 
     virtual wxOutputStream& Write(const void *buffer, size_t size) wxOVERRIDE;
+    virtual wxOutputStream& WriteV(const wxIOVec *vec, size_t count) wxOVERRIDE;
 
     // Position functions
     virtual wxFileOffset SeekO(wxFileOffset pos, wxSeekMode mode = wxFromStart) wxOVERRIDE;
@@ -627,6 +702,7 @@ public:
 
 protected:
     virtual size_t OnSysWrite(const void *buffer, size_t bufsize) wxOVERRIDE;
+    virtual size_t OnSysWriteV(const wxIOVec *vec, size_t count) wxOVERRIDE;
     virtual wxFileOffset OnSysSeek(wxFileOffset seek, wxSeekMode mode) wxOVERRIDE;
     virtual wxFileOffset OnSysTell() const wxOVERRIDE;
 
@@ -165,6 +165,18 @@ public:
 
     wxTarEntry *GetNextEntry();
 
+    // random access to the entries using an index built by reading all the
+    // headers once or loaded from a previously saved one
+    bool LoadIndex();
+    bool LoadIndex(wxInputStream& index);
+    bool SaveIndex(wxOutputStream& index) const;
+    bool HasIndex() const               { return m_index != NULL; }
+    size_t GetIndexedCount() const;
+    const wxTarEntry *GetIndexedEntry(size_t n) const;
+    const wxTarEntry *FindEntry(const wxString& name,
+                                wxPathFormat format = wxPATH_NATIVE) const;
+    bool OpenEntry(const wxString& name, wxPathFormat format = wxPATH_NATIVE);
+
     wxFileOffset GetLength() const wxOVERRIDE      { return m_size; }
     bool IsSeekable() const wxOVERRIDE { return m_parent_i_stream->IsSeekable(); }
 
@@ -192,12 +204,14 @@ private:
     wxFileOffset m_pos;     // position within the current entry
     wxFileOffset m_offset;  // offset to the start of the entry's data
     wxFileOffset m_size;    // size of the current entry's data
+    wxFileOffset m_start;   // offset of the archive in the parent stream
 
     int m_sumType;
     int m_tarType;
     class wxTarHeaderBlock *m_hdr;
     wxTarHeaderRecords *m_HeaderRecs;
     wxTarHeaderRecords *m_GlobalHeaderRecs;
+    class wxTarIndex *m_index;
 
     wxDECLARE_NO_COPY_CLASS(wxTarInputStream);
 };
@@ -25,6 +25,15 @@ public:
 
     virtual ~wxInotifyFileSystemWatcher();
 
+    // Reimplemented to avoid the overhead of wxDir and path normalization
+    // for every directory in big trees.
+    virtual bool AddTree(const wxFileName& path, int events = wxFSW_EVENT_ALL,
+                         const wxString& filespec = wxEmptyString) wxOVERRIDE;
+
+    virtual bool SetCoalescingDelay(int milliseconds) wxOVERRIDE;
+    virtual bool EnableBatching(bool enable = true) wxOVERRIDE;
+    virtual bool EnableOverflowRecovery(bool enable = true) wxOVERRIDE;
+
     void OnDirDeleted(const wxString& path);
 
 protected:
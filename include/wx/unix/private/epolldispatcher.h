@@ -15,10 +15,11 @@
 #ifdef wxUSE_EPOLL_DISPATCHER
 
 #include "wx/private/fdiodispatcher.h"
+#include "wx/thread.h"
 
 struct epoll_event;
 
-class WXDLLIMPEXP_BASE wxEpollDispatcher : public wxFDIODispatcher
+class WXDLLIMPEXP_BASE wxEpollDispatcher : public wxMappedFDIODispatcher
 {
 public:
     // create a new instance of this class, can return NULL if
@@ -29,6 +30,12 @@ public:
 
     virtual ~wxEpollDispatcher();
 
+    // set the maximal number of events retrieved by a single epoll_wait()
+    // call, using bigger values reduces the number of system calls when
+    // there are many active descriptors
+    void SetBatchSize(int size);
+    int GetBatchSize() const { return m_batchSize; }
+
     // implement base class pure virtual methods
     virtual bool RegisterFD(int fd, wxFDIOHandler* handler, int flags = wxFDIO_ALL) wxOVERRIDE;
     virtual bool ModifyFD(int fd, wxFDIOHandler* handler, int flags = wxFDIO_ALL) wxOVERRIDE;
@@ -44,8 +51,28 @@ private:
     // given timeout
     int DoPoll(epoll_event *events, int numEvents, int timeout) const;
 
+    // call the handlers for the given events, return the number of handlers
+    // called
+    int ProcessEvents(const epoll_event *events, int numEvents);
+
+
+#if wxUSE_THREADS
+    // protects m_handlers and the pending events below, as the dispatcher can
+    // be used from several threads at once
+    mutable wxCriticalSection m_cs;
+#endif // wxUSE_THREADS
 
     int m_epollDescriptor;
+
+    // maximal number of events retrieved at once
+    int m_batchSize;
+
+    // buffer of m_batchSize events containing m_numPending events already
+    // retrieved by HasPending() but not dispatched yet, Dispatch() takes them
+    // from here and uses its own buffer for processing them, as it can be
+    // called concurrently from several threads or recursively by a handler
+    epoll_event *m_pending;
+    mutable int m_numPending;
 };
 
 #endif // wxUSE_EPOLL_DISPATCHER
@@ -20,6 +20,50 @@
 #endif
 
 class wxEventLoopBase;
+class wxEventLoopSource;
+class wxEventLoopSourceHandler;
+
+#if wxUSE_STREAMS
+
+// Copies the output of the child process from the pipe connected to it to
+// the sink specified by wxProcess::SetOutputSink() as soon as it arrives,
+// without accumulating it in memory as wxStreamTempInputBuffer does.
+class wxExecuteSinkBuffer
+{
+public:
+    wxExecuteSinkBuffer()
+    {
+        m_fd = wxPipe::INVALID_FD;
+        m_sink = NULL;
+        m_eof = false;
+    }
+
+    ~wxExecuteSinkBuffer();
+
+    // Take ownership of the given pipe FD, which is switched to non-blocking
+    // mode, and start copying the data from it to the sink.
+    void Init(int fd, wxOutputStream *sink);
+
+    bool IsOk() const { return m_fd != wxPipe::INVALID_FD; }
+    int GetFD() const { return m_fd; }
+
+    // Copy all the data currently available in the pipe to the sink without
+    // blocking, this is called when the pipe becomes readable and also when
+    // the child process exits.
+    void Update();
+
+    // Return true if there is nothing more to read.
+    bool Eof() const { return m_eof || !IsOk(); }
+
+private:
+    int m_fd;
+    wxOutputStream *m_sink;
+    bool m_eof;
+
+    wxDECLARE_NO_COPY_CLASS(wxExecuteSinkBuffer);
+};
+
+#endif // wxUSE_STREAMS
 
 // Information associated with a running child process.
 class wxExecuteData
@@ -30,26 +74,43 @@ public:
         m_flags =
         m_pid = 0;
         m_exitcode = -1;
+        m_pidfd = -1;
 
         m_process = NULL;
 
         m_syncEventLoop = NULL;
 
+        m_pidfdHandler = NULL;
+        m_pidfdSource = NULL;
+
 #if wxUSE_STREAMS
         m_fdOut =
         m_fdErr = wxPipe::INVALID_FD;
+
+        m_sinkOutHandler =
+        m_sinkErrHandler = NULL;
 #endif // wxUSE_STREAMS
     }
 
-    // This must be called in the parent process as soon as fork() returns to
-    // update us with the effective child PID. It also ensures that we handle
-    // SIGCHLD to be able to detect when this PID exits, so wxTheApp must be
-    // available.
+    ~wxExecuteData();
+
+    // This must be called in the parent process as soon as the child is
+    // created to update us with the effective child PID. It also ensures
+    // that we can detect when this PID exits, either using a pidfd under
+    // Linux or by handling SIGCHLD otherwise, so wxTheApp must be available.
     void OnStart(int pid);
 
     // Called when the child process exits.
     void OnExit(int exitcode);
 
+    // Called when the pidfd becomes readable: checks whether the child has
+    // really exited and calls OnExit() if it did.
+    void OnPidFDReady();
+
+    // Return the pidfd referring to the child process, becoming readable
+    // when it exits, or -1 if not used.
+    int GetPidFD() const { return m_pidfd; }
+
     // Return true if we should (or already did) redirect the child IO.
     bool IsRedirected() const { return m_process && m_process->IsRedirected(); }
 
@@ -81,10 +142,33 @@ public:
     // the corresponding FDs, -1 if not redirected
     int m_fdOut,
         m_fdErr;
+
+    // the buffers used instead of the ones above when the output is sent to
+    // the sinks specified by wxProcess
+    wxExecuteSinkBuffer m_sinkOut,
+                        m_sinkErr;
 #endif // wxUSE_STREAMS
 
 
 private:
+    // Start monitoring the pidfd and the output sinks, if any, using the
+    // event loop. This is not done in wxEXEC_NOEVENTS case.
+    void AddEventLoopSources();
+    void RemoveEventLoopSources();
+
+    // pidfd for the child or -1
+    int m_pidfd;
+
+    // the handlers for the FDs above and their event loop sources, only used
+    // if AddEventLoopSources() was called
+    wxEventLoopSourceHandler *m_pidfdHandler;
+    wxEventLoopSource *m_pidfdSource;
+
+#if wxUSE_STREAMS
+    wxEventLoopSourceHandler *m_sinkOutHandler,
+                             *m_sinkErrHandler;
+#endif // wxUSE_STREAMS
+
     // SIGCHLD signal handler that checks whether any of the currently running
     // children have exited.
     static void OnSomeChildExited(int sig);
@@ -19,11 +19,14 @@
 // wxFDIOHandler depending on the kind of dispatcher/event loop it is used
 // with. In the future, when we get rid of wxFDIOHandler entirely, it will
 // derive from wxEventLoopSourceHandler only.
-template <class T>
+//
+// The buffer type B is either wxStreamTempInputBuffer, accumulating the
+// output in memory, or wxExecuteSinkBuffer, passing it to wxProcess sink.
+template <class T, class B>
 class wxExecuteIOHandlerBase : public T
 {
 public:
-    wxExecuteIOHandlerBase(int fd, wxStreamTempInputBuffer& buf)
+    wxExecuteIOHandlerBase(int fd, B& buf)
         : m_fd(fd),
           m_buf(buf)
     {
@@ -33,8 +36,8 @@ public:
     // Called when the associated descriptor is available for reading.
     virtual void OnReadWaiting() wxOVERRIDE
     {
-        // Sync process, process all data coming at us from the pipe so that
-        // the pipe does not get full and cause a deadlock situation.
+        // Process all data coming at us from the pipe so that the pipe does
+        // not get full and cause a deadlock situation.
         m_buf.Update();
 
         if ( m_buf.Eof() )
@@ -65,7 +68,7 @@ protected:
 private:
     virtual void DoDisable() = 0;
 
-    wxStreamTempInputBuffer& m_buf;
+    B& m_buf;
 
     // If true, DisableCallback() had been already called.
     bool m_callbackDisabled;
@@ -75,50 +78,52 @@ private:
 
 // This is the version used with wxFDIODispatcher, which must be passed to the
 // ctor in order to register this handler with it.
-class wxExecuteFDIOHandler : public wxExecuteIOHandlerBase<wxFDIOHandler>
+template <class B>
+class wxExecuteFDIOHandlerT : public wxExecuteIOHandlerBase<wxFDIOHandler, B>
 {
 public:
-    wxExecuteFDIOHandler(wxFDIODispatcher& dispatcher,
-                         int fd,
-                         wxStreamTempInputBuffer& buf)
-        : wxExecuteIOHandlerBase<wxFDIOHandler>(fd, buf),
+    wxExecuteFDIOHandlerT(wxFDIODispatcher& dispatcher, int fd, B& buf)
+        : wxExecuteIOHandlerBase<wxFDIOHandler, B>(fd, buf),
           m_dispatcher(dispatcher)
     {
         dispatcher.RegisterFD(fd, this, wxFDIO_INPUT);
     }
 
-    virtual ~wxExecuteFDIOHandler()
+    virtual ~wxExecuteFDIOHandlerT()
     {
-        DisableCallback();
+        this->DisableCallback();
     }
 
 private:
     virtual void DoDisable() wxOVERRIDE
     {
-        m_dispatcher.UnregisterFD(m_fd);
+        m_dispatcher.UnregisterFD(this->m_fd);
     }
 
     wxFDIODispatcher& m_dispatcher;
 
-    wxDECLARE_NO_COPY_CLASS(wxExecuteFDIOHandler);
+    wxDECLARE_NO_COPY_CLASS(wxExecuteFDIOHandlerT);
 };
 
+typedef wxExecuteFDIOHandlerT<wxStreamTempInputBuffer> wxExecuteFDIOHandler;
+
 // And this is the version used with an event loop. As AddSourceForFD() is
 // static, we don't require passing the event loop to the ctor but an event
 // loop must be running to handle our events.
-class wxExecuteEventLoopSourceHandler
-    : public wxExecuteIOHandlerBase<wxEventLoopSourceHandler>
+template <class B>
+class wxExecuteEventLoopSourceHandlerT
+    : public wxExecuteIOHandlerBase<wxEventLoopSourceHandler, B>
 {
 public:
-    wxExecuteEventLoopSourceHandler(int fd, wxStreamTempInputBuffer& buf)
-        : wxExecuteIOHandlerBase<wxEventLoopSourceHandler>(fd, buf)
+    wxExecuteEventLoopSourceHandlerT(int fd, B& buf)
+        : wxExecuteIOHandlerBase<wxEventLoopSourceHandler, B>(fd, buf)
     {
         m_source = wxEventLoop::AddSourceForFD(fd, this, wxEVENT_SOURCE_INPUT);
     }
 
-    virtual ~wxExecuteEventLoopSourceHandler()
+    virtual ~wxExecuteEventLoopSourceHandlerT()
     {
-        DisableCallback();
+        this->DisableCallback();
     }
 
 private:
@@ -130,7 +135,10 @@ private:
 
     wxEventLoopSource* m_source;
 
-    wxDECLARE_NO_COPY_CLASS(wxExecuteEventLoopSourceHandler);
+    wxDECLARE_NO_COPY_CLASS(wxExecuteEventLoopSourceHandlerT);
 };
 
+typedef wxExecuteEventLoopSourceHandlerT<wxStreamTempInputBuffer>
+    wxExecuteEventLoopSourceHandler;
+
 #endif // _WX_UNIX_PRIVATE_EXECUTEIOHANDLER_H_
@@ -0,0 +1,94 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        wx/unix/private/iouringdispatcher.h
+// Purpose:     wxIOUringDispatcher class
+// Author:      wxWidgets team
+// Created:     2020-10-12
+// Copyright:   (c) 2020 wxWidgets development team
+// Licence:     wxWindows licence
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef _WX_PRIVATE_IOURINGDISPATCHER_H_
+#define _WX_PRIVATE_IOURINGDISPATCHER_H_
+
+#include "wx/defs.h"
+
+#if wxUSE_EPOLL_DISPATCHER && defined(HAVE_LINUX_IO_URING_H)
+    #define wxHAS_IO_URING_DISPATCHER
+#endif
+
+#ifdef wxHAS_IO_URING_DISPATCHER
+
+#include "wx/private/fdiodispatcher.h"
+#include "wx/thread.h"
+
+struct wxIOUringData;
+struct io_uring_sqe;
+
+// Dispatcher using Linux io_uring poll requests instead of epoll_wait(): this
+// allows to submit the requests and wait for their completion using a single
+// system call and to check for pending events without any system calls at
+// all in the common case.
+//
+// Level-triggered notifications are implemented by re-arming one-shot poll
+// requests after each event, while multi-shot requests are used for the
+// descriptors registered with wxFDIO_EDGE_TRIGGERED flag.
+class WXDLLIMPEXP_BASE wxIOUringDispatcher : public wxFDIODispatcher
+{
+public:
+    // create a new instance of this class, returns NULL if io_uring is not
+    // supported by the kernel or is disabled
+    //
+    // the caller should delete the returned pointer
+    static wxIOUringDispatcher *Create();
+
+    virtual ~wxIOUringDispatcher();
+
+    // implement base class pure virtual methods
+    virtual bool RegisterFD(int fd, wxFDIOHandler* handler, int flags = wxFDIO_ALL) wxOVERRIDE;
+    virtual bool ModifyFD(int fd, wxFDIOHandler* handler, int flags = wxFDIO_ALL) wxOVERRIDE;
+    virtual bool UnregisterFD(int fd) wxOVERRIDE;
+    virtual bool HasPending() const wxOVERRIDE;
+    virtual int Dispatch(int timeout = TIMEOUT_INFINITE) wxOVERRIDE;
+
+private:
+    // ctor is private, use Create()
+    explicit wxIOUringDispatcher(wxIOUringData *data);
+
+    // return a free submission queue entry, submitting the already queued
+    // requests once to make space for it if necessary, or NULL if the queue
+    // is still full, must be called with m_cs locked
+    io_uring_sqe *GetFreeSQE();
+
+    // queue a poll request for the given descriptor, return false if the
+    // submission queue is full, must be called with m_cs locked
+    bool QueuePollAdd(int fd);
+
+    // queue a request cancelling the poll request for the given descriptor,
+    // return false if the submission queue is full, must be called with m_cs
+    // locked
+    bool QueuePollRemove(int fd);
+
+    // submit the queued requests, return false if an error occurred, must be
+    // called with m_cs locked
+    bool Submit();
+
+    // submit the queued requests and wait for at least one completion for the
+    // given time, return false if an error occurred, must be called with m_cs
+    // not locked as it's only locked while determining what to submit
+    bool SubmitAndWait(int timeout);
+
+
+#if wxUSE_THREADS
+    // protects the submission and completion queues and the registered
+    // descriptors, as the dispatcher can be used from several threads at once
+    mutable wxCriticalSection m_cs;
+#endif // wxUSE_THREADS
+
+    wxIOUringData *m_data;
+
+    wxDECLARE_NO_COPY_CLASS(wxIOUringDispatcher);
+};
+
+#endif // wxHAS_IO_URING_DISPATCHER
+
+#endif // _WX_PRIVATE_IOURINGDISPATCHER_H_
@@ -23,6 +23,8 @@
 
 #include "wx/private/fdiomanager.h"
 
+class wxFDIODispatcher;
+
 #define wxCloseSocket close
 
 class wxSocketImplUnix : public wxSocketImpl,
@@ -34,10 +36,19 @@ public:
     {
         m_fds[0] =
         m_fds[1] = -1;
+
+        m_dispatcher = NULL;
     }
 
     virtual wxSocketError GetLastError() const wxOVERRIDE;
 
+    // use the given dispatcher for monitoring this socket instead of the
+    // global wxSocketManager, this allows to handle the socket events in
+    // another thread which must be the one calling Dispatch() on it
+    //
+    // NULL resets the socket to use the global manager again
+    void SetDispatcher(wxFDIODispatcher *dispatcher);
+
     virtual void ReenableEvents(wxSocketEventFlags flags) wxOVERRIDE
     {
         // Events are only ever used for non-blocking sockets.
@@ -91,12 +102,18 @@ private:
     // really enable or disable socket input/output events
     void DoEnableEvents(int flags, bool enable);
 
+    // implementation of DoEnableEvents() used when m_dispatcher is set
+    void DoEnableDispatcherEvents(int flags, bool enable);
+
 protected:
     // descriptors for input and output event notification channels associated
     // with the socket
     int m_fds[2];
 
 private:
+    // the dispatcher used instead of wxSocketManager if non-NULL
+    wxFDIODispatcher *m_dispatcher;
+
     // notify the associated wxSocket about a change in socket state and shut
     // down the socket if the event is wxSOCKET_LOST
     void OnStateChange(wxSocketNotify event);
@@ -125,6 +125,43 @@ protected:
     wxWebResponseImplPtr m_impl;
 };
 
+// Interface for the objects receiving the response data directly as it is
+// downloaded, see wxWebRequest::SetDataSink().
+class WXDLLIMPEXP_NET wxWebRequestSink
+{
+public:
+    enum Result
+    {
+        Result_Continue,    // data consumed, continue the transfer
+        Result_Pause,       // data not consumed, pause until Resume()
+        Result_Abort        // abort the transfer
+    };
+
+    virtual ~wxWebRequestSink() { }
+
+    // Called with each block of the received data, possibly from a worker
+    // thread.
+    virtual Result OnData(const void* data, size_t size) = 0;
+};
+
+// Sink writing the data to the given stream, which must remain valid for as
+// long as the request is active.
+class WXDLLIMPEXP_NET wxWebRequestStreamSink : public wxWebRequestSink
+{
+public:
+    explicit wxWebRequestStreamSink(wxOutputStream& stream)
+        : m_stream(stream)
+    {
+    }
+
+    virtual Result OnData(const void* data, size_t size) wxOVERRIDE;
+
+private:
+    wxOutputStream& m_stream;
+
+    wxDECLARE_NO_COPY_CLASS(wxWebRequestStreamSink);
+};
+
 class WXDLLIMPEXP_NET wxWebRequest
 {
 public:
@@ -164,10 +201,19 @@ public:
 
     Storage GetStorage() const;
 
+    // Takes ownership of the sink, returns false if not supported.
+    bool SetDataSink(wxWebRequestSink* sink);
+
+    void SetProgressInterval(int milliseconds);
+
     void Start();
 
     void Cancel();
 
+    // Resume the transfer paused by the data sink, may be called from any
+    // thread.
+    void Resume();
+
     wxWebResponse GetResponse() const;
 
     wxWebAuthChallenge GetAuthChallenge() const;
@@ -235,6 +281,16 @@ public:
     void SetTempDir(const wxString& dir);
     wxString GetTempDir() const;
 
+    // Connection management options: these functions return false if the
+    // option is not supported by the backend and only affect the requests
+    // created after calling them.
+    bool SetMaxConnectionsPerHost(int count);
+    bool SetMaxConnections(int count);
+    bool EnableMultiplexing(bool enable = true);
+    bool SetKeepAlive(int idle, int interval = 0);
+    bool SetMaxIdleTime(int seconds);
+    bool EnableSharedCache(bool enable = true);
+
     bool IsOpened() const;
 
     void Close();
@@ -293,6 +349,7 @@ private:
 
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_NET, wxEVT_WEBREQUEST_STATE, wxWebRequestEvent);
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_NET, wxEVT_WEBREQUEST_DATA, wxWebRequestEvent);
+wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_NET, wxEVT_WEBREQUEST_PROGRESS, wxWebRequestEvent);
 
 #endif // wxUSE_WEBREQUEST
 
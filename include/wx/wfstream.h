@@ -47,6 +47,7 @@ protected:
     wxFileInputStream();
 
     virtual size_t OnSysRead(void *buffer, size_t size) wxOVERRIDE;
+    virtual size_t OnSysReadV(const wxIOVec *vec, size_t count) wxOVERRIDE;
     virtual wxFileOffset OnSysSeek(wxFileOffset pos, wxSeekMode mode) wxOVERRIDE;
     virtual wxFileOffset OnSysTell() const wxOVERRIDE;
 
@@ -79,6 +80,7 @@ protected:
     wxFileOutputStream();
 
     virtual size_t OnSysWrite(const void *buffer, size_t size) wxOVERRIDE;
+    virtual size_t OnSysWriteV(const wxIOVec *vec, size_t count) wxOVERRIDE;
     virtual wxFileOffset OnSysSeek(wxFileOffset pos, wxSeekMode mode) wxOVERRIDE;
     virtual wxFileOffset OnSysTell() const wxOVERRIDE;
 
@@ -175,6 +177,68 @@ private:
     wxDECLARE_NO_COPY_CLASS(wxFileStream);
 };
 
+// ----------------------------------------------------------------------------
+// wxMappedFileInputStream: read-only stream directly over the file contents
+// ----------------------------------------------------------------------------
+
+// Hints about the way the data of wxMappedFileInputStream is going to be read.
+enum wxMappedFileAccess
+{
+    wxMAPPED_FILE_ACCESS_NORMAL,        // no particular access pattern
+    wxMAPPED_FILE_ACCESS_SEQUENTIAL,    // read from the beginning to the end
+    wxMAPPED_FILE_ACCESS_RANDOM         // read at arbitrary offsets
+};
+
+class WXDLLIMPEXP_BASE wxMappedFileInputStream : public wxInputStream
+{
+public:
+    wxMappedFileInputStream(const wxString& fileName,
+                            wxMappedFileAccess access = wxMAPPED_FILE_ACCESS_NORMAL);
+    virtual ~wxMappedFileInputStream();
+
+    virtual wxFileOffset GetLength() const wxOVERRIDE;
+
+    virtual bool IsOk() const wxOVERRIDE;
+    virtual bool IsSeekable() const wxOVERRIDE;
+    virtual bool CanRead() const wxOVERRIDE;
+
+    // Return true if the file contents are mapped into memory, false if we
+    // had to fall back to reading it using the normal file API.
+    bool IsMapped() const { return m_mapping != NULL; }
+
+    // Direct access to the file contents, only available if IsMapped().
+    const void *GetData() const { return m_data; }
+    size_t GetDataLength() const { return m_length; }
+
+    // Change the access pattern hint given to the OS.
+    void SetAccessHint(wxMappedFileAccess access);
+
+protected:
+    virtual size_t OnSysRead(void *buffer, size_t size) wxOVERRIDE;
+    virtual wxFileOffset OnSysSeek(wxFileOffset pos, wxSeekMode mode) wxOVERRIDE;
+    virtual wxFileOffset OnSysTell() const wxOVERRIDE;
+
+private:
+    // Try to map the already opened file, return false if it's impossible.
+    bool DoMap();
+
+    wxFile m_file;
+
+    // The object owning the mapping, may be shared with wxMemoryInputStream
+    // objects created from this stream and is NULL if the file isn't mapped.
+    wxRefCounter *m_mapping;
+
+    const char *m_data;
+    size_t m_length;
+    size_t m_pos;
+
+    // wxMemoryInputStream shares our mapping instead of copying the data.
+    friend class WXDLLIMPEXP_FWD_BASE wxMemoryInputStream;
+
+    wxDECLARE_ABSTRACT_CLASS(wxMappedFileInputStream);
+    wxDECLARE_NO_COPY_CLASS(wxMappedFileInputStream);
+};
+
 #endif //wxUSE_FILE
 
 #if wxUSE_FFILE
@@ -324,6 +324,11 @@ public:
     void SetFormat(wxZipArchiveFormat format)   { m_format = format; }
     wxZipArchiveFormat GetFormat() const        { return m_format; }
 
+    // compress several entries concurrently using the given number of
+    // threads, 0 meaning to use as many of them as there are CPUs
+    void WXZIPFIX SetThreadCount(int threads);
+    int GetThreadCount() const                  { return m_threads; }
+
 protected:
     virtual size_t WXZIPFIX OnSysWrite(const void *buffer, size_t size) wxOVERRIDE;
     virtual wxFileOffset OnSysTell() const wxOVERRIDE      { return m_entrySize; }
@@ -348,9 +353,15 @@ private:
     bool IsOpened() const { return m_comp || m_pending; }
 
     bool DoCreate(wxZipEntry *entry, bool raw = false);
+    void WriteLocalMagic(wxZipEntry& entry);
     void CreatePendingEntry(const void *buffer, size_t size);
     void CreatePendingEntry();
 
+    bool IsCollecting() const;
+    void StreamCollectedEntry();
+    bool SubmitCollectedEntry();
+    bool WriteCompressedEntries(bool wait);
+
     class wxStoredOutputStream *m_store;
     class wxZlibOutputStream2 *m_deflate;
     class wxZipStreamLink *m_backlink;
@@ -369,6 +380,8 @@ private:
     wxString m_Comment;
     bool m_endrecWritten;
     wxZipArchiveFormat m_format;
+    class wxZipParallelCompressor *m_parallel;
+    int m_threads;
 
     wxDECLARE_NO_COPY_CLASS(wxZipOutputStream);
 };
@@ -395,6 +408,16 @@ public:
     wxString WXZIPFIX GetComment();
     int WXZIPFIX GetTotalEntries();
 
+    // random access to the entries of seekable archives
+    bool LoadIndex();
+    bool HasIndex() const                   { return m_index != NULL; }
+    size_t GetIndexedCount() const;
+    const wxZipEntry *GetIndexedEntry(size_t n) const;
+    const wxZipEntry *FindEntry(const wxString& name,
+                                wxPathFormat format = wxPATH_NATIVE) const;
+    bool OpenEntry(const wxString& name, wxPathFormat format = wxPATH_NATIVE);
+    wxInputStream *OpenEntryStream(const wxZipEntry& entry) const;
+
     virtual wxFileOffset GetLength() const wxOVERRIDE { return m_entry.GetSize(); }
 
 protected:
@@ -415,6 +438,7 @@ private:
 
     wxStreamError ReadLocal(bool readEndRec = false);
     wxStreamError ReadCentral();
+    bool AdjustOffset(wxZipEntry& entry) const;
 
     wxUint32 ReadSignature();
     bool FindEndRecord();
@@ -445,6 +469,9 @@ private:
     wxUint32 m_signature;
     size_t m_TotalEntries;
     wxString m_Comment;
+    wxFileOffset m_centralOffset;
+    wxFileOffset m_centralSize;
+    class wxZipIndex *m_index;
 
     friend bool wxZipOutputStream::CopyEntry(
                     wxZipEntry *entry, wxZipInputStream& inputStream);
@@ -78,6 +78,12 @@ class WXDLLIMPEXP_BASE wxZlibOutputStream: public wxFilterOutputStream {
   bool SetDictionary(const char *data, size_t datalen);
   bool SetDictionary(const wxMemoryBuffer &buf);
 
+  // Compress independent blocks of data of the given size (0 for default)
+  // concurrently using the given number of threads (0 for the number of
+  // CPUs), must be called before writing anything to the stream.
+  bool SetThreadCount(int threads, size_t blockSize = 0);
+  int GetThreadCount() const;
+
  protected:
   size_t OnSysWrite(const void *buffer, size_t size) wxOVERRIDE;
   wxFileOffset OnSysTell() const wxOVERRIDE { return m_pos; }
@@ -92,6 +98,9 @@ class WXDLLIMPEXP_BASE wxZlibOutputStream: public wxFilterOutputStream {
   unsigned char *m_z_buffer;
   struct z_stream_s *m_deflate;
   wxFileOffset m_pos;
+  class wxZlibParallelDeflate *m_parallel;
+  int m_level;
+  int m_flags;
 
   wxDECLARE_NO_COPY_CLASS(wxZlibOutputStream);
 };
@@ -5,6 +5,31 @@
 // Licence:     wxWindows licence
 /////////////////////////////////////////////////////////////////////////////
 
+/**
+    Statistics about the usage of wxMemoryFSHandler.
+
+    @see wxMemoryFSHandler::GetStatistics()
+
+    @since 3.1.5
+*/
+struct wxMemoryFSStatistics
+{
+    /// Number of the files successfully opened.
+    unsigned long hits;
+
+    /// Number of the attempts to open files not stored in memory.
+    unsigned long misses;
+
+    /// Number of the files removed because the size limit was exceeded.
+    unsigned long evictions;
+
+    /// Number of the files currently stored in memory.
+    size_t filesCount;
+
+    /// Total size of the files currently stored in memory, in bytes.
+    size_t totalSize;
+};
+
 /**
     @class wxMemoryFSHandler
 
@@ -16,6 +41,14 @@
 
     Filenames are prefixed with @c "memory:", e.g. @c "memory:myfile.html".
 
+    The memory FS can also be used as a cache, e.g. for the rendered images
+    or HTML fragments, by limiting the total size of the stored files using
+    SetMaxSize(): the least recently opened files are then removed
+    automatically when it is exceeded. All the static functions of this class
+    can be safely called from any thread and the streams returned for the
+    stored files remain valid even if the file is removed from the memory FS,
+    either explicitly or automatically, while they are being used.
+
     Example:
 
     @code
@@ -117,7 +150,57 @@ public:
 
     /**
         Removes a file from memory FS and frees the occupied memory.
+
+        If the file is currently opened, its memory is only freed when the
+        stream reading from it is destroyed.
     */
     static void RemoveFile(const wxString& filename);
+
+    /**
+        Limits the total size of the files stored in memory.
+
+        When adding a new file results in exceeding the limit, the least
+        recently used files, i.e. those which had been added or opened the
+        longest time ago, are removed until the total size doesn't exceed it
+        any more. Notice that the file being added is never removed, even if
+        it is bigger than the limit on its own.
+
+        Calling this function removes the files immediately if their total
+        size is already greater than @a size.
+
+        @param size
+            The maximal total size of the files in bytes or 0 to remove the
+            limit, which is the default.
+
+        @since 3.1.5
+    */
+    static void SetMaxSize(size_t size);
+
+    /**
+        Returns the limit set by SetMaxSize().
+
+        @since 3.1.5
+    */
+    static size_t GetMaxSize();
+
+    /**
+        Returns the statistics about the memory FS usage.
+
+        This can be notably useful to check the efficiency of the memory FS
+        used as a cache.
+
+        @see ResetStatistics()
+
+        @since 3.1.5
+    */
+    static wxMemoryFSStatistics GetStatistics();
+
+    /**
+        Resets the counters of hits, misses and evictions returned by
+        GetStatistics() to 0.
+
+        @since 3.1.5
+    */
+    static void ResetStatistics();
 };
 
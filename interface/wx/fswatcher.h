@@ -87,9 +87,12 @@ public:
 
         This method is implemented efficiently on MSW and macOS, but
         should be used with care on other platforms for directories with lots
-        of children (e.g. the root directory) as it calls Add() for each
+        of children (e.g. the root directory) as it adds a watch for each
         subdirectory, potentially creating a lot of watches and taking a long
-        time to execute.
+        time to execute. Under Linux, subdirectories are enumerated directly
+        without normalizing their paths, which makes this much faster for big
+        trees, but the number of watches is still limited by the system, see
+        @c /proc/sys/fs/inotify/max_user_watches.
 
         Note that on platforms that use symbolic links, you will probably want
         to have called wxFileName::DontFollowLink on @a path. This is especially
@@ -141,6 +144,77 @@ public:
         owner.
      */
     void SetOwner(wxEvtHandler* handler);
+
+    /**
+        Delays the change notifications, merging the changes to the same path.
+
+        When this delay is non-zero, the notifications about the changes are
+        not sent immediately but only after the given time passes since the
+        first of them. All the changes to the same path during this time are
+        merged into a single event, e.g. several modifications of the same
+        file result in a single ::wxFSW_EVENT_MODIFY event, a file created and
+        modified is reported as just created and a file which was created and
+        deleted is not reported at all. This is useful to avoid being flooded
+        with events when many files are changed at once, e.g. when switching
+        between branches in a version control system.
+
+        Rename events are never merged, but are delivered in order with
+        the other changes. Warnings and errors are not delayed.
+
+        This function is currently only implemented under Linux.
+
+        @param milliseconds
+            The delay, 0 by default which means that the events are sent as
+            soon as the changes are detected.
+        @return @true if the delay was set, @false if this is not supported.
+
+        @since 3.1.5
+     */
+    virtual bool SetCoalescingDelay(int milliseconds);
+
+    /**
+        Enables delivering the changes in batches.
+
+        When batching is enabled, all the changes detected at once, or during
+        the delay set with SetCoalescingDelay() if it was called, are
+        delivered in a single event of ::wxFSW_EVENT_BATCH type instead of
+        separate events. Use wxFileSystemWatcherEvent::GetChanges() to
+        retrieve them.
+
+        This function is currently only implemented under Linux.
+
+        @return @true if batching was enabled or disabled, @false if this is
+            not supported.
+
+        @since 3.1.5
+     */
+    virtual bool EnableBatching(bool enable = true);
+
+    /**
+        Enables recovering from the change queue overflow.
+
+        Normally, when an overflow occurs, i.e. when there are too many
+        changes for the system to queue them all, a warning event of
+        ::wxFSW_WARNING_OVERFLOW type is generated and the application needs to
+        rescan all the watched directories. With overflow recovery enabled,
+        the smallest watched subtree containing the directories which had
+        changes recently is rescanned automatically instead: the watches for
+        the new subdirectories are added, with ::wxFSW_EVENT_CREATE events
+        generated for them, and the watches for the deleted directories are
+        removed, with ::wxFSW_EVENT_DELETE events. The overflow warning
+        event is still sent after doing this and its
+        wxFileSystemWatcherEvent::GetPath() returns the root of the rescanned
+        subtree, meaning that only the files under it need to be checked by
+        the application, or is empty if all the watched trees were rescanned.
+
+        This function is currently only implemented under Linux.
+
+        @return @true if recovery was enabled or disabled, @false if this is
+            not supported.
+
+        @since 3.1.5
+     */
+    virtual bool EnableOverflowRecovery(bool enable = true);
 };
 
 
@@ -194,6 +268,27 @@ public:
      */
     int GetChangeType() const;
 
+    /**
+        Returns all the changes carried by an event of ::wxFSW_EVENT_BATCH
+        type.
+
+        For the other events the returned vector is empty.
+
+        @see wxFileSystemWatcher::EnableBatching()
+
+        @since 3.1.5
+     */
+    const wxFileSystemWatcherChanges& GetChanges() const;
+
+    /**
+        Adds a change to the event of ::wxFSW_EVENT_BATCH type.
+
+        This is only useful when creating such events in the user code.
+
+        @since 3.1.5
+     */
+    void AddChange(const wxFileSystemWatcherChange& change);
+
     /**
         Returns @c true if this error is an error event
 
@@ -229,6 +324,56 @@ public:
 
 wxEventType wxEVT_FSWATCHER;
 
+/**
+    @class wxFileSystemWatcherChange
+
+    Describes a single change carried by a wxFileSystemWatcherEvent of
+    ::wxFSW_EVENT_BATCH type.
+
+    @library{wxbase}
+    @category{file}
+
+    @since 3.1.5
+*/
+class wxFileSystemWatcherChange
+{
+public:
+    /**
+        Creates the object describing a change of the given type.
+     */
+    wxFileSystemWatcherChange(int changeType = 0,
+                              const wxFileName& path = wxFileName(),
+                              const wxFileName& newPath = wxFileName());
+
+    /**
+        Returns the type of the change, one of wxFSWFlags values.
+     */
+    int GetChangeType() const;
+
+    /**
+        Changes the type of the change.
+     */
+    void SetChangeType(int changeType);
+
+    /**
+        Returns the path which was changed.
+     */
+    const wxFileName& GetPath() const;
+
+    /**
+        Returns the new path for the renames or the same path as GetPath()
+        for the other changes.
+     */
+    const wxFileName& GetNewPath() const;
+};
+
+/**
+    Vector of wxFileSystemWatcherChange objects.
+
+    @since 3.1.5
+ */
+typedef wxVector<wxFileSystemWatcherChange> wxFileSystemWatcherChanges;
+
 /**
     These are the possible types of file system change events.
 
@@ -319,7 +464,19 @@ enum wxFSWFlags
     wxFSW_EVENT_ALL = wxFSW_EVENT_CREATE | wxFSW_EVENT_DELETE |
                          wxFSW_EVENT_RENAME | wxFSW_EVENT_MODIFY |
                          wxFSW_EVENT_ACCESS | wxFSW_EVENT_ATTRIB |
-                         wxFSW_EVENT_WARNING | wxFSW_EVENT_ERROR
+                         wxFSW_EVENT_WARNING | wxFSW_EVENT_ERROR,
+
+    /**
+        Several changes happened.
+
+        This is not a real change type and can't be used as a filter, it is
+        only used for the events carrying several changes when batching is
+        enabled, see wxFileSystemWatcher::EnableBatching() and
+        wxFileSystemWatcherEvent::GetChanges().
+
+        @since 3.1.5
+     */
+    wxFSW_EVENT_BATCH = 0x100
 };
 
 /**
@@ -11,6 +11,12 @@
    @class wxGIFDecoder
 
    An animation decoder supporting animated GIF files.
+
+   Only the first frame is decoded when the file is loaded, the other ones
+   are decoded when they are used, e.g. by ConvertToImage(), and only a few
+   most recently used frames are kept in memory, see SetMaxCachedFrames().
+   Notice that this means that an error in the compressed data of any frame
+   but the first one is only detected when this frame is converted.
 */
 class  wxGIFDecoder : public wxAnimationDecoder
 {
@@ -28,6 +34,47 @@ public:
     virtual long GetDelay(unsigned int frame) const;
     virtual wxColour GetTransparentColour(unsigned int frame) const;
 
+    /**
+        Returns the pixels of the given frame as palette indices, one byte
+        per pixel.
+
+        The frame is decoded if it isn't in the cache of the decoded frames
+        yet, which may remove the least recently used frame from it, see
+        SetMaxCachedFrames(). Because of this, the returned pointer is only
+        valid until this function or ConvertToImage() is called for another
+        frame, even though this function is const, or the cache size is
+        reduced, and must not be used after it. Use SetMaxCachedFrames() with
+        0 argument to keep all the frames and the pointers to them valid
+        until the decoder is destroyed.
+
+        @return Pointer to the frame pixels or @NULL if decoding it failed.
+    */
+    unsigned char* GetData(unsigned int frame) const;
+
+    /**
+        Set the maximal number of decoded frames kept in memory.
+
+        The decoded frames use one byte per pixel, so keeping all of them for
+        a long animation can use a lot of memory, while decoding them again
+        each time they're shown takes time. By default, the 4 most recently
+        used frames are kept, which is enough for playing the animation as
+        each frame is only decoded once per loop then.
+
+        @param frames The number of frames to keep or 0 to keep all of them.
+
+        @since 3.1.5
+    */
+    void SetMaxCachedFrames(unsigned int frames);
+
+    /**
+        Get the maximal number of decoded frames kept in memory.
+
+        @see SetMaxCachedFrames()
+
+        @since 3.1.5
+    */
+    unsigned int GetMaxCachedFrames() const;
+
 protected:
     virtual bool DoCanRead(wxInputStream& stream) const;    
 };
@@ -75,6 +75,38 @@ enum wxImageAlphaBlendMode
     wxIMAGE_ALPHA_BLEND_COMPOSE = 1
 };
 
+/**
+    Possible formats of the pixel data stored in wxImage.
+
+    @see wxImage::SetPixelFormat()
+
+    @since 3.1.5
+*/
+enum wxImagePixelFormat
+{
+    /**
+        Default format with 3 bytes per pixel in R, G, B order and an
+        optional separate array of alpha values, as returned by
+        wxImage::GetData() and wxImage::GetAlpha().
+    */
+    wxIMAGE_PIXEL_FORMAT_RGB = 0,
+
+    /**
+        4 bytes per pixel in R, G, B, A order, alpha is not premultiplied.
+
+        This is the same layout as used by @c GdkPixbuf with alpha.
+    */
+    wxIMAGE_PIXEL_FORMAT_RGBA = 1,
+
+    /**
+        32 bit native-endian values with alpha in the upper 8 bits, followed
+        by red, green and blue premultiplied by alpha.
+
+        This is the same layout as used by @c CAIRO_FORMAT_ARGB32.
+    */
+    wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED = 2
+};
+
 /**
     Possible values for PNG image type option.
 
@@ -100,6 +132,8 @@ enum wxImagePNGType
 #define wxIMAGE_OPTION_RESOLUTIONUNIT                   wxString("ResolutionUnit")
 #define wxIMAGE_OPTION_MAX_WIDTH                        wxString("MaxWidth")
 #define wxIMAGE_OPTION_MAX_HEIGHT                       wxString("MaxHeight")
+#define wxIMAGE_OPTION_MIN_WIDTH                        wxString("MinWidth")
+#define wxIMAGE_OPTION_MIN_HEIGHT                       wxString("MinHeight")
 #define wxIMAGE_OPTION_ORIGINAL_WIDTH                   wxString("OriginalWidth")
 #define wxIMAGE_OPTION_ORIGINAL_HEIGHT                  wxString("OriginalHeight")
 
@@ -107,6 +141,8 @@ enum wxImagePNGType
 #define wxIMAGE_OPTION_CUR_HOTSPOT_X                    wxString("HotSpotX")
 #define wxIMAGE_OPTION_CUR_HOTSPOT_Y                    wxString("HotSpotY")
 
+#define wxIMAGE_OPTION_JPEG_FAST_IDCT                   wxString("JpegFastIDCT")
+
 #define wxIMAGE_OPTION_GIF_COMMENT                      wxString("GifComment")
 #define wxIMAGE_OPTION_GIF_TRANSPARENCY                 wxString("Transparency")
 #define wxIMAGE_OPTION_GIF_TRANSPARENCY_HIGHLIGHT       wxString("Highlight")
@@ -119,6 +155,7 @@ enum wxImagePNGType
 #define wxIMAGE_OPTION_PNG_COMPRESSION_MEM_LEVEL        wxString("PngZM")
 #define wxIMAGE_OPTION_PNG_COMPRESSION_STRATEGY         wxString("PngZS")
 #define wxIMAGE_OPTION_PNG_COMPRESSION_BUFFER_SIZE      wxString("PngZB")
+#define wxIMAGE_OPTION_PNG_PIXEL_FORMAT                 wxString("PngPixelFormat")
 
 #define wxIMAGE_OPTION_TIFF_BITSPERSAMPLE               wxString("BitsPerSample")
 #define wxIMAGE_OPTION_TIFF_SAMPLESPERPIXEL             wxString("SamplesPerPixel")
@@ -754,6 +791,27 @@ public:
     */
     bool Create( const wxSize& sz, unsigned char* data, unsigned char* alpha, bool static_data = false );
 
+    /**
+        Creates a fresh image storing its pixels in the given format.
+
+        The image always has alpha channel, even if @a format is
+        ::wxIMAGE_PIXEL_FORMAT_RGB.
+
+        @param width
+            Specifies the width of the image.
+        @param height
+            Specifies the height of the image.
+        @param format
+            The format of the pixel data, see SetPixelFormat().
+        @param clear
+            If @true, initialize all the pixels to fully transparent black.
+
+        @return @true if the call succeeded, @false otherwise.
+
+        @since 3.1.5
+    */
+    bool Create(int width, int height, wxImagePixelFormat format, bool clear = true);
+
     /**
         Initialize the image data with zeroes (the default) or with the
         byte value given as @a value.
@@ -810,6 +868,28 @@ public:
     */
     wxImage BlurVertical(int blurRadius) const;
 
+    /**
+        Blurs the image using Gaussian kernel with the given standard
+        deviation.
+
+        The blur is approximated by several successive box blurs, so its cost
+        doesn't depend on @a sigma. As with Blur(), all the channels,
+        including alpha, are blurred independently and the pixels outside of
+        the image are considered to be the same as the closest edge pixels.
+        This should not be used when using a single mask colour for
+        transparency.
+
+        @param sigma
+            The standard deviation of the Gaussian kernel in pixels, the
+            image is noticeably changed up to about three times this distance
+            from each pixel. If it is 0, the image is returned unchanged.
+
+        @see Blur()
+
+        @since 3.1.5
+    */
+    wxImage GaussianBlur(double sigma) const;
+
     /**
         Returns a mirrored copy of the image.
         The parameter @a horizontally indicates the orientation.
@@ -871,6 +951,10 @@ public:
         Rotates the image about the given point, by @a angle radians.
 
         Passing @true to @a interpolating results in better image quality, but is slower.
+        Since wxWidgets 3.1.5 bilinear interpolation of the 4 source pixels
+        nearest to each pixel of the rotated image is used in this case,
+        previous versions used weights inversely proportional to the squared
+        distances to these pixels.
 
         If the image has a mask, then the mask colour is used for the uncovered
         pixels in the rotated image background. Else, black (rgb 0, 0, 0) will be used.
@@ -898,6 +982,10 @@ public:
         Rotates the hue of each pixel in the image by @e angle, which is a double in
         the range of -1.0 to +1.0, where -1.0 corresponds to -360 degrees and +1.0
         corresponds to +360 degrees.
+
+        Since wxWidgets 3.1.5 this function uses integer arithmetic and its
+        results may differ by 1 from those obtained using RGBtoHSV() and
+        HSVtoRGB().
     */
     void RotateHue(double angle);
 
@@ -1041,6 +1129,22 @@ public:
     */
     wxImage ConvertToDisabled(unsigned char brightness = 255) const;
 
+    /**
+        Returns a version of the image with changed lightness.
+
+        Every pixel of the returned image is the result of calling
+        wxColour::ChangeLightness() with the given @a alpha for the
+        corresponding pixel of this one, except for the pixels of the mask
+        colour, if any, which are left unchanged.
+
+        @param alpha
+            The lightness to use, in 0..200 range, see
+            wxColour::ChangeLightness(). 100 returns a copy of the image.
+
+        @since 3.1.5
+    */
+    wxImage ChangeLightness(int alpha) const;
+
     //@}
 
 
@@ -1119,6 +1223,9 @@ public:
         This pointer is @NULL for the images without the alpha channel. If the image
         does have it, this pointer may be used to directly manipulate the alpha values
         which are stored as the RGB ones.
+
+        If the image uses a packed pixel format, it is converted to
+        ::wxIMAGE_PIXEL_FORMAT_RGB by this function, see SetPixelFormat().
     */
     unsigned char* GetAlpha() const;
 
@@ -1133,6 +1240,9 @@ public:
         row, with second row following after it and so on.
 
         You should not delete the returned pointer nor pass it to SetData().
+
+        If the image uses a packed pixel format, it is converted to
+        ::wxIMAGE_PIXEL_FORMAT_RGB by this function, see SetPixelFormat().
     */
     unsigned char* GetData() const;
 
@@ -1238,10 +1348,28 @@ public:
             handler, this is still what happens however). These options must be
             set before calling LoadFile() to have any effect.
 
+        @li @c wxIMAGE_OPTION_MIN_WIDTH and @c wxIMAGE_OPTION_MIN_HEIGHT: If
+            either of these options is specified, the handlers supporting it
+            (only JPEG one right now) may load a reduced version of the image
+            if it is still at least as big as the given minimal size, e.g.
+            JPEG images can be loaded at 1/2, 1/4 or 1/8 of their size. This
+            is useful for making thumbnails of the given size: loading the
+            image with these options and then rescaling it to the exact size
+            is much faster than loading the entire image first. Unlike with
+            the maximal size options, the image is never rescaled after
+            loading it, so the handlers not supporting these options just
+            load the full image. @c wxIMAGE_OPTION_MAX_WIDTH and
+            @c wxIMAGE_OPTION_MAX_HEIGHT take precedence if they are
+            specified too. These options must be set before calling
+            LoadFile() to have any effect.
+            @since 3.1.5
+
         @li @c wxIMAGE_OPTION_ORIGINAL_WIDTH and @c wxIMAGE_OPTION_ORIGINAL_HEIGHT:
             These options will return the original size of the image if either
-            @c wxIMAGE_OPTION_MAX_WIDTH or @c wxIMAGE_OPTION_MAX_HEIGHT is
-            specified.
+            @c wxIMAGE_OPTION_MAX_WIDTH or @c wxIMAGE_OPTION_MAX_HEIGHT (or,
+            since 3.1.5, @c wxIMAGE_OPTION_MIN_WIDTH or
+            @c wxIMAGE_OPTION_MIN_HEIGHT) is specified and the image was
+            loaded at a reduced size.
             @since 2.9.3
 
         @li @c wxIMAGE_OPTION_QUALITY: JPEG quality used when saving. This is an
@@ -1263,6 +1391,12 @@ public:
             the image provides the resolution information and can be queried
             after loading the image.
 
+        Options specific to wxJPEGHandler:
+        @li @c wxIMAGE_OPTION_JPEG_FAST_IDCT: If this option is set to a
+            non-zero value before loading a JPEG file, the faster but slightly
+            less accurate integer inverse DCT is used for decoding it. This is
+            mostly useful for making thumbnails. @since 3.1.5
+
         Options specific to wxPNGHandler:
         @li @c wxIMAGE_OPTION_PNG_FORMAT: Format for saving a PNG file, see
             wxImagePNGType for the supported values.
@@ -1286,6 +1420,22 @@ public:
             (in bytes) for saving a PNG file. Ideally this should be as big as
             the resulting PNG file. Use this option if your application produces
             images with small size variation.
+        @li @c wxIMAGE_OPTION_PNG_PIXEL_FORMAT: If this option is set to one
+            of the packed ::wxImagePixelFormat values before loading a PNG
+            file with an alpha channel or a transparent colour, the image is
+            decoded directly into this format, see SetPixelFormat(), instead
+            of the default RGB one with a separate alpha array. This avoids
+            converting the image data when it's going to be used in the
+            packed format anyhow, e.g. for drawing it. Notice that the alpha
+            channel is kept in this case even if all pixels are opaque.
+            @since 3.1.5
+
+        Big PNG images are saved using several threads, see SetMaxThreads(),
+        which compress independent bands of rows concurrently. In this case
+        wxWidgets filters the rows itself, choosing the filter in the same way
+        as libpng, so the saved file may differ from the one produced when
+        using a single thread, although all the options above are still
+        taken into account and the image compression ratio is almost the same.
 
         Options specific to wxTIFFHandler:
         @li @c wxIMAGE_OPTION_TIFF_BITSPERSAMPLE: Number of bits per
@@ -1360,6 +1510,30 @@ public:
     */
     const wxPalette& GetPalette() const;
 
+    /**
+        Returns the format used for storing the pixel data.
+
+        @see SetPixelFormat()
+
+        @since 3.1.5
+    */
+    wxImagePixelFormat GetPixelFormat() const;
+
+    /**
+        Returns the pixel data stored in a packed format.
+
+        The returned array uses the format returned by GetPixelFormat() and
+        contains 4 bytes per pixel, with @c 4*GetWidth() bytes per row and
+        the rows following each other from top to bottom. As with GetData(),
+        modifying it affects all images sharing the same data.
+
+        @return Pointer to the pixel data or @NULL if the image uses
+            ::wxIMAGE_PIXEL_FORMAT_RGB.
+
+        @since 3.1.5
+    */
+    unsigned char* GetPixels() const;
+
     /**
         Returns a sub image of the current one as long as the rect belongs entirely
         to the image.
@@ -1376,6 +1550,8 @@ public:
     /**
         Returns @true if this image has alpha channel, @false otherwise.
 
+        Images using a packed pixel format always have alpha channel.
+
         @see GetAlpha(), SetAlpha()
     */
     bool HasAlpha() const;
@@ -1764,6 +1940,36 @@ public:
     */
     void SetPalette(const wxPalette& palette);
 
+    /**
+        Changes the format used for storing the pixel data in memory.
+
+        By default, wxImage stores RGB values and alpha in two separate arrays,
+        which is convenient for the image processing functions but requires
+        converting the data when drawing it. Converting an image to
+        ::wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED allows wxBitmap in wxGTK 3
+        and Cairo wxGraphicsContext to just copy its pixels, without
+        converting them. Conversely, wxBitmap::ConvertToImage() may return an
+        image in this format.
+
+        All the other wxImage functions keep working with images in packed
+        formats, but the image is converted back to ::wxIMAGE_PIXEL_FORMAT_RGB
+        by the functions accessing its RGB or alpha values, such as GetData(),
+        GetRed() or Scale(), which makes GetPixels() return @NULL. The alpha
+        channel is always kept when converting from a packed format. Unlike
+        this function, which gives this image its own copy of the data if it
+        was shared, these implicit conversions apply to all the images
+        sharing the same data.
+
+        Notice that the pointers previously returned by GetData(),
+        GetAlpha() or GetPixels() are invalidated when the format changes.
+
+        @return @true if the format was changed or @false if there was not
+            enough memory to do it.
+
+        @since 3.1.5
+    */
+    bool SetPixelFormat(wxImagePixelFormat format);
+
     /**
        Set the color of the pixel at the given x and y coordinate.
     */
@@ -2030,6 +2236,37 @@ public:
         Converts a color in HSV color space to RGB color space.
     */
     static wxImage::RGBValue HSVtoRGB(const wxImage::HSVValue& hsv);
+
+    /**
+        Sets the maximal number of threads used for processing big images.
+
+        Some operations, currently Scale() and Rescale() using any quality
+        other than ::wxIMAGE_QUALITY_NEAREST, Rotate(), Rotate90(),
+        Rotate180(), Mirror(), Replace(), RotateHue() and the colour conversion
+        functions such as ConvertToGreyscale() or ConvertToDisabled(), as well
+        as wxQuantize when not using Floyd-Steinberg dithering and saving PNG
+        files, split big images in bands of rows processed by several threads
+        in parallel. This function allows to limit the number of threads used
+        for this.
+
+        @param threads
+            The maximal number of threads to use, including the calling one.
+            The default value of 0 means to use as many threads as there are
+            CPUs in the system while 1 disables the use of any additional
+            threads.
+
+        @since 3.1.5
+     */
+    static void SetMaxThreads(int threads);
+
+    /**
+        Returns the maximal number of threads used for processing big images.
+
+        @see SetMaxThreads()
+
+        @since 3.1.5
+     */
+    static int GetMaxThreads();
 };
 
 
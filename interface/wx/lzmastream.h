@@ -60,6 +60,45 @@ public:
         delete it when it is itself destroyed.
      */
     wxLZMAInputStream(wxInputStream* stream);
+
+    /**
+        Sets the number of threads to use for decompression.
+
+        Using more than one thread only helps with the data compressed in
+        several blocks, e.g. by wxLZMAOutputStream::SetThreadCount() or
+        multi-threaded xz utility. If @a threads is 0, the number of CPUs is
+        used. This function must be called before reading anything.
+
+        Returns @false if the decoder couldn't be created. With liblzma
+        versions before 5.4, which don't support multi-threaded decoding, it
+        always returns @false unless @a threads is 1.
+
+        @since 3.1.5
+    */
+    bool SetThreadCount(int threads);
+
+    /**
+        Returns the number of threads used for decompression, 1 by default.
+
+        @since 3.1.5
+    */
+    int GetThreadCount() const;
+
+    /**
+        Reads the index of the xz file to allow seeking in it.
+
+        The parent stream must be seekable. After the index is successfully
+        loaded, this stream becomes seekable too and GetLength() returns the
+        size of the uncompressed data. Seeking is done by restarting
+        decompression at the start of the block containing the new position,
+        so it is only efficient for files compressed in several blocks.
+
+        Returns @false if the index couldn't be read. Requires liblzma 5.4 or
+        later, otherwise always returns @false.
+
+        @since 3.1.5
+    */
+    bool LoadIndex();
 };
 
 /**
@@ -101,6 +140,31 @@ class wxLZMAOutputStream : public wxFilterOutputStream
         delete it when it is itself destroyed.
      */
     wxLZMAOutputStream(wxOutputStream* stream);
+
+    /**
+        Sets the number of threads to use for compression.
+
+        The data is split into blocks of @a blockSize bytes compressed
+        independently, which may be done concurrently and also allows
+        wxLZMAInputStream to seek in the result. If @a blockSize is 0, liblzma
+        chooses it depending on the compression level, which results in
+        rather large blocks. If @a threads is 0, the number of CPUs is used.
+
+        This function must be called before writing anything. Returns @false
+        if the encoder couldn't be created. With liblzma versions before 5.2,
+        which don't support multi-threaded compression, it always returns
+        @false unless @a threads is 1, and @a blockSize is ignored.
+
+        @since 3.1.5
+    */
+    bool SetThreadCount(int threads, size_t blockSize = 0);
+
+    /**
+        Returns the number of threads used for compression, 1 by default.
+
+        @since 3.1.5
+    */
+    int GetThreadCount() const;
 };
 
 /**
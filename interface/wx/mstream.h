@@ -118,6 +118,10 @@ public:
         The @a len argument specifies the amount of data to read from the
         @a stream. Setting it to ::wxInvalidOffset means that the @a stream
         is to be read entirely (i.e. till the EOF is reached).
+
+        If @a stream is a wxMappedFileInputStream which could map the file into
+        memory, the data is not copied but shared with it. The mapping remains
+        valid even if @a stream is destroyed before this object.
     */
     wxMemoryInputStream(wxInputStream& stream,
                         wxFileOffset len = wxInvalidOffset);
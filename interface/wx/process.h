@@ -257,6 +257,58 @@ public:
     */
     void Redirect();
 
+    /**
+        Sends the output of the child process directly to the given streams.
+
+        This function turns on redirection, like Redirect(), but instead of
+        being available via GetInputStream() and GetErrorStream(), the child
+        process output is written to the provided streams as soon as it
+        becomes available, without accumulating it in memory. This is notably
+        useful for the processes producing a lot of output.
+
+        If a stream is a wxFileOutputStream, the child process writes directly
+        into the underlying file without passing the data through this process
+        at all.
+
+        Notice that the streams are not owned by wxProcess and must remain
+        valid until the child process terminates. When using asynchronous
+        execution, all the output will have been written to them by the time
+        OnTerminate() is called.
+
+        This function must be called before passing the object to ::wxExecute()
+        and is currently only implemented under Unix.
+
+        @param out
+            The stream receiving the standard output of the child, must be
+            non-@NULL.
+        @param err
+            The stream receiving the standard error of the child. If it is
+            @NULL, the standard error can be read from GetErrorStream() as
+            usual.
+
+        @since 3.1.5
+    */
+    void SetOutputSink(wxOutputStream *out, wxOutputStream *err = NULL);
+
+    /**
+        Returns the stream receiving the standard output of the child process.
+
+        @return The stream passed to SetOutputSink() or @NULL if it wasn't
+            called.
+
+        @since 3.1.5
+    */
+    wxOutputStream *GetOutputSink() const;
+
+    /**
+        Returns the stream receiving the standard error of the child process.
+
+        @return The second stream passed to SetOutputSink() or @NULL.
+
+        @since 3.1.5
+    */
+    wxOutputStream *GetErrorSink() const;
+
     /**
         Sets the priority of the process, between 0 (lowest) and 100 (highest).
         It can only be set before the process is created.
@@ -76,11 +76,15 @@ public:
         @return Returns the initialized stream. You must delete it yourself
                  once you don't use it anymore and this must be done before
                  the wxHTTP object itself is destroyed. The destructor
-                 closes the network connection. The next time you will
+                 closes the network connection, unless keep-alive is
+                 enabled and the entire response has been read from the
+                 stream, see SetKeepAlive(). The next time you will
                  try to get a file the network connection will have to
                  be reestablished, but you don't have to take care of
                  this since wxHTTP reestablishes it automatically.
 
+        Responses using chunked transfer encoding are decoded transparently.
+
         @see wxInputStream
     */
     virtual wxInputStream* GetInputStream(const wxString& path);
@@ -175,4 +179,132 @@ public:
     bool SetPostText(const wxString& contentType,
                      const wxString& data,
                      const wxMBConv& conv = wxConvUTF8);
+
+    /**
+        Set the stream providing the data to be posted to the server.
+
+        This is similar to SetPostBuffer() but avoids having to keep all the
+        data in memory. The data is read from the stream while sending the
+        request and, if its @a size is not specified, it is sent using
+        chunked transfer encoding, which requires the server to support
+        HTTP/1.1.
+
+        Notice that the request can't be resent if the connection is closed
+        while sending it, unlike a request with the body set by the other
+        functions.
+
+        @param contentType
+            The value of HTTP "Content-Type" header.
+        @param stream
+            The stream to read the data from, wxHTTP takes ownership of it and
+            deletes it after the next request.
+        @param size
+            The number of bytes to post or ::wxInvalidOffset if unknown.
+        @return
+            @true if the stream is valid or @false otherwise.
+
+        @since 3.1.5
+     */
+    bool SetPostStream(const wxString& contentType,
+                       wxInputStream *stream,
+                       wxFileOffset size = wxInvalidOffset);
+
+    /**
+        Enable or disable persistent connections.
+
+        When keep-alive is enabled, HTTP/1.1 is used for the requests and the
+        connection is not closed after getting the response, if the server
+        allows it, so that the next call to GetInputStream() can reuse it
+        instead of establishing a new one. For this to work, the entire
+        response must be read from the stream returned by GetInputStream()
+        before deleting it.
+
+        Keep-alive is disabled by default for compatibility.
+
+        @see wxHTTPConnectionPool
+
+        @since 3.1.5
+     */
+    void SetKeepAlive(bool on = true);
+
+    /**
+        Returns @true if keep-alive is enabled.
+
+        @see SetKeepAlive()
+
+        @since 3.1.5
+     */
+    bool IsKeepAlive() const;
+};
+
+/**
+    @class wxHTTPConnectionPool
+
+    Pool of wxHTTP objects with persistent connections to the same server.
+
+    This class allows to reuse the connections for several requests, possibly
+    made from different threads, without reestablishing them every time. Each
+    request must use the object returned by Acquire() and give it back using
+    Release() once the stream returned by wxHTTP::GetInputStream() has been
+    read and deleted.
+
+    Pipelining of the requests is not supported, each connection is used for
+    one request at a time.
+
+    @library{wxnet}
+    @category{net}
+
+    @see wxHTTP::SetKeepAlive()
+
+    @since 3.1.5
+*/
+class wxHTTPConnectionPool
+{
+public:
+    /**
+        Create a pool for the connections to the given server.
+
+        @param host
+            The host name or address of the server.
+        @param port
+            The port to connect to, 0 means the default HTTP port.
+        @param maxIdle
+            The maximal number of the connections kept open after being
+            released, the other ones are closed.
+     */
+    wxHTTPConnectionPool(const wxString& host,
+                         unsigned short port = 0,
+                         size_t maxIdle = 4);
+
+    /**
+        Destructor closes all idle connections.
+
+        All the objects returned by Acquire() must have been released before
+        the pool is destroyed.
+     */
+    ~wxHTTPConnectionPool();
+
+    /**
+        Returns an idle wxHTTP object or creates a new one.
+
+        The returned object has keep-alive enabled.
+
+        @return The object to use or @NULL if the host name couldn't be
+            resolved.
+     */
+    wxHTTP *Acquire();
+
+    /**
+        Gives back the object returned by Acquire().
+
+        The object is kept for reuse if its connection is still open and the
+        pool doesn't contain too many idle objects already, otherwise it is
+        deleted. In either case, it must not be used any more by the caller.
+     */
+    void Release(wxHTTP *http);
+
+    /**
+        Returns the number of idle connections in the pool.
+     */
+    size_t GetIdleCount() const;
 };
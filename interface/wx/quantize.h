@@ -5,6 +5,56 @@
 // Licence:     wxWindows licence
 /////////////////////////////////////////////////////////////////////////////
 
+// Flags for wxQuantize::Quantize() and wxQuantize::DoQuantize().
+
+/**
+    Reserve the first 20 palette entries for the Windows system colours
+    and shift the returned 8 bit data accordingly (MSW only).
+*/
+#define wxQUANTIZE_INCLUDE_WINDOWS_COLOURS 0x01
+
+/// Return the image data as palette indices in @c eightBitData.
+#define wxQUANTIZE_RETURN_8BIT_DATA 0x02
+
+/// Fill the destination image with the quantized colours.
+#define wxQUANTIZE_FILL_DESTINATION_IMAGE 0x04
+
+/**
+    Map each pixel to the nearest palette colour without dithering.
+
+    This is much faster than the default Floyd-Steinberg dithering,
+    notably because big images are processed using several threads, see
+    wxImage::SetMaxThreads(), but shows banding in the gradients.
+
+    @since 3.1.5
+*/
+#define wxQUANTIZE_NO_DITHER 0x08
+
+/**
+    Use ordered dithering instead of Floyd-Steinberg one.
+
+    Ordered dithering is as fast as ::wxQUANTIZE_NO_DITHER and, unlike
+    error diffusion, doesn't propagate changes in one part of the image to
+    the rest of it, which makes it more suitable for animations.
+
+    @since 3.1.5
+*/
+#define wxQUANTIZE_ORDERED_DITHER 0x10
+
+/**
+    Map the image to an existing palette instead of computing a new one.
+
+    The palette is taken from @c *pPalette, which must be non-@NULL, for
+    the Quantize() overload taking it, or from the destination image for
+    the other one. All of its colours are used, independently of the
+    number of colours requested, and the existing palette is neither
+    changed nor replaced. Using the same palette for all frames of an
+    animation avoids computing it again and makes the frames consistent.
+
+    @since 3.1.5
+*/
+#define wxQUANTIZE_USE_PALETTE 0x20
+
 /**
     @class wxQuantize
 
@@ -36,12 +86,35 @@ public:
                            unsigned char** in_rows, unsigned char** out_rows,
                            unsigned char* palette, int desiredNoColours);
 
+    /**
+        Converts input bitmap(s) into 8bit representation using the given
+        flags.
+
+        This overload is the same as the one above, except that it takes into
+        account ::wxQUANTIZE_NO_DITHER and ::wxQUANTIZE_ORDERED_DITHER and,
+        if ::wxQUANTIZE_USE_PALETTE is included in @a flags, uses the
+        @a desiredNoColours colours in @a palette as input instead of
+        computing them.
+
+        @since 3.1.5
+    */
+    static void DoQuantize(unsigned int w, unsigned int h,
+                           unsigned char** in_rows, unsigned char** out_rows,
+                           unsigned char* palette, int desiredNoColours,
+                           int flags);
+
     /**
         Reduce the colours in the source image and put the result into the destination image.
         Both images may be the same, to overwrite the source image.
 
         Specify an optional palette pointer to receive the resulting palette.
         This palette may be passed to ConvertImageToBitmap, for example.
+
+        The @a flags parameter is a combination of the @c wxQUANTIZE_XXX
+        constants. By default, Floyd-Steinberg dithering is used, see
+        ::wxQUANTIZE_NO_DITHER and ::wxQUANTIZE_ORDERED_DITHER for faster
+        alternatives and ::wxQUANTIZE_USE_PALETTE for reusing the palette
+        returned by a previous call.
     */
     static bool Quantize(const wxImage& src, wxImage& dest,
                          wxPalette** pPalette, int desiredNoColours = 236,
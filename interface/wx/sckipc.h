@@ -142,6 +142,42 @@ public:
         Returns @true if this is a valid host name, @false otherwise.
     */
     virtual bool ValidHost(const wxString& host);
+
+    /**
+        Enables the use of shared memory for the connections made by this
+        client.
+
+        If @a size is non-zero, MakeConnection() tries to create a block of
+        shared memory containing a ring buffer of at least the given size for
+        each direction and pass it to the server. If the server accepts it,
+        the data of all messages bigger than a single network packet is then
+        copied into these buffers instead of being written to the socket,
+        which is significantly faster for big amounts of data, while the
+        messages themselves are still sent over the socket.
+
+        The connection silently falls back to using only the socket if shared
+        memory can't be used, e.g. because the server doesn't support it, so
+        calling this function is always safe. Use
+        wxTCPConnection::UsesSharedMemory() to check if it is really used.
+
+        Notice that shared memory is currently only supported under Linux and
+        only for the servers using Unix domain sockets, i.e. whose service
+        name is a file path, as the memory is passed to the server over the
+        socket.
+
+        By default the size is 0 and shared memory is not used.
+
+        @since 3.1.5
+    */
+    void SetSharedMemorySize(size_t size);
+
+    /**
+        Returns the size of the shared memory buffers set with
+        SetSharedMemorySize().
+
+        @since 3.1.5
+    */
+    size_t GetSharedMemorySize() const;
 };
 
 
@@ -339,5 +375,16 @@ public:
         Returns @true if the server okays it, @false otherwise.
     */
     virtual bool StopAdvise(const wxString& item);
+
+    /**
+        Returns @true if this connection transfers the data using shared
+        memory instead of the socket.
+
+        This can only be the case for the connections made by a wxTCPClient
+        for which wxTCPClient::SetSharedMemorySize() was called.
+
+        @since 3.1.5
+    */
+    bool UsesSharedMemory() const;
 };
 
@@ -275,6 +275,146 @@ public:
 };
 
 
+/**
+    @class wxSocketServerPool
+
+    Server accepting the connections and handling them in several threads.
+
+    Unlike wxSocketServer, whose connections are all handled by the main
+    thread event loop, this class uses a fixed number of worker threads, each
+    with its own loop monitoring the sockets, and handles every accepted
+    connection in one of them. This allows to scale to a large number of
+    connections and to handle them without blocking the GUI.
+
+    By default, the connections are accepted by the first thread and
+    distributed between all of them in round-robin order. If
+    @c wxSOCKET_REUSEPORT flag is specified and supported by the platform,
+    each thread uses its own listening socket and the system distributes the
+    connections between them instead, which avoids the bottleneck of having
+    a single thread accepting all of them.
+
+    The @c wxEVT_SOCKET events for the accepted sockets are processed by the
+    event handler specified with SetEventHandler() directly in the thread
+    handling the socket, i.e. @e not in the main thread. This means that the
+    handler must be thread-safe and must not use any GUI functions, but it
+    can use the socket itself without any restrictions. The connection event
+    is generated for each new socket and the socket is closed and deleted by
+    the pool after its lost connection event is processed, or when
+    CloseConnection() is called: the sockets must never be deleted by the
+    application code.
+
+    This class is currently only available under Unix systems, where the
+    symbol @c wxHAS_SOCKET_SERVER_POOL is defined.
+
+    @since 3.1.5
+
+    @library{wxnet}
+    @category{net}
+*/
+class wxSocketServerPool
+{
+public:
+    /**
+        Creates the server sockets and the worker threads.
+
+        Use IsOk() to check whether this succeeded.
+
+        @param address
+            Specifies the local address for the server, the port may be 0 to
+            let the system choose it and GetLocal() can then be used to
+            retrieve it.
+        @param threads
+            Number of threads to use, 0 means to use as many threads as there
+            are CPUs in the system.
+        @param flags
+            Socket flags (see wxSocketBase::SetFlags()) used for the accepted
+            sockets, except for @c wxSOCKET_REUSEADDR and @c wxSOCKET_REUSEPORT
+            which are used for the server sockets only. Notice that @c
+            wxSOCKET_BLOCK can't be used as the accepted sockets must be
+            non-blocking to generate events.
+    */
+    wxSocketServerPool(const wxSockAddress& address,
+                       int threads = 0,
+                       wxSocketFlags flags = wxSOCKET_NONE);
+
+    /**
+        Destructor stops the threads and closes all the sockets.
+    */
+    ~wxSocketServerPool();
+
+    /**
+        Returns @true if the pool was successfully created and not stopped.
+    */
+    bool IsOk() const;
+
+    /**
+        Retrieves the local address the server sockets are bound to.
+    */
+    bool GetLocal(wxSockAddress& address) const;
+
+    /**
+        Returns the number of the worker threads.
+    */
+    int GetThreadCount() const;
+
+    /**
+        Returns @true if each thread uses its own listening socket.
+
+        This is only the case if @c wxSOCKET_REUSEPORT was specified and is
+        supported.
+    */
+    bool UsesReusePort() const;
+
+    /**
+        Sets the handler for the events of the accepted sockets.
+
+        Must be called before Start(). The events have the specified @a id
+        and are processed by calling wxEvtHandler::ProcessEventLocally() from
+        the worker threads.
+    */
+    void SetEventHandler(wxEvtHandler& handler, int id = wxID_ANY);
+
+    /**
+        Specifies the events generated for the accepted sockets.
+
+        Must be called before Start(). By default, input and lost connection
+        events are generated, @c wxSOCKET_CONNECTION_FLAG can be used to be
+        notified about the new connections too.
+
+        @see wxSocketBase::SetNotify()
+    */
+    void SetNotify(wxSocketEventFlags flags);
+
+    /**
+        Starts accepting the connections.
+
+        This function can be only called once.
+    */
+    bool Start();
+
+    /**
+        Stops the worker threads and closes all the sockets.
+
+        The pool can't be used any more after calling this function.
+    */
+    void Stop();
+
+    /**
+        Closes the given accepted socket.
+
+        The socket is deleted once all its pending events are processed. This
+        function must be called from the thread handling this socket, i.e.
+        from the event handler.
+    */
+    void CloseConnection(wxSocketBase* socket);
+
+    /**
+        Returns the total number of the currently open connections.
+    */
+    int GetConnectionCount() const;
+};
+
+
 /**
     @class wxSocketClient
 
@@ -673,6 +813,12 @@ enum wxSocketEventFlags
     and is generally used in conjunction with @b wxSOCKET_NOBIND and
     wxIPaddress::BroadcastAddress().
 
+    The @b wxSOCKET_REUSEPORT flag controls the use of the @b SO_REUSEPORT
+    @b setsockopt() flag, available since wxWidgets 3.1.5. It allows several
+    server sockets to listen on the same port, with the system distributing
+    the incoming connections between them, as done by wxSocketServerPool. It
+    is ignored on the platforms not supporting this option.
+
     So:
     - @b wxSOCKET_NONE will try to read at least SOME data, no matter how much.
     - @b wxSOCKET_NOWAIT will always return immediately, even if it cannot
@@ -698,7 +844,37 @@ enum
     wxSOCKET_NOWAIT_READ = 64,    ///< Read as much data as possible and return immediately
     wxSOCKET_WAITALL_READ = 128,  ///< Wait for all required data to be read unless an error occurs.
     wxSOCKET_NOWAIT_WRITE = 256,   ///< Write as much data as possible and return immediately
-    wxSOCKET_WAITALL_WRITE = 512   ///< Wait for all required data to be written unless an error occurs.
+    wxSOCKET_WAITALL_WRITE = 512,  ///< Wait for all required data to be written unless an error occurs.
+    wxSOCKET_REUSEPORT = 1024      ///< Allows several sockets to bind to the same port (since 3.1.5).
+};
+
+
+/**
+    Buffer used with wxSocketBase::ReadV() and wxSocketBase::WriteV().
+
+    This is a simple pair of the buffer pointer and its size.
+
+    @since 3.1.5
+
+    @library{wxnet}
+    @category{net}
+*/
+struct wxSocketBuffer
+{
+    /// Default constructor creates an empty buffer.
+    wxSocketBuffer();
+
+    /// Constructor for the buffers used for reading.
+    wxSocketBuffer(void* data, wxUint32 size);
+
+    /// Constructor for the buffers used for writing.
+    wxSocketBuffer(const void* data, wxUint32 size);
+
+    /// Pointer to the buffer data, may be @NULL only if size is 0.
+    void* data;
+
+    /// Size of the buffer in bytes.
+    wxUint32 size;
 };
 
 
@@ -1092,6 +1268,30 @@ public:
     */
     wxSocketBase& ReadMsg(void* buffer, wxUint32 nbytes);
 
+    /**
+        Read data from the socket into several buffers.
+
+        This function behaves exactly like Read() called with the single
+        buffer consisting of all the given buffers concatenated together, but
+        fills them all using a single system call when possible, i.e. the
+        buffers are filled in order and the next one is only used once the
+        previous one is full.
+
+        Use LastReadCount() to get the total number of bytes read.
+
+        @param buffers
+            Array of the buffers to fill, the array itself is not modified.
+        @param count
+            Number of elements in @a buffers array.
+
+        @return Returns a reference to the current object.
+
+        @see Read(), WriteV()
+
+        @since 3.1.5
+    */
+    wxSocketBase& ReadV(const wxSocketBuffer* buffers, size_t count);
+
     /**
         Use SetFlags to customize IO operation for this socket.
 
@@ -1120,6 +1320,9 @@ public:
             ready. This means that UI will be unresponsive during socket IO.
         @flag{wxSOCKET_REUSEADDR}
             Allows the use of an in-use port (wxServerSocket only).
+        @flag{wxSOCKET_REUSEPORT}
+            Allows several server sockets to listen on the same port (this
+            flag is new since wxWidgets 3.1.5).
         @flag{wxSOCKET_BROADCAST}
             Switches the socket to broadcast mode.
         @flag{wxSOCKET_NOBIND}
@@ -1326,11 +1529,72 @@ public:
         By setting these flags before the multi-threading, it will ensure that
         they don't get reset by thread race conditions.
 
+        Notice that the header, the data and the trailer following them are
+        all sent using a single system call when possible.
+
         @see  Error(), LastError(), LastWriteCount(), SetFlags(), ReadMsg()
 
     */
     wxSocketBase& WriteMsg(const void* buffer, wxUint32 nbytes);
 
+    /**
+        Write the data from several buffers to the socket.
+
+        This function behaves exactly like Write() called with the single
+        buffer consisting of all the given buffers concatenated together, but
+        avoids both copying the data into such buffer and sending it using
+        multiple system calls when possible.
+
+        Use LastWriteCount() to get the total number of bytes written.
+
+        @param buffers
+            Array of the buffers with the data to be sent, the array itself is
+            not modified.
+        @param count
+            Number of elements in @a buffers array.
+
+        @return Returns a reference to the current object.
+
+        @see Write(), ReadV()
+
+        @since 3.1.5
+    */
+    wxSocketBase& WriteV(const wxSocketBuffer* buffers, size_t count);
+
+    /**
+        Send the contents of the file to the socket.
+
+        Under Linux, the data is sent directly by the kernel using @c
+        sendfile() or, if the file is a pipe, @c splice(), without copying it
+        into the user space. Under the other platforms, or if the kernel
+        doesn't support this for the given file, the data is read from the
+        file and written to the socket using an intermediate buffer.
+
+        Like WriteMsg(), this function behaves as if the @b wxSOCKET_WAITALL
+        flag was always set. The current position of @a file after calling it
+        is unspecified.
+
+        Use LastWriteCount() to verify the number of bytes actually written,
+        notice that it is limited to 4GiB.
+
+        @param file
+            File to send the data from, must be opened for reading.
+        @param offset
+            Offset of the data to send in the file, ignored if the file is a
+            pipe.
+        @param size
+            Number of bytes to send or ::wxInvalidOffset to send everything
+            until the end of the file. If the file is shorter than @a size,
+            the available data is sent and an error is returned.
+
+        @return Returns a reference to the current object.
+
+        @since 3.1.5
+    */
+    wxSocketBase& SendFile(wxFile& file,
+                           wxFileOffset offset = 0,
+                           wxFileOffset size = wxInvalidOffset);
+
     //@}
 
 
@@ -18,6 +18,27 @@ enum wxStreamError
     wxSTREAM_READ_ERROR         //!< generic read error on the last read call.
 };
 
+/**
+    Describes a buffer used by wxInputStream::ReadV() and
+    wxOutputStream::WriteV().
+
+    @since 3.1.5
+*/
+struct wxIOVec
+{
+    /// Default constructor initializes an empty buffer descriptor.
+    wxIOVec();
+
+    /// Constructor from a pointer to the buffer and its size.
+    wxIOVec(const void *data, size_t size);
+
+    /// Pointer to the buffer data.
+    void *data;
+
+    /// Size of the buffer, in bytes.
+    size_t size;
+};
+
 /**
     @class wxStreamBase
 
@@ -280,6 +301,15 @@ public:
     */
     void* GetBufferEnd() const;
 
+    /**
+        Returns the maximal size the buffer can grow to.
+
+        @see SetMaxBufferSize()
+
+        @since 3.1.5
+    */
+    size_t GetMaxBufferSize() const;
+
     /**
         Returns a pointer on the current position of the stream buffer.
     */
@@ -410,6 +440,25 @@ public:
     */
     void SetIntPosition(size_t pos);
 
+    /**
+        Allows the buffer to grow up to the given size.
+
+        When a buffer allocated by this object is entirely filled or flushed
+        several times in a row, i.e. the stream is accessed sequentially, it
+        is grown by doubling its size, up to the given value, to reduce the
+        number of calls to the underlying stream. It shrinks back to its
+        original size when the stream is seeked.
+
+        By default, the buffer doesn't grow, except for the buffers created by
+        wxBufferedInputStream and wxBufferedOutputStream themselves.
+
+        @param size
+            The maximal buffer size or 0 to disable growing.
+
+        @since 3.1.5
+    */
+    void SetMaxBufferSize(size_t size);
+
     /**
         Returns the parent stream of the stream buffer.
         @deprecated use GetStream() instead
@@ -445,6 +494,23 @@ public:
         See Read().
     */
     size_t Write(wxStreamBuffer* buffer);
+
+    /**
+        Writes the data of several buffers.
+
+        If all the data fits into the buffer, it is simply copied there.
+        Otherwise the data already in the buffer is written to the stream
+        together with the new data using a single call to
+        wxOutputStream::OnSysWriteV(), without copying it.
+
+        Notice that Write() uses this function for the blocks of data which
+        are at least as big as the buffer itself.
+
+        @return The number of bytes of the new data written.
+
+        @since 3.1.5
+    */
+    size_t WriteV(const wxIOVec* vec, size_t count);
 };
 
 
@@ -550,6 +616,22 @@ public:
     */
     bool WriteAll(const void* buffer, size_t size);
 
+    /**
+        Writes the data of several buffers, in order.
+
+        This is equivalent to calling Write() for each of them, but can be
+        more efficient, e.g. wxFileOutputStream uses @c writev() system call
+        under Unix to write all of them at once and wxBufferedOutputStream
+        avoids copying them into its buffer.
+
+        LastWrite() returns the total amount of data written by this function.
+
+        Classes overriding Write() must override this function as well.
+
+        @since 3.1.5
+    */
+    virtual wxOutputStream& WriteV(const wxIOVec* vec, size_t count);
+
 protected:
     /**
         Internal function. It is called when the stream wants to write data of the
@@ -560,6 +642,17 @@ protected:
         variable @c m_lasterror should be appropriately set).
     */
     size_t OnSysWrite(const void* buffer, size_t bufsize);
+
+    /**
+        Internal function called to write the data of several buffers.
+
+        The default implementation calls OnSysWrite() for each of the buffers
+        until one of them is written only partially. It may be overridden to
+        write all of them at once.
+
+        @since 3.1.5
+    */
+    virtual size_t OnSysWriteV(const wxIOVec* vec, size_t count);
 };
 
 
@@ -642,6 +735,22 @@ public:
     */
     wxInputStream& Read(wxOutputStream& stream_out);
 
+    /**
+        Reads data into several buffers, filling them in order.
+
+        This is equivalent to calling Read() for each of the buffers, but can
+        be more efficient, e.g. wxFileInputStream uses @c readv() system call
+        under Unix to fill all of them at once.
+
+        As with Read(), less data than requested may be read and LastRead()
+        returns the total amount of data read into all buffers.
+
+        Classes overriding Read() must override this function as well.
+
+        @since 3.1.5
+    */
+    virtual wxInputStream& ReadV(const wxIOVec* vec, size_t count);
+
     /**
         Reads exactly the specified number of bytes into the buffer.
 
@@ -718,6 +827,17 @@ protected:
         variable should be set accordingly as well).
     */
     size_t OnSysRead(void* buffer, size_t bufsize) = 0;
+
+    /**
+        Internal function called to read data into several buffers.
+
+        The default implementation calls OnSysRead() for each of the buffers
+        until one of them is filled only partially. It may be overridden to
+        read data into all of them at once.
+
+        @since 3.1.5
+    */
+    virtual size_t OnSysReadV(const wxIOVec* vec, size_t count);
 };
 
 
@@ -769,6 +889,9 @@ public:
     This class may not be used without some other stream to read the data
     from (such as a file stream or a memory stream).
 
+    Reads of blocks of data at least as big as the buffer bypass it and read
+    the data directly into the memory provided by the caller.
+
     @library{wxbase}
     @category{streams}
 
@@ -785,7 +908,9 @@ public:
         @param buffer
             The buffer to use if non-@NULL. Notice that the ownership of this
             buffer is taken by the stream, i.e. it will delete it. If this
-            parameter is @NULL a default 1KB buffer is used.
+            parameter is @NULL a default 1KB buffer is used. Since wxWidgets
+            3.1.5 this buffer grows up to 64KB when the stream is used
+            sequentially, see wxStreamBuffer::SetMaxBufferSize().
     */
     wxBufferedInputStream(wxInputStream& stream,
                           wxStreamBuffer *buffer = NULL);
@@ -1040,6 +1165,8 @@ public:
     This stream acts as a cache. It caches the bytes to be written to the specified
     output stream (See wxFilterOutputStream). The data is only written when the
     cache is full, when the buffered stream is destroyed or when calling SeekO().
+    Blocks of data at least as big as the cache are written directly, together
+    with the data already in it, without being copied into it.
 
     This class may not be used without some other stream to write the data
     to (such as a file stream or a memory stream).
@@ -1060,7 +1187,9 @@ public:
         @param buffer
             The buffer to use if non-@NULL. Notice that the ownership of this
             buffer is taken by the stream, i.e. it will delete it. If this
-            parameter is @NULL a default 1KB buffer is used.
+            parameter is @NULL a default 1KB buffer is used. Since wxWidgets
+            3.1.5 this buffer grows up to 64KB when the stream is used
+            sequentially, see wxStreamBuffer::SetMaxBufferSize().
     */
     wxBufferedOutputStream(wxOutputStream& stream,
                            wxStreamBuffer *buffer = NULL);
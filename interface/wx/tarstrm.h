@@ -91,6 +91,105 @@ public:
         seekable stream.
     */
     bool OpenEntry(wxTarEntry& entry);
+
+    /**
+        Closes the current entry if one is open, then opens the entry with the
+        given name.
+
+        For a tar on a seekable stream, the entry is found using the index
+        built by LoadIndex(), which is called by this function if necessary.
+        For tars on non-seekable streams the entries following the current
+        one are searched sequentially, so only the entries after it can be
+        opened.
+
+        Returns @false if there is no entry with this name.
+
+        @since 3.1.5
+    */
+    bool OpenEntry(const wxString& name, wxPathFormat format = wxPATH_NATIVE);
+
+    /**
+        Reads the headers of all the entries in the tar and indexes them by
+        name.
+
+        As a tar has no central directory, this requires reading all the
+        headers, but the entries data is skipped by seeking if the parent
+        stream is seekable. Once the index is built, FindEntry() and
+        OpenEntry() can be used to access the entries directly, and the index
+        can be saved using SaveIndex() to avoid rebuilding it later.
+
+        If some entries had been already read, the parent stream is rewound
+        to the beginning of the tar, which is only possible if it is seekable.
+        For the compressed tars, a seekable parent can be obtained by using
+        wxLZMAInputStream::LoadIndex() with a .tar.xz compressed in several
+        blocks.
+
+        The index is only built once, subsequent calls just return @true.
+
+        @since 3.1.5
+    */
+    bool LoadIndex();
+
+    /**
+        Loads the index previously saved by SaveIndex() from the given stream.
+
+        Returns @false if the stream doesn't contain a valid index or if the
+        index is for a tar of a different size, when the length of the parent
+        stream is known. Any existing index is replaced by the loaded one.
+
+        @since 3.1.5
+    */
+    bool LoadIndex(wxInputStream& index);
+
+    /**
+        Saves the index built by LoadIndex() to the given stream.
+
+        The saved index is typically stored in a file next to the tar and
+        allows to avoid reading all its headers again the next time it is
+        opened.
+
+        @since 3.1.5
+    */
+    bool SaveIndex(wxOutputStream& index) const;
+
+    /**
+        Returns @true if the index had been loaded by one of LoadIndex()
+        overloads.
+
+        @since 3.1.5
+    */
+    bool HasIndex() const;
+
+    /**
+        Returns the number of entries in the index, in the order in which they
+        appear in the tar, or 0 if it is not loaded.
+
+        @since 3.1.5
+    */
+    size_t GetIndexedCount() const;
+
+    /**
+        Returns the entry with the given position in the index or @NULL if
+        the position is invalid or the index is not loaded.
+
+        The returned object is owned by the stream and remains valid for as
+        long as it exists.
+
+        @since 3.1.5
+    */
+    const wxTarEntry* GetIndexedEntry(size_t n) const;
+
+    /**
+        Returns the entry with the given name or @NULL if there is no such
+        entry or if the index is not loaded.
+
+        If the tar contains several entries with the same name, the last one
+        is returned, as it is the one that would be extracted by tar.
+
+        @since 3.1.5
+    */
+    const wxTarEntry* FindEntry(const wxString& name,
+                                wxPathFormat format = wxPATH_NATIVE) const;
 };
 
 
@@ -116,6 +116,9 @@
         The request state changed.
     @event{wxEVT_WEBREQUEST_DATA(id, func)}
         A new block of data has been downloaded.
+    @event{wxEVT_WEBREQUEST_PROGRESS(id, func)}
+        More data has been downloaded, only sent if SetProgressInterval() was
+        called. This event is available since wxWidgets 3.1.5.
     @endEventTable
 
     @since 3.1.5
@@ -272,6 +275,20 @@ public:
     */
     void Cancel();
 
+    /**
+        Resume the transfer paused by the data sink.
+
+        This function must be called after wxWebRequestSink::OnData() returns
+        wxWebRequestSink::Result_Pause to continue receiving the data. Unlike
+        most of the other functions of this class, it may be called from any
+        thread.
+
+        @see SetDataSink()
+
+        @since 3.1.5
+    */
+    void Resume();
+
     /**
         Returns a response object after a successful request.
 
@@ -400,6 +417,33 @@ public:
     */
     void SetStorage(Storage storage);
 
+    /**
+        Sets the object receiving the response data as soon as it arrives.
+
+        Using a sink is similar to using @c Storage_None, but the data is
+        passed to wxWebRequestSink::OnData() directly from the code receiving
+        it instead of being copied into a buffer and sent to the main thread
+        in @c wxEVT_WEBREQUEST_DATA events, which is more efficient for big
+        downloads. The sink may also pause the transfer if it can't process
+        the data quickly enough, see wxWebRequestSink::Result_Pause.
+
+        This function must be called before Start() and changes the storage
+        to @c Storage_None.
+
+        Currently data sinks are only supported by the libcurl backend.
+
+        @param sink
+            The sink to use, the request takes ownership of it and deletes it
+            when it's destroyed itself. Use wxWebRequestStreamSink to write
+            the data to a wxOutputStream.
+        @return
+            @false if data sinks are not supported by the backend used, in
+            which case the sink is deleted immediately.
+
+        @since 3.1.5
+    */
+    bool SetDataSink(wxWebRequestSink* sink);
+
     /**
         Disable SSL certificate verification.
 
@@ -457,9 +501,131 @@ public:
         @see wxWebResponse::GetContentLength()
     */
     wxFileOffset GetBytesExpectedToReceive() const;
+
+    /**
+        Enables generation of @c wxEVT_WEBREQUEST_PROGRESS events.
+
+        When the interval is positive, an event is generated when more data
+        is received, but not more often than once per the given number of
+        milliseconds. Moreover, a new event is not generated until the
+        previous one is processed, so the event queue is never flooded with
+        these events even if the main thread is busy. Use GetBytesReceived()
+        and GetBytesExpectedToReceive() in the event handler to get the
+        current progress.
+
+        By default, the interval is 0 and no progress events are generated.
+
+        @since 3.1.5
+    */
+    void SetProgressInterval(int milliseconds);
     ///@}
 };
 
+/**
+    @class wxWebRequestSink
+
+    Interface for the objects receiving the response data directly.
+
+    Objects of a class implementing this interface can be passed to
+    wxWebRequest::SetDataSink() to process the data as soon as it's received,
+    e.g. to parse it or write it somewhere, without buffering it.
+
+    Example of a sink calculating a checksum of the downloaded data in a
+    background thread:
+    @code
+    class ChecksumSink : public wxWebRequestSink
+    {
+    public:
+        virtual Result OnData(const void* data, size_t size) wxOVERRIDE
+        {
+            if ( m_queue.IsFull() )
+            {
+                // Ask the checksum thread to call wxWebRequest::Resume()
+                // after it processes some data.
+                m_queue.RequestResume();
+                return Result_Pause;
+            }
+
+            m_queue.Push(data, size);
+            return Result_Continue;
+        }
+
+        ...
+    };
+    @endcode
+
+    @since 3.1.5
+
+    @library{wxnet}
+    @category{net}
+
+    @see wxWebRequestStreamSink
+*/
+class wxWebRequestSink
+{
+public:
+    /**
+        Possible return values of OnData().
+    */
+    enum Result
+    {
+        /// The data has been consumed, the transfer continues.
+        Result_Continue,
+
+        /**
+            The data couldn't be consumed now and the transfer is paused.
+
+            The same data will be passed to OnData() again after
+            wxWebRequest::Resume() is called.
+         */
+        Result_Pause,
+
+        /// The data couldn't be processed, the request fails.
+        Result_Abort
+    };
+
+    /**
+        Called with each new block of data received.
+
+        Note that this function may be called from a worker thread, or from
+        the main thread, depending on the backend used, so it shouldn't
+        access any GUI objects directly. It should also avoid blocking for a
+        long time, as this would prevent the other requests of the same
+        session from making progress with some backends, and return
+        Result_Pause instead.
+
+        @param data Pointer to the data, valid only during this call.
+        @param size Size of the data, in bytes.
+    */
+    virtual Result OnData(const void* data, size_t size) = 0;
+
+    /// Trivial but virtual destructor.
+    virtual ~wxWebRequestSink();
+};
+
+/**
+    @class wxWebRequestStreamSink
+
+    Data sink writing the received data to a stream.
+
+    Note that the stream is not owned by the sink and must remain valid for
+    the lifetime of the request. Its OnData() aborts the request if writing
+    to the stream fails.
+
+    @since 3.1.5
+
+    @library{wxnet}
+    @category{net}
+*/
+class wxWebRequestStreamSink : public wxWebRequestSink
+{
+public:
+    /**
+        Create the sink writing to the given stream.
+    */
+    explicit wxWebRequestStreamSink(wxOutputStream& stream);
+};
+
 /**
     Authentication challenge information available via
     wxWebRequest::GetAuthChallenge().
@@ -709,6 +875,106 @@ public:
     */
     wxString GetTempDir() const;
 
+    /**
+        @name Connection management
+
+        These functions allow to control how the connections used by the
+        requests of this session are opened and reused. They are currently
+        only implemented by the libcurl backend and return @false if the
+        option is not supported by the backend or by the version of the
+        library used at run-time.
+
+        Notice that the options only apply to the requests created after
+        calling these functions, but the limits on the number of connections
+        also affect the requests already running.
+
+        Example of configuring a session used for making many small requests
+        to the same server:
+        @code
+        wxWebSession session = wxWebSession::New();
+        session.SetMaxConnectionsPerHost(4);
+        session.EnableMultiplexing();
+        session.EnableSharedCache();
+        @endcode
+     */
+    //@{
+
+    /**
+        Sets the maximum number of simultaneously open connections to the
+        same host.
+
+        The requests which can't be started because of this limit are queued
+        until one of the existing connections becomes available, which allows
+        to reuse a few persistent connections for many requests.
+
+        The default value is 0, meaning that there is no limit.
+
+        @since 3.1.5
+    */
+    bool SetMaxConnectionsPerHost(int count);
+
+    /**
+        Sets the maximum number of simultaneously open connections.
+
+        This limits both the number of the connections used by the running
+        requests and the number of idle connections kept open for reuse.
+
+        The default value is 0, meaning that there is no limit.
+
+        @since 3.1.5
+    */
+    bool SetMaxConnections(int count);
+
+    /**
+        Enables or disables multiplexing several requests over a single
+        connection using HTTP/2.
+
+        When multiplexing is enabled, the new requests wait for an existing
+        connection to the same host to be established instead of opening a
+        new one, if possible. Notice that libcurl enables multiplexing by
+        default since version 7.62, but without waiting for the connection.
+
+        @since 3.1.5
+    */
+    bool EnableMultiplexing(bool enable = true);
+
+    /**
+        Configures TCP keep-alive probes.
+
+        Sets the time, in seconds, the connection must be idle for before
+        sending the keep-alive probes and the interval between them, which
+        is the same as @a idle if it is 0. Passing 0 for @a idle disables
+        the keep-alive probes.
+
+        @since 3.1.5
+    */
+    bool SetKeepAlive(int idle, int interval = 0);
+
+    /**
+        Sets the maximum time, in seconds, an idle connection may be kept for
+        reuse.
+
+        Passing 0 restores the default value, which is 118 seconds for the
+        libcurl backend.
+
+        @since 3.1.5
+    */
+    bool SetMaxIdleTime(int seconds);
+
+    /**
+        Enables or disables sharing DNS and TLS session caches, as well as
+        the connection cache with libcurl 7.57 or later, between all the
+        requests of this session.
+
+        This allows to reuse TLS sessions when opening new connections to the
+        same server, which avoids the full TLS handshake.
+
+        @since 3.1.5
+    */
+    bool EnableSharedCache(bool enable = true);
+
+    //@}
+
     /**
         Returns the default session
     */
@@ -832,3 +1098,4 @@ public:
 
 wxEventType wxEVT_WEBREQUEST_STATE;
 wxEventType wxEVT_WEBREQUEST_DATA;
+wxEventType wxEVT_WEBREQUEST_PROGRESS;
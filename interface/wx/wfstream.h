@@ -265,6 +265,113 @@ public:
 
 
 
+/**
+    Hints about the expected access pattern for wxMappedFileInputStream.
+
+    @since 3.1.5
+*/
+enum wxMappedFileAccess
+{
+    /// No particular access pattern, this is the default.
+    wxMAPPED_FILE_ACCESS_NORMAL,
+
+    /// The data will be read sequentially from the beginning to the end.
+    wxMAPPED_FILE_ACCESS_SEQUENTIAL,
+
+    /// The data will be read at arbitrary offsets.
+    wxMAPPED_FILE_ACCESS_RANDOM
+};
+
+/**
+    @class wxMappedFileInputStream
+
+    Input stream reading the file contents directly from memory.
+
+    This stream maps the file into the process address space if possible,
+    which allows reading from it without any system calls and without copying
+    the data into an intermediate buffer. Additionally, the contents of the
+    mapped file can be accessed directly using GetData().
+
+    If the file can't be mapped, e.g. because it is not a regular file, the
+    stream transparently falls back to reading it using wxFile, so it can be
+    used in any case. IsMapped() can be used to check which mode is used.
+
+    Creating a wxMemoryInputStream from this stream doesn't copy the data but
+    shares the mapping with it, and so is cheap even for big files.
+
+    Notice that, as with any use of memory mapped files, the file must not be
+    truncated by another process while it is being read from, as accessing the
+    mapped data beyond the end of the file results in a crash under Unix.
+
+    @library{wxbase}
+    @category{streams}
+
+    @see wxFileInputStream, wxMemoryInputStream
+
+    @since 3.1.5
+*/
+class wxMappedFileInputStream : public wxInputStream
+{
+public:
+    /**
+        Opens the file with the given name in read-only mode and maps it into
+        memory if possible.
+
+        The @a access parameter is passed to the OS as a hint allowing it to
+        optimize the read ahead strategy and can be changed later by calling
+        SetAccessHint().
+
+        @warning
+        You should use wxStreamBase::IsOk() to verify if the constructor succeeded.
+    */
+    wxMappedFileInputStream(const wxString& fileName,
+                            wxMappedFileAccess access = wxMAPPED_FILE_ACCESS_NORMAL);
+
+    /**
+        Destructor.
+
+        The file is unmapped unless the mapping is still used by a
+        wxMemoryInputStream created from this stream.
+    */
+    virtual ~wxMappedFileInputStream();
+
+    /**
+        Returns @true if the stream is initialized and ready.
+    */
+    bool IsOk() const;
+
+    /**
+        Returns @true if the file contents are mapped into memory.
+
+        If this function returns @false, the stream reads the file contents
+        using wxFile and GetData() returns @NULL.
+    */
+    bool IsMapped() const;
+
+    /**
+        Returns the pointer to the file contents.
+
+        The returned pointer remains valid as long as this stream exists. It
+        is @NULL if the file is not mapped.
+    */
+    const void *GetData() const;
+
+    /**
+        Returns the size of the data returned by GetData().
+    */
+    size_t GetDataLength() const;
+
+    /**
+        Changes the hint about the access pattern passed to the OS.
+
+        This function does nothing under the platforms not supporting such
+        hints.
+    */
+    void SetAccessHint(wxMappedFileAccess access);
+};
+
+
+
 /**
     @class wxFFileInputStream
 
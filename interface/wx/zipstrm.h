@@ -434,6 +434,102 @@ public:
         @see overview_archive_byname
     */
     bool OpenEntry(wxZipEntry& entry);
+
+    /**
+        Closes the current entry if one is open, then opens the entry with the
+        given name.
+
+        For a zip on a seekable stream, the entry is found using the index
+        loaded by LoadIndex(), which is called by this function if necessary.
+        For zips on non-seekable streams the entries following the current
+        one are searched sequentially, so only the entries after it can be
+        opened.
+
+        Returns @false if there is no entry with this name.
+
+        @since 3.1.5
+    */
+    bool OpenEntry(const wxString& name, wxPathFormat format = wxPATH_NATIVE);
+
+    /**
+        Reads the whole central directory of a zip on a seekable stream at
+        once and indexes its entries by name.
+
+        This allows to find the entries using FindEntry() and to open them
+        directly using OpenEntry() or OpenEntryStream() without reading the
+        entries preceding them.
+
+        The index is only loaded once, subsequent calls just return @true.
+        Returns @false if the stream is not seekable or the central directory
+        couldn't be read.
+
+        @since 3.1.5
+    */
+    bool LoadIndex();
+
+    /**
+        Returns @true if LoadIndex() had been successfully called.
+
+        @since 3.1.5
+    */
+    bool HasIndex() const;
+
+    /**
+        Returns the number of entries in the index, in the order in which they
+        appear in the central directory, or 0 if it is not loaded.
+
+        @since 3.1.5
+    */
+    size_t GetIndexedCount() const;
+
+    /**
+        Returns the entry with the given position in the index or @NULL if
+        the position is invalid or the index is not loaded.
+
+        The returned object is owned by the stream and remains valid for as
+        long as it exists.
+
+        @since 3.1.5
+    */
+    const wxZipEntry* GetIndexedEntry(size_t n) const;
+
+    /**
+        Returns the entry with the given name or @NULL if there is no such
+        entry or if the index is not loaded.
+
+        The returned object is owned by the stream and remains valid for as
+        long as it exists.
+
+        @since 3.1.5
+    */
+    const wxZipEntry* FindEntry(const wxString& name,
+                                wxPathFormat format = wxPATH_NATIVE) const;
+
+    /**
+        Creates a new stream reading the data of the given entry independently
+        of this one.
+
+        This function can only be used after LoadIndex() and @a entry must be
+        one of the entries of the index. The returned stream must be deleted
+        by the caller and checks the size and CRC of the entry data, just as
+        reading from this stream does.
+
+        Unlike the other functions of this class, this one can be called
+        concurrently from several threads, allowing to extract different
+        entries at the same time. It is especially efficient when the zip is
+        read from wxMappedFileInputStream or wxMemoryInputStream, as the data
+        is then decompressed directly from memory, but in this case the
+        returned stream must not outlive this one. Otherwise the compressed
+        data of the entry is read into memory first and the other functions
+        of this stream must not be used while this function is running in
+        another thread.
+
+        Returns @NULL if the entry couldn't be opened or uses an unsupported
+        compression method.
+
+        @since 3.1.5
+    */
+    wxInputStream* OpenEntryStream(const wxZipEntry& entry) const;
 };
 
 
@@ -619,5 +715,44 @@ public:
         @since 3.1.1
     */
     wxZipArchiveFormat GetFormat() const;
+
+    /**
+        Compress several entries concurrently.
+
+        When more than one thread is used, the data of each entry using the
+        built-in compression methods (i.e. ::wxZIP_METHOD_DEFAULT,
+        ::wxZIP_METHOD_STORE or ::wxZIP_METHOD_DEFLATE) is collected in memory
+        and compressed in the background when the entry is closed, while the
+        next entries are being added. The entries are still written to the
+        archive in the order in which they were added, as soon as they are
+        compressed, with their sizes and checksums in their local headers.
+
+        Entries bigger than a few megabytes, as well as the entries flushed
+        using Sync(), are written directly as usual, but their data is
+        compressed using several threads too, see
+        wxZlibOutputStream::SetThreadCount().
+
+        Notice that an overridden OpenCompressor() is not used for the entries
+        compressed in the background.
+
+        This function can't be called while an entry is open.
+
+        @param threads
+            The number of threads to use, 0 meaning to use as many threads as
+            there are CPUs and 1, which is the default, disabling concurrent
+            compression.
+
+        @since 3.1.5
+    */
+    void SetThreadCount(int threads);
+
+    /**
+        Returns the number of threads used for compression.
+
+        @see SetThreadCount()
+
+        @since 3.1.5
+    */
+    int GetThreadCount() const;
 };
 
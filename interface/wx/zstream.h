@@ -88,6 +88,47 @@ public:
     bool SetDictionary(const char *data, size_t datalen);
     bool SetDictionary(const wxMemoryBuffer &buf);
     //@}
+
+    /**
+        Compress the data using several threads.
+
+        In this mode the data is split into blocks of the given size which are
+        compressed concurrently, each of them using the end of the previous
+        block as dictionary to preserve most of the compression ratio. The
+        resulting stream is a normal zlib, gzip or raw deflate stream which
+        can be read by any decompressor.
+
+        The output is written in bigger chunks than in the default mode, and
+        Sync() results in a sync flush rather than a full one, i.e. the
+        compression dictionary is not reset.
+
+        This function must be called before writing anything to the stream.
+        SetDictionary() can be used after calling it, but not with gzip
+        streams, as in the default mode.
+
+        @param threads
+            The number of threads to use, 0 meaning to use as many threads as
+            there are CPUs and 1, which is the default, disabling parallel
+            compression.
+        @param blockSize
+            The size of the independently compressed blocks, 0 means to use
+            the default size of 128KB.
+        @return
+            @true if the number of threads was changed, @false if
+            wxWidgets was built without threads support.
+
+        @since 3.1.5
+    */
+    bool SetThreadCount(int threads, size_t blockSize = 0);
+
+    /**
+        Returns the number of threads used for compression.
+
+        @see SetThreadCount()
+
+        @since 3.1.5
+    */
+    int GetThreadCount() const;
 };
 
 
@@ -21,6 +21,7 @@
 
 #ifndef WX_PRECOMP
     #include "wx/module.h"
+    #include "wx/utils.h"
 #endif //WX_PRECOMP
 
 #include "wx/private/fdiodispatcher.h"
@@ -28,11 +29,16 @@
 #include "wx/private/selectdispatcher.h"
 #ifdef __UNIX__
     #include "wx/unix/private/epolldispatcher.h"
+    #include "wx/unix/private/iouringdispatcher.h"
 #endif
 
 static
 wxFDIODispatcher *gs_dispatcher = NULL;
 
+// the kind of gs_dispatcher, Kind_Default means to use WXFDIO_DISPATCHER
+static
+wxFDIODispatcher::Kind gs_dispatcherKind = wxFDIODispatcher::Kind_Default;
+
 // ============================================================================
 // implementation
 // ============================================================================
@@ -42,17 +48,68 @@ wxFDIODispatcher *gs_dispatcher = NULL;
 // ----------------------------------------------------------------------------
 
 /* static */
-wxFDIODispatcher *wxFDIODispatcher::Get()
+wxFDIODispatcher *wxFDIODispatcher::Create(Kind kind)
 {
-    if ( !gs_dispatcher )
+    wxFDIODispatcher *dispatcher = NULL;
+
+    switch ( kind )
     {
+        case Kind_IOUring:
+#ifdef wxHAS_IO_URING_DISPATCHER
+            dispatcher = wxIOUringDispatcher::Create();
+            if ( dispatcher )
+                break;
+#endif // wxHAS_IO_URING_DISPATCHER
+            wxFALLTHROUGH;
+
+        case Kind_Default:
+        case Kind_Epoll:
 #if wxUSE_EPOLL_DISPATCHER
-        gs_dispatcher = wxEpollDispatcher::Create();
-        if ( !gs_dispatcher )
+            dispatcher = wxEpollDispatcher::Create();
+            if ( dispatcher )
+                break;
 #endif // wxUSE_EPOLL_DISPATCHER
+            wxFALLTHROUGH;
+
+        case Kind_Select:
 #if wxUSE_SELECT_DISPATCHER
-            gs_dispatcher = new wxSelectDispatcher();
+            dispatcher = new wxSelectDispatcher();
 #endif // wxUSE_SELECT_DISPATCHER
+            break;
+    }
+
+    return dispatcher;
+}
+
+/* static */
+bool wxFDIODispatcher::SetDefaultKind(Kind kind)
+{
+    if ( gs_dispatcher )
+        return false;
+
+    gs_dispatcherKind = kind;
+
+    return true;
+}
+
+/* static */
+wxFDIODispatcher *wxFDIODispatcher::Get()
+{
+    if ( !gs_dispatcher )
+    {
+        Kind kind = gs_dispatcherKind;
+        wxString name;
+        if ( kind == Kind_Default && wxGetEnv("WXFDIO_DISPATCHER", &name) )
+        {
+            if ( name == "select" )
+                kind = Kind_Select;
+            else if ( name == "epoll" )
+                kind = Kind_Epoll;
+            else if ( name == "io_uring" )
+                kind = Kind_IOUring;
+        }
+
+        gs_dispatcher = Create(kind);
     }
 
     wxASSERT_MSG( gs_dispatcher, "failed to create any IO dispatchers" );
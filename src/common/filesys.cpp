@@ -279,10 +279,13 @@ wxFSFile* wxLocalFSHandler::OpenFile(wxFileSystem& WXUNUSED(fs), const wxString&
 
     // we need to check whether we can really read from this file, otherwise
     // wxFSFile is not going to work
-#if wxUSE_FFILE
+#if wxUSE_FILE
+    // Map the file into memory if possible: this allows the consumers of the
+    // stream, e.g. archive or image handlers, to read from it without any
+    // intermediate buffering.
+    wxMappedFileInputStream *is = new wxMappedFileInputStream(fullpath);
+#elif wxUSE_FFILE
     wxFFileInputStream *is = new wxFFileInputStream(fullpath);
-#elif wxUSE_FILE
-    wxFileInputStream *is = new wxFileInputStream(fullpath);
 #else
 #error One of wxUSE_FILE or wxUSE_FFILE must be set to 1 for wxFSHandler to work
 #endif
@@ -18,6 +18,7 @@
 #endif
 
 #include "wx/archive.h"
+#include "wx/zipstrm.h"
 #include "wx/private/fileback.h"
 
 //---------------------------------------------------------------------------
@@ -61,6 +62,9 @@ public:
 private:
     wxArchiveFSEntry *AddToCache(wxArchiveEntry *entry);
     void CloseStreams();
+#if wxUSE_ZIPSTREAM
+    bool LoadZipIndex();
+#endif
 
     int m_refcount;
 
@@ -71,6 +75,11 @@ private:
     wxBackingFile m_backer;
     wxInputStream *m_stream;
     wxArchiveInputStream *m_archive;
+#if wxUSE_ZIPSTREAM
+    // the archive streams have no RTTI of their own, so remember whether
+    // m_archive is a wxZipInputStream using the factory which created it
+    bool m_isZip;
+#endif
 };
 
 wxArchiveFSCacheDataImpl::wxArchiveFSCacheDataImpl(
@@ -83,6 +92,9 @@ wxArchiveFSCacheDataImpl::wxArchiveFSCacheDataImpl(
     m_stream(new wxBackedInputStream(backer)),
     m_archive(factory.NewStream(*m_stream))
 {
+#if wxUSE_ZIPSTREAM
+    m_isZip = wxDynamicCast(&factory, wxZipClassFactory) != NULL;
+#endif
 }
 
 wxArchiveFSCacheDataImpl::wxArchiveFSCacheDataImpl(
@@ -94,17 +106,19 @@ wxArchiveFSCacheDataImpl::wxArchiveFSCacheDataImpl(
     m_stream(stream),
     m_archive(factory.NewStream(*m_stream))
 {
+#if wxUSE_ZIPSTREAM
+    m_isZip = wxDynamicCast(&factory, wxZipClassFactory) != NULL;
+#endif
 }
 
 wxArchiveFSCacheDataImpl::~wxArchiveFSCacheDataImpl()
 {
-    WX_CLEAR_HASH_MAP(wxArchiveFSEntryHash, m_hash);
-
     wxArchiveFSEntry *entry = m_begin;
 
     while (entry)
     {
         wxArchiveFSEntry *next = entry->next;
+        delete entry->entry;
         delete entry;
         entry = next;
     }
@@ -114,7 +128,13 @@ wxArchiveFSCacheDataImpl::~wxArchiveFSCacheDataImpl()
 
 wxArchiveFSEntry *wxArchiveFSCacheDataImpl::AddToCache(wxArchiveEntry *entry)
 {
-    m_hash[entry->GetName(wxPATH_UNIX)] = entry;
+    // if the same name occurs more than once, the first one wins, as it's
+    // the one found by a sequential search (all of them are still listed and
+    // owned by the list, so that they're deleted in the dtor)
+    const wxString name = entry->GetName(wxPATH_UNIX);
+    if (m_hash.find(name) == m_hash.end())
+        m_hash[name] = entry;
+
     wxArchiveFSEntry *fse = new wxArchiveFSEntry;
     *m_endptr = fse;
     (*m_endptr)->entry = entry;
@@ -139,6 +159,16 @@ wxArchiveEntry *wxArchiveFSCacheDataImpl::Get(const wxString& name)
     if (!m_archive)
         return NULL;
 
+#if wxUSE_ZIPSTREAM
+    // Zip archives can be indexed all at once using their central directory
+    // instead of searching through the entries one by one.
+    if (!m_begin && LoadZipIndex())
+    {
+        it = m_hash.find(name);
+        return it != m_hash.end() ? it->second : NULL;
+    }
+#endif // wxUSE_ZIPSTREAM
+
     wxArchiveEntry *entry;
 
     while ((entry = m_archive->GetNextEntry()) != NULL)
@@ -154,6 +184,26 @@ wxArchiveEntry *wxArchiveFSCacheDataImpl::Get(const wxString& name)
     return NULL;
 }
 
+#if wxUSE_ZIPSTREAM
+bool wxArchiveFSCacheDataImpl::LoadZipIndex()
+{
+    if (!m_isZip)
+        return false;
+
+    wxZipInputStream * const zip = static_cast<wxZipInputStream*>(m_archive);
+    if (!zip->LoadIndex())
+        return false;
+
+    const size_t count = zip->GetIndexedCount();
+    for (size_t n = 0; n < count; n++)
+        AddToCache(new wxZipEntry(*zip->GetIndexedEntry(n)));
+
+    CloseStreams();
+
+    return true;
+}
+#endif // wxUSE_ZIPSTREAM
+
 wxInputStream* wxArchiveFSCacheDataImpl::NewStream() const
 {
     if (m_backer)
@@ -166,6 +216,11 @@ wxArchiveFSEntry *wxArchiveFSCacheDataImpl::GetNext(wxArchiveFSEntry *fse)
 {
     wxArchiveFSEntry *next = fse ? fse->next : m_begin;
 
+#if wxUSE_ZIPSTREAM
+    if (!m_begin && m_archive && LoadZipIndex())
+        return m_begin;
+#endif // wxUSE_ZIPSTREAM
+
     if (!next && m_archive)
     {
         wxArchiveEntry *entry = m_archive->GetNextEntry();
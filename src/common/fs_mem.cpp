@@ -22,9 +22,16 @@
     #endif // wxUSE_GUI
 #endif
 
+#include "wx/atomic.h"
 #include "wx/mstream.h"
+#include "wx/thread.h"
 
 // represents a file entry in wxMemoryFS
+//
+// The entries are reference counted: the memory FS itself holds one reference
+// while the file is stored in it and each stream returned by OpenFile() holds
+// another one, so that the data remains valid until the stream is destroyed
+// even if the file is removed from the memory FS in the meanwhile.
 class wxMemoryFSFile
 {
 public:
@@ -34,7 +41,7 @@ public:
         memcpy(m_Data, data, len);
         m_Len = len;
         m_MimeType = mime;
-        InitTime();
+        Init();
     }
 
     wxMemoryFSFile(const wxMemoryOutputStream& stream, const wxString& mime)
@@ -43,12 +50,14 @@ public:
         m_Data = new char[m_Len];
         stream.CopyTo(m_Data, m_Len);
         m_MimeType = mime;
-        InitTime();
+        Init();
     }
 
-    virtual ~wxMemoryFSFile()
+    void IncRef() { wxAtomicInc(m_refCount); }
+    void DecRef()
     {
-        delete[] m_Data;
+        if ( !wxAtomicDec(m_refCount) )
+            delete this;
     }
 
     char *m_Data;
@@ -58,14 +67,33 @@ public:
     wxDateTime m_Time;
 #endif // wxUSE_DATETIME
 
+    // the name of this file and the neighbours in the list of the files
+    // sorted by the time of the last access, only used while it is stored in
+    // the memory FS
+    wxString m_Name;
+    wxMemoryFSFile *m_Prev,
+                   *m_Next;
+
 private:
-    void InitTime()
+    // use DecRef() instead
+    ~wxMemoryFSFile()
+    {
+        delete[] m_Data;
+    }
+
+    void Init()
     {
 #if wxUSE_DATETIME
         m_Time = wxDateTime::Now();
 #endif // wxUSE_DATETIME
+
+        m_Prev =
+        m_Next = NULL;
+        m_refCount = 1;
     }
 
+    wxAtomicInt m_refCount;
+
     wxDECLARE_NO_COPY_CLASS(wxMemoryFSFile);
 };
 
@@ -79,9 +107,112 @@ private:
 
 wxMemoryFSHash wxMemoryFSHandlerBase::m_Hash;
 
+namespace
+{
+
+#if wxUSE_THREADS
+// protects m_Hash and all the variables below
+wxCriticalSection gs_csMemoryFS;
+#endif // wxUSE_THREADS
+
+// the list of all the stored files, from the most to the least recently used
+wxMemoryFSFile *gs_mostRecentlyUsed = NULL;
+wxMemoryFSFile *gs_leastRecentlyUsed = NULL;
+
+// the maximal total size of the files or 0 if unlimited
+size_t gs_maxSize = 0;
+
+wxMemoryFSStatistics gs_stats;
+
+// Input stream reading directly from the file data and keeping a reference
+// to the file while it exists.
+class wxMemoryFSInputStream : public wxMemoryInputStream
+{
+public:
+    // takes ownership of the reference to the file
+    explicit wxMemoryFSInputStream(wxMemoryFSFile *file)
+        : wxMemoryInputStream(file->m_Data, file->m_Len),
+          m_file(file)
+    {
+    }
+
+    virtual ~wxMemoryFSInputStream()
+    {
+        m_file->DecRef();
+    }
+
+private:
+    wxMemoryFSFile * const m_file;
+
+    wxDECLARE_NO_COPY_CLASS(wxMemoryFSInputStream);
+};
+
+// All the functions below must be called while holding gs_csMemoryFS.
+
+void UnlinkFile(wxMemoryFSFile *file)
+{
+    if ( file->m_Prev )
+        file->m_Prev->m_Next = file->m_Next;
+    else
+        gs_mostRecentlyUsed = file->m_Next;
+
+    if ( file->m_Next )
+        file->m_Next->m_Prev = file->m_Prev;
+    else
+        gs_leastRecentlyUsed = file->m_Prev;
+
+    file->m_Prev =
+    file->m_Next = NULL;
+}
+
+void LinkFileAsMostRecent(wxMemoryFSFile *file)
+{
+    file->m_Next = gs_mostRecentlyUsed;
+    if ( gs_mostRecentlyUsed )
+        gs_mostRecentlyUsed->m_Prev = file;
+    else
+        gs_leastRecentlyUsed = file;
+
+    gs_mostRecentlyUsed = file;
+}
+
+// remove the file from the list and release the reference held by it, the
+// caller is responsible for removing it from the hash map
+void ReleaseFile(wxMemoryFSFile *file)
+{
+    UnlinkFile(file);
+
+    gs_stats.filesCount--;
+    gs_stats.totalSize -= file->m_Len;
+
+    file->DecRef();
+}
+
+// remove the least recently used files until their total size doesn't exceed
+// the limit, but never remove the given file which has just been added
+void EvictFiles(wxMemoryFSHash& hash, wxMemoryFSFile *keep = NULL)
+{
+    if ( !gs_maxSize )
+        return;
+
+    while ( gs_stats.totalSize > gs_maxSize &&
+                gs_leastRecentlyUsed && gs_leastRecentlyUsed != keep )
+    {
+        wxMemoryFSFile * const file = gs_leastRecentlyUsed;
+
+        hash.erase(file->m_Name);
+        ReleaseFile(file);
+
+        gs_stats.evictions++;
+    }
+}
+
+} // anonymous namespace
+
 
 wxMemoryFSHandlerBase::wxMemoryFSHandlerBase() : wxFileSystemHandler()
 {
+    m_findIndex = 0;
 }
 
 wxMemoryFSHandlerBase::~wxMemoryFSHandlerBase()
@@ -89,7 +220,12 @@ wxMemoryFSHandlerBase::~wxMemoryFSHandlerBase()
     // as only one copy of FS handler is supposed to exist, we may silently
     // delete static data here. (There is no way how to remove FS handler from
     // wxFileSystem other than releasing _all_ handlers.)
-    WX_CLEAR_HASH_MAP(wxMemoryFSHash, m_Hash);
+    wxCRIT_SECT_LOCKER(lock, gs_csMemoryFS);
+
+    while ( gs_mostRecentlyUsed )
+        ReleaseFile(gs_mostRecentlyUsed);
+
+    m_Hash.clear();
 }
 
 bool wxMemoryFSHandlerBase::CanOpen(const wxString& location)
@@ -100,15 +236,34 @@ bool wxMemoryFSHandlerBase::CanOpen(const wxString& location)
 wxFSFile * wxMemoryFSHandlerBase::OpenFile(wxFileSystem& WXUNUSED(fs),
                                            const wxString& location)
 {
-    wxMemoryFSHash::const_iterator i = m_Hash.find(GetRightLocation(location));
-    if ( i == m_Hash.end() )
-        return NULL;
+    wxMemoryFSFile *obj;
+    {
+        wxCRIT_SECT_LOCKER(lock, gs_csMemoryFS);
+
+        wxMemoryFSHash::const_iterator i = m_Hash.find(GetRightLocation(location));
+        if ( i == m_Hash.end() )
+        {
+            gs_stats.misses++;
+            return NULL;
+        }
 
-    const wxMemoryFSFile * const obj = i->second;
+        gs_stats.hits++;
+
+        obj = i->second;
+        obj->IncRef();
+
+        if ( obj != gs_mostRecentlyUsed )
+        {
+            UnlinkFile(obj);
+            LinkFileAsMostRecent(obj);
+        }
+    }
 
+    // the stream takes ownership of the reference to the file, so it's safe
+    // to use it without holding the lock any more
     return new wxFSFile
                (
-                    new wxMemoryInputStream(obj->m_Data, obj->m_Len),
+                    new wxMemoryFSInputStream(obj),
                     location,
                     obj->m_MimeType,
                     GetAnchor(location)
@@ -120,9 +275,10 @@ wxFSFile * wxMemoryFSHandlerBase::OpenFile(wxFileSystem& WXUNUSED(fs),
 
 wxString wxMemoryFSHandlerBase::FindFirst(const wxString& url, int flags)
 {
-    // Make sure to reset the find iterator, so that calling FindNext() doesn't
-    // reuse its value from the last search that could well be invalid.
-    m_findIter = m_Hash.end();
+    // Make sure to reset the results, so that calling FindNext() doesn't
+    // return those of the last search.
+    m_findResults.clear();
+    m_findIndex = 0;
 
     if ( (flags & wxDIR) && !(flags & wxFILE) )
     {
@@ -136,36 +292,46 @@ wxString wxMemoryFSHandlerBase::FindFirst(const wxString& url, int flags)
     {
         // simple case: there are no wildcard characters so we can return
         // either 0 or 1 results and we can find the potential match quickly
+        wxCRIT_SECT_LOCKER(lock, gs_csMemoryFS);
+
         return m_Hash.count(spec) ? url : wxString();
     }
-    //else: deal with wildcards in FindNext()
 
-    m_findArgument = spec;
-    m_findIter = m_Hash.begin();
+    // Collect all the matches at once instead of iterating over m_Hash in
+    // FindNext() as it can be modified by another thread in the meanwhile.
+    {
+        wxCRIT_SECT_LOCKER(lock, gs_csMemoryFS);
+
+        for ( wxMemoryFSHash::const_iterator i = m_Hash.begin();
+              i != m_Hash.end();
+              ++i )
+        {
+            if ( i->first.Matches(spec) )
+                m_findResults.push_back(i->first);
+        }
+    }
 
     return FindNext();
 }
 
 wxString wxMemoryFSHandlerBase::FindNext()
 {
-    while ( m_findIter != m_Hash.end() )
-    {
-        const wxString& path = m_findIter->first;
-
-        // advance m_findIter first as we need to do it anyhow, whether it
-        // matches or not
-        ++m_findIter;
-
-        if ( path.Matches(m_findArgument) )
-            return "memory:" + path;
-    }
+    if ( m_findIndex == m_findResults.size() )
+        return wxString();
 
-    return wxString();
+    return "memory:" + m_findResults[m_findIndex++];
 }
 
 bool wxMemoryFSHandlerBase::CheckDoesntExist(const wxString& filename)
 {
-    if ( m_Hash.count(filename) )
+    bool exists;
+    {
+        wxCRIT_SECT_LOCKER(lock, gs_csMemoryFS);
+
+        exists = m_Hash.count(filename) != 0;
+    }
+
+    if ( exists )
     {
         wxLogError(_("Memory VFS already contains file '%s'!"), filename);
         return false;
@@ -174,6 +340,73 @@ bool wxMemoryFSHandlerBase::CheckDoesntExist(const wxString& filename)
     return true;
 }
 
+/*static*/
+bool wxMemoryFSHandlerBase::DoAddFile(const wxString& filename,
+                                      wxMemoryFSFile *file)
+{
+    {
+        wxCRIT_SECT_LOCKER(lock, gs_csMemoryFS);
+
+        // check for the existing file again as it could have been added by
+        // another thread since the caller checked for it
+        wxMemoryFSFile*& slot = m_Hash[filename];
+        if ( !slot )
+        {
+            slot = file;
+
+            file->m_Name = filename;
+            LinkFileAsMostRecent(file);
+
+            gs_stats.filesCount++;
+            gs_stats.totalSize += file->m_Len;
+
+            EvictFiles(m_Hash, file);
+
+            return true;
+        }
+    }
+
+    file->DecRef();
+
+    return CheckDoesntExist(filename);
+}
+
+/*static*/
+void wxMemoryFSHandlerBase::SetMaxSize(size_t size)
+{
+    wxCRIT_SECT_LOCKER(lock, gs_csMemoryFS);
+
+    gs_maxSize = size;
+
+    EvictFiles(m_Hash);
+}
+
+/*static*/
+size_t wxMemoryFSHandlerBase::GetMaxSize()
+{
+    wxCRIT_SECT_LOCKER(lock, gs_csMemoryFS);
+
+    return gs_maxSize;
+}
+
+/*static*/
+wxMemoryFSStatistics wxMemoryFSHandlerBase::GetStatistics()
+{
+    wxCRIT_SECT_LOCKER(lock, gs_csMemoryFS);
+
+    return gs_stats;
+}
+
+/*static*/
+void wxMemoryFSHandlerBase::ResetStatistics()
+{
+    wxCRIT_SECT_LOCKER(lock, gs_csMemoryFS);
+
+    gs_stats.hits =
+    gs_stats.misses =
+    gs_stats.evictions = 0;
+}
+
 
 /*static*/
 void wxMemoryFSHandlerBase::AddFileWithMimeType(const wxString& filename,
@@ -194,7 +427,7 @@ void wxMemoryFSHandlerBase::AddFileWithMimeType(const wxString& filename,
     if ( !CheckDoesntExist(filename) )
         return;
 
-    m_Hash[filename] = new wxMemoryFSFile(binarydata, size, mimetype);
+    DoAddFile(filename, new wxMemoryFSFile(binarydata, size, mimetype));
 }
 
 /*static*/
@@ -216,17 +449,23 @@ void wxMemoryFSHandlerBase::AddFile(const wxString& filename,
 
 /*static*/ void wxMemoryFSHandlerBase::RemoveFile(const wxString& filename)
 {
-    wxMemoryFSHash::iterator i = m_Hash.find(filename);
-    if ( i == m_Hash.end() )
     {
-        wxLogError(_("Trying to remove file '%s' from memory VFS, "
-                     "but it is not loaded!"),
-                   filename);
-        return;
+        wxCRIT_SECT_LOCKER(lock, gs_csMemoryFS);
+
+        wxMemoryFSHash::iterator i = m_Hash.find(filename);
+        if ( i != m_Hash.end() )
+        {
+            // notice that the file data is only freed if it's not used by
+            // any stream returned by OpenFile()
+            ReleaseFile(i->second);
+            m_Hash.erase(i);
+            return;
+        }
     }
 
-    delete i->second;
-    m_Hash.erase(i);
+    wxLogError(_("Trying to remove file '%s' from memory VFS, "
+                 "but it is not loaded!"),
+               filename);
 }
 
 #endif // wxUSE_BASE
@@ -245,11 +484,12 @@ wxMemoryFSHandler::AddFile(const wxString& filename,
     wxMemoryOutputStream mems;
     if ( image.IsOk() && image.SaveFile(mems, type) )
     {
-        m_Hash[filename] = new wxMemoryFSFile
-                               (
-                                    mems,
-                                    wxImage::FindHandler(type)->GetMimeType()
-                               );
+        DoAddFile(filename,
+                  new wxMemoryFSFile
+                      (
+                        mems,
+                        wxImage::FindHandler(type)->GetMimeType()
+                      ));
     }
     else
     {
@@ -46,6 +46,8 @@ static wxString GetFSWEventChangeTypeName(int type)
         return "WARNING";
     case wxFSW_EVENT_ERROR:
         return "ERROR";
+    case wxFSW_EVENT_BATCH:
+        return "BATCH";
     }
 
     // should never be reached!
@@ -67,6 +69,12 @@ wxString wxFileSystemWatcherEvent::ToString() const
         return wxString::Format("FSW_EVT type=%d (%s) message='%s'", m_changeType,
             GetFSWEventChangeTypeName(m_changeType), GetErrorDescription());
     }
+    if (m_changeType == wxFSW_EVENT_BATCH)
+    {
+        return wxString::Format("FSW_EVT type=%d (%s) changes=%lu",
+            m_changeType, GetFSWEventChangeTypeName(m_changeType),
+            static_cast<unsigned long>(m_changes.size()));
+    }
     return wxString::Format("FSW_EVT type=%d (%s) path='%s'", m_changeType,
             GetFSWEventChangeTypeName(m_changeType), GetPath().GetFullPath());
 }
@@ -121,6 +129,15 @@ wxFileSystemWatcherBase::AddAny(const wxFileName& path,
     if (canonical.IsEmpty())
         return false;
 
+    return AddCanonicalPath(canonical, events, type, filespec);
+}
+
+bool
+wxFileSystemWatcherBase::AddCanonicalPath(const wxString& canonical,
+                                          int events,
+                                          wxFSWPathType type,
+                                          const wxString& filespec)
+{
     // Check if the patch isn't already being watched.
     wxFSWatchInfoMap::iterator it = m_watches.find(canonical);
     if ( it == m_watches.end() )
@@ -146,6 +163,21 @@ wxFileSystemWatcherBase::AddAny(const wxFileName& path,
     return true;
 }
 
+bool wxFileSystemWatcherBase::SetCoalescingDelay(int WXUNUSED(milliseconds))
+{
+    return false;
+}
+
+bool wxFileSystemWatcherBase::EnableBatching(bool WXUNUSED(enable))
+{
+    return false;
+}
+
+bool wxFileSystemWatcherBase::EnableOverflowRecovery(bool WXUNUSED(enable))
+{
+    return false;
+}
+
 bool wxFileSystemWatcherBase::Remove(const wxFileName& path)
 {
     // args validation & consistency checks
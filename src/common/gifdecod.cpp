@@ -57,10 +57,14 @@ public:
     int transparent;                // transparent color index (-1 = none)
     wxAnimationDisposal disposal;   // disposal method
     long delay;                     // delay in ms (-1 = unused)
-    unsigned char *p;               // bitmap
+    unsigned char *p;               // bitmap (NULL if not decoded)
     unsigned char *pal;             // palette
     unsigned int ncolours;          // number of colours
     wxString comment;
+    size_t lzwOffset;               // offset of the compressed data
+    size_t lzwSize;                 // size of the compressed data
+    int bits;                       // initial code size
+    bool interlaced;                // rows are stored in interlaced order
 
     wxDECLARE_NO_COPY_CLASS(GIFImage);
 };
@@ -84,6 +88,10 @@ GIFImage::GIFImage()
     p = (unsigned char *) NULL;
     pal = (unsigned char *) NULL;
     ncolours = 0;
+    lzwOffset = 0;
+    lzwSize = 0;
+    bits = 0;
+    interlaced = false;
 }
 
 //---------------------------------------------------------------------------
@@ -92,6 +100,7 @@ GIFImage::GIFImage()
 
 wxGIFDecoder::wxGIFDecoder()
 {
+    m_maxCachedFrames = 4;
 }
 
 wxGIFDecoder::~wxGIFDecoder()
@@ -112,6 +121,55 @@ void wxGIFDecoder::Destroy()
 
     m_frames.Clear();
     m_nFrames = 0;
+
+    m_lzwData = wxMemoryBuffer();
+    m_cachedFrames.clear();
+}
+
+void wxGIFDecoder::SetMaxCachedFrames(unsigned int frames)
+{
+    m_maxCachedFrames = frames;
+
+    TrimCache();
+}
+
+void wxGIFDecoder::TrimCache() const
+{
+    while ( m_maxCachedFrames && m_cachedFrames.size() > m_maxCachedFrames )
+    {
+        GIFImage * const f = GetFrame(m_cachedFrames.back());
+        free(f->p);
+        f->p = NULL;
+
+        m_cachedFrames.pop_back();
+    }
+}
+
+wxGIFErrorCode wxGIFDecoder::DecodeFrame(unsigned int frame) const
+{
+    GIFImage * const f = GetFrame(frame);
+    if ( f->p )
+    {
+        for ( size_t n = 0; n < m_cachedFrames.size(); n++ )
+        {
+            if ( m_cachedFrames[n] == frame )
+            {
+                m_cachedFrames.erase(m_cachedFrames.begin() + n);
+                break;
+            }
+        }
+    }
+    else
+    {
+        wxGIFErrorCode result = dgif(f);
+        if ( result != wxGIF_OK )
+            return result;
+    }
+
+    m_cachedFrames.insert(m_cachedFrames.begin(), frame);
+    TrimCache();
+
+    return wxGIF_OK;
 }
 
 
@@ -140,8 +198,11 @@ bool wxGIFDecoder::ConvertToImage(unsigned int frame, wxImage *image) const
     if (!image->IsOk())
         return false;
 
-    pal = GetPalette(frame);
     src = GetData(frame);
+    if (!src)
+        return false;
+
+    pal = GetPalette(frame);
     dst = image->GetData();
     transparent = GetTransparentColourIndex(frame);
 
@@ -273,7 +334,12 @@ wxColour wxGIFDecoder::GetTransparentColour(unsigned int frame) const
                     pal[n*3 + 2]);
 }
 
-unsigned char* wxGIFDecoder::GetData(unsigned int frame) const    { return (GetFrame(frame)->p); }
+unsigned char* wxGIFDecoder::GetData(unsigned int frame) const
+{
+    return DecodeFrame(frame) == wxGIF_OK ? GetFrame(frame)->p : NULL;
+}
+
+
 unsigned char* wxGIFDecoder::GetPalette(unsigned int frame) const { return (GetFrame(frame)->pal); }
 unsigned int wxGIFDecoder::GetNcolours(unsigned int frame) const  { return (GetFrame(frame)->ncolours); }
 int wxGIFDecoder::GetTransparentColourIndex(unsigned int frame) const  { return (GetFrame(frame)->transparent); }
@@ -284,163 +350,125 @@ int wxGIFDecoder::GetTransparentColourIndex(unsigned int frame) const  { return
 // GIF reading and decoding
 //---------------------------------------------------------------------------
 
-// getcode:
-//  Reads the next code from the file stream, with size 'bits'
-//
-int wxGIFDecoder::getcode(wxInputStream& stream, int bits, int ab_fin)
-{
-    unsigned int mask;          // bit mask
-    unsigned int code;          // code (result)
-
-    // get remaining bits from last byte read
-    mask = (1 << bits) - 1;
-    code = (m_lastbyte >> (8 - m_restbits)) & mask;
-
-    // keep reading new bytes while needed
-    while (bits > m_restbits)
-    {
-        // if no bytes left in this block, read the next block
-        if (m_restbyte == 0)
-        {
-            m_restbyte = stream.GetC();
-
-            /* Some encoders are a bit broken: instead of issuing
-             * an end-of-image symbol (ab_fin) they come up with
-             * a zero-length subblock!! We catch this here so
-             * that the decoder sees an ab_fin code.
-             */
-            if (m_restbyte == 0)
-            {
-                code = ab_fin;
-                break;
-            }
-
-            // prefetch data
-            stream.Read((void *) m_buffer, m_restbyte);
-            if (stream.LastRead() != m_restbyte)
-            {
-                code = ab_fin;
-                return code;
-            }
-            m_bufp = m_buffer;
-        }
-
-        // read next byte and isolate the bits we need
-        m_lastbyte = (unsigned char) (*m_bufp++);
-        mask       = (1 << (bits - m_restbits)) - 1;
-        code       = code + ((m_lastbyte & mask) << m_restbits);
-        m_restbyte--;
-
-        // adjust total number of bits extracted from the buffer
-        m_restbits = m_restbits + 8;
-    }
-
-    // find number of bits remaining for next code
-    m_restbits = (m_restbits - bits);
-
-    return code;
-}
-
-
 // dgif:
-//  GIF decoding function. The initial code size (aka root size)
-//  is 'bits'. Supports interlaced images (interl == 1).
+//  GIF decoding function, decodes the compressed data of the given frame and
+//  allocates its bitmap. Supports interlaced images.
 //  Returns wxGIF_OK (== 0) on success, or an error code if something
-// fails (see header file for details)
-wxGIFErrorCode
-wxGIFDecoder::dgif(wxInputStream& stream, GIFImage *img, int interl, int bits)
+//  fails (see header file for details)
+//
+//  The alphabet stores the length and the first character of the string
+//  corresponding to each code, which allows to write the strings directly
+//  into the image buffer, from their end, instead of using a stack.
+wxGIFErrorCode wxGIFDecoder::dgif(GIFImage *img) const
 {
-    static const int allocSize = 4096 + 1;
+    static const int allocSize = 4096;
 
-    wxScopedArray<int> ab_prefix(allocSize); // alphabet (prefixes)
-    if ( !ab_prefix )
-        return wxGIF_MEMERR;
+    const int bits = img->bits;
+    if (bits > 11)
+        return wxGIF_INVFORMAT;
 
-    wxScopedArray<int> ab_tail(allocSize);   // alphabet (tails)
-    if ( !ab_tail )
+    wxScopedArray<wxUint16> ab_prefix(allocSize); // alphabet (prefixes)
+    wxScopedArray<wxUint16> ab_length(allocSize); // lengths of the strings
+    wxScopedArray<unsigned char> ab_tail(allocSize);  // alphabet (tails)
+    wxScopedArray<unsigned char> ab_first(allocSize); // first characters
+    if ( !ab_prefix || !ab_length || !ab_tail || !ab_first )
         return wxGIF_MEMERR;
 
-    wxScopedArray<int> stack(allocSize);     // decompression stack
-    if ( !stack )
+    // The last string may be written past the end of the image, so allocate
+    // enough space for it.
+    const size_t npixels = static_cast<size_t>(img->w) * img->h;
+    unsigned char * const
+        out = static_cast<unsigned char *>(malloc(npixels + allocSize));
+    if ( !out )
         return wxGIF_MEMERR;
 
-    int ab_clr;                     // clear code
-    int ab_fin;                     // end of info code
-    int ab_bits;                    // actual symbol width, in bits
-    int ab_free;                    // first free position in alphabet
-    int ab_max;                     // last possible character in alphabet
-    int pass;                       // pass number in interlaced images
-    int pos;                        // index into decompresion stack
-    unsigned int x, y;              // position in image buffer
-
-    int code, lastcode, abcabca;
+    wxScopeGuard guardOut = wxMakeGuard(free, out);
 
     // these won't change
-    ab_clr = (1 << bits);
-    ab_fin = (1 << bits) + 1;
+    const int ab_clr = (1 << bits);         // clear code
+    const int ab_fin = (1 << bits) + 1;     // end of info code
+
+    for (int c = 0; c < ab_clr; c++)
+    {
+        ab_tail[c] =
+        ab_first[c] = (unsigned char) c;
+        ab_length[c] = 1;
+    }
 
     // these will change through the decompression process
-    ab_bits  = bits + 1;
-    ab_free  = (1 << bits) + 2;
-    ab_max   = (1 << ab_bits) - 1;
-    lastcode = -1;
-    abcabca  = -1;
-    pass     = 1;
-    pos = x = y = 0;
-
-    // reset decoder vars
-    m_restbits = 0;
-    m_restbyte = 0;
-    m_lastbyte = 0;
-
-    do
+    int ab_bits  = bits + 1;                // actual symbol width, in bits
+    int ab_free  = (1 << bits) + 2;         // first free position in alphabet
+    int ab_max   = (1 << ab_bits) - 1;      // last possible code in alphabet
+    int lastcode = -1;
+
+    const unsigned char *src = static_cast<const unsigned char *>
+                                (m_lzwData.GetData()) + img->lzwOffset;
+    const unsigned char * const srcEnd = src + img->lzwSize;
+    wxUint32 bitbuf = 0;                    // bits read but not used yet
+    int nbits = 0;                          // number of bits in bitbuf
+
+    size_t pos = 0;                         // position in the output
+    while (pos < npixels)
     {
-        // get next code
-        int readcode;
-        readcode = code = getcode(stream, ab_bits, ab_fin);
+        // get next code, reaching the end of data is the same as the end of
+        // information code
+        while (nbits < ab_bits && src != srcEnd)
+        {
+            bitbuf |= static_cast<wxUint32>(*src++) << nbits;
+            nbits += 8;
+        }
+
+        if (nbits < ab_bits)
+            break;
+
+        const int code = bitbuf & ab_max;
+        bitbuf >>= ab_bits;
+        nbits -= ab_bits;
 
         // end of image?
-        if (code == ab_fin) break;
+        if (code == ab_fin)
+            break;
 
         // reset alphabet?
         if (code == ab_clr)
         {
-            // reset main variables
             ab_bits  = bits + 1;
             ab_free  = (1 << bits) + 2;
             ab_max   = (1 << ab_bits) - 1;
             lastcode = -1;
-            abcabca  = -1;
-
-            // skip to next code
             continue;
         }
 
-        // unknown code: special case (like in ABCABCA)
-        if (code >= ab_free)
+        int len;
+        int first;
+        int prefix;
+        if (code < ab_free)
         {
-            code = lastcode;            // take last string
-            stack[pos++] = abcabca;     // add first character
+            len = ab_length[code];
+            first = ab_first[code];
+            prefix = code;
         }
-
-        // build the string for this code in the stack
-        while (code > ab_clr)
+        else
         {
-            stack[pos++] = ab_tail[code];
-            code         = ab_prefix[code];
-
-            // Don't overflow. This shouldn't happen with normal
-            // GIF files, the allocSize of 4096+1 is enough. This
-            // will only happen with badly formed GIFs.
-            if (pos >= allocSize)
+            // unknown code: special case (like in ABCABCA), the string is the
+            // last one followed by its own first character
+            if (code > ab_free || lastcode == -1)
                 return wxGIF_INVFORMAT;
-        }
 
-        if (pos >= allocSize)
-            return wxGIF_INVFORMAT;
+            len = ab_length[lastcode] + 1;
+            first = ab_first[lastcode];
+            prefix = lastcode;
+            out[pos + len - 1] = (unsigned char) first;
+        }
 
-        stack[pos] = code;              // push last code into the stack
-        abcabca    = code;              // save for special case
+        // write the string for this code in the image buffer
+        unsigned char *p = out + pos + ab_length[prefix] - 1;
+        while (prefix > ab_clr)
+        {
+            *p-- = ab_tail[prefix];
+            prefix = ab_prefix[prefix];
+        }
+        *p = (unsigned char) prefix;
 
         // make new entry in alphabet (only if NOT just cleared)
         if (lastcode != -1)
@@ -452,15 +480,10 @@ wxGIFDecoder::dgif(wxInputStream& stream, GIFImage *img, int interl, int bits)
             if (ab_free > ab_max)
                 return wxGIF_INVFORMAT;
 
-            // This assert seems unnecessary since the condition above
-            // eliminates the only case in which it went false. But I really
-            // don't like being forced to ask "Who in .text could have
-            // written there?!" And I wouldn't have been forced to ask if
-            // this line had already been here.
-            wxASSERT(ab_free < allocSize);
-
-            ab_prefix[ab_free] = lastcode;
-            ab_tail[ab_free]   = code;
+            ab_prefix[ab_free] = (wxUint16) lastcode;
+            ab_tail[ab_free]   = (unsigned char) first;
+            ab_first[ab_free]  = ab_first[lastcode];
+            ab_length[ab_free] = (wxUint16) (ab_length[lastcode] + 1);
             ab_free++;
 
             if ((ab_free > ab_max) && (ab_bits < 12))
@@ -470,125 +493,40 @@ wxGIFDecoder::dgif(wxInputStream& stream, GIFImage *img, int interl, int bits)
             }
         }
 
-        // dump stack data to the image buffer
-        while (pos >= 0)
-        {
-            (img->p)[x + (y * (img->w))] = (char) stack[pos];
-            pos--;
+        pos += len;
+        lastcode = code;
+    }
 
-            if (++x >= (img->w))
-            {
-                x = 0;
+    // the pixels missing from truncated images are left with the first colour
+    if (pos < npixels)
+        memset(out + pos, 0, npixels - pos);
 
-                if (interl)
-                {
-                    // support for interlaced images
-                    switch (pass)
-                    {
-                        case 1: y += 8; break;
-                        case 2: y += 8; break;
-                        case 3: y += 4; break;
-                        case 4: y += 2; break;
-                    }
+    if (img->interlaced)
+    {
+        // the rows are stored in 4 passes, each one starting at the given
+        // row and taking every given row after it
+        static const unsigned int passStart[] = { 0, 4, 2, 1 };
+        static const unsigned int passStep[] = { 8, 8, 4, 2 };
 
-                    /* loop until a valid y coordinate has been
-                    found, Or if the maximum number of passes has
-                    been reached, exit the loop, and stop image
-                    decoding (At this point the image is successfully
-                    decoded).
-                    If we don't loop, but merely set y to some other
-                    value, that new value might still be invalid depending
-                    on the height of the image. This would cause out of
-                    bounds writing.
-                    */
-                    while (y >= (img->h))
-                    {
-                        switch (++pass)
-                        {
-                            case 2: y = 4; break;
-                            case 3: y = 2; break;
-                            case 4: y = 1; break;
-
-                            default:
-                                /*
-                                It's possible we arrive here. For example this
-                                happens when the image is interlaced, and the
-                                height is 1. Looking at the above cases, the
-                                lowest possible y is 1. While the only valid
-                                one would be 0 for an image of height 1. So
-                                'eventually' the loop will arrive here.
-                                This case makes sure this while loop is
-                                exited, as well as the 2 other ones.
-                                */
-
-                                // Set y to a valid coordinate so the local
-                                // while loop will be exited. (y = 0 always
-                                // is >= img->h since if img->h == 0 the
-                                // image is never decoded)
-                                y = 0;
-
-                                // This will exit the other outer while loop
-                                pos = -1;
-
-                                // This will halt image decoding.
-                                code = ab_fin;
+        img->p = (unsigned char *) malloc(npixels ? npixels : 1);
+        if (!img->p)
+            return wxGIF_MEMERR;
 
-                                break;
-                        }
-                    }
-                }
-                else
-                {
-                    // non-interlaced
-                    y++;
-/*
-Normally image decoding is finished when an End of Information code is
-encountered (code == ab_fin) however some broken encoders write wrong
-"block byte counts" (The first byte value after the "code size" byte),
-being one value too high. It might very well be possible other variants
-of this problem occur as well. The only sensible solution seems to
-be to check for clipping.
-Example of wrong encoding:
-(1 * 1 B/W image, raster data stream follows in hex bytes)
-
-02  << B/W images have a code size of 2
-02  << Block byte count
-44  << LZW packed
-00  << Zero byte count (terminates data stream)
-
-Because the block byte count is 2, the zero byte count is used in the
-decoding process, and decoding is continued after this byte. (While it
-should signal an end of image)
-
-It should be:
-02
-02
-44
-01  << When decoded this correctly includes the End of Information code
-00
-
-Or (Worse solution):
-02
-01
-44
-00
-(The 44 doesn't include an End of Information code, but at least the
-decoder correctly skips to 00 now after decoding, and signals this
-as an End of Information itself)
-*/
-                    if (y >= img->h)
-                    {
-                        code = ab_fin;
-                        break;
-                    }
-                }
+        const unsigned char *row = out;
+        for (int pass = 0; pass < 4; pass++)
+        {
+            for (unsigned int y = passStart[pass]; y < img->h; y += passStep[pass])
+            {
+                memcpy(img->p + y * img->w, row, img->w);
+                row += img->w;
             }
         }
-
-        pos = 0;
-        lastcode = readcode;
     }
-    while (code != ab_fin);
+    else
+    {
+        guardOut.Dismiss();
+        img->p = out;
+    }
 
     return wxGIF_OK;
 }
@@ -608,6 +546,162 @@ bool wxGIFDecoder::DoCanRead(wxInputStream &stream) const
 }
 
 
+namespace
+{
+
+// GIFImageEndFinder:
+//  Follows the LZW codes of an image to find where it ends, without decoding
+//  it, by computing only the number of pixels produced by each code. This is
+//  used to stop reading the sub-blocks of the image data when it's complete.
+//
+//  Normally the image data ends with an End of Information code followed by
+//  an empty sub-block, however some broken encoders write wrong "block byte
+//  counts" (the first byte value after the "code size" byte), being one
+//  value too high. Example of wrong encoding of an 1*1 B/W image:
+//
+//  02  << B/W images have a code size of 2
+//  02  << Block byte count
+//  44  << LZW packed
+//  00  << Zero byte count (terminates data stream)
+//
+//  Because the block byte count is 2, the zero byte count is read as part of
+//  the image data and the following bytes would be taken for the size of the
+//  next sub-block, while the image is already complete after the first one.
+class GIFImageEndFinder
+{
+public:
+    GIFImageEndFinder(int bits, size_t npixels)
+        : m_bits(bits),
+          m_npixels(npixels),
+          m_pos(0),
+          m_bitbuf(0),
+          m_nbits(0),
+          m_done(false)
+    {
+        // invalid data will be reported when decoding the image, just read
+        // all of it until then
+        m_valid = bits <= 11;
+
+        Clear();
+    }
+
+    // Process the next sub-block of data, return true if the image is
+    // complete after it.
+    bool Add(const unsigned char *data, size_t len)
+    {
+        for ( size_t n = 0; n < len && m_valid && !m_done; n++ )
+        {
+            m_bitbuf |= static_cast<wxUint32>(data[n]) << m_nbits;
+            m_nbits += 8;
+
+            while ( m_nbits >= m_ab_bits && m_valid && !m_done )
+            {
+                const int code = m_bitbuf & m_ab_max;
+                m_bitbuf >>= m_ab_bits;
+                m_nbits -= m_ab_bits;
+
+                ProcessCode(code);
+            }
+        }
+
+        return m_done;
+    }
+
+private:
+    void Clear()
+    {
+        m_ab_bits = m_bits + 1;
+        m_ab_free = (1 << m_bits) + 2;
+        m_ab_max = (1 << m_ab_bits) - 1;
+        m_lastcode = -1;
+    }
+
+    // This must be kept in sync with wxGIFDecoder::dgif().
+    void ProcessCode(int code)
+    {
+        const int ab_clr = 1 << m_bits;
+        if ( code == ab_clr + 1 )
+        {
+            m_done = true;
+            return;
+        }
+
+        if ( code == ab_clr )
+        {
+            Clear();
+            return;
+        }
+
+        unsigned len;
+        if ( code < ab_clr )
+        {
+            len = 1;
+        }
+        else if ( code < m_ab_free )
+        {
+            len = m_ab_length[code];
+        }
+        else
+        {
+            if ( code > m_ab_free || m_lastcode == -1 )
+            {
+                m_valid = false;
+                return;
+            }
+
+            len = LengthOf(m_lastcode) + 1;
+        }
+
+        if ( m_lastcode != -1 )
+        {
+            if ( m_ab_free > m_ab_max )
+            {
+                m_valid = false;
+                return;
+            }
+
+            m_ab_length[m_ab_free++] = (wxUint16) (LengthOf(m_lastcode) + 1);
+
+            if ( (m_ab_free > m_ab_max) && (m_ab_bits < 12) )
+            {
+                m_ab_bits++;
+                m_ab_max = (1 << m_ab_bits) - 1;
+            }
+        }
+
+        m_lastcode = code;
+
+        m_pos += len;
+        if ( m_npixels && m_pos >= m_npixels )
+            m_done = true;
+    }
+
+    unsigned LengthOf(int code) const
+    {
+        return code < (1 << m_bits) ? 1 : m_ab_length[code];
+    }
+
+    const int m_bits;
+    const size_t m_npixels;
+    size_t m_pos;
+
+    wxUint32 m_bitbuf;
+    int m_nbits;
+
+    int m_ab_bits;
+    int m_ab_free;
+    int m_ab_max;
+    int m_lastcode;
+    wxUint16 m_ab_length[4096];
+
+    bool m_valid;
+    bool m_done;
+
+    wxDECLARE_NO_COPY_CLASS(GIFImageEndFinder);
+};
+
+} // anonymous namespace
+
 // LoadGIF:
 //  Reads and decodes one or more GIF images, depending on whether
 //  animated GIF support is enabled. Can read GIFs with any bit
@@ -620,9 +714,8 @@ bool wxGIFDecoder::DoCanRead(wxInputStream &stream) const
 wxGIFErrorCode wxGIFDecoder::LoadGIF(wxInputStream& stream)
 {
     unsigned int  global_ncolors = 0;
-    int           bits, interl, i;
+    int           bits, i;
     wxAnimationDisposal disposal;
-    long          size;
     long          delay;
     unsigned char type = 0;
     unsigned char pal[768];
@@ -831,18 +924,17 @@ wxGIFErrorCode wxGIFDecoder::LoadGIF(wxInputStream& stream)
                     }
                 }
 
-                interl = ((buf[8] & 0x40)? 1 : 0);
-                size = pimg->w * pimg->h;
+                pimg->interlaced = (buf[8] & 0x40) != 0;
 
                 pimg->transparent = transparent;
                 pimg->disposal = disposal;
                 pimg->delay = delay;
 
-                // allocate memory for image and palette
-                pimg->p   = (unsigned char *) malloc((unsigned int)size);
+                // allocate memory for palette, the image itself is only
+                // allocated when it's decoded
                 pimg->pal = (unsigned char *) malloc(768);
 
-                if ((!pimg->p) || (!pimg->pal))
+                if (!pimg->pal)
                     return wxGIF_MEMERR;
 
                 // load local color map if available, else use global map
@@ -866,17 +958,50 @@ wxGIFErrorCode wxGIFDecoder::LoadGIF(wxInputStream& stream)
                 if (bits == 0)
                     return wxGIF_INVFORMAT;
 
-                // decode image
-                wxGIFErrorCode result = dgif(stream, pimg.get(), interl, bits);
-                if (result != wxGIF_OK)
-                    return result;
+                pimg->bits = bits;
+
+                // Keep the compressed data of the image, without the size of
+                // the sub-blocks, to decode it when it's needed. The end of
+                // data or a truncated sub-block ends the image too, as does
+                // reaching its end, even if the terminating empty sub-block
+                // hasn't been found, see GIFImageEndFinder.
+                GIFImageEndFinder endFinder(bits,
+                                            static_cast<size_t>(pimg->w) * pimg->h);
+                pimg->lzwOffset = m_lzwData.GetDataLen();
+                while ((i = stream.GetC()) > 0)
+                {
+                    const size_t len = m_lzwData.GetDataLen();
+                    if (m_lzwData.GetBufSize() < len + i)
+                        m_lzwData.SetBufSize(2 * (len + i));
+
+                    unsigned char * const
+                        block = static_cast<unsigned char *>(m_lzwData.GetAppendBuf(i));
+                    stream.Read(block, i);
+                    if (stream.LastRead() != (size_t)i)
+                        break;
 
-                guardDestroy.Dismiss();
+                    m_lzwData.UngetAppendBuf(i);
+
+                    if (endFinder.Add(block, i))
+                        break;
+                }
+                pimg->lzwSize = m_lzwData.GetDataLen() - pimg->lzwOffset;
 
                 // add the image to our frame array
                 m_frames.Add(pimg.release());
                 m_nFrames++;
 
+                // Decode the first image immediately to report any errors in
+                // it, the other ones are only decoded when needed.
+                if (m_nFrames == 1)
+                {
+                    wxGIFErrorCode result = DecodeFrame(0);
+                    if (result != wxGIF_OK)
+                        return result;
+                }
+
+                guardDestroy.Dismiss();
+
                 // if this is not an animated GIF, exit after first image
                 if (!anim)
                     done = true;
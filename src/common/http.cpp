@@ -19,6 +19,7 @@
 
 #ifndef WX_PRECOMP
     #include "wx/string.h"
+    #include "wx/crt.h"
 #endif
 
 #include "wx/tokenzr.h"
@@ -29,6 +30,24 @@
 #include "wx/sckstrm.h"
 #include "wx/thread.h"
 
+namespace
+{
+
+// size of the blocks used for reading the response headers
+const wxUint32 HTTP_READ_SIZE = 4096;
+
+// maximal size of the response headers, this is the same limit as used by
+// many other HTTP implementations
+const size_t HTTP_MAX_HEADERS_SIZE = 64*1024;
+
+// maximal size of a line in chunked encoding: they're normally very short
+const size_t HTTP_MAX_CHUNK_LINE_SIZE = 1024;
+
+// size of the blocks used for sending the data from m_postStream
+const size_t HTTP_POST_BLOCK_SIZE = 64*1024;
+
+} // anonymous namespace
+
 
 // ----------------------------------------------------------------------------
 // wxHTTP
@@ -44,12 +63,17 @@ wxHTTP::wxHTTP()
     m_read = false;
     m_proxy_mode = false;
     m_http_response = 0;
+    m_postStream = NULL;
+    m_postStreamSize = wxInvalidOffset;
+    m_keepAlive = false;
+    m_reusable = false;
 }
 
 wxHTTP::~wxHTTP()
 {
     ClearHeaders();
 
+    delete m_postStream;
     delete m_addr;
 }
 
@@ -200,12 +224,29 @@ bool
 wxHTTP::SetPostBuffer(const wxString& contentType,
                       const wxMemoryBuffer& data)
 {
+    wxDELETE(m_postStream);
+
     m_postBuffer = data;
     m_contentType = contentType;
 
     return !m_postBuffer.IsEmpty();
 }
 
+bool
+wxHTTP::SetPostStream(const wxString& contentType,
+                      wxInputStream *stream,
+                      wxFileOffset size)
+{
+    delete m_postStream;
+    m_postStream = stream;
+    m_postStreamSize = size;
+
+    m_postBuffer.Clear();
+    m_contentType = contentType;
+
+    return m_postStream && m_postStream->IsOk();
+}
+
 bool
 wxHTTP::SetPostText(const wxString& contentType,
                     const wxString& data,
@@ -223,6 +264,8 @@ wxHTTP::SetPostText(const wxString& contentType,
     if ( !len )
         return false;
 
+    wxDELETE(m_postStream);
+
     m_postBuffer.Clear();
     m_postBuffer.AppendData(buf, len);
     m_contentType = contentType;
@@ -244,20 +287,89 @@ void wxHTTP::SendHeaders()
     }
 }
 
-bool wxHTTP::ParseHeaders()
+wxUint32 wxHTTP::ReadAvailable(void *buffer, wxUint32 size)
+{
+    // Take the pushed back data first, as Read() would wait for more data
+    // after consuming it even without wxSOCKET_WAITALL_READ.
+    const wxUint32 pushback = GetPushback(buffer, size, false);
+    if ( pushback )
+        return pushback;
+
+    const wxSocketFlags flags = GetFlags();
+    SetFlags(flags & ~wxSOCKET_WAITALL_READ);
+    Read(buffer, size);
+    SetFlags(flags);
+
+    return LastReadCount();
+}
+
+bool
+wxHTTP::ReadUntil(const char *terminator, wxMemoryBuffer& buf, size_t maxSize)
 {
-    wxString line;
-    wxStringTokenizer tokenzr;
+    const size_t termLen = strlen(terminator);
+
+    buf.SetDataLen(0);
+    for ( ;; )
+    {
+        const size_t oldLen = buf.GetDataLen();
+        if ( oldLen >= maxSize )
+            return false;
+
+        void * const p = buf.GetAppendBuf(HTTP_READ_SIZE);
+        const wxUint32 count = ReadAvailable(p, HTTP_READ_SIZE);
+        buf.UngetAppendBuf(count);
+        if ( !count )
+            return false;
 
+        // The terminator could have been split between the reads, so start
+        // looking for it slightly before the new data.
+        const char * const data = static_cast<const char *>(buf.GetData());
+        const size_t len = buf.GetDataLen();
+        for ( size_t n = oldLen >= termLen ? oldLen - termLen + 1 : 0;
+              n + termLen <= len;
+              n++ )
+        {
+            if ( data[n] == *terminator &&
+                    memcmp(data + n, terminator, termLen) == 0 )
+            {
+                const size_t end = n + termLen;
+                if ( end < len )
+                    Pushback(data + end, len - end);
+
+                buf.SetDataLen(end);
+                return true;
+            }
+        }
+    }
+}
+
+bool wxHTTP::ParseHeaders()
+{
     ClearHeaders();
     ClearCookies();
     m_read = true;
 
-    for ( ;; )
+    // Although we're supposed to get 7-bit ASCII from the server, some
+    // servers are known to send 8-bit data, so decode it in any way that
+    // works, as wxProtocol::ReadLine() does.
+    const wxString
+        head(static_cast<const char *>(m_responseHead.GetData()),
+             wxWhateverWorksConv(),
+             m_responseHead.GetDataLen());
+
+    // skip the status line
+    size_t pos = head.find(wxS("\r\n"));
+    if ( pos == wxString::npos )
+        return false;
+
+    for ( pos += 2; pos < head.length(); )
     {
-        m_lastError = ReadLine(this, line);
-        if (m_lastError != wxPROTO_NOERR)
-            return false;
+        size_t eol = head.find(wxS("\r\n"), pos);
+        if ( eol == wxString::npos )
+            eol = head.length();
+
+        const wxString line = head.substr(pos, eol - pos);
+        pos = eol + 2;
 
         if ( line.empty() )
             break;
@@ -306,6 +418,8 @@ bool wxHTTP::Connect(const wxString& host, unsigned short port)
     if ( port && port != 80 )
         hostHdr << wxT(":") << port;
     SetHeader(wxT("Host"), hostHdr);
+    m_hostHeader = hostHdr;
+    m_reusable = false;
 
     m_lastError = wxPROTO_NOERR;
     return true;
@@ -328,24 +442,46 @@ bool wxHTTP::Connect(const wxSockAddress& addr, bool WXUNUSED(wait))
         if ( port && port != 80 )
             hostHdr << wxT(":") << port;
         SetHeader(wxT("Host"), hostHdr);
+        m_hostHeader = hostHdr;
     }
 
+    m_reusable = false;
+
     m_lastError = wxPROTO_NOERR;
     return true;
 }
 
 bool wxHTTP::BuildRequest(const wxString& path, const wxString& method)
 {
-    // Use the data in the post buffer, if any.
-    if ( !m_postBuffer.IsEmpty() )
+    // Chunked transfer encoding requires HTTP/1.1, as do persistent
+    // connections, but keep using HTTP/1.0 otherwise for compatibility.
+    const bool chunked = m_postStream && m_postStreamSize == wxInvalidOffset;
+    const bool http11 = m_keepAlive || chunked;
+
+    // Use the data in the post buffer or stream, if any.
+    if ( !m_postBuffer.IsEmpty() || m_postStream )
     {
-        wxString len;
-        len << m_postBuffer.GetDataLen();
+        if ( chunked )
+        {
+            SetHeader(wxS("Transfer-Encoding"), wxS("chunked"));
 
-        // Content length must be correct, so always set, possibly
-        // overriding the value set explicitly by a previous call to
-        // SetHeader("Content-Length").
-        SetHeader(wxS("Content-Length"), len);
+            wxHeaderIterator it = FindHeader(wxS("Content-Length"));
+            if ( it != m_headers.end() )
+                m_headers.erase(it);
+        }
+        else
+        {
+            wxString len;
+            if ( m_postStream )
+                len << m_postStreamSize;
+            else
+                len << m_postBuffer.GetDataLen();
+
+            // Content length must be correct, so always set, possibly
+            // overriding the value set explicitly by a previous call to
+            // SetHeader("Content-Length").
+            SetHeader(wxS("Content-Length"), len);
+        }
 
         // However if the user had explicitly set the content type, don't
         // override it with the content type passed to SetPostText().
@@ -355,6 +491,10 @@ bool wxHTTP::BuildRequest(const wxString& path, const wxString& method)
 
     m_http_response = 0;
 
+    // The headers of the previous response may have replaced the Host one.
+    if ( GetHeader(wxT("Host")).empty() && !m_hostHeader.empty() )
+        SetHeader(wxT("Host"), m_hostHeader);
+
     // If there is no User-Agent defined, define it.
     if ( GetHeader(wxT("User-Agent")).empty() )
         SetHeader(wxT("User-Agent"), wxVERSION_STRING);
@@ -364,54 +504,111 @@ bool wxHTTP::BuildRequest(const wxString& path, const wxString& method)
         SetHeader(wxT("Authorization"), GenerateAuthString(m_username, m_password));
     }
 
+    if ( http11 && GetHeader(wxT("Connection")).empty() )
+        SetHeader(wxT("Connection"), m_keepAlive ? wxT("keep-alive") : wxT("close"));
+
     wxString buf;
-    buf.Printf(wxT("%s %s HTTP/1.0\r\n"), method, path);
+    buf.Printf(wxT("%s %s HTTP/1.%d\r\n"), method, path, http11 ? 1 : 0);
     const wxWX2MBbuf pathbuf = buf.mb_str();
     Write(pathbuf, strlen(pathbuf));
     SendHeaders();
     Write("\r\n", 2);
 
-    if ( !m_postBuffer.IsEmpty() ) {
+    if ( m_postStream )
+    {
+        if ( !SendPostStream() )
+        {
+            m_lastError = wxPROTO_NETERR;
+            return false;
+        }
+    }
+    else if ( !m_postBuffer.IsEmpty() )
+    {
         Write(m_postBuffer.GetData(), m_postBuffer.GetDataLen());
-
-        m_postBuffer.Clear();
     }
 
-    wxString tmp_str;
-    m_lastError = ReadLine(this, tmp_str);
-    if (m_lastError != wxPROTO_NOERR)
-        return false;
+    // Read the status line and all the headers at once instead of reading
+    // them line by line, skipping any informational (1xx) responses.
+    for ( ;; )
+    {
+        // Check for the status line first to handle HTTP/0.9 responses.
+        static const char statusPrefix[] = "HTTP/";
+        const size_t prefixLen = strlen(statusPrefix);
 
-    if (!tmp_str.Contains(wxT("HTTP/"))) {
-        // TODO: support HTTP v0.9 which can have no header.
-        // FIXME: tmp_str is not put back in the in-queue of the socket.
-        m_lastError = wxPROTO_NOERR;
-        SetHeader(wxT("Content-Length"), wxT("-1"));
-        SetHeader(wxT("Content-Type"), wxT("none/none"));
-        RestoreState();
-        return true;
-    }
+        char prefix[sizeof(statusPrefix)];
+        size_t prefixRead = 0;
+        while ( prefixRead < prefixLen )
+        {
+            const wxUint32 count = ReadAvailable(prefix + prefixRead,
+                                                 prefixLen - prefixRead);
+            if ( !count )
+                break;
 
-    wxStringTokenizer token(tmp_str,wxT(' '));
-    wxString tmp_str2;
-    bool ret_value;
+            prefixRead += count;
+        }
 
-    token.NextToken();
-    tmp_str2 = token.NextToken();
+        if ( !prefixRead )
+        {
+            m_lastError = wxPROTO_NETERR;
+            return false;
+        }
 
-    m_http_response = wxAtoi(tmp_str2);
+        Pushback(prefix, prefixRead);
 
-    switch ( tmp_str2[0u].GetValue() )
-    {
-        case wxT('1'):
-            /* INFORMATION / SUCCESS */
+        if ( prefixRead < prefixLen ||
+                memcmp(prefix, statusPrefix, prefixLen) != 0 )
+        {
+            // TODO: support HTTP v0.9 which can have no header.
+            m_lastError = wxPROTO_NOERR;
+            SetHeader(wxT("Content-Length"), wxT("-1"));
+            SetHeader(wxT("Content-Type"), wxT("none/none"));
+            m_reusable = false;
+            RestoreState();
+            return true;
+        }
+
+        if ( !ReadUntil("\r\n\r\n", m_responseHead, HTTP_MAX_HEADERS_SIZE) )
+        {
+            m_lastError = wxPROTO_NETERR;
+            return false;
+        }
+
+        // Skip "HTTP/1.x " to get the status code.
+        const char * const head = static_cast<const char *>(m_responseHead.GetData());
+        const char *status = head + prefixLen;
+        while ( *status != ' ' && *status != '\r' )
+            status++;
+
+        m_http_response = atoi(status);
+        if ( m_http_response < 100 || m_http_response >= 200 )
+        {
+            // Determine whether the server allows keeping the connection
+            // open: the final decision is taken in GetInputStream() as it
+            // also depends on whether we know the response length.
+            m_reusable = m_keepAlive && strncmp(head, "HTTP/1.0", 8) != 0;
             break;
+        }
+    }
+
+    if ( !ParseHeaders() )
+    {
+        m_lastError = wxPROTO_NETERR;
+        return false;
+    }
 
-        case wxT('2'):
+    const wxString connection = GetHeader(wxT("Connection"));
+    if ( connection.CmpNoCase(wxT("close")) == 0 )
+        m_reusable = false;
+    else if ( connection.CmpNoCase(wxT("keep-alive")) == 0 && m_keepAlive )
+        m_reusable = true;
+
+    switch ( m_http_response / 100 )
+    {
+        case 2:
             /* SUCCESS */
             break;
 
-        case wxT('3'):
+        case 3:
             /* REDIRECTION */
             break;
 
@@ -422,16 +619,90 @@ bool wxHTTP::BuildRequest(const wxString& path, const wxString& method)
     }
 
     m_lastError = wxPROTO_NOERR;
-    ret_value = ParseHeaders();
+    return true;
+}
+
+bool wxHTTP::SendPostStream()
+{
+    const bool chunked = m_postStreamSize == wxInvalidOffset;
+    wxFileOffset left = m_postStreamSize;
+
+    wxCharBuffer buf(HTTP_POST_BLOCK_SIZE);
+    for ( ;; )
+    {
+        size_t size = HTTP_POST_BLOCK_SIZE;
+        if ( !chunked )
+        {
+            if ( !left )
+                break;
+
+            if ( left < static_cast<wxFileOffset>(size) )
+                size = static_cast<size_t>(left);
+        }
+
+        const size_t count = m_postStream->Read(buf.data(), size).LastRead();
+        if ( !count )
+        {
+            // The stream must provide as much data as it was specified when
+            // setting it and, even in chunked mode, a read error is fatal.
+            if ( !chunked || !m_postStream->Eof() )
+                return false;
 
-    return ret_value;
+            Write("0\r\n\r\n", 5);
+            break;
+        }
+
+        if ( chunked )
+        {
+            char header[32];
+            const int headerLen = wxSnprintf(header, sizeof(header),
+                                             "%lx\r\n",
+                                             static_cast<unsigned long>(count));
+
+            const wxSocketBuffer buffers[] =
+            {
+                wxSocketBuffer(header, headerLen),
+                wxSocketBuffer(buf.data(), count),
+                wxSocketBuffer("\r\n", 2),
+            };
+
+            WriteV(buffers, WXSIZEOF(buffers));
+        }
+        else
+        {
+            Write(buf.data(), count);
+            left -= count;
+        }
+
+        if ( Error() )
+            return false;
+    }
+
+    return !Error();
 }
 
 bool wxHTTP::Abort()
 {
+    // Discard any data read from this connection but not consumed yet, as it
+    // would be taken to be the start of the response on the next connection.
+    char buf[HTTP_READ_SIZE];
+    while ( GetPushback(buf, sizeof(buf), false) )
+        ;
+
     return wxSocketClient::Close();
 }
 
+void wxHTTP::OnStreamDone(bool complete)
+{
+    // Keep the connection open only if the entire response was read, as
+    // otherwise we'd have to read and discard the rest of it first.
+    if ( complete && m_reusable && IsConnected() )
+        return;
+
+    m_reusable = false;
+    Abort();
+}
+
 // ----------------------------------------------------------------------------
 // wxHTTPStream and wxHTTP::GetInputStream
 // ----------------------------------------------------------------------------
@@ -443,40 +714,141 @@ public:
     size_t m_httpsize;
     unsigned long m_read_bytes;
 
-    wxHTTPStream(wxHTTP *http) : wxSocketInputStream(*http)
+    wxHTTPStream(wxHTTP *http, bool chunked)
+        : wxSocketInputStream(*http),
+          m_chunked(chunked)
     {
         m_http = http;
         m_httpsize = 0;
         m_read_bytes = 0;
+        m_chunkLeft = 0;
+        m_done = false;
     }
 
     size_t GetSize() const wxOVERRIDE { return m_httpsize; }
-    virtual ~wxHTTPStream() { m_http->Abort(); }
+    virtual ~wxHTTPStream() { m_http->OnStreamDone(IsDone()); }
 
 protected:
     size_t OnSysRead(void *buffer, size_t bufsize) wxOVERRIDE;
 
+private:
+    // return true if the entire response body has been read
+    bool IsDone() const
+    {
+        return m_done ||
+                (!m_chunked && m_httpsize != (size_t)-1 &&
+                    m_read_bytes >= m_httpsize);
+    }
+
+    // read the size of the next chunk into m_chunkLeft
+    bool ReadChunkSize();
+
+    const bool m_chunked;
+
+    // the number of bytes remaining in the current chunk
+    size_t m_chunkLeft;
+
+    // true once the last chunk has been read
+    bool m_done;
+
     wxDECLARE_NO_COPY_CLASS(wxHTTPStream);
 };
 
+bool wxHTTPStream::ReadChunkSize()
+{
+    wxMemoryBuffer line;
+
+    // The data of every chunk is followed by CRLF, notice that only the last
+    // chunk can be empty, so we're at the start of the body if nothing was
+    // read yet.
+    if ( m_read_bytes )
+    {
+        if ( !m_http->ReadUntil("\r\n", line, HTTP_MAX_CHUNK_LINE_SIZE) ||
+                line.GetDataLen() != 2 )
+            return false;
+    }
+
+    if ( !m_http->ReadUntil("\r\n", line, HTTP_MAX_CHUNK_LINE_SIZE) )
+        return false;
+
+    // The size may be followed by the chunk extensions which we ignore.
+    line.AppendByte('\0');
+    const char * const start = static_cast<const char *>(line.GetData());
+    char *end;
+    const unsigned long size = strtoul(start, &end, 16);
+    if ( end == start )
+        return false;
+
+    m_chunkLeft = size;
+
+    if ( !size )
+    {
+        // Skip the trailer headers, if any, until the final empty line.
+        do
+        {
+            if ( !m_http->ReadUntil("\r\n", line, HTTP_MAX_HEADERS_SIZE) )
+                return false;
+        }
+        while ( line.GetDataLen() != 2 );
+    }
+
+    return true;
+}
+
 size_t wxHTTPStream::OnSysRead(void *buffer, size_t bufsize)
 {
-    if (m_read_bytes >= m_httpsize)
+    if ( IsDone() )
     {
         m_lasterror = wxSTREAM_EOF;
         return 0;
     }
 
+    if ( m_chunked )
+    {
+        if ( !m_chunkLeft )
+        {
+            if ( !ReadChunkSize() )
+            {
+                m_lasterror = wxSTREAM_READ_ERROR;
+                return 0;
+            }
+
+            if ( !m_chunkLeft )
+            {
+                m_done = true;
+                m_lasterror = wxSTREAM_EOF;
+                return 0;
+            }
+        }
+
+        if ( bufsize > m_chunkLeft )
+            bufsize = m_chunkLeft;
+    }
+    else if ( m_httpsize != (size_t)-1 )
+    {
+        // Don't read beyond the end of the response as the connection may
+        // be reused for the next one.
+        if ( bufsize > m_httpsize - m_read_bytes )
+            bufsize = m_httpsize - m_read_bytes;
+    }
+
     size_t ret = wxSocketInputStream::OnSysRead(buffer, bufsize);
     m_read_bytes += ret;
 
-    if (m_httpsize==(size_t)-1 && m_lasterror == wxSTREAM_READ_ERROR )
+    if ( m_chunked )
     {
-        // if m_httpsize is (size_t) -1 this means read until connection closed
-        // which is equivalent to getting a READ_ERROR, for clients however this
-        // must be translated into EOF, as it is the expected way of signalling
-        // end end of the content
-        m_lasterror = wxSTREAM_EOF;
+        m_chunkLeft -= ret;
+    }
+    else if ( m_httpsize==(size_t)-1 )
+    {
+        if ( m_lasterror == wxSTREAM_READ_ERROR )
+        {
+            // if m_httpsize is (size_t) -1 this means read until connection
+            // closed which is equivalent to getting a READ_ERROR, for clients
+            // however this must be translated into EOF, as it is the expected
+            // way of signalling end end of the content
+            m_lasterror = wxSTREAM_EOF;
+        }
     }
 
     return ret;
@@ -492,34 +864,85 @@ wxInputStream *wxHTTP::GetInputStream(const wxString& path)
     if (!m_addr)
         return NULL;
 
-    // We set m_connected back to false so wxSocketBase will know what to do.
-#ifdef __WXMAC__
-    wxSocketClient::Connect(*m_addr , false );
-    wxSocketClient::WaitOnConnect(10);
-
-    if (!wxSocketClient::IsConnected())
-        return NULL;
-#else
-    if (!wxProtocol::Connect(*m_addr))
-        return NULL;
-#endif
+    // Don't send the headers of the previous response with this request.
+    if ( m_read )
+    {
+        ClearHeaders();
+        m_read = false;
+    }
 
     // Use the user-specified method if any or determine the method to use
     // automatically depending on whether we have anything to post or not.
     wxString method = m_method;
     if (method.empty())
-        method = m_postBuffer.IsEmpty() ? wxS("GET"): wxS("POST");
+        method = m_postBuffer.IsEmpty() && !m_postStream ? wxS("GET"): wxS("POST");
 
-    if (!BuildRequest(path, method))
-        return NULL;
+    // Reuse the connection kept open after the previous request if possible,
+    // but only if the server hasn't closed it in the meanwhile, which would
+    // make it readable.
+    bool reused = m_reusable && IsConnected() && !WaitForRead(0, 0);
+    m_reusable = false;
+
+    // If the server closes the reused connection just before getting our
+    // request, try sending the request again, if we still can.
+    for ( ;; )
+    {
+        if ( !reused )
+        {
+            if ( IsConnected() )
+                Abort();
+
+            // We set m_connected back to false so wxSocketBase will know what to do.
+#ifdef __WXMAC__
+            wxSocketClient::Connect(*m_addr , false );
+            wxSocketClient::WaitOnConnect(10);
+
+            if (!wxSocketClient::IsConnected())
+                return NULL;
+#else
+            if (!wxProtocol::Connect(*m_addr))
+                return NULL;
+#endif
+        }
+
+        if ( BuildRequest(path, method) )
+            break;
+
+        // The body of an error response is never read, so the connection
+        // can't be used any more in any case.
+        m_reusable = false;
+
+        if ( !reused || m_http_response || m_lastError != wxPROTO_NETERR ||
+                m_postStream )
+        {
+            m_postBuffer.Clear();
+            wxDELETE(m_postStream);
+            return NULL;
+        }
+
+        reused = false;
+    }
+
+    m_postBuffer.Clear();
+    wxDELETE(m_postStream);
 
-    inp_stream = new wxHTTPStream(this);
+    const bool chunked = GetHeader(wxT("Transfer-Encoding")).Lower().Contains(wxT("chunked"));
+    inp_stream = new wxHTTPStream(this, chunked);
 
-    if (!GetHeader(wxT("Content-Length")).empty())
+    if ( chunked )
+        inp_stream->m_httpsize = (size_t)-1;
+    else if (!GetHeader(wxT("Content-Length")).empty())
         inp_stream->m_httpsize = wxAtoi(GetHeader(wxT("Content-Length")));
+    else if ( method == wxS("HEAD") ||
+                m_http_response == 204 || m_http_response == 304 )
+        inp_stream->m_httpsize = 0;
     else
         inp_stream->m_httpsize = (size_t)-1;
 
+    // The connection can't be reused if its end is the end of the response.
+    if ( inp_stream->m_httpsize == (size_t)-1 && !chunked )
+        m_reusable = false;
+
     inp_stream->m_read_bytes = 0;
 
     // no error; reset m_lastError
@@ -527,4 +950,75 @@ wxInputStream *wxHTTP::GetInputStream(const wxString& path)
     return inp_stream;
 }
 
+// ----------------------------------------------------------------------------
+// wxHTTPConnectionPool
+// ----------------------------------------------------------------------------
+
+wxHTTPConnectionPool::wxHTTPConnectionPool(const wxString& host,
+                                           unsigned short port,
+                                           size_t maxIdle)
+    : m_host(host),
+      m_port(port),
+      m_maxIdle(maxIdle)
+{
+}
+
+wxHTTPConnectionPool::~wxHTTPConnectionPool()
+{
+    for ( size_t n = 0; n < m_idle.size(); n++ )
+        delete m_idle[n];
+}
+
+wxHTTP *wxHTTPConnectionPool::Acquire()
+{
+    {
+        wxCRIT_SECT_LOCKER(lock, m_cs);
+
+        if ( !m_idle.empty() )
+        {
+            wxHTTP * const http = m_idle.back();
+            m_idle.pop_back();
+            return http;
+        }
+    }
+
+    wxHTTP * const http = new wxHTTP;
+    http->SetKeepAlive();
+    if ( !http->Connect(m_host, m_port) )
+    {
+        delete http;
+        return NULL;
+    }
+
+    return http;
+}
+
+void wxHTTPConnectionPool::Release(wxHTTP *http)
+{
+    wxCHECK_RET( http, "NULL connection" );
+
+    // Reset the request parameters which are not reset automatically.
+    http->SetMethod(wxString());
+
+    if ( http->IsConnected() )
+    {
+        wxCRIT_SECT_LOCKER(lock, m_cs);
+
+        if ( m_idle.size() < m_maxIdle )
+        {
+            m_idle.push_back(http);
+            return;
+        }
+    }
+
+    delete http;
+}
+
+size_t wxHTTPConnectionPool::GetIdleCount() const
+{
+    wxCRIT_SECT_LOCKER(lock, m_cs);
+
+    return m_idle.size();
+}
+
 #endif // wxUSE_PROTOCOL_HTTP
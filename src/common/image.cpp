@@ -27,10 +27,30 @@
 
 #include "wx/wfstream.h"
 #include "wx/xpmdecod.h"
+#include "wx/scopedarray.h"
+#include "wx/sharedptr.h"
+#include "wx/private/image.h"
+#include "wx/private/threadpool.h"
 
 // For memcpy
 #include <string.h>
 
+// SSE2 is always available when targeting x86-64, use it for the image
+// processing functions if possible.
+#if defined(__SSE2__) || defined(_M_X64) || \
+        (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define wxIMAGE_USE_SSE2
+    #include <emmintrin.h>
+
+    // AVX2 versions of some functions are also compiled and selected during
+    // run-time if the CPU supports them, this requires gcc or clang.
+    #if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+            (defined(__clang__) || wxCHECK_GCC_VERSION(4, 9))
+        #define wxIMAGE_USE_AVX2
+        #include <immintrin.h>
+    #endif
+#endif
+
 // make the code compile with either wxFile*Stream or wxFFile*Stream:
 #define HAS_FILE_STREAMS (wxUSE_STREAMS && (wxUSE_FILE || wxUSE_FFILE))
 
@@ -84,6 +104,11 @@ public:
     // same as m_static but for m_alpha
     bool            m_staticAlpha;
 
+    // the format of the pixel data: if it's not wxIMAGE_PIXEL_FORMAT_RGB, the
+    // pixels are stored in m_pixels while m_data and m_alpha are both NULL
+    wxImagePixelFormat m_pixelFormat;
+    unsigned char  *m_pixels;
+
     // global and per-object flags determining LoadFile() behaviour
     int             m_loadFlags;
     static int      sm_defaultLoadFlags;
@@ -118,6 +143,9 @@ wxImageRefData::wxImageRefData()
     m_static =
     m_staticAlpha = false;
 
+    m_pixelFormat = wxIMAGE_PIXEL_FORMAT_RGB;
+    m_pixels = NULL;
+
     m_loadFlags = sm_defaultLoadFlags;
 }
 
@@ -127,6 +155,7 @@ wxImageRefData::~wxImageRefData()
         free( m_data );
     if ( !m_staticAlpha )
         free( m_alpha );
+    free( m_pixels );
 }
 
 
@@ -134,7 +163,31 @@ wxImageRefData::~wxImageRefData()
 // wxImage
 //-----------------------------------------------------------------------------
 
-#define M_IMGDATA static_cast<wxImageRefData*>(m_refData)
+// This gives access to the image data in RGB format, converting it to this
+// format first if necessary.
+#define M_IMGDATA (EnsureRGBFormat(), static_cast<wxImageRefData*>(m_refData))
+
+// This can be used to access the fields not depending on the pixel format
+// only, such as the image size or mask colour, without any conversions.
+#define M_IMGDATA_ANY static_cast<wxImageRefData*>(m_refData)
+
+static bool ConvertImagePixelFormat(wxImageRefData *refData,
+                                    wxImagePixelFormat format,
+                                    wxImageRefData *refDataNew);
+
+inline void wxImage::EnsureRGBFormat() const
+{
+    if ( m_refData &&
+            M_IMGDATA_ANY->m_pixelFormat != wxIMAGE_PIXEL_FORMAT_RGB )
+    {
+        // Convert the data in place even if it's shared with other images:
+        // this changes only the representation of the pixels and not their
+        // values, so it's fine to do it in a const function, unlike unsharing
+        // the data which would modify this object.
+        ConvertImagePixelFormat(M_IMGDATA_ANY, wxIMAGE_PIXEL_FORMAT_RGB,
+                                M_IMGDATA_ANY);
+    }
+}
 
 wxIMPLEMENT_DYNAMIC_CLASS(wxImage, wxObject);
 
@@ -223,6 +276,24 @@ void wxImage::Clear(unsigned char value)
     memset(M_IMGDATA->m_data, value, M_IMGDATA->m_width*M_IMGDATA->m_height*3);
 }
 
+// copy everything but the pixel data from one image data object to another one
+static void
+CopyImageProperties(wxImageRefData* refData_new, const wxImageRefData* refData)
+{
+    refData_new->m_width = refData->m_width;
+    refData_new->m_height = refData->m_height;
+    refData_new->m_maskRed = refData->m_maskRed;
+    refData_new->m_maskGreen = refData->m_maskGreen;
+    refData_new->m_maskBlue = refData->m_maskBlue;
+    refData_new->m_hasMask = refData->m_hasMask;
+    refData_new->m_ok = true;
+#if wxUSE_PALETTE
+    refData_new->m_palette = refData->m_palette;
+#endif
+    refData_new->m_optionNames = refData->m_optionNames;
+    refData_new->m_optionValues = refData->m_optionValues;
+}
+
 wxObjectRefData* wxImage::CreateRefData() const
 {
     return new wxImageRefData;
@@ -234,14 +305,16 @@ wxObjectRefData* wxImage::CloneRefData(const wxObjectRefData* that) const
     wxCHECK_MSG(refData->m_ok, NULL, wxT("invalid image") );
 
     wxImageRefData* refData_new = new wxImageRefData;
-    refData_new->m_width = refData->m_width;
-    refData_new->m_height = refData->m_height;
-    refData_new->m_maskRed = refData->m_maskRed;
-    refData_new->m_maskGreen = refData->m_maskGreen;
-    refData_new->m_maskBlue = refData->m_maskBlue;
-    refData_new->m_hasMask = refData->m_hasMask;
-    refData_new->m_ok = true;
+    CopyImageProperties(refData_new, refData);
     unsigned size = unsigned(refData->m_width) * unsigned(refData->m_height);
+    if (refData->m_pixelFormat != wxIMAGE_PIXEL_FORMAT_RGB)
+    {
+        size *= 4;
+        refData_new->m_pixelFormat = refData->m_pixelFormat;
+        refData_new->m_pixels = (unsigned char*)malloc(size);
+        memcpy(refData_new->m_pixels, refData->m_pixels, size);
+        return refData_new;
+    }
     if (refData->m_alpha != NULL)
     {
         refData_new->m_alpha = (unsigned char*)malloc(size);
@@ -250,11 +323,6 @@ wxObjectRefData* wxImage::CloneRefData(const wxObjectRefData* that) const
     size *= 3;
     refData_new->m_data = (unsigned char*)malloc(size);
     memcpy(refData_new->m_data, refData->m_data, size);
-#if wxUSE_PALETTE
-    refData_new->m_palette = refData->m_palette;
-#endif
-    refData_new->m_optionNames = refData->m_optionNames;
-    refData_new->m_optionValues = refData->m_optionValues;
     return refData_new;
 }
 
@@ -560,370 +628,1045 @@ wxImage wxImage::ResampleNearest(int width, int height) const
     return image;
 }
 
-namespace
-{
+// ----------------------------------------------------------------------------
+// Separable resampling implementation
+// ----------------------------------------------------------------------------
 
-struct BoxPrecalc
-{
-    int boxStart;
-    int boxEnd;
-};
+// All the resampling algorithms below are separable, i.e. each destination
+// pixel is computed by filtering the source rows horizontally first and then
+// filtering the results of this pass vertically. Both passes use the tables of
+// the source pixels and their weights precomputed for each destination column
+// or row by the functions defining the algorithms.
+//
+// The vertical pass only keeps as many horizontally filtered rows as are used
+// by a single destination row, so that the memory used doesn't depend on the
+// size of the source image. For big images, the destination rows are divided
+// into bands processed in parallel.
 
-void ResampleBoxPrecalc(wxVector<BoxPrecalc>& boxes, int oldDim)
+namespace
 {
-    const int newDim = boxes.size();
-    wxASSERT( oldDim > 0 && newDim > 0 );
 
-    // We need to map pixel values in the range [-0.5 .. (newDim-1)+0.5]
-    // to the pixel values in the range [-0.5 .. (oldDim-1)+0.5].
-    // Transformation function is therefore:
-    //   pOld = sc * (pNew + 0.5) - 0.5, where sc = oldDim/newDim
-    //
-    // A new pixel pNew in the interval [pNew-0.5 .. pNew+0.5]
-    // is mapped to the old pixel in the interval [pOldLoBound..pOldUpBound],
-    // where:
-    //   pOldLoBound = sc * ((pNew-0.5) + 0.5) - 0.5 = sc * pNew - 0.5
-    //   pOldUpBound = sc * ((pNew+0.5) + 0.5) - 0.5 = sc * (pNew+1) - 0.5
-    // So, the lower bound of the pixel box (interval) is:
-    //   boxStart = round(pOldLoBound) = trunc((sc * pNew - 0.5) + 0.5) = trunc(sc * pNew)
-    // and the upper bound is:
-    // - if fraction(pOldUpBound) != 0.5 (bound inside the pixel):
-    //   boxEnd = round(pixOldUpBound) = trunc((sc * (pNew+1) - 0.5) + 0.5) = trunc(sc * (pNew+1))
-    //    e.g. for UpBound = 7.2 -> boxEnd = 7
-    //         for UpBound = 7.6 -> boxEnd = 8
-    // - if fraction(pOldUpBound) == 0.5 (bound at the edge of the pixel):
-    //   boxEnd = round(pOldUpBound)-1 = trunc((sc * (pNew+1) - 0.5) + 0.5) - 1 = trunc(sc * (pNew+1))-1
-    //    e.g. for UpBound = 7.5 -> boxEnd = 7 (not 8)
-    //
-    // In integer arithmetic:
-    //  boxStart = (oldDim * pNew) / newDim
-    //  boxEnd:
-    //   vEnd =  oldDim * (pNew+1) = oldDim * pNew + oldDim
-    //  if vEnd % newDim != 0 (frac(pOldUpBound) != 0.5) => boxEnd = vEnd / newDim
-    //  if vEnd % newDim == 0 (frac(pOldUpBound) == 0.5) => boxEnd = (vEnd / newDim) - 1
+// Maximal number of threads to use, 0 means to use all CPUs.
+int gs_imageMaxThreads = 0;
 
-    int v = 0; // oldDim * 0
-    for ( int dst = 0; dst < newDim; dst++ )
-    {
-        BoxPrecalc& precalc = boxes[dst];
-        precalc.boxStart = v/newDim;
-        v += oldDim;
-        precalc.boxEnd = v%newDim != 0 ? v/newDim : (v/newDim)-1;
-    }
-}
+// Use multiple threads only if the image has at least this many pixels, as
+// the overhead of creating them is not worth it for small images.
+const size_t wxIMAGE_MIN_PIXELS_PER_THREAD = 128*1024;
 
-} // anonymous namespace
+#ifdef wxIMAGE_USE_AVX2
 
-wxImage wxImage::ResampleBox(int width, int height) const
+inline bool CPUHasAVX2()
 {
-    // This function implements a simple pre-blur/box averaging method for
-    // downsampling that gives reasonably smooth results To scale the image
-    // down we will need to gather a grid of pixels of the size of the scale
-    // factor in each direction and then do an averaging of the pixels.
-
-    wxImage ret_image(width, height, false);
-
-    wxVector<BoxPrecalc> vPrecalcs(height);
-    wxVector<BoxPrecalc> hPrecalcs(width);
-
-    ResampleBoxPrecalc(vPrecalcs, M_IMGDATA->m_height);
-    ResampleBoxPrecalc(hPrecalcs, M_IMGDATA->m_width);
+#ifdef __AVX2__
+    return true;
+#else
+    static const bool s_hasAVX2 = __builtin_cpu_supports("avx2") != 0;
+    return s_hasAVX2;
+#endif
+}
 
+#endif // wxIMAGE_USE_AVX2
 
-    const unsigned char* src_data = M_IMGDATA->m_data;
-    const unsigned char* src_alpha = M_IMGDATA->m_alpha;
-    unsigned char* dst_data = ret_image.GetData();
-    unsigned char* dst_alpha = NULL;
+#if wxUSE_THREADS
 
-    if ( src_alpha )
+class wxImageRowsTask : public wxThreadPoolTask
+{
+public:
+    wxImageRowsTask(wxImageRowsFunc func, const void *data, int y0, int y1)
+        : m_func(func), m_data(data), m_y0(y0), m_y1(y1)
     {
-        ret_image.SetAlpha();
-        dst_alpha = ret_image.GetAlpha();
     }
 
-    int averaged_pixels, src_pixel_index;
-    double sum_r, sum_g, sum_b, sum_a;
-
-    for ( int y = 0; y < height; y++ )         // Destination image - Y direction
+protected:
+    virtual void Run() wxOVERRIDE
     {
-        // Source pixel in the Y direction
-        const BoxPrecalc& vPrecalc = vPrecalcs[y];
-
-        for ( int x = 0; x < width; x++ )      // Destination image - X direction
-        {
-            // Source pixel in the X direction
-            const BoxPrecalc& hPrecalc = hPrecalcs[x];
-
-            // Box of pixels to average
-            averaged_pixels = 0;
-            sum_r = sum_g = sum_b = sum_a = 0.0;
+        (*m_func)(m_data, m_y0, m_y1);
+    }
 
-            for ( int j = vPrecalc.boxStart; j <= vPrecalc.boxEnd; ++j )
-            {
-                for ( int i = hPrecalc.boxStart; i <= hPrecalc.boxEnd; ++i )
-                {
-                    // Calculate the actual index in our source pixels
-                    src_pixel_index = j * M_IMGDATA->m_width + i;
+private:
+    const wxImageRowsFunc m_func;
+    const void * const m_data;
+    const int m_y0,
+              m_y1;
+};
 
-                    if (src_alpha)
-                    {
-                        sum_r += src_data[src_pixel_index * 3 + 0] * src_alpha[src_pixel_index];
-                        sum_g += src_data[src_pixel_index * 3 + 1] * src_alpha[src_pixel_index];
-                        sum_b += src_data[src_pixel_index * 3 + 2] * src_alpha[src_pixel_index];
-                        sum_a += src_alpha[src_pixel_index];
-                    }
-                    else
-                    {
-                        sum_r += src_data[src_pixel_index * 3 + 0];
-                        sum_g += src_data[src_pixel_index * 3 + 1];
-                        sum_b += src_data[src_pixel_index * 3 + 2];
-                    }
+// Pool used by wxProcessImageRows(), created when it's needed for the first
+// time and kept until the library cleanup to avoid creating new threads for
+// every image processed.
+wxCriticalSection gs_csImagePool;
+wxSharedPtr<wxThreadPool> gs_imagePool;
+int gs_imagePoolSize = 0;
 
-                    averaged_pixels++;
-                }
-            }
+// Return the pool with at least the given number of threads.
+wxSharedPtr<wxThreadPool> GetImageThreadPool(int threads)
+{
+    wxCriticalSectionLocker lock(gs_csImagePool);
 
-            // Calculate the average from the sum and number of averaged pixels
-            if (src_alpha)
-            {
-                if (sum_a)
-                {
-                    dst_data[0] = (unsigned char)(sum_r / sum_a);
-                    dst_data[1] = (unsigned char)(sum_g / sum_a);
-                    dst_data[2] = (unsigned char)(sum_b / sum_a);
-                }
-                else
-                {
-                    dst_data[0] = 0;
-                    dst_data[1] = 0;
-                    dst_data[2] = 0;
-                }
-                *dst_alpha++ = (unsigned char)(sum_a / averaged_pixels);
-            }
-            else
-            {
-                dst_data[0] = (unsigned char)(sum_r / averaged_pixels);
-                dst_data[1] = (unsigned char)(sum_g / averaged_pixels);
-                dst_data[2] = (unsigned char)(sum_b / averaged_pixels);
-            }
-            dst_data += 3;
-        }
+    // If the existing pool is too small, replace it with a bigger one: the
+    // old pool is destroyed when it's not used by any other thread any more.
+    if ( threads > gs_imagePoolSize )
+    {
+        gs_imagePool = wxSharedPtr<wxThreadPool>(new wxThreadPool(threads));
+        gs_imagePoolSize = threads;
     }
 
-    return ret_image;
+    return gs_imagePool;
 }
 
-namespace
+void DestroyImageThreadPool()
 {
+    wxCriticalSectionLocker lock(gs_csImagePool);
 
-struct BilinearPrecalc
-{
-    int offset1;
-    int offset2;
-    double dd;
-    double dd1;
-};
+    gs_imagePool.reset();
+    gs_imagePoolSize = 0;
+}
+
+#endif // wxUSE_THREADS
+
+} // anonymous namespace
 
-inline void DoCalc(BilinearPrecalc& precalc, double srcpix, int srcpixmax)
+int wxGetImageRowsThreads(int height, size_t pixels)
 {
-    int srcpix1 = int(srcpix);
-    int srcpix2 = srcpix1 == srcpixmax ? srcpix1 : srcpix1 + 1;
+#if wxUSE_THREADS
+    int threads = gs_imageMaxThreads > 0
+                    ? gs_imageMaxThreads
+                    : wxThreadPool::GetDefaultThreadCount();
+    if ( static_cast<size_t>(threads) > pixels / wxIMAGE_MIN_PIXELS_PER_THREAD )
+        threads = static_cast<int>(pixels / wxIMAGE_MIN_PIXELS_PER_THREAD);
+    if ( threads > height )
+        threads = height;
 
-    precalc.dd = srcpix - (int)srcpix;
-    precalc.dd1 = 1.0 - precalc.dd;
-    precalc.offset1 = srcpix1 < 0.0
-                        ? 0
-                        : srcpix1 > srcpixmax
-                            ? srcpixmax
-                            : (int)srcpix1;
-    precalc.offset2 = srcpix2 < 0.0
-                        ? 0
-                        : srcpix2 > srcpixmax
-                            ? srcpixmax
-                            : (int)srcpix2;
+    return threads > 1 ? threads : 1;
+#else // !wxUSE_THREADS
+    wxUnusedVar(height);
+    wxUnusedVar(pixels);
+
+    return 1;
+#endif // wxUSE_THREADS/!wxUSE_THREADS
 }
 
-void ResampleBilinearPrecalc(wxVector<BilinearPrecalc>& precalcs, int oldDim)
+void wxProcessImageRows(wxImageRowsFunc func, const void *data,
+                        int height, size_t pixels)
 {
-    const int newDim = precalcs.size();
-    wxASSERT( oldDim > 0 && newDim > 0 );
-    const int srcpixmax = oldDim - 1;
-    if ( newDim > 1 )
+#if wxUSE_THREADS
+    const int threads = wxGetImageRowsThreads(height, pixels);
+    if ( threads > 1 )
     {
-        // We want to map pixels in the range [0..newDim-1]
-        // to the range [0..oldDim-1]
-        const double scale_factor = double(oldDim-1) / (newDim-1);
+        // The current thread processes the last band itself.
+        const wxSharedPtr<wxThreadPool> pool = GetImageThreadPool(threads - 1);
 
-        for ( int dsty = 0; dsty < newDim; dsty++ )
+        wxVector<wxImageRowsTask *> tasks;
+        int y0 = 0;
+        for ( int n = 0; n < threads - 1; n++ )
         {
-            // We need to calculate the source pixel to interpolate from - Y-axis
-            double srcpix = (double)dsty * scale_factor;
+            const int y1 = static_cast<int>((wxLongLong_t)height*(n + 1)/threads);
+            tasks.push_back(new wxImageRowsTask(func, data, y0, y1));
+            pool->Submit(tasks.back());
+            y0 = y1;
+        }
+
+        (*func)(data, y0, height);
 
-            DoCalc(precalcs[dsty], srcpix, srcpixmax);
+        for ( size_t n = 0; n < tasks.size(); n++ )
+        {
+            tasks[n]->Wait();
+            delete tasks[n];
         }
-    }
-    else
-    {
-        // Let's take the pixel from the center of the source image.
-        double srcpix = (double)srcpixmax / 2.0;
 
-        DoCalc(precalcs[0], srcpix, srcpixmax);
+        return;
     }
-}
+#else // !wxUSE_THREADS
+    wxUnusedVar(pixels);
+#endif // wxUSE_THREADS/!wxUSE_THREADS
 
-} // anonymous namespace
+    (*func)(data, 0, height);
+}
 
-wxImage wxImage::ResampleBilinear(int width, int height) const
+namespace
 {
-    // This function implements a Bilinear algorithm for resampling.
-    wxImage ret_image(width, height, false);
-    const unsigned char* src_data = M_IMGDATA->m_data;
-    const unsigned char* src_alpha = M_IMGDATA->m_alpha;
-    unsigned char* dst_data = ret_image.GetData();
-    unsigned char* dst_alpha = NULL;
 
-    if ( src_alpha )
+// Source pixels used for computing all pixels of the destination image along
+// one dimension: each destination pixel n is computed from GetCount(n)
+// consecutive source pixels starting from GetStart(n) with the weights given
+// by GetWeights(n), if the filter uses them.
+class ResampleFilter
+{
+public:
+    // Create the filter for the given number of destination pixels, each of
+    // which uses at most maxTaps source pixels. If maxTaps is 0, the filter
+    // doesn't use any weights and AddTap() can't be used.
+    ResampleFilter(int newDim, int maxTaps)
+        : m_start(newDim, 0),
+          m_count(newDim, 0),
+          m_weights(newDim*maxTaps, 0.0f),
+          m_maxTaps(maxTaps),
+          m_maxCount(0)
     {
-        ret_image.SetAlpha();
-        dst_alpha = ret_image.GetAlpha();
     }
 
-    wxVector<BilinearPrecalc> vPrecalcs(height);
-    wxVector<BilinearPrecalc> hPrecalcs(width);
-    ResampleBilinearPrecalc(vPrecalcs, M_IMGDATA->m_height);
-    ResampleBilinearPrecalc(hPrecalcs, M_IMGDATA->m_width);
+    int GetSize() const { return static_cast<int>(m_start.size()); }
 
-    // initialize alpha values to avoid g++ warnings about possibly
-    // uninitialized variables
-    double r1, g1, b1, a1 = 0;
-    double r2, g2, b2, a2 = 0;
+    int GetStart(int n) const { return m_start[n]; }
+    int GetCount(int n) const { return m_count[n]; }
+    const float *GetWeights(int n) const { return &m_weights[n*m_maxTaps]; }
 
-    for ( int dsty = 0; dsty < height; dsty++ )
+    // Return the maximal number of source pixels used for any pixel.
+    int GetMaxCount() const { return m_maxCount; }
+
+    // Use count source pixels starting from start with equal weights.
+    void SetRange(int n, int start, int count)
     {
-        // We need to calculate the source pixel to interpolate from - Y-axis
-        const BilinearPrecalc& vPrecalc = vPrecalcs[dsty];
-        const int y_offset1 = vPrecalc.offset1;
-        const int y_offset2 = vPrecalc.offset2;
-        const double dy = vPrecalc.dd;
-        const double dy1 = vPrecalc.dd1;
+        m_start[n] = start;
+        m_count[n] = count;
 
+        if ( count > m_maxCount )
+            m_maxCount = count;
+    }
 
-        for ( int dstx = 0; dstx < width; dstx++ )
+    // Add the weight of the given source pixel to the weights used for the
+    // destination pixel n, the source pixels must be added in increasing
+    // order, but the same pixel may be added more than once.
+    void AddTap(int n, int src, double weight)
+    {
+        if ( !m_count[n] )
         {
-            // X-axis of pixel to interpolate from
-            const BilinearPrecalc& hPrecalc = hPrecalcs[dstx];
+            m_start[n] = src;
+            m_count[n] = 1;
+        }
+
+        const int tap = src - m_start[n];
+        wxASSERT( tap >= m_count[n] - 1 && tap < m_maxTaps );
+
+        float * const weights = &m_weights[n*m_maxTaps];
+        while ( m_count[n] <= tap )
+            weights[m_count[n]++] = 0.0f;
+
+        weights[tap] += static_cast<float>(weight);
+
+        if ( m_count[n] > m_maxCount )
+            m_maxCount = m_count[n];
+    }
+
+private:
+    wxVector<int> m_start,
+                  m_count;
+    wxVector<float> m_weights;
+    const int m_maxTaps;
+    int m_maxCount;
+};
 
-            const int x_offset1 = hPrecalc.offset1;
-            const int x_offset2 = hPrecalc.offset2;
-            const double dx = hPrecalc.dd;
-            const double dx1 = hPrecalc.dd1;
+enum ResampleMethod
+{
+    Resample_Box,
+    Resample_Bilinear,
+    Resample_Bicubic
+};
 
-            int src_pixel_index00 = y_offset1 * M_IMGDATA->m_width + x_offset1;
-            int src_pixel_index01 = y_offset1 * M_IMGDATA->m_width + x_offset2;
-            int src_pixel_index10 = y_offset2 * M_IMGDATA->m_width + x_offset1;
-            int src_pixel_index11 = y_offset2 * M_IMGDATA->m_width + x_offset2;
+// Everything needed to compute a band of rows of the destination image.
+struct ResampleContext
+{
+    ResampleMethod method;
 
-            // first line
-            r1 = src_data[src_pixel_index00 * 3 + 0] * dx1 + src_data[src_pixel_index01 * 3 + 0] * dx;
-            g1 = src_data[src_pixel_index00 * 3 + 1] * dx1 + src_data[src_pixel_index01 * 3 + 1] * dx;
-            b1 = src_data[src_pixel_index00 * 3 + 2] * dx1 + src_data[src_pixel_index01 * 3 + 2] * dx;
-            if ( src_alpha )
-                a1 = src_alpha[src_pixel_index00] * dx1 + src_alpha[src_pixel_index01] * dx;
+    const unsigned char *srcData,
+                        *srcAlpha;
+    int srcWidth;
 
-            // second line
-            r2 = src_data[src_pixel_index10 * 3 + 0] * dx1 + src_data[src_pixel_index11 * 3 + 0] * dx;
-            g2 = src_data[src_pixel_index10 * 3 + 1] * dx1 + src_data[src_pixel_index11 * 3 + 1] * dx;
-            b2 = src_data[src_pixel_index10 * 3 + 2] * dx1 + src_data[src_pixel_index11 * 3 + 2] * dx;
-            if ( src_alpha )
-                a2 = src_alpha[src_pixel_index10] * dx1 + src_alpha[src_pixel_index11] * dx;
+    unsigned char *dstData,
+                  *dstAlpha;
+    int dstWidth;
 
-            // result lines
+    const ResampleFilter *hFilter,
+                         *vFilter;
 
-            dst_data[0] = static_cast<unsigned char>(r1 * dy1 + r2 * dy + .5);
-            dst_data[1] = static_cast<unsigned char>(g1 * dy1 + g2 * dy + .5);
-            dst_data[2] = static_cast<unsigned char>(b1 * dy1 + b2 * dy + .5);
-            dst_data += 3;
+    // Copy of the last source row followed by an extra byte, see LoadPixel().
+    const unsigned char *srcLastRow;
+    int srcHeight;
 
-            if ( src_alpha )
-                *dst_alpha++ = static_cast<unsigned char>(a1 * dy1 + a2 * dy +.5);
-        }
+    const unsigned char *GetSrcRow(int y) const
+    {
+        return y == srcHeight - 1 ? srcLastRow : srcData + 3*y*srcWidth;
     }
+};
 
-    return ret_image;
-}
+// The intermediate results use 4 values (red, green, blue and alpha) per
+// pixel, colour values are premultiplied by alpha if necessary. When there
+// is no alpha channel, the last value is unused but still present to allow
+// processing the pixels using SIMD instructions.
+const int RESAMPLE_CHANNELS = 4;
 
-// The following two local functions are for the B-spline weighting of the
-// bicubic sampling algorithm
-static inline double spline_cube(double value)
-{
-    return value <= 0.0 ? 0.0 : value * value * value;
-}
+#ifdef wxIMAGE_USE_SSE2
 
-static inline double spline_weight(double value)
+// Load the pixel components expanded to 16 bits. The pixel is read as a
+// single 32 bit value, so the byte following it must be accessible, which is
+// why ResampleContext::GetSrcRow() must be used for getting the rows. Without
+// alpha the last component contains this byte and must be ignored.
+inline __m128i LoadPixel(const unsigned char *p,
+                         const unsigned char *alpha,
+                         __m128i zero)
 {
-    return (spline_cube(value + 2) -
-            4 * spline_cube(value + 1) +
-            6 * spline_cube(value) -
-            4 * spline_cube(value - 1)) / 6;
+    wxUint32 value;
+    memcpy(&value, p, sizeof(value));
+
+    __m128i pixel = _mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero);
+    if ( alpha )
+        pixel = _mm_insert_epi16(pixel, *alpha, 3);
+
+    return pixel;
 }
 
+#endif // wxIMAGE_USE_SSE2
 
-namespace
-{
+// Box filter: the sums of the pixel values are computed using integer
+// arithmetic in the given type and the averages are computed at the end.
 
-struct BicubicPrecalc
+template <typename T>
+void FilterRowBox(const ResampleFilter& filter,
+                  const unsigned char *src,
+                  const unsigned char *alpha,
+                  T *out)
 {
-    double weight[4];
-    int offset[4];
-};
+    const int width = filter.GetSize();
+    for ( int x = 0; x < width; x++ )
+    {
+        const int start = filter.GetStart(x),
+                  end = start + filter.GetCount(x);
 
-inline void DoCalc(BicubicPrecalc& precalc, double srcpixd, int oldDim)
-{
-    const double dd = srcpixd - static_cast<int>(srcpixd);
+        T r = 0, g = 0, b = 0, a = 0;
+        for ( int i = start; i < end; i++ )
+        {
+            const unsigned char * const p = src + 3*i;
+            if ( alpha )
+            {
+                const T pa = alpha[i];
+                r += p[0]*pa;
+                g += p[1]*pa;
+                b += p[2]*pa;
+                a += pa;
+            }
+            else
+            {
+                r += p[0];
+                g += p[1];
+                b += p[2];
+            }
+        }
 
-    for ( int k = -1; k <= 2; k++ )
-    {
-        precalc.offset[k + 1] = srcpixd + k < 0.0
-            ? 0
-            : srcpixd + k >= oldDim
-                ? oldDim - 1
-                : static_cast<int>(srcpixd + k);
+        *out++ = r;
+        *out++ = g;
+        *out++ = b;
+        *out++ = a;
+    }
+}
 
-        precalc.weight[k + 1] = spline_weight(k - dd);
+template <typename T>
+void AccumulateRowBox(T *acc, const T *row, size_t n, bool init)
+{
+    if ( init )
+    {
+        memcpy(acc, row, n*sizeof(T));
+        return;
     }
+
+    for ( size_t i = 0; i < n; i++ )
+        acc[i] += row[i];
 }
 
-void ResampleBicubicPrecalc(wxVector<BicubicPrecalc> &aWeight, int oldDim)
+#ifdef wxIMAGE_USE_SSE2
+
+// Overload of the function above for 32 bit sums processing all channels of
+// a pixel at once.
+void FilterRowBox(const ResampleFilter& filter,
+                  const unsigned char *src,
+                  const unsigned char *alpha,
+                  wxUint32 *out)
 {
-    const int newDim = aWeight.size();
-    wxASSERT( oldDim > 0 && newDim > 0 );
+    const __m128i zero = _mm_setzero_si128();
 
-    if ( newDim > 1 )
+    const int width = filter.GetSize();
+    for ( int x = 0; x < width; x++ )
     {
-        // We want to map pixels in the range [0..newDim-1]
-        // to the range [0..oldDim-1]
-        const double scale_factor = static_cast<double>(oldDim-1) / (newDim-1);
+        const int start = filter.GetStart(x),
+                  end = start + filter.GetCount(x);
 
-        for ( int dstd = 0; dstd < newDim; dstd++ )
+        __m128i sum = zero;
+        for ( int i = start; i < end; i++ )
         {
-            // We need to calculate the source pixel to interpolate from - Y-axis
-            const double srcpixd = static_cast<double>(dstd) * scale_factor;
+            __m128i pixel = LoadPixel(src + 3*i, alpha ? alpha + i : NULL, zero);
+            if ( alpha )
+            {
+                const short a = alpha[i];
+                pixel = _mm_mullo_epi16(pixel, _mm_setr_epi16(a, a, a, 1,
+                                                              0, 0, 0, 0));
+            }
 
-            DoCalc(aWeight[dstd], srcpixd, oldDim);
+            // And add them as 32 bit values.
+            sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(pixel, zero));
         }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), sum);
+        out += RESAMPLE_CHANNELS;
     }
-    else
+}
+
+#ifdef wxIMAGE_USE_AVX2
+
+__attribute__((target("avx2")))
+void AccumulateRowBoxAVX2(wxUint32 *acc, const wxUint32 *row, size_t n)
+{
+    size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
     {
-        // Let's take the pixel from the center of the source image.
-        const double srcpixd = static_cast<double>(oldDim - 1) / 2.0;
+        __m256i * const p = reinterpret_cast<__m256i *>(acc + i);
+        _mm256_storeu_si256(p,
+            _mm256_add_epi32(_mm256_loadu_si256(p),
+                             _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i))));
+    }
 
-        DoCalc(aWeight[0], srcpixd, oldDim);
+    // n is always a multiple of 4, so at most one group of 4 can remain.
+    if ( i < n )
+    {
+        __m128i * const p = reinterpret_cast<__m128i *>(acc + i);
+        _mm_storeu_si128(p,
+            _mm_add_epi32(_mm_loadu_si128(p),
+                          _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i))));
     }
 }
 
-} // anonymous namespace
+#endif // wxIMAGE_USE_AVX2
 
-// This is the bicubic resampling algorithm
+void AccumulateRowBox(wxUint32 *acc, const wxUint32 *row, size_t n, bool init)
+{
+    if ( init )
+    {
+        memcpy(acc, row, n*sizeof(wxUint32));
+        return;
+    }
+
+#ifdef wxIMAGE_USE_AVX2
+    if ( CPUHasAVX2() )
+    {
+        AccumulateRowBoxAVX2(acc, row, n);
+        return;
+    }
+#endif // wxIMAGE_USE_AVX2
+
+    for ( size_t i = 0; i < n; i += 4 )
+    {
+        __m128i * const p = reinterpret_cast<__m128i *>(acc + i);
+        _mm_storeu_si128(p,
+            _mm_add_epi32(_mm_loadu_si128(p),
+                          _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i))));
+    }
+}
+
+#endif // wxIMAGE_USE_SSE2
+
+template <typename T>
+void ResampleRowsBox(const ResampleContext& ctx, int y0, int y1)
+{
+    const ResampleFilter& hFilter = *ctx.hFilter;
+    const ResampleFilter& vFilter = *ctx.vFilter;
+
+    const size_t rowLen = RESAMPLE_CHANNELS*ctx.dstWidth;
+    const int window = vFilter.GetMaxCount();
+
+    // Ring buffer of the horizontally filtered rows, row y is stored at the
+    // index y % window.
+    wxVector<T> rows(window*rowLen);
+    wxVector<T> acc(rowLen);
+
+    unsigned char *dst = ctx.dstData + 3*y0*ctx.dstWidth;
+    unsigned char *dstAlpha = ctx.dstAlpha ? ctx.dstAlpha + y0*ctx.dstWidth
+                                           : NULL;
+
+    int nextRow = 0;
+    for ( int y = y0; y < y1; y++ )
+    {
+        const int start = vFilter.GetStart(y),
+                  count = vFilter.GetCount(y);
+
+        if ( nextRow < start )
+            nextRow = start;
+
+        for ( ; nextRow < start + count; nextRow++ )
+        {
+            FilterRowBox(hFilter,
+                         ctx.GetSrcRow(nextRow),
+                         ctx.srcAlpha ? ctx.srcAlpha + nextRow*ctx.srcWidth
+                                      : NULL,
+                         &rows[(nextRow % window)*rowLen]);
+        }
+
+        for ( int i = 0; i < count; i++ )
+        {
+            AccumulateRowBox(&acc[0], &rows[((start + i) % window)*rowLen],
+                             rowLen, i == 0);
+        }
+
+        // Floating point division is faster than the integer one and still
+        // gives exact results for the values in the range we use.
+        const T *sum = &acc[0];
+        for ( int x = 0; x < ctx.dstWidth; x++, sum += RESAMPLE_CHANNELS )
+        {
+            const double pixels = static_cast<double>(count)*hFilter.GetCount(x);
+            if ( dstAlpha )
+            {
+                const double a = static_cast<double>(sum[3]);
+                if ( sum[3] )
+                {
+                    dst[0] = static_cast<unsigned char>(sum[0] / a);
+                    dst[1] = static_cast<unsigned char>(sum[1] / a);
+                    dst[2] = static_cast<unsigned char>(sum[2] / a);
+                }
+                else
+                {
+                    dst[0] =
+                    dst[1] =
+                    dst[2] = 0;
+                }
+
+                *dstAlpha++ = static_cast<unsigned char>(a / pixels);
+            }
+            else
+            {
+                dst[0] = static_cast<unsigned char>(sum[0] / pixels);
+                dst[1] = static_cast<unsigned char>(sum[1] / pixels);
+                dst[2] = static_cast<unsigned char>(sum[2] / pixels);
+            }
+
+            dst += 3;
+        }
+    }
+}
+
+// Other filters use floating point arithmetic. The horizontal pass reads the
+// source pixels directly, as only a few of them are used when shrinking the
+// image, and produces floating point values used by the vertical pass.
+
+void FilterRowFloat(const ResampleFilter& filter,
+                    const unsigned char *src,
+                    const unsigned char *alpha,
+                    bool premultiply,
+                    float *out)
+{
+#ifdef wxIMAGE_USE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+#endif // wxIMAGE_USE_SSE2
+
+    const int width = filter.GetSize();
+    for ( int x = 0; x < width; x++, out += RESAMPLE_CHANNELS )
+    {
+        const int start = filter.GetStart(x),
+                  count = filter.GetCount(x);
+        const float * const weights = filter.GetWeights(x);
+
+#ifdef wxIMAGE_USE_SSE2
+        __m128 sum = _mm_setzero_ps();
+        for ( int i = 0; i < count; i++ )
+        {
+            const int n = start + i;
+            __m128i pixel = LoadPixel(src + 3*n, alpha ? alpha + n : NULL, zero);
+            if ( premultiply && alpha )
+            {
+                const short a = alpha[n];
+                pixel = _mm_mullo_epi16(pixel, _mm_setr_epi16(a, a, a, 1,
+                                                              0, 0, 0, 0));
+            }
+
+            const __m128 value = _mm_cvtepi32_ps(_mm_unpacklo_epi16(pixel, zero));
+            sum = _mm_add_ps(sum, _mm_mul_ps(value, _mm_set1_ps(weights[i])));
+        }
+
+        _mm_storeu_ps(out, sum);
+#else // !wxIMAGE_USE_SSE2
+        float r = 0, g = 0, b = 0, a = 0;
+        for ( int i = 0; i < count; i++ )
+        {
+            const unsigned char * const p = src + 3*(start + i);
+            float w = weights[i];
+            if ( alpha )
+            {
+                const float pa = alpha[start + i];
+                a += pa*w;
+
+                if ( premultiply )
+                    w *= pa;
+            }
+
+            r += p[0]*w;
+            g += p[1]*w;
+            b += p[2]*w;
+        }
+
+        out[0] = r;
+        out[1] = g;
+        out[2] = b;
+        out[3] = a;
+#endif // wxIMAGE_USE_SSE2/!wxIMAGE_USE_SSE2
+    }
+}
+
+#ifdef wxIMAGE_USE_AVX2
+
+__attribute__((target("avx2")))
+void AccumulateRowFloatAVX2(float *acc, const float *row, float w, size_t n)
+{
+    const __m256 weight = _mm256_set1_ps(w);
+
+    size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        _mm256_storeu_ps(acc + i,
+            _mm256_add_ps(_mm256_loadu_ps(acc + i),
+                          _mm256_mul_ps(_mm256_loadu_ps(row + i), weight)));
+    }
+
+    if ( i < n )
+    {
+        _mm_storeu_ps(acc + i,
+            _mm_add_ps(_mm_loadu_ps(acc + i),
+                       _mm_mul_ps(_mm_loadu_ps(row + i), _mm_set1_ps(w))));
+    }
+}
+
+#endif // wxIMAGE_USE_AVX2
+
+void AccumulateRowFloat(float *acc, const float *row, float w, size_t n,
+                        bool init)
+{
+    if ( init )
+    {
+        for ( size_t i = 0; i < n; i++ )
+            acc[i] = row[i]*w;
+        return;
+    }
+
+#ifdef wxIMAGE_USE_AVX2
+    if ( CPUHasAVX2() )
+    {
+        AccumulateRowFloatAVX2(acc, row, w, n);
+        return;
+    }
+#endif // wxIMAGE_USE_AVX2
+
+#ifdef wxIMAGE_USE_SSE2
+    const __m128 weight = _mm_set1_ps(w);
+    for ( size_t i = 0; i < n; i += 4 )
+    {
+        _mm_storeu_ps(acc + i,
+            _mm_add_ps(_mm_loadu_ps(acc + i),
+                       _mm_mul_ps(_mm_loadu_ps(row + i), weight)));
+    }
+#else // !wxIMAGE_USE_SSE2
+    for ( size_t i = 0; i < n; i++ )
+        acc[i] += row[i]*w;
+#endif // wxIMAGE_USE_SSE2/!wxIMAGE_USE_SSE2
+}
+
+#ifndef wxIMAGE_USE_SSE2
+
+// Convert the filtered value to unsigned char, rounding or truncating it.
+inline unsigned char FloatToByte(float value, float rounding)
+{
+    value += rounding;
+    return value <= 0.0f ? 0
+                         : value >= 255.0f ? 255
+                                           : static_cast<unsigned char>(value);
+}
+
+#endif // !wxIMAGE_USE_SSE2
+
+void ResampleRowsFloat(const ResampleContext& ctx, int y0, int y1)
+{
+    const ResampleFilter& hFilter = *ctx.hFilter;
+    const ResampleFilter& vFilter = *ctx.vFilter;
+
+    // Bicubic filter uses alpha-weighted colour values and truncates alpha,
+    // while bilinear one just interpolates all channels independently.
+    const bool premultiply = ctx.method == Resample_Bicubic;
+    const float alphaRounding = premultiply ? 0.0f : 0.5f;
+
+    const size_t rowLen = RESAMPLE_CHANNELS*ctx.dstWidth;
+    const int window = vFilter.GetMaxCount();
+
+    wxVector<float> rows(window*rowLen);
+    wxVector<float> acc(rowLen);
+
+#ifdef wxIMAGE_USE_SSE2
+    const __m128 rounding = _mm_setr_ps(0.5f, 0.5f, 0.5f, alphaRounding);
+#endif // wxIMAGE_USE_SSE2
+
+    unsigned char *dst = ctx.dstData + 3*y0*ctx.dstWidth;
+    unsigned char *dstAlpha = ctx.dstAlpha ? ctx.dstAlpha + y0*ctx.dstWidth
+                                           : NULL;
+
+    int nextRow = 0;
+    for ( int y = y0; y < y1; y++ )
+    {
+        const int start = vFilter.GetStart(y),
+                  count = vFilter.GetCount(y);
+        const float * const weights = vFilter.GetWeights(y);
+
+        if ( nextRow < start )
+            nextRow = start;
+
+        for ( ; nextRow < start + count; nextRow++ )
+        {
+            FilterRowFloat(hFilter,
+                           ctx.GetSrcRow(nextRow),
+                           ctx.srcAlpha ? ctx.srcAlpha + nextRow*ctx.srcWidth
+                                        : NULL,
+                           premultiply,
+                           &rows[(nextRow % window)*rowLen]);
+        }
+
+        for ( int i = 0; i < count; i++ )
+        {
+            AccumulateRowFloat(&acc[0], &rows[((start + i) % window)*rowLen],
+                               weights[i], rowLen, i == 0);
+        }
+
+        const float *sum = &acc[0];
+        for ( int x = 0; x < ctx.dstWidth; x++, sum += RESAMPLE_CHANNELS )
+        {
+#ifdef wxIMAGE_USE_SSE2
+            __m128 value = _mm_loadu_ps(sum);
+            if ( dstAlpha && premultiply )
+            {
+                if ( sum[3] > 0.0f )
+                    value = _mm_div_ps(value, _mm_setr_ps(sum[3], sum[3], sum[3], 1.0f));
+                else
+                    value = _mm_setr_ps(0.0f, 0.0f, 0.0f, sum[3]);
+            }
+
+            // Values out of range are clamped by the saturating packs.
+            const __m128i v = _mm_cvttps_epi32(_mm_add_ps(value, rounding));
+            const wxUint32 pixel = _mm_cvtsi128_si32(
+                _mm_packus_epi16(_mm_packs_epi32(v, v), v));
+
+            dst[0] = static_cast<unsigned char>(pixel);
+            dst[1] = static_cast<unsigned char>(pixel >> 8);
+            dst[2] = static_cast<unsigned char>(pixel >> 16);
+
+            if ( dstAlpha )
+                *dstAlpha++ = static_cast<unsigned char>(pixel >> 24);
+#else // !wxIMAGE_USE_SSE2
+            if ( dstAlpha && premultiply )
+            {
+                const float a = sum[3];
+                if ( a > 0.0f )
+                {
+                    dst[0] = FloatToByte(sum[0] / a, 0.5f);
+                    dst[1] = FloatToByte(sum[1] / a, 0.5f);
+                    dst[2] = FloatToByte(sum[2] / a, 0.5f);
+                }
+                else
+                {
+                    dst[0] =
+                    dst[1] =
+                    dst[2] = 0;
+                }
+            }
+            else
+            {
+                dst[0] = FloatToByte(sum[0], 0.5f);
+                dst[1] = FloatToByte(sum[1], 0.5f);
+                dst[2] = FloatToByte(sum[2], 0.5f);
+            }
+
+            if ( dstAlpha )
+                *dstAlpha++ = FloatToByte(sum[3], alphaRounding);
+#endif // wxIMAGE_USE_SSE2/!wxIMAGE_USE_SSE2
+
+            dst += 3;
+        }
+    }
+}
+
+void ResampleRows(const void *data, int y0, int y1)
+{
+    const ResampleContext& ctx = *static_cast<const ResampleContext *>(data);
+
+    if ( ctx.method != Resample_Box )
+    {
+        ResampleRowsFloat(ctx, y0, y1);
+        return;
+    }
+
+    // Use 32 bit sums if they can't overflow, which is almost always the
+    // case, unless the image is scaled down by a huge factor.
+    const double maxSum = (ctx.srcAlpha ? 255.0*255.0 : 255.0)*
+                            ctx.hFilter->GetMaxCount()*ctx.vFilter->GetMaxCount();
+    if ( maxSum < 4294967296.0 )
+        ResampleRowsBox<wxUint32>(ctx, y0, y1);
+    else
+        ResampleRowsBox<wxUint64>(ctx, y0, y1);
+}
+
+// Resample the image data using the given filters.
+void DoResample(ResampleMethod method,
+                const unsigned char *srcData,
+                const unsigned char *srcAlpha,
+                int srcWidth,
+                int srcHeight,
+                wxImage& dst,
+                const ResampleFilter& hFilter,
+                const ResampleFilter& vFilter)
+{
+    ResampleContext ctx;
+    ctx.method = method;
+    ctx.srcData = srcData;
+    ctx.srcAlpha = srcAlpha;
+    ctx.srcWidth = srcWidth;
+    ctx.dstData = dst.GetData();
+    ctx.dstAlpha = dst.GetAlpha();
+    ctx.dstWidth = dst.GetWidth();
+    ctx.hFilter = &hFilter;
+    ctx.vFilter = &vFilter;
+
+    const size_t lastRowLen = 3*static_cast<size_t>(srcWidth);
+    wxVector<unsigned char> lastRow(lastRowLen + 1);
+    memcpy(&lastRow[0], srcData + (srcHeight - 1)*lastRowLen, lastRowLen);
+    ctx.srcLastRow = &lastRow[0];
+    ctx.srcHeight = srcHeight;
+
+    const int height = dst.GetHeight();
+    wxProcessImageRows(ResampleRows, &ctx, height,
+                       static_cast<size_t>(srcWidth)*srcHeight +
+                          static_cast<size_t>(ctx.dstWidth)*height);
+}
+
+} // anonymous namespace
+
+/* static */
+void wxImage::SetMaxThreads(int threads)
+{
+    gs_imageMaxThreads = threads;
+}
+
+/* static */
+int wxImage::GetMaxThreads()
+{
+    return gs_imageMaxThreads;
+}
+
+namespace
+{
+
+void ResampleBoxPrecalc(ResampleFilter& boxes, int oldDim)
+{
+    const int newDim = boxes.GetSize();
+    wxASSERT( oldDim > 0 && newDim > 0 );
+
+    // We need to map pixel values in the range [-0.5 .. (newDim-1)+0.5]
+    // to the pixel values in the range [-0.5 .. (oldDim-1)+0.5].
+    // Transformation function is therefore:
+    //   pOld = sc * (pNew + 0.5) - 0.5, where sc = oldDim/newDim
+    //
+    // A new pixel pNew in the interval [pNew-0.5 .. pNew+0.5]
+    // is mapped to the old pixel in the interval [pOldLoBound..pOldUpBound],
+    // where:
+    //   pOldLoBound = sc * ((pNew-0.5) + 0.5) - 0.5 = sc * pNew - 0.5
+    //   pOldUpBound = sc * ((pNew+0.5) + 0.5) - 0.5 = sc * (pNew+1) - 0.5
+    // So, the lower bound of the pixel box (interval) is:
+    //   boxStart = round(pOldLoBound) = trunc((sc * pNew - 0.5) + 0.5) = trunc(sc * pNew)
+    // and the upper bound is:
+    // - if fraction(pOldUpBound) != 0.5 (bound inside the pixel):
+    //   boxEnd = round(pixOldUpBound) = trunc((sc * (pNew+1) - 0.5) + 0.5) = trunc(sc * (pNew+1))
+    //    e.g. for UpBound = 7.2 -> boxEnd = 7
+    //         for UpBound = 7.6 -> boxEnd = 8
+    // - if fraction(pOldUpBound) == 0.5 (bound at the edge of the pixel):
+    //   boxEnd = round(pOldUpBound)-1 = trunc((sc * (pNew+1) - 0.5) + 0.5) - 1 = trunc(sc * (pNew+1))-1
+    //    e.g. for UpBound = 7.5 -> boxEnd = 7 (not 8)
+    //
+    // In integer arithmetic:
+    //  boxStart = (oldDim * pNew) / newDim
+    //  boxEnd:
+    //   vEnd =  oldDim * (pNew+1) = oldDim * pNew + oldDim
+    //  if vEnd % newDim != 0 (frac(pOldUpBound) != 0.5) => boxEnd = vEnd / newDim
+    //  if vEnd % newDim == 0 (frac(pOldUpBound) == 0.5) => boxEnd = (vEnd / newDim) - 1
+
+    int v = 0; // oldDim * 0
+    for ( int dst = 0; dst < newDim; dst++ )
+    {
+        const int boxStart = v/newDim;
+        v += oldDim;
+        const int boxEnd = v%newDim != 0 ? v/newDim : (v/newDim)-1;
+
+        boxes.SetRange(dst, boxStart, boxEnd - boxStart + 1);
+    }
+}
+
+} // anonymous namespace
+
+wxImage wxImage::ResampleBox(int width, int height) const
+{
+    // This function implements a simple pre-blur/box averaging method for
+    // downsampling that gives reasonably smooth results To scale the image
+    // down we will need to gather a grid of pixels of the size of the scale
+    // factor in each direction and then do an averaging of the pixels.
+
+    wxImage ret_image(width, height, false);
+
+    ResampleFilter vPrecalcs(height, 0);
+    ResampleFilter hPrecalcs(width, 0);
+
+    ResampleBoxPrecalc(vPrecalcs, M_IMGDATA->m_height);
+    ResampleBoxPrecalc(hPrecalcs, M_IMGDATA->m_width);
+
+    if ( M_IMGDATA->m_alpha )
+        ret_image.SetAlpha();
+
+    DoResample(Resample_Box,
+               M_IMGDATA->m_data, M_IMGDATA->m_alpha,
+               M_IMGDATA->m_width, M_IMGDATA->m_height,
+               ret_image, hPrecalcs, vPrecalcs);
+
+    return ret_image;
+}
+
+namespace
+{
+
+inline void DoBilinearCalc(ResampleFilter& precalcs, int n, double srcpix, int srcpixmax)
+{
+    int srcpix1 = int(srcpix);
+    int srcpix2 = srcpix1 == srcpixmax ? srcpix1 : srcpix1 + 1;
+
+    const double dd = srcpix - (int)srcpix;
+    const double dd1 = 1.0 - dd;
+    const int offset1 = srcpix1 < 0.0
+                        ? 0
+                        : srcpix1 > srcpixmax
+                            ? srcpixmax
+                            : (int)srcpix1;
+    const int offset2 = srcpix2 < 0.0
+                        ? 0
+                        : srcpix2 > srcpixmax
+                            ? srcpixmax
+                            : (int)srcpix2;
+
+    precalcs.AddTap(n, offset1, dd1);
+    precalcs.AddTap(n, offset2, dd);
+}
+
+void ResampleBilinearPrecalc(ResampleFilter& precalcs, int oldDim)
+{
+    const int newDim = precalcs.GetSize();
+    wxASSERT( oldDim > 0 && newDim > 0 );
+    const int srcpixmax = oldDim - 1;
+    if ( newDim > 1 )
+    {
+        // We want to map pixels in the range [0..newDim-1]
+        // to the range [0..oldDim-1]
+        const double scale_factor = double(oldDim-1) / (newDim-1);
+
+        for ( int dsty = 0; dsty < newDim; dsty++ )
+        {
+            // We need to calculate the source pixel to interpolate from - Y-axis
+            double srcpix = (double)dsty * scale_factor;
+
+            DoBilinearCalc(precalcs, dsty, srcpix, srcpixmax);
+        }
+    }
+    else
+    {
+        // Let's take the pixel from the center of the source image.
+        double srcpix = (double)srcpixmax / 2.0;
+
+        DoBilinearCalc(precalcs, 0, srcpix, srcpixmax);
+    }
+}
+
+} // anonymous namespace
+
+wxImage wxImage::ResampleBilinear(int width, int height) const
+{
+    // This function implements a Bilinear algorithm for resampling.
+    wxImage ret_image(width, height, false);
+
+    if ( M_IMGDATA->m_alpha )
+        ret_image.SetAlpha();
+
+    ResampleFilter vPrecalcs(height, 2);
+    ResampleFilter hPrecalcs(width, 2);
+    ResampleBilinearPrecalc(vPrecalcs, M_IMGDATA->m_height);
+    ResampleBilinearPrecalc(hPrecalcs, M_IMGDATA->m_width);
+
+    DoResample(Resample_Bilinear,
+               M_IMGDATA->m_data, M_IMGDATA->m_alpha,
+               M_IMGDATA->m_width, M_IMGDATA->m_height,
+               ret_image, hPrecalcs, vPrecalcs);
+
+    return ret_image;
+}
+
+// The following two local functions are for the B-spline weighting of the
+// bicubic sampling algorithm
+static inline double spline_cube(double value)
+{
+    return value <= 0.0 ? 0.0 : value * value * value;
+}
+
+static inline double spline_weight(double value)
+{
+    return (spline_cube(value + 2) -
+            4 * spline_cube(value + 1) +
+            6 * spline_cube(value) -
+            4 * spline_cube(value - 1)) / 6;
+}
+
+
+namespace
+{
+
+inline void DoBicubicCalc(ResampleFilter& aWeight, int n, double srcpixd, int oldDim)
+{
+    const double dd = srcpixd - static_cast<int>(srcpixd);
+
+    for ( int k = -1; k <= 2; k++ )
+    {
+        const int offset = srcpixd + k < 0.0
+            ? 0
+            : srcpixd + k >= oldDim
+                ? oldDim - 1
+                : static_cast<int>(srcpixd + k);
+
+        aWeight.AddTap(n, offset, spline_weight(k - dd));
+    }
+}
+
+void ResampleBicubicPrecalc(ResampleFilter& aWeight, int oldDim)
+{
+    const int newDim = aWeight.GetSize();
+    wxASSERT( oldDim > 0 && newDim > 0 );
+
+    if ( newDim > 1 )
+    {
+        // We want to map pixels in the range [0..newDim-1]
+        // to the range [0..oldDim-1]
+        const double scale_factor = static_cast<double>(oldDim-1) / (newDim-1);
+
+        for ( int dstd = 0; dstd < newDim; dstd++ )
+        {
+            // We need to calculate the source pixel to interpolate from - Y-axis
+            const double srcpixd = static_cast<double>(dstd) * scale_factor;
+
+            DoBicubicCalc(aWeight, dstd, srcpixd, oldDim);
+        }
+    }
+    else
+    {
+        // Let's take the pixel from the center of the source image.
+        const double srcpixd = static_cast<double>(oldDim - 1) / 2.0;
+
+        DoBicubicCalc(aWeight, 0, srcpixd, oldDim);
+    }
+}
+
+} // anonymous namespace
+
+// This is the bicubic resampling algorithm
 wxImage wxImage::ResampleBicubic(int width, int height) const
 {
     // This function implements a Bicubic B-Spline algorithm for resampling.
@@ -956,328 +1699,718 @@ wxImage wxImage::ResampleBicubic(int width, int height) const
 
     ret_image.Create(width, height, false);
 
-    const unsigned char* src_data = M_IMGDATA->m_data;
-    const unsigned char* src_alpha = M_IMGDATA->m_alpha;
-    unsigned char* dst_data = ret_image.GetData();
-    unsigned char* dst_alpha = NULL;
-
-    if ( src_alpha )
-    {
+    if ( M_IMGDATA->m_alpha )
         ret_image.SetAlpha();
-        dst_alpha = ret_image.GetAlpha();
-    }
 
     // Precalculate weights
-    wxVector<BicubicPrecalc> vPrecalcs(height);
-    wxVector<BicubicPrecalc> hPrecalcs(width);
+    ResampleFilter vPrecalcs(height, 4);
+    ResampleFilter hPrecalcs(width, 4);
 
     ResampleBicubicPrecalc(vPrecalcs, M_IMGDATA->m_height);
     ResampleBicubicPrecalc(hPrecalcs, M_IMGDATA->m_width);
 
-    for ( int dsty = 0; dsty < height; dsty++ )
+    DoResample(Resample_Bicubic,
+               M_IMGDATA->m_data, M_IMGDATA->m_alpha,
+               M_IMGDATA->m_width, M_IMGDATA->m_height,
+               ret_image, hPrecalcs, vPrecalcs);
+
+    return ret_image;
+}
+
+// ----------------------------------------------------------------------------
+// Blur implementation
+// ----------------------------------------------------------------------------
+
+namespace
+{
+
+// The blur functions first blur the image rows, which are expanded to 32 bit
+// values for all the channels (red, green, blue and alpha, which is unused if
+// the image doesn't have it), optionally with some fractional bits. The
+// result is stored in an intermediate image using 16 bit values which is then
+// blurred vertically. This is done row by row too, by keeping the running
+// sums for all the columns, which is much more cache-friendly than
+// processing the image column by column.
+
+// Parameters of a single box blur pass.
+struct BlurPass
+{
+    int radius;
+
+    // The average value is computed as sum*scale + bias truncated to integer.
+    float scale,
+          bias;
+};
+
+// Maximal number of box blur passes done in each direction.
+const int BLUR_MAX_PASSES = 3;
+
+struct BlurContext
+{
+    const unsigned char *srcData,
+                        *srcAlpha;
+    unsigned char *dstData,
+                  *dstAlpha;
+
+    int width,
+        height;
+
+    // The intermediate images, the final result is stored in dstData if
+    // dst16 is NULL.
+    const wxInt16 *src16;
+    wxInt16 *dst16;
+
+    // The passes used for the rows, only the first one is used for columns.
+    BlurPass passes[BLUR_MAX_PASSES];
+    int numPasses;
+
+    // Number of fractional bits used for the intermediate values, must be
+    // small enough for them to fit in 16 bit signed integers.
+    int shift;
+};
+
+// Return the pointer to the values of the given row of 16 bit image.
+inline const wxInt16 *GetBlurRow16(const BlurContext& ctx, int y)
+{
+    if ( y < 0 )
+        y = 0;
+    else if ( y >= ctx.height )
+        y = ctx.height - 1;
+
+    return ctx.src16 + 4*static_cast<size_t>(y)*ctx.width;
+}
+
+void PackPixels(const unsigned char *data,
+                const unsigned char *alpha,
+                int n,
+                wxUint32 *out)
+{
+    unsigned char *p = reinterpret_cast<unsigned char *>(out);
+    for ( int i = 0; i < n; i++, p += 4 )
+    {
+        p[0] = *data++;
+        p[1] = *data++;
+        p[2] = *data++;
+        p[3] = alpha ? *alpha++ : 0;
+    }
+}
+
+void UnpackPixels(const wxUint32 *in,
+                  int n,
+                  unsigned char *data,
+                  unsigned char *alpha)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(in);
+    for ( int i = 0; i < n; i++, p += 4 )
+    {
+        *data++ = p[0];
+        *data++ = p[1];
+        *data++ = p[2];
+        if ( alpha )
+            *alpha++ = p[3];
+    }
+}
+
+void ExpandBlurRow(const wxUint32 *src, int width, int shift, wxInt32 *out)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(src);
+    const int n = 4*width;
+
+    int i = 0;
+#ifdef wxIMAGE_USE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for ( ; i + 16 <= n; i += 16 )
+    {
+        const __m128i
+            bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i)),
+            lo = _mm_unpacklo_epi8(bytes, zero),
+            hi = _mm_unpackhi_epi8(bytes, zero);
+
+        __m128i * const q = reinterpret_cast<__m128i *>(out + i);
+        _mm_storeu_si128(q + 0, _mm_slli_epi32(_mm_unpacklo_epi16(lo, zero), shift));
+        _mm_storeu_si128(q + 1, _mm_slli_epi32(_mm_unpackhi_epi16(lo, zero), shift));
+        _mm_storeu_si128(q + 2, _mm_slli_epi32(_mm_unpacklo_epi16(hi, zero), shift));
+        _mm_storeu_si128(q + 3, _mm_slli_epi32(_mm_unpackhi_epi16(hi, zero), shift));
+    }
+#endif // wxIMAGE_USE_SSE2
+
+    for ( ; i < n; i++ )
+        out[i] = p[i] << shift;
+}
+
+// Store the values as 16 bit integers.
+void StoreBlurRow16(const wxInt32 *in, int n, wxInt16 *out)
+{
+    int i = 0;
+#ifdef wxIMAGE_USE_SSE2
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        const __m128i * const q = reinterpret_cast<const __m128i *>(in + i);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                         _mm_packs_epi32(_mm_loadu_si128(q),
+                                         _mm_loadu_si128(q + 1)));
+    }
+#endif // wxIMAGE_USE_SSE2
+
+    for ( ; i < n; i++ )
+        out[i] = static_cast<wxInt16>(in[i]);
+}
+
+// Round the values to 8 bits and pack them into pixels.
+void PackBlurRow(const wxInt32 *in, int width, int shift, wxUint32 *dst)
+{
+    unsigned char *p = reinterpret_cast<unsigned char *>(dst);
+    const int n = 4*width;
+    const int rounding = shift ? 1 << (shift - 1) : 0;
+
+    int i = 0;
+#ifdef wxIMAGE_USE_SSE2
+    const __m128i round = _mm_set1_epi32(rounding);
+    for ( ; i + 16 <= n; i += 16 )
+    {
+        const __m128i * const q = reinterpret_cast<const __m128i *>(in + i);
+        __m128i v0 = _mm_loadu_si128(q + 0),
+                v1 = _mm_loadu_si128(q + 1),
+                v2 = _mm_loadu_si128(q + 2),
+                v3 = _mm_loadu_si128(q + 3);
+
+        v0 = _mm_srai_epi32(_mm_add_epi32(v0, round), shift);
+        v1 = _mm_srai_epi32(_mm_add_epi32(v1, round), shift);
+        v2 = _mm_srai_epi32(_mm_add_epi32(v2, round), shift);
+        v3 = _mm_srai_epi32(_mm_add_epi32(v3, round), shift);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p + i),
+                         _mm_packus_epi16(_mm_packs_epi32(v0, v1),
+                                          _mm_packs_epi32(v2, v3)));
+    }
+#endif // wxIMAGE_USE_SSE2
+
+    for ( ; i < n; i++ )
+    {
+        const int v = (in[i] + rounding) >> shift;
+        p[i] = static_cast<unsigned char>(v < 0 ? 0 : v > 255 ? 255 : v);
+    }
+}
+
+// Blur a single expanded row using a sliding window, so that the cost per
+// pixel doesn't depend on the radius. The pixels outside of the row are
+// replaced with the edge ones.
+void BoxBlurRow(const wxInt32 *in, wxInt32 *out, int width,
+                const BlurPass& pass)
+{
+    const int radius = pass.radius,
+              last = width - 1;
+
+#ifdef wxIMAGE_USE_SSE2
+    #define wxBLUR_PIXEL(n) \
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 4*(n)))
+
+    __m128i sum = _mm_setzero_si128();
+    for ( int i = -radius; i <= radius; i++ )
+        sum = _mm_add_epi32(sum, wxBLUR_PIXEL(i < 0 ? 0 : i > last ? last : i));
+
+    const __m128 scale = _mm_set1_ps(pass.scale),
+                 bias = _mm_set1_ps(pass.bias);
+    for ( int x = 0; x < width; x++ )
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 4*x),
+            _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(sum), scale),
+                                        bias)));
+
+        const int add = x + radius + 1,
+                  sub = x - radius;
+        sum = _mm_add_epi32(sum, wxBLUR_PIXEL(add > last ? last : add));
+        sum = _mm_sub_epi32(sum, wxBLUR_PIXEL(sub < 0 ? 0 : sub));
+    }
+
+    #undef wxBLUR_PIXEL
+#else // !wxIMAGE_USE_SSE2
+    for ( int c = 0; c < 4; c++ )
     {
-        // We need to calculate the source pixel to interpolate from - Y-axis
-        const BicubicPrecalc& vPrecalc = vPrecalcs[dsty];
+        wxInt32 sum = 0;
+        for ( int i = -radius; i <= radius; i++ )
+            sum += in[4*(i < 0 ? 0 : i > last ? last : i) + c];
 
-        for ( int dstx = 0; dstx < width; dstx++ )
+        for ( int x = 0; x < width; x++ )
         {
-            // X-axis of pixel to interpolate from
-            const BicubicPrecalc& hPrecalc = hPrecalcs[dstx];
+            out[4*x + c] = static_cast<wxInt32>(sum*pass.scale + pass.bias);
 
-            // Sums for each color channel
-            double sum_r = 0, sum_g = 0, sum_b = 0, sum_a = 0;
+            const int add = x + radius + 1,
+                      sub = x - radius;
+            sum += in[4*(add > last ? last : add) + c];
+            sum -= in[4*(sub < 0 ? 0 : sub) + c];
+        }
+    }
+#endif // wxIMAGE_USE_SSE2/!wxIMAGE_USE_SSE2
+}
 
-            // Here we actually determine the RGBA values for the destination pixel
-            for ( int k = -1; k <= 2; k++ )
-            {
-                // Y offset
-                const int y_offset = vPrecalc.offset[k + 1];
+// Update the running sums of the columns by adding one row and subtracting
+// another one (which may be NULL).
+void UpdateBlurSums(wxInt32 *sums, const wxInt16 *add, const wxInt16 *sub,
+                    int n)
+{
+    int i = 0;
+#ifdef wxIMAGE_USE_SSE2
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        // Compute the difference using 16 bit values if possible, it can't
+        // overflow as the values are non-negative.
+        __m128i lo, hi;
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(add + i));
+        if ( sub )
+        {
+            const __m128i
+                d = _mm_sub_epi16(a, _mm_loadu_si128(
+                                        reinterpret_cast<const __m128i *>(sub + i)));
 
-                // Loop across the X axis
-                for ( int i = -1; i <= 2; i++ )
-                {
-                    // X offset
-                    const int x_offset = hPrecalc.offset[i + 1];
-
-                    // Calculate the exact position where the source data
-                    // should be pulled from based on the x_offset and y_offset
-                    int src_pixel_index = y_offset*M_IMGDATA->m_width + x_offset;
-
-                    // Calculate the weight for the specified pixel according
-                    // to the bicubic b-spline kernel we're using for
-                    // interpolation
-                    const double
-                        pixel_weight = vPrecalc.weight[k + 1] * hPrecalc.weight[i + 1];
-
-                    // Create a sum of all velues for each color channel
-                    // adjusted for the pixel's calculated weight
-                    if ( src_alpha )
-                    {
-                        const unsigned char a = src_alpha[src_pixel_index];
-                        sum_r += src_data[src_pixel_index * 3 + 0] * pixel_weight * a;
-                        sum_g += src_data[src_pixel_index * 3 + 1] * pixel_weight * a;
-                        sum_b += src_data[src_pixel_index * 3 + 2] * pixel_weight * a;
-                        sum_a += a * pixel_weight;
-                    }
-                    else
-                    {
-                        sum_r += src_data[src_pixel_index * 3 + 0] * pixel_weight;
-                        sum_g += src_data[src_pixel_index * 3 + 1] * pixel_weight;
-                        sum_b += src_data[src_pixel_index * 3 + 2] * pixel_weight;
-                    }
-                }
-            }
+            // Sign-extend the differences to 32 bits.
+            lo = _mm_srai_epi32(_mm_unpacklo_epi16(d, d), 16);
+            hi = _mm_srai_epi32(_mm_unpackhi_epi16(d, d), 16);
+        }
+        else
+        {
+            const __m128i zero = _mm_setzero_si128();
+            lo = _mm_unpacklo_epi16(a, zero);
+            hi = _mm_unpackhi_epi16(a, zero);
+        }
 
-            // Put the data into the destination image.  The summed values are
-            // of double data type and are rounded here for accuracy
-            if ( src_alpha )
-            {
-                if ( sum_a )
-                {
-                     dst_data[0] = (unsigned char)(sum_r / sum_a + 0.5);
-                     dst_data[1] = (unsigned char)(sum_g / sum_a + 0.5);
-                     dst_data[2] = (unsigned char)(sum_b / sum_a + 0.5);
-                }
-                else
-                {
-                    dst_data[0] = 0;
-                    dst_data[1] = 0;
-                    dst_data[2] = 0;
-                }
-                *dst_alpha++ = (unsigned char)sum_a;
-            }
-            else
+        __m128i * const p = reinterpret_cast<__m128i *>(sums + i);
+        _mm_storeu_si128(p, _mm_add_epi32(_mm_loadu_si128(p), lo));
+        _mm_storeu_si128(p + 1, _mm_add_epi32(_mm_loadu_si128(p + 1), hi));
+    }
+#endif // wxIMAGE_USE_SSE2
+
+    for ( ; i < n; i++ )
+        sums[i] += add[i] - (sub ? sub[i] : 0);
+}
+
+// Compute the averages of the columns sums.
+void AverageBlurSums(const wxInt32 *sums, int n, const BlurPass& pass,
+                     wxInt32 *out)
+{
+    int i = 0;
+#ifdef wxIMAGE_USE_SSE2
+    const __m128 scale = _mm_set1_ps(pass.scale),
+                 bias = _mm_set1_ps(pass.bias);
+    for ( ; i + 4 <= n; i += 4 )
+    {
+        const __m128i
+            sum = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sums + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+            _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(sum), scale),
+                                        bias)));
+    }
+#endif // wxIMAGE_USE_SSE2
+
+    for ( ; i < n; i++ )
+        out[i] = static_cast<wxInt32>(sums[i]*pass.scale + pass.bias);
+}
+
+// Store the blurred row either in the intermediate or in the final image.
+void StoreBlurRow(const BlurContext& ctx, int y, const wxInt32 *row,
+                  wxUint32 *packed)
+{
+    const size_t offset = static_cast<size_t>(y)*ctx.width;
+    if ( ctx.dst16 )
+    {
+        StoreBlurRow16(row, 4*ctx.width, ctx.dst16 + 4*offset);
+    }
+    else
+    {
+        PackBlurRow(row, ctx.width, ctx.shift, packed);
+        UnpackPixels(packed, ctx.width,
+                     ctx.dstData + 3*offset,
+                     ctx.dstAlpha ? ctx.dstAlpha + offset : NULL);
+    }
+}
+
+// Blur the rows of the source image.
+void BlurRows(const void *data, int y0, int y1)
+{
+    const BlurContext& ctx = *static_cast<const BlurContext *>(data);
+    const int width = ctx.width;
+
+    wxVector<wxUint32> packed(width);
+    wxVector<wxInt32> row1(4*width),
+                      row2(4*width);
+
+    for ( int y = y0; y < y1; y++ )
+    {
+        const size_t offset = static_cast<size_t>(y)*width;
+        PackPixels(ctx.srcData + 3*offset,
+                   ctx.srcAlpha ? ctx.srcAlpha + offset : NULL,
+                   width, &packed[0]);
+
+        ExpandBlurRow(&packed[0], width, ctx.shift, &row1[0]);
+        for ( int n = 0; n < ctx.numPasses; n++ )
+        {
+            BoxBlurRow(&row1[0], &row2[0], width, ctx.passes[n]);
+            row1.swap(row2);
+        }
+
+        StoreBlurRow(ctx, y, &row1[0], &packed[0]);
+    }
+}
+
+// Blur the columns of the intermediate image using the first pass.
+void BlurColumns(const void *data, int y0, int y1)
+{
+    const BlurContext& ctx = *static_cast<const BlurContext *>(data);
+    const BlurPass& pass = ctx.passes[0];
+    const int n = 4*ctx.width;
+
+    wxVector<wxUint32> packed(ctx.width);
+    wxVector<wxInt32> sums(n),
+                      row(n);
+
+    for ( int i = -pass.radius; i <= pass.radius; i++ )
+        UpdateBlurSums(&sums[0], GetBlurRow16(ctx, y0 + i), NULL, n);
+
+    for ( int y = y0; y < y1; y++ )
+    {
+        AverageBlurSums(&sums[0], n, pass, &row[0]);
+        StoreBlurRow(ctx, y, &row[0], &packed[0]);
+
+        UpdateBlurSums(&sums[0],
+                       GetBlurRow16(ctx, y + pass.radius + 1),
+                       GetBlurRow16(ctx, y - pass.radius),
+                       n);
+    }
+}
+
+// Blur the image data in the horizontal and/or vertical directions using the
+// given passes and store the result in dst, which must have the same size as
+// the source image.
+void DoBlur(const unsigned char *srcData,
+            const unsigned char *srcAlpha,
+            int width,
+            int height,
+            wxImage& dst,
+            const BlurPass *passes,
+            int numPasses,
+            bool horz,
+            bool vert,
+            int shift)
+{
+    BlurContext ctx;
+    ctx.srcData = srcData;
+    ctx.srcAlpha = srcAlpha;
+    ctx.dstData = dst.GetData();
+    ctx.dstAlpha = dst.GetAlpha();
+    ctx.width = width;
+    ctx.height = height;
+    ctx.src16 = NULL;
+    ctx.dst16 = NULL;
+    ctx.shift = shift;
+
+    ctx.numPasses = horz ? numPasses : 0;
+    for ( int n = 0; n < ctx.numPasses; n++ )
+        ctx.passes[n] = passes[n];
+
+    const size_t numPixels = static_cast<size_t>(width)*height;
+    if ( !vert )
+    {
+        wxProcessImageRows(BlurRows, &ctx, height, numPixels*numPasses);
+        return;
+    }
+
+    // Blur (or just copy) the rows into the intermediate image first.
+    wxScopedArray<wxInt16> image1(4*numPixels),
+                           image2(numPasses > 1 ? 4*numPixels : 0);
+
+    ctx.dst16 = image1.get();
+    wxProcessImageRows(BlurRows, &ctx, height, numPixels*(ctx.numPasses + 1));
+
+    // Then do all the vertical passes, with the last one producing the result.
+    for ( int n = 0; n < numPasses; n++ )
+    {
+        ctx.src16 = image1.get();
+        ctx.dst16 = n == numPasses - 1 ? NULL : image2.get();
+        ctx.passes[0] = passes[n];
+
+        wxProcessImageRows(BlurColumns, &ctx, height, numPixels);
+
+        image1.swap(image2);
+    }
+}
+
+// Set up the pass used by the simple box blur functions: notice that they use
+// the truncated average value, to which the bias is added only to compensate
+// for the floating point errors.
+void InitBoxBlurPass(BlurPass& pass, int radius)
+{
+    const int area = 2*radius + 1;
+
+    pass.radius = radius;
+    pass.scale = 1.0f / area;
+    pass.bias = 0.5f / area;
+}
+
+// Compute the passes approximating Gaussian blur with the given standard
+// deviation by successive box blurs as explained in "Fast Almost-Gaussian
+// Filtering" by Peter Kovesi.
+void InitGaussianBlurPasses(BlurPass *passes, double sigma)
+{
+    const int n = BLUR_MAX_PASSES;
+
+    int wl = static_cast<int>(sqrt(12*sigma*sigma/n + 1));
+    if ( wl % 2 == 0 )
+        wl--;
+
+    const int m = wxRound((12*sigma*sigma - n*wl*wl - 4*n*wl - 3*n)/
+                            (-4*wl - 4));
+
+    for ( int i = 0; i < n; i++ )
+    {
+        const int area = i < m ? wl : wl + 2;
+
+        passes[i].radius = area / 2;
+        passes[i].scale = 1.0f / area;
+        passes[i].bias = 0.5f;
+    }
+}
+
+} // anonymous namespace
+
+// Blur in the horizontal direction
+wxImage wxImage::BlurHorizontal(int blurRadius) const
+{
+    wxImage ret_image(MakeEmptyClone());
+
+    wxCHECK( ret_image.IsOk(), ret_image );
+    wxCHECK_MSG( blurRadius >= 0, ret_image, wxS("invalid blur radius") );
+
+    BlurPass pass;
+    InitBoxBlurPass(pass, blurRadius);
+
+    DoBlur(M_IMGDATA->m_data, M_IMGDATA->m_alpha,
+           M_IMGDATA->m_width, M_IMGDATA->m_height,
+           ret_image, &pass, 1, true, false, 0);
+
+    return ret_image;
+}
+
+// Blur in the vertical direction
+wxImage wxImage::BlurVertical(int blurRadius) const
+{
+    wxImage ret_image(MakeEmptyClone());
+
+    wxCHECK( ret_image.IsOk(), ret_image );
+    wxCHECK_MSG( blurRadius >= 0, ret_image, wxS("invalid blur radius") );
+
+    BlurPass pass;
+    InitBoxBlurPass(pass, blurRadius);
+
+    DoBlur(M_IMGDATA->m_data, M_IMGDATA->m_alpha,
+           M_IMGDATA->m_width, M_IMGDATA->m_height,
+           ret_image, &pass, 1, false, true, 0);
+
+    return ret_image;
+}
+
+// The new blur function
+wxImage wxImage::Blur(int blurRadius) const
+{
+    wxImage ret_image(MakeEmptyClone());
+
+    wxCHECK( ret_image.IsOk(), ret_image );
+    wxCHECK_MSG( blurRadius >= 0, ret_image, wxS("invalid blur radius") );
+
+    // Blur the image in each direction
+    BlurPass pass;
+    InitBoxBlurPass(pass, blurRadius);
+
+    DoBlur(M_IMGDATA->m_data, M_IMGDATA->m_alpha,
+           M_IMGDATA->m_width, M_IMGDATA->m_height,
+           ret_image, &pass, 1, true, true, 0);
+
+    return ret_image;
+}
+
+wxImage wxImage::GaussianBlur(double sigma) const
+{
+    wxImage ret_image(MakeEmptyClone());
+
+    wxCHECK( ret_image.IsOk(), ret_image );
+    wxCHECK_MSG( sigma >= 0, ret_image, wxS("invalid standard deviation") );
+
+    BlurPass passes[BLUR_MAX_PASSES];
+    InitGaussianBlurPasses(passes, sigma);
+
+    // Use 7 fractional bits for the intermediate results to avoid
+    // accumulating the rounding errors.
+    DoBlur(M_IMGDATA->m_data, M_IMGDATA->m_alpha,
+           M_IMGDATA->m_width, M_IMGDATA->m_height,
+           ret_image, passes, BLUR_MAX_PASSES, true, true, 7);
+
+    return ret_image;
+}
+
+// ----------------------------------------------------------------------------
+// Rotating by multiples of 90 degrees and mirroring
+// ----------------------------------------------------------------------------
+
+// Rotating by 90 degrees is done by copying square tiles of pixels, so that
+// both the source columns and the destination rows of the tile remain in cache
+// while it is processed. Both the rotation and mirroring process the bands of
+// the destination rows in parallel for big images.
+
+namespace
+{
+
+// The size of the tiles used for rotating by 90 degrees in pixels: the source
+// rows of a tile of RGB pixels take just 3KiB.
+const int ROTATE_TILE_SIZE = 32;
+
+struct RotateFlipContext
+{
+    const unsigned char *src;
+    unsigned char *dst;
+
+    // the size of the source image
+    int width,
+        height;
+
+    // used by Rotate90Rows() only
+    bool clockwise;
+
+    // used by FlipRows() only
+    bool flipX,
+         flipY;
+};
+
+// Rotate the destination rows in [y0, y1) range of an image with N bytes per
+// pixel: when rotating clockwise, dst(x, y) = src(y, height - 1 - x) and
+// when rotating counterclockwise dst(x, y) = src(width - 1 - y, x).
+template <int N>
+void DoRotate90Rows(const RotateFlipContext& ctx, int y0, int y1)
+{
+    const int dstWidth = ctx.height;
+    const ptrdiff_t srcStep = ctx.clockwise ? -ctx.width*N : ctx.width*N;
+
+    for ( int ty = y0; ty < y1; ty += ROTATE_TILE_SIZE )
+    {
+        const int tyEnd = wxMin(ty + ROTATE_TILE_SIZE, y1);
+        for ( int tx = 0; tx < dstWidth; tx += ROTATE_TILE_SIZE )
+        {
+            const int txEnd = wxMin(tx + ROTATE_TILE_SIZE, dstWidth);
+            for ( int y = ty; y < tyEnd; y++ )
             {
-                dst_data[0] = (unsigned char)(sum_r + 0.5);
-                dst_data[1] = (unsigned char)(sum_g + 0.5);
-                dst_data[2] = (unsigned char)(sum_b + 0.5);
+                const int srcX = ctx.clockwise ? y : ctx.width - 1 - y;
+                const int srcY = ctx.clockwise ? ctx.height - 1 - tx : tx;
+
+                const unsigned char *s = ctx.src +
+                    (static_cast<size_t>(srcY)*ctx.width + srcX)*N;
+                unsigned char *d = ctx.dst +
+                    (static_cast<size_t>(y)*dstWidth + tx)*N;
+                for ( int x = tx; x < txEnd; x++, s += srcStep, d += N )
+                    memcpy(d, s, N);
             }
-            dst_data += 3;
         }
     }
+}
 
-    return ret_image;
+void Rotate90Rows(const void *data, int y0, int y1)
+{
+    DoRotate90Rows<3>(*static_cast<const RotateFlipContext *>(data), y0, y1);
 }
 
-// Blur in the horizontal direction
-wxImage wxImage::BlurHorizontal(int blurRadius) const
+void Rotate90AlphaRows(const void *data, int y0, int y1)
 {
-    wxImage ret_image(MakeEmptyClone());
+    DoRotate90Rows<1>(*static_cast<const RotateFlipContext *>(data), y0, y1);
+}
 
-    wxCHECK( ret_image.IsOk(), ret_image );
+// Copy the row of n pixels of N bytes each in reverse order.
+template <int N>
+void ReverseRow(const unsigned char *src, unsigned char *dst, int n)
+{
+    src += (n - 1)*N;
+    for ( int x = 0; x < n; x++, src -= N, dst += N )
+        memcpy(dst, src, N);
+}
 
-    const unsigned char* src_data = M_IMGDATA->m_data;
-    unsigned char* dst_data = ret_image.GetData();
-    const unsigned char* src_alpha = M_IMGDATA->m_alpha;
-    unsigned char* dst_alpha = ret_image.GetAlpha();
-
-    // number of pixels we average over
-    const int blurArea = blurRadius*2 + 1;
-
-    // Horizontal blurring algorithm - average all pixels in the specified blur
-    // radius in the X or horizontal direction
-    for ( int y = 0; y < M_IMGDATA->m_height; y++ )
-    {
-        // Variables used in the blurring algorithm
-        long sum_r = 0,
-             sum_g = 0,
-             sum_b = 0,
-             sum_a = 0;
-
-        long pixel_idx;
-        const unsigned char *src;
-        unsigned char *dst;
-
-        // Calculate the average of all pixels in the blur radius for the first
-        // pixel of the row
-        for ( int kernel_x = -blurRadius; kernel_x <= blurRadius; kernel_x++ )
-        {
-            // To deal with the pixels at the start of a row so it's not
-            // grabbing GOK values from memory at negative indices of the
-            // image's data or grabbing from the previous row
-            if ( kernel_x < 0 )
-                pixel_idx = y * M_IMGDATA->m_width;
-            else
-                pixel_idx = kernel_x + y * M_IMGDATA->m_width;
-
-            src = src_data + pixel_idx*3;
-            sum_r += src[0];
-            sum_g += src[1];
-            sum_b += src[2];
-            if ( src_alpha )
-                sum_a += src_alpha[pixel_idx];
-        }
-
-        dst = dst_data + y * M_IMGDATA->m_width*3;
-        dst[0] = (unsigned char)(sum_r / blurArea);
-        dst[1] = (unsigned char)(sum_g / blurArea);
-        dst[2] = (unsigned char)(sum_b / blurArea);
-        if ( src_alpha )
-            dst_alpha[y * M_IMGDATA->m_width] = (unsigned char)(sum_a / blurArea);
-
-        // Now average the values of the rest of the pixels by just moving the
-        // blur radius box along the row
-        for ( int x = 1; x < M_IMGDATA->m_width; x++ )
-        {
-            // Take care of edge pixels on the left edge by essentially
-            // duplicating the edge pixel
-            if ( x - blurRadius - 1 < 0 )
-                pixel_idx = y * M_IMGDATA->m_width;
-            else
-                pixel_idx = (x - blurRadius - 1) + y * M_IMGDATA->m_width;
-
-            // Subtract the value of the pixel at the left side of the blur
-            // radius box
-            src = src_data + pixel_idx*3;
-            sum_r -= src[0];
-            sum_g -= src[1];
-            sum_b -= src[2];
-            if ( src_alpha )
-                sum_a -= src_alpha[pixel_idx];
-
-            // Take care of edge pixels on the right edge
-            if ( x + blurRadius > M_IMGDATA->m_width - 1 )
-                pixel_idx = M_IMGDATA->m_width - 1 + y * M_IMGDATA->m_width;
-            else
-                pixel_idx = x + blurRadius + y * M_IMGDATA->m_width;
+#ifdef wxIMAGE_USE_SSE2
 
-            // Add the value of the pixel being added to the end of our box
-            src = src_data + pixel_idx*3;
-            sum_r += src[0];
-            sum_g += src[1];
-            sum_b += src[2];
-            if ( src_alpha )
-                sum_a += src_alpha[pixel_idx];
+template <>
+void ReverseRow<1>(const unsigned char *src, unsigned char *dst, int n)
+{
+    int x = 0;
+    for ( ; x + 16 <= n; x += 16 )
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + n - x - 16));
 
-            // Save off the averaged data
-            dst = dst_data + x*3 + y*M_IMGDATA->m_width*3;
-            dst[0] = (unsigned char)(sum_r / blurArea);
-            dst[1] = (unsigned char)(sum_g / blurArea);
-            dst[2] = (unsigned char)(sum_b / blurArea);
-            if ( src_alpha )
-                dst_alpha[x + y * M_IMGDATA->m_width] = (unsigned char)(sum_a / blurArea);
-        }
+        // reverse the order of 32 bit values, then of 16 bit values inside
+        // them and finally of the bytes inside 16 bit values
+        v = _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+
+        _mm_storeu_si128((__m128i *)(dst + x), v);
     }
 
-    return ret_image;
+    for ( ; x < n; x++ )
+        dst[x] = src[n - 1 - x];
 }
 
-// Blur in the vertical direction
-wxImage wxImage::BlurVertical(int blurRadius) const
-{
-    wxImage ret_image(MakeEmptyClone());
-
-    wxCHECK( ret_image.IsOk(), ret_image );
-
-    const unsigned char* src_data = M_IMGDATA->m_data;
-    unsigned char* dst_data = ret_image.GetData();
-    const unsigned char* src_alpha = M_IMGDATA->m_alpha;
-    unsigned char* dst_alpha = ret_image.GetAlpha();
-
-    // number of pixels we average over
-    const int blurArea = blurRadius*2 + 1;
-
-    // Vertical blurring algorithm - same as horizontal but switched the
-    // opposite direction
-    for ( int x = 0; x < M_IMGDATA->m_width; x++ )
-    {
-        // Variables used in the blurring algorithm
-        long sum_r = 0,
-             sum_g = 0,
-             sum_b = 0,
-             sum_a = 0;
-
-        long pixel_idx;
-        const unsigned char *src;
-        unsigned char *dst;
-
-        // Calculate the average of all pixels in our blur radius box for the
-        // first pixel of the column
-        for ( int kernel_y = -blurRadius; kernel_y <= blurRadius; kernel_y++ )
-        {
-            // To deal with the pixels at the start of a column so it's not
-            // grabbing GOK values from memory at negative indices of the
-            // image's data or grabbing from the previous column
-            if ( kernel_y < 0 )
-                pixel_idx = x;
-            else
-                pixel_idx = x + kernel_y * M_IMGDATA->m_width;
-
-            src = src_data + pixel_idx*3;
-            sum_r += src[0];
-            sum_g += src[1];
-            sum_b += src[2];
-            if ( src_alpha )
-                sum_a += src_alpha[pixel_idx];
-        }
-
-        dst = dst_data + x*3;
-        dst[0] = (unsigned char)(sum_r / blurArea);
-        dst[1] = (unsigned char)(sum_g / blurArea);
-        dst[2] = (unsigned char)(sum_b / blurArea);
-        if ( src_alpha )
-            dst_alpha[x] = (unsigned char)(sum_a / blurArea);
-
-        // Now average the values of the rest of the pixels by just moving the
-        // box along the column from top to bottom
-        for ( int y = 1; y < M_IMGDATA->m_height; y++ )
-        {
-            // Take care of pixels that would be beyond the top edge by
-            // duplicating the top edge pixel for the column
-            if ( y - blurRadius - 1 < 0 )
-                pixel_idx = x;
-            else
-                pixel_idx = x + (y - blurRadius - 1) * M_IMGDATA->m_width;
-
-            // Subtract the value of the pixel at the top of our blur radius box
-            src = src_data + pixel_idx*3;
-            sum_r -= src[0];
-            sum_g -= src[1];
-            sum_b -= src[2];
-            if ( src_alpha )
-                sum_a -= src_alpha[pixel_idx];
-
-            // Take care of the pixels that would be beyond the bottom edge of
-            // the image similar to the top edge
-            if ( y + blurRadius > M_IMGDATA->m_height - 1 )
-                pixel_idx = x + (M_IMGDATA->m_height - 1) * M_IMGDATA->m_width;
-            else
-                pixel_idx = x + (blurRadius + y) * M_IMGDATA->m_width;
+#endif // wxIMAGE_USE_SSE2
 
-            // Add the value of the pixel being added to the end of our box
-            src = src_data + pixel_idx*3;
-            sum_r += src[0];
-            sum_g += src[1];
-            sum_b += src[2];
-            if ( src_alpha )
-                sum_a += src_alpha[pixel_idx];
+template <int N>
+void DoFlipRows(const RotateFlipContext& ctx, int y0, int y1)
+{
+    const size_t stride = static_cast<size_t>(ctx.width)*N;
+    for ( int y = y0; y < y1; y++ )
+    {
+        const int srcY = ctx.flipY ? ctx.height - 1 - y : y;
+        const unsigned char * const s = ctx.src + srcY*stride;
+        unsigned char * const d = ctx.dst + y*stride;
 
-            // Save off the averaged data
-            dst = dst_data + (x + y * M_IMGDATA->m_width) * 3;
-            dst[0] = (unsigned char)(sum_r / blurArea);
-            dst[1] = (unsigned char)(sum_g / blurArea);
-            dst[2] = (unsigned char)(sum_b / blurArea);
-            if ( src_alpha )
-                dst_alpha[x + y * M_IMGDATA->m_width] = (unsigned char)(sum_a / blurArea);
-        }
+        if ( ctx.flipX )
+            ReverseRow<N>(s, d, ctx.width);
+        else
+            memcpy(d, s, stride);
     }
+}
 
-    return ret_image;
+void FlipRows(const void *data, int y0, int y1)
+{
+    DoFlipRows<3>(*static_cast<const RotateFlipContext *>(data), y0, y1);
 }
 
-// The new blur function
-wxImage wxImage::Blur(int blurRadius) const
+void FlipAlphaRows(const void *data, int y0, int y1)
 {
-    wxImage ret_image;
-    ret_image.Create(M_IMGDATA->m_width, M_IMGDATA->m_height, false);
+    DoFlipRows<1>(*static_cast<const RotateFlipContext *>(data), y0, y1);
+}
 
-    // Blur the image in each direction
-    ret_image = BlurHorizontal(blurRadius);
-    ret_image = ret_image.BlurVertical(blurRadius);
+// Flip the image data horizontally and/or vertically.
+void DoFlip(const unsigned char *srcData, const unsigned char *srcAlpha,
+            int width, int height,
+            wxImage& image,
+            bool flipX, bool flipY)
+{
+    RotateFlipContext ctx;
+    ctx.width = width;
+    ctx.height = height;
+    ctx.clockwise = false;
+    ctx.flipX = flipX;
+    ctx.flipY = flipY;
 
-    return ret_image;
+    const size_t numPixels = static_cast<size_t>(width)*height;
+
+    ctx.src = srcData;
+    ctx.dst = image.GetData();
+    wxProcessImageRows(FlipRows, &ctx, height, numPixels);
+
+    if ( srcAlpha )
+    {
+        ctx.src = srcAlpha;
+        ctx.dst = image.GetAlpha();
+        wxProcessImageRows(FlipAlphaRows, &ctx, height, numPixels);
+    }
 }
 
+} // anonymous namespace
+
 wxImage wxImage::Rotate90( bool clockwise ) const
 {
     wxImage image(MakeEmptyClone(Clone_SwapOrientation));
@@ -1301,72 +2434,25 @@ wxImage wxImage::Rotate90( bool clockwise ) const
                         clockwise ? height - 1 - hot_y : hot_y);
     }
 
-    unsigned char *data = image.GetData();
-    unsigned char *target_data;
-
-    // we rotate the image in 21-pixel (63-byte) wide strips
-    // to make better use of cpu cache - memory transfers
-    // (note: while much better than single-pixel "strips",
-    //  our vertical strips will still generally straddle 64-byte cachelines)
-    for (long ii = 0; ii < width; )
-    {
-        long next_ii = wxMin(ii + 21, width);
-
-        for (long j = 0; j < height; j++)
-        {
-            const unsigned char *source_data =
-                M_IMGDATA->m_data + (j*width + ii)*3;
-
-            for (long i = ii; i < next_ii; i++)
-            {
-                if ( clockwise )
-                {
-                    target_data = data + ((i + 1)*height - j - 1)*3;
-                }
-                else
-                {
-                    target_data = data + (height*(width - 1 - i) + j)*3;
-                }
-                memcpy( target_data, source_data, 3 );
-                source_data += 3;
-            }
-        }
+    RotateFlipContext ctx;
+    ctx.width = width;
+    ctx.height = height;
+    ctx.clockwise = clockwise;
+    ctx.flipX =
+    ctx.flipY = false;
 
-        ii = next_ii;
-    }
+    const size_t numPixels = static_cast<size_t>(width)*height;
 
-    const unsigned char *source_alpha = M_IMGDATA->m_alpha;
+    // The rows of the rotated image correspond to the source columns.
+    ctx.src = M_IMGDATA->m_data;
+    ctx.dst = image.GetData();
+    wxProcessImageRows(Rotate90Rows, &ctx, width, numPixels);
 
-    if ( source_alpha )
+    if ( M_IMGDATA->m_alpha )
     {
-        unsigned char *alpha_data = image.GetAlpha();
-
-        for (long ii = 0; ii < width; )
-        {
-            long next_ii = wxMin(ii + 64, width);
-
-            for (long j = 0; j < height; j++)
-            {
-                source_alpha = M_IMGDATA->m_alpha + j*width + ii;
-
-                for (long i = ii; i < next_ii; i++)
-                {
-                    unsigned char* target_alpha;
-                    if ( clockwise )
-                    {
-                        target_alpha = alpha_data + (i+1)*height - j - 1;
-                    }
-                    else
-                    {
-                        target_alpha = alpha_data + height*(width - i - 1) + j;
-                    }
-
-                    *target_alpha = *source_alpha++;
-                }
-            }
-
-            ii = next_ii;
-        }
+        ctx.src = M_IMGDATA->m_alpha;
+        ctx.dst = image.GetAlpha();
+        wxProcessImageRows(Rotate90AlphaRows, &ctx, width, numPixels);
     }
 
     return image;
@@ -1393,34 +2479,8 @@ wxImage wxImage::Rotate180() const
                         height - 1 - GetOptionInt(wxIMAGE_OPTION_CUR_HOTSPOT_Y));
     }
 
-    unsigned char *data = image.GetData();
-    unsigned char *alpha = image.GetAlpha();
-    const unsigned char *source_data = M_IMGDATA->m_data;
-    unsigned char *target_data = data + width * height * 3;
-
-    for (long j = 0; j < height; j++)
-    {
-        for (long i = 0; i < width; i++)
-        {
-            target_data -= 3;
-            memcpy( target_data, source_data, 3 );
-            source_data += 3;
-        }
-    }
-
-    if ( alpha )
-    {
-        const unsigned char *src_alpha = M_IMGDATA->m_alpha;
-        unsigned char *dest_alpha = alpha + width * height;
-
-        for (long j = 0; j < height; ++j)
-        {
-            for (long i = 0; i < width; ++i)
-            {
-                *(--dest_alpha) = *(src_alpha++);
-            }
-        }
-    }
+    DoFlip(M_IMGDATA->m_data, M_IMGDATA->m_alpha, width, height,
+           image, true, true);
 
     return image;
 }
@@ -1431,73 +2491,9 @@ wxImage wxImage::Mirror( bool horizontally ) const
 
     wxCHECK( image.IsOk(), image );
 
-    long height = M_IMGDATA->m_height;
-    long width  = M_IMGDATA->m_width;
-
-    unsigned char *data = image.GetData();
-    unsigned char *alpha = image.GetAlpha();
-    const unsigned char *source_data = M_IMGDATA->m_data;
-    unsigned char *target_data;
-
-    if (horizontally)
-    {
-        for (long j = 0; j < height; j++)
-        {
-            data += width*3;
-            target_data = data-3;
-            for (long i = 0; i < width; i++)
-            {
-                memcpy( target_data, source_data, 3 );
-                source_data += 3;
-                target_data -= 3;
-            }
-        }
-
-        if (alpha != NULL)
-        {
-            // src_alpha starts at the first pixel and increases by 1 after each step
-            // (a step here is the copy of the alpha value of one pixel)
-            const unsigned char *src_alpha = M_IMGDATA->m_alpha;
-            // dest_alpha starts just beyond the first line, decreases before each step,
-            // and after each line is finished, increases by 2 widths (skipping the line
-            // just copied and the line that will be copied next)
-            unsigned char *dest_alpha = alpha + width;
-
-            for (long jj = 0; jj < height; ++jj)
-            {
-                for (long i = 0; i < width; ++i) {
-                    *(--dest_alpha) = *(src_alpha++); // copy one pixel
-                }
-                dest_alpha += 2 * width; // advance beyond the end of the next line
-            }
-        }
-    }
-    else
-    {
-        for (long i = 0; i < height; i++)
-        {
-            target_data = data + 3*width*(height-1-i);
-            memcpy( target_data, source_data, (size_t)3*width );
-            source_data += 3*width;
-        }
-
-        if ( alpha )
-        {
-            // src_alpha starts at the first pixel and increases by 1 width after each step
-            // (a step here is the copy of the alpha channel of an entire line)
-            const unsigned char *src_alpha = M_IMGDATA->m_alpha;
-            // dest_alpha starts just beyond the last line (beyond the whole image)
-            // and decreases by 1 width before each step
-            unsigned char *dest_alpha = alpha + width * height;
-
-            for (long jj = 0; jj < height; ++jj)
-            {
-                dest_alpha -= width;
-                memcpy( dest_alpha, src_alpha, (size_t)width );
-                src_alpha += width;
-            }
-        }
-    }
+    DoFlip(M_IMGDATA->m_data, M_IMGDATA->m_alpha,
+           M_IMGDATA->m_width, M_IMGDATA->m_height,
+           image, horizontally, !horizontally);
 
     return image;
 }
@@ -1796,6 +2792,410 @@ wxImage::Paste(const wxImage & image, int x, int y,
     }
 }
 
+// ----------------------------------------------------------------------------
+// Pixel-wise colour operations
+// ----------------------------------------------------------------------------
+
+// All these operations process the bands of rows of big images in parallel.
+// The per-channel operations use lookup tables giving exactly the same results
+// as the corresponding wxColour functions, while the pixels of the given
+// colour, e.g. the mask one, are found using SSE2 if available.
+
+namespace
+{
+
+#ifdef wxIMAGE_USE_SSE2
+
+// Load 16 bytes of the pattern formed by repeating the given RGB colour,
+// starting at the given byte offset of it.
+inline __m128i LoadColourPattern(const unsigned char rgb[3], int offset)
+{
+    unsigned char pattern[16];
+    for ( int n = 0; n < 16; n++ )
+        pattern[n] = rgb[(offset + n) % 3];
+
+    return _mm_loadu_si128((const __m128i *)pattern);
+}
+
+// Finds the pixels of the given colour in the blocks of 16 RGB pixels, i.e. 3
+// SSE registers.
+class ColourMatcherSSE2
+{
+public:
+    explicit ColourMatcherSSE2(const unsigned char rgb[3])
+    {
+        static const unsigned char red[3] = { 0xff, 0, 0 };
+
+        for ( int i = 0; i < 3; i++ )
+        {
+            m_colour[i] = LoadColourPattern(rgb, 16*i);
+            m_firstByte[i] = LoadColourPattern(red, 16*i);
+        }
+    }
+
+    // Set all bytes of the pixels of our colour among the 16 ones starting at
+    // the given pointer to 0xff and all the other ones to 0 in the output
+    // registers. Returns false, without filling them, if there are none.
+    bool Match(const unsigned char *p, __m128i m[3]) const
+    {
+        __m128i eq[3];
+        for ( int i = 0; i < 3; i++ )
+        {
+            eq[i] = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p + i),
+                                   m_colour[i]);
+        }
+
+        // Combine the results for all 3 bytes of each pixel in its first byte,
+        // notice that the last pixel of the block is entirely in eq[2].
+        __m128i first[3];
+        for ( int i = 0; i < 3; i++ )
+        {
+            const __m128i next = i < 2 ? eq[i + 1] : _mm_setzero_si128();
+            const __m128i second = _mm_or_si128(_mm_srli_si128(eq[i], 1),
+                                                _mm_slli_si128(next, 15));
+            const __m128i third = _mm_or_si128(_mm_srli_si128(eq[i], 2),
+                                               _mm_slli_si128(next, 14));
+            first[i] = _mm_and_si128(_mm_and_si128(eq[i], m_firstByte[i]),
+                                     _mm_and_si128(second, third));
+        }
+
+        if ( !_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(first[0], first[1]),
+                                             first[2])) )
+            return false;
+
+        // And propagate them back to the other bytes.
+        for ( int i = 0; i < 3; i++ )
+        {
+            const __m128i prev = i > 0 ? first[i - 1] : _mm_setzero_si128();
+            const __m128i second = _mm_or_si128(_mm_slli_si128(first[i], 1),
+                                                _mm_srli_si128(prev, 15));
+            const __m128i third = _mm_or_si128(_mm_slli_si128(first[i], 2),
+                                               _mm_srli_si128(prev, 14));
+            m[i] = _mm_or_si128(first[i], _mm_or_si128(second, third));
+        }
+
+        return true;
+    }
+
+private:
+    // the colour repeated to fill 3 registers
+    __m128i m_colour[3];
+
+    // 0xff for the first byte of each pixel and 0 for the other ones
+    __m128i m_firstByte[3];
+};
+
+#endif // wxIMAGE_USE_SSE2
+
+// Set the pixels of the destination row corresponding to the source pixels
+// of the "from" colour to the "to" one, src and dst may be the same.
+void ReplaceColourPixels(const unsigned char *src, unsigned char *dst, int n,
+                         const unsigned char from[3],
+                         const unsigned char to[3])
+{
+    int x = 0;
+
+#ifdef wxIMAGE_USE_SSE2
+    const ColourMatcherSSE2 matcher(from);
+
+    __m128i toColour[3];
+    for ( int i = 0; i < 3; i++ )
+        toColour[i] = LoadColourPattern(to, 16*i);
+
+    for ( ; x + 16 <= n; x += 16, src += 48, dst += 48 )
+    {
+        __m128i m[3];
+        if ( !matcher.Match(src, m) )
+            continue;
+
+        for ( int i = 0; i < 3; i++ )
+        {
+            __m128i * const d = (__m128i *)dst + i;
+            const __m128i v = _mm_loadu_si128(d);
+            _mm_storeu_si128(d, _mm_or_si128(_mm_and_si128(m[i], toColour[i]),
+                                             _mm_andnot_si128(m[i], v)));
+        }
+    }
+#endif // wxIMAGE_USE_SSE2
+
+    for ( ; x < n; x++, src += 3, dst += 3 )
+    {
+        if ( src[0] == from[0] && src[1] == from[1] && src[2] == from[2] )
+        {
+            dst[0] = to[0];
+            dst[1] = to[1];
+            dst[2] = to[2];
+        }
+    }
+}
+
+struct ColourOpContext;
+class HueReciprocalTable;
+
+typedef void (*ColourOpFunc)(const ColourOpContext& ctx,
+                             const unsigned char *src,
+                             unsigned char *dst,
+                             int n);
+
+struct ColourOpContext
+{
+    ColourOpContext()
+    {
+        src = NULL;
+        dst = NULL;
+        width = 0;
+        convert = NULL;
+        replace = false;
+        hueAngle = 0;
+        hueReciprocals = NULL;
+    }
+
+    const unsigned char *src;
+    unsigned char *dst;
+    int width;
+
+    // the function converting the pixels of a row, may be NULL
+    ColourOpFunc convert;
+
+    // if true, the destination pixels corresponding to the source pixels of
+    // the "from" colour are set to the "to" colour after converting them
+    bool replace;
+    unsigned char from[3],
+                  to[3];
+
+    // the table used by ConvertChannels()
+    unsigned char table[256];
+
+    // the products of all channel values by the weights of the corresponding
+    // channels used by ConvertGrey()
+    double grey[3][256];
+
+    // the hue rotation angle used by RotateHueRow(), in the units used there
+    // and in [-HUE_FULL_TURN, HUE_FULL_TURN] range
+    int hueAngle;
+
+    // the table used by RotateHueRow()
+    const HueReciprocalTable *hueReciprocals;
+};
+
+void ColourOpRows(const void *data, int y0, int y1)
+{
+    const ColourOpContext& ctx = *static_cast<const ColourOpContext *>(data);
+
+    for ( int y = y0; y < y1; y++ )
+    {
+        const size_t offset = 3*static_cast<size_t>(y)*ctx.width;
+        const unsigned char * const src = ctx.src + offset;
+        unsigned char * const dst = ctx.dst + offset;
+
+        if ( ctx.convert )
+            ctx.convert(ctx, src, dst, ctx.width);
+
+        if ( ctx.replace )
+            ReplaceColourPixels(src, dst, ctx.width, ctx.from, ctx.to);
+    }
+}
+
+// Create the image with the same size, alpha channel and mask as the given
+// one and convert its pixels using the given context, leaving the pixels of
+// the mask colour unchanged.
+wxImage ConvertImageColours(const wxImage& src, ColourOpContext& ctx)
+{
+    wxImage image;
+
+    const int w = src.GetWidth();
+    const int h = src.GetHeight();
+    const size_t size = size_t(w) * h;
+    if ( !image.Create(w, h, false) )
+        return image;
+
+    const unsigned char* alpha = src.GetAlpha();
+    if (alpha)
+    {
+        image.SetAlpha();
+        memcpy(image.GetAlpha(), alpha, size);
+    }
+
+    if ( src.HasMask() )
+    {
+        ctx.replace = true;
+        ctx.from[0] =
+        ctx.to[0] = src.GetMaskRed();
+        ctx.from[1] =
+        ctx.to[1] = src.GetMaskGreen();
+        ctx.from[2] =
+        ctx.to[2] = src.GetMaskBlue();
+        image.SetMaskColour(ctx.from[0], ctx.from[1], ctx.from[2]);
+    }
+
+    ctx.src = src.GetData();
+    ctx.dst = image.GetData();
+    ctx.width = w;
+    wxProcessImageRows(ColourOpRows, &ctx, h, size);
+
+    return image;
+}
+
+void ClearRow(const ColourOpContext& WXUNUSED(ctx),
+              const unsigned char *WXUNUSED(src), unsigned char *dst, int n)
+{
+    memset(dst, 0, 3*static_cast<size_t>(n));
+}
+
+void ConvertChannels(const ColourOpContext& ctx,
+                     const unsigned char *src, unsigned char *dst, int n)
+{
+    const unsigned char * const table = ctx.table;
+    for ( int x = 0; x < 3*n; x++ )
+        dst[x] = table[src[x]];
+}
+
+void ConvertGrey(const ColourOpContext& ctx,
+                 const unsigned char *src, unsigned char *dst, int n)
+{
+    for ( int x = 0; x < n; x++, src += 3, dst += 3 )
+    {
+        // This computes exactly the same value as wxColour::MakeGrey() but
+        // avoids the multiplications and the slow rounding function call.
+        const double luma = ctx.grey[0][src[0]] +
+                            ctx.grey[1][src[1]] +
+                            ctx.grey[2][src[2]];
+
+        dst[0] =
+        dst[1] =
+        dst[2] = static_cast<unsigned char>(luma >= 0
+                                                ? static_cast<int>(luma + 0.5)
+                                                : wxRound(luma));
+    }
+}
+
+// Hue rotation is done using integer arithmetic with the hue expressed in the
+// units of 1/6 of the full turn, i.e. 60 degrees, with this many bits in the
+// fractional part.
+const int HUE_FRACTION_BITS = 22;
+const int HUE_ONE = 1 << HUE_FRACTION_BITS;
+const int HUE_FULL_TURN = 6*HUE_ONE;
+
+// Table of HUE_ONE/n values used to avoid the divisions.
+class HueReciprocalTable
+{
+public:
+    HueReciprocalTable()
+    {
+        m_values[0] = 0;
+        for ( int n = 1; n < 256; n++ )
+            m_values[n] = (HUE_ONE + n/2)/n;
+    }
+
+    int operator[](int n) const { return m_values[n]; }
+
+private:
+    int m_values[256];
+};
+
+// This must be called before starting the worker threads using the table, so
+// that it's initialized by the thread calling it.
+const HueReciprocalTable *GetHueReciprocalTable()
+{
+    static const HueReciprocalTable s_reciprocals;
+
+    return &s_reciprocals;
+}
+
+void RotateHueRow(const ColourOpContext& ctx,
+                  const unsigned char *WXUNUSED(src), unsigned char *dst, int n)
+{
+    const HueReciprocalTable& reciprocals = *ctx.hueReciprocals;
+
+    for ( int x = 0; x < n; x++, dst += 3 )
+    {
+        const int r = dst[0],
+                  g = dst[1],
+                  b = dst[2];
+
+        const int maxRGB = wxMax(r, wxMax(g, b)),
+                  minRGB = wxMin(r, wxMin(g, b));
+        const int delta = maxRGB - minRGB;
+
+        // The hue of grey pixels is undefined, leave them unchanged.
+        if ( !delta )
+            continue;
+
+        // Compute the hue, in the same way as wxImage::RGBtoHSV() does.
+        int hue;
+        if ( r == maxRGB )
+            hue = (g - b)*reciprocals[delta];
+        else if ( g == maxRGB )
+            hue = 2*HUE_ONE + (b - r)*reciprocals[delta];
+        else
+            hue = 4*HUE_ONE + (r - g)*reciprocals[delta];
+
+        if ( hue < 0 )
+            hue += HUE_FULL_TURN;
+
+        hue += ctx.hueAngle;
+        if ( hue < 0 )
+            hue += HUE_FULL_TURN;
+        else if ( hue >= HUE_FULL_TURN )
+            hue -= HUE_FULL_TURN;
+
+        // The value and the saturation, and hence the maximal and minimal
+        // components, don't change, so only the remaining one and the order
+        // of the components need to be found, as in wxImage::HSVtoRGB().
+        const int f = hue & (HUE_ONE - 1);
+        const int up = minRGB +
+            ((delta*f + HUE_ONE/2) >> HUE_FRACTION_BITS);
+        const int down = maxRGB -
+            ((delta*f + HUE_ONE/2) >> HUE_FRACTION_BITS);
+
+        int red, green, blue;
+        switch ( hue >> HUE_FRACTION_BITS )
+        {
+            case 0:
+                red = maxRGB;
+                green = up;
+                blue = minRGB;
+                break;
+
+            case 1:
+                red = down;
+                green = maxRGB;
+                blue = minRGB;
+                break;
+
+            case 2:
+                red = minRGB;
+                green = maxRGB;
+                blue = up;
+                break;
+
+            case 3:
+                red = minRGB;
+                green = down;
+                blue = maxRGB;
+                break;
+
+            case 4:
+                red = up;
+                green = minRGB;
+                blue = maxRGB;
+                break;
+
+            default:    // case 5:
+                red = maxRGB;
+                green = minRGB;
+                blue = down;
+                break;
+        }
+
+        dst[0] = static_cast<unsigned char>(red);
+        dst[1] = static_cast<unsigned char>(green);
+        dst[2] = static_cast<unsigned char>(blue);
+    }
+}
+
+} // anonymous namespace
+
 void wxImage::Replace( unsigned char r1, unsigned char g1, unsigned char b1,
                        unsigned char r2, unsigned char g2, unsigned char b2 )
 {
@@ -1803,22 +3203,20 @@ void wxImage::Replace( unsigned char r1, unsigned char g1, unsigned char b1,
 
     AllocExclusive();
 
-    unsigned char *data = GetData();
+    ColourOpContext ctx;
+    ctx.src =
+    ctx.dst = GetData();
+    ctx.width = GetWidth();
+    ctx.replace = true;
+    ctx.from[0] = r1;
+    ctx.from[1] = g1;
+    ctx.from[2] = b1;
+    ctx.to[0] = r2;
+    ctx.to[1] = g2;
+    ctx.to[2] = b2;
 
-    const int w = GetWidth();
     const int h = GetHeight();
-
-    for (int j = 0; j < h; j++)
-        for (int i = 0; i < w; i++)
-        {
-            if ((data[0] == r1) && (data[1] == g1) && (data[2] == b1))
-            {
-                data[0] = r2;
-                data[1] = g2;
-                data[2] = b2;
-            }
-            data += 3;
-        }
+    wxProcessImageRows(ColourOpRows, &ctx, h, static_cast<size_t>(ctx.width)*h);
 }
 
 wxImage wxImage::ConvertToGreyscale(void) const
@@ -1828,40 +3226,18 @@ wxImage wxImage::ConvertToGreyscale(void) const
 
 wxImage wxImage::ConvertToGreyscale(double weight_r, double weight_g, double weight_b) const
 {
-    wxImage image;
-    wxCHECK_MSG(IsOk(), image, "invalid image");
+    wxCHECK_MSG(IsOk(), wxImage(), "invalid image");
 
-    const int w = M_IMGDATA->m_width;
-    const int h = M_IMGDATA->m_height;
-    size_t size = size_t(w) * h;
-    image.Create(w, h, false);
-    const unsigned char* alpha = M_IMGDATA->m_alpha;
-    if (alpha)
+    ColourOpContext ctx;
+    ctx.convert = ConvertGrey;
+    for ( int n = 0; n < 256; n++ )
     {
-        image.SetAlpha();
-        memcpy(image.GetAlpha(), alpha, size);
-    }
-    const unsigned char mask_r = M_IMGDATA->m_maskRed;
-    const unsigned char mask_g = M_IMGDATA->m_maskGreen;
-    const unsigned char mask_b = M_IMGDATA->m_maskBlue;
-    const bool hasMask = M_IMGDATA->m_hasMask;
-    if (hasMask)
-        image.SetMaskColour(mask_r, mask_g, mask_b);
-
-    const unsigned char* src = M_IMGDATA->m_data;
-    unsigned char* dst = image.GetData();
-    while (size--)
-    {
-        unsigned char r = *src++;
-        unsigned char g = *src++;
-        unsigned char b = *src++;
-        if (!hasMask || r != mask_r || g != mask_g || b != mask_b)
-            wxColour::MakeGrey(&r, &g, &b, weight_r, weight_g, weight_b);
-        *dst++ = r;
-        *dst++ = g;
-        *dst++ = b;
+        ctx.grey[0][n] = n * weight_r;
+        ctx.grey[1][n] = n * weight_g;
+        ctx.grey[2][n] = n * weight_b;
     }
-    return image;
+
+    return ConvertImageColours(*this, ctx);
 }
 
 wxImage wxImage::ConvertToMono( unsigned char r, unsigned char g, unsigned char b ) const
@@ -1885,77 +3261,81 @@ wxImage wxImage::ConvertToMono( unsigned char r, unsigned char g, unsigned char
             image.SetMaskColour( 0, 0, 0 );
     }
 
-    long size = M_IMGDATA->m_height * M_IMGDATA->m_width;
+    // Set all pixels to black and then those of the given colour to white,
+    // as wxColourBase::MakeMono() does.
+    ColourOpContext ctx;
+    ctx.src = M_IMGDATA->m_data;
+    ctx.dst = data;
+    ctx.width = M_IMGDATA->m_width;
+    ctx.convert = ClearRow;
+    ctx.replace = true;
+    ctx.from[0] = r;
+    ctx.from[1] = g;
+    ctx.from[2] = b;
+    ctx.to[0] =
+    ctx.to[1] =
+    ctx.to[2] = 255;
 
-    unsigned char *srcd = M_IMGDATA->m_data;
-    unsigned char *tard = image.GetData();
-
-    for ( long i = 0; i < size; i++, srcd += 3, tard += 3 )
-    {
-        bool on = (srcd[0] == r) && (srcd[1] == g) && (srcd[2] == b);
-        wxColourBase::MakeMono(tard + 0, tard + 1, tard + 2, on);
-    }
+    const int h = M_IMGDATA->m_height;
+    wxProcessImageRows(ColourOpRows, &ctx, h, static_cast<size_t>(ctx.width)*h);
 
     return image;
 }
 
 wxImage wxImage::ConvertToDisabled(unsigned char brightness) const
 {
-    wxImage image;
-    wxCHECK_MSG(IsOk(), image, "invalid image");
+    wxCHECK_MSG(IsOk(), wxImage(), "invalid image");
 
-    const int w = M_IMGDATA->m_width;
-    const int h = M_IMGDATA->m_height;
-    size_t size = size_t(w) * h;
-    image.Create(w, h, false);
-    const unsigned char* alpha = M_IMGDATA->m_alpha;
-    if (alpha)
+    // wxColour::MakeDisabled() transforms each channel independently, so just
+    // tabulate its results.
+    ColourOpContext ctx;
+    ctx.convert = ConvertChannels;
+    for ( int n = 0; n < 256; n++ )
     {
-        image.SetAlpha();
-        memcpy(image.GetAlpha(), alpha, size);
+        unsigned char r = n, g = n, b = n;
+        wxColour::MakeDisabled(&r, &g, &b, brightness);
+        ctx.table[n] = r;
     }
-    const unsigned char mask_r = M_IMGDATA->m_maskRed;
-    const unsigned char mask_g = M_IMGDATA->m_maskGreen;
-    const unsigned char mask_b = M_IMGDATA->m_maskBlue;
-    const bool hasMask = M_IMGDATA->m_hasMask;
-    if (hasMask)
-        image.SetMaskColour(mask_r, mask_g, mask_b);
-
-    const unsigned char* src = M_IMGDATA->m_data;
-    unsigned char* dst = image.GetData();
-    while (size--)
-    {
-        unsigned char r = *src++;
-        unsigned char g = *src++;
-        unsigned char b = *src++;
-        if (!hasMask || r != mask_r || g != mask_g || b != mask_b)
-            wxColour::MakeDisabled(&r, &g, &b, brightness);
-        *dst++ = r;
-        *dst++ = g;
-        *dst++ = b;
+
+    return ConvertImageColours(*this, ctx);
+}
+
+wxImage wxImage::ChangeLightness(int alpha) const
+{
+    wxCHECK_MSG(IsOk(), wxImage(), "invalid image");
+    wxCHECK_MSG(alpha >= 0 && alpha <= 200, wxImage(), "invalid alpha value");
+
+    ColourOpContext ctx;
+    ctx.convert = ConvertChannels;
+    for ( int n = 0; n < 256; n++ )
+    {
+        unsigned char r = n, g = n, b = n;
+        wxColour::ChangeLightness(&r, &g, &b, alpha);
+        ctx.table[n] = r;
     }
-    return image;
+
+    return ConvertImageColours(*this, ctx);
 }
 
 int wxImage::GetWidth() const
 {
     wxCHECK_MSG( IsOk(), 0, wxT("invalid image") );
 
-    return M_IMGDATA->m_width;
+    return M_IMGDATA_ANY->m_width;
 }
 
 int wxImage::GetHeight() const
 {
     wxCHECK_MSG( IsOk(), 0, wxT("invalid image") );
 
-    return M_IMGDATA->m_height;
+    return M_IMGDATA_ANY->m_height;
 }
 
 wxBitmapType wxImage::GetType() const
 {
     wxCHECK_MSG( IsOk(), wxBITMAP_TYPE_INVALID, wxT("invalid image") );
 
-    return M_IMGDATA->m_type;
+    return M_IMGDATA_ANY->m_type;
 }
 
 void wxImage::SetType(wxBitmapType type)
@@ -1965,16 +3345,16 @@ void wxImage::SetType(wxBitmapType type)
     // type can be wxBITMAP_TYPE_INVALID to reset the image type to default
     wxASSERT_MSG( type != wxBITMAP_TYPE_MAX, "invalid bitmap type" );
 
-    M_IMGDATA->m_type = type;
+    M_IMGDATA_ANY->m_type = type;
 }
 
 long wxImage::XYToIndex(int x, int y) const
 {
     if ( IsOk() &&
             x >= 0 && y >= 0 &&
-                x < M_IMGDATA->m_width && y < M_IMGDATA->m_height )
+                x < M_IMGDATA_ANY->m_width && y < M_IMGDATA_ANY->m_height )
     {
-        return y*M_IMGDATA->m_width + x;
+        return y*M_IMGDATA_ANY->m_width + x;
     }
 
     return -1;
@@ -2066,7 +3446,7 @@ bool wxImage::IsOk() const
 {
     // image of 0 width or height can't be considered ok - at least because it
     // causes crashes in ConvertToBitmap() if we don't catch it in time
-    wxImageRefData *data = M_IMGDATA;
+    wxImageRefData *data = M_IMGDATA_ANY;
     return data && data->m_ok && data->m_width && data->m_height;
 }
 
@@ -2083,14 +3463,14 @@ void wxImage::SetData( unsigned char *data, bool static_data  )
 
     wxImageRefData *newRefData = new wxImageRefData();
 
-    newRefData->m_width = M_IMGDATA->m_width;
-    newRefData->m_height = M_IMGDATA->m_height;
+    newRefData->m_width = M_IMGDATA_ANY->m_width;
+    newRefData->m_height = M_IMGDATA_ANY->m_height;
     newRefData->m_data = data;
     newRefData->m_ok = true;
-    newRefData->m_maskRed = M_IMGDATA->m_maskRed;
-    newRefData->m_maskGreen = M_IMGDATA->m_maskGreen;
-    newRefData->m_maskBlue = M_IMGDATA->m_maskBlue;
-    newRefData->m_hasMask = M_IMGDATA->m_hasMask;
+    newRefData->m_maskRed = M_IMGDATA_ANY->m_maskRed;
+    newRefData->m_maskGreen = M_IMGDATA_ANY->m_maskGreen;
+    newRefData->m_maskBlue = M_IMGDATA_ANY->m_maskBlue;
+    newRefData->m_hasMask = M_IMGDATA_ANY->m_hasMask;
     newRefData->m_static = static_data;
 
     UnRef();
@@ -2108,10 +3488,10 @@ void wxImage::SetData( unsigned char *data, int new_width, int new_height, bool
         newRefData->m_height = new_height;
         newRefData->m_data = data;
         newRefData->m_ok = true;
-        newRefData->m_maskRed = M_IMGDATA->m_maskRed;
-        newRefData->m_maskGreen = M_IMGDATA->m_maskGreen;
-        newRefData->m_maskBlue = M_IMGDATA->m_maskBlue;
-        newRefData->m_hasMask = M_IMGDATA->m_hasMask;
+        newRefData->m_maskRed = M_IMGDATA_ANY->m_maskRed;
+        newRefData->m_maskGreen = M_IMGDATA_ANY->m_maskGreen;
+        newRefData->m_maskBlue = M_IMGDATA_ANY->m_maskBlue;
+        newRefData->m_hasMask = M_IMGDATA_ANY->m_hasMask;
     }
     else
     {
@@ -2158,99 +3538,543 @@ wxImage::ConvertColourToAlpha(unsigned char r, unsigned char g, unsigned char b)
 {
     SetAlpha(NULL);
 
-    const int w = M_IMGDATA->m_width;
-    const int h = M_IMGDATA->m_height;
+    const int w = M_IMGDATA->m_width;
+    const int h = M_IMGDATA->m_height;
+
+    unsigned char *alpha = GetAlpha();
+    unsigned char *data = GetData();
+
+    for ( int y = 0; y < h; y++ )
+    {
+        for ( int x = 0; x < w; x++ )
+        {
+            *alpha++ = *data;
+            *data++ = r;
+            *data++ = g;
+            *data++ = b;
+        }
+    }
+
+    return true;
+}
+
+void wxImage::SetAlpha( unsigned char *alpha, bool static_data )
+{
+    wxCHECK_RET( IsOk(), wxT("invalid image") );
+
+    AllocExclusive();
+
+    if ( !alpha )
+    {
+        alpha = (unsigned char *)malloc(M_IMGDATA->m_width*M_IMGDATA->m_height);
+    }
+
+    if( !M_IMGDATA->m_staticAlpha )
+        free(M_IMGDATA->m_alpha);
+
+    M_IMGDATA->m_alpha = alpha;
+    M_IMGDATA->m_staticAlpha = static_data;
+}
+
+unsigned char *wxImage::GetAlpha() const
+{
+    wxCHECK_MSG( IsOk(), (unsigned char *)NULL, wxT("invalid image") );
+
+    return M_IMGDATA->m_alpha;
+}
+
+bool wxImage::HasAlpha() const
+{
+    wxCHECK_MSG( IsOk(), false, wxT("invalid image") );
+
+    // packed formats always store alpha
+    return M_IMGDATA_ANY->m_pixelFormat != wxIMAGE_PIXEL_FORMAT_RGB ||
+                M_IMGDATA_ANY->m_alpha != NULL;
+}
+
+void wxImage::InitAlpha()
+{
+    wxCHECK_RET( !HasAlpha(), wxT("image already has an alpha channel") );
+
+    // initialize memory for alpha channel
+    SetAlpha();
+
+    unsigned char *alpha = M_IMGDATA->m_alpha;
+    const size_t lenAlpha = M_IMGDATA->m_width * M_IMGDATA->m_height;
+
+    if ( HasMask() )
+    {
+        // use the mask to initialize the alpha channel.
+        const unsigned char * const alphaEnd = alpha + lenAlpha;
+
+        const unsigned char mr = M_IMGDATA->m_maskRed;
+        const unsigned char mg = M_IMGDATA->m_maskGreen;
+        const unsigned char mb = M_IMGDATA->m_maskBlue;
+        for ( unsigned char *src = M_IMGDATA->m_data;
+              alpha < alphaEnd;
+              src += 3, alpha++ )
+        {
+            *alpha = (src[0] == mr && src[1] == mg && src[2] == mb)
+                            ? wxIMAGE_ALPHA_TRANSPARENT
+                            : wxIMAGE_ALPHA_OPAQUE;
+        }
+
+        M_IMGDATA->m_hasMask = false;
+    }
+    else // no mask
+    {
+        // make the image fully opaque
+        memset(alpha, wxIMAGE_ALPHA_OPAQUE, lenAlpha);
+    }
+}
+
+void wxImage::ClearAlpha()
+{
+    wxCHECK_RET( HasAlpha(), wxT("image already doesn't have an alpha channel") );
+
+    AllocExclusive();
+
+    if ( !M_IMGDATA->m_staticAlpha )
+        free( M_IMGDATA->m_alpha );
+
+    M_IMGDATA->m_alpha = NULL;
+}
+
+
+// ----------------------------------------------------------------------------
+// pixel formats support
+// ----------------------------------------------------------------------------
+
+// The image data is converted between the formats row by row, using multiple
+// threads for big images. Conversions between the packed formats are done in
+// place if the data is not shared with any other image.
+
+namespace
+{
+
+// Table used for undoing alpha premultiplication, i.e. computing
+// value*255/alpha, using 16.16 fixed point multiplication instead of division.
+// The results are exactly the same as with the integer division, which was
+// used by wxGraphicsContext code before and is still used elsewhere, and the
+// value is returned unchanged for zero alpha.
+struct UnpremultiplyTable
+{
+    UnpremultiplyTable()
+    {
+        factor[0] = 65536;
+
+        for ( unsigned a = 1; a < 256; a++ )
+            factor[a] = (255*65536 + a - 1)/a;
+    }
+
+    wxUint32 factor[256];
+};
+
+const UnpremultiplyTable *GetUnpremultiplyTable()
+{
+    // The images can be converted from several threads at once, so rely on
+    // the compiler to initialize this static object in a thread-safe way.
+    static const UnpremultiplyTable s_table;
+
+    return &s_table;
+}
+
+// Return value*alpha/255 rounded to the nearest integer.
+inline wxUint32 Premultiply(unsigned value, unsigned alpha)
+{
+    const unsigned t = value*alpha + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+inline unsigned char
+Unpremultiply(wxUint32 value, unsigned alpha, const UnpremultiplyTable *table)
+{
+    return static_cast<unsigned char>
+           (
+            ((value & 0xff)*table->factor[alpha]) >> 16
+           );
+}
+
+struct PixelFormatContext
+{
+    // RGB data or packed pixels, depending on the corresponding format
+    const unsigned char *srcData;
+    unsigned char *dstData;
+
+    // alpha corresponding to RGB source or destination data, if any
+    const unsigned char *srcAlpha;
+    unsigned char *dstAlpha;
+
+    wxImagePixelFormat srcFormat,
+                       dstFormat;
+
+    const UnpremultiplyTable *unpremultiply;
+    int width;
+};
+
+void ConvertRowFromRGB(const unsigned char *src,
+                       const unsigned char *alpha,
+                       int n,
+                       wxImagePixelFormat format,
+                       unsigned char *dst)
+{
+    if ( format == wxIMAGE_PIXEL_FORMAT_RGBA )
+    {
+        for ( int x = 0; x < n; x++, src += 3, dst += 4 )
+        {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            dst[3] = alpha ? alpha[x] : wxIMAGE_ALPHA_OPAQUE;
+        }
+    }
+    else // wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED
+    {
+        wxUint32 * const out = reinterpret_cast<wxUint32 *>(dst);
+        if ( !alpha )
+        {
+            for ( int x = 0; x < n; x++, src += 3 )
+                out[x] = 0xff000000u | src[0] << 16 | src[1] << 8 | src[2];
+        }
+        else
+        {
+            for ( int x = 0; x < n; x++, src += 3 )
+            {
+                const unsigned a = alpha[x];
+                out[x] = wxUint32(a) << 24 |
+                         Premultiply(src[0], a) << 16 |
+                         Premultiply(src[1], a) << 8 |
+                         Premultiply(src[2], a);
+            }
+        }
+    }
+}
+
+void ConvertRowToRGB(const unsigned char *src,
+                     wxImagePixelFormat format,
+                     int n,
+                     unsigned char *dst,
+                     unsigned char *alpha,
+                     const UnpremultiplyTable *unpremultiply)
+{
+    if ( format == wxIMAGE_PIXEL_FORMAT_RGBA )
+    {
+        for ( int x = 0; x < n; x++, src += 4, dst += 3 )
+        {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            alpha[x] = src[3];
+        }
+    }
+    else // wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED
+    {
+        const wxUint32 * const in = reinterpret_cast<const wxUint32 *>(src);
+        for ( int x = 0; x < n; x++, dst += 3 )
+        {
+            const wxUint32 argb = in[x];
+            const unsigned a = argb >> 24;
+
+            alpha[x] = static_cast<unsigned char>(a);
+            dst[0] = Unpremultiply(argb >> 16, a, unpremultiply);
+            dst[1] = Unpremultiply(argb >> 8, a, unpremultiply);
+            dst[2] = Unpremultiply(argb, a, unpremultiply);
+        }
+    }
+}
+
+#ifdef wxIMAGE_USE_SSE2
+
+// Premultiply 2 RGBA pixels unpacked to 16 bit values and reorder their
+// components in B, G, R, A order, i.e. native little-endian ARGB32.
+inline __m128i PremultiplyRGBA(__m128i v)
+{
+    const __m128i alphaMask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+
+    // multiply the colour components by alpha and alpha itself by 255
+    __m128i a = _mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm_or_si128(_mm_andnot_si128(alphaMask, a),
+                     _mm_and_si128(alphaMask, _mm_set1_epi16(255)));
+
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(v, a), _mm_set1_epi16(128));
+    t = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+
+    t = _mm_shufflelo_epi16(t, _MM_SHUFFLE(3, 0, 1, 2));
+    return _mm_shufflehi_epi16(t, _MM_SHUFFLE(3, 0, 1, 2));
+}
+
+#endif // wxIMAGE_USE_SSE2
+
+// Convert between the packed formats, this works in place too.
+void ConvertPackedRow(const unsigned char *src,
+                      wxImagePixelFormat format,
+                      int n,
+                      unsigned char *dst,
+                      const UnpremultiplyTable *unpremultiply)
+{
+    int x = 0;
+    if ( format == wxIMAGE_PIXEL_FORMAT_RGBA )
+    {
+#ifdef wxIMAGE_USE_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for ( ; x + 4 <= n; x += 4 )
+        {
+            const __m128i p = _mm_loadu_si128((const __m128i *)(src + 4*x));
+            const __m128i lo = PremultiplyRGBA(_mm_unpacklo_epi8(p, zero));
+            const __m128i hi = PremultiplyRGBA(_mm_unpackhi_epi8(p, zero));
+            _mm_storeu_si128((__m128i *)(dst + 4*x), _mm_packus_epi16(lo, hi));
+        }
+#endif // wxIMAGE_USE_SSE2
+
+        wxUint32 * const out = reinterpret_cast<wxUint32 *>(dst);
+        for ( ; x < n; x++ )
+        {
+            const unsigned char * const p = src + 4*x;
+            const unsigned a = p[3];
+            out[x] = wxUint32(a) << 24 |
+                     Premultiply(p[0], a) << 16 |
+                     Premultiply(p[1], a) << 8 |
+                     Premultiply(p[2], a);
+        }
+    }
+    else // wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED
+    {
+        const wxUint32 * const in = reinterpret_cast<const wxUint32 *>(src);
+        for ( ; x < n; x++ )
+        {
+            const wxUint32 argb = in[x];
+            const unsigned a = argb >> 24;
+
+            unsigned char * const p = dst + 4*x;
+            p[0] = Unpremultiply(argb >> 16, a, unpremultiply);
+            p[1] = Unpremultiply(argb >> 8, a, unpremultiply);
+            p[2] = Unpremultiply(argb, a, unpremultiply);
+            p[3] = static_cast<unsigned char>(a);
+        }
+    }
+}
+
+void ConvertPixelFormatRows(const void *data, int y0, int y1)
+{
+    const PixelFormatContext&
+        ctx = *static_cast<const PixelFormatContext *>(data);
+
+    for ( int y = y0; y < y1; y++ )
+    {
+        const size_t offset = static_cast<size_t>(y)*ctx.width;
+
+        if ( ctx.srcFormat == wxIMAGE_PIXEL_FORMAT_RGB )
+        {
+            ConvertRowFromRGB(ctx.srcData + 3*offset,
+                              ctx.srcAlpha ? ctx.srcAlpha + offset : NULL,
+                              ctx.width,
+                              ctx.dstFormat,
+                              ctx.dstData + 4*offset);
+        }
+        else if ( ctx.dstFormat == wxIMAGE_PIXEL_FORMAT_RGB )
+        {
+            ConvertRowToRGB(ctx.srcData + 4*offset,
+                            ctx.srcFormat,
+                            ctx.width,
+                            ctx.dstData + 3*offset,
+                            ctx.dstAlpha + offset,
+                            ctx.unpremultiply);
+        }
+        else
+        {
+            ConvertPackedRow(ctx.srcData + 4*offset,
+                             ctx.srcFormat,
+                             ctx.width,
+                             ctx.dstData + 4*offset,
+                             ctx.unpremultiply);
+        }
+    }
+}
+
+} // anonymous namespace
+
+bool wxImage::Create( int width, int height, wxImagePixelFormat format, bool clear )
+{
+    UnRef();
+
+    wxImageRefData * const refData = new wxImageRefData();
+    m_refData = refData;
+
+    const size_t numPixels = static_cast<size_t>(width)*height;
+    if ( format == wxIMAGE_PIXEL_FORMAT_RGB )
+    {
+        refData->m_data = (unsigned char *) malloc( numPixels*3 );
+        refData->m_alpha = (unsigned char *) malloc( numPixels );
+    }
+    else
+    {
+        refData->m_pixels = (unsigned char *) malloc( numPixels*4 );
+    }
+
+    if ( format == wxIMAGE_PIXEL_FORMAT_RGB ? !refData->m_data || !refData->m_alpha
+                                            : !refData->m_pixels )
+    {
+        UnRef();
+        return false;
+    }
 
-    unsigned char *alpha = GetAlpha();
-    unsigned char *data = GetData();
+    refData->m_pixelFormat = format;
+    refData->m_width = width;
+    refData->m_height = height;
+    refData->m_ok = true;
 
-    for ( int y = 0; y < h; y++ )
+    if ( clear )
     {
-        for ( int x = 0; x < w; x++ )
+        if ( format == wxIMAGE_PIXEL_FORMAT_RGB )
         {
-            *alpha++ = *data;
-            *data++ = r;
-            *data++ = g;
-            *data++ = b;
+            memset(refData->m_data, 0, numPixels*3);
+            memset(refData->m_alpha, wxIMAGE_ALPHA_TRANSPARENT, numPixels);
+        }
+        else
+        {
+            memset(refData->m_pixels, 0, numPixels*4);
         }
     }
 
     return true;
 }
 
-void wxImage::SetAlpha( unsigned char *alpha, bool static_data )
+bool wxImage::SetPixelFormat(wxImagePixelFormat format)
 {
-    wxCHECK_RET( IsOk(), wxT("invalid image") );
+    wxCHECK_MSG( IsOk(), false, wxT("invalid image") );
 
-    AllocExclusive();
+    wxImageRefData * const refData = M_IMGDATA_ANY;
+    if ( format == refData->m_pixelFormat )
+        return true;
 
-    if ( !alpha )
+    if ( refData->GetRefCount() == 1 )
+        return ConvertImagePixelFormat(refData, format, refData);
+
+    // Don't modify the data shared with the other images, they must continue
+    // to use it in its current format.
+    wxImageRefData * const refDataNew = new wxImageRefData();
+    CopyImageProperties(refDataNew, refData);
+
+    if ( !ConvertImagePixelFormat(refData, format, refDataNew) )
     {
-        alpha = (unsigned char *)malloc(M_IMGDATA->m_width*M_IMGDATA->m_height);
+        refDataNew->DecRef();
+        return false;
     }
 
-    if( !M_IMGDATA->m_staticAlpha )
-        free(M_IMGDATA->m_alpha);
+    UnRef();
+    m_refData = refDataNew;
 
-    M_IMGDATA->m_alpha = alpha;
-    M_IMGDATA->m_staticAlpha = static_data;
+    return true;
 }
 
-unsigned char *wxImage::GetAlpha() const
+wxImagePixelFormat wxImage::GetPixelFormat() const
 {
-    wxCHECK_MSG( IsOk(), (unsigned char *)NULL, wxT("invalid image") );
+    wxCHECK_MSG( IsOk(), wxIMAGE_PIXEL_FORMAT_RGB, wxT("invalid image") );
 
-    return M_IMGDATA->m_alpha;
+    return M_IMGDATA_ANY->m_pixelFormat;
 }
 
-void wxImage::InitAlpha()
+unsigned char *wxImage::GetPixels() const
 {
-    wxCHECK_RET( !HasAlpha(), wxT("image already has an alpha channel") );
+    wxCHECK_MSG( IsOk(), NULL, wxT("invalid image") );
 
-    // initialize memory for alpha channel
-    SetAlpha();
+    return M_IMGDATA_ANY->m_pixels;
+}
 
-    unsigned char *alpha = M_IMGDATA->m_alpha;
-    const size_t lenAlpha = M_IMGDATA->m_width * M_IMGDATA->m_height;
+// Convert the pixels of refData to the given format and store them in
+// refDataNew, which may be the same object as refData to convert it in place.
+// Otherwise refData is left unchanged.
+static bool ConvertImagePixelFormat(wxImageRefData *refData,
+                                    wxImagePixelFormat format,
+                                    wxImageRefData *refDataNew)
+{
+    const bool inPlace = refDataNew == refData;
 
-    if ( HasMask() )
-    {
-        // use the mask to initialize the alpha channel.
-        const unsigned char * const alphaEnd = alpha + lenAlpha;
+    const size_t numPixels = static_cast<size_t>(refData->m_width)*
+                                refData->m_height;
 
-        const unsigned char mr = M_IMGDATA->m_maskRed;
-        const unsigned char mg = M_IMGDATA->m_maskGreen;
-        const unsigned char mb = M_IMGDATA->m_maskBlue;
-        for ( unsigned char *src = M_IMGDATA->m_data;
-              alpha < alphaEnd;
-              src += 3, alpha++ )
-        {
-            *alpha = (src[0] == mr && src[1] == mg && src[2] == mb)
-                            ? wxIMAGE_ALPHA_TRANSPARENT
-                            : wxIMAGE_ALPHA_OPAQUE;
-        }
+    PixelFormatContext ctx;
+    ctx.srcFormat = refData->m_pixelFormat;
+    ctx.dstFormat = format;
+    ctx.width = refData->m_width;
+    ctx.unpremultiply = GetUnpremultiplyTable();
+    ctx.dstAlpha = NULL;
 
-        M_IMGDATA->m_hasMask = false;
+    if ( ctx.srcFormat == wxIMAGE_PIXEL_FORMAT_RGB )
+    {
+        ctx.srcData = refData->m_data;
+        ctx.srcAlpha = refData->m_alpha;
     }
-    else // no mask
+    else
     {
-        // make the image fully opaque
-        memset(alpha, wxIMAGE_ALPHA_OPAQUE, lenAlpha);
+        ctx.srcData = refData->m_pixels;
+        ctx.srcAlpha = NULL;
     }
-}
 
-void wxImage::ClearAlpha()
-{
-    wxCHECK_RET( HasAlpha(), wxT("image already doesn't have an alpha channel") );
+    if ( format == wxIMAGE_PIXEL_FORMAT_RGB )
+    {
+        // alpha is always used by the packed formats, so keep it
+        ctx.dstData = (unsigned char *) malloc( numPixels*3 );
+        ctx.dstAlpha = (unsigned char *) malloc( numPixels );
+    }
+    else if ( ctx.srcFormat != wxIMAGE_PIXEL_FORMAT_RGB && inPlace )
+    {
+        ctx.dstData = refData->m_pixels;
+    }
+    else
+    {
+        ctx.dstData = (unsigned char *) malloc( numPixels*4 );
+    }
 
-    AllocExclusive();
+    if ( !ctx.dstData ||
+            (format == wxIMAGE_PIXEL_FORMAT_RGB && !ctx.dstAlpha) )
+    {
+        free(ctx.dstData);
+        free(ctx.dstAlpha);
 
-    if ( !M_IMGDATA->m_staticAlpha )
-        free( M_IMGDATA->m_alpha );
+        wxFAIL_MSG( wxT("out of memory converting image pixel format") );
+        return false;
+    }
 
-    M_IMGDATA->m_alpha = NULL;
-}
+    wxProcessImageRows(ConvertPixelFormatRows, &ctx,
+                       refData->m_height, numPixels);
+
+    // otherwise the old data is still used by the other images
+    if ( inPlace )
+    {
+        if ( refData->m_pixelFormat == wxIMAGE_PIXEL_FORMAT_RGB )
+        {
+            if ( !refData->m_static )
+                free(refData->m_data);
+            if ( !refData->m_staticAlpha )
+                free(refData->m_alpha);
+
+            refData->m_data =
+            refData->m_alpha = NULL;
+            refData->m_static =
+            refData->m_staticAlpha = false;
+        }
+        else if ( refData->m_pixels != ctx.dstData )
+        {
+            free(refData->m_pixels);
+            refData->m_pixels = NULL;
+        }
+    }
 
+    refDataNew->m_pixelFormat = format;
+    if ( format == wxIMAGE_PIXEL_FORMAT_RGB )
+    {
+        refDataNew->m_data = ctx.dstData;
+        refDataNew->m_alpha = ctx.dstAlpha;
+    }
+    else
+    {
+        refDataNew->m_pixels = ctx.dstData;
+    }
+
+    return true;
+}
 
 // ----------------------------------------------------------------------------
 // mask support
@@ -2262,21 +4086,21 @@ void wxImage::SetMaskColour( unsigned char r, unsigned char g, unsigned char b )
 
     AllocExclusive();
 
-    M_IMGDATA->m_maskRed = r;
-    M_IMGDATA->m_maskGreen = g;
-    M_IMGDATA->m_maskBlue = b;
-    M_IMGDATA->m_hasMask = true;
+    M_IMGDATA_ANY->m_maskRed = r;
+    M_IMGDATA_ANY->m_maskGreen = g;
+    M_IMGDATA_ANY->m_maskBlue = b;
+    M_IMGDATA_ANY->m_hasMask = true;
 }
 
 bool wxImage::GetOrFindMaskColour( unsigned char *r, unsigned char *g, unsigned char *b ) const
 {
     wxCHECK_MSG( IsOk(), false, wxT("invalid image") );
 
-    if (M_IMGDATA->m_hasMask)
+    if (M_IMGDATA_ANY->m_hasMask)
     {
-        if (r) *r = M_IMGDATA->m_maskRed;
-        if (g) *g = M_IMGDATA->m_maskGreen;
-        if (b) *b = M_IMGDATA->m_maskBlue;
+        if (r) *r = M_IMGDATA_ANY->m_maskRed;
+        if (g) *g = M_IMGDATA_ANY->m_maskGreen;
+        if (b) *b = M_IMGDATA_ANY->m_maskBlue;
         return true;
     }
     else
@@ -2290,21 +4114,21 @@ unsigned char wxImage::GetMaskRed() const
 {
     wxCHECK_MSG( IsOk(), 0, wxT("invalid image") );
 
-    return M_IMGDATA->m_maskRed;
+    return M_IMGDATA_ANY->m_maskRed;
 }
 
 unsigned char wxImage::GetMaskGreen() const
 {
     wxCHECK_MSG( IsOk(), 0, wxT("invalid image") );
 
-    return M_IMGDATA->m_maskGreen;
+    return M_IMGDATA_ANY->m_maskGreen;
 }
 
 unsigned char wxImage::GetMaskBlue() const
 {
     wxCHECK_MSG( IsOk(), 0, wxT("invalid image") );
 
-    return M_IMGDATA->m_maskBlue;
+    return M_IMGDATA_ANY->m_maskBlue;
 }
 
 void wxImage::SetMask( bool mask )
@@ -2313,14 +4137,14 @@ void wxImage::SetMask( bool mask )
 
     AllocExclusive();
 
-    M_IMGDATA->m_hasMask = mask;
+    M_IMGDATA_ANY->m_hasMask = mask;
 }
 
 bool wxImage::HasMask() const
 {
     wxCHECK_MSG( IsOk(), false, wxT("invalid image") );
 
-    return M_IMGDATA->m_hasMask;
+    return M_IMGDATA_ANY->m_hasMask;
 }
 
 bool wxImage::IsTransparent(int x, int y, unsigned char threshold) const
@@ -2374,26 +4198,20 @@ bool wxImage::SetMaskFromImage(const wxImage& mask,
 
     AllocExclusive();
 
-    unsigned char *imgdata = GetData();
-    unsigned char *maskdata = mask.GetData();
+    ColourOpContext ctx;
+    ctx.src = mask.GetData();
+    ctx.dst = GetData();
+    ctx.width = GetWidth();
+    ctx.replace = true;
+    ctx.from[0] = mr;
+    ctx.from[1] = mg;
+    ctx.from[2] = mb;
+    ctx.to[0] = r;
+    ctx.to[1] = g;
+    ctx.to[2] = b;
 
-    const int w = GetWidth();
     const int h = GetHeight();
-
-    for (int j = 0; j < h; j++)
-    {
-        for (int i = 0; i < w; i++)
-        {
-            if ((maskdata[0] == mr) && (maskdata[1]  == mg) && (maskdata[2] == mb))
-            {
-                imgdata[0] = r;
-                imgdata[1] = g;
-                imgdata[2] = b;
-            }
-            imgdata  += 3;
-            maskdata += 3;
-        }
-    }
+    wxProcessImageRows(ColourOpRows, &ctx, h, static_cast<size_t>(ctx.width)*h);
 
     SetMaskColour(r, g, b);
     SetMask(true);
@@ -2468,14 +4286,14 @@ bool wxImage::HasPalette() const
     if (!IsOk())
         return false;
 
-    return M_IMGDATA->m_palette.IsOk();
+    return M_IMGDATA_ANY->m_palette.IsOk();
 }
 
 const wxPalette& wxImage::GetPalette() const
 {
     wxCHECK_MSG( IsOk(), wxNullPalette, wxT("invalid image") );
 
-    return M_IMGDATA->m_palette;
+    return M_IMGDATA_ANY->m_palette;
 }
 
 void wxImage::SetPalette(const wxPalette& palette)
@@ -2484,7 +4302,7 @@ void wxImage::SetPalette(const wxPalette& palette)
 
     AllocExclusive();
 
-    M_IMGDATA->m_palette = palette;
+    M_IMGDATA_ANY->m_palette = palette;
 }
 
 #endif // wxUSE_PALETTE
@@ -2497,16 +4315,16 @@ void wxImage::SetOption(const wxString& name, const wxString& value)
 {
     AllocExclusive();
 
-    int idx = M_IMGDATA->m_optionNames.Index(name, false);
+    int idx = M_IMGDATA_ANY->m_optionNames.Index(name, false);
     if ( idx == wxNOT_FOUND )
     {
-        M_IMGDATA->m_optionNames.Add(name);
-        M_IMGDATA->m_optionValues.Add(value);
+        M_IMGDATA_ANY->m_optionNames.Add(name);
+        M_IMGDATA_ANY->m_optionValues.Add(value);
     }
     else
     {
-        M_IMGDATA->m_optionNames[idx] = name;
-        M_IMGDATA->m_optionValues[idx] = value;
+        M_IMGDATA_ANY->m_optionNames[idx] = name;
+        M_IMGDATA_ANY->m_optionValues[idx] = value;
     }
 }
 
@@ -2519,14 +4337,14 @@ void wxImage::SetOption(const wxString& name, int value)
 
 wxString wxImage::GetOption(const wxString& name) const
 {
-    if ( !M_IMGDATA )
+    if ( !M_IMGDATA_ANY )
         return wxEmptyString;
 
-    int idx = M_IMGDATA->m_optionNames.Index(name, false);
+    int idx = M_IMGDATA_ANY->m_optionNames.Index(name, false);
     if ( idx == wxNOT_FOUND )
         return wxEmptyString;
     else
-        return M_IMGDATA->m_optionValues[idx];
+        return M_IMGDATA_ANY->m_optionValues[idx];
 }
 
 int wxImage::GetOptionInt(const wxString& name) const
@@ -2536,7 +4354,7 @@ int wxImage::GetOptionInt(const wxString& name) const
 
 bool wxImage::HasOption(const wxString& name) const
 {
-    return M_IMGDATA ? M_IMGDATA->m_optionNames.Index(name, false) != wxNOT_FOUND
+    return M_IMGDATA_ANY ? M_IMGDATA_ANY->m_optionNames.Index(name, false) != wxNOT_FOUND
                      : false;
 }
 
@@ -2560,12 +4378,12 @@ void wxImage::SetLoadFlags(int flags)
 {
     AllocExclusive();
 
-    M_IMGDATA->m_loadFlags = flags;
+    M_IMGDATA_ANY->m_loadFlags = flags;
 }
 
 int wxImage::GetLoadFlags() const
 {
-    return M_IMGDATA ? M_IMGDATA->m_loadFlags : wxImageRefData::sm_defaultLoadFlags;
+    return M_IMGDATA_ANY ? M_IMGDATA_ANY->m_loadFlags : wxImageRefData::sm_defaultLoadFlags;
 }
 
 // Under Windows we can load wxImage not only from files but also from
@@ -2652,6 +4470,39 @@ static wxImage LoadImageFromResource(const wxString &name, wxBitmapType type)
 
 #endif // HAS_LOAD_FROM_RESOURCE
 
+#if HAS_FILE_STREAMS
+
+namespace
+{
+
+// Common part of LoadFile() overloads taking either the type or the MIME type.
+template <typename T>
+bool
+LoadImageFromFile(wxImage& image, const wxString& filename, const T& type, int index)
+{
+#if wxUSE_FILE
+    wxMappedFileInputStream stream(filename, wxMAPPED_FILE_ACCESS_SEQUENTIAL);
+    if ( !stream.IsOk() )
+        return false;
+
+    // When the file is mapped into memory, the handlers can read from it
+    // directly and there is no need to copy the data into a buffer first.
+    if ( stream.IsMapped() )
+        return image.LoadFile(stream, type, index);
+#else // !wxUSE_FILE
+    wxImageFileInputStream stream(filename);
+    if ( !stream.IsOk() )
+        return false;
+#endif // wxUSE_FILE/!wxUSE_FILE
+
+    wxBufferedInputStream bstream( stream );
+    return image.LoadFile(bstream, type, index);
+}
+
+} // anonymous namespace
+
+#endif // HAS_FILE_STREAMS
+
 bool wxImage::LoadFile( const wxString& filename,
                         wxBitmapType type,
                         int WXUNUSED_UNLESS_STREAMS(index) )
@@ -2671,13 +4522,8 @@ bool wxImage::LoadFile( const wxString& filename,
 #endif // HAS_LOAD_FROM_RESOURCE
 
 #if HAS_FILE_STREAMS
-    wxImageFileInputStream stream(filename);
-    if ( stream.IsOk() )
-    {
-        wxBufferedInputStream bstream( stream );
-        if ( LoadFile(bstream, type, index) )
-            return true;
-    }
+    if ( LoadImageFromFile(*this, filename, type, index) )
+        return true;
 
     wxLogError(_("Failed to load image from file \"%s\"."), filename);
 #endif // HAS_FILE_STREAMS
@@ -2690,13 +4536,8 @@ bool wxImage::LoadFile( const wxString& WXUNUSED_UNLESS_STREAMS(filename),
                         int WXUNUSED_UNLESS_STREAMS(index) )
 {
 #if HAS_FILE_STREAMS
-    wxImageFileInputStream stream(filename);
-    if ( stream.IsOk() )
-    {
-        wxBufferedInputStream bstream( stream );
-        if ( LoadFile(bstream, mimetype, index) )
-            return true;
-    }
+    if ( LoadImageFromFile(*this, filename, mimetype, index) )
+        return true;
 
     wxLogError(_("Failed to load image from file \"%s\"."), filename);
 #endif // HAS_FILE_STREAMS
@@ -2897,7 +4738,7 @@ bool wxImage::DoLoad(wxImageHandler& handler, wxInputStream& stream, int index)
     }
 
     // Set this after Rescale, which currently does not preserve it
-    M_IMGDATA->m_type = handler.GetType();
+    M_IMGDATA_ANY->m_type = handler.GetType();
 
     return true;
 }
@@ -3325,36 +5166,21 @@ void wxImage::RotateHue(double angle)
 {
     AllocExclusive();
 
-    unsigned long count;
-    wxImage::HSVValue hsv;
-    wxImage::RGBValue rgb;
-
     wxASSERT (angle >= -1.0 && angle <= 1.0);
-    count = M_IMGDATA->m_width * M_IMGDATA->m_height;
-    if ( count > 0 && !wxIsNullDouble(angle) )
-    {
-        unsigned char* srcBytePtr;
-        unsigned char* dstBytePtr;
-        srcBytePtr = M_IMGDATA->m_data;
-        dstBytePtr = srcBytePtr;
-        do
-        {
-            rgb.red = *srcBytePtr++;
-            rgb.green = *srcBytePtr++;
-            rgb.blue = *srcBytePtr++;
-            hsv = RGBtoHSV(rgb);
 
-            hsv.hue = hsv.hue + angle;
-            if (hsv.hue > 1.0)
-                hsv.hue = hsv.hue - 1.0;
-            else if (hsv.hue < 0.0)
-                hsv.hue = hsv.hue + 1.0;
+    const int w = M_IMGDATA->m_width;
+    const int h = M_IMGDATA->m_height;
+    if ( w > 0 && h > 0 && !wxIsNullDouble(angle) )
+    {
+        ColourOpContext ctx;
+        ctx.src =
+        ctx.dst = M_IMGDATA->m_data;
+        ctx.width = w;
+        ctx.convert = RotateHueRow;
+        ctx.hueAngle = wxRound(fmod(angle, 1.0)*HUE_FULL_TURN);
+        ctx.hueReciprocals = GetHueReciprocalTable();
 
-            rgb = HSVtoRGB(hsv);
-            *dstBytePtr++ = rgb.red;
-            *dstBytePtr++ = rgb.green;
-            *dstBytePtr++ = rgb.blue;
-        } while (--count != 0);
+        wxProcessImageRows(ColourOpRows, &ctx, h, static_cast<size_t>(w)*h);
     }
 }
 
@@ -3409,62 +5235,240 @@ bool wxImageHandler::CallDoCanRead(wxInputStream& stream)
     if ( !stream.IsSeekable() )
         return false;        // can't test unseekable stream
 
-    wxFileOffset posOld = stream.TellI();
-    bool ok = DoCanRead(stream);
+    wxFileOffset posOld = stream.TellI();
+    bool ok = DoCanRead(stream);
+
+    // restore the old position to be able to test other formats and so on
+    if ( stream.SeekI(posOld) == wxInvalidOffset )
+    {
+        wxLogDebug(wxT("Failed to rewind the stream in wxImageHandler!"));
+
+        // reading would fail anyhow as we're not at the right position
+        return false;
+    }
+
+    return ok;
+}
+
+#endif // wxUSE_STREAMS
+
+/* static */
+wxImageResolution
+wxImageHandler::GetResolutionFromOptions(const wxImage& image, int *x, int *y)
+{
+    wxCHECK_MSG( x && y, wxIMAGE_RESOLUTION_NONE, wxT("NULL pointer") );
+
+    if ( image.HasOption(wxIMAGE_OPTION_RESOLUTIONX) &&
+         image.HasOption(wxIMAGE_OPTION_RESOLUTIONY) )
+    {
+        *x = image.GetOptionInt(wxIMAGE_OPTION_RESOLUTIONX);
+        *y = image.GetOptionInt(wxIMAGE_OPTION_RESOLUTIONY);
+    }
+    else if ( image.HasOption(wxIMAGE_OPTION_RESOLUTION) )
+    {
+        *x =
+        *y = image.GetOptionInt(wxIMAGE_OPTION_RESOLUTION);
+    }
+    else // no resolution options specified
+    {
+        *x =
+        *y = 0;
+
+        return wxIMAGE_RESOLUTION_NONE;
+    }
+
+    // get the resolution unit too
+    int resUnit = image.GetOptionInt(wxIMAGE_OPTION_RESOLUTIONUNIT);
+    if ( !resUnit )
+    {
+        // this is the default
+        resUnit = wxIMAGE_RESOLUTION_INCHES;
+    }
+
+    return (wxImageResolution)resUnit;
+}
+
+// ----------------------------------------------------------------------------
+// image histogram stuff
+// ----------------------------------------------------------------------------
+
+// For big images, the colours are counted using a bitmap directly indexed by
+// the 24 bit keys returned by wxImageHistogram::MakeKey() and the array of
+// the pixel counts of the colours present in the image, indexed by the rank
+// of the colour in this bitmap. The bitmap is allocated using calloc(), so
+// that only its parts corresponding to the colours actually used are really
+// touched. For small images and if there is not enough memory for it, hash
+// tables are still used.
+//
+// When using several threads, each of them processes all pixels but handles
+// only the colours with the red component in the range assigned to it, so
+// that the threads never update the same memory.
+
+namespace
+{
+
+// The number of all possible RGB colours.
+const wxUint32 NUM_COLOURS = 1u << 24;
+
+// The minimal number of pixels for which the bitmap is used.
+const unsigned long DENSE_COLOURS_MIN_PIXELS = 16384;
+
+inline wxUint32 MakeColourKey(const unsigned char *p)
+{
+    return (static_cast<wxUint32>(p[0]) << 16) | (p[1] << 8) | p[2];
+}
+
+inline int CountBits(wxUint32 x)
+{
+    x = x - ((x >> 1) & 0x55555555);
+    x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+    x = (x + (x >> 4)) & 0x0f0f0f0f;
+    return static_cast<int>((x * 0x01010101) >> 24);
+}
+
+// Set of the colours used in the image.
+class ColourPresenceMap
+{
+public:
+    ColourPresenceMap()
+    {
+        m_bits = static_cast<wxUint32 *>(calloc(NUM_WORDS, sizeof(wxUint32)));
+        m_ranks = NULL;
+    }
+
+    ~ColourPresenceMap()
+    {
+        free(m_ranks);
+        free(m_bits);
+    }
+
+    bool IsOk() const { return m_bits != NULL; }
+
+    // Add the colour to the set and return true if it was not there yet.
+    bool Add(wxUint32 key)
+    {
+        wxUint32& word = m_bits[key >> 5];
+        const wxUint32 bit = 1u << (key & 31);
+        if ( word & bit )
+            return false;
+
+        word |= bit;
+        return true;
+    }
+
+    bool Has(wxUint32 key) const
+    {
+        return (m_bits[key >> 5] & (1u << (key & 31))) != 0;
+    }
+
+    // Return the bits corresponding to the 32 colours starting at the given
+    // one, which must be a multiple of 32.
+    wxUint32 GetWord(wxUint32 key) const { return m_bits[key >> 5]; }
+
+    // Compute the ranks of all the colours in the set, must be called before
+    // using GetRank() and the set must not be modified after calling it.
+    bool ComputeRanks()
+    {
+        m_ranks = static_cast<wxUint32 *>(malloc(NUM_WORDS*sizeof(wxUint32)));
+        if ( !m_ranks )
+            return false;
+
+        wxUint32 rank = 0;
+        for ( wxUint32 n = 0; n < NUM_WORDS; n++ )
+        {
+            m_ranks[n] = rank;
+            rank += CountBits(m_bits[n]);
+        }
+
+        return true;
+    }
+
+    // Return the number of the colours in the set with smaller keys.
+    wxUint32 GetRank(wxUint32 key) const
+    {
+        const wxUint32 before = (1u << (key & 31)) - 1;
+        return m_ranks[key >> 5] + CountBits(m_bits[key >> 5] & before);
+    }
+
+private:
+    static const wxUint32 NUM_WORDS = NUM_COLOURS / 32;
+
+    wxUint32 *m_bits;
+
+    // the number of colours in all the words preceding the given one
+    wxUint32 *m_ranks;
 
-    // restore the old position to be able to test other formats and so on
-    if ( stream.SeekI(posOld) == wxInvalidOffset )
-    {
-        wxLogDebug(wxT("Failed to rewind the stream in wxImageHandler!"));
+    wxDECLARE_NO_COPY_CLASS(ColourPresenceMap);
+};
 
-        // reading would fail anyhow as we're not at the right position
-        return false;
-    }
+struct ColourCountContext
+{
+    const unsigned char *data;
+    size_t size;
 
-    return ok;
-}
+    ColourPresenceMap *presence;
 
-#endif // wxUSE_STREAMS
+    // the number of the new colours found by the band starting at the given
+    // red value, used if counts is NULL
+    unsigned long *numColours;
 
-/* static */
-wxImageResolution
-wxImageHandler::GetResolutionFromOptions(const wxImage& image, int *x, int *y)
+    // the number of pixels of each colour present in the image, indexed by
+    // its rank in the presence map, if non-NULL
+    unsigned long *counts;
+};
+
+// Process the colours with the red component in [r0, r1) range: either add
+// them to the presence map or count the pixels of each of them.
+void CountColoursBand(const void *data, int r0, int r1)
 {
-    wxCHECK_MSG( x && y, wxIMAGE_RESOLUTION_NONE, wxT("NULL pointer") );
+    const ColourCountContext& ctx = *static_cast<const ColourCountContext *>(data);
 
-    if ( image.HasOption(wxIMAGE_OPTION_RESOLUTIONX) &&
-         image.HasOption(wxIMAGE_OPTION_RESOLUTIONY) )
-    {
-        *x = image.GetOptionInt(wxIMAGE_OPTION_RESOLUTIONX);
-        *y = image.GetOptionInt(wxIMAGE_OPTION_RESOLUTIONY);
-    }
-    else if ( image.HasOption(wxIMAGE_OPTION_RESOLUTION) )
+    const unsigned char *p = ctx.data;
+    if ( ctx.counts )
     {
-        *x =
-        *y = image.GetOptionInt(wxIMAGE_OPTION_RESOLUTION);
+        for ( size_t n = 0; n < ctx.size; n++, p += 3 )
+        {
+            if ( p[0] >= r0 && p[0] < r1 )
+                ctx.counts[ctx.presence->GetRank(MakeColourKey(p))]++;
+        }
     }
-    else // no resolution options specified
+    else
     {
-        *x =
-        *y = 0;
+        unsigned long numColours = 0;
+        for ( size_t n = 0; n < ctx.size; n++, p += 3 )
+        {
+            if ( p[0] >= r0 && p[0] < r1 && ctx.presence->Add(MakeColourKey(p)) )
+                numColours++;
+        }
 
-        return wxIMAGE_RESOLUTION_NONE;
+        ctx.numColours[r0] = numColours;
     }
+}
 
-    // get the resolution unit too
-    int resUnit = image.GetOptionInt(wxIMAGE_OPTION_RESOLUTIONUNIT);
-    if ( !resUnit )
-    {
-        // this is the default
-        resUnit = wxIMAGE_RESOLUTION_INCHES;
-    }
+// Fill the presence map with all colours used in the image and return their
+// number.
+unsigned long
+FillColourPresenceMap(const wxImage& image, ColourPresenceMap& presence)
+{
+    unsigned long numColours[256] = { 0 };
 
-    return (wxImageResolution)resUnit;
+    ColourCountContext ctx;
+    ctx.data = image.GetData();
+    ctx.size = static_cast<size_t>(image.GetWidth())*image.GetHeight();
+    ctx.presence = &presence;
+    ctx.numColours = numColours;
+    ctx.counts = NULL;
+
+    wxProcessImageRows(CountColoursBand, &ctx, 256, ctx.size);
+
+    unsigned long total = 0;
+    for ( int n = 0; n < 256; n++ )
+        total += numColours[n];
+
+    return total;
 }
 
-// ----------------------------------------------------------------------------
-// image histogram stuff
-// ----------------------------------------------------------------------------
+} // anonymous namespace
 
 bool
 wxImage::FindFirstUnusedColour(unsigned char *r,
@@ -3474,6 +5478,44 @@ wxImage::FindFirstUnusedColour(unsigned char *r,
                                unsigned char g2,
                                unsigned char b2) const
 {
+    const unsigned long size = static_cast<unsigned long>(GetWidth()) * GetHeight();
+    if ( size >= DENSE_COLOURS_MIN_PIXELS )
+    {
+        ColourPresenceMap presence;
+        if ( presence.IsOk() )
+        {
+            FillColourPresenceMap(*this, presence);
+
+            // This loop must be kept in sync with the one in
+            // wxImageHistogram::FindFirstUnusedColour().
+            while ( presence.Has(wxImageHistogram::MakeKey(r2, g2, b2)) )
+            {
+                r2++;
+                if ( r2 >= 255 )
+                {
+                    r2 = 0;
+                    g2++;
+                    if ( g2 >= 255 )
+                    {
+                        g2 = 0;
+                        b2++;
+                        if ( b2 >= 255 )
+                            return false;
+                    }
+                }
+            }
+
+            if ( r )
+                *r = r2;
+            if ( g )
+                *g = g2;
+            if ( b )
+                *b = b2;
+
+            return true;
+        }
+    }
+
     wxImageHistogram histogram;
 
     ComputeHistogram(histogram);
@@ -3492,8 +5534,6 @@ wxImage::FindFirstUnusedColour(unsigned char *r,
 //
 unsigned long wxImage::CountColours( unsigned long stopafter ) const
 {
-    wxHashTable h;
-    wxObject dummy;
     unsigned char *p;
     unsigned long size, nentries;
 
@@ -3501,6 +5541,29 @@ unsigned long wxImage::CountColours( unsigned long stopafter ) const
     size = static_cast<unsigned long>(GetWidth()) * GetHeight();
     nentries = 0;
 
+    if ( size >= DENSE_COLOURS_MIN_PIXELS )
+    {
+        ColourPresenceMap presence;
+        if ( presence.IsOk() )
+        {
+            // If we can't stop early, count the colours in parallel.
+            if ( stopafter >= size )
+                return FillColourPresenceMap(*this, presence);
+
+            for (unsigned long j = 0; (j < size) && (nentries <= stopafter) ; j++)
+            {
+                if ( presence.Add(MakeColourKey(p)) )
+                    nentries++;
+                p += 3;
+            }
+
+            return nentries;
+        }
+    }
+
+    wxHashTable h;
+    wxObject dummy;
+
     for (unsigned long j = 0; (j < size) && (nentries <= stopafter) ; j++)
     {
         unsigned char r, g, b;
@@ -3530,6 +5593,76 @@ unsigned long wxImage::ComputeHistogram( wxImageHistogram &h ) const
 
     const unsigned long size = static_cast<unsigned long>(GetWidth()) * GetHeight();
 
+    if ( size >= DENSE_COLOURS_MIN_PIXELS )
+    {
+        ColourPresenceMap presence;
+        if ( presence.IsOk() )
+        {
+            // Find all colours in the order of their first appearance, which
+            // determines their indices, and then count their pixels.
+            wxVector<wxUint32> colours;
+            for ( unsigned long n = 0; n < size; n++, p += 3 )
+            {
+                const wxUint32 key = MakeColourKey(p);
+                if ( presence.Add(key) )
+                    colours.push_back(key);
+            }
+
+            // Both arrays are indexed by the rank of the colour.
+            const size_t numColours = colours.size();
+            unsigned long * const counts = presence.ComputeRanks()
+                ? static_cast<unsigned long *>(calloc(numColours,
+                                                      sizeof(unsigned long)))
+                : NULL;
+            unsigned long * const indices = counts
+                ? static_cast<unsigned long *>(malloc(numColours*
+                                                      sizeof(unsigned long)))
+                : NULL;
+            if ( indices )
+            {
+                ColourCountContext ctx;
+                ctx.data = GetData();
+                ctx.size = size;
+                ctx.presence = &presence;
+                ctx.numColours = NULL;
+                ctx.counts = counts;
+
+                wxProcessImageRows(CountColoursBand, &ctx, 256, size);
+
+                for ( size_t n = 0; n < numColours; n++ )
+                    indices[presence.GetRank(colours[n])] = n;
+
+                // Fill the histogram in the order of the keys, this is much
+                // faster than doing it in the order of the indices.
+                size_t rank = 0;
+                for ( wxUint32 key = 0; rank < numColours; key += 32 )
+                {
+                    wxUint32 word = presence.GetWord(key);
+                    for ( wxUint32 bit = 0; word; bit++, word >>= 1 )
+                    {
+                        if ( !(word & 1) )
+                            continue;
+
+                        wxImageHistogramEntry& entry = h[key + bit];
+                        entry.index = indices[rank];
+                        entry.value = counts[rank];
+                        rank++;
+                    }
+                }
+
+                nentries = numColours;
+            }
+
+            free(indices);
+            free(counts);
+
+            if ( nentries )
+                return nentries;
+
+            p = GetData();
+        }
+    }
+
     for ( unsigned long n = 0; n < size; n++ )
     {
         unsigned char r, g, b;
@@ -3550,8 +5683,6 @@ unsigned long wxImage::ComputeHistogram( wxImageHistogram &h ) const
  * Rotation code by Carlos Moreno
  */
 
-static const double wxROTATE_EPSILON = 1e-10;
-
 // Auxiliary function to rotate a point (x,y) with respect to point p0
 // make it inline and use a straight return to facilitate optimization
 // also, the function receives the sine and cosine of the angle to avoid
@@ -3573,6 +5704,232 @@ wxRotatePoint(double x, double y, double cos_angle, double sin_angle,
     return wxRotatePoint (wxRealPoint(x,y), cos_angle, sin_angle, p0);
 }
 
+namespace
+{
+
+// Rotation by an arbitrary angle steps along the destination rows using the
+// source coordinates in 32.32 fixed point format, so that only the starting
+// point of each row needs to be computed using floating point arithmetic.
+const int ROTATE_FIXED_SHIFT = 32;
+const wxInt64 ROTATE_FIXED_ONE = static_cast<wxInt64>(1) << ROTATE_FIXED_SHIFT;
+
+// The number of bits in the fractional parts of the coordinates used as the
+// bilinear interpolation weights: the weighted sum of the four pixels, of
+// at most 255 << (2*ROTATE_WEIGHT_BITS), must fit into 32 bits.
+const int ROTATE_WEIGHT_BITS = 11;
+const unsigned ROTATE_WEIGHT_ONE = 1u << ROTATE_WEIGHT_BITS;
+
+inline wxInt64 ToRotateFixed(double x)
+{
+    return static_cast<wxInt64>(floor(x*ROTATE_FIXED_ONE + 0.5));
+}
+
+struct RotateContext
+{
+    const unsigned char *srcData,
+                        *srcAlpha;
+    int srcWidth,
+        srcHeight;
+
+    unsigned char *dstData,
+                  *dstAlpha;
+    int dstWidth;
+
+    // the centre of rotation, the sine and cosine of the inverse rotation
+    // angle and the position of the top left corner of the rotated image
+    wxRealPoint p0;
+    double cos_angle,
+           sin_angle;
+    int x1a,
+        y1a;
+
+    unsigned char blank[3];
+};
+
+// Compute the source coordinates of the first pixel of the given destination
+// row and their increments when moving to the next pixel in this row.
+inline void
+GetRotateRowStart(const RotateContext& ctx, int y,
+                  wxInt64& fx, wxInt64& fy, wxInt64& stepX, wxInt64& stepY)
+{
+    const wxRealPoint src = wxRotatePoint(ctx.x1a, y + ctx.y1a,
+                                          ctx.cos_angle, -ctx.sin_angle,
+                                          ctx.p0);
+    fx = ToRotateFixed(src.x);
+    fy = ToRotateFixed(src.y);
+    stepX = ToRotateFixed(ctx.cos_angle);
+    stepY = ToRotateFixed(-ctx.sin_angle);
+}
+
+// Return true if the fractional part of the given coordinate is so close to
+// 1/2 that rounding it could be affected by the fixed point arithmetic errors.
+//
+// The error of each of the steps is at most 2^-33, so using 2^-12 as margin
+// is enough for the images up to 2^21 pixels wide.
+inline bool IsNearRotateTie(wxInt64 f)
+{
+    const wxInt64 margin = ROTATE_FIXED_ONE >> 12;
+    const wxInt64 d = (f & (ROTATE_FIXED_ONE - 1)) - ROTATE_FIXED_ONE / 2;
+
+    return d > -margin && d < margin;
+}
+
+// Use the nearest source pixel for each destination one, rounding the source
+// coordinates exactly as wxRound() does.
+void RotateNearestRows(const void *data, int y0, int y1)
+{
+    const RotateContext& ctx = *static_cast<const RotateContext *>(data);
+
+    const wxInt64 half = ROTATE_FIXED_ONE / 2;
+
+    // the range of the coordinates rounded to the pixels inside the image
+    const wxInt64 maxX = ctx.srcWidth*ROTATE_FIXED_ONE - half;
+    const wxInt64 maxY = ctx.srcHeight*ROTATE_FIXED_ONE - half;
+
+    for ( int y = y0; y < y1; y++ )
+    {
+        wxInt64 fx, fy, stepX, stepY;
+        GetRotateRowStart(ctx, y, fx, fy, stepX, stepY);
+
+        const size_t offset = static_cast<size_t>(y)*ctx.dstWidth;
+        unsigned char *dst = ctx.dstData + 3*offset;
+        unsigned char *alpha = ctx.dstAlpha ? ctx.dstAlpha + offset : NULL;
+
+        for ( int x = 0; x < ctx.dstWidth; x++, fx += stepX, fy += stepY )
+        {
+            int xs = 0,
+                ys = 0;
+            bool inside;
+            if ( IsNearRotateTie(fx) || IsNearRotateTie(fy) )
+            {
+                // The accumulated rounding errors could make us round these
+                // coordinates differently from wxRound(), so compute them
+                // exactly in the same way as the non-optimized code did.
+                const wxRealPoint src = wxRotatePoint(x + ctx.x1a, y + ctx.y1a,
+                                                      ctx.cos_angle,
+                                                      -ctx.sin_angle,
+                                                      ctx.p0);
+                xs = wxRound(src.x);
+                ys = wxRound(src.y);
+                inside = xs >= 0 && xs < ctx.srcWidth &&
+                            ys >= 0 && ys < ctx.srcHeight;
+            }
+            else
+            {
+                inside = fx > -half && fx < maxX && fy > -half && fy < maxY;
+                if ( inside )
+                {
+                    xs = static_cast<int>((fx + half) >> ROTATE_FIXED_SHIFT);
+                    ys = static_cast<int>((fy + half) >> ROTATE_FIXED_SHIFT);
+                }
+            }
+
+            if ( inside )
+            {
+                const size_t pos = static_cast<size_t>(ys)*ctx.srcWidth + xs;
+
+                memcpy(dst, ctx.srcData + 3*pos, 3);
+                if ( alpha )
+                    *alpha++ = ctx.srcAlpha[pos];
+            }
+            else
+            {
+                memcpy(dst, ctx.blank, 3);
+                if ( alpha )
+                    *alpha++ = 255;
+            }
+
+            dst += 3;
+        }
+    }
+}
+
+// Interpolate the value of a single channel using the given weights.
+inline unsigned char
+RotateInterpolate(const unsigned char *p, size_t dx, size_t dy,
+                  unsigned wx, unsigned wy)
+{
+    const unsigned top = p[0]*(ROTATE_WEIGHT_ONE - wx) + p[dx]*wx;
+    const unsigned bottom = p[dy]*(ROTATE_WEIGHT_ONE - wx) + p[dy + dx]*wx;
+
+    return static_cast<unsigned char>
+           (
+            (top*(ROTATE_WEIGHT_ONE - wy) + bottom*wy +
+                (1u << (2*ROTATE_WEIGHT_BITS - 1))) >> (2*ROTATE_WEIGHT_BITS)
+           );
+}
+
+// Use bilinear interpolation of the 4 source pixels surrounding the point
+// corresponding to each destination one.
+void RotateBilinearRows(const void *data, int y0, int y1)
+{
+    const RotateContext& ctx = *static_cast<const RotateContext *>(data);
+
+    // The pixels at most at 1/4 pixel distance outside of the source image
+    // are still considered to be inside it and use the border pixels values.
+    const wxInt64 quarter = ROTATE_FIXED_ONE / 4;
+    const wxInt64 maxX = ctx.srcWidth*ROTATE_FIXED_ONE - 3*quarter;
+    const wxInt64 maxY = ctx.srcHeight*ROTATE_FIXED_ONE - 3*quarter;
+
+    const wxInt64 lastX = (ctx.srcWidth - 1)*ROTATE_FIXED_ONE;
+    const wxInt64 lastY = (ctx.srcHeight - 1)*ROTATE_FIXED_ONE;
+
+    const int weightShift = ROTATE_FIXED_SHIFT - ROTATE_WEIGHT_BITS;
+
+    for ( int y = y0; y < y1; y++ )
+    {
+        wxInt64 fx, fy, stepX, stepY;
+        GetRotateRowStart(ctx, y, fx, fy, stepX, stepY);
+
+        const size_t offset = static_cast<size_t>(y)*ctx.dstWidth;
+        unsigned char *dst = ctx.dstData + 3*offset;
+        unsigned char *alpha = ctx.dstAlpha ? ctx.dstAlpha + offset : NULL;
+
+        for ( int x = 0; x < ctx.dstWidth; x++, fx += stepX, fy += stepY )
+        {
+            if ( fx > -quarter && fx < maxX && fy > -quarter && fy < maxY )
+            {
+                const wxInt64 cx = fx < 0 ? 0 : fx > lastX ? lastX : fx;
+                const wxInt64 cy = fy < 0 ? 0 : fy > lastY ? lastY : fy;
+
+                const int xs = static_cast<int>(cx >> ROTATE_FIXED_SHIFT);
+                const int ys = static_cast<int>(cy >> ROTATE_FIXED_SHIFT);
+                const unsigned wx = static_cast<unsigned>(cx >> weightShift) &
+                                        (ROTATE_WEIGHT_ONE - 1);
+                const unsigned wy = static_cast<unsigned>(cy >> weightShift) &
+                                        (ROTATE_WEIGHT_ONE - 1);
+
+                // don't read beyond the last column or row, the weight of the
+                // next pixel is 0 anyhow in this case
+                const size_t dx = xs < ctx.srcWidth - 1 ? 1 : 0;
+                const size_t dy = ys < ctx.srcHeight - 1 ? ctx.srcWidth : 0;
+
+                const size_t pos = static_cast<size_t>(ys)*ctx.srcWidth + xs;
+                const unsigned char * const p = ctx.srcData + 3*pos;
+                dst[0] = RotateInterpolate(p, 3*dx, 3*dy, wx, wy);
+                dst[1] = RotateInterpolate(p + 1, 3*dx, 3*dy, wx, wy);
+                dst[2] = RotateInterpolate(p + 2, 3*dx, 3*dy, wx, wy);
+
+                if ( alpha )
+                {
+                    *alpha++ = RotateInterpolate(ctx.srcAlpha + pos,
+                                                 dx, dy, wx, wy);
+                }
+            }
+            else
+            {
+                memcpy(dst, ctx.blank, 3);
+                if ( alpha )
+                    *alpha++ = 0;
+            }
+
+            dst += 3;
+        }
+    }
+}
+
+} // anonymous namespace
+
 wxImage wxImage::Rotate(double angle,
                         const wxPoint& centre_of_rotation,
                         bool interpolating,
@@ -3586,24 +5943,6 @@ wxImage wxImage::Rotate(double angle,
     const int w = GetWidth();
     const int h = GetHeight();
 
-    int i;
-
-    // Create pointer-based array to accelerate access to wxImage's data
-    unsigned char ** data = new unsigned char * [h];
-    data[0] = GetData();
-    for (i = 1; i < h; i++)
-        data[i] = data[i - 1] + (3 * w);
-
-    // Same for alpha channel
-    unsigned char ** alpha = NULL;
-    if (has_alpha)
-    {
-        alpha = new unsigned char * [h];
-        alpha[0] = GetAlpha();
-        for (i = 1; i < h; i++)
-            alpha[i] = alpha[i - 1] + w;
-    }
-
     // precompute coefficients for rotation formula
     const double cos_angle = cos(angle);
     const double sin_angle = sin(angle);
@@ -3635,218 +5974,40 @@ wxImage wxImage::Rotate(double angle,
         *offset_after_rotation = wxPoint (x1a, y1a);
     }
 
-    // the rotated (destination) image is always accessed sequentially via this
-    // pointer, there is no need for pointer-based arrays here
-    unsigned char *dst = rotated.GetData();
-
-    unsigned char *alpha_dst = has_alpha ? rotated.GetAlpha() : NULL;
+    RotateContext ctx;
+    ctx.srcData = GetData();
+    ctx.srcAlpha = has_alpha ? GetAlpha() : NULL;
+    ctx.srcWidth = w;
+    ctx.srcHeight = h;
+    ctx.dstData = rotated.GetData();
+    ctx.dstAlpha = has_alpha ? rotated.GetAlpha() : NULL;
+    ctx.dstWidth = rotated.GetWidth();
+    ctx.p0 = p0;
+    ctx.cos_angle = cos_angle;
+    ctx.sin_angle = sin_angle;
+    ctx.x1a = x1a;
+    ctx.y1a = y1a;
 
     // if the original image has a mask, use its RGB values as the blank pixel,
     // else, fall back to default (black).
-    unsigned char blank_r = 0;
-    unsigned char blank_g = 0;
-    unsigned char blank_b = 0;
+    ctx.blank[0] =
+    ctx.blank[1] =
+    ctx.blank[2] = 0;
 
     if (HasMask())
     {
-        blank_r = GetMaskRed();
-        blank_g = GetMaskGreen();
-        blank_b = GetMaskBlue();
-        rotated.SetMaskColour( blank_r, blank_g, blank_b );
+        ctx.blank[0] = GetMaskRed();
+        ctx.blank[1] = GetMaskGreen();
+        ctx.blank[2] = GetMaskBlue();
+        rotated.SetMaskColour( ctx.blank[0], ctx.blank[1], ctx.blank[2] );
     }
 
     // Now, for each point of the rotated image, find where it came from, by
     // performing an inverse rotation (a rotation of -angle) and getting the
     // pixel at those coordinates
-
     const int rH = rotated.GetHeight();
-    const int rW = rotated.GetWidth();
-
-    // do the (interpolating) test outside of the loops, so that it is done
-    // only once, instead of repeating it for each pixel.
-    if (interpolating)
-    {
-        for (int y = 0; y < rH; y++)
-        {
-            for (int x = 0; x < rW; x++)
-            {
-                wxRealPoint src = wxRotatePoint (x + x1a, y + y1a, cos_angle, -sin_angle, p0);
-
-                if (-0.25 < src.x && src.x < w - 0.75 &&
-                    -0.25 < src.y && src.y < h - 0.75)
-                {
-                    // interpolate using the 4 enclosing grid-points.  Those
-                    // points can be obtained using floor and ceiling of the
-                    // exact coordinates of the point
-                    int x1, y1, x2, y2;
-
-                    if (0 < src.x && src.x < w - 1)
-                    {
-                        x1 = wxRound(floor(src.x));
-                        x2 = wxRound(ceil(src.x));
-                    }
-                    else    // else means that x is near one of the borders (0 or width-1)
-                    {
-                        x1 = x2 = wxRound (src.x);
-                    }
-
-                    if (0 < src.y && src.y < h - 1)
-                    {
-                        y1 = wxRound(floor(src.y));
-                        y2 = wxRound(ceil(src.y));
-                    }
-                    else
-                    {
-                        y1 = y2 = wxRound (src.y);
-                    }
-
-                    // get four points and the distances (square of the distance,
-                    // for efficiency reasons) for the interpolation formula
-
-                    // GRG: Do not calculate the points until they are
-                    //      really needed -- this way we can calculate
-                    //      just one, instead of four, if d1, d2, d3
-                    //      or d4 are < wxROTATE_EPSILON
-
-                    const double d1 = (src.x - x1) * (src.x - x1) + (src.y - y1) * (src.y - y1);
-                    const double d2 = (src.x - x2) * (src.x - x2) + (src.y - y1) * (src.y - y1);
-                    const double d3 = (src.x - x2) * (src.x - x2) + (src.y - y2) * (src.y - y2);
-                    const double d4 = (src.x - x1) * (src.x - x1) + (src.y - y2) * (src.y - y2);
-
-                    // Now interpolate as a weighted average of the four surrounding
-                    // points, where the weights are the distances to each of those points
-
-                    // If the point is exactly at one point of the grid of the source
-                    // image, then don't interpolate -- just assign the pixel
-
-                    // d1,d2,d3,d4 are positive -- no need for abs()
-                    if (d1 < wxROTATE_EPSILON)
-                    {
-                        unsigned char *p = data[y1] + (3 * x1);
-                        *(dst++) = *(p++);
-                        *(dst++) = *(p++);
-                        *(dst++) = *p;
-
-                        if (has_alpha)
-                            *(alpha_dst++) = *(alpha[y1] + x1);
-                    }
-                    else if (d2 < wxROTATE_EPSILON)
-                    {
-                        unsigned char *p = data[y1] + (3 * x2);
-                        *(dst++) = *(p++);
-                        *(dst++) = *(p++);
-                        *(dst++) = *p;
-
-                        if (has_alpha)
-                            *(alpha_dst++) = *(alpha[y1] + x2);
-                    }
-                    else if (d3 < wxROTATE_EPSILON)
-                    {
-                        unsigned char *p = data[y2] + (3 * x2);
-                        *(dst++) = *(p++);
-                        *(dst++) = *(p++);
-                        *(dst++) = *p;
-
-                        if (has_alpha)
-                            *(alpha_dst++) = *(alpha[y2] + x2);
-                    }
-                    else if (d4 < wxROTATE_EPSILON)
-                    {
-                        unsigned char *p = data[y2] + (3 * x1);
-                        *(dst++) = *(p++);
-                        *(dst++) = *(p++);
-                        *(dst++) = *p;
-
-                        if (has_alpha)
-                            *(alpha_dst++) = *(alpha[y2] + x1);
-                    }
-                    else
-                    {
-                        // weights for the weighted average are proportional to the inverse of the distance
-                        unsigned char *v1 = data[y1] + (3 * x1);
-                        unsigned char *v2 = data[y1] + (3 * x2);
-                        unsigned char *v3 = data[y2] + (3 * x2);
-                        unsigned char *v4 = data[y2] + (3 * x1);
-
-                        const double w1 = 1/d1, w2 = 1/d2, w3 = 1/d3, w4 = 1/d4;
-
-                        // GRG: Unrolled.
-
-                        *(dst++) = (unsigned char)
-                            ( (w1 * *(v1++) + w2 * *(v2++) +
-                               w3 * *(v3++) + w4 * *(v4++)) /
-                              (w1 + w2 + w3 + w4) );
-                        *(dst++) = (unsigned char)
-                            ( (w1 * *(v1++) + w2 * *(v2++) +
-                               w3 * *(v3++) + w4 * *(v4++)) /
-                              (w1 + w2 + w3 + w4) );
-                        *(dst++) = (unsigned char)
-                            ( (w1 * *v1 + w2 * *v2 +
-                               w3 * *v3 + w4 * *v4) /
-                              (w1 + w2 + w3 + w4) );
-
-                        if (has_alpha)
-                        {
-                            v1 = alpha[y1] + (x1);
-                            v2 = alpha[y1] + (x2);
-                            v3 = alpha[y2] + (x2);
-                            v4 = alpha[y2] + (x1);
-
-                            *(alpha_dst++) = (unsigned char)
-                                ( (w1 * *v1 + w2 * *v2 +
-                                   w3 * *v3 + w4 * *v4) /
-                                  (w1 + w2 + w3 + w4) );
-                        }
-                    }
-                }
-                else
-                {
-                    *(dst++) = blank_r;
-                    *(dst++) = blank_g;
-                    *(dst++) = blank_b;
-
-                    if (has_alpha)
-                        *(alpha_dst++) = 0;
-                }
-            }
-        }
-    }
-    else // not interpolating
-    {
-        for (int y = 0; y < rH; y++)
-        {
-            for (int x = 0; x < rW; x++)
-            {
-                wxRealPoint src = wxRotatePoint (x + x1a, y + y1a, cos_angle, -sin_angle, p0);
-
-                const int xs = wxRound (src.x);      // wxRound rounds to the
-                const int ys = wxRound (src.y);      // closest integer
-
-                if (0 <= xs && xs < w && 0 <= ys && ys < h)
-                {
-                    unsigned char *p = data[ys] + (3 * xs);
-                    *(dst++) = *(p++);
-                    *(dst++) = *(p++);
-                    *(dst++) = *p;
-
-                    if (has_alpha)
-                        *(alpha_dst++) = *(alpha[ys] + (xs));
-                }
-                else
-                {
-                    *(dst++) = blank_r;
-                    *(dst++) = blank_g;
-                    *(dst++) = blank_b;
-
-                    if (has_alpha)
-                        *(alpha_dst++) = 255;
-                }
-            }
-        }
-    }
-
-    delete [] data;
-    delete [] alpha;
+    wxProcessImageRows(interpolating ? RotateBilinearRows : RotateNearestRows,
+                       &ctx, rH, static_cast<size_t>(ctx.dstWidth)*rH);
 
     return rotated;
 }
@@ -3863,9 +6024,24 @@ class wxImageModule: public wxModule
 {
     wxDECLARE_DYNAMIC_CLASS(wxImageModule);
 public:
-    wxImageModule() {}
+    wxImageModule()
+    {
+#if wxUSE_THREADS
+        // The image threads pool must be destroyed before the threads module
+        // is cleaned up.
+        AddDependency("wxThreadModule");
+#endif // wxUSE_THREADS
+    }
+
     bool OnInit() wxOVERRIDE { wxImage::InitStandardHandlers(); return true; }
-    void OnExit() wxOVERRIDE { wxImage::CleanUpHandlers(); }
+    void OnExit() wxOVERRIDE
+    {
+        wxImage::CleanUpHandlers();
+
+#if wxUSE_THREADS
+        DestroyImageThreadPool();
+#endif // wxUSE_THREADS
+    }
 };
 
 wxIMPLEMENT_DYNAMIC_CLASS(wxImageModule, wxModule);
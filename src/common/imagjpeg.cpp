@@ -206,6 +206,12 @@ void wx_jpeg_io_src( j_decompress_ptr cinfo, wxInputStream& infile )
 
 } // extern "C"
 
+// Return the size of the image dimension when decoding it at 1/scale size.
+static inline unsigned wx_scaled_size(unsigned size, unsigned scale)
+{
+    return (size + scale - 1) / scale;
+}
+
 static inline void wx_cmyk_to_rgb(unsigned char* rgb, const unsigned char* cmyk)
 {
     int k = 255 - cmyk[3];
@@ -238,7 +244,10 @@ bool wxJPEGHandler::LoadFile( wxImage *image, wxInputStream& stream, bool verbos
 
     // save this before calling Destroy()
     const unsigned maxWidth = image->GetOptionInt(wxIMAGE_OPTION_MAX_WIDTH),
-                   maxHeight = image->GetOptionInt(wxIMAGE_OPTION_MAX_HEIGHT);
+                   maxHeight = image->GetOptionInt(wxIMAGE_OPTION_MAX_HEIGHT),
+                   minWidth = image->GetOptionInt(wxIMAGE_OPTION_MIN_WIDTH),
+                   minHeight = image->GetOptionInt(wxIMAGE_OPTION_MIN_HEIGHT);
+    const bool fastIDCT = image->GetOptionInt(wxIMAGE_OPTION_JPEG_FAST_IDCT) != 0;
     image->Destroy();
 
     cinfo.err = jpeg_std_error( &jerr );
@@ -289,6 +298,22 @@ bool wxJPEGHandler::LoadFile( wxImage *image, wxInputStream& stream, bool verbos
         }
     }
 
+    // and reduce it as much as possible while keeping it at least as big as
+    // the specified min size, which is useful for making thumbnails
+    if ( minWidth > 0 || minHeight > 0 )
+    {
+        unsigned& scale = cinfo.scale_denom;
+        while ( scale < 8 &&
+                    wx_scaled_size(cinfo.image_width, 2*scale) >= minWidth &&
+                        wx_scaled_size(cinfo.image_height, 2*scale) >= minHeight )
+        {
+            scale *= 2;
+        }
+    }
+
+    if ( fastIDCT )
+        cinfo.dct_method = JDCT_IFAST;
+
     jpeg_start_decompress( &cinfo );
 
     image->Create( cinfo.output_width, cinfo.output_height );
@@ -300,20 +325,26 @@ bool wxJPEGHandler::LoadFile( wxImage *image, wxInputStream& stream, bool verbos
     image->SetMask( false );
     ptr = image->GetData();
 
-    unsigned stride = cinfo.output_width * bytesPerPixel;
-    JSAMPARRAY tempbuf = (*cinfo.mem->alloc_sarray)
-                            ((j_common_ptr) &cinfo, JPOOL_IMAGE, stride, 1 );
-
-    while ( cinfo.output_scanline < cinfo.output_height )
+    if (cinfo.out_color_space == JCS_RGB)
     {
-        jpeg_read_scanlines( &cinfo, tempbuf, 1 );
-        if (cinfo.out_color_space == JCS_RGB)
+        // decode directly into the image data
+        const size_t stride = static_cast<size_t>(cinfo.output_width) * 3;
+        while ( cinfo.output_scanline < cinfo.output_height )
         {
-            memcpy( ptr, tempbuf[0], stride );
-            ptr += stride;
+            JSAMPROW row = ptr + stride * cinfo.output_scanline;
+            jpeg_read_scanlines( &cinfo, &row, 1 );
         }
-        else // CMYK
+    }
+    else // CMYK
+    {
+        unsigned stride = cinfo.output_width * bytesPerPixel;
+        JSAMPARRAY tempbuf = (*cinfo.mem->alloc_sarray)
+                                ((j_common_ptr) &cinfo, JPOOL_IMAGE, stride, 1 );
+
+        while ( cinfo.output_scanline < cinfo.output_height )
         {
+            jpeg_read_scanlines( &cinfo, tempbuf, 1 );
+
             const unsigned char* inptr = (const unsigned char*) tempbuf[0];
             for (size_t i = 0; i < cinfo.output_width; i++)
             {
@@ -30,8 +30,18 @@
     #include "wx/stream.h"
 #endif
 
+#include "wx/buffer.h"
+#include "wx/private/image.h"
+
 #include "png.h"
 
+// see the comment near the same lines in zstream.cpp
+#if defined(__WINDOWS__) && !defined(__WX_SETUP_H__) && !defined(wxUSE_ZLIB_H_IN_PATH)
+    #include "../zlib/zlib.h"
+#else
+    #include "zlib.h"
+#endif
+
 // For memcpy
 #include <string.h>
 
@@ -110,16 +120,18 @@ struct wxPNGImageData
         ok = false;
     }
 
-    bool Alloc(png_uint_32 width, png_uint_32 height, unsigned char* buf)
+    // Allocate the rows pointing into the given buffer using the given number
+    // of bytes per pixel or, if it is NULL, into an intermediate RGBA buffer.
+    bool Alloc(png_uint_32 width, png_uint_32 height,
+               unsigned char* buf, size_t bytesPerPixel)
     {
         lines = (unsigned char **)malloc(height * sizeof(unsigned char *));
         if ( !lines )
             return false;
 
         size_t w = width;
-        // if RGB data will be written directly to wxImage buffer
         if (buf)
-            w *= 3;
+            w *= bytesPerPixel;
         else
         {
             // allocate intermediate RGBA buffer
@@ -241,42 +253,48 @@ bool wxPNGHandler::DoCanRead( wxInputStream& stream )
     return memcmp(hdr, "\211PNG", WXSIZEOF(hdr)) == 0;
 }
 
-// convert data from RGB to wxImage format
+// convert a row of data from RGBA to wxImage format, alpha is allocated on
+// demand if we have any non-opaque pixels and must be initially NULL
+static
+void CopyRowFromPNG(wxImage *image,
+                    const unsigned char *ptrSrc,
+                    png_uint_32 width,
+                    png_uint_32 y,
+                    unsigned char *&ptrDst,
+                    unsigned char *&alpha)
+{
+    for ( png_uint_32 x = 0; x < width; x++ )
+    {
+        unsigned char r = *ptrSrc++;
+        unsigned char g = *ptrSrc++;
+        unsigned char b = *ptrSrc++;
+        unsigned char a = *ptrSrc++;
+
+        // the first time we encounter a transparent pixel we must
+        // allocate alpha channel for the image
+        if ( !IsOpaque(a) && !alpha )
+            alpha = InitAlpha(image, x, y);
+
+        if ( alpha )
+            *alpha++ = a;
+
+        *ptrDst++ = r;
+        *ptrDst++ = g;
+        *ptrDst++ = b;
+    }
+}
+
+// convert data from RGBA to wxImage format
 static
 void CopyDataFromPNG(wxImage *image,
                      unsigned char **lines,
                      png_uint_32 width,
                      png_uint_32 height)
 {
-    // allocated on demand if we have any non-opaque pixels
     unsigned char *alpha = NULL;
-
     unsigned char *ptrDst = image->GetData();
-    {
-        for ( png_uint_32 y = 0; y < height; y++ )
-        {
-            const unsigned char *ptrSrc = lines[y];
-            for ( png_uint_32 x = 0; x < width; x++ )
-            {
-                unsigned char r = *ptrSrc++;
-                unsigned char g = *ptrSrc++;
-                unsigned char b = *ptrSrc++;
-                unsigned char a = *ptrSrc++;
-
-                // the first time we encounter a transparent pixel we must
-                // allocate alpha channel for the image
-                if ( !IsOpaque(a) && !alpha )
-                    alpha = InitAlpha(image, x, y);
-
-                if ( alpha )
-                    *alpha++ = a;
-
-                *ptrDst++ = r;
-                *ptrDst++ = g;
-                *ptrDst++ = b;
-            }
-        }
-    }
+    for ( png_uint_32 y = 0; y < height; y++ )
+        CopyRowFromPNG(image, lines[y], width, y, ptrDst, alpha);
 }
 
 // temporarily disable the warning C4611 (interaction between '_setjmp' and
@@ -296,6 +314,9 @@ wxPNGImageData::DoLoadPNGFile(wxImage* image, wxPNGInfoStruct& wxinfo)
     png_uint_32 width, height = 0;
     int bit_depth, color_type;
 
+    // save this before calling Destroy()
+    const int pixelFormat = image->GetOptionInt(wxIMAGE_OPTION_PNG_PIXEL_FORMAT);
+
     image->Destroy();
 
     png_ptr = png_create_read_struct
@@ -327,19 +348,65 @@ wxPNGImageData::DoLoadPNGFile(wxImage* image, wxPNGInfoStruct& wxinfo)
     png_set_strip_16( png_ptr );
     png_set_packing( png_ptr );
 
-    image->Create((int)width, (int)height, (bool) false /* no need to init pixels */);
-
-    if (!image->IsOk())
-        return;
-
-    const bool needCopy =
+    const bool hasAlpha =
         (color_type & PNG_COLOR_MASK_ALPHA) ||
         png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS);
 
-    if (!Alloc(width, height, needCopy ? NULL : image->GetData()))
-        return;
+    // The transformations above result in RGBA data for the images with alpha,
+    // which can be read directly into the pixels if this format is used.
+    const bool usePixels = hasAlpha && pixelFormat != wxIMAGE_PIXEL_FORMAT_RGB;
+
+    bool needCopy = false;
+    if ( usePixels )
+    {
+        image->Create((int)width, (int)height, wxIMAGE_PIXEL_FORMAT_RGBA, false);
+
+        if (!image->IsOk())
+            return;
+
+        if (!Alloc(width, height, image->GetPixels(), 4))
+            return;
+    }
+    else
+    {
+        image->Create((int)width, (int)height, (bool) false /* no need to init pixels */);
+
+        if (!image->IsOk())
+            return;
+
+        if ( !hasAlpha )
+        {
+            // RGB data can be written directly to wxImage buffer
+            if (!Alloc(width, height, image->GetData(), 3))
+                return;
+        }
+        else if ( png_get_interlace_type(png_ptr, info_ptr) == PNG_INTERLACE_NONE )
+        {
+            // we only need to keep a single RGBA row if the image is not
+            // interlaced, as we can convert the rows as soon as they're read
+            m_buf = static_cast<unsigned char*>(malloc(width * 4));
+            if (!m_buf)
+                return;
 
-    png_read_image( png_ptr, lines );
+            unsigned char *alpha = NULL;
+            unsigned char *ptrDst = image->GetData();
+            for ( png_uint_32 y = 0; y < height; y++ )
+            {
+                png_read_row( png_ptr, m_buf, NULL );
+                CopyRowFromPNG(image, m_buf, width, y, ptrDst, alpha);
+            }
+        }
+        else
+        {
+            needCopy = true;
+
+            if (!Alloc(width, height, NULL, 4))
+                return;
+        }
+    }
+
+    if ( lines )
+        png_read_image( png_ptr, lines );
     png_read_end( png_ptr, info_ptr );
 
 #if wxUSE_PALETTE
@@ -412,6 +479,8 @@ wxPNGImageData::DoLoadPNGFile(wxImage* image, wxPNGInfoStruct& wxinfo)
     // loaded successfully, now init wxImage with this data
     if (needCopy)
         CopyDataFromPNG(image, lines, width, height);
+    else if ( usePixels && pixelFormat == wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED )
+        image->SetPixelFormat(wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED);
 
     // This will indicate to the caller that loading succeeded.
     ok = true;
@@ -486,6 +555,556 @@ static long PaletteAdd(PaletteMap *palette, const png_color_8& clr)
     return index;
 }
 
+// ----------------------------------------------------------------------------
+// SaveFile() rows helpers
+// ----------------------------------------------------------------------------
+
+namespace
+{
+
+// Converts the rows of wxImage to the format used in the PNG file.
+struct wxPNGRowConverter
+{
+    void ConvertRow(int y, unsigned char *pData) const;
+
+    const unsigned char *colors;
+    const unsigned char *alpha;
+    const PaletteMap *palette;
+    png_color_8 mask;
+    int width;
+    int colorType;
+    int bitDepth;
+    bool usePalette;
+    bool useAlpha;
+    bool hasAlpha;
+    bool hasMask;
+};
+
+void wxPNGRowConverter::ConvertRow(int y, unsigned char *pData) const
+{
+    const unsigned char *pColors = colors + static_cast<size_t>(y)*width*3;
+    const unsigned char *
+        pAlpha = alpha ? alpha + static_cast<size_t>(y)*width : NULL;
+
+    for (int x = 0; x != width; x++)
+    {
+        png_color_8 clr;
+        clr.red   = *pColors++;
+        clr.green = *pColors++;
+        clr.blue  = *pColors++;
+        clr.gray  = 0;
+        clr.alpha = (usePalette && pAlpha) ? *pAlpha++ : 0; // use with wxPNG_TYPE_PALETTE only
+
+        switch ( colorType )
+        {
+            default:
+                wxFAIL_MSG( wxT("unknown wxPNG_TYPE_XXX") );
+                wxFALLTHROUGH;
+
+            case wxPNG_TYPE_COLOUR:
+                *pData++ = clr.red;
+                if ( bitDepth == 16 )
+                    *pData++ = 0;
+                *pData++ = clr.green;
+                if ( bitDepth == 16 )
+                    *pData++ = 0;
+                *pData++ = clr.blue;
+                if ( bitDepth == 16 )
+                    *pData++ = 0;
+                break;
+
+            case wxPNG_TYPE_GREY:
+                {
+                    // where do these coefficients come from? maybe we
+                    // should have image options for them as well?
+                    unsigned uiColor =
+                        (unsigned) (76.544*(unsigned)clr.red +
+                                    150.272*(unsigned)clr.green +
+                                    36.864*(unsigned)clr.blue);
+
+                    *pData++ = (unsigned char)((uiColor >> 8) & 0xFF);
+                    if ( bitDepth == 16 )
+                        *pData++ = (unsigned char)(uiColor & 0xFF);
+                }
+                break;
+
+            case wxPNG_TYPE_GREY_RED:
+                *pData++ = clr.red;
+                if ( bitDepth == 16 )
+                    *pData++ = 0;
+                break;
+
+            case wxPNG_TYPE_PALETTE:
+                *pData++ = (unsigned char) PaletteFind(*palette, clr);
+                break;
+        }
+
+        if ( useAlpha )
+        {
+            unsigned char uchAlpha = 255;
+            if ( hasAlpha )
+                uchAlpha = *pAlpha++;
+
+            if ( hasMask )
+            {
+                if ( (clr.red == mask.red)
+                        && (clr.green == mask.green)
+                            && (clr.blue == mask.blue) )
+                    uchAlpha = 0;
+            }
+
+            *pData++ = uchAlpha;
+            if ( bitDepth == 16 )
+                *pData++ = 0;
+        }
+    }
+}
+
+// The rows compressed by a single thread: the raw deflate data ends on a byte
+// boundary, so that the data of all bands can be simply concatenated.
+struct wxPNGCompressedBand
+{
+    explicit wxPNGCompressedBand(int y1_) : y1(y1_), adler(0), ok(false) { }
+
+    wxMemoryBuffer data;
+    int y1;
+    uLong adler;
+    bool ok;
+};
+
+// Parameters of the parallel compression of the image data.
+struct wxPNGCompressInfo
+{
+    const wxPNGRowConverter *converter;
+    size_t rowBytes;
+    int bytesPerPixel;
+    int filters;
+    int level;
+    int memLevel;
+    int strategy;
+    int height;
+
+    // Indexed by the first row of each band.
+    wxPNGCompressedBand **bands;
+};
+
+// Return the PNG_FILTER_XXX mask corresponding to the value which may be
+// passed to png_set_filter(), i.e. either a mask or a single filter value.
+int GetPNGFiltersMask(int filters)
+{
+    switch ( filters & (PNG_ALL_FILTERS | 0x07) )
+    {
+        case PNG_FILTER_VALUE_NONE:  return PNG_FILTER_NONE;
+        case PNG_FILTER_VALUE_SUB:   return PNG_FILTER_SUB;
+        case PNG_FILTER_VALUE_UP:    return PNG_FILTER_UP;
+        case PNG_FILTER_VALUE_AVG:   return PNG_FILTER_AVG;
+        case PNG_FILTER_VALUE_PAETH: return PNG_FILTER_PAETH;
+    }
+
+    filters &= PNG_ALL_FILTERS;
+    return filters ? filters : PNG_FILTER_NONE;
+}
+
+// Applies the PNG filters to the image rows, choosing the filter using the
+// same heuristic as libpng when several of them are allowed, i.e. the one
+// minimizing the sum of the absolute values of the filtered bytes.
+class wxPNGRowFilter
+{
+public:
+    explicit wxPNGRowFilter(const wxPNGCompressInfo& info)
+        : m_info(info),
+          m_lastY(-1)
+    {
+        const size_t rowBytes = m_info.rowBytes;
+        m_buf = static_cast<unsigned char *>
+                    (malloc(2*rowBytes + PNG_FILTER_VALUE_LAST*(rowBytes + 1)));
+        if ( !m_buf )
+            return;
+
+        m_row = m_buf;
+        m_prev = m_buf + rowBytes;
+        for ( int n = 0; n < PNG_FILTER_VALUE_LAST; n++ )
+            m_filtered[n] = m_buf + 2*rowBytes + n*(rowBytes + 1);
+    }
+
+    ~wxPNGRowFilter() { free(m_buf); }
+
+    bool IsOk() const { return m_buf != NULL; }
+
+    // Return the filtered row, i.e. the filter type byte followed by the
+    // rowBytes bytes of data, valid until the next call to this function.
+    const unsigned char *GetRow(int y);
+
+private:
+    static unsigned long GetCost(const unsigned char *p, size_t len)
+    {
+        unsigned long cost = 0;
+        for ( size_t i = 0; i < len; i++ )
+            cost += p[i] < 128 ? p[i] : 256 - p[i];
+        return cost;
+    }
+
+    void ApplyFilter(int type, unsigned char *out) const;
+
+    const wxPNGCompressInfo& m_info;
+    unsigned char *m_buf;
+    unsigned char *m_row;
+    unsigned char *m_prev;
+    unsigned char *m_filtered[PNG_FILTER_VALUE_LAST];
+    int m_lastY;
+
+    wxDECLARE_NO_COPY_CLASS(wxPNGRowFilter);
+};
+
+void wxPNGRowFilter::ApplyFilter(int type, unsigned char *out) const
+{
+    const size_t len = m_info.rowBytes;
+    const size_t bpp = m_info.bytesPerPixel;
+    const unsigned char * const row = m_row;
+    const unsigned char * const prev = m_prev;
+
+    *out++ = static_cast<unsigned char>(type);
+
+    size_t i;
+    switch ( type )
+    {
+        case PNG_FILTER_VALUE_NONE:
+            memcpy(out, row, len);
+            break;
+
+        case PNG_FILTER_VALUE_SUB:
+            memcpy(out, row, bpp);
+            for ( i = bpp; i < len; i++ )
+                out[i] = static_cast<unsigned char>(row[i] - row[i - bpp]);
+            break;
+
+        case PNG_FILTER_VALUE_UP:
+            for ( i = 0; i < len; i++ )
+                out[i] = static_cast<unsigned char>(row[i] - prev[i]);
+            break;
+
+        case PNG_FILTER_VALUE_AVG:
+            for ( i = 0; i < bpp; i++ )
+                out[i] = static_cast<unsigned char>(row[i] - prev[i] / 2);
+            for ( ; i < len; i++ )
+                out[i] = static_cast<unsigned char>
+                            (row[i] - (row[i - bpp] + prev[i]) / 2);
+            break;
+
+        case PNG_FILTER_VALUE_PAETH:
+            for ( i = 0; i < bpp; i++ )
+                out[i] = static_cast<unsigned char>(row[i] - prev[i]);
+            for ( ; i < len; i++ )
+            {
+                const int a = row[i - bpp],
+                          b = prev[i],
+                          c = prev[i - bpp];
+                const int pa = abs(b - c),
+                          pb = abs(a - c),
+                          pc = abs(a + b - 2*c);
+                const int pred = pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+                out[i] = static_cast<unsigned char>(row[i] - pred);
+            }
+            break;
+    }
+}
+
+const unsigned char *wxPNGRowFilter::GetRow(int y)
+{
+    const size_t rowBytes = m_info.rowBytes;
+    if ( y > 0 && y == m_lastY + 1 )
+    {
+        unsigned char * const tmp = m_prev;
+        m_prev = m_row;
+        m_row = tmp;
+    }
+    else if ( y == 0 )
+    {
+        // the row before the first one is considered to be all zeroes
+        memset(m_prev, 0, rowBytes);
+    }
+    else
+    {
+        m_info.converter->ConvertRow(y - 1, m_prev);
+    }
+
+    m_info.converter->ConvertRow(y, m_row);
+    m_lastY = y;
+
+    int best = -1;
+    unsigned long bestCost = 0;
+    for ( int type = 0; type < PNG_FILTER_VALUE_LAST; type++ )
+    {
+        if ( !(m_info.filters & (PNG_FILTER_NONE << type)) )
+            continue;
+
+        ApplyFilter(type, m_filtered[type]);
+
+        // there is no need to compute the cost if there is no choice
+        if ( m_info.filters == (PNG_FILTER_NONE << type) )
+            return m_filtered[type];
+
+        const unsigned long cost = GetCost(m_filtered[type] + 1, rowBytes);
+        if ( best == -1 || cost < bestCost )
+        {
+            best = type;
+            bestCost = cost;
+        }
+    }
+
+    return m_filtered[best];
+}
+
+// Compress the given data appending the output to the buffer.
+bool DeflatePNGData(z_stream& z, const unsigned char *data, size_t len,
+                    int flush, wxMemoryBuffer& buf)
+{
+    static const size_t CHUNK_SIZE = 16384;
+
+    z.next_in = const_cast<Bytef *>(data);
+    z.avail_in = static_cast<uInt>(len);
+    for ( ;; )
+    {
+        z.next_out = static_cast<Bytef *>(buf.GetAppendBuf(CHUNK_SIZE));
+        z.avail_out = CHUNK_SIZE;
+
+        const int rc = deflate(&z, flush);
+        buf.UngetAppendBuf(CHUNK_SIZE - z.avail_out);
+
+        if ( rc == Z_STREAM_END )
+            return true;
+
+        if ( rc != Z_OK && rc != Z_BUF_ERROR )
+            return false;
+
+        if ( z.avail_out && !z.avail_in && flush != Z_FINISH )
+            return true;
+    }
+}
+
+bool DoCompressPNGRows(const wxPNGCompressInfo& info, int y0, int y1,
+                       wxPNGCompressedBand& band)
+{
+    wxPNGRowFilter filter(info);
+    if ( !filter.IsOk() )
+        return false;
+
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    if ( deflateInit2(&z, info.level, Z_DEFLATED, -MAX_WBITS,
+                      info.memLevel, info.strategy) != Z_OK )
+        return false;
+
+    const size_t lenRow = info.rowBytes + 1;
+    band.data.SetBufSize(deflateBound(&z, lenRow*(y1 - y0)) + 64);
+
+    bool ok = true;
+    if ( y0 > 0 )
+    {
+        // Use the end of the previous band as dictionary to compress this one
+        // almost as well as if it were compressed together with it.
+        const size_t lenWindow = 1 << MAX_WBITS;
+        int yDict = y0 - static_cast<int>((lenWindow + lenRow - 1) / lenRow);
+        if ( yDict < 0 )
+            yDict = 0;
+
+        wxMemoryBuffer dict(lenRow*(y0 - yDict));
+        for ( int y = yDict; y < y0; y++ )
+            dict.AppendData(filter.GetRow(y), lenRow);
+
+        size_t lenDict = dict.GetDataLen();
+        const Bytef *p = static_cast<const Bytef *>(dict.GetData());
+        if ( lenDict > lenWindow )
+        {
+            p += lenDict - lenWindow;
+            lenDict = lenWindow;
+        }
+
+        ok = deflateSetDictionary(&z, p, static_cast<uInt>(lenDict)) == Z_OK;
+    }
+
+    uLong adler = adler32(0, Z_NULL, 0);
+    for ( int y = y0; ok && y < y1; y++ )
+    {
+        const unsigned char * const row = filter.GetRow(y);
+        adler = adler32(adler, row, static_cast<uInt>(lenRow));
+        ok = DeflatePNGData(z, row, lenRow, Z_NO_FLUSH, band.data);
+    }
+
+    // Only the last band ends the stream, the others just need to be flushed
+    // to end on a byte boundary.
+    if ( ok )
+        ok = DeflatePNGData(z, NULL, 0,
+                            y1 == info.height ? Z_FINISH : Z_SYNC_FLUSH,
+                            band.data);
+
+    deflateEnd(&z);
+
+    band.adler = adler;
+    return ok;
+}
+
+void CompressPNGRows(const void *data, int y0, int y1)
+{
+    const wxPNGCompressInfo& info = *static_cast<const wxPNGCompressInfo *>(data);
+
+    wxPNGCompressedBand * const band = new wxPNGCompressedBand(y1);
+    info.bands[y0] = band;
+
+    band->ok = DoCompressPNGRows(info, y0, y1, *band);
+}
+
+// Collects the data into chunks of the given size.
+class wxPNGChunkWriter
+{
+public:
+    wxPNGChunkWriter(wxOutputStream& stream, size_t size)
+        : m_stream(stream),
+          m_buf(size),
+          m_size(size)
+    {
+    }
+
+    void Write(const void *data, size_t len)
+    {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        while ( len )
+        {
+            size_t n = m_size - m_buf.GetDataLen();
+            if ( n > len )
+                n = len;
+            m_buf.AppendData(p, n);
+            p += n;
+            len -= n;
+
+            if ( m_buf.GetDataLen() == m_size )
+                Flush();
+        }
+    }
+
+    void Flush()
+    {
+        if ( m_buf.GetDataLen() )
+        {
+            WriteChunk("IDAT", m_buf.GetData(), m_buf.GetDataLen());
+            m_buf.Clear();
+        }
+    }
+
+    void WriteChunk(const char *type, const void *data, size_t len)
+    {
+        unsigned char header[8];
+        for ( int n = 0; n < 4; n++ )
+        {
+            header[n] = static_cast<unsigned char>(len >> (24 - 8*n));
+            header[4 + n] = static_cast<unsigned char>(type[n]);
+        }
+
+        // the CRC covers the chunk type and data but not its length
+        uLong crc = crc32(0, header + 4, 4);
+        if ( len )
+            crc = crc32(crc, static_cast<const Bytef *>(data), static_cast<uInt>(len));
+
+        unsigned char trailer[4];
+        for ( int n = 0; n < 4; n++ )
+            trailer[n] = static_cast<unsigned char>(crc >> (24 - 8*n));
+
+        m_stream.Write(header, sizeof(header));
+        if ( len )
+            m_stream.Write(data, len);
+        m_stream.Write(trailer, sizeof(trailer));
+    }
+
+private:
+    wxOutputStream& m_stream;
+    wxMemoryBuffer m_buf;
+    const size_t m_size;
+
+    wxDECLARE_NO_COPY_CLASS(wxPNGChunkWriter);
+};
+
+// Write IDAT chunks containing the rows compressed in parallel, as well as
+// the final IEND chunk. This is done without using libpng, which doesn't
+// support it, but png_write_info() must have been already called.
+bool WritePNGRowsParallel(wxOutputStream& stream,
+                          wxPNGCompressInfo& info,
+                          size_t chunkSize)
+{
+    const int height = info.height;
+    info.bands = new wxPNGCompressedBand *[height];
+
+    wxProcessImageRows(CompressPNGRows, &info, height,
+                       static_cast<size_t>(info.converter->width)*height);
+
+    // Generate the zlib header and trailer ourselves, as we use raw deflate
+    // streams for the bands, see RFC 1950.
+    const int level = info.level == Z_DEFAULT_COMPRESSION ? 6 : info.level;
+    int levelFlags;
+    if ( info.strategy >= Z_HUFFMAN_ONLY || level < 2 )
+        levelFlags = 0;
+    else if ( level < 6 )
+        levelFlags = 1;
+    else if ( level == 6 )
+        levelFlags = 2;
+    else
+        levelFlags = 3;
+
+    unsigned header = (0x78 << 8) | (levelFlags << 6);
+    header += 31 - header % 31;
+
+    const unsigned char zlibHeader[2] =
+    {
+        static_cast<unsigned char>(header >> 8),
+        static_cast<unsigned char>(header)
+    };
+
+    wxPNGChunkWriter writer(stream, chunkSize);
+    writer.Write(zlibHeader, sizeof(zlibHeader));
+
+    bool ok = true;
+    uLong adler = adler32(0, Z_NULL, 0);
+    for ( int y = 0; y < height; )
+    {
+        wxPNGCompressedBand * const band = info.bands[y];
+        if ( ok && band->ok )
+        {
+            const size_t lenBand = (band->y1 - y)*(info.rowBytes + 1);
+            adler = adler32_combine(adler, band->adler, lenBand);
+
+            writer.Write(band->data.GetData(), band->data.GetDataLen());
+        }
+        else
+        {
+            ok = false;
+        }
+
+        y = band->y1;
+        delete band;
+    }
+
+    delete [] info.bands;
+    info.bands = NULL;
+
+    if ( !ok )
+        return false;
+
+    const unsigned char zlibTrailer[4] =
+    {
+        static_cast<unsigned char>(adler >> 24),
+        static_cast<unsigned char>(adler >> 16),
+        static_cast<unsigned char>(adler >> 8),
+        static_cast<unsigned char>(adler)
+    };
+    writer.Write(zlibTrailer, sizeof(zlibTrailer));
+    writer.Flush();
+
+    writer.WriteChunk("IEND", NULL, 0);
+
+    return stream.IsOk();
+}
+
+} // anonymous namespace
+
 // ----------------------------------------------------------------------------
 // writing PNGs
 // ----------------------------------------------------------------------------
@@ -739,6 +1358,74 @@ bool wxPNGHandler::SaveFile( wxImage *image, wxOutputStream& stream, bool verbos
     png_set_shift( png_ptr, &sig_bit );
     png_set_packing( png_ptr );
 
+    wxPNGRowConverter converter;
+    converter.colors = image->GetData();
+    converter.alpha = bHasAlpha ? image->GetAlpha() : NULL;
+    converter.palette = &palette;
+    converter.mask = mask;
+    converter.width = iWidth;
+    converter.colorType = iColorType;
+    converter.bitDepth = iBitDepth;
+    converter.usePalette = bUsePalette;
+    converter.useAlpha = bUseAlpha;
+    converter.hasAlpha = bHasAlpha;
+    converter.hasMask = bHasMask;
+
+    // Compress big images using several threads if possible, which requires
+    // doing the filtering and compression ourselves as libpng can only do it
+    // sequentially.
+    const size_t numPixels = static_cast<size_t>(iWidth)*iHeight;
+    if ( (iBitDepth == 8 || iBitDepth == 16) &&
+            wxGetImageRowsThreads(iHeight, numPixels) > 1 )
+    {
+        wxPNGCompressInfo compressInfo;
+        compressInfo.converter = &converter;
+        // palette indices always use a single byte with 8 bit depth
+        const int bytesPerPixel = bUsePalette ? 1 : iElements;
+        compressInfo.rowBytes = static_cast<size_t>(iWidth)*bytesPerPixel;
+        compressInfo.bytesPerPixel = bytesPerPixel;
+        compressInfo.filters = GetPNGFiltersMask
+                               (
+                                image->HasOption(wxIMAGE_OPTION_PNG_FILTER)
+                                    ? image->GetOptionInt(wxIMAGE_OPTION_PNG_FILTER)
+                                    : bUsePalette ? PNG_FILTER_NONE
+                                                  : PNG_ALL_FILTERS
+                               );
+        compressInfo.level =
+            image->HasOption(wxIMAGE_OPTION_PNG_COMPRESSION_LEVEL)
+                ? image->GetOptionInt(wxIMAGE_OPTION_PNG_COMPRESSION_LEVEL)
+                : Z_DEFAULT_COMPRESSION;
+        compressInfo.memLevel =
+            image->HasOption(wxIMAGE_OPTION_PNG_COMPRESSION_MEM_LEVEL)
+                ? image->GetOptionInt(wxIMAGE_OPTION_PNG_COMPRESSION_MEM_LEVEL)
+                : 8;
+
+        // use the same default strategy as libpng
+        compressInfo.strategy =
+            image->HasOption(wxIMAGE_OPTION_PNG_COMPRESSION_STRATEGY)
+                ? image->GetOptionInt(wxIMAGE_OPTION_PNG_COMPRESSION_STRATEGY)
+                : compressInfo.filters != PNG_FILTER_NONE ? Z_FILTERED
+                                                          : Z_DEFAULT_STRATEGY;
+        compressInfo.height = iHeight;
+        compressInfo.bands = NULL;
+
+        const bool ok = WritePNGRowsParallel
+                        (
+                            stream,
+                            compressInfo,
+                            png_get_compression_buffer_size(png_ptr)
+                        );
+
+        png_destroy_write_struct( &png_ptr, (png_infopp)&info_ptr );
+
+        if ( !ok && verbose )
+        {
+           wxLogError(_("Couldn't save PNG image."));
+        }
+
+        return ok;
+    }
+
     unsigned char *
         data = (unsigned char *)malloc( image->GetWidth() * iElements );
     if ( !data )
@@ -747,86 +1434,9 @@ bool wxPNGHandler::SaveFile( wxImage *image, wxOutputStream& stream, bool verbos
         return false;
     }
 
-    const unsigned char *
-        pAlpha = (const unsigned char *)(bHasAlpha ? image->GetAlpha() : NULL);
-
-    const unsigned char *pColors = image->GetData();
-
     for (int y = 0; y != iHeight; ++y)
     {
-        unsigned char *pData = data;
-        for (int x = 0; x != iWidth; x++)
-        {
-            png_color_8 clr;
-            clr.red   = *pColors++;
-            clr.green = *pColors++;
-            clr.blue  = *pColors++;
-            clr.gray  = 0;
-            clr.alpha = (bUsePalette && pAlpha) ? *pAlpha++ : 0; // use with wxPNG_TYPE_PALETTE only
-
-            switch ( iColorType )
-            {
-                default:
-                    wxFAIL_MSG( wxT("unknown wxPNG_TYPE_XXX") );
-                    wxFALLTHROUGH;
-
-                case wxPNG_TYPE_COLOUR:
-                    *pData++ = clr.red;
-                    if ( iBitDepth == 16 )
-                        *pData++ = 0;
-                    *pData++ = clr.green;
-                    if ( iBitDepth == 16 )
-                        *pData++ = 0;
-                    *pData++ = clr.blue;
-                    if ( iBitDepth == 16 )
-                        *pData++ = 0;
-                    break;
-
-                case wxPNG_TYPE_GREY:
-                    {
-                        // where do these coefficients come from? maybe we
-                        // should have image options for them as well?
-                        unsigned uiColor =
-                            (unsigned) (76.544*(unsigned)clr.red +
-                                        150.272*(unsigned)clr.green +
-                                        36.864*(unsigned)clr.blue);
-
-                        *pData++ = (unsigned char)((uiColor >> 8) & 0xFF);
-                        if ( iBitDepth == 16 )
-                            *pData++ = (unsigned char)(uiColor & 0xFF);
-                    }
-                    break;
-
-                case wxPNG_TYPE_GREY_RED:
-                    *pData++ = clr.red;
-                    if ( iBitDepth == 16 )
-                        *pData++ = 0;
-                    break;
-
-                case wxPNG_TYPE_PALETTE:
-                    *pData++ = (unsigned char) PaletteFind(palette, clr);
-                    break;
-            }
-
-            if ( bUseAlpha )
-            {
-                unsigned char uchAlpha = 255;
-                if ( bHasAlpha )
-                    uchAlpha = *pAlpha++;
-
-                if ( bHasMask )
-                {
-                    if ( (clr.red == mask.red)
-                            && (clr.green == mask.green)
-                                && (clr.blue == mask.blue) )
-                        uchAlpha = 0;
-                }
-
-                *pData++ = uchAlpha;
-                if ( iBitDepth == 16 )
-                    *pData++ = 0;
-            }
-        }
+        converter.ConvertRow(y, data);
 
         png_bytep row_ptr = data;
         png_write_rows( png_ptr, &row_ptr, 1 );
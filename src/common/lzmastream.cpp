@@ -58,6 +58,50 @@ struct wxLZMAStream : lzma_stream
     }
 };
 
+// Data used for random access to the xz data: the index of all its blocks
+// and the iterator pointing to the block being currently decoded.
+struct wxLZMASeekData
+{
+    explicit wxLZMASeekData(lzma_index* index_)
+        : index(index_),
+          inBlock(false)
+    {
+        lzma_index_iter_init(&iter, index);
+    }
+
+    ~wxLZMASeekData()
+    {
+        lzma_index_end(index, NULL);
+    }
+
+    lzma_index* index;
+    lzma_index_iter iter;
+
+    // Options of the block being decoded, which must remain valid while the
+    // block decoder uses them.
+    lzma_block block;
+
+    // True if we switched to decoding the individual blocks, which happens
+    // after the first seek.
+    bool inBlock;
+};
+
+// Return the number of threads to use for the given value of the parameter
+// of SetThreadCount().
+static uint32_t GetLZMAThreadCount(int threads)
+{
+    if ( threads > 0 )
+        return threads;
+
+#if LZMA_VERSION >= 50020002
+    const uint32_t count = lzma_cputhreads();
+    if ( count )
+        return count;
+#endif
+
+    return 1;
+}
+
 } // namespace wxPrivate
 
 using namespace wxPrivate;
@@ -93,6 +137,7 @@ wxLZMAData::wxLZMAData()
     m_stream = new wxLZMAStream;
     m_streamBuf = new wxUint8[wxLZMA_BUF_SIZE];
     m_pos = 0;
+    m_threads = 1;
 }
 
 wxLZMAData::~wxLZMAData()
@@ -107,6 +152,16 @@ wxLZMAData::~wxLZMAData()
 
 void wxLZMAInputStream::Init()
 {
+    m_seek = NULL;
+
+    // Remember where the compressed data starts for LoadIndex().
+    {
+        wxLogNull noLog;
+        m_parentStart = m_parent_i_stream->IsSeekable()
+                            ? m_parent_i_stream->TellI()
+                            : wxInvalidOffset;
+    }
+
     // We don't specify any memory usage limit nor any flags, not even
     // LZMA_CONCATENATED recommended by liblzma documentation, because we don't
     // foresee the need to support concatenated compressed files for now.
@@ -131,8 +186,255 @@ void wxLZMAInputStream::Init()
     m_lasterror = wxSTREAM_READ_ERROR;
 }
 
+wxLZMAInputStream::~wxLZMAInputStream()
+{
+    delete m_seek;
+}
+
+bool wxLZMAInputStream::SetThreadCount(int threads)
+{
+    wxCHECK_MSG( m_pos == 0 && !m_stream->total_in, false,
+                 "must be called before reading anything" );
+
+#if LZMA_VERSION >= 50040002
+    const uint32_t count = GetLZMAThreadCount(threads);
+
+    lzma_mt mt;
+    memset(&mt, 0, sizeof(mt));
+    mt.threads = count;
+
+    // Use the same limit as xz itself for switching to single-threaded mode
+    // to avoid using too much memory, but never fail because of it.
+    mt.memlimit_threading = lzma_physmem() / 4;
+    if ( !mt.memlimit_threading )
+        mt.memlimit_threading = UINT64_MAX;
+    mt.memlimit_stop = UINT64_MAX;
+
+    const lzma_ret rc = count == 1 ? lzma_stream_decoder(m_stream, UINT64_MAX, 0)
+                                   : lzma_stream_decoder_mt(m_stream, &mt);
+    if ( rc != LZMA_OK )
+    {
+        wxLogError(_("Failed to initialize LZMA decompression: "
+                     "unexpected error %u."),
+                   rc);
+        m_lasterror = wxSTREAM_READ_ERROR;
+        return false;
+    }
+
+    m_threads = count;
+    return true;
+#else // liblzma < 5.4
+    // Multi-threaded decoder is not available, just keep using one thread.
+    return threads == 1;
+#endif // liblzma version
+}
+
+bool wxLZMAInputStream::LoadIndex()
+{
+    if ( m_seek )
+        return true;
+
+#if LZMA_VERSION >= 50040002
+    if ( m_parentStart == wxInvalidOffset || !m_parent_i_stream->IsSeekable() )
+        return false;
+
+    const wxFileOffset length = m_parent_i_stream->GetLength();
+    if ( length == wxInvalidOffset || length < m_parentStart )
+        return false;
+
+    const wxFileOffset posOld = m_parent_i_stream->TellI();
+
+    // Let liblzma read the index of all the streams in the file, it tells us
+    // where it needs to seek to do it.
+    wxLZMAStream stream;
+    lzma_index* index = NULL;
+    lzma_ret rc = lzma_file_info_decoder(&stream, &index, UINT64_MAX,
+                                         length - m_parentStart);
+    wxUint8 buf[wxLZMA_BUF_SIZE];
+    while ( rc == LZMA_OK )
+    {
+        if ( !stream.avail_in )
+        {
+            stream.next_in = buf;
+            stream.avail_in = m_parent_i_stream->Read(buf, sizeof(buf))
+                                                 .LastRead();
+        }
+
+        rc = lzma_code(&stream, stream.avail_in ? LZMA_RUN : LZMA_FINISH);
+        if ( rc == LZMA_SEEK_NEEDED )
+        {
+            const wxFileOffset pos = m_parentStart + stream.seek_pos;
+            if ( m_parent_i_stream->SeekI(pos) != pos )
+                break;
+
+            stream.avail_in = 0;
+            rc = LZMA_OK;
+        }
+    }
+
+    if ( posOld != wxInvalidOffset )
+        m_parent_i_stream->SeekI(posOld);
+
+    if ( rc != LZMA_STREAM_END )
+    {
+        wxLogError(_("LZMA decompression error: %s"),
+                   _("failed to read the index"));
+        return false;
+    }
+
+    m_seek = new wxLZMASeekData(index);
+    return true;
+#else // liblzma < 5.4
+    return false;
+#endif // liblzma version
+}
+
+wxFileOffset wxLZMAInputStream::GetLength() const
+{
+    if ( m_seek )
+        return lzma_index_uncompressed_size(m_seek->index);
+
+    return wxInputStream::GetLength();
+}
+
+bool wxLZMAInputStream::StartBlock()
+{
+    const lzma_index_iter& iter = m_seek->iter;
+
+    m_lasterror = wxSTREAM_READ_ERROR;
+    m_stream->avail_in = 0;
+
+    const wxFileOffset pos = m_parentStart + iter.block.compressed_file_offset;
+    if ( m_parent_i_stream->SeekI(pos) != pos )
+        return false;
+
+    // The first byte of the block header gives its size.
+    wxUint8 header[LZMA_BLOCK_HEADER_SIZE_MAX];
+    if ( m_parent_i_stream->Read(header, 1).LastRead() != 1 || !header[0] )
+        return false;
+
+    lzma_filter filters[LZMA_FILTERS_MAX + 1];
+    lzma_block& block = m_seek->block;
+    memset(&block, 0, sizeof(block));
+    block.version = 1;
+    block.check = iter.stream.flags->check;
+    block.filters = filters;
+    block.header_size = lzma_block_header_size_decode(header[0]);
+
+    const size_t rest = block.header_size - 1;
+    if ( m_parent_i_stream->Read(header + 1, rest).LastRead() != rest )
+        return false;
+
+    lzma_ret rc = lzma_block_header_decode(&block, NULL, header);
+    if ( rc == LZMA_OK )
+    {
+        rc = lzma_block_compressed_size(&block, iter.block.unpadded_size);
+        if ( rc == LZMA_OK )
+            rc = lzma_block_decoder(m_stream, &block);
+
+        // The filters are only used during the decoder initialization.
+        for ( size_t n = 0; filters[n].id != LZMA_VLI_UNKNOWN; n++ )
+            free(filters[n].options);
+        block.filters = NULL;
+    }
+
+    if ( rc != LZMA_OK )
+    {
+        wxLogError(_("LZMA decompression error: %s"),
+                   _("input is corrupted"));
+        return false;
+    }
+
+    m_seek->inBlock = true;
+    m_pos = iter.block.uncompressed_file_offset;
+    m_lasterror = wxSTREAM_NO_ERROR;
+    return true;
+}
+
+bool wxLZMAInputStream::Skip(wxFileOffset count)
+{
+    wxUint8 buf[wxLZMA_BUF_SIZE];
+    while ( count > 0 && m_lasterror == wxSTREAM_NO_ERROR )
+    {
+        const size_t n = count > wxFileOffset(sizeof(buf))
+                            ? sizeof(buf)
+                            : static_cast<size_t>(count);
+        count -= OnSysRead(buf, n);
+    }
+
+    return count == 0;
+}
+
+wxFileOffset wxLZMAInputStream::OnSysSeek(wxFileOffset pos, wxSeekMode mode)
+{
+    if ( !m_seek )
+        return wxInvalidOffset;
+
+    const wxFileOffset length = lzma_index_uncompressed_size(m_seek->index);
+    switch ( mode )
+    {
+        case wxFromStart:
+            break;
+
+        case wxFromCurrent:
+            pos += m_pos;
+            break;
+
+        case wxFromEnd:
+            pos += length;
+            break;
+    }
+
+    if ( pos < 0 || pos > length )
+        return wxInvalidOffset;
+
+    if ( m_lasterror == wxSTREAM_EOF )
+        m_lasterror = wxSTREAM_NO_ERROR;
+
+    // If the new position is in the same block as the current one, we can just
+    // decompress up to it, whether we're decoding the whole stream or just the
+    // individual blocks.
+    if ( pos >= m_pos && m_lasterror == wxSTREAM_NO_ERROR )
+    {
+        lzma_index_iter iter;
+        lzma_index_iter_init(&iter, m_seek->index);
+        if ( !lzma_index_iter_locate(&iter, m_pos) &&
+                wxUint64(pos) < iter.block.uncompressed_file_offset +
+                                iter.block.uncompressed_size )
+        {
+            if ( !Skip(pos - m_pos) )
+                return wxInvalidOffset;
+
+            return m_pos;
+        }
+    }
+
+    if ( pos == length )
+    {
+        // Seeking to the end doesn't require decoding anything.
+        m_seek->inBlock = false;
+        m_pos = pos;
+        m_lasterror = wxSTREAM_EOF;
+        return m_pos;
+    }
+
+    lzma_index_iter_rewind(&m_seek->iter);
+    if ( lzma_index_iter_locate(&m_seek->iter, pos) || !StartBlock() )
+        return wxInvalidOffset;
+
+    if ( !Skip(pos - m_pos) )
+        return wxInvalidOffset;
+
+    return m_pos;
+}
+
 size_t wxLZMAInputStream::OnSysRead(void* outbuf, size_t size)
 {
+    // After seeking to the end of the data, there is no current block and so
+    // nothing left to decode: the stream just remains at EOF.
+    if ( m_seek && !m_seek->inBlock && m_lasterror == wxSTREAM_EOF )
+        return 0;
+
     m_stream->next_out = static_cast<uint8_t*>(outbuf);
     m_stream->avail_out = size;
 
@@ -172,6 +474,26 @@ size_t wxLZMAInputStream::OnSysRead(void* outbuf, size_t size)
                 continue;
 
             case LZMA_STREAM_END:
+                // When decoding individual blocks, continue with the next
+                // one, if any.
+                if ( m_seek && m_seek->inBlock )
+                {
+                    if ( !lzma_index_iter_next(&m_seek->iter,
+                                               LZMA_INDEX_ITER_NONEMPTY_BLOCK) )
+                    {
+                        if ( !StartBlock() )
+                            return 0;
+
+                        // StartBlock() sets m_pos to the start of the new
+                        // block, but it is updated at the end of this
+                        // function, so make it correct for this.
+                        m_pos -= size - m_stream->avail_out;
+                        continue;
+                    }
+
+                    m_seek->inBlock = false;
+                }
+
                 m_lasterror = wxSTREAM_EOF;
                 continue;
 
@@ -215,6 +537,8 @@ void wxLZMAOutputStream::Init(int level)
     if ( level == -1 )
         level = LZMA_PRESET_DEFAULT;
 
+    m_level = level;
+
     // Use the check type recommended by liblzma documentation.
     const lzma_ret rc = lzma_easy_encoder(m_stream, level, LZMA_CHECK_CRC64);
     switch ( rc )
@@ -241,6 +565,51 @@ void wxLZMAOutputStream::Init(int level)
     m_lasterror = wxSTREAM_WRITE_ERROR;
 }
 
+bool wxLZMAOutputStream::SetThreadCount(int threads, size_t blockSize)
+{
+    wxCHECK_MSG( m_pos == 0, false, "must be called before writing anything" );
+
+#if LZMA_VERSION >= 50020002
+    const uint32_t count = GetLZMAThreadCount(threads);
+
+    lzma_ret rc;
+    if ( count == 1 && !blockSize )
+    {
+        rc = lzma_easy_encoder(m_stream, m_level, LZMA_CHECK_CRC64);
+    }
+    else
+    {
+        // The data is split in independently compressed blocks which can
+        // also be decompressed concurrently, or used for random access, by
+        // wxLZMAInputStream.
+        lzma_mt mt;
+        memset(&mt, 0, sizeof(mt));
+        mt.threads = count;
+        mt.block_size = blockSize;
+        mt.preset = m_level;
+        mt.check = LZMA_CHECK_CRC64;
+
+        rc = lzma_stream_encoder_mt(m_stream, &mt);
+    }
+
+    if ( rc != LZMA_OK )
+    {
+        wxLogError(_("Failed to initialize LZMA compression: "
+                     "unexpected error %u."),
+                   rc);
+        m_lasterror = wxSTREAM_WRITE_ERROR;
+        return false;
+    }
+
+    m_threads = count;
+    return true;
+#else // liblzma < 5.2
+    wxUnusedVar(blockSize);
+
+    return threads == 1;
+#endif // liblzma version
+}
+
 size_t wxLZMAOutputStream::OnSysWrite(const void *inbuf, size_t size)
 {
     m_stream->next_in = static_cast<const uint8_t*>(inbuf);
@@ -28,6 +28,8 @@
     #include  "wx/stream.h"
 #endif  //WX_PRECOMP
 
+#include "wx/wfstream.h"
+
 #include <stdlib.h>
 
 // ============================================================================
@@ -41,6 +43,7 @@
 wxIMPLEMENT_ABSTRACT_CLASS(wxMemoryInputStream, wxInputStream);
 
 wxMemoryInputStream::wxMemoryInputStream(const void *data, size_t len)
+                   : m_dataOwner(NULL)
 {
     m_i_streambuf = new wxStreamBuffer(wxStreamBuffer::read);
     m_i_streambuf->SetBufferIO(const_cast<void *>(data), len);
@@ -51,6 +54,7 @@ wxMemoryInputStream::wxMemoryInputStream(const void *data, size_t len)
 }
 
 wxMemoryInputStream::wxMemoryInputStream(const wxMemoryOutputStream& stream)
+                   : m_dataOwner(NULL)
 {
     const wxFileOffset lenFile = stream.GetLength();
     if ( lenFile == wxInvalidOffset )
@@ -71,9 +75,55 @@ wxMemoryInputStream::wxMemoryInputStream(const wxMemoryOutputStream& stream)
     m_length = len;
 }
 
+bool
+wxMemoryInputStream::InitFromMappedStream(wxInputStream& stream,
+                                          wxFileOffset lenFile)
+{
+#if wxUSE_FILE
+    wxMappedFileInputStream * const
+        mapped = wxDynamicCast(&stream, wxMappedFileInputStream);
+    if ( !mapped || !mapped->IsMapped() )
+        return false;
+
+    // We can't use the mapped data directly if some of it had been put back
+    // into the stream, as this data lives in a separate buffer.
+    if ( mapped->m_wback && mapped->m_wbackcur < mapped->m_wbacksize )
+        return false;
+
+    // Just as when copying, take the data from the current position.
+    const size_t pos = mapped->m_pos;
+    size_t len = mapped->m_length - pos;
+    if ( lenFile != wxInvalidOffset && (wxFileOffset)len > lenFile )
+        len = wx_truncate_cast(size_t, lenFile);
+
+    m_dataOwner = mapped->m_mapping;
+    m_dataOwner->IncRef();
+
+    m_i_streambuf = new wxStreamBuffer(wxStreamBuffer::read);
+    m_i_streambuf->SetBufferIO(const_cast<char *>(mapped->m_data + pos), len);
+    m_i_streambuf->SetIntPosition(0); // seek to start pos
+    m_i_streambuf->Fixed(true);
+    m_length = len;
+
+    // Consume the data in the source stream, as reading it would have done.
+    mapped->m_pos += len;
+
+    return true;
+#else // !wxUSE_FILE
+    wxUnusedVar(stream);
+    wxUnusedVar(lenFile);
+
+    return false;
+#endif // wxUSE_FILE/!wxUSE_FILE
+}
+
 void
 wxMemoryInputStream::InitFromStream(wxInputStream& stream, wxFileOffset lenFile)
 {
+    // Avoid copying the data if we can share it with the other stream.
+    if ( InitFromMappedStream(stream, lenFile) )
+        return;
+
     if ( lenFile == wxInvalidOffset )
         lenFile = stream.GetLength();
 
@@ -103,6 +153,9 @@ bool wxMemoryInputStream::CanRead() const
 wxMemoryInputStream::~wxMemoryInputStream()
 {
     delete m_i_streambuf;
+
+    if ( m_dataOwner )
+        m_dataOwner->DecRef();
 }
 
 char wxMemoryInputStream::Peek()
@@ -53,6 +53,9 @@ void wxProcess::Init(wxEvtHandler *parent, int id, int flags)
     m_inputStream  = NULL;
     m_errorStream  = NULL;
     m_outputStream = NULL;
+
+    m_outputSink =
+    m_errorSink = NULL;
 #endif // wxUSE_STREAMS
 }
 
@@ -123,6 +126,16 @@ void wxProcess::SetPipeStreams(wxInputStream *inputSstream,
     m_outputStream = outputStream;
 }
 
+void wxProcess::SetOutputSink(wxOutputStream *out, wxOutputStream *err)
+{
+    wxCHECK_RET( out, wxS("output sink must be specified") );
+
+    m_outputSink = out;
+    m_errorSink = err;
+
+    m_redirect = true;
+}
+
 bool wxProcess::IsInputOpened() const
 {
     return m_inputStream && m_inputStream->GetLastError() != wxSTREAM_EOF;
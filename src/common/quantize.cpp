@@ -29,12 +29,20 @@
 
 /* modified by Vaclav Slavik for use as jpeglib-independent module */
 
+/* Support for mapping without dithering or with ordered dithering, using
+ * several threads for big images, and for mapping to an externally given
+ * colormap was added later.  Ordered dithering uses the dither amplitude
+ * of a regular colormap with the same number of colors, which is a good
+ * enough approximation in practice.
+ */
+
 // For compilers that support precompilation, includes "wx/wx.h".
 #include "wx/wxprec.h"
 
 #if wxUSE_IMAGE
 
 #include "wx/quantize.h"
+#include "wx/private/image.h"
 
 #ifndef WX_PRECOMP
     #include "wx/palette.h"
@@ -67,8 +75,15 @@ typedef JSAMPLE *JSAMPROW;
 typedef JSAMPROW *JSAMPARRAY;
 typedef unsigned int JDIMENSION;
 
+typedef enum {
+        JDITHER_NONE,       /* no dithering */
+        JDITHER_ORDERED,    /* simple ordered dither */
+        JDITHER_FS          /* Floyd-Steinberg error diffusion dither */
+} J_DITHER_MODE;
+
 typedef struct {
         void *cquantize;
+        J_DITHER_MODE dither_mode;
         JDIMENSION output_width;
         JSAMPARRAY colormap;
         int actual_number_of_colors;
@@ -258,6 +273,31 @@ typedef wxInt32 LOCFSERROR;   /* be sure calculation temps are big enough */
 typedef FSERROR  *FSERRPTR; /* pointer to error array (in  storage!) */
 
 
+/* Declarations for ordered dithering.
+ *
+ * We use the standard 8x8 Bayer matrix, scaled so that the dither values
+ * cover the distance between adjacent colors of a regular colormap with the
+ * same number of colors.  Unlike Floyd-Steinberg dithering, the value of
+ * each output pixel depends only on the corresponding input pixel, so the
+ * rows can be mapped independently of each other.
+ */
+
+#define ODITHER_SIZE  8     /* dimension of dither matrix */
+#define ODITHER_CELLS (ODITHER_SIZE*ODITHER_SIZE)   /* # cells in matrix */
+#define ODITHER_MASK  (ODITHER_SIZE-1) /* mask for wrapping around counters */
+
+static const wxUint8 base_dither_matrix[ODITHER_SIZE][ODITHER_SIZE] = {
+  {  0, 32,  8, 40,  2, 34, 10, 42 },
+  { 48, 16, 56, 24, 50, 18, 58, 26 },
+  { 12, 44,  4, 36, 14, 46,  6, 38 },
+  { 60, 28, 52, 20, 62, 30, 54, 22 },
+  {  3, 35, 11, 43,  1, 33,  9, 41 },
+  { 51, 19, 59, 27, 49, 17, 57, 25 },
+  { 15, 47,  7, 39, 13, 45,  5, 37 },
+  { 63, 31, 55, 23, 61, 29, 53, 21 }
+};
+
+
 /* Private subobject */
 
 typedef struct {
@@ -282,6 +322,9 @@ typedef struct {
   FSERRPTR fserrors;        /* accumulated errors */
   bool on_odd_row;      /* flag to remember which row we are on */
   int * error_limiter;      /* table for clamping the applied error */
+
+  /* Variables for ordered dithering */
+  int odither[ODITHER_SIZE][ODITHER_SIZE]; /* scaled dither matrix */
 } my_cquantizer;
 
 typedef my_cquantizer * my_cquantize_ptr;
@@ -989,14 +1032,43 @@ fill_inverse_cmap (j_decompress_ptr cinfo, int c0, int c1, int c2)
 
 /*
  * Map some rows of pixels to the output colormapped representation.
+ *
+ * The functions mapping the pixels without dithering or with ordered
+ * dithering handle the given range of rows of the whole image, so that they
+ * can be called from several threads at once.  This is only safe if the
+ * inverse colormap was completely filled in advance by fill_inverse_cmap_rows,
+ * as otherwise they fill it as needed.
  */
 
-#if 0
+typedef struct {
+  j_decompress_ptr cinfo;
+  JSAMPARRAY input_buf;
+  JSAMPARRAY output_buf;
+} pass2_rows_info;
+
+
 void
-pass2_no_dither (j_decompress_ptr cinfo,
-         JSAMPARRAY input_buf, JSAMPARRAY output_buf, int num_rows)
+fill_inverse_cmap_rows (const void *data, int first_box, int last_box)
+/* Fill all inverse-colormap entries in the update boxes with the C0 box */
+/* indexes in [first_box, last_box) range */
+{
+  j_decompress_ptr cinfo = ((const pass2_rows_info *) data)->cinfo;
+  int c0, c1, c2;
+
+  for (c0 = first_box << BOX_C0_LOG; c0 < (last_box << BOX_C0_LOG);
+       c0 += BOX_C0_ELEMS)
+    for (c1 = 0; c1 < HIST_C1_ELEMS; c1 += BOX_C1_ELEMS)
+      for (c2 = 0; c2 < HIST_C2_ELEMS; c2 += BOX_C2_ELEMS)
+    fill_inverse_cmap(cinfo, c0, c1, c2);
+}
+
+
+void
+pass2_no_dither (const void *data, int first_row, int last_row)
 /* This version performs no dithering */
 {
+  const pass2_rows_info *info = (const pass2_rows_info *) data;
+  j_decompress_ptr cinfo = info->cinfo;
   my_cquantize_ptr cquantize = (my_cquantize_ptr) cinfo->cquantize;
   hist3d histogram = cquantize->histogram;
   JSAMPROW inptr, outptr;
@@ -1006,9 +1078,9 @@ pass2_no_dither (j_decompress_ptr cinfo,
   JDIMENSION col;
   JDIMENSION width = cinfo->output_width;
 
-  for (row = 0; row < num_rows; row++) {
-    inptr = input_buf[row];
-    outptr = output_buf[row];
+  for (row = first_row; row < last_row; row++) {
+    inptr = info->input_buf[row];
+    outptr = info->output_buf[row];
     for (col = width; col > 0; col--) {
       /* get pixel value and index into the cache */
       c0 = GETJSAMPLE(*inptr++) >> C0_SHIFT;
@@ -1024,7 +1096,42 @@ pass2_no_dither (j_decompress_ptr cinfo,
     }
   }
 }
-#endif
+
+
+void
+pass2_ordered_dither (const void *data, int first_row, int last_row)
+/* This version performs ordered dithering */
+{
+  const pass2_rows_info *info = (const pass2_rows_info *) data;
+  j_decompress_ptr cinfo = info->cinfo;
+  my_cquantize_ptr cquantize = (my_cquantize_ptr) cinfo->cquantize;
+  hist3d histogram = cquantize->histogram;
+  JSAMPLE *range_limit = cinfo->sample_range_limit;
+  JSAMPROW inptr, outptr;
+  histptr cachep;
+  const int *dither;
+  int c0, c1, c2;
+  int row;
+  JDIMENSION col;
+  JDIMENSION width = cinfo->output_width;
+
+  for (row = first_row; row < last_row; row++) {
+    inptr = info->input_buf[row];
+    outptr = info->output_buf[row];
+    dither = cquantize->odither[row & ODITHER_MASK];
+    for (col = 0; col < width; col++) {
+      /* add the dither value to the pixel and index into the cache */
+      const int d = dither[col & ODITHER_MASK];
+      c0 = GETJSAMPLE(range_limit[GETJSAMPLE(*inptr++) + d]) >> C0_SHIFT;
+      c1 = GETJSAMPLE(range_limit[GETJSAMPLE(*inptr++) + d]) >> C1_SHIFT;
+      c2 = GETJSAMPLE(range_limit[GETJSAMPLE(*inptr++) + d]) >> C2_SHIFT;
+      cachep = & histogram[c0][c1][c2];
+      if (*cachep == 0)
+    fill_inverse_cmap(cinfo, c0,c1,c2);
+      *outptr++ = (JSAMPLE) (*cachep - 1);
+    }
+  }
+}
 
 void
 pass2_fs_dither (j_decompress_ptr cinfo,
@@ -1235,6 +1342,34 @@ init_error_limit (j_decompress_ptr cinfo)
 }
 
 
+/*
+ * Initialize the ordered dither matrix for the current colormap.
+ */
+
+static void
+init_ordered_dither (j_decompress_ptr cinfo)
+{
+  my_cquantize_ptr cquantize = (my_cquantize_ptr) cinfo->cquantize;
+  int levels, spread, j, k;
+
+  /* Find the number of levels per component of a regular colormap with */
+  /* at most as many colors as the actual one. */
+  for (levels = 2; (levels+1)*(levels+1)*(levels+1) <=
+                   cinfo->actual_number_of_colors; levels++)
+    ;
+  spread = MAXJSAMPLE / (levels-1);
+
+  /* Map the matrix values to -spread/2 .. +spread/2 range */
+  for (j = 0; j < ODITHER_SIZE; j++) {
+    for (k = 0; k < ODITHER_SIZE; k++) {
+      cquantize->odither[j][k] =
+        ((2 * (int) base_dither_matrix[j][k] + 1 - ODITHER_CELLS) * spread)
+          / (2 * ODITHER_CELLS);
+    }
+  }
+}
+
+
 /*
  * Finish up at the end of each pass.
  */
@@ -1274,6 +1409,13 @@ start_pass_2_quant (j_decompress_ptr cinfo, bool is_pre_scan)
     cquantize->pub.color_quantize = prescan_quantize;
     cquantize->pub.finish_pass = finish_pass1;
     cquantize->needs_zeroed = true; /* Always zero histogram */
+  } else if (cinfo->dither_mode != JDITHER_FS) {
+    /* The rows are mapped by pass2_no_dither or pass2_ordered_dither */
+    cquantize->pub.color_quantize = NULL;
+    cquantize->pub.finish_pass = finish_pass2;
+
+    if (cinfo->dither_mode == JDITHER_ORDERED)
+      init_ordered_dither(cinfo);
   } else {
     /* Set up method pointers */
     cquantize->pub.color_quantize = pass2_fs_dither;
@@ -1420,6 +1562,12 @@ wxIMPLEMENT_DYNAMIC_CLASS(wxQuantize, wxObject);
 
 void wxQuantize::DoQuantize(unsigned w, unsigned h, unsigned char **in_rows, unsigned char **out_rows,
     unsigned char *palette, int desiredNoColours)
+{
+    DoQuantize(w, h, in_rows, out_rows, palette, desiredNoColours, 0);
+}
+
+void wxQuantize::DoQuantize(unsigned w, unsigned h, unsigned char **in_rows, unsigned char **out_rows,
+    unsigned char *palette, int desiredNoColours, int flags)
 {
     j_decompress dec;
     my_cquantize_ptr cquantize;
@@ -1427,17 +1575,60 @@ void wxQuantize::DoQuantize(unsigned w, unsigned h, unsigned char **in_rows, uns
     dec.colormap = NULL;
     dec.output_width = w;
     dec.desired_number_of_colors = desiredNoColours;
+    if (flags & wxQUANTIZE_NO_DITHER)
+        dec.dither_mode = JDITHER_NONE;
+    else if (flags & wxQUANTIZE_ORDERED_DITHER)
+        dec.dither_mode = JDITHER_ORDERED;
+    else
+        dec.dither_mode = JDITHER_FS;
     prepare_range_limit_table(&dec);
     jinit_2pass_quantizer(&dec);
     cquantize = (my_cquantize_ptr) dec.cquantize;
 
 
-    cquantize->pub.start_pass(&dec, true);
-    cquantize->pub.color_quantize(&dec, in_rows, out_rows, h);
-    cquantize->pub.finish_pass(&dec);
+    if (flags & wxQUANTIZE_USE_PALETTE)
+    {
+        // Skip the first pass and map the image to the given palette.
+        for (int i = 0; i < desiredNoColours; i++) {
+            cquantize->sv_colormap[0][i] = palette[3 * i + 0];
+            cquantize->sv_colormap[1][i] = palette[3 * i + 1];
+            cquantize->sv_colormap[2][i] = palette[3 * i + 2];
+        }
+        dec.colormap = cquantize->sv_colormap;
+        dec.actual_number_of_colors = desiredNoColours;
+    }
+    else
+    {
+        cquantize->pub.start_pass(&dec, true);
+        cquantize->pub.color_quantize(&dec, in_rows, out_rows, h);
+        cquantize->pub.finish_pass(&dec);
+    }
 
     cquantize->pub.start_pass(&dec, false);
-    cquantize->pub.color_quantize(&dec, in_rows, out_rows, h);
+    if (dec.dither_mode == JDITHER_FS)
+    {
+        cquantize->pub.color_quantize(&dec, in_rows, out_rows, h);
+    }
+    else
+    {
+        pass2_rows_info info;
+        info.cinfo = &dec;
+        info.input_buf = in_rows;
+        info.output_buf = out_rows;
+
+        const size_t pixels = static_cast<size_t>(w) * h;
+
+        // When using several threads, the inverse colour map can't be filled
+        // lazily, so do it in advance, also using several threads.
+        if (wxGetImageRowsThreads(h, pixels) > 1)
+            wxProcessImageRows(fill_inverse_cmap_rows, &info,
+                               HIST_C0_ELEMS / BOX_C0_ELEMS, pixels);
+
+        wxProcessImageRows(dec.dither_mode == JDITHER_ORDERED
+                            ? pass2_ordered_dither
+                            : pass2_no_dither,
+                           &info, h, pixels);
+    }
     cquantize->pub.finish_pass(&dec);
 
 
@@ -1462,6 +1653,34 @@ void wxQuantize::DoQuantize(unsigned w, unsigned h, unsigned char **in_rows, uns
     free(cquantize);
 }
 
+namespace
+{
+
+struct FillDestinationInfo
+{
+    const unsigned char *data8bit;
+    const unsigned char *palette;
+    unsigned char *dest;
+    int width;
+};
+
+void FillDestinationRows(const void *data, int y0, int y1)
+{
+    const FillDestinationInfo& info = *static_cast<const FillDestinationInfo *>(data);
+
+    const unsigned char *src = info.data8bit + static_cast<size_t>(info.width) * y0;
+    unsigned char *dst = info.dest + 3 * static_cast<size_t>(info.width) * y0;
+    for (size_t n = static_cast<size_t>(info.width) * (y1 - y0); n > 0; n--)
+    {
+        const unsigned char *p = info.palette + 3 * *src++;
+        *dst++ = p[0];
+        *dst++ = p[1];
+        *dst++ = p[2];
+    }
+}
+
+} // anonymous namespace
+
 // TODO: somehow make use of the Windows system colours, rather than ignoring them for the
 // purposes of quantization.
 
@@ -1478,16 +1697,44 @@ bool wxQuantize::Quantize(const wxImage& src, wxImage& dest,
 
     int paletteShift = 0;
 
-    // Shift the palette up by the number of Windows system colours,
-    // if necessary
-    if (flags & wxQUANTIZE_INCLUDE_WINDOWS_COLOURS)
-        paletteShift = windowsSystemColourCount;
+    unsigned char palette[3*256];
+
+    // Use the existing palette if requested: it is used as is, so neither
+    // the Windows system colours nor the number of colours matter then.
+#if wxUSE_PALETTE
+    const wxPalette *usePalette = NULL;
+    if ((flags & wxQUANTIZE_USE_PALETTE) && pPalette && *pPalette)
+    {
+        usePalette = *pPalette;
+        wxCHECK_MSG( usePalette->IsOk() && usePalette->GetColoursCount() > 0,
+                     false, wxS("invalid palette") );
 
-    // Make room for the Windows system colours
+        desiredNoColours = usePalette->GetColoursCount();
+        if (desiredNoColours > 256)
+            desiredNoColours = 256;
+        for (i = 0; i < desiredNoColours; i++)
+        {
+            usePalette->GetRGB(i, &palette[3 * i + 0],
+                                  &palette[3 * i + 1],
+                                  &palette[3 * i + 2]);
+        }
+    }
+    else
+#endif // wxUSE_PALETTE
+    {
+        flags &= ~wxQUANTIZE_USE_PALETTE;
+
+        // Shift the palette up by the number of Windows system colours,
+        // if necessary
+        if (flags & wxQUANTIZE_INCLUDE_WINDOWS_COLOURS)
+            paletteShift = windowsSystemColourCount;
+
+        // Make room for the Windows system colours
 #ifdef __WXMSW__
-    if ((flags & wxQUANTIZE_INCLUDE_WINDOWS_COLOURS) && (desiredNoColours > (256 - windowsSystemColourCount)))
-        desiredNoColours = 256 - windowsSystemColourCount;
+        if ((flags & wxQUANTIZE_INCLUDE_WINDOWS_COLOURS) && (desiredNoColours > (256 - windowsSystemColourCount)))
+            desiredNoColours = 256 - windowsSystemColourCount;
 #endif
+    }
 
     // create rows info:
     int h = src.GetHeight();
@@ -1497,8 +1744,6 @@ bool wxQuantize::Quantize(const wxImage& src, wxImage& dest,
     for (i = 0; i < h; i++)
         rows[i] = imgdt + 3/*RGB*/ * w * i;
 
-    unsigned char palette[3*256];
-
     // This is the image as represented by palette indexes.
     unsigned char *data8bit = new unsigned char[w * h];
     unsigned char **outrows = new unsigned char *[h];
@@ -1506,7 +1751,7 @@ bool wxQuantize::Quantize(const wxImage& src, wxImage& dest,
         outrows[i] = data8bit + w * i;
 
     //RGB->palette
-    DoQuantize(w, h, rows, outrows, palette, desiredNoColours);
+    DoQuantize(w, h, rows, outrows, palette, desiredNoColours, flags);
 
     delete[] rows;
     delete[] outrows;
@@ -1518,20 +1763,20 @@ bool wxQuantize::Quantize(const wxImage& src, wxImage& dest,
         if (!dest.IsOk())
             dest.Create(w, h);
 
-        imgdt = dest.GetData();
-        for (i = 0; i < w * h; i++)
-        {
-            unsigned char c = data8bit[i];
-            imgdt[3 * i + 0/*R*/] = palette[3 * c + 0];
-            imgdt[3 * i + 1/*G*/] = palette[3 * c + 1];
-            imgdt[3 * i + 2/*B*/] = palette[3 * c + 2];
-        }
+        FillDestinationInfo info;
+        info.data8bit = data8bit;
+        info.palette = palette;
+        info.dest = dest.GetData();
+        info.width = w;
+
+        wxProcessImageRows(FillDestinationRows, &info, h,
+                           static_cast<size_t>(w) * h);
     }
 
     if (eightBitData && (flags & wxQUANTIZE_RETURN_8BIT_DATA))
     {
 #ifdef __WXMSW__
-        if (flags & wxQUANTIZE_INCLUDE_WINDOWS_COLOURS)
+        if (paletteShift)
         {
             // We need to shift the palette entries up
             // to make room for the Windows system colours.
@@ -1546,7 +1791,7 @@ bool wxQuantize::Quantize(const wxImage& src, wxImage& dest,
 
 #if wxUSE_PALETTE
     // Make a wxWidgets palette
-    if (pPalette)
+    if (pPalette && !usePalette)
     {
         unsigned char* r = new unsigned char[256];
         unsigned char* g = new unsigned char[256];
@@ -1607,11 +1852,22 @@ bool wxQuantize::Quantize(const wxImage& src,
                           int flags)
 {
     wxPalette* palette = NULL;
+
+#if wxUSE_PALETTE
+    // Reuse the palette of the destination image if requested and possible,
+    // it remains set then.
+    wxPalette destPalette;
+    if ( (flags & wxQUANTIZE_USE_PALETTE) && dest.IsOk() )
+        destPalette = dest.GetPalette();
+    if ( destPalette.IsOk() )
+        palette = &destPalette;
+#endif // wxUSE_PALETTE
+
     if ( !Quantize(src, dest, & palette, desiredNoColours, eightBitData, flags) )
         return false;
 
 #if wxUSE_PALETTE
-    if (palette)
+    if (palette && palette != &destPalette)
     {
         dest.SetPalette(* palette);
         delete palette;
@@ -34,6 +34,7 @@
     #include "wx/log.h"
     #include "wx/event.h"
     #include "wx/module.h"
+    #include "wx/utils.h"
 #endif
 
 #include <stdlib.h>
@@ -64,9 +65,18 @@ enum IPCCode
     IPC_FAIL            = 9,
     IPC_CONNECT         = 10,
     IPC_DISCONNECT      = 11,
+    IPC_SHM_SETUP       = 12,
     IPC_MAX
 };
 
+// Value written instead of the data size to indicate that the data follows in
+// the shared memory ring and not in the socket stream, the real size follows.
+const wxUint32 IPC_SHM_DATA = 0xffffffff;
+
+// Smaller data is always sent via the socket, as it fits into a single write
+// to it anyhow.
+const size_t IPC_SHM_MIN_SIZE = 1448;
+
 } // anonymous namespace
 
 // headers needed for umask()
@@ -75,6 +85,32 @@ enum IPCCode
     #include <sys/stat.h>
 #endif // __UNIX_LIKE__
 
+// shared memory transport is only implemented for Linux as it relies on
+// memfd_create() and eventfd()
+#if defined(__LINUX__) && defined(__GNUC__)
+    #include <sys/eventfd.h>
+    #include <sys/mman.h>
+    #include <sys/socket.h>
+    #include <sys/syscall.h>
+    #include <fcntl.h>
+    #include <limits.h>
+    #include <poll.h>
+    #include <string.h>
+    #include <unistd.h>
+
+    #ifdef __NR_memfd_create
+        #define HAS_SHARED_MEMORY
+
+        // these constants may be missing in older headers
+        #ifndef MFD_CLOEXEC
+            #define MFD_CLOEXEC 1U
+        #endif
+        #ifndef POLLRDHUP
+            #define POLLRDHUP 0x2000
+        #endif
+    #endif
+#endif // __LINUX__
+
 // ----------------------------------------------------------------------------
 // private functions
 // ----------------------------------------------------------------------------
@@ -166,6 +202,347 @@ wxIMPLEMENT_DYNAMIC_CLASS(wxTCPEventHandlerModule, wxModule);
 
 wxTCPEventHandler *wxTCPEventHandlerModule::ms_handler = NULL;
 
+// --------------------------------------------------------------------------
+// wxIPCSharedMemory
+// --------------------------------------------------------------------------
+
+#ifdef HAS_SHARED_MEMORY
+
+namespace
+{
+
+// Positions in one of the rings: they are only ever incremented, so the
+// amount of data in the ring is just their difference. Each of them is on its
+// own cache line as they're updated by different processes.
+struct wxIPCShmRing
+{
+    wxUint64 head;              // written by the producer
+    wxUint32 readerWaiting;     // set by the consumer before sleeping
+    char pad1[52];
+
+    wxUint64 tail;              // written by the consumer
+    wxUint32 writerWaiting;     // set by the producer before sleeping
+    char pad2[52];
+};
+
+// The header at the start of the shared memory block, the data of the ring
+// used by the client for sending data starts at IPC_SHM_HEADER_SIZE and is
+// followed by the data of the ring used by the server.
+struct wxIPCShmHeader
+{
+    wxUint32 magic;
+    wxUint32 ringSize;
+    char pad[56];
+
+    wxIPCShmRing rings[2];
+};
+
+const wxUint32 IPC_SHM_MAGIC = 0x77784950; // "wxIP"
+const size_t IPC_SHM_HEADER_SIZE = 4096;
+
+// Indices of the descriptors passed to the server.
+enum
+{
+    IPC_SHM_FD_MEMORY,
+    IPC_SHM_FD_CLIENT_EVENT,    // signalled to wake up the client
+    IPC_SHM_FD_SERVER_EVENT,    // signalled to wake up the server
+    IPC_SHM_FD_COUNT
+};
+
+} // anonymous namespace
+
+// This class manages the block of memory shared between the client and the
+// server and containing two single producer/single consumer rings, one for
+// each direction. The eventfd descriptors are used to wake up the other side
+// only when it is waiting for the ring to become non-empty or non-full.
+class wxIPCSharedMemory
+{
+public:
+    // create a new block on the client side, return NULL on failure
+    static wxIPCSharedMemory *Create(int sock, size_t ringSize, int timeout)
+    {
+        // round the size to the power of 2 to be able to use masking
+        size_t size = 64*1024;
+        while ( size < ringSize && size < 0x40000000 )
+            size *= 2;
+
+        int fds[IPC_SHM_FD_COUNT];
+        fds[IPC_SHM_FD_MEMORY] = static_cast<int>(
+            syscall(__NR_memfd_create, "wxIPC", MFD_CLOEXEC));
+        fds[IPC_SHM_FD_CLIENT_EVENT] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        fds[IPC_SHM_FD_SERVER_EVENT] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+        const size_t mapSize = IPC_SHM_HEADER_SIZE + 2*size;
+        void *addr = MAP_FAILED;
+        if ( fds[IPC_SHM_FD_MEMORY] != -1 &&
+                fds[IPC_SHM_FD_CLIENT_EVENT] != -1 &&
+                    fds[IPC_SHM_FD_SERVER_EVENT] != -1 &&
+                        ftruncate(fds[IPC_SHM_FD_MEMORY], mapSize) == 0 )
+        {
+            addr = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                        fds[IPC_SHM_FD_MEMORY], 0);
+        }
+
+        if ( addr == MAP_FAILED )
+        {
+            CloseFDs(fds);
+            return NULL;
+        }
+
+        // the memory is zero-initialized, so only the header fields need to
+        // be set
+        wxIPCShmHeader * const header = static_cast<wxIPCShmHeader *>(addr);
+        header->magic = IPC_SHM_MAGIC;
+        header->ringSize = static_cast<wxUint32>(size);
+
+        return new wxIPCSharedMemory(fds, sock, addr, mapSize, false, timeout);
+    }
+
+    // map the block created by the client on the server side, takes
+    // ownership of the descriptors even in case of failure
+    static wxIPCSharedMemory *Attach(int fds[IPC_SHM_FD_COUNT],
+                                     int sock,
+                                     int timeout)
+    {
+        struct stat st;
+        if ( fstat(fds[IPC_SHM_FD_MEMORY], &st) != 0 ||
+                static_cast<size_t>(st.st_size) <= IPC_SHM_HEADER_SIZE )
+        {
+            CloseFDs(fds);
+            return NULL;
+        }
+
+        const size_t mapSize = st.st_size;
+        void * const addr = mmap(NULL, mapSize, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED, fds[IPC_SHM_FD_MEMORY], 0);
+        if ( addr == MAP_FAILED )
+        {
+            CloseFDs(fds);
+            return NULL;
+        }
+
+        const wxIPCShmHeader * const header
+            = static_cast<const wxIPCShmHeader *>(addr);
+        const size_t size = header->ringSize;
+        if ( header->magic != IPC_SHM_MAGIC ||
+                size == 0 || (size & (size - 1)) != 0 ||
+                    IPC_SHM_HEADER_SIZE + 2*size != mapSize )
+        {
+            munmap(addr, mapSize);
+            CloseFDs(fds);
+            return NULL;
+        }
+
+        return new wxIPCSharedMemory(fds, sock, addr, mapSize, true, timeout);
+    }
+
+    ~wxIPCSharedMemory()
+    {
+        munmap(m_header, m_mapSize);
+        CloseFDs(m_fds);
+    }
+
+    const int *GetFDs() const { return m_fds; }
+
+    // copy as much data as fits into the outgoing ring without blocking,
+    // return the amount of data written
+    size_t WriteAvailable(const void *data, size_t size)
+    {
+        wxIPCShmRing& ring = m_header->rings[m_isServer];
+
+        const wxUint64 head = ring.head;
+        const size_t
+            space = m_ringSize - (head - __atomic_load_n(&ring.tail,
+                                                        __ATOMIC_SEQ_CST));
+        if ( size > space )
+            size = space;
+
+        if ( size )
+        {
+            CopyToRing(m_data[m_isServer], head, data, size);
+
+            __atomic_store_n(&ring.head, head + size, __ATOMIC_SEQ_CST);
+            if ( __atomic_exchange_n(&ring.readerWaiting, 0, __ATOMIC_SEQ_CST) )
+                Signal();
+        }
+
+        return size;
+    }
+
+    // write all the data to the outgoing ring, waiting for the peer to read
+    // it if necessary
+    bool Write(const void *data, size_t size)
+    {
+        wxIPCShmRing& ring = m_header->rings[m_isServer];
+
+        const char *p = static_cast<const char *>(data);
+        while ( size )
+        {
+            const size_t written = WriteAvailable(p, size);
+            if ( written )
+            {
+                p += written;
+                size -= written;
+                continue;
+            }
+
+            // the ring is full, tell the reader that we're waiting for it
+            // and check again to avoid missing its update
+            __atomic_store_n(&ring.writerWaiting, 1, __ATOMIC_SEQ_CST);
+            if ( ring.head - __atomic_load_n(&ring.tail, __ATOMIC_SEQ_CST)
+                    == m_ringSize )
+            {
+                if ( !Wait() )
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    // read exactly the given amount of data from the incoming ring, waiting
+    // for the peer to write it if necessary
+    bool Read(void *data, size_t size)
+    {
+        const int index = !m_isServer;
+        wxIPCShmRing& ring = m_header->rings[index];
+
+        char *p = static_cast<char *>(data);
+        while ( size )
+        {
+            const wxUint64 tail = ring.tail;
+            size_t avail = __atomic_load_n(&ring.head, __ATOMIC_SEQ_CST) - tail;
+            if ( !avail )
+            {
+                __atomic_store_n(&ring.readerWaiting, 1, __ATOMIC_SEQ_CST);
+                if ( __atomic_load_n(&ring.head, __ATOMIC_SEQ_CST) == tail )
+                {
+                    if ( !Wait() )
+                        return false;
+                }
+
+                continue;
+            }
+
+            if ( avail > size )
+                avail = size;
+
+            CopyFromRing(m_data[index], tail, p, avail);
+            p += avail;
+            size -= avail;
+
+            __atomic_store_n(&ring.tail, tail + avail, __ATOMIC_SEQ_CST);
+            if ( __atomic_exchange_n(&ring.writerWaiting, 0, __ATOMIC_SEQ_CST) )
+                Signal();
+        }
+
+        return true;
+    }
+
+private:
+    wxIPCSharedMemory(const int fds[IPC_SHM_FD_COUNT],
+                      int sock,
+                      void *addr,
+                      size_t mapSize,
+                      bool isServer,
+                      int timeout)
+        : m_header(static_cast<wxIPCShmHeader *>(addr)),
+          m_mapSize(mapSize),
+          m_ringSize(m_header->ringSize),
+          m_sock(sock),
+          m_isServer(isServer),
+          m_timeout(timeout)
+    {
+        for ( int n = 0; n < IPC_SHM_FD_COUNT; n++ )
+            m_fds[n] = fds[n];
+
+        char * const data = static_cast<char *>(addr) + IPC_SHM_HEADER_SIZE;
+        m_data[0] = data;
+        m_data[1] = data + m_ringSize;
+    }
+
+    static void CloseFDs(const int fds[IPC_SHM_FD_COUNT])
+    {
+        for ( int n = 0; n < IPC_SHM_FD_COUNT; n++ )
+        {
+            if ( fds[n] != -1 )
+                close(fds[n]);
+        }
+    }
+
+    void CopyToRing(char *ring, wxUint64 pos, const void *data, size_t size)
+    {
+        const size_t offset = pos & (m_ringSize - 1);
+        const size_t first = wxMin(size, m_ringSize - offset);
+        memcpy(ring + offset, data, first);
+        memcpy(ring, static_cast<const char *>(data) + first, size - first);
+    }
+
+    void CopyFromRing(const char *ring, wxUint64 pos, void *data, size_t size)
+    {
+        const size_t offset = pos & (m_ringSize - 1);
+        const size_t first = wxMin(size, m_ringSize - offset);
+        memcpy(data, ring + offset, first);
+        memcpy(static_cast<char *>(data) + first, ring, size - first);
+    }
+
+    // wake up the peer
+    void Signal()
+    {
+        eventfd_write(m_fds[m_isServer ? IPC_SHM_FD_CLIENT_EVENT
+                                       : IPC_SHM_FD_SERVER_EVENT], 1);
+    }
+
+    // wait until the peer wakes us up, returns false if it didn't happen
+    // before the timeout expired or if the connection was closed
+    bool Wait()
+    {
+        const int fd = m_fds[m_isServer ? IPC_SHM_FD_SERVER_EVENT
+                                        : IPC_SHM_FD_CLIENT_EVENT];
+
+        // notice that we don't wait for the input on the socket, as there may
+        // be other messages in it, but only for it being closed
+        pollfd fds[2];
+        fds[0].fd = fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = m_sock;
+        fds[1].events = POLLRDHUP;
+
+        int rc;
+        do
+        {
+            rc = poll(fds, WXSIZEOF(fds), m_timeout);
+        } while ( rc == -1 && errno == EINTR );
+
+        if ( rc <= 0 || fds[1].revents )
+            return false;
+
+        eventfd_t value;
+        eventfd_read(fd, &value);
+
+        return true;
+    }
+
+
+    wxIPCShmHeader * const m_header;
+    const size_t m_mapSize;
+    const size_t m_ringSize;
+    char *m_data[2];
+
+    int m_fds[IPC_SHM_FD_COUNT];
+    const int m_sock;
+
+    // the server writes to the second ring and reads from the first one
+    const bool m_isServer;
+
+    // timeout for waiting for the peer in milliseconds
+    const int m_timeout;
+
+    wxDECLARE_NO_COPY_CLASS(wxIPCSharedMemory);
+};
+
+#endif // HAS_SHARED_MEMORY
+
 // --------------------------------------------------------------------------
 // wxIPCSocketStreams
 // --------------------------------------------------------------------------
@@ -193,6 +570,32 @@ public:
           m_dataIn(m_socketStream),
           m_dataOut(m_bufferedOut)
     {
+#ifdef HAS_SHARED_MEMORY
+        m_shm = NULL;
+#endif // HAS_SHARED_MEMORY
+    }
+
+#ifdef HAS_SHARED_MEMORY
+    ~wxIPCSocketStreams() { delete m_shm; }
+
+    // start using the given shared memory block for transferring data, takes
+    // ownership of the pointer
+    void SetSharedMemory(wxIPCSharedMemory *shm)
+    {
+        delete m_shm;
+        m_shm = shm;
+    }
+
+    wxIPCSharedMemory *GetSharedMemory() const { return m_shm; }
+#endif // HAS_SHARED_MEMORY
+
+    bool UsesSharedMemory() const
+    {
+#ifdef HAS_SHARED_MEMORY
+        return m_shm != NULL;
+#else
+        return false;
+#endif
     }
 
     // expose the IO methods needed by IPC code (notice that writing is only
@@ -238,6 +641,18 @@ public:
 
         *size = Read32();
 
+#ifdef HAS_SHARED_MEMORY
+        if ( *size == IPC_SHM_DATA && m_shm )
+        {
+            *size = Read32();
+
+            void * const data = conn->GetBufferAtLeast(*size);
+            wxCHECK_MSG( data, NULL, "IPC buffer allocation failed" );
+
+            return m_shm->Read(data, *size) ? data : NULL;
+        }
+#endif // HAS_SHARED_MEMORY
+
         void * const data = conn->GetBufferAtLeast(*size);
         wxCHECK_MSG( data, NULL, "IPC buffer allocation failed" );
 
@@ -280,6 +695,11 @@ private:
     wxDataInputStream  m_dataIn;
     wxDataOutputStream m_dataOut;
 
+#ifdef HAS_SHARED_MEMORY
+    // the shared memory used for big data transfers, may be NULL
+    wxIPCSharedMemory *m_shm;
+#endif // HAS_SHARED_MEMORY
+
     wxDECLARE_NO_COPY_CLASS(wxIPCSocketStreams);
 };
 
@@ -326,11 +746,32 @@ public:
         Write8(format);
     }
 
-    // write arbitrary data
-    void WriteData(const void *data, size_t size)
+    // write arbitrary data, return false only if writing it to the shared
+    // memory failed
+    bool WriteData(const void *data, size_t size)
     {
+#ifdef HAS_SHARED_MEMORY
+        wxIPCSharedMemory * const shm = m_streams.GetSharedMemory();
+        if ( shm && size >= IPC_SHM_MIN_SIZE )
+        {
+            // copy as much as we can before sending the header, so that the
+            // reader doesn't need to wait for the data in the common case
+            // of it fitting into the ring entirely
+            const size_t written = shm->WriteAvailable(data, size);
+
+            m_streams.GetDataOut().Write32(IPC_SHM_DATA);
+            m_streams.GetDataOut().Write32(size);
+            m_streams.Flush();
+
+            return shm->Write(static_cast<const char *>(data) + written,
+                              size - written);
+        }
+#endif // HAS_SHARED_MEMORY
+
         m_streams.GetDataOut().Write32(size);
         m_streams.GetUnformattedOut().Write(data, size);
+
+        return true;
     }
 
 
@@ -340,6 +781,218 @@ private:
     wxDECLARE_NO_COPY_CLASS(IPCOutput);
 };
 
+#ifdef HAS_SHARED_MEMORY
+
+// return the timeout to use for the shared memory operations on this socket
+// in milliseconds
+int GetSharedMemoryTimeout(const wxSocketBase& sock)
+{
+    const long timeout = sock.GetTimeout();
+    return timeout < INT_MAX / 1000 ? static_cast<int>(timeout*1000) : INT_MAX;
+}
+
+// wait until the socket becomes ready for the given operation
+bool WaitForSocket(int sock, short events, int timeout)
+{
+    pollfd pfd;
+    pfd.fd = sock;
+    pfd.events = events;
+
+    int rc;
+    do
+    {
+        rc = poll(&pfd, 1, timeout);
+    } while ( rc == -1 && errno == EINTR );
+
+    return rc == 1 && (pfd.revents & events);
+}
+
+// send the shared memory descriptors to the peer as ancillary data of a single
+// byte written directly to the socket
+bool SendSharedMemoryFDs(int sock, const int *fds, int timeout)
+{
+    char msg = IPC_SHM_SETUP;
+    iovec iov;
+    iov.iov_base = &msg;
+    iov.iov_len = 1;
+
+    char control[CMSG_SPACE(IPC_SHM_FD_COUNT*sizeof(int))];
+    memset(control, 0, sizeof(control));
+
+    msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control;
+    hdr.msg_controllen = sizeof(control);
+
+    cmsghdr * const cmsg = CMSG_FIRSTHDR(&hdr);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(IPC_SHM_FD_COUNT*sizeof(int));
+    memcpy(CMSG_DATA(cmsg), fds, IPC_SHM_FD_COUNT*sizeof(int));
+
+    for ( ;; )
+    {
+        const ssize_t rc = sendmsg(sock, &hdr, MSG_NOSIGNAL);
+        if ( rc == 1 )
+            return true;
+
+        if ( rc == -1 && errno == EINTR )
+            continue;
+
+        if ( rc != -1 || errno != EAGAIN ||
+                !WaitForSocket(sock, POLLOUT, timeout) )
+            return false;
+    }
+}
+
+// receive the descriptors sent by SendSharedMemoryFDs()
+bool ReceiveSharedMemoryFDs(int sock, int *fds, int timeout)
+{
+    char msg;
+    iovec iov;
+    iov.iov_base = &msg;
+    iov.iov_len = 1;
+
+    char control[CMSG_SPACE(IPC_SHM_FD_COUNT*sizeof(int))];
+
+    msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control;
+    hdr.msg_controllen = sizeof(control);
+
+    ssize_t rc;
+    for ( ;; )
+    {
+        rc = recvmsg(sock, &hdr, MSG_CMSG_CLOEXEC);
+        if ( rc != -1 )
+            break;
+
+        if ( errno == EINTR )
+            continue;
+
+        if ( errno != EAGAIN || !WaitForSocket(sock, POLLIN, timeout) )
+            return false;
+    }
+
+    cmsghdr * const cmsg = CMSG_FIRSTHDR(&hdr);
+    if ( !cmsg || cmsg->cmsg_level != SOL_SOCKET ||
+            cmsg->cmsg_type != SCM_RIGHTS )
+        return false;
+
+    const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    if ( count != IPC_SHM_FD_COUNT || rc != 1 || msg != IPC_SHM_SETUP ||
+            (hdr.msg_flags & MSG_CTRUNC) )
+    {
+        // don't leak the descriptors we did receive
+        const int * const received = reinterpret_cast<int *>(CMSG_DATA(cmsg));
+        for ( size_t n = 0; n < count; n++ )
+            close(received[n]);
+
+        return false;
+    }
+
+    memcpy(fds, CMSG_DATA(cmsg), IPC_SHM_FD_COUNT*sizeof(int));
+
+    return true;
+}
+
+// check if this socket can be used for passing the descriptors
+bool IsUnixSocket(int sock)
+{
+    sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    return getsockname(sock, reinterpret_cast<sockaddr *>(&addr), &len) == 0 &&
+                addr.ss_family == AF_UNIX;
+}
+
+#endif // HAS_SHARED_MEMORY
+
+// negotiate the use of the shared memory with the server on the client side
+//
+// notice that failing to use shared memory is not an error, this function
+// only returns false if the connection can't be used any longer
+bool
+SetupSharedMemory(wxSocketBase& sock, wxIPCSocketStreams *streams, size_t size)
+{
+#ifdef HAS_SHARED_MEMORY
+    const int fd = sock.GetSocket();
+    if ( !IsUnixSocket(fd) )
+        return true;
+
+    const int timeout = GetSharedMemoryTimeout(sock);
+    wxIPCSharedMemory * const
+        shm = wxIPCSharedMemory::Create(fd, size, timeout);
+    if ( !shm )
+        return true;
+
+    // the servers not supporting shared memory just reply with IPC_FAIL
+    IPCOutput(streams).Write8(IPC_SHM_SETUP);
+    if ( streams->Read8() != IPC_SHM_SETUP )
+    {
+        delete shm;
+        return true;
+    }
+
+    if ( !SendSharedMemoryFDs(fd, shm->GetFDs(), timeout) )
+    {
+        delete shm;
+        return false;
+    }
+
+    if ( streams->Read8() != IPC_SHM_SETUP )
+    {
+        delete shm;
+        return true;
+    }
+
+    streams->SetSharedMemory(shm);
+#else // !HAS_SHARED_MEMORY
+    wxUnusedVar(sock);
+    wxUnusedVar(streams);
+    wxUnusedVar(size);
+#endif // HAS_SHARED_MEMORY/!HAS_SHARED_MEMORY
+
+    return true;
+}
+
+// handle IPC_SHM_SETUP request on the server side, return false if shared
+// memory can't be used for this connection
+bool AcceptSharedMemory(wxSocketBase& sock, wxIPCSocketStreams *streams)
+{
+#ifdef HAS_SHARED_MEMORY
+    const int fd = sock.GetSocket();
+    if ( streams->UsesSharedMemory() || !IsUnixSocket(fd) )
+        return false;
+
+    // tell the client that we're ready to receive the descriptors
+    IPCOutput(streams).Write8(IPC_SHM_SETUP);
+
+    const int timeout = GetSharedMemoryTimeout(sock);
+    int fds[IPC_SHM_FD_COUNT];
+    if ( !ReceiveSharedMemoryFDs(fd, fds, timeout) )
+        return false;
+
+    wxIPCSharedMemory * const
+        shm = wxIPCSharedMemory::Attach(fds, fd, timeout);
+    if ( !shm )
+        return false;
+
+    streams->SetSharedMemory(shm);
+    IPCOutput(streams).Write8(IPC_SHM_SETUP);
+
+    return true;
+#else // !HAS_SHARED_MEMORY
+    wxUnusedVar(sock);
+    wxUnusedVar(streams);
+
+    return false;
+#endif // HAS_SHARED_MEMORY/!HAS_SHARED_MEMORY
+}
+
 } // anonymous namespace
 
 // ==========================================================================
@@ -357,6 +1010,7 @@ wxIMPLEMENT_CLASS(wxTCPConnection, wxConnectionBase);
 wxTCPClient::wxTCPClient()
            : wxClientBase()
 {
+    m_sharedMemorySize = 0;
 }
 
 bool wxTCPClient::ValidHost(const wxString& host)
@@ -388,7 +1042,13 @@ wxConnectionBase *wxTCPClient::MakeConnection(const wxString& host,
         unsigned char msg = streams->Read8();
 
         // OK! Confirmation.
-        if (msg == IPC_CONNECT)
+        //
+        // Also try to switch to using the shared memory if requested, this
+        // is done before enabling the socket events as it reads the replies
+        // from the server synchronously
+        if ( msg == IPC_CONNECT &&
+                (!m_sharedMemorySize ||
+                    SetupSharedMemory(*client, streams, m_sharedMemorySize)) )
         {
             wxTCPConnection *
                 connection = (wxTCPConnection *)OnMakeConnection ();
@@ -564,6 +1224,11 @@ void wxTCPConnection::Compress(bool WXUNUSED(on))
     // TODO
 }
 
+bool wxTCPConnection::UsesSharedMemory() const
+{
+    return m_streams && m_streams->UsesSharedMemory();
+}
+
 // Calls that CLIENT can make.
 bool wxTCPConnection::Disconnect()
 {
@@ -596,9 +1261,7 @@ bool wxTCPConnection::DoExecute(const void *data,
     out.Write8(IPC_EXECUTE);
     out.Write8(format);
 
-    out.WriteData(data, size);
-
-    return true;
+    return out.WriteData(data, size);
 }
 
 const void *wxTCPConnection::Request(const wxString& item,
@@ -631,9 +1294,7 @@ bool wxTCPConnection::DoPoke(const wxString& item,
 
     IPCOutput out(m_streams);
     out.Write(IPC_POKE, item, format);
-    out.WriteData(data, size);
-
-    return true;
+    return out.WriteData(data, size);
 }
 
 bool wxTCPConnection::StartAdvise(const wxString& item)
@@ -671,9 +1332,7 @@ bool wxTCPConnection::DoAdvise(const wxString& item,
 
     IPCOutput out(m_streams);
     out.Write(IPC_ADVISE, item, format);
-    out.WriteData(data, size);
-
-    return true;
+    return out.WriteData(data, size);
 }
 
 // --------------------------------------------------------------------------
@@ -840,6 +1499,12 @@ void wxTCPEventHandler::Client_OnRequest(wxSocketEvent &event)
             HandleDisconnect(connection);
             break;
 
+        case IPC_SHM_SETUP:
+            // this replies with IPC_SHM_SETUP itself on success
+            if ( !AcceptSharedMemory(*connection->m_sock, streams) )
+                error = true;
+            break;
+
         case IPC_FAIL:
             wxLogDebug("Unexpected IPC_FAIL received");
             error = true;
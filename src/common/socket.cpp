@@ -40,13 +40,23 @@
 #include "wx/stopwatch.h"
 #include "wx/thread.h"
 #include "wx/evtloop.h"
+#include "wx/file.h"
 #include "wx/link.h"
+#include "wx/scopedarray.h"
+#include "wx/vector.h"
 
 #include "wx/private/fd.h"
 #include "wx/private/socket.h"
 
 #ifdef __UNIX__
     #include <errno.h>
+    #include <sys/uio.h>
+#endif
+
+#ifdef __LINUX__
+    #include <fcntl.h>
+    #include <signal.h>
+    #include <sys/sendfile.h>
 #endif
 
 // we use MSG_NOSIGNAL to avoid getting SIGPIPE when sending data to a remote
@@ -312,6 +322,7 @@ wxSocketImpl::wxSocketImpl(wxSocketBase& wxsocket)
 
     m_establishing    = false;
     m_reusable        = false;
+    m_reusablePort    = false;
     m_broadcast       = false;
     m_dobind          = true;
     m_initialRecvBufferSize = -1;
@@ -351,6 +362,15 @@ void wxSocketImpl::PostCreation()
     if ( m_reusable )
         EnableSocketOption(SO_REUSEADDR);
 
+    if ( m_reusablePort )
+    {
+#ifdef SO_REUSEPORT
+        EnableSocketOption(SO_REUSEPORT);
+#else
+        wxLogDebug("SO_REUSEPORT is not supported on this platform");
+#endif
+    }
+
     if ( m_broadcast )
     {
         wxASSERT_MSG( !m_stream, "broadcasting is for datagram sockets only" );
@@ -416,7 +436,9 @@ wxSocketError wxSocketImpl::CreateServer()
 
     if ( IsOk() )
     {
-        if ( listen(m_fd, 5) != 0 )
+        // use the maximal backlog allowed by the system as a short queue
+        // results in refused connections when many clients connect at once
+        if ( listen(m_fd, SOMAXCONN) != 0 )
             m_error = wxSOCKET_IOERR;
     }
 
@@ -651,19 +673,22 @@ int wxSocketImpl::RecvStream(void *buffer, int size)
     DO_WHILE_EINTR( ret, recv(m_fd, static_cast<char *>(buffer), size, 0) );
 
     if ( !ret )
-    {
-        // receiving 0 bytes for a TCP socket indicates that the connection was
-        // closed by peer so shut down our end as well (for UDP sockets empty
-        // datagrams are also possible)
-        m_establishing = false;
-        NotifyOnStateChange(wxSOCKET_LOST);
+        OnStreamClosed();
 
-        Shutdown();
+    return ret;
+}
 
-        // do not return an error in this case however
-    }
+void wxSocketImpl::OnStreamClosed()
+{
+    // receiving 0 bytes for a TCP socket indicates that the connection was
+    // closed by peer so shut down our end as well (for UDP sockets empty
+    // datagrams are also possible)
+    m_establishing = false;
+    NotifyOnStateChange(wxSOCKET_LOST);
 
-    return ret;
+    Shutdown();
+
+    // do not return an error in this case however
 }
 
 int wxSocketImpl::SendStream(const void *buffer, int size)
@@ -746,6 +771,215 @@ int wxSocketImpl::Write(const void *buffer, int size)
     return ret;
 }
 
+#ifdef __UNIX__
+
+// maximal number of buffers passed to a single recvmsg() or sendmsg() call,
+// the callers just call us again if there are more of them
+static const int MAX_IOV_COUNT = 64;
+
+// fill the iovec array with the given buffers and return their number
+static int InitIOVec(iovec *iov, const wxSocketBuffer *buffers, int count)
+{
+    if ( count > MAX_IOV_COUNT )
+        count = MAX_IOV_COUNT;
+
+    for ( int n = 0; n < count; n++ )
+    {
+        iov[n].iov_base = buffers[n].data;
+        iov[n].iov_len = buffers[n].size;
+    }
+
+    return count;
+}
+
+int wxSocketImpl::ReadV(const wxSocketBuffer *buffers, int count)
+{
+    if ( m_fd == INVALID_SOCKET || m_server )
+    {
+        m_error = wxSOCKET_INVSOCK;
+        return -1;
+    }
+
+    iovec iov[MAX_IOV_COUNT];
+
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = InitIOVec(iov, buffers, count);
+
+    wxSockAddressStorage from;
+    if ( !m_stream )
+    {
+        msg.msg_name = &from.addr;
+        msg.msg_namelen = sizeof(from);
+    }
+
+    int ret;
+    DO_WHILE_EINTR( ret, recvmsg(m_fd, &msg, 0) );
+
+    if ( ret == SOCKET_ERROR )
+    {
+        m_error = GetLastError();
+        return ret;
+    }
+
+    if ( m_stream )
+    {
+        if ( !ret )
+            OnStreamClosed();
+    }
+    else
+    {
+        m_peer = wxSockAddressImpl(from.addr, msg.msg_namelen);
+        if ( !m_peer.IsOk() )
+        {
+            m_error = wxSOCKET_IOERR;
+            return -1;
+        }
+    }
+
+    m_error = wxSOCKET_NOERROR;
+
+    return ret;
+}
+
+int wxSocketImpl::WriteV(const wxSocketBuffer *buffers, int count)
+{
+    if ( m_fd == INVALID_SOCKET || m_server )
+    {
+        m_error = wxSOCKET_INVSOCK;
+        return -1;
+    }
+
+    iovec iov[MAX_IOV_COUNT];
+
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = InitIOVec(iov, buffers, count);
+
+    if ( !m_stream )
+    {
+        if ( !m_peer.IsOk() )
+        {
+            m_error = wxSOCKET_INVADDR;
+            return -1;
+        }
+
+        msg.msg_name = const_cast<sockaddr *>(m_peer.GetAddr());
+        msg.msg_namelen = m_peer.GetLen();
+    }
+
+#ifdef wxNEEDS_IGNORE_SIGPIPE
+    IgnoreSignal ignore(SIGPIPE);
+#endif
+
+    int ret;
+    DO_WHILE_EINTR( ret, sendmsg(m_fd, &msg, wxSOCKET_MSG_NOSIGNAL) );
+
+    m_error = ret == SOCKET_ERROR ? GetLastError() : wxSOCKET_NOERROR;
+
+    return ret;
+}
+
+#else // !__UNIX__
+
+// Without native support for scatter/gather IO just use the first non-empty
+// buffer, the callers will call us again for the remaining ones.
+int wxSocketImpl::ReadV(const wxSocketBuffer *buffers, int count)
+{
+    for ( int n = 0; n < count; n++ )
+    {
+        if ( buffers[n].size )
+            return Read(buffers[n].data, buffers[n].size);
+    }
+
+    return 0;
+}
+
+int wxSocketImpl::WriteV(const wxSocketBuffer *buffers, int count)
+{
+    for ( int n = 0; n < count; n++ )
+    {
+        if ( buffers[n].size )
+            return Write(buffers[n].data, buffers[n].size);
+    }
+
+    return 0;
+}
+
+#endif // __UNIX__/!__UNIX__
+
+#ifdef __LINUX__
+
+int wxSocketImpl::SendFile(int fd, wxFileOffset offset, int size, bool isPipe)
+{
+    if ( m_fd == INVALID_SOCKET || m_server || !m_stream )
+    {
+        m_error = wxSOCKET_INVSOCK;
+        return -1;
+    }
+
+    // neither sendfile() nor splice() have MSG_NOSIGNAL equivalent, so block
+    // SIGPIPE in this thread while using them and discard it if it was
+    // generated, as is done with the other socket functions
+    sigset_t sigpipe,
+             oldmask;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, &oldmask);
+
+    ssize_t ret;
+    if ( isPipe )
+    {
+        // pipes don't support offsets, but can be spliced to the socket (we
+        // don't use SPLICE_F_NONBLOCK as we want to wait for the data in the
+        // pipe, while the socket side is still non-blocking if the socket is)
+        DO_WHILE_EINTR( ret, splice(fd, NULL, m_fd, NULL, size,
+                                    SPLICE_F_MOVE) );
+    }
+    else
+    {
+        off_t off = offset;
+        DO_WHILE_EINTR( ret, sendfile(m_fd, fd, &off, size) );
+    }
+
+    const int err = errno;
+    if ( ret == -1 && err == EPIPE && !sigismember(&oldmask, SIGPIPE) )
+    {
+        const timespec zero = { 0, 0 };
+        sigtimedwait(&sigpipe, NULL, &zero);
+    }
+
+    pthread_sigmask(SIG_SETMASK, &oldmask, NULL);
+
+    if ( ret == -1 )
+    {
+        switch ( err )
+        {
+            case EINVAL:
+            case ENOSYS:
+            case EOPNOTSUPP:
+                // not supported for this kind of file, the caller should
+                // fall back to copying the data
+                m_error = wxSOCKET_INVOP;
+                break;
+
+            default:
+                errno = err;
+                m_error = GetLastError();
+        }
+
+        return -1;
+    }
+
+    m_error = wxSOCKET_NOERROR;
+
+    return static_cast<int>(ret);
+}
+
+#endif // __LINUX__
+
 // ==========================================================================
 // wxSocketBase
 // ==========================================================================
@@ -967,22 +1201,63 @@ wxSocketBase& wxSocketBase::Read(void* buffer, wxUint32 nbytes)
     return *this;
 }
 
-wxUint32 wxSocketBase::DoRead(void* buffer_, wxUint32 nbytes)
+wxUint32 wxSocketBase::DoRead(void* buffer, wxUint32 nbytes)
+{
+    wxCHECK_MSG( buffer, 0, "NULL buffer" );
+
+    wxSocketBuffer buf(buffer, nbytes);
+    return DoReadV(&buf, 1);
+}
+
+namespace
+{
+
+// skip the given number of bytes in the buffers array, also skipping any
+// empty buffers
+void AdvanceBuffers(wxSocketBuffer *&buffers, size_t& count, wxUint32 nbytes)
+{
+    while ( count && nbytes >= buffers->size )
+    {
+        nbytes -= buffers->size;
+        buffers++;
+        count--;
+    }
+
+    if ( count )
+    {
+        buffers->data = static_cast<char *>(buffers->data) + nbytes;
+        buffers->size -= nbytes;
+    }
+}
+
+} // anonymous namespace
+
+wxUint32 wxSocketBase::DoReadV(wxSocketBuffer *buffers, size_t count)
 {
     wxCHECK_MSG( m_impl, 0, "socket must be valid" );
 
-    // We use pointer arithmetic here which doesn't work with void pointers.
-    char *buffer = static_cast<char *>(buffer_);
-    wxCHECK_MSG( buffer, 0, "NULL buffer" );
+    for ( size_t n = 0; n < count; n++ )
+    {
+        wxCHECK_MSG( buffers[n].data || !buffers[n].size, 0, "NULL buffer" );
+    }
+
+    AdvanceBuffers(buffers, count, 0);
 
     // Try the push back buffer first, even before checking whether the socket
     // is valid to allow reading previously pushed back data from an already
     // closed socket.
-    wxUint32 total = GetPushback(buffer, nbytes, false);
-    nbytes -= total;
-    buffer += total;
+    wxUint32 total = 0;
+    while ( count )
+    {
+        const wxUint32 pushback = GetPushback(buffers->data, buffers->size, false);
+        if ( !pushback )
+            break;
+
+        total += pushback;
+        AdvanceBuffers(buffers, count, pushback);
+    }
 
-    while ( nbytes )
+    while ( count )
     {
         // our socket is non-blocking so Read() will return immediately if
         // there is nothing to read yet and it's more efficient to try it first
@@ -990,9 +1265,13 @@ wxUint32 wxSocketBase::DoRead(void* buffer_, wxUint32 nbytes)
         // events and, even more importantly, we must do this under Windows
         // where we're not going to get notifications about socket being ready
         // for reading before we read all the existing data from it
-        const int ret = !m_impl->m_stream || m_connected
-                            ? m_impl->Read(buffer, nbytes)
-                            : 0;
+        int ret = 0;
+        if ( !m_impl->m_stream || m_connected )
+        {
+            ret = count == 1 ? m_impl->Read(buffers->data, buffers->size)
+                             : m_impl->ReadV(buffers, static_cast<int>(count));
+        }
+
         if ( ret == -1 )
         {
             if ( m_impl->GetLastError() == wxSOCKET_WOULDBLOCK )
@@ -1046,13 +1325,25 @@ wxUint32 wxSocketBase::DoRead(void* buffer_, wxUint32 nbytes)
         if ( !(m_flags & wxSOCKET_WAITALL_READ) )
             break;
 
-        nbytes -= ret;
-        buffer += ret;
+        AdvanceBuffers(buffers, count, ret);
     }
 
     return total;
 }
 
+wxSocketBase& wxSocketBase::ReadV(const wxSocketBuffer *buffers, size_t count)
+{
+    wxSocketReadGuard read(this);
+
+    // make a copy as DoReadV() modifies the buffers
+    wxVector<wxSocketBuffer> bufs(buffers, buffers + count);
+
+    m_lcount_read = count ? DoReadV(&bufs[0], count) : 0;
+    m_lcount = m_lcount_read;
+
+    return *this;
+}
+
 wxSocketBase& wxSocketBase::ReadMsg(void* buffer, wxUint32 nbytes)
 {
     struct
@@ -1089,12 +1380,35 @@ wxSocketBase& wxSocketBase::ReadMsg(void* buffer, wxUint32 nbytes)
             else
                 len2 = 0;
 
-            // Don't attempt to read if the msg was zero bytes long.
-            m_lcount_read = len ? DoRead(buffer, len) : 0;
-            m_lcount = m_lcount_read;
+            if ( !len2 )
+            {
+                // Read the data and the trailer at once if there is nothing
+                // to discard between them.
+                wxSocketBuffer buffers[2];
+                buffers[0] = wxSocketBuffer(buffer, len);
+                buffers[1] = wxSocketBuffer(&msg, sizeof(msg));
+
+                const wxUint32 total = DoReadV(buffers, WXSIZEOF(buffers));
 
-            if ( len2 )
+                m_lcount_read = wxMin(total, len);
+                m_lcount = m_lcount_read;
+
+                if ( total == len + sizeof(msg) )
+                {
+                    sig = (wxUint32)msg.sig[0];
+                    sig |= (wxUint32)(msg.sig[1] << 8);
+                    sig |= (wxUint32)(msg.sig[2] << 16);
+                    sig |= (wxUint32)(msg.sig[3] << 24);
+
+                    if ( sig == 0xdeadfeed )
+                        ok = true;
+                }
+            }
+            else
             {
+                m_lcount_read = DoRead(buffer, len);
+                m_lcount = m_lcount_read;
+
                 char discard_buffer[MAX_DISCARD_SIZE];
                 long discard_len;
 
@@ -1108,17 +1422,17 @@ wxSocketBase& wxSocketBase::ReadMsg(void* buffer, wxUint32 nbytes)
                     len2 -= (wxUint32)discard_len;
                 }
                 while ((discard_len > 0) && len2);
-            }
 
-            if ( !len2 && DoRead(&msg, sizeof(msg)) == sizeof(msg) )
-            {
-                sig = (wxUint32)msg.sig[0];
-                sig |= (wxUint32)(msg.sig[1] << 8);
-                sig |= (wxUint32)(msg.sig[2] << 16);
-                sig |= (wxUint32)(msg.sig[3] << 24);
+                if ( !len2 && DoRead(&msg, sizeof(msg)) == sizeof(msg) )
+                {
+                    sig = (wxUint32)msg.sig[0];
+                    sig |= (wxUint32)(msg.sig[1] << 8);
+                    sig |= (wxUint32)(msg.sig[2] << 16);
+                    sig |= (wxUint32)(msg.sig[3] << 24);
 
-                if ( sig == 0xdeadfeed )
-                    ok = true;
+                    if ( sig == 0xdeadfeed )
+                        ok = true;
+                }
             }
         }
     }
@@ -1153,18 +1467,30 @@ wxSocketBase& wxSocketBase::Write(const void *buffer, wxUint32 nbytes)
     return *this;
 }
 
-// This function is a mirror image of DoRead() except that it doesn't use the
+wxUint32 wxSocketBase::DoWrite(const void *buffer, wxUint32 nbytes)
+{
+    wxCHECK_MSG( buffer, 0, "NULL buffer" );
+
+    wxSocketBuffer buf(buffer, nbytes);
+    return DoWriteV(&buf, 1);
+}
+
+// This function is a mirror image of DoReadV() except that it doesn't use the
 // push back buffer and doesn't treat 0 return value specially (normally this
 // shouldn't happen at all here), so please see comments there for explanations
-wxUint32 wxSocketBase::DoWrite(const void *buffer_, wxUint32 nbytes)
+wxUint32 wxSocketBase::DoWriteV(wxSocketBuffer *buffers, size_t count)
 {
     wxCHECK_MSG( m_impl, 0, "socket must be valid" );
 
-    const char *buffer = static_cast<const char *>(buffer_);
-    wxCHECK_MSG( buffer, 0, "NULL buffer" );
+    for ( size_t n = 0; n < count; n++ )
+    {
+        wxCHECK_MSG( buffers[n].data || !buffers[n].size, 0, "NULL buffer" );
+    }
+
+    AdvanceBuffers(buffers, count, 0);
 
     wxUint32 total = 0;
-    while ( nbytes )
+    while ( count )
     {
         if ( m_impl->m_stream && !m_connected )
         {
@@ -1173,7 +1499,9 @@ wxUint32 wxSocketBase::DoWrite(const void *buffer_, wxUint32 nbytes)
             break;
         }
 
-        const int ret = m_impl->Write(buffer, nbytes);
+        const int ret = count == 1
+                            ? m_impl->Write(buffers->data, buffers->size)
+                            : m_impl->WriteV(buffers, static_cast<int>(count));
         if ( ret == -1 )
         {
             if ( m_impl->GetLastError() == wxSOCKET_WOULDBLOCK )
@@ -1201,13 +1529,151 @@ wxUint32 wxSocketBase::DoWrite(const void *buffer_, wxUint32 nbytes)
         if ( !(m_flags & wxSOCKET_WAITALL_WRITE) )
             break;
 
-        nbytes -= ret;
-        buffer += ret;
+        AdvanceBuffers(buffers, count, ret);
+    }
+
+    return total;
+}
+
+wxSocketBase& wxSocketBase::WriteV(const wxSocketBuffer *buffers, size_t count)
+{
+    wxSocketWriteGuard write(this);
+
+    wxVector<wxSocketBuffer> bufs(buffers, buffers + count);
+
+    m_lcount_write = count ? DoWriteV(&bufs[0], count) : 0;
+    m_lcount = m_lcount_write;
+
+    return *this;
+}
+
+#if wxUSE_FILE
+
+wxSocketBase& wxSocketBase::SendFile(wxFile& file,
+                                     wxFileOffset offset,
+                                     wxFileOffset size)
+{
+    wxSocketWriteGuard write(this);
+
+    wxSocketWaitModeChanger changeFlags(this, wxSOCKET_WAITALL_WRITE);
+
+    const wxFileOffset total = DoSendFile(file, offset, size);
+
+    m_lcount_write = total > wxUINT32_MAX ? wxUINT32_MAX
+                                          : static_cast<wxUint32>(total);
+    m_lcount = m_lcount_write;
+
+    if ( size != wxInvalidOffset && total != size && !Error() )
+        SetError(wxSOCKET_IOERR);
+
+    return *this;
+}
+
+wxFileOffset
+wxSocketBase::DoSendFile(wxFile& file, wxFileOffset offset, wxFileOffset size)
+{
+    wxCHECK_MSG( m_impl, 0, "socket must be valid" );
+    wxCHECK_MSG( file.IsOpened(), 0, "file must be opened" );
+    wxCHECK_MSG( offset >= 0, 0, "invalid offset" );
+
+    const bool isPipe = file.GetKind() == wxFILE_KIND_PIPE;
+
+    wxFileOffset total = 0;
+
+#ifdef __LINUX__
+    // Try sending the data directly from the kernel first, this avoids
+    // copying it to and from the user space.
+    while ( size == wxInvalidOffset || total < size )
+    {
+        if ( !m_connected )
+        {
+            SetError(wxSOCKET_IOERR);
+            return total;
+        }
+
+        // sendfile() can't send more than this in one go anyhow
+        wxFileOffset chunk = 0x7ffff000;
+        if ( size != wxInvalidOffset && size - total < chunk )
+            chunk = size - total;
+
+        const int ret = m_impl->SendFile(file.fd(), offset + total,
+                                         static_cast<int>(chunk), isPipe);
+        if ( ret == -1 )
+        {
+            const wxSocketError err = m_impl->GetLastError();
+            if ( err == wxSOCKET_WOULDBLOCK )
+            {
+                if ( !DoWaitWithTimeout(wxSOCKET_OUTPUT_FLAG) )
+                {
+                    SetError(wxSOCKET_TIMEDOUT);
+                    return total;
+                }
+
+                continue;
+            }
+
+            // fall back to copying the data below if this file can't be
+            // used with sendfile(), but only if nothing was sent yet
+            if ( err == wxSOCKET_INVOP && !total )
+            {
+                SetError(wxSOCKET_NOERROR);
+                break;
+            }
+
+            SetError(wxSOCKET_IOERR);
+            return total;
+        }
+
+        if ( !ret )
+        {
+            // end of file
+            return total;
+        }
+
+        total += ret;
+    }
+
+    if ( size != wxInvalidOffset && total == size )
+        return total;
+#endif // __LINUX__
+
+    // Generic implementation copying the data using an intermediate buffer.
+    if ( !isPipe && file.Seek(offset) == wxInvalidOffset )
+    {
+        SetError(wxSOCKET_IOERR);
+        return total;
+    }
+
+    static const size_t BUF_SIZE = 64*1024;
+    wxScopedArray<char> buf(BUF_SIZE);
+
+    while ( size == wxInvalidOffset || total < size )
+    {
+        size_t chunk = BUF_SIZE;
+        if ( size != wxInvalidOffset && size - total < (wxFileOffset)chunk )
+            chunk = static_cast<size_t>(size - total);
+
+        const ssize_t count = file.Read(buf.get(), chunk);
+        if ( count == wxInvalidOffset )
+        {
+            SetError(wxSOCKET_IOERR);
+            break;
+        }
+
+        if ( !count )
+            break;
+
+        const wxUint32 written = DoWrite(buf.get(), count);
+        total += written;
+        if ( written != static_cast<wxUint32>(count) )
+            break;
     }
 
     return total;
 }
 
+#endif // wxUSE_FILE
+
 wxSocketBase& wxSocketBase::WriteMsg(const void *buffer, wxUint32 nbytes)
 {
     struct
@@ -1230,28 +1696,38 @@ wxSocketBase& wxSocketBase::WriteMsg(const void *buffer, wxUint32 nbytes)
     msg.len[2] = (unsigned char) ((nbytes >> 16) & 0xff);
     msg.len[3] = (unsigned char) ((nbytes >> 24) & 0xff);
 
-    bool ok = false;
-    if ( DoWrite(&msg, sizeof(msg)) == sizeof(msg) )
+    struct
     {
-        m_lcount_write = DoWrite(buffer, nbytes);
-        m_lcount = m_lcount_write;
-        if ( m_lcount_write == nbytes )
-        {
-            msg.sig[0] = (unsigned char) 0xed;
-            msg.sig[1] = (unsigned char) 0xfe;
-            msg.sig[2] = (unsigned char) 0xad;
-            msg.sig[3] = (unsigned char) 0xde;
-            msg.len[0] =
-            msg.len[1] =
-            msg.len[2] =
-            msg.len[3] = (char) 0;
-
-            if ( DoWrite(&msg, sizeof(msg)) == sizeof(msg))
-                ok = true;
-        }
-    }
+        unsigned char sig[4];
+        unsigned char len[4];
+    } trailer;
+
+    trailer.sig[0] = (unsigned char) 0xed;
+    trailer.sig[1] = (unsigned char) 0xfe;
+    trailer.sig[2] = (unsigned char) 0xad;
+    trailer.sig[3] = (unsigned char) 0xde;
+    trailer.len[0] =
+    trailer.len[1] =
+    trailer.len[2] =
+    trailer.len[3] = (char) 0;
+
+    // Send the header, the data and the trailer using a single system call
+    // instead of 3 separate ones: this is not only faster, but also avoids
+    // sending the header in a separate small packet when Nagle's algorithm is
+    // disabled.
+    wxSocketBuffer buffers[3];
+    buffers[0] = wxSocketBuffer(&msg, sizeof(msg));
+    buffers[1] = wxSocketBuffer(buffer, nbytes);
+    buffers[2] = wxSocketBuffer(&trailer, sizeof(trailer));
+
+    const wxUint32 total = DoWriteV(buffers, WXSIZEOF(buffers));
+
+    // Only the data bytes are counted, not the header nor the trailer.
+    m_lcount_write = total > sizeof(msg) ? wxMin(total - sizeof(msg), nbytes)
+                                         : 0;
+    m_lcount = m_lcount_write;
 
-    if ( !ok )
+    if ( total != nbytes + sizeof(msg) + sizeof(trailer) )
         SetError(wxSOCKET_IOERR);
 
     return *this;
@@ -1852,6 +2328,9 @@ wxSocketServer::wxSocketServer(const wxSockAddress& addr,
     if (GetFlags() & wxSOCKET_REUSEADDR) {
         m_impl->SetReusable();
     }
+    if (GetFlags() & wxSOCKET_REUSEPORT) {
+        m_impl->SetReusablePort();
+    }
     if (GetFlags() & wxSOCKET_BROADCAST) {
         m_impl->SetBroadcast();
     }
@@ -2111,6 +2590,10 @@ wxDatagramSocket::wxDatagramSocket( const wxSockAddress& addr,
     {
         m_impl->SetReusable();
     }
+    if (flags & wxSOCKET_REUSEPORT)
+    {
+        m_impl->SetReusablePort();
+    }
     if (GetFlags() & wxSOCKET_BROADCAST)
     {
         m_impl->SetBroadcast();
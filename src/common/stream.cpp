@@ -27,12 +27,14 @@
 
 #ifndef WX_PRECOMP
     #include "wx/log.h"
+    #include "wx/utils.h"
 #endif
 
 #include <ctype.h>
 #include "wx/datstrm.h"
 #include "wx/textfile.h"
 #include "wx/scopeguard.h"
+#include "wx/vector.h"
 
 // ----------------------------------------------------------------------------
 // constants
@@ -41,6 +43,9 @@
 // the temporary buffer size used when copying from stream to stream
 #define BUF_TEMP_SIZE 4096
 
+// the maximal size the default buffer of wxBufferedStreams can grow to
+#define BUF_MAX_ADAPTIVE_SIZE (64*1024)
+
 // ============================================================================
 // implementation
 // ============================================================================
@@ -61,6 +66,11 @@ void wxStreamBuffer::InitBuffer()
     m_buffer_end =
     m_buffer_pos = NULL;
 
+    m_buffer_size =
+    m_buffer_initsize = 0;
+
+    m_sequential = false;
+
     // if we are going to allocate the buffer, we should free it later as well
     m_destroybuf = true;
 }
@@ -69,6 +79,8 @@ void wxStreamBuffer::Init()
 {
     InitBuffer();
 
+    m_buffer_maxsize = 0;
+
     m_fixed = true;
 }
 
@@ -102,6 +114,13 @@ wxStreamBuffer::wxStreamBuffer(const wxStreamBuffer& buffer)
     m_buffer_start = buffer.m_buffer_start;
     m_buffer_end = buffer.m_buffer_end;
     m_buffer_pos = buffer.m_buffer_pos;
+    m_buffer_size = buffer.m_buffer_size;
+    m_buffer_initsize = buffer.m_buffer_initsize;
+
+    // we can't reallocate the buffer we don't own
+    m_buffer_maxsize = 0;
+    m_sequential = false;
+
     m_fixed = buffer.m_fixed;
     m_flushable = buffer.m_flushable;
     m_stream = buffer.m_stream;
@@ -151,6 +170,9 @@ void wxStreamBuffer::SetBufferIO(void *start,
     m_buffer_start = (char *)start;
     m_buffer_end   = m_buffer_start + len;
 
+    m_buffer_size =
+    m_buffer_initsize = len;
+
     // if we own it, we free it
     m_destroybuf = takeOwnership;
 
@@ -180,11 +202,61 @@ void wxStreamBuffer::ResetBuffer()
         m_stream->m_lastcount = 0;
     }
 
+    // the buffer is reset when seeking, so the access is not sequential (any
+    // more)
+    m_sequential = false;
+    ShrinkIfGrown();
+
     m_buffer_pos = m_mode == read && m_flushable
                         ? m_buffer_end
                         : m_buffer_start;
 }
 
+void wxStreamBuffer::GrowIfSequential()
+{
+    if ( !m_sequential || !m_destroybuf || m_buffer_size >= m_buffer_maxsize )
+        return;
+
+    size_t new_size = 2*m_buffer_size;
+    if ( new_size > m_buffer_maxsize )
+        new_size = m_buffer_maxsize;
+
+    ResizeBuffer(new_size);
+}
+
+void wxStreamBuffer::ShrinkIfGrown()
+{
+    if ( !m_buffer_maxsize || !m_destroybuf ||
+            m_buffer_size <= m_buffer_initsize )
+        return;
+
+    ResizeBuffer(m_buffer_initsize);
+}
+
+void wxStreamBuffer::ResizeBuffer(size_t new_size)
+{
+    const size_t end = m_buffer_end - m_buffer_start;
+    const size_t pos = m_buffer_pos - m_buffer_start;
+
+    char *new_start = (char *)realloc(m_buffer_start, new_size);
+    if ( !new_start )
+    {
+        // not a problem, just continue using the existing buffer
+        return;
+    }
+
+    // preserve the data in the buffer as it may be still used when seeking
+    // backwards
+    m_buffer_start = new_start;
+    m_buffer_size = new_size;
+    m_buffer_end = m_buffer_start + wxMin(end, new_size);
+    m_buffer_pos = m_buffer_start + wxMin(pos, new_size);
+
+    // write buffers always extend to the end of the allocated memory
+    if ( m_mode != read )
+        m_buffer_end = m_buffer_start + new_size;
+}
+
 void wxStreamBuffer::Truncate()
 {
     size_t new_size = m_buffer_pos - m_buffer_start;
@@ -204,6 +276,7 @@ void wxStreamBuffer::Truncate()
     m_buffer_start = new_start;
     m_buffer_end = m_buffer_start + new_size;
     m_buffer_pos = m_buffer_end;
+    m_buffer_size = new_size;
 }
 
 // fill the buffer with as much data as possible (only for read buffers)
@@ -215,13 +288,21 @@ bool wxStreamBuffer::FillBuffer()
     if ( !inStream )
         return false;
 
-    size_t count = inStream->OnSysRead(GetBufferStart(), GetBufferSize());
+    GrowIfSequential();
+
+    // Note that we use the full buffer size here and not GetBufferSize() as
+    // the latter may be smaller if the last read didn't fill the buffer.
+    size_t count = inStream->OnSysRead(m_buffer_start, m_buffer_size);
     if ( !count )
         return false;
 
     m_buffer_end = m_buffer_start + count;
     m_buffer_pos = m_buffer_start;
 
+    // if we could fill the buffer entirely, there is probably more data to
+    // come and we can use a bigger buffer for the next read
+    m_sequential = count == m_buffer_size;
+
     return true;
 }
 
@@ -245,6 +326,12 @@ bool wxStreamBuffer::FlushBuffer()
 
     m_buffer_pos = m_buffer_start;
 
+    // if the buffer was full, more data is probably going to be written, so
+    // allow it to grow
+    const bool wasFull = current == m_buffer_size;
+    GrowIfSequential();
+    m_sequential = wasFull;
+
     return true;
 }
 
@@ -304,6 +391,7 @@ void wxStreamBuffer::PutToBuffer(const void *buffer, size_t size)
                 // adjust the pointers invalidated by realloc()
                 m_buffer_pos = m_buffer_start + delta;
                 m_buffer_end = m_buffer_start + new_size;
+                m_buffer_size = new_size;
             } // else: the buffer is big enough
         }
     }
@@ -411,6 +499,23 @@ size_t wxStreamBuffer::Read(void *buffer, size_t size)
 
         while ( size > 0 )
         {
+            // if the buffer is empty and we need to read at least as much data
+            // as it can contain, read it directly into the provided memory
+            // instead of copying it via the buffer
+            if ( !GetBytesLeft() && size >= m_buffer_size && m_flushable )
+            {
+                size_t count = ReadDirectly(buffer, size);
+                if ( !count )
+                {
+                    SetError(wxSTREAM_EOF);
+                    break;
+                }
+
+                size -= count;
+                buffer = (char *)buffer + count;
+                continue;
+            }
+
             size_t left = GetDataLeft();
 
             // if the requested number of bytes if greater than the buffer
@@ -421,6 +526,10 @@ size_t wxStreamBuffer::Read(void *buffer, size_t size)
                 size -= left;
                 buffer = (char *)buffer + left;
 
+                // don't fill the buffer if we are going to bypass it anyhow
+                if ( m_flushable && size >= m_buffer_size )
+                    continue;
+
                 if ( !FillBuffer() )
                 {
                     SetError(wxSTREAM_EOF);
@@ -443,6 +552,32 @@ size_t wxStreamBuffer::Read(void *buffer, size_t size)
     return readBytes;
 }
 
+size_t wxStreamBuffer::ReadDirectly(void *buffer, size_t size)
+{
+    wxInputStream *inStream = GetInputStream();
+    if ( !inStream )
+        return 0;
+
+    const size_t count = inStream->OnSysRead(buffer, size);
+    if ( !count )
+        return 0;
+
+    // keep the tail of the data read in the buffer: this ensures that it
+    // remains consistent with the stream position and that seeking backwards
+    // inside it still works
+    size_t tail = count;
+    if ( tail > m_buffer_size )
+        tail = m_buffer_size;
+
+    memcpy(m_buffer_start, (char *)buffer + count - tail, tail);
+    m_buffer_end =
+    m_buffer_pos = m_buffer_start + tail;
+
+    m_sequential = false;
+
+    return count;
+}
+
 // this should really be called "Copy()"
 size_t wxStreamBuffer::Read(wxStreamBuffer *dbuf)
 {
@@ -487,6 +622,14 @@ size_t wxStreamBuffer::Write(const void *buffer, size_t size)
         // no buffer, just forward the call to the stream
         ret = outStream->OnSysWrite(buffer, size);
     }
+    else if ( m_fixed && m_flushable &&
+                size > GetBytesLeft() && size >= m_buffer_size )
+    {
+        // the data wouldn't fit into the buffer anyhow, so write it directly
+        // together with the already buffered data instead of copying it
+        const wxIOVec vec(buffer, size);
+        return WriteV(&vec, 1);
+    }
     else // we [may] have a buffer, use it
     {
         size_t orig_size = size;
@@ -538,6 +681,74 @@ size_t wxStreamBuffer::Write(const void *buffer, size_t size)
     return ret;
 }
 
+size_t wxStreamBuffer::WriteV(const wxIOVec *vec, size_t count)
+{
+    wxCHECK_MSG( vec || !count, 0, wxT("NULL data pointer") );
+
+    size_t total = 0;
+    for ( size_t n = 0; n < count; n++ )
+        total += vec[n].size;
+
+    wxOutputStream *outStream = GetOutputStream();
+    if ( !outStream || !m_flushable || !m_fixed || total <= GetBytesLeft() )
+    {
+        // the data fits into the buffer (or the buffer can't be flushed at
+        // all), so just copy it there
+        size_t ret = 0;
+        for ( size_t n = 0; n < count; n++ )
+        {
+            const size_t written = Write(vec[n].data, vec[n].size);
+            ret += written;
+            if ( written != vec[n].size )
+                break;
+        }
+
+        if ( m_stream )
+            m_stream->m_lastcount = ret;
+
+        return ret;
+    }
+
+    if ( m_stream )
+        m_stream->Reset();
+
+    // write the buffered data, if any, followed by all the new data at once
+    const size_t buffered = m_buffer_pos - m_buffer_start;
+
+    wxVector<wxIOVec> all;
+    all.reserve(count + 1);
+    if ( buffered )
+        all.push_back(wxIOVec(m_buffer_start, buffered));
+    for ( size_t n = 0; n < count; n++ )
+        all.push_back(vec[n]);
+
+    const size_t written = outStream->OnSysWriteV(&all[0], all.size());
+
+    size_t ret = 0;
+    if ( written < buffered )
+    {
+        // we didn't even manage to write the buffered data, keep the part of
+        // it which wasn't written
+        memmove(m_buffer_start, m_buffer_start + written, buffered - written);
+        m_buffer_pos -= written;
+
+        SetError(wxSTREAM_WRITE_ERROR);
+    }
+    else
+    {
+        m_buffer_pos = m_buffer_start;
+
+        ret = written - buffered;
+        if ( ret != total )
+            SetError(wxSTREAM_WRITE_ERROR);
+    }
+
+    if ( m_stream )
+        m_stream->m_lastcount = ret;
+
+    return ret;
+}
+
 size_t wxStreamBuffer::Write(wxStreamBuffer *sbuf)
 {
     wxCHECK_MSG( m_mode != read, 0, wxT("can't write to this buffer") );
@@ -632,7 +843,9 @@ wxFileOffset wxStreamBuffer::Seek(wxFileOffset pos, wxSeekMode mode)
                 size_t int_diff = wx_truncate_cast(size_t, diff);
                 wxCHECK_MSG( (wxFileOffset)int_diff == diff, wxInvalidOffset, wxT("huge file not supported") );
                 SetIntPosition(int_diff);
-                return diff;
+
+                // return the position in the stream and not in the buffer
+                return Tell();
             }
 
         case wxFromEnd:
@@ -874,6 +1087,82 @@ wxInputStream& wxInputStream::Read(void *buf, size_t size)
     return *this;
 }
 
+wxInputStream& wxInputStream::ReadV(const wxIOVec *vec, size_t count)
+{
+    wxCHECK_MSG( vec || !count, *this, wxT("NULL data pointer") );
+
+    m_lastcount = 0;
+
+    // we need to modify the descriptors as we advance through them
+    wxVector<wxIOVec> v(vec, vec + count);
+
+    size_t n = 0;
+    while ( n < v.size() )
+    {
+        // skip the buffers which are already full
+        if ( !v[n].size )
+        {
+            n++;
+            continue;
+        }
+
+        // use the data put back into the stream first, if any, and only then
+        // read from the stream itself
+        size_t read = GetWBack(v[n].data, v[n].size);
+        if ( !read )
+        {
+            if ( m_lastcount && !CanRead() )
+            {
+                // as in Read(), don't block if we already have read something
+                break;
+            }
+
+            read = OnSysReadV(&v[n], v.size() - n);
+            if ( !read )
+            {
+                // no more data available
+                break;
+            }
+        }
+
+        m_lastcount += read;
+
+        // advance over the data read
+        for ( ; n < v.size() && read; n++ )
+        {
+            if ( read < v[n].size )
+            {
+                v[n].data = (char *)v[n].data + read;
+                v[n].size -= read;
+                break;
+            }
+
+            read -= v[n].size;
+        }
+    }
+
+    return *this;
+}
+
+size_t wxInputStream::OnSysReadV(const wxIOVec *vec, size_t count)
+{
+    size_t total = 0;
+    for ( size_t n = 0; n < count; n++ )
+    {
+        if ( !vec[n].size )
+            continue;
+
+        const size_t read = OnSysRead(vec[n].data, vec[n].size);
+        total += read;
+
+        // don't risk blocking by reading more than we could
+        if ( read != vec[n].size )
+            break;
+    }
+
+    return total;
+}
+
 char wxInputStream::Peek()
 {
     char c;
@@ -1061,6 +1350,32 @@ wxOutputStream& wxOutputStream::Write(const void *buffer, size_t size)
     return *this;
 }
 
+wxOutputStream& wxOutputStream::WriteV(const wxIOVec *vec, size_t count)
+{
+    wxCHECK_MSG( vec || !count, *this, wxT("NULL data pointer") );
+
+    m_lastcount = OnSysWriteV(vec, count);
+    return *this;
+}
+
+size_t wxOutputStream::OnSysWriteV(const wxIOVec *vec, size_t count)
+{
+    size_t total = 0;
+    for ( size_t n = 0; n < count; n++ )
+    {
+        if ( !vec[n].size )
+            continue;
+
+        const size_t written = OnSysWrite(vec[n].data, vec[n].size);
+        total += written;
+
+        if ( written != vec[n].size )
+            break;
+    }
+
+    return total;
+}
+
 wxOutputStream& wxOutputStream::Write(wxInputStream& stream_in)
 {
     stream_in.Read(*this);
@@ -1316,11 +1631,23 @@ namespace
 // helper function used for initializing the buffer used by
 // wxBufferedInput/OutputStream: it simply returns the provided buffer if it's
 // not NULL or creates a buffer of the given size otherwise
+//
+// if no size is specified, a small buffer which can grow when the stream is
+// used sequentially is created
 template <typename T>
 wxStreamBuffer *
-CreateBufferIfNeeded(T& stream, wxStreamBuffer *buffer, size_t bufsize = 1024)
+CreateBufferIfNeeded(T& stream, wxStreamBuffer *buffer, size_t bufsize = 0)
 {
-    return buffer ? buffer : new wxStreamBuffer(bufsize, stream);
+    if ( buffer )
+        return buffer;
+
+    if ( bufsize )
+        return new wxStreamBuffer(bufsize, stream);
+
+    buffer = new wxStreamBuffer(1024, stream);
+    buffer->SetMaxBufferSize(BUF_MAX_ADAPTIVE_SIZE);
+
+    return buffer;
 }
 
 } // anonymous namespace
@@ -1381,6 +1708,26 @@ wxInputStream& wxBufferedInputStream::Read(void *buf, size_t size)
     return *this;
 }
 
+wxInputStream& wxBufferedInputStream::ReadV(const wxIOVec *vec, size_t count)
+{
+    // reading into each buffer in turn is as efficient as it gets here, as
+    // Read() copies from our buffer if it has data and bypasses it when
+    // reading big chunks of data
+    size_t total = 0;
+    for ( size_t n = 0; n < count; n++ )
+    {
+        Read(vec[n].data, vec[n].size);
+        total += m_lastcount;
+
+        if ( m_lastcount != vec[n].size )
+            break;
+    }
+
+    m_lastcount = total;
+
+    return *this;
+}
+
 wxFileOffset wxBufferedInputStream::SeekI(wxFileOffset pos, wxSeekMode mode)
 {
     // RR: Look at wxInputStream for comments.
@@ -1472,6 +1819,13 @@ wxOutputStream& wxBufferedOutputStream::Write(const void *buffer, size_t size)
     return *this;
 }
 
+wxOutputStream& wxBufferedOutputStream::WriteV(const wxIOVec *vec, size_t count)
+{
+    m_lastcount = 0;
+    m_o_streambuf->WriteV(vec, count);
+    return *this;
+}
+
 wxFileOffset wxBufferedOutputStream::SeekO(wxFileOffset pos, wxSeekMode mode)
 {
     Sync();
@@ -1497,6 +1851,11 @@ size_t wxBufferedOutputStream::OnSysWrite(const void *buffer, size_t bufsize)
     return m_parent_o_stream->Write(buffer, bufsize).LastWrite();
 }
 
+size_t wxBufferedOutputStream::OnSysWriteV(const wxIOVec *vec, size_t count)
+{
+    return m_parent_o_stream->WriteV(vec, count).LastWrite();
+}
+
 wxFileOffset wxBufferedOutputStream::OnSysSeek(wxFileOffset seek, wxSeekMode mode)
 {
     return m_parent_o_stream->SeekO(seek, mode);
@@ -22,9 +22,11 @@
 
 #include "wx/buffer.h"
 #include "wx/datetime.h"
+#include "wx/datstrm.h"
 #include "wx/scopedptr.h"
 #include "wx/filename.h"
 #include "wx/thread.h"
+#include "wx/vector.h"
 
 #include <ctype.h>
 
@@ -453,6 +455,72 @@ static inline wxFileOffset GetDataSize(const wxTarEntry& entry)
 }
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Index of the entries of a tar, allowing random access to them by name
+
+// magic and version of the saved indices
+static const char TARINDEX_MAGIC[] = "wxTARIDX";
+enum { TARINDEX_VERSION = 1 };
+
+WX_DECLARE_STRING_HASH_MAP(size_t, wxTarIndexHash);
+
+class wxTarIndex
+{
+public:
+    wxTarIndex() : m_length(wxInvalidOffset) { }
+    ~wxTarIndex();
+
+    void Add(wxTarEntry *entry);
+    size_t GetCount() const { return m_entries.size(); }
+    const wxTarEntry *GetEntry(size_t n) const
+        { return n < m_entries.size() ? m_entries[n] : NULL; }
+    const wxTarEntry *Find(const wxString& name) const;
+
+    // the length of the archive the index was made for, if known
+    void SetLength(wxFileOffset length) { m_length = length; }
+    wxFileOffset GetLength() const { return m_length; }
+
+private:
+    wxVector<wxTarEntry*> m_entries;
+    wxTarIndexHash m_hash;
+    wxFileOffset m_length;
+
+    wxDECLARE_NO_COPY_CLASS(wxTarIndex);
+};
+
+wxTarIndex::~wxTarIndex()
+{
+    for (size_t n = 0; n < m_entries.size(); n++)
+        delete m_entries[n];
+}
+
+void wxTarIndex::Add(wxTarEntry *entry)
+{
+    // if an entry occurs more than once, the last one is used, as when
+    // extracting the whole tar
+    m_hash[entry->GetInternalName()] = m_entries.size();
+    m_entries.push_back(entry);
+}
+
+const wxTarEntry *wxTarIndex::Find(const wxString& name) const
+{
+    wxTarIndexHash::const_iterator it = m_hash.find(name);
+    return it != m_hash.end() ? m_entries[it->second] : NULL;
+}
+
+static inline void WriteDate(wxDataOutputStream& out, const wxDateTime& dt)
+{
+    out.Write64(static_cast<wxInt64>(dt.IsValid() ? dt.GetValue().GetValue()
+                                                  : wxINT64_MIN));
+}
+
+static inline wxDateTime ReadDate(wxDataInputStream& in)
+{
+    const wxInt64 value = static_cast<wxInt64>(in.Read64());
+    return value == wxINT64_MIN ? wxDateTime() : wxDateTime(wxLongLong(value));
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Tar Entry
 // Holds all the meta-data for a file in the tar
@@ -657,11 +725,17 @@ void wxTarInputStream::Init()
     m_pos = wxInvalidOffset;
     m_offset = 0;
     m_size = wxInvalidOffset;
+    // the entry offsets are relative to the start of the archive, which isn't
+    // necessarily at the start of the parent stream
+    m_start = m_parent_i_stream->IsSeekable() ? m_parent_i_stream->TellI() : 0;
+    if (m_start == wxInvalidOffset)
+        m_start = 0;
     m_sumType = SUM_UNKNOWN;
     m_tarType = TYPE_USTAR;
     m_hdr = new wxTarHeaderBlock;
     m_HeaderRecs = NULL;
     m_GlobalHeaderRecs = NULL;
+    m_index = NULL;
     m_lasterror = m_parent_i_stream->GetLastError();
 }
 
@@ -670,6 +744,7 @@ wxTarInputStream::~wxTarInputStream()
     delete m_hdr;
     delete m_HeaderRecs;
     delete m_GlobalHeaderRecs;
+    delete m_index;
 }
 
 wxTarEntry *wxTarInputStream::GetNextEntry()
@@ -721,10 +796,11 @@ wxTarEntry *wxTarInputStream::GetNextEntry()
 bool wxTarInputStream::OpenEntry(wxTarEntry& entry)
 {
     wxFileOffset offset = entry.GetOffset();
+    wxFileOffset parentOffset = m_start + offset;
 
     if (GetLastError() != wxSTREAM_READ_ERROR
             && m_parent_i_stream->IsSeekable()
-            && m_parent_i_stream->SeekI(offset) == offset)
+            && m_parent_i_stream->SeekI(parentOffset) == parentOffset)
     {
         m_offset = offset;
         m_size = GetDataSize(entry);
@@ -743,6 +819,175 @@ bool wxTarInputStream::OpenEntry(wxArchiveEntry& entry)
     return tarEntry ? OpenEntry(*tarEntry) : false;
 }
 
+// Build the index by reading all the headers, seeking over the data if the
+// parent stream is seekable
+//
+bool wxTarInputStream::LoadIndex()
+{
+    if (m_index)
+        return true;
+
+    if (m_offset != 0 || IsOpened()) {
+        // some entries were already read, so rewind if possible
+        wxLogNull nolog;
+        if (!m_parent_i_stream->IsSeekable() ||
+                m_parent_i_stream->SeekI(m_start) != m_start)
+            return false;
+
+        m_pos = wxInvalidOffset;
+        m_offset = 0;
+        m_size = wxInvalidOffset;
+        wxDELETE(m_HeaderRecs);
+        wxDELETE(m_GlobalHeaderRecs);
+        m_lasterror = wxSTREAM_NO_ERROR;
+    }
+
+    wxScopedPtr<wxTarIndex> index(new wxTarIndex);
+    wxTarEntry *entry;
+
+    while ((entry = GetNextEntry()) != NULL)
+        index->Add(entry);
+
+    if (m_lasterror != wxSTREAM_EOF)
+        return false;
+
+    wxLogNull nolog;
+    index->SetLength(m_parent_i_stream->GetLength());
+    m_index = index.release();
+    return true;
+}
+
+// Load an index saved by SaveIndex()
+//
+bool wxTarInputStream::LoadIndex(wxInputStream& stream)
+{
+    char magic[sizeof(TARINDEX_MAGIC) - 1];
+    if (stream.Read(magic, sizeof(magic)).LastRead() != sizeof(magic) ||
+            memcmp(magic, TARINDEX_MAGIC, sizeof(magic)) != 0)
+        return false;
+
+    wxDataInputStream in(stream);
+    if (in.Read32() != TARINDEX_VERSION)
+        return false;
+
+    wxScopedPtr<wxTarIndex> index(new wxTarIndex);
+    index->SetLength(static_cast<wxInt64>(in.Read64()));
+
+    // check that the index is for this archive, as far as we can tell
+    wxFileOffset length;
+    {
+        wxLogNull nolog;
+        length = m_parent_i_stream->GetLength();
+    }
+    if (length != wxInvalidOffset && index->GetLength() != wxInvalidOffset &&
+            length != index->GetLength())
+        return false;
+
+    const wxUint32 count = in.Read32();
+
+    for (wxUint32 n = 0; n < count && stream.IsOk(); n++) {
+        wxTarEntryPtr entry(new wxTarEntry);
+
+        entry->m_Name = in.ReadString();
+        entry->SetTypeFlag(in.Read8());
+        entry->SetMode(in.Read32());
+        entry->SetUserId(in.Read32());
+        entry->SetGroupId(in.Read32());
+        entry->SetSize(static_cast<wxInt64>(in.Read64()));
+        entry->SetOffset(static_cast<wxInt64>(in.Read64()));
+        entry->SetDateTime(ReadDate(in));
+        entry->SetAccessTime(ReadDate(in));
+        entry->SetCreateTime(ReadDate(in));
+        entry->SetLinkName(in.ReadString());
+        entry->SetUserName(in.ReadString());
+        entry->SetGroupName(in.ReadString());
+        entry->SetDevMajor(in.Read32());
+        entry->SetDevMinor(in.Read32());
+
+        index->Add(entry.release());
+    }
+
+    if (!stream.IsOk() && !(stream.Eof() && index->GetCount() == count))
+        return false;
+
+    delete m_index;
+    m_index = index.release();
+    return true;
+}
+
+bool wxTarInputStream::SaveIndex(wxOutputStream& stream) const
+{
+    wxCHECK_MSG(m_index, false, wxT("no index to save"));
+
+    stream.Write(TARINDEX_MAGIC, sizeof(TARINDEX_MAGIC) - 1);
+
+    wxDataOutputStream out(stream);
+    out.Write32(TARINDEX_VERSION);
+    out.Write64(static_cast<wxInt64>(m_index->GetLength()));
+    out.Write32(static_cast<wxUint32>(m_index->GetCount()));
+
+    for (size_t n = 0; n < m_index->GetCount() && stream.IsOk(); n++) {
+        const wxTarEntry& entry = *m_index->GetEntry(n);
+
+        out.WriteString(entry.GetInternalName());
+        out.Write8(static_cast<wxUint8>(entry.GetTypeFlag()));
+        out.Write32(entry.GetMode());
+        out.Write32(entry.GetUserId());
+        out.Write32(entry.GetGroupId());
+        out.Write64(static_cast<wxInt64>(entry.GetSize()));
+        out.Write64(static_cast<wxInt64>(entry.GetOffset()));
+        WriteDate(out, entry.GetDateTime());
+        WriteDate(out, entry.GetAccessTime());
+        WriteDate(out, entry.GetCreateTime());
+        out.WriteString(entry.GetLinkName());
+        out.WriteString(entry.GetUserName());
+        out.WriteString(entry.GetGroupName());
+        out.Write32(entry.GetDevMajor());
+        out.Write32(entry.GetDevMinor());
+    }
+
+    return stream.IsOk();
+}
+
+size_t wxTarInputStream::GetIndexedCount() const
+{
+    return m_index ? m_index->GetCount() : 0;
+}
+
+const wxTarEntry *wxTarInputStream::GetIndexedEntry(size_t n) const
+{
+    return m_index ? m_index->GetEntry(n) : NULL;
+}
+
+const wxTarEntry *wxTarInputStream::FindEntry(const wxString& name,
+                                              wxPathFormat format) const
+{
+    if (!m_index)
+        return NULL;
+    return m_index->Find(wxTarEntry::GetInternalName(name, format));
+}
+
+bool wxTarInputStream::OpenEntry(const wxString& name, wxPathFormat format)
+{
+    if (m_index || (m_parent_i_stream->IsSeekable() && LoadIndex())) {
+        const wxTarEntry *found = FindEntry(name, format);
+        if (!found)
+            return false;
+        wxTarEntry entry(*found);
+        return OpenEntry(entry);
+    }
+
+    // not seekable, so all we can do is to search forward
+    const wxString internal = wxTarEntry::GetInternalName(name, format);
+    wxTarEntryPtr entry;
+
+    while (entry.reset(GetNextEntry()), entry.get() != NULL)
+        if (entry->GetInternalName() == internal)
+            return true;
+
+    return false;
+}
+
 bool wxTarInputStream::CloseEntry()
 {
     if (m_lasterror == wxSTREAM_READ_ERROR)
@@ -1006,7 +1251,8 @@ wxFileOffset wxTarInputStream::OnSysSeek(wxFileOffset pos, wxSeekMode mode)
         case wxFromEnd:     pos += m_size; break;
     }
 
-    if (pos < 0 || m_parent_i_stream->SeekI(m_offset + pos) == wxInvalidOffset)
+    if (pos < 0 || m_parent_i_stream->SeekI(m_start + m_offset + pos)
+                        == wxInvalidOffset)
         return wxInvalidOffset;
 
     m_pos = pos;
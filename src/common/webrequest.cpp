@@ -45,6 +45,7 @@ extern WXDLLIMPEXP_DATA_NET(const char) wxWebSessionBackendCURL[] = "CURL";
 
 wxDEFINE_EVENT(wxEVT_WEBREQUEST_STATE, wxWebRequestEvent);
 wxDEFINE_EVENT(wxEVT_WEBREQUEST_DATA, wxWebRequestEvent);
+wxDEFINE_EVENT(wxEVT_WEBREQUEST_PROGRESS, wxWebRequestEvent);
 
 #ifdef __WXDEBUG__
 static const wxStringCharType* wxNO_IMPL_MSG
@@ -70,6 +71,9 @@ wxWebRequestImpl::wxWebRequestImpl(wxWebSession& session,
       m_id(id),
       m_state(wxWebRequest::State_Idle),
       m_bytesReceived(0),
+      m_progressInterval(0),
+      m_lastProgress(0),
+      m_progressPending(0),
       m_cancelled(false)
 {
 }
@@ -149,6 +153,18 @@ wxWebRequestImpl::SetData(wxScopedPtr<wxInputStream>& dataStream,
     return true;
 }
 
+bool wxWebRequestImpl::SetDataSink(wxScopedPtr<wxWebRequestSink>& sink)
+{
+    if ( !SupportsDataSink() )
+        return false;
+
+    m_dataSink.reset(sink.release());
+    if ( m_dataSink )
+        m_storage = wxWebRequest::Storage_None;
+
+    return true;
+}
+
 wxFileOffset wxWebRequestImpl::GetBytesReceived() const
 {
     return m_bytesReceived;
@@ -201,8 +217,80 @@ struct StateEventProcessor
     const wxString m_failMsg;
 };
 
+// Functor used to process the progress events in the main thread.
+struct ProgressEventProcessor
+{
+    explicit ProgressEventProcessor(wxWebRequestImpl& request)
+        : m_request(request)
+    {
+        m_request.IncRef();
+    }
+
+    ProgressEventProcessor(const ProgressEventProcessor& other)
+        : m_request(other.m_request)
+    {
+        m_request.IncRef();
+    }
+
+    void operator()()
+    {
+        m_request.ProcessProgressEvent();
+    }
+
+    ~ProgressEventProcessor()
+    {
+        m_request.DecRef();
+    }
+
+    wxWebRequestImpl& m_request;
+};
+
+// Functor used to resume the request in the main thread.
+struct ResumeProcessor
+{
+    explicit ResumeProcessor(wxWebRequestImpl& request)
+        : m_request(request)
+    {
+        m_request.IncRef();
+    }
+
+    ResumeProcessor(const ResumeProcessor& other)
+        : m_request(other.m_request)
+    {
+        m_request.IncRef();
+    }
+
+    void operator()()
+    {
+        m_request.Resume();
+    }
+
+    ~ResumeProcessor()
+    {
+        m_request.DecRef();
+    }
+
+    wxWebRequestImpl& m_request;
+};
+
 } // anonymous namespace
 
+void wxWebRequestImpl::Resume()
+{
+    if ( !wxIsMainThread() )
+    {
+        m_handler->CallAfter(ResumeProcessor(*this));
+        return;
+    }
+
+    if ( m_state == wxWebRequest::State_Active && !m_cancelled )
+    {
+        wxLogTrace(wxTRACE_WEBREQUEST, "Request %p: resuming", this);
+
+        DoResume();
+    }
+}
+
 void wxWebRequestImpl::SetState(wxWebRequest::State state, const wxString & failMsg)
 {
     wxASSERT_MSG( state != m_state, "shouldn't switch to the same state" );
@@ -231,6 +319,35 @@ void wxWebRequestImpl::SetState(wxWebRequest::State state, const wxString & fail
 void wxWebRequestImpl::ReportDataReceived(size_t sizeReceived)
 {
     m_bytesReceived += sizeReceived;
+
+    // Don't flood the event queue with the progress events: there is no need
+    // to send more than one of them at any given moment, as the event handler
+    // always gets the current values from the request anyhow.
+    if ( m_progressInterval > 0 && !m_progressPending )
+    {
+        const wxMilliClock_t now = wxGetLocalTimeMillis();
+        if ( now - m_lastProgress >= m_progressInterval )
+        {
+            m_lastProgress = now;
+            m_progressPending = 1;
+            m_handler->CallAfter(ProgressEventProcessor(*this));
+        }
+    }
+}
+
+void wxWebRequestImpl::ProcessProgressEvent()
+{
+    m_progressPending = 0;
+
+    // The request may have been completed or cancelled since the event was
+    // queued, don't send progress events after the final state change.
+    if ( m_state != wxWebRequest::State_Active )
+        return;
+
+    wxWebRequestEvent evt(wxEVT_WEBREQUEST_PROGRESS, GetId(),
+                          wxWebRequest::State_Active,
+                          wxWebResponse(GetResponse()));
+    m_handler->ProcessEvent(evt);
 }
 
 // The SplitParamaters implementation is adapted to wxWidgets
@@ -355,6 +472,16 @@ void wxWebRequestImpl::ProcessStateEvent(wxWebRequest::State state, const wxStri
         wxRemoveFile(dataFile);
 }
 
+//
+// wxWebRequestStreamSink
+//
+
+wxWebRequestSink::Result
+wxWebRequestStreamSink::OnData(const void* data, size_t size)
+{
+    return m_stream.WriteAll(data, size) ? Result_Continue : Result_Abort;
+}
+
 //
 // wxWebRequest
 //
@@ -431,6 +558,28 @@ wxWebRequest::Storage wxWebRequest::GetStorage() const
     return m_impl->GetStorage();
 }
 
+bool wxWebRequest::SetDataSink(wxWebRequestSink* sink)
+{
+    // Ensure that the sink is destroyed even we return below.
+    wxScopedPtr<wxWebRequestSink> sinkPtr(sink);
+
+    wxCHECK_IMPL( false );
+
+    wxCHECK_MSG( m_impl->GetState() == wxWebRequest::State_Idle, false,
+                 "Data sink must be set before starting the request" );
+
+    return m_impl->SetDataSink(sinkPtr);
+}
+
+void wxWebRequest::SetProgressInterval(int milliseconds)
+{
+    wxCHECK_IMPL_VOID();
+
+    wxCHECK_RET( milliseconds >= 0, "invalid progress interval" );
+
+    m_impl->SetProgressInterval(milliseconds);
+}
+
 void wxWebRequest::Start()
 {
     wxCHECK_IMPL_VOID();
@@ -451,6 +600,13 @@ void wxWebRequest::Cancel()
     m_impl->Cancel();
 }
 
+void wxWebRequest::Resume()
+{
+    wxCHECK_IMPL_VOID();
+
+    m_impl->Resume();
+}
+
 wxWebResponse wxWebRequest::GetResponse() const
 {
     wxCHECK_IMPL( wxWebResponse() );
@@ -1009,6 +1165,52 @@ wxString wxWebSession::GetTempDir() const
     return m_impl->GetTempDir();
 }
 
+bool wxWebSession::SetMaxConnectionsPerHost(int count)
+{
+    wxCHECK_IMPL( false );
+    wxCHECK_MSG( count >= 0, false, "invalid number of connections" );
+
+    return m_impl->SetMaxConnectionsPerHost(count);
+}
+
+bool wxWebSession::SetMaxConnections(int count)
+{
+    wxCHECK_IMPL( false );
+    wxCHECK_MSG( count >= 0, false, "invalid number of connections" );
+
+    return m_impl->SetMaxConnections(count);
+}
+
+bool wxWebSession::EnableMultiplexing(bool enable)
+{
+    wxCHECK_IMPL( false );
+
+    return m_impl->EnableMultiplexing(enable);
+}
+
+bool wxWebSession::SetKeepAlive(int idle, int interval)
+{
+    wxCHECK_IMPL( false );
+    wxCHECK_MSG( idle >= 0 && interval >= 0, false, "invalid keep-alive time" );
+
+    return m_impl->SetKeepAlive(idle, interval);
+}
+
+bool wxWebSession::SetMaxIdleTime(int seconds)
+{
+    wxCHECK_IMPL( false );
+    wxCHECK_MSG( seconds >= 0, false, "invalid idle time" );
+
+    return m_impl->SetMaxIdleTime(seconds);
+}
+
+bool wxWebSession::EnableSharedCache(bool enable)
+{
+    wxCHECK_IMPL( false );
+
+    return m_impl->EnableSharedCache(enable);
+}
+
 bool wxWebSession::IsOpened() const
 {
     return m_impl.get() != NULL;
@@ -119,6 +119,28 @@ wxWebResponseCURL::wxWebResponseCURL(wxWebRequestCURL& request) :
 
 size_t wxWebResponseCURL::CURLOnWrite(void* buffer, size_t size)
 {
+    wxWebRequestSink* const sink = m_request.GetDataSink();
+    if ( sink )
+    {
+        switch ( sink->OnData(buffer, size) )
+        {
+            case wxWebRequestSink::Result_Continue:
+                m_request.ReportDataReceived(size);
+                return size;
+
+            case wxWebRequestSink::Result_Pause:
+                // libcurl keeps this data and passes it to us again once the
+                // transfer is resumed.
+                return CURL_WRITEFUNC_PAUSE;
+
+            case wxWebRequestSink::Result_Abort:
+                break;
+        }
+
+        // Returning a different size makes libcurl abort the transfer.
+        return size ? 0 : 1;
+    }
+
     void* buf = GetDataBuffer(size);
     memcpy(buf, buffer, size);
     ReportDataReceived(size);
@@ -257,6 +279,8 @@ wxWebRequestCURL::wxWebRequestCURL(wxWebSession & session,
     // Enable all supported authentication methods
     curl_easy_setopt(m_handle, CURLOPT_HTTPAUTH, CURLAUTH_ANY);
     curl_easy_setopt(m_handle, CURLOPT_PROXYAUTH, CURLAUTH_ANY);
+    // Use the connection options of the session
+    m_sessionImpl.SetupRequestHandle(m_handle);
 }
 
 wxWebRequestCURL::~wxWebRequestCURL()
@@ -335,6 +359,11 @@ void wxWebRequestCURL::DoCancel()
     m_sessionImpl.CancelRequest(this);
 }
 
+void wxWebRequestCURL::DoResume()
+{
+    curl_easy_pause(m_handle, CURLPAUSE_CONT);
+}
+
 void wxWebRequestCURL::HandleCompletion()
 {
     int status = m_response ? m_response->GetStatus() : 0;
@@ -874,7 +903,15 @@ int wxWebSessionCURL::ms_activeSessions = 0;
 unsigned int wxWebSessionCURL::ms_runtimeVersion = 0;
 
 wxWebSessionCURL::wxWebSessionCURL() :
-    m_handle(NULL)
+    m_handle(NULL),
+    m_maxConnectionsPerHost(-1),
+    m_maxConnections(-1),
+    m_multiplexing(-1),
+    m_keepAliveIdle(-1),
+    m_keepAliveInterval(-1),
+    m_maxIdleTime(-1),
+    m_share(NULL),
+    m_useShare(false)
 {
     // Initialize CURL globally if no sessions are active
     if ( ms_activeSessions == 0 )
@@ -906,6 +943,12 @@ wxWebSessionCURL::~wxWebSessionCURL()
     if ( m_handle )
         curl_multi_cleanup(m_handle);
 
+    // Notice that this fails, and the share handle is leaked, if any requests
+    // using it still exist, but this is better than crashing when they're
+    // destroyed later.
+    if ( m_share )
+        curl_share_cleanup(m_share);
+
     // Global CURL cleanup if this is the last session
     --ms_activeSessions;
     if ( ms_activeSessions == 0 )
@@ -933,12 +976,219 @@ wxWebSessionCURL::CreateRequest(wxWebSession& session,
             curl_multi_setopt(m_handle, CURLMOPT_SOCKETFUNCTION, SocketCallback);
             curl_multi_setopt(m_handle, CURLMOPT_TIMERDATA, this);
             curl_multi_setopt(m_handle, CURLMOPT_TIMERFUNCTION, TimerCallback);
+
+            ApplyMultiOptions();
         }
     }
 
     return wxWebRequestImplPtr(new wxWebRequestCURL(session, *this, handler, url, id));
 }
 
+// Connection options: those applying to the multi handle are stored and used
+// when it is created, as it is only done on demand, while the others are
+// applied to the easy handles of all requests created later.
+
+bool wxWebSessionCURL::SetMaxConnectionsPerHost(int count)
+{
+#if CURL_AT_LEAST_VERSION(7, 30, 0)
+    if ( CurlRuntimeAtLeastVersion(7, 30, 0) )
+    {
+        m_maxConnectionsPerHost = count;
+        ApplyMultiOptions();
+        return true;
+    }
+#else
+    wxUnusedVar(count);
+#endif
+
+    return false;
+}
+
+bool wxWebSessionCURL::SetMaxConnections(int count)
+{
+#if CURL_AT_LEAST_VERSION(7, 30, 0)
+    if ( CurlRuntimeAtLeastVersion(7, 30, 0) )
+    {
+        m_maxConnections = count;
+        ApplyMultiOptions();
+        return true;
+    }
+#else
+    wxUnusedVar(count);
+#endif
+
+    return false;
+}
+
+bool wxWebSessionCURL::EnableMultiplexing(bool enable)
+{
+#if CURL_AT_LEAST_VERSION(7, 43, 0)
+    if ( CurlRuntimeAtLeastVersion(7, 43, 0) )
+    {
+        m_multiplexing = enable;
+        ApplyMultiOptions();
+        return true;
+    }
+#else
+    wxUnusedVar(enable);
+#endif
+
+    return false;
+}
+
+bool wxWebSessionCURL::SetKeepAlive(int idle, int interval)
+{
+#if CURL_AT_LEAST_VERSION(7, 25, 0)
+    if ( CurlRuntimeAtLeastVersion(7, 25, 0) )
+    {
+        m_keepAliveIdle = idle;
+        m_keepAliveInterval = interval ? interval : idle;
+        return true;
+    }
+#else
+    wxUnusedVar(idle);
+    wxUnusedVar(interval);
+#endif
+
+    return false;
+}
+
+bool wxWebSessionCURL::SetMaxIdleTime(int seconds)
+{
+#if CURL_AT_LEAST_VERSION(7, 65, 0)
+    if ( CurlRuntimeAtLeastVersion(7, 65, 0) )
+    {
+        // 0 means to use the default value
+        m_maxIdleTime = seconds ? seconds : -1;
+        return true;
+    }
+#else
+    wxUnusedVar(seconds);
+#endif
+
+    return false;
+}
+
+bool wxWebSessionCURL::EnableSharedCache(bool enable)
+{
+    // Notice that we can't destroy the share handle when disabling it while
+    // it's still used by the existing requests, so just stop using it for the
+    // new ones.
+    if ( enable && !m_share )
+    {
+        m_share = curl_share_init();
+        if ( !m_share )
+            return false;
+
+        // Notice that the connection cache is shared by the requests of the
+        // same session anyhow, as they all use the same multi handle, so the
+        // main benefit of this is reusing the TLS sessions when opening new
+        // connections. libcurl doesn't lock the shared data on its own, so
+        // provide the lock callbacks to keep it safe even if the requests end
+        // up being processed in different threads.
+        curl_share_setopt(m_share, CURLSHOPT_LOCKFUNC, ShareLockCallback);
+        curl_share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, ShareUnlockCallback);
+        curl_share_setopt(m_share, CURLSHOPT_USERDATA, this);
+
+        curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if CURL_AT_LEAST_VERSION(7, 57, 0)
+        // This fails with older runtime versions, but it's not a problem.
+        curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+    }
+
+    m_useShare = enable;
+
+    return true;
+}
+
+/* static */
+void wxWebSessionCURL::ShareLockCallback(CURL* WXUNUSED(curl),
+                                         curl_lock_data data,
+                                         curl_lock_access WXUNUSED(access),
+                                         void* userdata)
+{
+    wxCHECK_RET( data >= 0 && data < CURL_LOCK_DATA_LAST,
+                 "invalid curl lock data" );
+
+    static_cast<wxWebSessionCURL*>(userdata)->m_shareLocks[data].Enter();
+}
+
+/* static */
+void wxWebSessionCURL::ShareUnlockCallback(CURL* WXUNUSED(curl),
+                                           curl_lock_data data,
+                                           void* userdata)
+{
+    wxCHECK_RET( data >= 0 && data < CURL_LOCK_DATA_LAST,
+                 "invalid curl lock data" );
+
+    static_cast<wxWebSessionCURL*>(userdata)->m_shareLocks[data].Leave();
+}
+
+void wxWebSessionCURL::SetupRequestHandle(CURL* curl) const
+{
+    if ( m_useShare )
+        curl_easy_setopt(curl, CURLOPT_SHARE, m_share);
+
+#if CURL_AT_LEAST_VERSION(7, 43, 0)
+    // Wait for an existing connection to become available for multiplexing
+    // instead of opening a new one.
+    if ( m_multiplexing == 1 )
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+#endif
+
+#if CURL_AT_LEAST_VERSION(7, 25, 0)
+    if ( m_keepAliveIdle > 0 )
+    {
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, m_keepAliveIdle);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, m_keepAliveInterval);
+    }
+    else if ( m_keepAliveIdle == 0 )
+    {
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 0L);
+    }
+#endif
+
+#if CURL_AT_LEAST_VERSION(7, 65, 0)
+    if ( m_maxIdleTime > 0 )
+        curl_easy_setopt(curl, CURLOPT_MAXAGE_CONN, m_maxIdleTime);
+#endif
+}
+
+void wxWebSessionCURL::ApplyMultiOptions()
+{
+    if ( !m_handle )
+        return;
+
+#if CURL_AT_LEAST_VERSION(7, 30, 0)
+    if ( m_maxConnectionsPerHost >= 0 )
+    {
+        curl_multi_setopt(m_handle, CURLMOPT_MAX_HOST_CONNECTIONS,
+                          m_maxConnectionsPerHost);
+    }
+
+    if ( m_maxConnections >= 0 )
+    {
+        curl_multi_setopt(m_handle, CURLMOPT_MAX_TOTAL_CONNECTIONS,
+                          m_maxConnections);
+
+        // Also don't keep more connections than we can use open.
+        if ( m_maxConnections > 0 )
+            curl_multi_setopt(m_handle, CURLMOPT_MAXCONNECTS, m_maxConnections);
+    }
+#endif
+
+#if CURL_AT_LEAST_VERSION(7, 43, 0)
+    if ( m_multiplexing >= 0 )
+    {
+        curl_multi_setopt(m_handle, CURLMOPT_PIPELINING,
+                          m_multiplexing ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+    }
+#endif
+}
+
 bool wxWebSessionCURL::StartRequest(wxWebRequestCURL & request)
 {
     // Add request easy handle to multi handle
@@ -1221,8 +1471,9 @@ void wxWebSessionCURL::StopActiveTransfer(CURL* curl)
         // Remove the CURL easy handle from the CURLM multi handle.
         curl_multi_remove_handle(m_handle, curl);
 
-        // If the transfer was active, close its socket.
-        if ( activeSocket != CURL_SOCKET_BAD )
+        // If the transfer was active, close its socket, unless it can be
+        // used by the other transfers too.
+        if ( activeSocket != CURL_SOCKET_BAD && m_multiplexing != 1 )
         {
             wxCloseSocket(activeSocket);
         }
@@ -21,8 +21,59 @@
 #endif
 
 #include <stdio.h>
+#include <string.h>
 
 #if wxUSE_FILE
+    #if defined(__UNIX__)
+        #include <sys/mman.h>
+        #include <sys/uio.h>
+        #include <fcntl.h>
+        #include <errno.h>
+        #include <limits.h>
+
+        #include "wx/vector.h"
+    #elif defined(__WINDOWS__)
+        #include "wx/msw/wrapwin.h"
+        #include <io.h>
+    #endif
+#endif // wxUSE_FILE
+
+#if wxUSE_FILE
+
+#if defined(__UNIX__)
+
+namespace
+{
+
+// Return the array of native descriptors corresponding to the given ones.
+wxVector<struct iovec> wxMakeIOVecs(const wxIOVec *vec, size_t count)
+{
+    wxVector<struct iovec> iov(count);
+    for ( size_t n = 0; n < count; n++ )
+    {
+        iov[n].iov_base = vec[n].data;
+        iov[n].iov_len = vec[n].size;
+    }
+
+    return iov;
+}
+
+// Return the number of descriptors which can be passed to readv()/writev() at
+// once: there is no need to pass more, as partial reads/writes are handled
+// anyhow.
+int wxGetIOVecsCount(size_t count)
+{
+#ifdef IOV_MAX
+    if ( count > IOV_MAX )
+        count = IOV_MAX;
+#endif
+
+    return static_cast<int>(count);
+}
+
+} // anonymous namespace
+
+#endif // __UNIX__
 
 // ----------------------------------------------------------------------------
 // wxFileInputStream
@@ -93,6 +144,41 @@ size_t wxFileInputStream::OnSysRead(void *buffer, size_t size)
     return ret;
 }
 
+size_t wxFileInputStream::OnSysReadV(const wxIOVec *vec, size_t count)
+{
+#if defined(__UNIX__)
+    if ( !count )
+        return 0;
+
+    wxVector<struct iovec> iov = wxMakeIOVecs(vec, count);
+
+    ssize_t ret;
+    do
+    {
+        ret = ::readv(m_file->fd(), &iov[0], wxGetIOVecsCount(count));
+    }
+    while ( ret == -1 && errno == EINTR );
+
+    if ( !ret )
+    {
+        m_lasterror = wxSTREAM_EOF;
+    }
+    else if ( ret == -1 )
+    {
+        m_lasterror = wxSTREAM_READ_ERROR;
+        ret = 0;
+    }
+    else
+    {
+        m_lasterror = wxSTREAM_NO_ERROR;
+    }
+
+    return ret;
+#else // !__UNIX__
+    return wxInputStream::OnSysReadV(vec, count);
+#endif // __UNIX__/!__UNIX__
+}
+
 wxFileOffset wxFileInputStream::OnSysSeek(wxFileOffset pos, wxSeekMode mode)
 {
     return m_file->Seek(pos, mode);
@@ -158,6 +244,61 @@ size_t wxFileOutputStream::OnSysWrite(const void *buffer, size_t size)
     return ret;
 }
 
+size_t wxFileOutputStream::OnSysWriteV(const wxIOVec *vec, size_t count)
+{
+#if defined(__UNIX__)
+    wxVector<struct iovec> iov = wxMakeIOVecs(vec, count);
+
+    m_lasterror = wxSTREAM_NO_ERROR;
+
+    // unlike read(), write() is supposed to write everything, so keep
+    // calling writev() until all the data is written
+    size_t total = 0;
+    size_t n = 0;
+    while ( n < count )
+    {
+        // skip the empty (or already written) buffers
+        if ( !iov[n].iov_len )
+        {
+            n++;
+            continue;
+        }
+
+        ssize_t ret;
+        do
+        {
+            ret = ::writev(m_file->fd(), &iov[n], wxGetIOVecsCount(count - n));
+        }
+        while ( ret == -1 && errno == EINTR );
+
+        if ( ret <= 0 )
+        {
+            m_lasterror = wxSTREAM_WRITE_ERROR;
+            break;
+        }
+
+        total += ret;
+
+        // advance over the data written
+        for ( size_t written = ret; written; n++ )
+        {
+            if ( written < iov[n].iov_len )
+            {
+                iov[n].iov_base = static_cast<char *>(iov[n].iov_base) + written;
+                iov[n].iov_len -= written;
+                break;
+            }
+
+            written -= iov[n].iov_len;
+        }
+    }
+
+    return total;
+#else // !__UNIX__
+    return wxOutputStream::OnSysWriteV(vec, count);
+#endif // __UNIX__/!__UNIX__
+}
+
 wxFileOffset wxFileOutputStream::OnSysTell() const
 {
     return m_file->Tell();
@@ -260,6 +401,279 @@ bool wxFileStream::IsOk() const
     return wxFileOutputStream::IsOk() && wxFileInputStream::IsOk();
 }
 
+// ----------------------------------------------------------------------------
+// wxMappedFileInputStream
+// ----------------------------------------------------------------------------
+
+namespace
+{
+
+// Owns the file mapping and destroys it when the last stream using it is gone.
+class wxFileMappingRef : public wxRefCounter
+{
+public:
+    wxFileMappingRef(void *data, size_t length)
+        : m_data(data),
+          m_length(length)
+    {
+    }
+
+protected:
+    virtual ~wxFileMappingRef()
+    {
+#if defined(__UNIX__)
+        munmap(m_data, m_length);
+#elif defined(__WINDOWS__)
+        ::UnmapViewOfFile(m_data);
+#endif
+    }
+
+private:
+    void * const m_data;
+    const size_t m_length;
+
+    wxDECLARE_NO_COPY_CLASS(wxFileMappingRef);
+};
+
+} // anonymous namespace
+
+wxIMPLEMENT_ABSTRACT_CLASS(wxMappedFileInputStream, wxInputStream);
+
+wxMappedFileInputStream::wxMappedFileInputStream(const wxString& fileName,
+                                                 wxMappedFileAccess access)
+                       : wxInputStream(),
+                         m_file(fileName, wxFile::read)
+{
+    m_mapping = NULL;
+    m_data = NULL;
+    m_length = 0;
+    m_pos = 0;
+
+    if ( !m_file.IsOpened() )
+    {
+        m_lasterror = wxSTREAM_READ_ERROR;
+        return;
+    }
+
+    // If mapping fails, we silently fall back to using read() which is always
+    // possible, so there is nothing special to do in this case.
+    DoMap();
+
+    SetAccessHint(access);
+}
+
+wxMappedFileInputStream::~wxMappedFileInputStream()
+{
+    if ( m_mapping )
+        m_mapping->DecRef();
+}
+
+bool wxMappedFileInputStream::DoMap()
+{
+    // Only regular files can be mapped and doing it for empty ones is not
+    // allowed, so don't even try in these cases.
+    if ( m_file.GetKind() != wxFILE_KIND_DISK )
+        return false;
+
+    const wxFileOffset lenFile = m_file.Length();
+    if ( lenFile <= 0 )
+        return false;
+
+    const size_t len = wx_truncate_cast(size_t, lenFile);
+    if ( (wxFileOffset)len != lenFile )
+    {
+        // The file is too big to be mapped in its entirety.
+        return false;
+    }
+
+    void *data;
+
+#if defined(__UNIX__)
+    data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, m_file.fd(), 0);
+    if ( data == MAP_FAILED )
+        return false;
+#elif defined(__WINDOWS__)
+    const HANDLE hFile = (HANDLE)_get_osfhandle(m_file.fd());
+    if ( hFile == INVALID_HANDLE_VALUE )
+        return false;
+
+    const HANDLE hMap = ::CreateFileMapping(hFile, NULL, PAGE_READONLY,
+                                            0, 0, NULL);
+    if ( !hMap )
+        return false;
+
+    data = ::MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, len);
+
+    // The view keeps the mapping object alive, we don't need its handle.
+    ::CloseHandle(hMap);
+
+    if ( !data )
+        return false;
+#else
+    wxUnusedVar(data);
+    return false;
+#endif
+
+    m_mapping = new wxFileMappingRef(data, len);
+    m_data = static_cast<const char *>(data);
+    m_length = len;
+
+    return true;
+}
+
+void wxMappedFileInputStream::SetAccessHint(wxMappedFileAccess access)
+{
+    if ( !m_file.IsOpened() )
+        return;
+
+#if defined(__UNIX__)
+    if ( IsMapped() )
+    {
+#ifdef MADV_SEQUENTIAL
+        int advice = MADV_NORMAL;
+        switch ( access )
+        {
+            case wxMAPPED_FILE_ACCESS_NORMAL:
+                break;
+
+            case wxMAPPED_FILE_ACCESS_SEQUENTIAL:
+                advice = MADV_SEQUENTIAL;
+                break;
+
+            case wxMAPPED_FILE_ACCESS_RANDOM:
+                advice = MADV_RANDOM;
+                break;
+        }
+
+        // This is just a hint, so ignore any errors.
+        madvise(const_cast<char *>(m_data), m_length, advice);
+#endif // MADV_SEQUENTIAL
+    }
+    else
+    {
+#ifdef POSIX_FADV_SEQUENTIAL
+        int advice = POSIX_FADV_NORMAL;
+        switch ( access )
+        {
+            case wxMAPPED_FILE_ACCESS_NORMAL:
+                break;
+
+            case wxMAPPED_FILE_ACCESS_SEQUENTIAL:
+                advice = POSIX_FADV_SEQUENTIAL;
+                break;
+
+            case wxMAPPED_FILE_ACCESS_RANDOM:
+                advice = POSIX_FADV_RANDOM;
+                break;
+        }
+
+        posix_fadvise(m_file.fd(), 0, 0, advice);
+#endif // POSIX_FADV_SEQUENTIAL
+    }
+#else // !__UNIX__
+    wxUnusedVar(access);
+#endif // __UNIX__/!__UNIX__
+}
+
+wxFileOffset wxMappedFileInputStream::GetLength() const
+{
+    return IsMapped() ? (wxFileOffset)m_length : m_file.Length();
+}
+
+bool wxMappedFileInputStream::IsOk() const
+{
+    return wxInputStream::IsOk() && m_file.IsOpened();
+}
+
+bool wxMappedFileInputStream::IsSeekable() const
+{
+    return IsMapped() || m_file.GetKind() == wxFILE_KIND_DISK;
+}
+
+bool wxMappedFileInputStream::CanRead() const
+{
+    if ( IsMapped() )
+        return m_pos < m_length;
+
+    return wxInputStream::CanRead();
+}
+
+size_t wxMappedFileInputStream::OnSysRead(void *buffer, size_t size)
+{
+    if ( !IsMapped() )
+    {
+        const ssize_t ret = m_file.Read(buffer, size);
+        if ( !ret )
+        {
+            m_lasterror = wxSTREAM_EOF;
+            return 0;
+        }
+
+        if ( ret == wxInvalidOffset )
+        {
+            m_lasterror = wxSTREAM_READ_ERROR;
+            return 0;
+        }
+
+        m_lasterror = wxSTREAM_NO_ERROR;
+        return ret;
+    }
+
+    if ( m_pos >= m_length )
+    {
+        m_lasterror = wxSTREAM_EOF;
+        return 0;
+    }
+
+    if ( size > m_length - m_pos )
+        size = m_length - m_pos;
+
+    memcpy(buffer, m_data + m_pos, size);
+    m_pos += size;
+
+    m_lasterror = wxSTREAM_NO_ERROR;
+    return size;
+}
+
+wxFileOffset
+wxMappedFileInputStream::OnSysSeek(wxFileOffset pos, wxSeekMode mode)
+{
+    if ( !IsMapped() )
+        return m_file.Seek(pos, mode);
+
+    wxFileOffset newPos;
+    switch ( mode )
+    {
+        case wxFromStart:
+            newPos = pos;
+            break;
+
+        case wxFromCurrent:
+            newPos = m_pos + pos;
+            break;
+
+        case wxFromEnd:
+            newPos = m_length + pos;
+            break;
+
+        default:
+            wxFAIL_MSG( wxT("invalid seek mode") );
+            return wxInvalidOffset;
+    }
+
+    if ( newPos < 0 || newPos > (wxFileOffset)m_length )
+        return wxInvalidOffset;
+
+    m_pos = wx_truncate_cast(size_t, newPos);
+
+    return newPos;
+}
+
+wxFileOffset wxMappedFileInputStream::OnSysTell() const
+{
+    return IsMapped() ? (wxFileOffset)m_pos : m_file.Tell();
+}
+
 #endif // wxUSE_FILE
 
 #if wxUSE_FFILE
@@ -25,7 +25,9 @@
 #include "wx/zstream.h"
 #include "wx/mstream.h"
 #include "wx/scopedptr.h"
+#include "wx/vector.h"
 #include "wx/wfstream.h"
+#include "wx/private/threadpool.h"
 #include "zlib.h"
 
 // value for the 'version needed to extract' field (20 means 2.0)
@@ -75,6 +77,13 @@ enum {
     SUMS_OFFSET  = 14
 };
 
+// Entries up to this size are compressed in memory, possibly concurrently
+// with the other ones, when wxZipOutputStream uses several threads, while
+// the bigger ones are compressed when they're written.
+enum {
+    PARALLEL_ENTRY_MAX = 4*1024*1024
+};
+
 wxIMPLEMENT_DYNAMIC_CLASS(wxZipEntry, wxArchiveEntry);
 wxIMPLEMENT_DYNAMIC_CLASS(wxZipClassFactory, wxArchiveClassFactory);
 
@@ -82,6 +91,22 @@ wxIMPLEMENT_DYNAMIC_CLASS(wxZipClassFactory, wxArchiveClassFactory);
 /////////////////////////////////////////////////////////////////////////////
 // Helpers
 
+// return the deflate flags corresponding to the compression level
+//
+static int GetDeflateFlags(int level)
+{
+    switch (level) {
+        case 0: case 1:
+            return wxZIP_DEFLATE_SUPERFAST;
+        case 2: case 3: case 4:
+            return wxZIP_DEFLATE_FAST;
+        case 8: case 9:
+            return wxZIP_DEFLATE_EXTRA;
+    }
+
+    return wxZIP_DEFLATE_NORMAL;
+}
+
 // read a string of a given length
 //
 static wxString ReadString(wxInputStream& stream, wxUint16 len, wxMBConv& conv)
@@ -1582,6 +1607,148 @@ private:
 };
 
 
+/////////////////////////////////////////////////////////////////////////////
+// Central directory index of a seekable zip, allowing random access to the
+// entries by name.
+
+WX_DECLARE_STRING_HASH_MAP(size_t, wxZipIndexHash);
+
+class wxZipIndex
+{
+public:
+    wxZipIndex() : m_data(NULL), m_length(0) { }
+    ~wxZipIndex();
+
+    void Add(wxZipEntry *entry);
+    size_t GetCount() const { return m_entries.size(); }
+    const wxZipEntry *GetEntry(size_t n) const
+        { return n < m_entries.size() ? m_entries[n] : NULL; }
+    const wxZipEntry *Find(const wxString& name) const;
+
+    // the archive contents, if they are entirely available in memory
+    void SetData(const char *data, size_t length)
+        { m_data = data; m_length = length; }
+    const char *GetData() const { return m_data; }
+    size_t GetLength() const { return m_length; }
+
+#if wxUSE_THREADS
+    // serializes the calls to wxZipInputStream::OpenEntryStream()
+    wxMutex& GetReadMutex() const { return m_readMutex; }
+#endif
+
+private:
+    wxVector<wxZipEntry*> m_entries;
+    wxZipIndexHash m_hash;
+    const char *m_data;
+    size_t m_length;
+#if wxUSE_THREADS
+    mutable wxMutex m_readMutex;
+#endif
+
+    wxDECLARE_NO_COPY_CLASS(wxZipIndex);
+};
+
+wxZipIndex::~wxZipIndex()
+{
+    for (size_t n = 0; n < m_entries.size(); n++)
+        delete m_entries[n];
+}
+
+void wxZipIndex::Add(wxZipEntry *entry)
+{
+    // if the same name occurs more than once, the first one wins, as it's
+    // the one found by a sequential search
+    wxZipIndexHash::iterator it = m_hash.find(entry->GetInternalName());
+    if (it == m_hash.end())
+        m_hash[entry->GetInternalName()] = m_entries.size();
+    m_entries.push_back(entry);
+}
+
+const wxZipEntry *wxZipIndex::Find(const wxString& name) const
+{
+    wxZipIndexHash::const_iterator it = m_hash.find(name);
+    return it != m_hash.end() ? m_entries[it->second] : NULL;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Stream returned by wxZipInputStream::OpenEntryStream(), decompressing an
+// entry's data held in memory independently of the wxZipInputStream.
+
+class wxZipEntryInputStream : public wxInputStream
+{
+public:
+    wxZipEntryInputStream(const wxZipEntry& entry,
+                          const char *data,
+                          const wxMemoryBuffer& owner = wxMemoryBuffer());
+    virtual ~wxZipEntryInputStream() { delete m_inflate; }
+
+    virtual wxFileOffset GetLength() const wxOVERRIDE { return m_size; }
+
+protected:
+    virtual size_t OnSysRead(void *buffer, size_t size) wxOVERRIDE;
+    virtual wxFileOffset OnSysTell() const wxOVERRIDE { return m_pos; }
+
+private:
+    wxMemoryBuffer m_owner;
+    wxMemoryInputStream m_compressed;
+    wxZlibInputStream *m_inflate;
+    wxString m_name;
+    wxFileOffset m_pos;
+    wxFileOffset m_size;
+    wxUint32 m_crc;
+    wxUint32 m_crcAccumulator;
+
+    wxDECLARE_NO_COPY_CLASS(wxZipEntryInputStream);
+};
+
+wxZipEntryInputStream::wxZipEntryInputStream(const wxZipEntry& entry,
+                                             const char *data,
+                                             const wxMemoryBuffer& owner)
+  : m_owner(owner),
+    m_compressed(data, wx_truncate_cast(size_t, entry.GetCompressedSize())),
+    m_inflate(NULL),
+    m_name(entry.GetName()),
+    m_pos(0),
+    m_size(entry.GetSize()),
+    m_crc(entry.GetCrc()),
+    m_crcAccumulator(crc32(0, Z_NULL, 0))
+{
+    if (entry.GetMethod() == wxZIP_METHOD_DEFLATE)
+        m_inflate = new wxZlibInputStream(m_compressed, wxZLIB_NO_HEADER);
+}
+
+size_t wxZipEntryInputStream::OnSysRead(void *buffer, size_t size)
+{
+    if (m_pos + wxFileOffset(size) > m_size)
+        size = wx_truncate_cast(size_t, m_size - m_pos);
+    if (!size) {
+        m_lasterror = wxSTREAM_EOF;
+        return 0;
+    }
+
+    wxInputStream& decomp = m_inflate ? *m_inflate
+                                      : static_cast<wxInputStream&>(m_compressed);
+    size_t count = decomp.Read(buffer, size).LastRead();
+    m_crcAccumulator = crc32(m_crcAccumulator, (Byte*)buffer, count);
+    m_pos += count;
+
+    if (m_pos == m_size) {
+        if (m_crcAccumulator != m_crc) {
+            wxLogError(_("reading zip stream (entry %s): bad crc"),
+                       m_name.c_str());
+            m_lasterror = wxSTREAM_READ_ERROR;
+        }
+    } else if (count < size) {
+        wxLogError(_("reading zip stream (entry %s): bad length"),
+                   m_name.c_str());
+        m_lasterror = wxSTREAM_READ_ERROR;
+    }
+
+    return count;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 // Input stream
 
@@ -1620,6 +1787,9 @@ void wxZipInputStream::Init()
     m_position = wxInvalidOffset;
     m_signature = 0;
     m_TotalEntries = 0;
+    m_centralOffset = wxInvalidOffset;
+    m_centralSize = 0;
+    m_index = NULL;
     m_lasterror = m_parent_i_stream->GetLastError();
 }
 
@@ -1630,6 +1800,7 @@ wxZipInputStream::~wxZipInputStream()
     delete m_store;
     delete m_inflate;
     delete m_rawin;
+    delete m_index;
 
     m_weaklinks->Release(this);
 
@@ -1725,6 +1896,8 @@ bool wxZipInputStream::LoadEndRecord()
         m_signature = magic;
         m_position = endrec.GetOffset();
         m_offsetAdjustment = 0;
+        m_centralOffset = m_position;
+        m_centralSize = endrec.GetSize();
         return true;
     }
 
@@ -1740,6 +1913,8 @@ bool wxZipInputStream::LoadEndRecord()
         if ( endrec.GetOffset() >= 0 && endrec.GetOffset() < m_position )
         {
             m_offsetAdjustment = m_position - endrec.GetOffset();
+            m_centralOffset = m_position;
+            m_centralSize = recSize;
             return true;
         }
     }
@@ -1849,23 +2024,222 @@ wxStreamError wxZipInputStream::ReadCentral()
     m_position += size;
     m_signature = ReadSignature();
 
+    if (!AdjustOffset(m_entry)) {
+        m_signature = 0;
+        return wxSTREAM_READ_ERROR;
+    }
+
+    return wxSTREAM_NO_ERROR;
+}
+
+// Adjust the offset of an entry read from the central directory of a zip
+// appended to some other data, such as a self extractor
+//
+bool wxZipInputStream::AdjustOffset(wxZipEntry& entry) const
+{
     if (m_offsetAdjustment) {
         // Offset read from the stream is 4 bytes independently of the
         // platform, but it's not clear if it can become greater than max
         // 32-bit value after adjustment. For now consider that it can't.
-        wxFileOffset ofs = wxUint32(m_entry.GetOffset());
+        wxFileOffset ofs = wxUint32(entry.GetOffset());
         ofs += m_offsetAdjustment;
-        if (ofs > wxUINT32_MAX) {
-            m_signature = 0;
-            return wxSTREAM_READ_ERROR;
+        if (ofs > wxUINT32_MAX)
+            return false;
+
+        entry.SetOffset(ofs);
+    }
+
+    entry.SetKey(entry.GetOffset());
+
+    return true;
+}
+
+// Read the whole central directory of a seekable zip at once and index its
+// entries by name
+//
+bool wxZipInputStream::LoadIndex()
+{
+    if (m_index)
+        return true;
+    if (m_position == wxInvalidOffset)
+        if (!LoadEndRecord())
+            return false;
+    if (!m_parentSeekable || m_centralOffset == wxInvalidOffset)
+        return false;
+
+    // if the whole archive is already in memory, use it directly, both for
+    // reading the central directory and the entries later
+    const char *data = NULL;
+    size_t length = 0;
+
+    wxMemoryInputStream *mem =
+        wxDynamicCast(m_parent_i_stream, wxMemoryInputStream);
+    if (mem) {
+        data = static_cast<const char*>(
+                    mem->GetInputStreamBuffer()->GetBufferStart());
+        length = wx_truncate_cast(size_t, mem->GetLength());
+    }
+#if wxUSE_FILE
+    wxMappedFileInputStream *mapped =
+        wxDynamicCast(m_parent_i_stream, wxMappedFileInputStream);
+    if (mapped && mapped->IsMapped()) {
+        data = static_cast<const char*>(mapped->GetData());
+        length = mapped->GetDataLength();
+    }
+#endif // wxUSE_FILE
+
+    const size_t size = wx_truncate_cast(size_t, m_centralSize);
+    wxMemoryBuffer buf;
+    const char *central;
+
+    if (data && m_centralOffset + m_centralSize <= wxFileOffset(length)) {
+        central = data + m_centralOffset;
+    } else {
+        data = NULL;
+        length = 0;
+
+        // otherwise read it with a single call instead of entry by entry
+        wxFileOffset pos = m_parent_i_stream->TellI();
+        if (QuietSeek(*m_parent_i_stream, m_centralOffset) == wxInvalidOffset)
+            return false;
+        size_t count = m_parent_i_stream->Read(buf.GetWriteBuf(size),
+                                               size).LastRead();
+        buf.UngetWriteBuf(count);
+        if (pos != wxInvalidOffset)
+            QuietSeek(*m_parent_i_stream, pos);
+        if (count != size) {
+            wxLogError(_("error reading zip central directory"));
+            return false;
         }
+        central = static_cast<const char*>(buf.GetData());
+    }
+
+    wxMemoryInputStream stream(central, size);
+    wxScopedPtr<wxZipIndex> index(new wxZipIndex);
+    char magic[4];
 
-        m_entry.SetOffset(ofs);
+    while (stream.Read(magic, 4).LastRead() == 4 &&
+            CrackUint32(magic) == CENTRAL_MAGIC) {
+        wxZipEntryPtr_ entry(new wxZipEntry);
+        if (!entry->ReadCentral(stream, GetConv()) || !AdjustOffset(*entry)) {
+            wxLogError(_("error reading zip central directory"));
+            return false;
+        }
+        index->Add(entry.release());
     }
 
-    m_entry.SetKey(m_entry.GetOffset());
+    index->SetData(data, length);
+    m_index = index.release();
+    return true;
+}
 
-    return wxSTREAM_NO_ERROR;
+size_t wxZipInputStream::GetIndexedCount() const
+{
+    return m_index ? m_index->GetCount() : 0;
+}
+
+const wxZipEntry *wxZipInputStream::GetIndexedEntry(size_t n) const
+{
+    return m_index ? m_index->GetEntry(n) : NULL;
+}
+
+const wxZipEntry *wxZipInputStream::FindEntry(const wxString& name,
+                                              wxPathFormat format) const
+{
+    if (!m_index)
+        return NULL;
+    return m_index->Find(wxZipEntry::GetInternalName(name, format));
+}
+
+bool wxZipInputStream::OpenEntry(const wxString& name, wxPathFormat format)
+{
+    if (LoadIndex()) {
+        const wxZipEntry *found = FindEntry(name, format);
+        if (!found)
+            return false;
+        wxZipEntry entry(*found);
+        return DoOpen(&entry);
+    }
+
+    // not seekable, so all we can do is to search forward
+    const wxString internal = wxZipEntry::GetInternalName(name, format);
+    wxZipEntryPtr_ entry;
+
+    while (entry.reset(GetNextEntry()), entry.get() != NULL)
+        if (entry->GetInternalName() == internal)
+            return OpenEntry(*entry);
+
+    return false;
+}
+
+// Create an independent stream reading the given entry, it can be called
+// from any thread once the index is loaded
+//
+wxInputStream *wxZipInputStream::OpenEntryStream(const wxZipEntry& entry) const
+{
+    wxCHECK_MSG(m_index, NULL, wxT("LoadIndex() must be called first"));
+
+    if (entry.GetMethod() != wxZIP_METHOD_STORE &&
+            entry.GetMethod() != wxZIP_METHOD_DEFLATE) {
+        wxLogError(_("unsupported Zip compression method"));
+        return NULL;
+    }
+
+    const wxFileOffset offset = entry.GetOffset();
+    const wxFileOffset compressedSize = entry.GetCompressedSize();
+    if (offset == wxInvalidOffset || compressedSize == wxInvalidOffset)
+        return NULL;
+
+    const size_t size = wx_truncate_cast(size_t, compressedSize);
+    const char *data = m_index->GetData();
+    const wxFileOffset length = m_index->GetLength();
+
+#if wxUSE_THREADS
+    // serialize all the calls, whether the data is in memory or read from the
+    // parent stream, this is cheap as the data is only decompressed later,
+    // when reading from the returned stream
+    wxMutexLocker lock(m_index->GetReadMutex());
+#endif
+
+    if (data) {
+        if (offset + LOCAL_SIZE <= length &&
+                CrackUint32(data + offset) == LOCAL_MAGIC) {
+            const char *local = data + offset;
+            wxFileOffset start = offset + LOCAL_SIZE +
+                CrackUint16(local + 26) + CrackUint16(local + 28);
+            if (start + compressedSize <= length)
+                return new wxZipEntryInputStream(entry, data + start);
+        }
+    } else {
+        wxInputStream& stream = *m_parent_i_stream;
+        wxFileOffset pos = stream.TellI();
+        char local[LOCAL_SIZE];
+        wxMemoryBuffer buf;
+        bool ok = false;
+
+        if (QuietSeek(stream, offset) != wxInvalidOffset &&
+                stream.Read(local, LOCAL_SIZE).LastRead() == LOCAL_SIZE &&
+                CrackUint32(local) == LOCAL_MAGIC) {
+            wxFileOffset start = offset + LOCAL_SIZE +
+                CrackUint16(local + 26) + CrackUint16(local + 28);
+            if (QuietSeek(stream, start) != wxInvalidOffset) {
+                size_t count = stream.Read(buf.GetWriteBuf(size),
+                                           size).LastRead();
+                buf.UngetWriteBuf(count);
+                ok = count == size;
+            }
+        }
+
+        if (pos != wxInvalidOffset)
+            QuietSeek(stream, pos);
+
+        if (ok)
+            return new wxZipEntryInputStream(
+                    entry, static_cast<const char*>(buf.GetData()), buf);
+    }
+
+    wxLogError(_("bad zipfile offset to entry"));
+    return NULL;
 }
 
 wxStreamError wxZipInputStream::ReadLocal(bool readEndRec /*=false*/)
@@ -2171,6 +2545,141 @@ size_t wxZipInputStream::OnSysRead(void *buffer, size_t size)
 #include "wx/listimpl.cpp"
 WX_DEFINE_LIST(wxZipEntryList_)
 
+#if wxUSE_THREADS
+
+/////////////////////////////////////////////////////////////////////////////
+// Support for compressing several entries concurrently
+//
+// When wxZipOutputStream uses several threads, the data of each entry is
+// collected in memory and compressed by a task running in a thread pool when
+// the entry is closed. The compressed entries are written to the output
+// stream in their original order, with their sizes and crc known in advance,
+// as soon as they're ready.
+
+class wxZipEntryTask : public wxThreadPoolTask
+{
+public:
+    wxZipEntryTask(wxZipEntry *entry, const wxMemoryBuffer& data, int level)
+        : m_entry(entry), m_data(data), m_level(level),
+          m_crc(0), m_method(entry->GetMethod()), m_ok(false)
+    {
+    }
+
+    virtual ~wxZipEntryTask() { delete m_entry; }
+
+    // input
+    wxZipEntry *m_entry;
+    const wxMemoryBuffer m_data;
+    const int m_level;
+
+    // output
+    wxMemoryBuffer m_compressed;
+    wxUint32 m_crc;
+    int m_method;
+    bool m_ok;
+
+protected:
+    virtual void Run() wxOVERRIDE;
+
+private:
+    bool Deflate();
+};
+
+bool wxZipEntryTask::Deflate()
+{
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    if (deflateInit2(&z, m_level, Z_DEFLATED, -MAX_WBITS,
+                     8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+
+    const uLong bound = deflateBound(&z, m_data.GetDataLen());
+    z.next_in = static_cast<Bytef*>(m_data.GetData());
+    z.avail_in = m_data.GetDataLen();
+    z.next_out = static_cast<Bytef*>(m_compressed.GetWriteBuf(bound));
+    z.avail_out = bound;
+
+    const bool ok = deflate(&z, Z_FINISH) == Z_STREAM_END;
+    m_compressed.UngetWriteBuf(ok ? bound - z.avail_out : 0);
+
+    deflateEnd(&z);
+    return ok;
+}
+
+void wxZipEntryTask::Run()
+{
+    const size_t size = m_data.GetDataLen();
+    m_crc = crc32(crc32(0, Z_NULL, 0),
+                  static_cast<Bytef*>(m_data.GetData()), size);
+
+    // choose the method in the same way as OpenCompressor() and
+    // CreatePendingEntry() do it
+    if (m_method == wxZIP_METHOD_DEFAULT)
+        m_method = m_level == 0 || size <= 6 ? wxZIP_METHOD_STORE
+                                             : wxZIP_METHOD_DEFLATE;
+
+    if (m_method == wxZIP_METHOD_DEFLATE) {
+        m_ok = Deflate();
+
+        // fall back to storing the data if compression doesn't help
+        if (m_ok && m_entry->GetMethod() == wxZIP_METHOD_DEFAULT
+                 && m_compressed.GetDataLen() >= size)
+            m_method = wxZIP_METHOD_STORE;
+    }
+
+    if (m_method == wxZIP_METHOD_STORE) {
+        m_compressed = m_data;
+        m_ok = true;
+    }
+}
+
+class wxZipParallelCompressor
+{
+public:
+    explicit wxZipParallelCompressor(int threads)
+        : m_pool(threads), m_entry(NULL) { }
+
+    ~wxZipParallelCompressor()
+    {
+        for (size_t n = 0; n < m_tasks.size(); n++) {
+            m_tasks[n]->Wait();
+            delete m_tasks[n];
+        }
+    }
+
+    // can the entry data be collected in memory?
+    static bool CanCollect(const wxZipEntry& entry)
+    {
+        switch (entry.GetMethod()) {
+            case wxZIP_METHOD_DEFAULT:
+            case wxZIP_METHOD_STORE:
+            case wxZIP_METHOD_DEFLATE:
+                break;
+
+            default:
+                return false;
+        }
+
+        return entry.GetSize() == wxInvalidOffset
+                || entry.GetSize() <= PARALLEL_ENTRY_MAX;
+    }
+
+    // the maximal number of tasks queued before waiting for them
+    size_t GetMaxTasks() const { return 2 * m_pool.GetThreadCount(); }
+
+    wxThreadPool m_pool;
+    wxVector<wxZipEntryTask*> m_tasks;
+
+    // the entry being collected, which is owned by wxZipOutputStream as
+    // its pending entry, and its data
+    wxZipEntry *m_entry;
+    wxMemoryBuffer m_data;
+
+    wxDECLARE_NO_COPY_CLASS(wxZipParallelCompressor);
+};
+
+#endif // wxUSE_THREADS
+
 wxZipOutputStream::wxZipOutputStream(wxOutputStream& stream,
                                      int level      /*=-1*/,
                                      wxMBConv& conv /*=wxConvUTF8*/)
@@ -2204,11 +2713,16 @@ void wxZipOutputStream::Init(int level)
     m_offsetAdjustment = wxInvalidOffset;
     m_endrecWritten = false;
     m_format = wxZIP_FORMAT_DEFAULT;
+    m_parallel = NULL;
+    m_threads = 1;
 }
 
 wxZipOutputStream::~wxZipOutputStream()
 {
     Close();
+#if wxUSE_THREADS
+    delete m_parallel;
+#endif
     WX_CLEAR_LIST(wxZipEntryList_, m_entries);
     delete m_store;
     delete m_deflate;
@@ -2291,6 +2805,35 @@ void wxZipOutputStream::SetLevel(int level)
     }
 }
 
+void wxZipOutputStream::SetThreadCount(int threads)
+{
+    wxCHECK_RET(!IsOpened(), wxT("can't change thread count inside entry"));
+
+#if wxUSE_THREADS
+    if (threads <= 0)
+        threads = wxThreadPool::GetDefaultThreadCount();
+
+    if (threads == m_threads)
+        return;
+
+    if (m_parallel) {
+        WriteCompressedEntries(true);
+        wxDELETE(m_parallel);
+    }
+
+    if (threads > 1)
+        m_parallel = new wxZipParallelCompressor(threads);
+
+    // recreate the compressor for the big entries as well
+    if (m_comp != m_deflate)
+        wxDELETE(m_deflate);
+
+    m_threads = threads;
+#else // !wxUSE_THREADS
+    wxUnusedVar(threads);
+#endif // wxUSE_THREADS/!wxUSE_THREADS
+}
+
 bool wxZipOutputStream::DoCreate(wxZipEntry *entry, bool raw /*=false*/)
 {
     CloseEntry();
@@ -2299,7 +2842,37 @@ bool wxZipOutputStream::DoCreate(wxZipEntry *entry, bool raw /*=false*/)
     if (!m_pending)
         return false;
 
-    // write the signature bytes right away
+#if wxUSE_THREADS
+    if (m_parallel && IsOk()) {
+        if (!raw && wxZipParallelCompressor::CanCollect(*m_pending)) {
+            // defer writing anything until the entry is compressed
+            m_parallel->m_entry = m_pending;
+            m_parallel->m_data = wxMemoryBuffer();
+            m_lasterror = wxSTREAM_NO_ERROR;
+            return true;
+        }
+
+        // all the previous entries must be written before this one
+        if (!WriteCompressedEntries(true))
+            return false;
+    }
+#endif // wxUSE_THREADS
+
+    WriteLocalMagic(*m_pending);
+
+    m_crcAccumulator = crc32(0, Z_NULL, 0);
+
+    if (raw)
+        m_raw = true;
+
+    m_lasterror = wxSTREAM_NO_ERROR;
+    return true;
+}
+
+// Write the signature bytes of the entry local header and set its offset
+//
+void wxZipOutputStream::WriteLocalMagic(wxZipEntry& entry)
+{
     wxDataOutputStream ds(*m_parent_o_stream);
     ds << LOCAL_MAGIC;
 
@@ -2322,15 +2895,133 @@ bool wxZipOutputStream::DoCreate(wxZipEntry *entry, bool raw /*=false*/)
         }
     }
 
-    m_pending->SetOffset(m_headerOffset);
+    entry.SetOffset(m_headerOffset);
+}
+
+bool wxZipOutputStream::IsCollecting() const
+{
+#if wxUSE_THREADS
+    return m_parallel && m_parallel->m_entry;
+#else
+    return false;
+#endif
+}
+
+// Write the data of the entry collected so far normally, this is used when
+// it turns out to be too big to be compressed in memory.
+//
+void wxZipOutputStream::StreamCollectedEntry()
+{
+#if wxUSE_THREADS
+    wxASSERT(IsCollecting());
+
+    m_parallel->m_entry = NULL;
+    const wxMemoryBuffer data = m_parallel->m_data;
+    m_parallel->m_data = wxMemoryBuffer();
+
+    if (!WriteCompressedEntries(true))
+        return;
 
+    WriteLocalMagic(*m_pending);
     m_crcAccumulator = crc32(0, Z_NULL, 0);
+    m_entrySize = 0;
 
-    if (raw)
-        m_raw = true;
+    OnSysWrite(data.GetData(), data.GetDataLen());
+#endif // wxUSE_THREADS
+}
 
-    m_lasterror = wxSTREAM_NO_ERROR;
-    return true;
+// Queue the collected entry for compression
+//
+bool wxZipOutputStream::SubmitCollectedEntry()
+{
+#if wxUSE_THREADS
+    wxASSERT(IsCollecting());
+
+    wxZipEntryTask *task = new wxZipEntryTask(m_parallel->m_entry,
+                                              m_parallel->m_data,
+                                              GetLevel());
+    m_parallel->m_entry = NULL;
+    m_parallel->m_data = wxMemoryBuffer();
+    m_pending = NULL;
+    m_entrySize = 0;
+
+    m_parallel->m_tasks.push_back(task);
+    m_parallel->m_pool.Submit(task);
+
+    // write the entries already compressed, waiting for the oldest one if too
+    // many of them are queued
+    return WriteCompressedEntries(
+                m_parallel->m_tasks.size() > m_parallel->GetMaxTasks());
+#else
+    return false;
+#endif // wxUSE_THREADS
+}
+
+// Write the entries compressed in the background: only those already
+// compressed, or all of them if wait is true
+//
+bool wxZipOutputStream::WriteCompressedEntries(bool wait)
+{
+#if wxUSE_THREADS
+    if (!m_parallel)
+        return IsOk();
+
+    wxVector<wxZipEntryTask*>& tasks = m_parallel->m_tasks;
+
+    size_t n;
+    for (n = 0; n < tasks.size() && IsOk(); n++) {
+        wxZipEntryTask *task = tasks[n];
+        if (!wait && !task->IsDone())
+            break;
+
+        task->Wait();
+
+        wxScopedPtr<wxZipEntryTask> spTask(task);
+        wxZipEntryPtr_ spEntry(task->m_entry);
+        task->m_entry = NULL;
+
+        if (!task->m_ok) {
+            wxLogError(_("error writing zip entry '%s': compression failed"),
+                       spEntry->GetName().c_str());
+            m_lasterror = wxSTREAM_WRITE_ERROR;
+            n++;
+            break;
+        }
+
+        wxZipEntry& entry = *spEntry;
+        const size_t compressedSize = task->m_compressed.GetDataLen();
+
+        entry.SetMethod(task->m_method);
+        if (task->m_method == wxZIP_METHOD_DEFLATE)
+            entry.SetFlags((entry.GetFlags() & ~wxZIP_DEFLATE_MASK) |
+                           GetDeflateFlags(task->m_level));
+        entry.m_Flags &= ~wxZIP_SUMS_FOLLOW;
+        entry.SetSize(task->m_data.GetDataLen());
+        entry.SetCrc(task->m_crc);
+        entry.SetCompressedSize(compressedSize);
+
+        WriteLocalMagic(entry);
+
+        m_headerSize = entry.WriteLocal(*m_parent_o_stream, GetConv(), m_format);
+        m_parent_o_stream->Write(task->m_compressed.GetData(), compressedSize);
+        m_lasterror = m_parent_o_stream->GetLastError();
+        if (!IsOk()) {
+            n++;
+            break;
+        }
+
+        m_entries.push_back(spEntry.release());
+        m_headerOffset += m_headerSize + compressedSize;
+        m_headerSize = 0;
+    }
+
+    tasks.erase(tasks.begin(), tasks.begin() + n);
+
+    return IsOk();
+#else
+    wxUnusedVar(wait);
+    return IsOk();
+#endif // wxUSE_THREADS
 }
 
 // Can be overridden to add support for additional compression methods
@@ -2363,23 +3054,17 @@ wxOutputStream *wxZipOutputStream::OpenCompressor(
 
         case wxZIP_METHOD_DEFLATE:
         {
-            int defbits = wxZIP_DEFLATE_NORMAL;
-            switch (GetLevel()) {
-                case 0: case 1:
-                    defbits = wxZIP_DEFLATE_SUPERFAST;
-                    break;
-                case 2: case 3: case 4:
-                    defbits = wxZIP_DEFLATE_FAST;
-                    break;
-                case 8: case 9:
-                    defbits = wxZIP_DEFLATE_EXTRA;
-                    break;
-            }
             entry.SetFlags((entry.GetFlags() & ~wxZIP_DEFLATE_MASK) |
-                            defbits | wxZIP_SUMS_FOLLOW);
+                            GetDeflateFlags(GetLevel()) | wxZIP_SUMS_FOLLOW);
 
-            if (!m_deflate)
+            if (!m_deflate) {
                 m_deflate = new wxZlibOutputStream2(stream, GetLevel());
+
+                // big entries are not compressed concurrently with the other
+                // ones, but their data can still be compressed in parallel
+                if (m_threads != 1)
+                    m_deflate->SetThreadCount(m_threads);
+            }
             else
                 m_deflate->Open(stream);
 
@@ -2502,6 +3187,7 @@ void wxZipOutputStream::CreatePendingEntry()
 bool wxZipOutputStream::Close()
 {
     CloseEntry();
+    WriteCompressedEntries(true);
 
     if (m_lasterror == wxSTREAM_WRITE_ERROR
         || (m_entries.size() == 0 && m_endrecWritten))
@@ -2542,6 +3228,8 @@ bool wxZipOutputStream::Close()
 //
 bool wxZipOutputStream::CloseEntry()
 {
+    if (IsCollecting())
+        return IsOk() && SubmitCollectedEntry();
     if (IsOk() && m_pending)
         CreatePendingEntry();
     if (!IsOk())
@@ -2619,6 +3307,9 @@ bool wxZipOutputStream::CloseEntry()
 
 void wxZipOutputStream::Sync()
 {
+    // the entry data can't be flushed without writing it
+    if (IsOk() && IsCollecting())
+        StreamCollectedEntry();
     if (IsOk() && m_pending)
         CreatePendingEntry(NULL, 0);
     if (!m_comp)
@@ -2631,6 +3322,18 @@ void wxZipOutputStream::Sync()
 
 size_t wxZipOutputStream::OnSysWrite(const void *buffer, size_t size)
 {
+#if wxUSE_THREADS
+    if (IsOk() && IsCollecting()) {
+        if (m_parallel->m_data.GetDataLen() + size <= PARALLEL_ENTRY_MAX) {
+            m_parallel->m_data.AppendData(buffer, size);
+            m_entrySize += size;
+            return size;
+        }
+
+        StreamCollectedEntry();
+    }
+#endif // wxUSE_THREADS
+
     if (IsOk() && m_pending) {
         if (m_initialSize + size < OUTPUT_LATENCY) {
             memcpy(m_initialData + m_initialSize, buffer, size);
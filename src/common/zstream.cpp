@@ -16,6 +16,7 @@
 
 #include "wx/zstream.h"
 #include "wx/versioninfo.h"
+#include "wx/private/threadpool.h"
 
 #ifndef WX_PRECOMP
     #include "wx/intl.h"
@@ -40,6 +41,12 @@ enum {
     ZSTREAM_AUTO        = 0x20      // auto detect between gzip and zlib
 };
 
+// parallel compression parameters
+enum {
+    ZSTREAM_BLOCK_SIZE  = 128*1024, // default size of independent blocks
+    ZSTREAM_DICT_SIZE   = 32768     // size of the data used to prime them
+};
+
 
 wxVersionInfo wxGetZlibVersionInfo()
 {
@@ -274,6 +281,422 @@ bool wxZlibInputStream::SetDictionary(const wxMemoryBuffer &buf)
 }
 
 
+#if wxUSE_THREADS
+
+/////////////////////////////////
+// Parallel compression support
+/////////////////////////////////
+
+// Compresses one block of data into a raw deflate stream. Non final blocks
+// end with a sync flush, i.e. on a byte boundary and without the final block
+// bit, so that the output of all blocks can be simply concatenated.
+class wxZlibDeflateTask : public wxThreadPoolTask
+{
+public:
+    wxZlibDeflateTask(int level, int flags, bool final)
+        : m_level(level), m_flags(flags), m_final(final),
+          m_check(0), m_ok(false)
+    {
+    }
+
+    // input: the data to compress and the data preceding it
+    wxMemoryBuffer m_input;
+    wxMemoryBuffer m_dict;
+
+    const int m_level;
+    const int m_flags;
+    const bool m_final;
+
+    // output: the compressed data and the checksum of the input
+    wxMemoryBuffer m_output;
+    uLong m_check;
+    bool m_ok;
+
+protected:
+    virtual void Run() wxOVERRIDE;
+};
+
+void wxZlibDeflateTask::Run()
+{
+    const Bytef * const data = static_cast<Bytef *>(m_input.GetData());
+    const uInt len = m_input.GetDataLen();
+
+    switch ( m_flags )
+    {
+        case wxZLIB_ZLIB:
+            m_check = adler32(adler32(0, Z_NULL, 0), data, len);
+            break;
+
+        case wxZLIB_GZIP:
+            m_check = crc32(crc32(0, Z_NULL, 0), data, len);
+            break;
+    }
+
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    if ( deflateInit2(&z, m_level, Z_DEFLATED, -MAX_WBITS,
+                      8, Z_DEFAULT_STRATEGY) != Z_OK )
+        return;
+
+    if ( m_dict.GetDataLen() &&
+            deflateSetDictionary(&z, static_cast<Bytef *>(m_dict.GetData()),
+                                 m_dict.GetDataLen()) != Z_OK )
+    {
+        deflateEnd(&z);
+        return;
+    }
+
+    // deflateBound() doesn't account for the sync flush marker
+    const size_t bound = deflateBound(&z, len) + 16;
+
+    z.next_in = const_cast<Bytef *>(data);
+    z.avail_in = len;
+    z.next_out = static_cast<Bytef *>(m_output.GetWriteBuf(bound));
+    z.avail_out = bound;
+
+    // When finishing, Z_STREAM_END means that all the output was written,
+    // even if it filled the buffer exactly. When flushing, there is no such
+    // indication and the flush is only known to be complete if some space
+    // remains in the buffer, which is always the case due to the margin above.
+    const int err = deflate(&z, m_final ? Z_FINISH : Z_SYNC_FLUSH);
+    const bool done = m_final ? err == Z_STREAM_END
+                              : err == Z_OK && z.avail_out != 0;
+    if ( done && !z.avail_in )
+    {
+        m_output.UngetWriteBuf(bound - z.avail_out);
+        m_ok = true;
+    }
+    else
+    {
+        m_output.UngetWriteBuf(0);
+    }
+
+    deflateEnd(&z);
+}
+
+// This class implements the parallel mode of wxZlibOutputStream: the data is
+// split into blocks compressed independently (but using the end of the
+// previous block as dictionary to avoid losing much compression) and the
+// results are written in order, with the header and trailer generated here.
+class wxZlibParallelDeflate
+{
+public:
+    wxZlibParallelDeflate(int threads, size_t blockSize, int level, int flags)
+        : m_pool(threads),
+          m_blockSize(blockSize ? blockSize : size_t(ZSTREAM_BLOCK_SIZE)),
+          m_level(level),
+          m_flags(flags)
+    {
+        Reset();
+    }
+
+    ~wxZlibParallelDeflate()
+    {
+        DiscardTasks();
+    }
+
+    int GetThreadCount() const { return m_pool.GetThreadCount(); }
+
+    // start a new stream, possibly writing to a different output
+    void Reset()
+    {
+        DiscardTasks();
+
+        // notice that we must not modify the buffers, which may be shared
+        // with the tasks, but only replace them with the new ones
+        m_block = wxMemoryBuffer(m_blockSize);
+        m_dict = wxMemoryBuffer();
+        m_userDict = wxMemoryBuffer();
+        m_check = m_flags == wxZLIB_GZIP ? crc32(0, Z_NULL, 0)
+                                         : adler32(0, Z_NULL, 0);
+        m_length = 0;
+        m_started = false;
+    }
+
+    bool SetDictionary(const char *data, size_t datalen)
+    {
+        // as with zlib itself, gzip streams can't use a dictionary
+        if ( m_started || m_flags == wxZLIB_GZIP )
+            return false;
+
+        m_userDict = wxMemoryBuffer(datalen);
+        m_userDict.AppendData(data, datalen);
+        SetPrimingData(m_userDict);
+
+        return true;
+    }
+
+    bool Write(wxOutputStream& out, const void *buffer, size_t size);
+    bool Flush(wxOutputStream& out, bool final);
+
+private:
+    bool WriteHeader(wxOutputStream& out);
+    bool WriteTrailer(wxOutputStream& out);
+
+    void SetPrimingData(const wxMemoryBuffer& data);
+    void SubmitBlock(bool final);
+
+    // write the output of the tasks already finished, or of all of them if
+    // wait is true, to the stream
+    bool WriteTasks(wxOutputStream& out, bool wait);
+    void DiscardTasks();
+
+    wxThreadPool m_pool;
+    wxVector<wxZlibDeflateTask *> m_tasks;
+
+    const size_t m_blockSize;
+    const int m_level;
+    const int m_flags;
+
+    wxMemoryBuffer m_block,     // the data of the current block
+                   m_dict,      // the dictionary to use for the next block
+                   m_userDict;  // the dictionary set by the user, if any
+
+    uLong m_check;
+    wxUint32 m_length;          // uncompressed length modulo 2^32
+    bool m_started;
+
+    wxDECLARE_NO_COPY_CLASS(wxZlibParallelDeflate);
+};
+
+bool wxZlibParallelDeflate::WriteHeader(wxOutputStream& out)
+{
+    m_started = true;
+
+    unsigned char header[10];
+    size_t len = 0;
+
+    switch ( m_flags )
+    {
+        case wxZLIB_ZLIB:
+        {
+            // see RFC 1950 for the header format, the compression level
+            // is computed in the same way as zlib itself does it
+            int level = m_level == Z_DEFAULT_COMPRESSION ? 6 : m_level;
+            int flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+
+            unsigned hdr = (0x78 << 8) | (flevel << 6);
+            if ( m_userDict.GetDataLen() )
+                hdr |= 0x20; // FDICT
+            hdr += 31 - hdr % 31;
+
+            header[len++] = hdr >> 8;
+            header[len++] = hdr & 0xff;
+
+            if ( m_userDict.GetDataLen() )
+            {
+                uLong id = adler32(adler32(0, Z_NULL, 0),
+                                   static_cast<Bytef *>(m_userDict.GetData()),
+                                   m_userDict.GetDataLen());
+                for ( int shift = 24; shift >= 0; shift -= 8 )
+                    header[len++] = (id >> shift) & 0xff;
+            }
+            break;
+        }
+
+        case wxZLIB_GZIP:
+            // see RFC 1952, no name and no modification time are stored
+            header[len++] = 0x1f;
+            header[len++] = 0x8b;
+            header[len++] = Z_DEFLATED;
+            header[len++] = 0; // flags
+            header[len++] = 0; // mtime
+            header[len++] = 0;
+            header[len++] = 0;
+            header[len++] = 0;
+            header[len++] = m_level == 9 ? 2 : m_level == 1 ? 4 : 0;
+#ifdef __WINDOWS__
+            header[len++] = 10; // OS: NTFS
+#else
+            header[len++] = 3;  // OS: Unix
+#endif
+            break;
+    }
+
+    return !len || out.WriteAll(header, len);
+}
+
+bool wxZlibParallelDeflate::WriteTrailer(wxOutputStream& out)
+{
+    unsigned char trailer[8];
+    size_t len = 0;
+
+    switch ( m_flags )
+    {
+        case wxZLIB_ZLIB:
+            // Adler-32 in big endian order
+            for ( int shift = 24; shift >= 0; shift -= 8 )
+                trailer[len++] = (m_check >> shift) & 0xff;
+            break;
+
+        case wxZLIB_GZIP:
+            // CRC-32 and length in little endian order
+            for ( int shift = 0; shift < 32; shift += 8 )
+                trailer[len++] = (m_check >> shift) & 0xff;
+            for ( int shift = 0; shift < 32; shift += 8 )
+                trailer[len++] = (m_length >> shift) & 0xff;
+            break;
+    }
+
+    return !len || out.WriteAll(trailer, len);
+}
+
+void wxZlibParallelDeflate::SetPrimingData(const wxMemoryBuffer& data)
+{
+    // use the last ZSTREAM_DICT_SIZE bytes of the preceding data, possibly
+    // combining them with the previous dictionary for short blocks
+    const char *p = static_cast<const char *>(data.GetData());
+    size_t len = data.GetDataLen();
+
+    if ( len < ZSTREAM_DICT_SIZE )
+    {
+        size_t keep = m_dict.GetDataLen();
+        if ( keep > ZSTREAM_DICT_SIZE - len )
+            keep = ZSTREAM_DICT_SIZE - len;
+
+        wxMemoryBuffer dict;
+        dict.AppendData(static_cast<char *>(m_dict.GetData()) +
+                            m_dict.GetDataLen() - keep, keep);
+        dict.AppendData(p, len);
+        m_dict = dict;
+    }
+    else
+    {
+        wxMemoryBuffer dict(ZSTREAM_DICT_SIZE);
+        dict.AppendData(p + len - ZSTREAM_DICT_SIZE, ZSTREAM_DICT_SIZE);
+        m_dict = dict;
+    }
+}
+
+void wxZlibParallelDeflate::SubmitBlock(bool final)
+{
+    wxZlibDeflateTask * const task = new wxZlibDeflateTask(m_level, m_flags,
+                                                           final);
+    task->m_input = m_block;
+    task->m_dict = m_dict;
+
+    SetPrimingData(m_block);
+
+    // don't reuse the buffer, which is now shared with the task
+    m_block = wxMemoryBuffer(m_blockSize);
+
+    m_tasks.push_back(task);
+    m_pool.Submit(task);
+}
+
+bool wxZlibParallelDeflate::WriteTasks(wxOutputStream& out, bool wait)
+{
+    bool ok = true;
+
+    size_t n;
+    for ( n = 0; n < m_tasks.size(); n++ )
+    {
+        wxZlibDeflateTask * const task = m_tasks[n];
+        if ( !wait && !task->IsDone() )
+            break;
+
+        task->Wait();
+
+        const size_t len = task->m_input.GetDataLen();
+        switch ( m_flags )
+        {
+            case wxZLIB_ZLIB:
+                m_check = adler32_combine(m_check, task->m_check, len);
+                break;
+
+            case wxZLIB_GZIP:
+                m_check = crc32_combine(m_check, task->m_check, len);
+                break;
+        }
+
+        if ( ok )
+        {
+            ok = task->m_ok &&
+                    out.WriteAll(task->m_output.GetData(),
+                                 task->m_output.GetDataLen());
+        }
+
+        delete task;
+    }
+
+    m_tasks.erase(m_tasks.begin(), m_tasks.begin() + n);
+
+    return ok;
+}
+
+void wxZlibParallelDeflate::DiscardTasks()
+{
+    for ( size_t n = 0; n < m_tasks.size(); n++ )
+    {
+        m_tasks[n]->Wait();
+        delete m_tasks[n];
+    }
+
+    m_tasks.clear();
+}
+
+bool wxZlibParallelDeflate::Write(wxOutputStream& out,
+                                  const void *buffer,
+                                  size_t size)
+{
+    if ( !m_started && !WriteHeader(out) )
+        return false;
+
+    m_length += size;
+
+    const char *p = static_cast<const char *>(buffer);
+    while ( size )
+    {
+        size_t len = m_blockSize - m_block.GetDataLen();
+        if ( len > size )
+            len = size;
+
+        m_block.AppendData(p, len);
+        p += len;
+        size -= len;
+
+        if ( m_block.GetDataLen() < m_blockSize )
+            break;
+
+        SubmitBlock(false);
+
+        // limit the amount of memory used by waiting for the oldest block if
+        // there are enough of them queued to keep all threads busy
+        const bool wait = m_tasks.size() > 2*size_t(GetThreadCount());
+        if ( !WriteTasks(out, wait) )
+            return false;
+    }
+
+    return true;
+}
+
+bool wxZlibParallelDeflate::Flush(wxOutputStream& out, bool final)
+{
+    if ( !m_started && !WriteHeader(out) )
+        return false;
+
+    // the final block must always be written as it has the last block bit
+    if ( final || m_block.GetDataLen() )
+        SubmitBlock(final);
+
+    if ( !WriteTasks(out, true) )
+        return false;
+
+    if ( final )
+    {
+        if ( !WriteTrailer(out) )
+            return false;
+
+        // be ready to start a new stream, as wxZlibOutputStream2 used by
+        // wxZipOutputStream does
+        Reset();
+    }
+
+    return true;
+}
+
+#endif // wxUSE_THREADS
+
 //////////////////////
 // wxZlibOutputStream
 //////////////////////
@@ -300,6 +723,7 @@ void wxZlibOutputStream::Init(int level, int flags)
   m_z_buffer = new unsigned char[ZSTREAM_BUFFER_SIZE];
   m_z_size = ZSTREAM_BUFFER_SIZE;
   m_pos = 0;
+  m_parallel = NULL;
 
   if ( level == -1 )
   {
@@ -310,6 +734,9 @@ void wxZlibOutputStream::Init(int level, int flags)
     wxASSERT_MSG(level >= 0 && level <= 9, wxT("wxZlibOutputStream compression level must be between 0 and 9!"));
   }
 
+  m_level = level;
+  m_flags = flags;
+
   // if gzip is asked for but not supported...
   if (flags == wxZLIB_GZIP && !CanHandleGZip()) {
     wxLogError(_("Gzip not supported by this version of zlib"));
@@ -350,6 +777,9 @@ bool wxZlibOutputStream::Close()
    deflateEnd(m_deflate);
    wxDELETE(m_deflate);
    wxDELETEA(m_z_buffer);
+#if wxUSE_THREADS
+   wxDELETE(m_parallel);
+#endif
 
   return wxFilterOutputStream::Close() && IsOk();
  }
@@ -361,6 +791,21 @@ void wxZlibOutputStream::DoFlush(bool final)
   if (!IsOk())
     return;
 
+#if wxUSE_THREADS
+  if (m_parallel) {
+    // the stream reused by wxZipOutputStream is marked in this way when it's
+    // closed, there is nothing left to flush then
+    if (m_pos == wxInvalidOffset)
+      return;
+
+    if (!m_parallel->Flush(*m_parent_o_stream, final)) {
+      m_lasterror = wxSTREAM_WRITE_ERROR;
+      wxLogDebug(wxT("wxZlibOutputStream: Error writing to underlying stream"));
+    }
+    return;
+  }
+#endif // wxUSE_THREADS
+
   int err = Z_OK;
   bool done = false;
 
@@ -396,6 +841,19 @@ size_t wxZlibOutputStream::OnSysWrite(const void *buffer, size_t size)
   if (!IsOk() || !size)
     return 0;
 
+#if wxUSE_THREADS
+  if (m_parallel) {
+    if (!m_parallel->Write(*m_parent_o_stream, buffer, size)) {
+      m_lasterror = wxSTREAM_WRITE_ERROR;
+      wxLogDebug(wxT("wxZlibOutputStream: Error writing to underlying stream"));
+      return 0;
+    }
+
+    m_pos += size;
+    return size;
+  }
+#endif // wxUSE_THREADS
+
   int err = Z_OK;
   m_deflate->next_in = const_cast<unsigned char*>(static_cast<const unsigned char*>(buffer));
   m_deflate->avail_in = size;
@@ -436,6 +894,11 @@ size_t wxZlibOutputStream::OnSysWrite(const void *buffer, size_t size)
 
 bool wxZlibOutputStream::SetDictionary(const char *data, size_t datalen)
 {
+#if wxUSE_THREADS
+    if ( m_parallel )
+        return m_parallel->SetDictionary(data, datalen);
+#endif // wxUSE_THREADS
+
     return deflateSetDictionary(m_deflate, reinterpret_cast<const Bytef*>(data), datalen) == Z_OK;
 }
 
@@ -444,5 +907,39 @@ bool wxZlibOutputStream::SetDictionary(const wxMemoryBuffer &buf)
     return SetDictionary((char*)buf.GetData(), buf.GetDataLen());
 }
 
+bool wxZlibOutputStream::SetThreadCount(int threads, size_t blockSize)
+{
+#if wxUSE_THREADS
+    // this can only be changed before starting compression
+    wxCHECK_MSG( m_pos == 0 && m_deflate && m_deflate->total_in == 0, false,
+                 wxT("can't change the number of threads after writing") );
+
+    wxDELETE(m_parallel);
+
+    if ( threads <= 0 )
+        threads = wxThreadPool::GetDefaultThreadCount();
+
+    if ( threads > 1 )
+        m_parallel = new wxZlibParallelDeflate(threads, blockSize,
+                                               m_level, m_flags);
+
+    return true;
+#else // !wxUSE_THREADS
+    wxUnusedVar(blockSize);
+
+    return threads == 1;
+#endif // wxUSE_THREADS/!wxUSE_THREADS
+}
+
+int wxZlibOutputStream::GetThreadCount() const
+{
+#if wxUSE_THREADS
+    if ( m_parallel )
+        return m_parallel->GetThreadCount();
+#endif // wxUSE_THREADS
+
+    return 1;
+}
+
 #endif
   // wxUSE_ZLIB && wxUSE_STREAMS
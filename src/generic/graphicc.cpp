@@ -112,11 +112,6 @@ namespace
         return alpha ? (data * alpha) / 0xff : data;
     }
 
-    inline unsigned char Unpremultiply(unsigned char alpha, unsigned char data)
-    {
-        return alpha ? (data * 0xff) / alpha : data;
-    }
-
 } // anonymous namespace
 
 class WXDLLIMPEXP_CORE wxCairoPathData : public wxGraphicsPathData
@@ -1712,6 +1707,21 @@ wxCairoBitmapData::wxCairoBitmapData(wxGraphicsRenderer* renderer,
                                      const wxImage& image)
     : wxGraphicsBitmapData(renderer)
 {
+    // Images using Cairo pixel format can be just copied to the buffer.
+    if ( image.GetPixelFormat() == wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED &&
+            !image.HasMask() )
+    {
+        const int stride = InitBuffer(image.GetWidth(), image.GetHeight(),
+                                      CAIRO_FORMAT_ARGB32);
+
+        const unsigned char* src = image.GetPixels();
+        for ( int y = 0; y < m_height; y++, src += 4*m_width )
+            memcpy(m_buffer + y*stride, src, 4*m_width);
+
+        InitSurface(CAIRO_FORMAT_ARGB32, stride);
+        return;
+    }
+
     const cairo_format_t bufferFormat = image.HasAlpha() || image.HasMask()
                                             ? CAIRO_FORMAT_ARGB32
                                             : CAIRO_FORMAT_RGB24;
@@ -1803,7 +1813,7 @@ wxCairoBitmapData::wxCairoBitmapData(wxGraphicsRenderer* renderer,
 
 wxImage wxCairoBitmapData::ConvertToImage() const
 {
-    wxImage image(m_width, m_height, false /* don't clear */);
+    wxImage image;
 
     // Get the surface type and format.
     wxCHECK_MSG( cairo_surface_get_type(m_surface) == CAIRO_SURFACE_TYPE_IMAGE,
@@ -1813,11 +1823,17 @@ wxImage wxCairoBitmapData::ConvertToImage() const
     switch ( cairo_image_surface_get_format(m_surface) )
     {
         case CAIRO_FORMAT_ARGB32:
-            image.SetAlpha();
+            // Create the image in the same format as the surface, this allows
+            // to avoid undoing the pre-multiplication if it's not needed.
+            if ( !image.Create(m_width, m_height,
+                               wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED,
+                               false /* don't clear */) )
+                return wxNullImage;
             break;
 
         case CAIRO_FORMAT_RGB24:
-            // Nothing to do, we don't use alpha by default.
+            // We don't use alpha by default.
+            image.Create(m_width, m_height, false /* don't clear */);
             break;
 
         case CAIRO_FORMAT_A8:
@@ -1845,33 +1861,17 @@ wxImage wxCairoBitmapData::ConvertToImage() const
     wxASSERT_MSG( !(stride % sizeof(wxUint32)), wxS("Unexpected stride.") );
     stride /= sizeof(wxUint32);
 
-    unsigned char* dst = image.GetData();
-    unsigned char *alpha = image.GetAlpha();
-    if ( alpha )
+    if ( image.GetPixelFormat() == wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED )
     {
-        // We need to also copy alpha and undo the pre-multiplication as Cairo
-        // stores pre-multiplied values in this format while wxImage does not.
-        for ( int y = 0; y < m_height; y++ )
-        {
-            const wxUint32* const rowStart = src;
-            for ( int x = 0; x < m_width; x++ )
-            {
-                const wxUint32 argb = *src++;
-
-                const unsigned char a = argb >> 24;
-                *alpha++ = a;
-
-                // Copy the RGB data undoing the pre-multiplication.
-                *dst++ = Unpremultiply(a, argb >> 16);
-                *dst++ = Unpremultiply(a, argb >>  8);
-                *dst++ = Unpremultiply(a, argb);
-            }
-
-            src = rowStart + stride;
-        }
+        // The pixels can be just copied.
+        wxUint32* dst = reinterpret_cast<wxUint32*>(image.GetPixels());
+        for ( int y = 0; y < m_height; y++, src += stride, dst += m_width )
+            memcpy(dst, src, m_width*sizeof(wxUint32));
     }
     else // RGB
     {
+        unsigned char* dst = image.GetData();
+
         // Things are pretty simple in this case, just copy RGB bytes.
         for ( int y = 0; y < m_height; y++ )
         {
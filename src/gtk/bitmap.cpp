@@ -588,12 +588,50 @@ static void CopyImageData(
 
 #if wxUSE_IMAGE
 #ifdef __WXGTK3__
+// Create a surface with a copy of the pixels of an image in premultiplied
+// ARGB32 format, which is the native cairo format, so no conversion is needed.
+// The pixels are not shared with the image as they could be modified, or even
+// freed when converting the image to another format, behind cairo's back.
+static cairo_surface_t* CreateSurfaceForImage(const wxImage& image)
+{
+    const int w = image.GetWidth();
+    const int h = image.GetHeight();
+    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
+    cairo_surface_flush(surface);
+    CopyImageData(cairo_image_surface_get_data(surface), 4,
+        cairo_image_surface_get_stride(surface), image.GetPixels(), 4, 4 * w, w, h);
+    cairo_surface_mark_dirty(surface);
+    return surface;
+}
+
 wxBitmap::wxBitmap(const wxImage& image, int depth, double scale)
 {
     wxCHECK_RET(image.IsOk(), "invalid image");
 
     const int w = image.GetWidth();
     const int h = image.GetHeight();
+    const wxImagePixelFormat format = image.GetPixelFormat();
+    if (format != wxIMAGE_PIXEL_FORMAT_RGB &&
+        (depth < 0 || depth == 32) && !image.HasMask())
+    {
+        // Images in packed formats always have alpha and can be used without
+        // converting them to RGB first: premultiplied ARGB32 is cairo native
+        // format and RGBA is the same as GdkPixbuf format with alpha.
+        wxBitmapRefData* bmpData = new wxBitmapRefData(w, h, 32);
+        bmpData->m_scaleFactor = scale;
+        m_refData = bmpData;
+        if (format == wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED)
+            bmpData->m_surface = CreateSurfaceForImage(image);
+        else
+        {
+            GdkPixbuf* pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, true, 8, w, h);
+            bmpData->m_pixbufNoMask = pixbuf;
+            CopyImageData(gdk_pixbuf_get_pixels(pixbuf), 4, gdk_pixbuf_get_rowstride(pixbuf),
+                image.GetPixels(), 4, 4 * w, w, h);
+        }
+        return;
+    }
+
     const guchar* alpha = image.GetAlpha();
     if (depth < 0)
         depth = alpha ? 32 : 24;
@@ -768,6 +806,21 @@ wxImage wxBitmap::ConvertToImage() const
     wxBitmapRefData* bmpData = M_BMPDATA;
     const int w = bmpData->m_width;
     const int h = bmpData->m_height;
+    if (bmpData->m_surface && bmpData->m_mask == NULL)
+    {
+        cairo_surface_flush(bmpData->m_surface);
+
+        // avoid converting the surface to pixbuf and then to image
+        if (bmpData->m_pixbufNoMask == NULL &&
+            cairo_image_surface_get_format(bmpData->m_surface) == CAIRO_FORMAT_ARGB32 &&
+            image.Create(w, h, wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED, false))
+        {
+            CopyImageData(image.GetPixels(), 4, 4 * w,
+                cairo_image_surface_get_data(bmpData->m_surface), 4,
+                cairo_image_surface_get_stride(bmpData->m_surface), w, h);
+            return image;
+        }
+    }
     image.Create(w, h, false);
     guchar* dst = image.GetData();
     GdkPixbuf* pixbuf_src = NULL;
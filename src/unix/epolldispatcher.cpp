@@ -22,11 +22,13 @@
 
 #include "wx/unix/private/epolldispatcher.h"
 #include "wx/unix/private.h"
+#include "wx/scopedarray.h"
 #include "wx/stopwatch.h"
 
 #ifndef WX_PRECOMP
     #include "wx/log.h"
     #include "wx/intl.h"
+    #include "wx/utils.h"
 #endif
 
 #include <sys/epoll.h>
@@ -35,6 +37,9 @@
 
 #define wxEpollDispatcher_Trace wxT("epolldispatcher")
 
+// default number of events retrieved by a single epoll_wait() call
+static const int DEFAULT_BATCH_SIZE = 64;
+
 // ============================================================================
 // implementation
 // ============================================================================
@@ -68,6 +73,13 @@ static uint32_t GetEpollMask(int flags, int fd)
                    wxT("Registered fd %d for exceptional events"), fd);
     }
 
+    if ( flags & wxFDIO_EDGE_TRIGGERED )
+    {
+        ep |= EPOLLET;
+        wxLogTrace(wxEpollDispatcher_Trace,
+                   wxT("Using edge-triggered notifications for fd %d"), fd);
+    }
+
     return ep;
 }
 
@@ -94,28 +106,68 @@ wxEpollDispatcher::wxEpollDispatcher(int epollDescriptor)
     wxASSERT_MSG( epollDescriptor != -1, wxT("invalid descriptor") );
 
     m_epollDescriptor = epollDescriptor;
+
+    m_batchSize = DEFAULT_BATCH_SIZE;
+    m_pending = new epoll_event[m_batchSize];
+    m_numPending = 0;
 }
 
 wxEpollDispatcher::~wxEpollDispatcher()
 {
+    delete [] m_pending;
+
     if ( close(m_epollDescriptor) != 0 )
     {
         wxLogSysError(_("Error closing epoll descriptor"));
     }
 }
 
+void wxEpollDispatcher::SetBatchSize(int size)
+{
+    wxCHECK_RET( size > 0, wxT("invalid batch size") );
+
+    wxCRIT_SECT_LOCKER(lock, m_cs);
+
+    // preserve the events already retrieved by HasPending(), if any
+    epoll_event * const events = new epoll_event[wxMax(size, m_numPending)];
+    memcpy(events, m_pending, m_numPending*sizeof(epoll_event));
+
+    delete [] m_pending;
+    m_pending = events;
+    m_batchSize = size;
+}
+
 bool wxEpollDispatcher::RegisterFD(int fd, wxFDIOHandler* handler, int flags)
 {
+    {
+        wxCRIT_SECT_LOCKER(lock, m_cs);
+
+        if ( !wxMappedFDIODispatcher::RegisterFD(fd, handler, flags) )
+            return false;
+    }
+
+    // we store the descriptor and not the handler itself in the event data to
+    // be able to detect the handlers unregistered while dispatching the events
     epoll_event ev;
     ev.events = GetEpollMask(flags, fd);
-    ev.data.ptr = handler;
+    ev.data.fd = fd;
+
+    int ret = epoll_ctl(m_epollDescriptor, EPOLL_CTL_ADD, fd, &ev);
+    if ( ret != 0 && errno == EEXIST )
+    {
+        // the descriptor is being registered again with different flags,
+        // which is allowed, so just update them
+        ret = epoll_ctl(m_epollDescriptor, EPOLL_CTL_MOD, fd, &ev);
+    }
 
-    const int ret = epoll_ctl(m_epollDescriptor, EPOLL_CTL_ADD, fd, &ev);
     if ( ret != 0 )
     {
         wxLogSysError(_("Failed to add descriptor %d to epoll descriptor %d"),
                       fd, m_epollDescriptor);
 
+        wxCRIT_SECT_LOCKER(lock, m_cs);
+        wxMappedFDIODispatcher::UnregisterFD(fd);
+
         return false;
     }
     wxLogTrace(wxEpollDispatcher_Trace,
@@ -126,9 +178,16 @@ bool wxEpollDispatcher::RegisterFD(int fd, wxFDIOHandler* handler, int flags)
 
 bool wxEpollDispatcher::ModifyFD(int fd, wxFDIOHandler* handler, int flags)
 {
+    {
+        wxCRIT_SECT_LOCKER(lock, m_cs);
+
+        if ( !wxMappedFDIODispatcher::ModifyFD(fd, handler, flags) )
+            return false;
+    }
+
     epoll_event ev;
     ev.events = GetEpollMask(flags, fd);
-    ev.data.ptr = handler;
+    ev.data.fd = fd;
 
     const int ret = epoll_ctl(m_epollDescriptor, EPOLL_CTL_MOD, fd, &ev);
     if ( ret != 0 )
@@ -146,6 +205,12 @@ bool wxEpollDispatcher::ModifyFD(int fd, wxFDIOHandler* handler, int flags)
 
 bool wxEpollDispatcher::UnregisterFD(int fd)
 {
+    {
+        wxCRIT_SECT_LOCKER(lock, m_cs);
+
+        wxMappedFDIODispatcher::UnregisterFD(fd);
+    }
+
     epoll_event ev;
     ev.events = 0;
     ev.data.ptr = NULL;
@@ -194,37 +259,39 @@ wxEpollDispatcher::DoPoll(epoll_event *events, int numEvents, int timeout) const
 
 bool wxEpollDispatcher::HasPending() const
 {
-    epoll_event event;
+    wxCRIT_SECT_LOCKER(lock, m_cs);
 
-    // NB: it's not really clear if epoll_wait() can return a number greater
-    //     than the number of events passed to it but just in case it can, use
-    //     >= instead of == here, see #10397
-    return DoPoll(&event, 1, 0) >= 1;
-}
+    if ( m_numPending )
+        return true;
 
-int wxEpollDispatcher::Dispatch(int timeout)
-{
-    epoll_event events[16];
+    // retrieve the events right now, as Dispatch() is usually called after
+    // this function returns true and this avoids calling epoll_wait() again
+    const int rc = DoPoll(m_pending, m_batchSize, 0);
+    if ( rc <= 0 )
+        return false;
 
-    const int rc = DoPoll(events, WXSIZEOF(events), timeout);
+    m_numPending = rc;
 
-    if ( rc == -1 )
-    {
-        wxLogSysError(_("Waiting for IO on epoll descriptor %d failed"),
-                      m_epollDescriptor);
-        return -1;
-    }
+    return true;
+}
 
-    int numEvents = 0;
-    for ( epoll_event *p = events; p < events + rc; p++ )
+int wxEpollDispatcher::ProcessEvents(const epoll_event *events, int numEvents)
+{
+    int numProcessed = 0;
+    for ( const epoll_event *p = events; p < events + numEvents; p++ )
     {
-        wxFDIOHandler * const handler = (wxFDIOHandler *)(p->data.ptr);
-        if ( !handler )
+        wxFDIOHandler *handler;
         {
-            wxFAIL_MSG( wxT("NULL handler in epoll_event?") );
-            continue;
+            wxCRIT_SECT_LOCKER(lock, m_cs);
+
+            handler = FindHandler(p->data.fd);
         }
 
+        // the handler could have been unregistered by another one called
+        // before it in this loop
+        if ( !handler )
+            continue;
+
         // note that for compatibility with wxSelectDispatcher we call
         // OnReadWaiting() on EPOLLHUP as this is what epoll_wait() returns
         // when the write end of a pipe is closed while with select() the
@@ -238,10 +305,49 @@ int wxEpollDispatcher::Dispatch(int timeout)
         else
             continue;
 
-        numEvents++;
+        numProcessed++;
+    }
+
+    return numProcessed;
+}
+
+int wxEpollDispatcher::Dispatch(int timeout)
+{
+    // use a buffer on the stack unless a bigger batch size was set
+    epoll_event eventsOnStack[DEFAULT_BATCH_SIZE];
+    wxScopedArray<epoll_event> eventsOnHeap;
+    epoll_event *events = eventsOnStack;
+
+    int rc;
+    int batchSize;
+    {
+        wxCRIT_SECT_LOCKER(lock, m_cs);
+
+        batchSize = m_batchSize;
+        if ( wxMax(batchSize, m_numPending) > DEFAULT_BATCH_SIZE )
+        {
+            eventsOnHeap.reset(new epoll_event[wxMax(batchSize, m_numPending)]);
+            events = eventsOnHeap.get();
+        }
+
+        // use the events retrieved by HasPending(), if any
+        rc = m_numPending;
+        memcpy(events, m_pending, rc*sizeof(epoll_event));
+        m_numPending = 0;
+    }
+
+    if ( !rc )
+    {
+        rc = DoPoll(events, batchSize, timeout);
+        if ( rc == -1 )
+        {
+            wxLogSysError(_("Waiting for IO on epoll descriptor %d failed"),
+                          m_epollDescriptor);
+            return -1;
+        }
     }
 
-    return numEvents;
+    return ProcessEvents(events, rc);
 }
 
 #endif // wxUSE_EPOLL_DISPATCHER
@@ -18,7 +18,13 @@
 #ifdef wxHAS_INOTIFY
 
 #include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
 #include <unistd.h>
+#include "wx/hashset.h"
+#include "wx/timer.h"
 #include "wx/private/fswatcher.h"
 
 // ============================================================================
@@ -33,6 +39,35 @@ WX_DECLARE_HASH_MAP(int, wxFSWatchEntry*, wxIntegerHash, wxIntegerEqual,
 WX_DECLARE_HASH_MAP(int, inotify_event*, wxIntegerHash, wxIntegerEqual,
                                                       wxInotifyCookies);
 
+// path => index in the pending changes vector map
+WX_DECLARE_STRING_HASH_MAP(size_t, wxFSWPendingIndex);
+
+// set of the watched paths
+WX_DECLARE_HASH_SET(wxString, wxStringHash, wxStringEqual, wxFSWPathSet);
+
+class wxFSWatcherImplUnix;
+
+#if wxUSE_TIMER
+
+// Timer used to deliver the changes accumulated during the coalescing delay.
+class wxFSWCoalescingTimer : public wxTimer
+{
+public:
+    explicit wxFSWCoalescingTimer(wxFSWatcherImplUnix* service) :
+        m_service(service)
+    {
+    }
+
+    virtual void Notify() wxOVERRIDE;
+
+private:
+    wxFSWatcherImplUnix* const m_service;
+
+    wxDECLARE_NO_COPY_CLASS(wxFSWCoalescingTimer);
+};
+
+#endif // wxUSE_TIMER
+
 /**
  * Helper class encapsulating inotify mechanism
  */
@@ -42,7 +77,15 @@ public:
     wxFSWatcherImplUnix(wxFileSystemWatcherBase* watcher) :
         wxFSWatcherImpl(watcher),
         m_source(NULL),
-        m_ifd(-1)
+        m_ifd(-1),
+#if wxUSE_TIMER
+        m_timer(this),
+#endif // wxUSE_TIMER
+        m_coalescingDelay(0),
+        m_batch(false),
+        m_recoverOverflow(false),
+        m_queueDrained(true),
+        m_watchLimitReached(false)
     {
         m_handler = new wxFSWSourceHandler(this);
     }
@@ -103,7 +146,25 @@ public:
         int wd = DoAddInotify(watch.get());
         if (wd == -1)
         {
-            wxLogSysError( _("Unable to add inotify watch") );
+            if ( errno == ENOSPC )
+            {
+                // Don't flood the user with the same error for every
+                // directory of a big tree.
+                if ( !m_watchLimitReached )
+                {
+                    wxLogError(_("Unable to add inotify watch for \"%s\": "
+                                 "the limit on the number of watches was "
+                                 "reached, consider increasing "
+                                 "fs.inotify.max_user_watches."),
+                               watch->GetPath());
+                }
+
+                m_watchLimitReached = true;
+            }
+            else
+            {
+                wxLogSysError( _("Unable to add inotify watch") );
+            }
             return false;
         }
 
@@ -162,7 +223,210 @@ public:
             (void) DoRemove(it->second);
         }
         m_watches.clear();
+
+        // We may be able to add watches again.
+        m_watchLimitReached = false;
+        return true;
+    }
+
+    bool SetCoalescingDelay(int milliseconds)
+    {
+        wxCHECK_MSG( milliseconds >= 0, false, "Invalid coalescing delay" );
+
+#if wxUSE_TIMER
+        m_coalescingDelay = milliseconds;
+        if ( !m_coalescingDelay )
+            FlushPending();
+
         return true;
+#else // !wxUSE_TIMER
+        return milliseconds == 0;
+#endif // wxUSE_TIMER/!wxUSE_TIMER
+    }
+
+    void EnableBatching(bool enable)
+    {
+        // Deliver the changes accumulated so far in the old way.
+        FlushPending();
+
+        m_batch = enable;
+    }
+
+    void EnableOverflowRecovery(bool enable)
+    {
+        m_recoverOverflow = enable;
+        m_activePaths.clear();
+    }
+
+    // Add watches for the directory, specified by its canonical path with the
+    // trailing separator, and all its subdirectories using readdir()
+    // directly, which is much faster than using wxDir and normalizing every
+    // path found in big trees.
+    //
+    // If rescan is true, the existing watches are left alone and the
+    // creation events are generated for the newly found directories, this is
+    // used to catch up with the changes we didn't get the events for.
+    //
+    // Returns false if we ran out of inotify watches.
+    bool AddTreeDirs(const wxString& root,
+                     int events,
+                     const wxString& filespec,
+                     bool followLinks,
+                     bool rescan)
+    {
+        // Protect against loops when following symlinks, this also ensures
+        // we don't try to watch the same directory twice, which would fail as
+        // inotify returns the existing watch descriptor in this case.
+        wxFSWPathSet visited;
+
+        wxVector<wxString> dirs;
+        dirs.push_back(root);
+        while ( !dirs.empty() )
+        {
+            const wxString dir = dirs.back();
+            dirs.pop_back();
+
+            if ( followLinks )
+            {
+                struct stat st;
+                if ( stat(dir.fn_str(), &st) != 0 )
+                    continue;
+
+                const wxString id = wxString::Format
+                                    (
+                                        "%llu:%llu",
+                                        (unsigned long long)st.st_dev,
+                                        (unsigned long long)st.st_ino
+                                    );
+                if ( !visited.insert(id).second )
+                    continue;
+            }
+
+            if ( !rescan )
+            {
+                if ( !m_watcher->AddCanonicalPath(dir, events,
+                                                  wxFSWPath_Tree, filespec) )
+                {
+                    if ( m_watchLimitReached )
+                        return false;
+
+                    continue;
+                }
+            }
+            else if ( m_watches.find(dir) == m_watches.end() )
+            {
+                if ( !m_watcher->AddCanonicalPath(dir, events,
+                                                  wxFSWPath_Tree, filespec) )
+                {
+                    if ( m_watchLimitReached )
+                        return false;
+
+                    continue;
+                }
+
+                // Tell the owner, in case it's interested, as we do when we
+                // get IN_CREATE for a directory. If there's a filespec,
+                // assume he's not.
+                if ( filespec.empty() && (events & wxFSW_EVENT_CREATE) )
+                {
+                    const wxFileName fn = wxFileName::DirName(dir);
+                    NotifyChange(wxFSW_EVENT_CREATE, fn, fn);
+                }
+            }
+
+            DIR* const d = opendir(dir.fn_str());
+            if ( !d )
+                continue;
+
+            while ( const dirent* const ent = readdir(d) )
+            {
+                const char* const name = ent->d_name;
+                if ( name[0] == '.' &&
+                        (!name[1] || (name[1] == '.' && !name[2])) )
+                    continue;
+
+                const wxString path = dir + wxString(name, *wxConvFileName);
+
+                // Avoid calling stat() when we can.
+                bool isDir;
+                switch ( ent->d_type )
+                {
+                    case DT_DIR:
+                        isDir = true;
+                        break;
+
+                    case DT_LNK:
+                    case DT_UNKNOWN:
+                        if ( ent->d_type == DT_LNK && !followLinks )
+                        {
+                            isDir = false;
+                        }
+                        else
+                        {
+                            struct stat st;
+                            const int rc = followLinks
+                                            ? stat(path.fn_str(), &st)
+                                            : lstat(path.fn_str(), &st);
+                            isDir = rc == 0 && S_ISDIR(st.st_mode);
+                        }
+                        break;
+
+                    default:
+                        isDir = false;
+                }
+
+                if ( isDir )
+                    dirs.push_back(path + '/');
+            }
+
+            closedir(d);
+        }
+
+        return true;
+    }
+
+    // Called when the change notification delay expires.
+    void FlushPending()
+    {
+#if wxUSE_TIMER
+        m_timer.Stop();
+#endif // wxUSE_TIMER
+
+        if ( m_pending.empty() )
+            return;
+
+        // Sending events may result in adding more changes, so take the
+        // current ones first.
+        wxFileSystemWatcherChanges pending;
+        pending.swap(m_pending);
+        m_pendingIndex.clear();
+
+        if ( m_batch )
+        {
+            wxFileSystemWatcherEvent event(wxFSW_EVENT_BATCH);
+            for ( size_t n = 0; n < pending.size(); n++ )
+            {
+                if ( pending[n].GetChangeType() )
+                    event.AddChange(pending[n]);
+            }
+
+            if ( !event.GetChanges().empty() )
+                SendEvent(event);
+        }
+        else
+        {
+            for ( size_t n = 0; n < pending.size(); n++ )
+            {
+                const wxFileSystemWatcherChange& change = pending[n];
+                if ( !change.GetChangeType() )
+                    continue;
+
+                wxFileSystemWatcherEvent event(change.GetChangeType(),
+                                               change.GetPath(),
+                                               change.GetNewPath());
+                SendEvent(event);
+            }
+        }
     }
 
     int ReadEvents()
@@ -170,13 +434,23 @@ public:
         wxCHECK_MSG( IsOk(), -1,
                     "Inotify not initialized or invalid inotify descriptor" );
 
-        // read events
-        // TODO differentiate depending on params
-        char buf[128 * sizeof(inotify_event)];
+        // If there was nothing left in the queue the last time, the events
+        // we saw then can't be related to any future overflow.
+        if ( m_queueDrained )
+            m_activePaths.clear();
+
+        // read events: use a big buffer to read many of them at once when
+        // there are a lot of changes
+        char buf[32768];
         int left = ReadEventsToBuf(buf, sizeof(buf));
         if (left == -1)
             return -1;
 
+        // If even the biggest possible event would have fit into the buffer,
+        // we must have read all of them.
+        m_queueDrained = left + sizeof(inotify_event) + NAME_MAX + 1
+                            <= sizeof(buf);
+
         // left > 0, we have events
         char* memory = buf;
         int event_count = 0;
@@ -196,6 +470,10 @@ public:
         // take care of unmatched renames
         ProcessRenames();
 
+        // and deliver the changes if we don't wait for more of them
+        if ( !m_coalescingDelay )
+            FlushPending();
+
         wxLogTrace(wxTRACE_FSWATCHER, "We had %d native events", event_count);
         return event_count;
     }
@@ -289,6 +567,9 @@ protected:
         // check out for error/warning condition
         if (flags & wxFSW_EVENT_WARNING || flags & wxFSW_EVENT_ERROR)
         {
+            // Deliver the changes which happened before it first.
+            FlushPending();
+
             wxFSWWarningType warningType;
             if ( flags & wxFSW_EVENT_WARNING )
             {
@@ -302,6 +583,17 @@ protected:
             }
 
             wxFileSystemWatcherEvent event(flags, warningType);
+
+            if ( warningType == wxFSW_WARNING_OVERFLOW && m_recoverOverflow )
+            {
+                const wxString rescanned = RecoverFromOverflow();
+                if ( !rescanned.empty() )
+                    event.SetPath(wxFileName::DirName(rescanned));
+
+                // Again, keep the events in order.
+                FlushPending();
+            }
+
             SendEvent(event);
             return;
         }
@@ -327,12 +619,16 @@ protected:
 
         wxFSWatchEntry& watch = *(it->second);
 
+        // Remember the paths that had some activity to be able to rescan
+        // them if we miss some events due to an overflow.
+        if ( m_recoverOverflow )
+            m_activePaths.insert(watch.GetPath());
+
         // Now IN_UNMOUNT. We must do so here, as it's not in the watch flags
         if (nativeFlags & IN_UNMOUNT)
         {
             wxFileName path = GetEventPath(watch, inevt);
-            wxFileSystemWatcherEvent event(wxFSW_EVENT_UNMOUNT, path, path);
-            SendEvent(event);
+            NotifyChange(wxFSW_EVENT_UNMOUNT, path, path);
         }
         // filter out ignored events and those not asked for.
         // we never filter out warnings or exceptions
@@ -353,16 +649,21 @@ protected:
             // Though it's a dir, fn treats it as a file. So:
             fn.AssignDir(fn.GetFullPath());
 
-            if (m_watcher->AddAny(fn, wxFSW_EVENT_ALL,
-                                   wxFSWPath_Tree, watch.GetFilespec()))
+            // It could have been already added when scanning its parent
+            // below, don't add it again nor notify about it twice then.
+            if (m_watches.find(fn.GetFullPath()) == m_watches.end() &&
+                    m_watcher->AddAny(fn, wxFSW_EVENT_ALL,
+                                      wxFSWPath_Tree, watch.GetFilespec()))
             {
                 // Tell the owner, in case it's interested
                 // If there's a filespec, assume he's not
                 if (watch.GetFilespec().empty())
-                {
-                    wxFileSystemWatcherEvent event(flags, fn, fn);
-                    SendEvent(event);
-                }
+                    NotifyChange(flags, fn, fn);
+
+                // The subdirectories could have been created before we added
+                // the watch, e.g. by "mkdir -p", so check for them too.
+                AddTreeDirs(fn.GetFullPath(), wxFSW_EVENT_ALL,
+                            watch.GetFilespec(), false, true);
             }
         }
 
@@ -384,31 +685,12 @@ protected:
             wxString path(fn.GetPathWithSep());
             const wxString filespec(watch.GetFilespec());
 
-            if (m_watchMap.erase(inevt.wd) == 1)
-            {
-                // Delete from wxFileSystemWatcher
-                wxDynamicCast(m_watcher, wxInotifyFileSystemWatcher)->
-                                            OnDirDeleted(path);
-
-                // Now remove from our local list of watched items
-                wxFSWatchEntries::iterator wit =
-                                        m_watches.find(path);
-                if (wit != m_watches.end())
-                {
-                    m_watches.erase(wit);
-                }
-
-                // Cache the wd in case any events arrive late
-                m_staleDescriptors.Add(inevt.wd);
-            }
+            OnWatchedDirDeleted(inevt.wd, path);
 
             // Tell the owner, in case it's interested
             // If there's a filespec, assume he's not
             if (filespec.empty())
-            {
-                wxFileSystemWatcherEvent event(flags, fn, fn);
-                SendEvent(event);
-            }
+                NotifyChange(flags, fn, fn);
         }
 
         // renames
@@ -463,18 +745,18 @@ protected:
                         oldwatch = &watch;
                     }
 
-                    wxFileSystemWatcherEvent event(flags);
                     if ( inevt.mask & IN_MOVED_FROM )
                     {
-                        event.SetPath(GetEventPath(watch, inevt));
-                        event.SetNewPath(GetEventPath(*oldwatch, oldinevt));
+                        NotifyChange(flags,
+                                     GetEventPath(watch, inevt),
+                                     GetEventPath(*oldwatch, oldinevt));
                     }
                     else
                     {
-                        event.SetPath(GetEventPath(*oldwatch, oldinevt));
-                        event.SetNewPath(GetEventPath(watch, inevt));
+                        NotifyChange(flags,
+                                     GetEventPath(*oldwatch, oldinevt),
+                                     GetEventPath(watch, inevt));
                     }
-                    SendEvent(event);
                 }
 
                 m_cookies.erase(it2);
@@ -487,10 +769,7 @@ protected:
             wxFileName path = GetEventPath(watch, inevt);
             // For files, check that it matches any filespec
             if ( MatchesFilespec(path, watch.GetFilespec()) )
-            {
-                wxFileSystemWatcherEvent event(flags, path, path);
-                SendEvent(event);
-            }
+                NotifyChange(flags, path, path);
         }
     }
 
@@ -522,10 +801,7 @@ protected:
                 {
                     int flags = Native2WatcherFlags(inevt.mask);
                     wxFileName path = GetEventPath(watch, inevt);
-                    {
-                        wxFileSystemWatcherEvent event(flags, path, path);
-                        SendEvent(event);
-                    }
+                    NotifyChange(flags, path, path);
                 }
             }
 
@@ -535,6 +811,248 @@ protected:
         }
     }
 
+    // Forget about the watch for a directory which doesn't exist any more.
+    void OnWatchedDirDeleted(int wd, const wxString& path)
+    {
+        // Don't assert if the wd isn't found: repeated IN_DELETE_SELFs can
+        // occur
+        if (m_watchMap.erase(wd) == 1)
+        {
+            // Delete from wxFileSystemWatcher
+            wxDynamicCast(m_watcher, wxInotifyFileSystemWatcher)->
+                                        OnDirDeleted(path);
+
+            // Now remove from our local list of watched items
+            wxFSWatchEntries::iterator wit =
+                                    m_watches.find(path);
+            if (wit != m_watches.end())
+            {
+                m_watches.erase(wit);
+            }
+
+            // Cache the wd in case any events arrive late
+            m_staleDescriptors.Add(wd);
+        }
+    }
+
+    // Rescan the watched directories after an overflow, adding the watches
+    // for the new subdirectories and removing the ones for the deleted
+    // directories. Returns the directory whose subtree was rescanned or an
+    // empty string if all of them were.
+    wxString RecoverFromOverflow()
+    {
+        // The events we lost must have been for the paths changing while
+        // the queue was filling up, so find the closest directory containing
+        // all of them: it's the only part of the tree which needs rescanning.
+        wxString common;
+        for ( wxFSWPathSet::const_iterator it = m_activePaths.begin();
+              it != m_activePaths.end();
+              ++it )
+        {
+            const wxString dir = it->BeforeLast('/') + '/';
+            if ( common.empty() )
+            {
+                common = dir;
+                continue;
+            }
+
+            size_t len = 0;
+            while ( len < common.length() && len < dir.length() &&
+                        common[len] == dir[len] )
+                len++;
+
+            common = common.substr(0, len).BeforeLast('/') + '/';
+        }
+
+        m_activePaths.clear();
+
+        // Find the closest watched directory containing all the changes.
+        wxString root;
+        while ( !common.empty() )
+        {
+            if ( m_watches.find(common) != m_watches.end() )
+            {
+                root = common;
+                break;
+            }
+
+            if ( common == "/" )
+                break;
+
+            common = common.substr(0, common.length() - 1).BeforeLast('/') + '/';
+        }
+
+        // Rescan either this subtree or all the watched trees, without
+        // rescanning the same directories more than once: as the parent
+        // directories sort before their children, we just need to skip all
+        // paths starting with the last tree root.
+        wxArrayString paths;
+        if ( !root.empty() )
+        {
+            paths.push_back(root);
+        }
+        else
+        {
+            for ( wxFSWatchEntries::const_iterator it = m_watches.begin();
+                  it != m_watches.end();
+                  ++it )
+            {
+                paths.push_back(it->first);
+            }
+
+            paths.Sort();
+        }
+
+        wxString lastTree;
+        for ( size_t n = 0; n < paths.size(); n++ )
+        {
+            const wxString& path = paths[n];
+            if ( !lastTree.empty() && path.StartsWith(lastTree) )
+                continue;
+
+            wxFSWatchEntries::const_iterator it = m_watches.find(path);
+            if ( it == m_watches.end() )
+                continue;
+
+            const wxSharedPtr<wxFSWatchEntry> watch = it->second;
+            if ( watch->GetType() != wxFSWPath_Tree )
+                continue;
+
+            lastTree = path;
+            RescanTree(*watch);
+        }
+
+        return root;
+    }
+
+    void RescanTree(const wxFSWatchEntry& watch)
+    {
+        const wxString root = watch.GetPath();
+        const int events = watch.GetFlags();
+        const wxString filespec = watch.GetFilespec();
+
+        // First forget about the directories which were deleted.
+        wxVector< wxSharedPtr<wxFSWatchEntry> > deleted;
+        for ( wxFSWatchEntries::const_iterator it = m_watches.begin();
+              it != m_watches.end();
+              ++it )
+        {
+            if ( it->second->GetType() == wxFSWPath_Tree &&
+                    it->first.StartsWith(root) && !wxDirExists(it->first) )
+            {
+                deleted.push_back(it->second);
+            }
+        }
+
+        for ( size_t n = 0; n < deleted.size(); n++ )
+        {
+            const wxString& path = deleted[n]->GetPath();
+            OnWatchedDirDeleted(deleted[n]->GetWatchDescriptor(), path);
+
+            if ( filespec.empty() && (events & wxFSW_EVENT_DELETE) )
+            {
+                const wxFileName fn = wxFileName::DirName(path);
+                NotifyChange(wxFSW_EVENT_DELETE, fn, fn);
+            }
+        }
+
+        // And then add the new ones.
+        if ( wxDirExists(root) )
+            AddTreeDirs(root, events, filespec, false, true);
+    }
+
+    // Combine the type of a change already pending for some path with the
+    // type of another change to the same path, returns 0 if they cancel
+    // each other.
+    static int MergeChangeTypes(int oldType, int newType)
+    {
+        switch ( newType )
+        {
+            case wxFSW_EVENT_DELETE:
+                // A file which was created and deleted during the delay is
+                // not interesting at all.
+                return oldType == wxFSW_EVENT_CREATE ? 0 : wxFSW_EVENT_DELETE;
+
+            case wxFSW_EVENT_CREATE:
+                // A file which was replaced by another one was modified, for
+                // all practical purposes.
+                return oldType == wxFSW_EVENT_DELETE ? wxFSW_EVENT_MODIFY
+                                                     : wxFSW_EVENT_CREATE;
+        }
+
+        // A new file is still new after being modified.
+        if ( oldType == wxFSW_EVENT_CREATE || oldType == wxFSW_EVENT_DELETE )
+            return oldType;
+
+        // Otherwise keep the most important of the two changes.
+        static const int types[] =
+        {
+            wxFSW_EVENT_UNMOUNT,
+            wxFSW_EVENT_MODIFY,
+            wxFSW_EVENT_ATTRIB,
+        };
+
+        for ( size_t n = 0; n < WXSIZEOF(types); n++ )
+        {
+            if ( oldType == types[n] || newType == types[n] )
+                return types[n];
+        }
+
+        return newType;
+    }
+
+    // Either send the event about the change immediately or remember it to
+    // be sent later, when the coalescing delay expires, or as part of a
+    // batch.
+    void NotifyChange(int changeType,
+                      const wxFileName& path,
+                      const wxFileName& newPath)
+    {
+        if ( !m_coalescingDelay && !m_batch )
+        {
+            wxFileSystemWatcherEvent event(changeType, path, newPath);
+            SendEvent(event);
+            return;
+        }
+
+        const wxString key = path.GetFullPath();
+        if ( changeType == wxFSW_EVENT_RENAME )
+        {
+            // Don't merge renames with anything, but ensure that the
+            // subsequent changes are not merged with the changes before them.
+            m_pendingIndex.erase(key);
+            m_pendingIndex.erase(newPath.GetFullPath());
+            m_pending.push_back(wxFileSystemWatcherChange(changeType,
+                                                          path, newPath));
+        }
+        else
+        {
+            wxFSWPendingIndex::iterator it = m_pendingIndex.find(key);
+            if ( it == m_pendingIndex.end() )
+            {
+                m_pendingIndex[key] = m_pending.size();
+                m_pending.push_back(wxFileSystemWatcherChange(changeType,
+                                                              path, newPath));
+            }
+            else
+            {
+                wxFileSystemWatcherChange& change = m_pending[it->second];
+                change.SetChangeType(MergeChangeTypes(change.GetChangeType(),
+                                                      changeType));
+
+                // If the changes cancelled each other, the next change for
+                // this path shouldn't be merged with them.
+                if ( !change.GetChangeType() )
+                    m_pendingIndex.erase(it);
+            }
+        }
+
+#if wxUSE_TIMER
+        if ( m_coalescingDelay && !m_timer.IsRunning() )
+            m_timer.StartOnce(m_coalescingDelay);
+#endif // wxUSE_TIMER
+    }
+
     void SendEvent(wxFileSystemWatcherEvent& evt)
     {
         wxLogTrace(wxTRACE_FSWATCHER, evt.ToString());
@@ -659,8 +1177,35 @@ protected:
 
     // file descriptor created by inotify_init()
     int m_ifd;
+
+#if wxUSE_TIMER
+    // timer used to deliver the pending changes after the coalescing delay
+    wxFSWCoalescingTimer m_timer;
+#endif // wxUSE_TIMER
+
+    // the changes not delivered yet and their indices by path
+    wxFileSystemWatcherChanges m_pending;
+    wxFSWPendingIndex m_pendingIndex;
+
+    // the paths which had some events since the queue was last drained
+    wxFSWPathSet m_activePaths;
+
+    int m_coalescingDelay;                // in ms, 0 if not coalescing
+    bool m_batch;                         // deliver the changes in batches
+    bool m_recoverOverflow;               // rescan after overflow
+    bool m_queueDrained;                  // last read got all the events
+    bool m_watchLimitReached;             // got ENOSPC when adding a watch
 };
 
+#if wxUSE_TIMER
+
+void wxFSWCoalescingTimer::Notify()
+{
+    m_service->FlushPending();
+}
+
+#endif // wxUSE_TIMER
+
 
 // ============================================================================
 // wxFSWSourceHandler implementation
@@ -717,6 +1262,40 @@ bool wxInotifyFileSystemWatcher::Init()
     return m_service->Init();
 }
 
+bool wxInotifyFileSystemWatcher::AddTree(const wxFileName& path, int events,
+                                         const wxString& filespec)
+{
+    if (!path.DirExists())
+        return false;
+
+    const wxString root = GetCanonicalPath(path.GetPathWithSep());
+    if (root.empty())
+        return false;
+
+    static_cast<wxFSWatcherImplUnix*>(m_service)->
+        AddTreeDirs(root, events, filespec, path.ShouldFollowLink(), false);
+
+    return true;
+}
+
+bool wxInotifyFileSystemWatcher::SetCoalescingDelay(int milliseconds)
+{
+    return static_cast<wxFSWatcherImplUnix*>(m_service)->
+                SetCoalescingDelay(milliseconds);
+}
+
+bool wxInotifyFileSystemWatcher::EnableBatching(bool enable)
+{
+    static_cast<wxFSWatcherImplUnix*>(m_service)->EnableBatching(enable);
+    return true;
+}
+
+bool wxInotifyFileSystemWatcher::EnableOverflowRecovery(bool enable)
+{
+    static_cast<wxFSWatcherImplUnix*>(m_service)->EnableOverflowRecovery(enable);
+    return true;
+}
+
 void wxInotifyFileSystemWatcher::OnDirDeleted(const wxString& path)
 {
     if (!path.empty())
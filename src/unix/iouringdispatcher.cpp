@@ -0,0 +1,760 @@
+///////////////////////////////////////////////////////////////////////////////
+// Name:        src/unix/iouringdispatcher.cpp
+// Purpose:     implements dispatcher using Linux io_uring poll requests
+// Author:      wxWidgets team
+// Created:     2020-10-12
+// Copyright:   (c) 2020 wxWidgets development team
+// Licence:     wxWindows licence
+///////////////////////////////////////////////////////////////////////////////
+
+// ============================================================================
+// declarations
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// headers
+// ----------------------------------------------------------------------------
+
+// for compilers that support precompilation, includes "wx.h".
+#include "wx/wxprec.h"
+
+#include "wx/unix/private/iouringdispatcher.h"
+
+#ifdef wxHAS_IO_URING_DISPATCHER
+
+#include "wx/unix/private.h"
+#include "wx/scopedptr.h"
+#include "wx/stopwatch.h"
+#include "wx/vector.h"
+
+#ifndef WX_PRECOMP
+    #include "wx/hashmap.h"
+    #include "wx/log.h"
+    #include "wx/intl.h"
+    #include "wx/utils.h"
+#endif
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#define wxIOUringDispatcher_Trace wxT("iouringdispatcher")
+
+// ============================================================================
+// implementation
+// ============================================================================
+
+namespace
+{
+
+// size of the submission and completion queues: the latter is much bigger as
+// there can be an event for each of the registered descriptors
+const unsigned IOURING_SQ_ENTRIES = 256;
+const unsigned IOURING_CQ_ENTRIES = 4096;
+
+// there are no wrappers for io_uring system calls in libc
+inline int wxIOUringSetup(unsigned entries, io_uring_params *params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+inline int wxIOUringEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                          unsigned flags, void *arg, size_t argSize)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit,
+                                    minComplete, flags, arg, argSize));
+}
+
+// call io_uring_enter() and retry it if it gets interrupted, waiting for at
+// least one completion for the given time if flags include GETEVENTS and
+// minComplete is non-zero, return false if an error occurred
+bool EnterRing(int ringFd, unsigned toSubmit, unsigned flags,
+               unsigned minComplete, int timeout)
+{
+    wxMilliClock_t timeEnd;
+    if ( timeout > 0 )
+        timeEnd = wxGetLocalTimeMillis() + timeout;
+
+    for ( ;; )
+    {
+        io_uring_getevents_arg arg;
+        __kernel_timespec ts;
+        void *parg = NULL;
+        size_t argSize = 0;
+        unsigned flagsToUse = flags;
+
+        if ( minComplete && timeout != wxFDIODispatcher::TIMEOUT_INFINITE )
+        {
+            ts.tv_sec = timeout / 1000;
+            ts.tv_nsec = (timeout % 1000)*1000000;
+
+            memset(&arg, 0, sizeof(arg));
+            arg.ts = reinterpret_cast<wxUIntPtr>(&ts);
+
+            flagsToUse |= IORING_ENTER_EXT_ARG;
+            parg = &arg;
+            argSize = sizeof(arg);
+        }
+
+        if ( wxIOUringEnter(ringFd, toSubmit, minComplete,
+                            flagsToUse, parg, argSize) != -1 )
+            return true;
+
+        switch ( errno )
+        {
+            case ETIME:
+                // the timeout expired
+                return true;
+
+            case EAGAIN:
+            case EBUSY:
+                // the completion queue is full, the caller needs to process
+                // the completions before submitting more requests
+                return true;
+
+            case EINTR:
+                // we got interrupted, update the timeout and restart
+                if ( timeout > 0 )
+                {
+                    timeout = wxMilliClockToLong(timeEnd - wxGetLocalTimeMillis());
+                    if ( timeout < 0 )
+                        return true;
+                }
+                break;
+
+            default:
+                return false;
+        }
+    }
+}
+
+// the user data of the poll requests consists of the descriptor in the low
+// 32 bits and of the generation of its registration in the high ones, the
+// generation is 0 for the cancel requests whose completions are ignored
+inline __u64 MakeUserData(int fd, wxUint32 gen)
+{
+    return (static_cast<__u64>(gen) << 32) | static_cast<wxUint32>(fd);
+}
+
+// return POLLxxx mask corresponding to the given flags
+wxUint32 GetPollMask(int flags)
+{
+    wxUint32 mask = 0;
+
+    if ( flags & wxFDIO_INPUT )
+        mask |= POLLIN;
+
+    if ( flags & wxFDIO_OUTPUT )
+        mask |= POLLOUT;
+
+    if ( flags & wxFDIO_EXCEPTION )
+        mask |= POLLERR | POLLHUP;
+
+#ifdef WORDS_BIGENDIAN
+    // the kernel expects the halves of the mask to be swapped
+    mask = (mask << 16) | (mask >> 16);
+#endif
+
+    return mask;
+}
+
+} // anonymous namespace
+
+struct wxIOUringEntry
+{
+    wxFDIOHandler *handler;
+    int flags;
+
+    // incremented whenever the registration changes to allow recognizing
+    // the completions of the cancelled requests
+    wxUint32 gen;
+
+    // true if there is a poll request in progress for this descriptor
+    bool armed;
+};
+
+WX_DECLARE_HASH_MAP(int, wxIOUringEntry, wxIntegerHash, wxIntegerEqual,
+                    wxIOUringEntryMap);
+
+struct wxIOUringData
+{
+    wxIOUringData()
+    {
+        fd = -1;
+        sqRing = cqRing = MAP_FAILED;
+        sqRingSize = cqRingSize = 0;
+        sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+        sqesSize = 0;
+        lastGen = 0;
+        multishot = true;
+    }
+
+    ~wxIOUringData()
+    {
+        if ( sqes != MAP_FAILED )
+            munmap(sqes, sqesSize);
+        if ( cqRing != MAP_FAILED && cqRing != sqRing )
+            munmap(cqRing, cqRingSize);
+        if ( sqRing != MAP_FAILED )
+            munmap(sqRing, sqRingSize);
+        if ( fd != -1 )
+            close(fd);
+    }
+
+    // map the rings of the io_uring descriptor fd into memory
+    bool Map(const io_uring_params& params)
+    {
+        sqRingSize = params.sq_off.array + params.sq_entries*sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries*sizeof(io_uring_cqe);
+
+        const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if ( singleMap )
+            sqRingSize = cqRingSize = wxMax(sqRingSize, cqRingSize);
+
+        sqRing = mmap(NULL, sqRingSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if ( sqRing == MAP_FAILED )
+            return false;
+
+        if ( singleMap )
+        {
+            cqRing = sqRing;
+        }
+        else
+        {
+            cqRing = mmap(NULL, cqRingSize, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if ( cqRing == MAP_FAILED )
+                return false;
+        }
+
+        sqesSize = params.sq_entries*sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(
+                mmap(NULL, sqesSize, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if ( sqes == MAP_FAILED )
+            return false;
+
+        char * const sq = static_cast<char *>(sqRing);
+        sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sqEntries = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_entries);
+        sqFlags = reinterpret_cast<unsigned *>(sq + params.sq_off.flags);
+        sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+        char * const cq = static_cast<char *>(cqRing);
+        cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+        return true;
+    }
+
+    // return the number of completions which can be processed
+    unsigned GetCompletionsCount() const
+    {
+        return __atomic_load_n(cqTail, __ATOMIC_ACQUIRE) - *cqHead;
+    }
+
+    // return the number of queued but not yet submitted requests
+    unsigned GetUnsubmittedCount() const
+    {
+        return __atomic_load_n(sqTail, __ATOMIC_RELAXED) -
+                __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    }
+
+    // return the next submission queue entry or NULL if the queue is full,
+    // the entry must be filled and then passed to the kernel using PushSQE()
+    io_uring_sqe *GetNextSQE() const
+    {
+        if ( GetUnsubmittedCount() >= sqEntries )
+            return NULL;
+
+        io_uring_sqe * const sqe = &sqes[*sqTail & sqMask];
+        memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // make the entry returned by GetNextSQE() available to the kernel
+    void PushSQE()
+    {
+        const unsigned tail = *sqTail;
+        const unsigned index = tail & sqMask;
+
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    // return true if we need to enter the kernel to get the completions
+    bool NeedsFlush() const
+    {
+        unsigned flags = IORING_SQ_CQ_OVERFLOW;
+#ifdef IORING_SQ_TASKRUN
+        flags |= IORING_SQ_TASKRUN;
+#endif
+        return (__atomic_load_n(sqFlags, __ATOMIC_RELAXED) & flags) != 0;
+    }
+
+    int fd;
+
+    void *sqRing,
+         *cqRing;
+    size_t sqRingSize,
+           cqRingSize;
+    io_uring_sqe *sqes;
+    size_t sqesSize;
+
+    unsigned *sqHead,
+             *sqTail,
+             *sqFlags,
+             *sqArray;
+    unsigned sqMask,
+             sqEntries;
+
+    unsigned *cqHead,
+             *cqTail;
+    unsigned cqMask;
+    io_uring_cqe *cqes;
+
+    // all the registered descriptors
+    wxIOUringEntryMap entries;
+
+    // the generation used for the last registration
+    wxUint32 lastGen;
+
+    // the descriptors whose poll requests couldn't be queued after an event
+    // because the submission queue was full, they're retried later
+    wxVector<int> toRearm;
+
+    // false if the kernel doesn't support multi-shot poll requests
+    bool multishot;
+};
+
+/* static */
+wxIOUringDispatcher *wxIOUringDispatcher::Create()
+{
+    wxScopedPtr<wxIOUringData> data(new wxIOUringData);
+
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = IOURING_CQ_ENTRIES;
+#if defined(IORING_SETUP_COOP_TASKRUN) && defined(IORING_SETUP_TASKRUN_FLAG)
+    // avoid interrupting the thread when the events happen, it will pick
+    // them up when it checks for them anyhow
+    params.flags |= IORING_SETUP_COOP_TASKRUN | IORING_SETUP_TASKRUN_FLAG;
+#endif
+
+    data->fd = wxIOUringSetup(IOURING_SQ_ENTRIES, &params);
+    if ( data->fd == -1 && errno == EINVAL )
+    {
+        // older kernels don't support the flags above
+        memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = IOURING_CQ_ENTRIES;
+
+        data->fd = wxIOUringSetup(IOURING_SQ_ENTRIES, &params);
+    }
+
+    // this is not an error, io_uring may be unavailable or disabled and we
+    // will just fall back to epoll in this case
+    if ( data->fd == -1 )
+    {
+        wxLogTrace(wxIOUringDispatcher_Trace,
+                   wxT("Creating io_uring failed: %s"), wxSysErrorMsgStr());
+        return NULL;
+    }
+
+    // we need support for timeouts in io_uring_enter(), which is available
+    // since Linux 5.11
+    if ( !(params.features & IORING_FEAT_EXT_ARG) )
+    {
+        wxLogTrace(wxIOUringDispatcher_Trace,
+                   wxT("io_uring doesn't support waiting with timeout"));
+        return NULL;
+    }
+
+    if ( !data->Map(params) )
+    {
+        wxLogSysError(_("Failed to map io_uring descriptor %d"), data->fd);
+        return NULL;
+    }
+
+    wxLogTrace(wxIOUringDispatcher_Trace,
+               wxT("io_uring fd %d created"), data->fd);
+
+    return new wxIOUringDispatcher(data.release());
+}
+
+wxIOUringDispatcher::wxIOUringDispatcher(wxIOUringData *data)
+    : m_data(data)
+{
+}
+
+wxIOUringDispatcher::~wxIOUringDispatcher()
+{
+    delete m_data;
+}
+
+io_uring_sqe *wxIOUringDispatcher::GetFreeSQE()
+{
+    io_uring_sqe *sqe = m_data->GetNextSQE();
+    if ( !sqe )
+    {
+        // the queue is full, submit the queued requests to free some space
+        // in it, but do it only once: if the kernel doesn't accept them right
+        // now, e.g. because the completion queue is full, we need to give up
+        if ( Submit() )
+            sqe = m_data->GetNextSQE();
+    }
+
+    return sqe;
+}
+
+bool wxIOUringDispatcher::QueuePollAdd(int fd)
+{
+    io_uring_sqe * const sqe = GetFreeSQE();
+    if ( !sqe )
+        return false;
+
+    wxIOUringEntry& entry = m_data->entries[fd];
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = GetPollMask(entry.flags);
+    if ( (entry.flags & wxFDIO_EDGE_TRIGGERED) && m_data->multishot )
+        sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = MakeUserData(fd, entry.gen);
+
+    m_data->PushSQE();
+
+    entry.armed = true;
+
+    return true;
+}
+
+bool wxIOUringDispatcher::QueuePollRemove(int fd)
+{
+    io_uring_sqe * const sqe = GetFreeSQE();
+    if ( !sqe )
+        return false;
+
+    const wxIOUringEntry& entry = m_data->entries[fd];
+
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = MakeUserData(fd, entry.gen);
+    sqe->user_data = MakeUserData(fd, 0);
+
+    m_data->PushSQE();
+
+    return true;
+}
+
+bool wxIOUringDispatcher::Submit()
+{
+    const unsigned flags = m_data->NeedsFlush() ? IORING_ENTER_GETEVENTS : 0;
+    const unsigned toSubmit = m_data->GetUnsubmittedCount();
+    if ( !toSubmit && !flags )
+        return true;
+
+    return EnterRing(m_data->fd, toSubmit, flags, 0, 0);
+}
+
+bool wxIOUringDispatcher::SubmitAndWait(int timeout)
+{
+    unsigned toSubmit;
+    {
+        wxCRIT_SECT_LOCKER(lock, m_cs);
+
+        toSubmit = m_data->GetUnsubmittedCount();
+    }
+
+    // it is safe to submit the requests without holding the lock while
+    // waiting, as the kernel serializes the submissions and only takes the
+    // requests already made available to it by PushSQE(), even if more of
+    // them are being queued by another thread in the meanwhile
+    return EnterRing(m_data->fd, toSubmit, IORING_ENTER_GETEVENTS, 1, timeout);
+}
+
+bool wxIOUringDispatcher::RegisterFD(int fd, wxFDIOHandler* handler, int flags)
+{
+    wxCHECK_MSG( handler, false, "handler can't be NULL" );
+
+    wxCRIT_SECT_LOCKER(lock, m_cs);
+
+    wxIOUringEntryMap::iterator i = m_data->entries.find(fd);
+    const bool isNew = i == m_data->entries.end();
+    if ( !isNew )
+    {
+        wxASSERT_MSG( i->second.handler == handler,
+                        "registering different handler for the same fd?" );
+        wxASSERT_MSG( i->second.flags != flags,
+                        "reregistering with the same flags?" );
+
+        // keep the existing registration if it can't be replaced
+        if ( i->second.armed && !QueuePollRemove(fd) )
+        {
+            wxLogError(_("Failed to add descriptor %d to io_uring descriptor %d: "
+                         "too many pending requests"), fd, m_data->fd);
+            return false;
+        }
+    }
+
+    wxIOUringEntry& entry = m_data->entries[fd];
+    entry.handler = handler;
+    entry.flags = flags;
+    if ( !++m_data->lastGen )
+        ++m_data->lastGen;
+    entry.gen = m_data->lastGen;
+    entry.armed = false;
+
+    if ( !QueuePollAdd(fd) )
+    {
+        wxLogError(_("Failed to add descriptor %d to io_uring descriptor %d: "
+                     "too many pending requests"), fd, m_data->fd);
+
+        // the old request, if any, was already cancelled, so forget about
+        // this descriptor entirely
+        m_data->entries.erase(fd);
+        return false;
+    }
+
+    if ( !Submit() )
+    {
+        wxLogSysError(_("Failed to add descriptor %d to io_uring descriptor %d"),
+                      fd, m_data->fd);
+
+        if ( isNew )
+            m_data->entries.erase(fd);
+        return false;
+    }
+
+    wxLogTrace(wxIOUringDispatcher_Trace,
+               wxT("Added fd %d (handler %p) to io_uring %d"),
+               fd, handler, m_data->fd);
+
+    return true;
+}
+
+bool wxIOUringDispatcher::ModifyFD(int fd, wxFDIOHandler* handler, int flags)
+{
+    wxCHECK_MSG( handler, false, "handler can't be NULL" );
+
+    wxCRIT_SECT_LOCKER(lock, m_cs);
+
+    wxIOUringEntryMap::iterator i = m_data->entries.find(fd);
+    wxCHECK_MSG( i != m_data->entries.end(), false,
+                    "modifying unregistered handler?" );
+
+    wxIOUringEntry& entry = i->second;
+    entry.handler = handler;
+
+    // there is no need to do anything else if only the handler changes
+    if ( entry.flags == flags )
+        return true;
+
+    if ( entry.armed && !QueuePollRemove(fd) )
+    {
+        wxLogError(_("Failed to modify descriptor %d in io_uring descriptor %d: "
+                     "too many pending requests"), fd, m_data->fd);
+        return false;
+    }
+
+    entry.flags = flags;
+    if ( !++m_data->lastGen )
+        ++m_data->lastGen;
+    entry.gen = m_data->lastGen;
+    entry.armed = false;
+
+    if ( !QueuePollAdd(fd) )
+    {
+        // try again after the next event
+        m_data->toRearm.push_back(fd);
+    }
+
+    if ( !Submit() )
+    {
+        wxLogSysError(_("Failed to modify descriptor %d in io_uring descriptor %d"),
+                      fd, m_data->fd);
+
+        return false;
+    }
+
+    wxLogTrace(wxIOUringDispatcher_Trace,
+               wxT("Modified fd %d (handler: %p) on io_uring %d"),
+               fd, handler, m_data->fd);
+
+    return true;
+}
+
+bool wxIOUringDispatcher::UnregisterFD(int fd)
+{
+    wxCRIT_SECT_LOCKER(lock, m_cs);
+
+    wxIOUringEntryMap::iterator i = m_data->entries.find(fd);
+    if ( i == m_data->entries.end() )
+        return false;
+
+    // the request needs to be cancelled before the descriptor is closed
+    if ( (i->second.armed && !QueuePollRemove(fd)) || !Submit() )
+    {
+        wxLogSysError(_("Failed to unregister descriptor %d from io_uring descriptor %d"),
+                      fd, m_data->fd);
+    }
+
+    // even if we failed to cancel the request, its completion will be
+    // ignored as the descriptor is not registered any more
+    m_data->entries.erase(i);
+
+    wxLogTrace(wxIOUringDispatcher_Trace,
+               wxT("removed fd %d from %d"), fd, m_data->fd);
+
+    return true;
+}
+
+bool wxIOUringDispatcher::HasPending() const
+{
+    wxCRIT_SECT_LOCKER(lock, m_cs);
+
+    if ( m_data->GetCompletionsCount() )
+        return true;
+
+    // we only need to make a system call if there are some requests queued
+    // by Dispatch() or if the kernel has some completions to deliver
+    if ( !m_data->GetUnsubmittedCount() && !m_data->NeedsFlush() )
+        return false;
+
+    // this doesn't change the observable state of the dispatcher
+    const_cast<wxIOUringDispatcher *>(this)->Submit();
+
+    return m_data->GetCompletionsCount() != 0;
+}
+
+int wxIOUringDispatcher::Dispatch(int timeout)
+{
+    {
+        wxCRIT_SECT_LOCKER(lock, m_cs);
+
+        // retry queuing the poll requests which couldn't be queued before
+        wxVector<int> toRearm;
+        toRearm.swap(m_data->toRearm);
+        for ( size_t n = 0; n < toRearm.size(); n++ )
+        {
+            const int fd = toRearm[n];
+            wxIOUringEntryMap::iterator i = m_data->entries.find(fd);
+            if ( i != m_data->entries.end() && !i->second.armed &&
+                    !QueuePollAdd(fd) )
+                m_data->toRearm.push_back(fd);
+        }
+    }
+
+    if ( !m_data->GetCompletionsCount() )
+    {
+        if ( !SubmitAndWait(timeout) )
+        {
+            wxLogSysError(_("Waiting for IO on io_uring descriptor %d failed"),
+                          m_data->fd);
+            return -1;
+        }
+    }
+
+    // only process the completions available now as the handlers could
+    // generate more of them
+    int numEvents = 0;
+    for ( unsigned n = m_data->GetCompletionsCount(); n > 0; n-- )
+    {
+        io_uring_cqe cqe;
+        wxFDIOHandler *handler;
+        {
+            wxCRIT_SECT_LOCKER(lock, m_cs);
+
+            // the head must be read again every time as it can be changed by
+            // another thread or by a nested call to this function from one of
+            // the handlers
+            const unsigned head = *m_data->cqHead;
+            if ( head == __atomic_load_n(m_data->cqTail, __ATOMIC_ACQUIRE) )
+                break;
+
+            cqe = m_data->cqes[head & m_data->cqMask];
+            __atomic_store_n(m_data->cqHead, head + 1, __ATOMIC_RELEASE);
+
+            const int fd = static_cast<int>(cqe.user_data & 0xffffffff);
+            const wxUint32 gen = static_cast<wxUint32>(cqe.user_data >> 32);
+
+            // ignore the completions of the cancel requests
+            if ( !gen )
+                continue;
+
+            // also ignore the completions for the requests cancelled because
+            // the descriptor was unregistered or modified
+            wxIOUringEntryMap::iterator i = m_data->entries.find(fd);
+            if ( i == m_data->entries.end() || i->second.gen != gen )
+                continue;
+
+            wxIOUringEntry& entry = i->second;
+            if ( !(cqe.flags & IORING_CQE_F_MORE) )
+                entry.armed = false;
+
+            if ( cqe.res < 0 )
+            {
+                if ( cqe.res == -EINVAL && m_data->multishot &&
+                        (entry.flags & wxFDIO_EDGE_TRIGGERED) )
+                {
+                    // multi-shot poll requests are not supported by this
+                    // kernel, use one-shot ones instead
+                    m_data->multishot = false;
+                    if ( !QueuePollAdd(fd) )
+                        m_data->toRearm.push_back(fd);
+                }
+                else
+                {
+                    wxLogTrace(wxIOUringDispatcher_Trace,
+                               wxT("Poll request for fd %d failed: %s"),
+                               fd, wxSysErrorMsgStr(-cqe.res));
+                }
+
+                continue;
+            }
+
+            handler = entry.handler;
+        }
+
+        // see the comment in wxEpollDispatcher::ProcessEvents()
+        const int events = cqe.res;
+        bool processed = true;
+        if ( events & (POLLIN | POLLHUP) )
+            handler->OnReadWaiting();
+        else if ( events & POLLOUT )
+            handler->OnWriteWaiting();
+        else if ( events & POLLERR )
+            handler->OnExceptionWaiting();
+        else
+            processed = false;
+
+        if ( processed )
+            numEvents++;
+
+        // poll again for the next event unless the handler was unregistered
+        // or modified, which would have already done it
+        const int fd = static_cast<int>(cqe.user_data & 0xffffffff);
+        const wxUint32 gen = static_cast<wxUint32>(cqe.user_data >> 32);
+
+        wxCRIT_SECT_LOCKER(lock, m_cs);
+
+        wxIOUringEntryMap::iterator i = m_data->entries.find(fd);
+        if ( i != m_data->entries.end() && i->second.gen == gen &&
+                !i->second.armed && !QueuePollAdd(fd) )
+            m_data->toRearm.push_back(fd);
+    }
+
+    return numEvents;
+}
+
+#endif // wxHAS_IO_URING_DISPATCHER
@@ -14,10 +14,19 @@
 
 #if wxUSE_SOCKETS
 
+#include "wx/socket.h"
+
 #include "wx/private/fd.h"
+#include "wx/private/fdiodispatcher.h"
 #include "wx/private/socket.h"
 #include "wx/unix/private/sockunix.h"
 
+#ifdef wxHAS_SOCKET_SERVER_POOL
+    #include "wx/atomic.h"
+    #include "wx/thread.h"
+    #include "wx/unix/pipe.h"
+#endif // wxHAS_SOCKET_SERVER_POOL
+
 #include <errno.h>
 
 #include <sys/types.h>
@@ -88,8 +97,75 @@ wxSocketError wxSocketImplUnix::GetLastError() const
     }
 }
 
+void wxSocketImplUnix::SetDispatcher(wxFDIODispatcher *dispatcher)
+{
+    if ( dispatcher == m_dispatcher )
+        return;
+
+    // move the existing registrations, if any, to the new dispatcher
+    int flags = 0;
+    if ( m_fds[wxFDIOManager::INPUT] != -1 )
+        flags |= wxSOCKET_INPUT_FLAG;
+    if ( m_fds[wxFDIOManager::OUTPUT] != -1 )
+        flags |= wxSOCKET_OUTPUT_FLAG;
+
+    if ( flags )
+        DisableEvents(flags);
+
+    m_dispatcher = dispatcher;
+
+    if ( flags )
+        EnableEvents(flags);
+}
+
+void wxSocketImplUnix::DoEnableDispatcherEvents(int flags, bool enable)
+{
+    const int regmask = GetRegisteredEvents();
+
+    int mask = 0;
+    if ( flags & wxSOCKET_INPUT_FLAG )
+    {
+        mask |= wxFDIO_INPUT;
+        m_fds[wxFDIOManager::INPUT] = enable ? m_fd : -1;
+    }
+    if ( flags & wxSOCKET_OUTPUT_FLAG )
+    {
+        mask |= wxFDIO_OUTPUT;
+        m_fds[wxFDIOManager::OUTPUT] = enable ? m_fd : -1;
+    }
+
+    const int newmask = enable ? regmask | mask : regmask & ~mask;
+    if ( newmask == regmask )
+        return;
+
+    // this is the same logic as in wxFDIOManagerUnix, but using our own
+    // dispatcher instead of the global one
+    bool ok;
+    if ( !regmask )
+        ok = m_dispatcher->RegisterFD(m_fd, this, newmask);
+    else if ( !newmask )
+        ok = m_dispatcher->UnregisterFD(m_fd);
+    else
+        ok = m_dispatcher->ModifyFD(m_fd, this, newmask);
+
+    if ( !ok && enable )
+    {
+        wxLogDebug("Failed to register socket %d for events", m_fd);
+        return;
+    }
+
+    ClearRegisteredEvent(regmask & ~newmask);
+    SetRegisteredEvent(newmask);
+}
+
 void wxSocketImplUnix::DoEnableEvents(int flags, bool enable)
 {
+    if ( m_dispatcher )
+    {
+        DoEnableDispatcherEvents(flags, enable);
+        return;
+    }
+
     wxSocketManager * const manager = wxSocketManager::Get();
     if (!manager)
         return;
@@ -238,4 +314,673 @@ void wxSocketImplUnix::OnExceptionWaiting()
         OnStateChange(wxSOCKET_LOST);
 }
 
+#ifdef wxHAS_SOCKET_SERVER_POOL
+
+// ============================================================================
+// wxSocketServerPool implementation
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// wxSocketPoolWorker: thread handling the connections of wxSocketServerPool
+// ----------------------------------------------------------------------------
+
+class wxSocketPoolWorker : public wxThread,
+                           private wxFDIOHandler
+{
+public:
+    // create the worker using the given dispatcher and the server socket,
+    // which may be NULL if this worker doesn't accept connections itself,
+    // both of which are owned by the worker
+    //
+    // if distribute is true, the connections accepted by this worker are
+    // distributed between all the workers and not handled by it only
+    wxSocketPoolWorker(const wxVector<wxSocketPoolWorker *>& workers,
+                       wxFDIODispatcher *dispatcher,
+                       wxSocketServer *server,
+                       wxSocketFlags flags,
+                       bool distribute);
+    virtual ~wxSocketPoolWorker();
+
+    bool IsOk() const { return m_wakeUpPipe.IsOk(); }
+
+    wxSocketServer *GetServer() const { return m_server; }
+
+    void SetEventHandler(wxEvtHandler *handler, int id, wxSocketEventFlags notify)
+    {
+        m_handler = handler;
+        m_id = id;
+        m_notify = notify;
+    }
+
+    // check if the socket is handled by this worker
+    bool Owns(const wxSocketBase *socket) const
+    {
+        return socket->m_handler == &m_sink;
+    }
+
+    int GetConnectionCount() const { return m_connectionCount; }
+
+    // these functions can be called from any thread
+    void AddConnection(wxSocketBase *socket);
+    void RequestStop();
+
+    // this one can only be called from the worker thread itself
+    void CloseConnection(wxSocketBase *socket);
+
+protected:
+    virtual ExitCode Entry() wxOVERRIDE;
+
+private:
+    // the event handler used for all our sockets: it just queues the events
+    // to be processed by the worker thread later, as it's not safe to do it
+    // from inside wxFDIODispatcher::Dispatch()
+    class EventSink : public wxEvtHandler
+    {
+    public:
+        explicit EventSink(wxSocketPoolWorker& worker) : m_worker(worker) { }
+
+        virtual void QueueEvent(wxEvent *event) wxOVERRIDE
+        {
+            m_worker.QueueSocketEvent(event);
+        }
+
+    private:
+        wxSocketPoolWorker& m_worker;
+
+        wxDECLARE_NO_COPY_CLASS(EventSink);
+    };
+
+    // wxFDIOHandler methods used for the wake up pipe
+    virtual void OnReadWaiting() wxOVERRIDE;
+    virtual void OnWriteWaiting() wxOVERRIDE { }
+    virtual void OnExceptionWaiting() wxOVERRIDE { }
+
+    void WakeUp();
+
+    void QueueSocketEvent(wxEvent *event);
+
+    // functions called from the worker thread only
+    void AttachConnection(wxSocketBase *socket);
+    void AcceptConnections();
+    void ProcessNewConnections();
+    void ProcessEvents();
+    void DeleteClosedConnections();
+    void DeleteAll();
+
+    bool IsClosing(const wxSocketBase *socket) const;
+
+
+    const wxVector<wxSocketPoolWorker *>& m_workers;
+    wxFDIODispatcher *m_dispatcher;
+    wxSocketServer *m_server;
+    const wxSocketFlags m_flags;
+    const bool m_distribute;
+
+    EventSink m_sink;
+    wxPipe m_wakeUpPipe;
+
+    // the user-defined handler and the events it's interested in
+    wxEvtHandler *m_handler;
+    int m_id;
+    wxSocketEventFlags m_notify;
+
+    // protects the fields below it
+    wxCriticalSection m_cs;
+    wxVector<wxEvent *> m_events;
+    wxVector<wxSocketBase *> m_newSockets;
+    bool m_stop;
+    bool m_wakeUpPending;
+
+    // these fields are only used by the worker thread
+    wxVector<wxSocketBase *> m_sockets;
+    wxVector<wxSocketBase *> m_closing;
+    size_t m_nextWorker;
+
+    wxAtomicInt m_connectionCount;
+
+    wxDECLARE_NO_COPY_CLASS(wxSocketPoolWorker);
+};
+
+wxSocketPoolWorker::wxSocketPoolWorker(const wxVector<wxSocketPoolWorker *>& workers,
+                                       wxFDIODispatcher *dispatcher,
+                                       wxSocketServer *server,
+                                       wxSocketFlags flags,
+                                       bool distribute)
+    : wxThread(wxTHREAD_JOINABLE),
+      m_workers(workers),
+      m_dispatcher(dispatcher),
+      m_server(server),
+      m_flags(flags),
+      m_distribute(distribute),
+      m_sink(*this),
+      m_handler(NULL),
+      m_id(wxID_ANY),
+      m_notify(0),
+      m_stop(false),
+      m_wakeUpPending(false),
+      m_nextWorker(0),
+      m_connectionCount(0)
+{
+    if ( !m_wakeUpPipe.Create() ||
+            !m_wakeUpPipe.MakeNonBlocking(wxPipe::Read) ||
+                !m_wakeUpPipe.MakeNonBlocking(wxPipe::Write) ||
+                    !m_dispatcher->RegisterFD(m_wakeUpPipe[wxPipe::Read],
+                                              this, wxFDIO_INPUT) )
+    {
+        m_wakeUpPipe.Close();
+        return;
+    }
+
+    if ( m_server )
+    {
+        // start monitoring the server socket using our dispatcher: notice
+        // that it must have been created in the blocking mode to avoid
+        // registering it with the global socket manager first
+        static_cast<wxSocketImplUnix *>(m_server->m_impl)->
+            SetDispatcher(m_dispatcher);
+
+        m_server->SetEventHandler(m_sink);
+        m_server->SetNotify(wxSOCKET_CONNECTION_FLAG);
+        m_server->Notify(true);
+        m_server->SetFlags(wxSOCKET_NONE);
+    }
+}
+
+wxSocketPoolWorker::~wxSocketPoolWorker()
+{
+    // this is only needed if the thread had never run
+    DeleteAll();
+
+    if ( m_wakeUpPipe.IsOk() )
+        m_dispatcher->UnregisterFD(m_wakeUpPipe[wxPipe::Read]);
+
+    delete m_dispatcher;
+}
+
+void wxSocketPoolWorker::WakeUp()
+{
+    // must be called with m_cs locked
+    if ( m_wakeUpPending )
+        return;
+
+    m_wakeUpPending = true;
+
+    const char ch = 0;
+    if ( write(m_wakeUpPipe[wxPipe::Write], &ch, 1) != 1 )
+    {
+        wxLogDebug("Failed to wake up socket pool worker thread");
+    }
+}
+
+void wxSocketPoolWorker::OnReadWaiting()
+{
+    wxCriticalSectionLocker lock(m_cs);
+
+    char buf[64];
+    while ( read(m_wakeUpPipe[wxPipe::Read], buf, sizeof(buf)) > 0 )
+        ;
+
+    m_wakeUpPending = false;
+}
+
+void wxSocketPoolWorker::QueueSocketEvent(wxEvent *event)
+{
+    wxCriticalSectionLocker lock(m_cs);
+
+    m_events.push_back(event);
+
+    // normally the events are generated by the worker thread itself, but wake
+    // it up if this is not the case as it could be blocked in Dispatch()
+    if ( wxThread::GetCurrentId() != GetId() )
+        WakeUp();
+}
+
+void wxSocketPoolWorker::AddConnection(wxSocketBase *socket)
+{
+    if ( wxThread::GetCurrentId() == GetId() )
+    {
+        AttachConnection(socket);
+        return;
+    }
+
+    wxCriticalSectionLocker lock(m_cs);
+
+    m_newSockets.push_back(socket);
+    WakeUp();
+}
+
+void wxSocketPoolWorker::RequestStop()
+{
+    wxCriticalSectionLocker lock(m_cs);
+
+    m_stop = true;
+    WakeUp();
+}
+
+void wxSocketPoolWorker::AttachConnection(wxSocketBase *socket)
+{
+    static_cast<wxSocketImplUnix *>(socket->m_impl)->SetDispatcher(m_dispatcher);
+
+    // we always need to know about the lost connections to delete them
+    socket->SetEventHandler(m_sink, m_id);
+    socket->SetNotify(m_notify | wxSOCKET_LOST_FLAG);
+    socket->Notify(true);
+
+    // this switches the socket to the non-blocking mode and registers it with
+    // our dispatcher
+    socket->SetFlags(m_flags);
+
+    m_sockets.push_back(socket);
+    m_connectionCount++;
+
+    // generate the connection event for the accepted socket
+    socket->OnRequest(wxSOCKET_CONNECTION);
+}
+
+void wxSocketPoolWorker::AcceptConnections()
+{
+    // accept all the pending connections at once
+    for ( ;; )
+    {
+        wxSocketBase * const socket = new wxSocketBase(wxSOCKET_BLOCK,
+                                                       wxSOCKET_BASE);
+        if ( !m_server->AcceptWith(*socket, false) )
+        {
+            delete socket;
+            break;
+        }
+
+        wxSocketPoolWorker * const worker = m_distribute
+            ? m_workers[m_nextWorker++ % m_workers.size()]
+            : this;
+
+        worker->AddConnection(socket);
+    }
+}
+
+void wxSocketPoolWorker::ProcessNewConnections()
+{
+    wxVector<wxSocketBase *> sockets;
+    {
+        wxCriticalSectionLocker lock(m_cs);
+        sockets.swap(m_newSockets);
+    }
+
+    for ( size_t n = 0; n < sockets.size(); n++ )
+        AttachConnection(sockets[n]);
+}
+
+bool wxSocketPoolWorker::IsClosing(const wxSocketBase *socket) const
+{
+    for ( size_t n = 0; n < m_closing.size(); n++ )
+    {
+        if ( m_closing[n] == socket )
+            return true;
+    }
+
+    return false;
+}
+
+void wxSocketPoolWorker::ProcessEvents()
+{
+    wxVector<wxEvent *> events;
+    {
+        wxCriticalSectionLocker lock(m_cs);
+        events.swap(m_events);
+    }
+
+    for ( size_t n = 0; n < events.size(); n++ )
+    {
+        wxSocketEvent& event = static_cast<wxSocketEvent&>(*events[n]);
+        wxSocketBase * const socket = event.GetSocket();
+
+        if ( socket == m_server )
+        {
+            AcceptConnections();
+        }
+        else if ( !IsClosing(socket) )
+        {
+            const wxSocketNotify notify = event.GetSocketEvent();
+            if ( m_handler && (m_notify & (1 << notify)) )
+                m_handler->ProcessEventLocally(event);
+
+            if ( notify == wxSOCKET_LOST )
+                CloseConnection(socket);
+        }
+
+        delete events[n];
+    }
+}
+
+void wxSocketPoolWorker::CloseConnection(wxSocketBase *socket)
+{
+    if ( IsClosing(socket) )
+        return;
+
+    socket->Notify(false);
+    socket->Close();
+
+    m_closing.push_back(socket);
+}
+
+void wxSocketPoolWorker::DeleteClosedConnections()
+{
+    if ( m_closing.empty() )
+        return;
+
+    // discard any events still pending for the sockets being deleted
+    {
+        wxCriticalSectionLocker lock(m_cs);
+
+        for ( size_t n = 0; n < m_events.size(); )
+        {
+            wxSocketEvent * const
+                event = static_cast<wxSocketEvent *>(m_events[n]);
+            if ( IsClosing(event->GetSocket()) )
+            {
+                delete event;
+                m_events.erase(m_events.begin() + n);
+            }
+            else
+            {
+                n++;
+            }
+        }
+    }
+
+    for ( size_t n = 0; n < m_closing.size(); n++ )
+    {
+        for ( size_t m = 0; m < m_sockets.size(); m++ )
+        {
+            if ( m_sockets[m] == m_closing[n] )
+            {
+                m_sockets.erase(m_sockets.begin() + m);
+                break;
+            }
+        }
+
+        delete m_closing[n];
+        m_connectionCount--;
+    }
+
+    m_closing.clear();
+}
+
+void wxSocketPoolWorker::DeleteAll()
+{
+    for ( size_t n = 0; n < m_sockets.size(); n++ )
+    {
+        if ( !IsClosing(m_sockets[n]) )
+            CloseConnection(m_sockets[n]);
+    }
+
+    DeleteClosedConnections();
+
+    wxCriticalSectionLocker lock(m_cs);
+
+    for ( size_t n = 0; n < m_newSockets.size(); n++ )
+        delete m_newSockets[n];
+    m_newSockets.clear();
+
+    for ( size_t n = 0; n < m_events.size(); n++ )
+        delete m_events[n];
+    m_events.clear();
+
+    wxDELETE(m_server);
+}
+
+wxThread::ExitCode wxSocketPoolWorker::Entry()
+{
+    for ( ;; )
+    {
+        bool hasEvents;
+        {
+            wxCriticalSectionLocker lock(m_cs);
+            if ( m_stop )
+                break;
+
+            hasEvents = !m_events.empty() || !m_newSockets.empty();
+        }
+
+        // don't block if we already have something to do
+        m_dispatcher->Dispatch(hasEvents ? 0
+                                         : wxFDIODispatcher::TIMEOUT_INFINITE);
+
+        ProcessNewConnections();
+        ProcessEvents();
+        DeleteClosedConnections();
+    }
+
+    // close all the sockets from this thread as they're registered with our
+    // dispatcher which can only be used by it
+    DeleteAll();
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// wxSocketServerPool
+// ----------------------------------------------------------------------------
+
+wxSocketServerPool::wxSocketServerPool(const wxSockAddress& addr,
+                                       int threads,
+                                       wxSocketFlags flags)
+    : m_local(NULL),
+      m_handler(NULL),
+      m_id(wxID_ANY),
+      m_notify(wxSOCKET_INPUT_FLAG | wxSOCKET_LOST_FLAG),
+      m_reusePort(false),
+      m_started(false),
+      m_numStarted(0)
+{
+    if ( threads <= 0 )
+    {
+        threads = wxThread::GetCPUCount();
+        if ( threads <= 0 )
+            threads = 1;
+    }
+
+    // the server sockets must be created in the blocking mode to avoid
+    // registering them with the global socket manager, see the worker ctor
+    const wxSocketFlags
+        serverFlags = wxSOCKET_BLOCK |
+                        (flags & (wxSOCKET_REUSEADDR | wxSOCKET_REUSEPORT));
+
+    // while the accepted sockets must be non-blocking to generate events
+    flags &= ~(wxSOCKET_BLOCK | wxSOCKET_REUSEADDR | wxSOCKET_REUSEPORT);
+
+    wxVector<wxSocketServer *> servers;
+    servers.push_back(new wxSocketServer(addr, serverFlags));
+    if ( !servers[0]->IsOk() )
+    {
+        delete servers[0];
+        return;
+    }
+
+    // remember the address we're effectively bound to, this is notably
+    // important if the port was 0 in the original address
+    m_local = addr.Clone();
+    servers[0]->GetLocal(*m_local);
+
+    // create the other server sockets bound to the same address if possible
+    // and fall back to using a single one if SO_REUSEPORT is not supported
+    if ( (serverFlags & wxSOCKET_REUSEPORT) && threads > 1 )
+    {
+        for ( int n = 1; n < threads; n++ )
+        {
+            wxSocketServer * const
+                server = new wxSocketServer(*m_local, serverFlags);
+            if ( !server->IsOk() )
+            {
+                delete server;
+                break;
+            }
+
+            servers.push_back(server);
+        }
+
+        if ( servers.size() == static_cast<size_t>(threads) )
+        {
+            m_reusePort = true;
+        }
+        else
+        {
+            while ( servers.size() > 1 )
+            {
+                delete servers.back();
+                servers.pop_back();
+            }
+        }
+    }
+
+    for ( int n = 0; n < threads; n++ )
+    {
+        wxSocketServer * const server = static_cast<size_t>(n) < servers.size()
+                                            ? servers[n]
+                                            : NULL;
+
+        wxFDIODispatcher * const dispatcher = wxFDIODispatcher::Create();
+        if ( !dispatcher )
+        {
+            delete server;
+            continue;
+        }
+
+        // notice that the worker takes ownership of the dispatcher and the
+        // server even if it fails to initialize
+        wxSocketPoolWorker * const
+            worker = new wxSocketPoolWorker(m_workers, dispatcher, server,
+                                            flags, !m_reusePort);
+        if ( !worker->IsOk() )
+        {
+            delete worker;
+            continue;
+        }
+
+        m_workers.push_back(worker);
+    }
+
+    // we can't do anything without the first worker, as it's the only one
+    // accepting the connections if SO_REUSEPORT is not used
+    if ( !m_workers.empty() && !m_workers[0]->GetServer() )
+    {
+        for ( size_t n = 0; n < m_workers.size(); n++ )
+            delete m_workers[n];
+
+        m_workers.clear();
+    }
+}
+
+wxSocketServerPool::~wxSocketServerPool()
+{
+    Stop();
+
+    for ( size_t n = 0; n < m_workers.size(); n++ )
+        delete m_workers[n];
+
+    delete m_local;
+}
+
+bool wxSocketServerPool::GetLocal(wxSockAddress& addr) const
+{
+    wxCHECK_MSG( IsOk(), false, "invalid socket server pool" );
+
+    addr.SetAddress(m_local->GetAddress());
+
+    return true;
+}
+
+void wxSocketServerPool::SetEventHandler(wxEvtHandler& handler, int id)
+{
+    wxCHECK_RET( !m_started, "must be called before Start()" );
+
+    m_handler = &handler;
+    m_id = id;
+}
+
+void wxSocketServerPool::SetNotify(wxSocketEventFlags flags)
+{
+    wxCHECK_RET( !m_started, "must be called before Start()" );
+
+    m_notify = flags;
+}
+
+bool wxSocketServerPool::Start()
+{
+    wxCHECK_MSG( IsOk(), false, "invalid socket server pool" );
+    wxCHECK_MSG( !m_started, false, "already started" );
+
+    m_started = true;
+
+    for ( size_t n = 0; n < m_workers.size(); n++ )
+    {
+        m_workers[n]->SetEventHandler(m_handler, m_id, m_notify);
+
+        if ( m_workers[n]->Run() != wxTHREAD_NO_ERROR )
+        {
+            wxLogDebug("Failed to start socket pool worker thread");
+
+            Stop();
+            return false;
+        }
+
+        m_numStarted++;
+    }
+
+    return true;
+}
+
+void wxSocketServerPool::Stop()
+{
+    if ( !m_started )
+        return;
+
+    for ( size_t n = 0; n < m_workers.size(); n++ )
+        m_workers[n]->RequestStop();
+
+    // join all the started threads, even those which have already exited,
+    // as otherwise their resources would be leaked
+    for ( size_t n = 0; n < m_numStarted; n++ )
+        m_workers[n]->Wait();
+
+    m_numStarted = 0;
+
+    // the workers can't be restarted
+    for ( size_t n = 0; n < m_workers.size(); n++ )
+        delete m_workers[n];
+
+    m_workers.clear();
+}
+
+void wxSocketServerPool::CloseConnection(wxSocketBase *socket)
+{
+    wxCHECK_RET( socket, "NULL socket" );
+
+    for ( size_t n = 0; n < m_workers.size(); n++ )
+    {
+        wxSocketPoolWorker * const worker = m_workers[n];
+        if ( worker->Owns(socket) )
+        {
+            wxCHECK_RET( wxThread::GetCurrentId() == worker->GetId(),
+                         "must be called from the socket thread" );
+
+            worker->CloseConnection(socket);
+            return;
+        }
+    }
+
+    wxFAIL_MSG( "socket doesn't belong to this pool" );
+}
+
+int wxSocketServerPool::GetConnectionCount() const
+{
+    int count = 0;
+    for ( size_t n = 0; n < m_workers.size(); n++ )
+        count += m_workers[n]->GetConnectionCount();
+
+    return count;
+}
+
+#endif // wxHAS_SOCKET_SERVER_POOL
+
 #endif  /* wxUSE_SOCKETS */
@@ -43,6 +43,7 @@
 #include "wx/process.h"
 #include "wx/scopedptr.h"
 #include "wx/thread.h"
+#include "wx/vector.h"
 
 #include "wx/cmdline.h"
 
@@ -120,6 +121,7 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <errno.h>
 #include <netdb.h>
 #include <signal.h>
@@ -141,6 +143,25 @@
     #include <sys/resource.h>   // for setpriority()
 #endif
 
+// posix_spawn() can only be used instead of fork() if we can close all the
+// inherited descriptors in the child, as we do after fork().
+#if defined(HAVE_POSIX_SPAWN) && \
+    defined(HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP)
+    #define wxHAS_POSIX_SPAWN
+    #include <spawn.h>
+
+    // not necessarily declared in the system headers
+    extern char **environ;
+#endif
+
+#ifdef __LINUX__
+    #include <sys/syscall.h>    // for SYS_pidfd_open
+
+    #ifdef SYS_pidfd_open
+        #define wxHAS_PIDFD
+    #endif
+#endif // __LINUX__
+
 // ----------------------------------------------------------------------------
 // conditional compilation
 // ----------------------------------------------------------------------------
@@ -486,6 +507,61 @@ long wxExecute(const wchar_t* const* wargv, int flags, wxProcess* process,
 namespace
 {
 
+// Handler of the pidfd becoming readable when the child process exits.
+//
+// As wxExecuteIOHandlerBase, it can be used with either an event loop or a
+// wxFDIODispatcher.
+template <class T>
+class wxExecutePidFDHandlerBase : public T
+{
+public:
+    explicit wxExecutePidFDHandlerBase(wxExecuteData& execData)
+        : m_execData(execData)
+    {
+    }
+
+    virtual void OnReadWaiting() wxOVERRIDE
+    {
+        // Notice that this object may be deleted by this call.
+        m_execData.OnPidFDReady();
+    }
+
+    virtual void OnWriteWaiting() wxOVERRIDE { }
+    virtual void OnExceptionWaiting() wxOVERRIDE { }
+
+private:
+    wxExecuteData& m_execData;
+
+    wxDECLARE_NO_COPY_CLASS(wxExecutePidFDHandlerBase);
+};
+
+typedef wxExecutePidFDHandlerBase<wxEventLoopSourceHandler>
+    wxExecutePidFDEventLoopSourceHandler;
+
+class wxExecutePidFDIOHandler : public wxExecutePidFDHandlerBase<wxFDIOHandler>
+{
+public:
+    wxExecutePidFDIOHandler(wxFDIODispatcher& dispatcher,
+                            wxExecuteData& execData)
+        : wxExecutePidFDHandlerBase<wxFDIOHandler>(execData),
+          m_dispatcher(dispatcher),
+          m_fd(execData.GetPidFD())
+    {
+        dispatcher.RegisterFD(m_fd, this, wxFDIO_INPUT);
+    }
+
+    virtual ~wxExecutePidFDIOHandler()
+    {
+        m_dispatcher.UnregisterFD(m_fd);
+    }
+
+private:
+    wxFDIODispatcher& m_dispatcher;
+    const int m_fd;
+
+    wxDECLARE_NO_COPY_CLASS(wxExecutePidFDIOHandler);
+};
+
 // Helper function of wxExecute(): wait for the process termination without
 // dispatching any events.
 //
@@ -518,16 +594,20 @@ int BlockUntilChildExit(wxExecuteData& execData)
     wxSelectDispatcher dispatcher;
 
     // Do register all the FDs we want to monitor here: first, the one used to
-    // handle the signals asynchronously.
-    wxScopedPtr<wxFDIOHandler>
-        signalHandler(wxTheApp->RegisterSignalWakeUpPipe(dispatcher));
+    // detect the child termination, which is either its pidfd, if we have
+    // it, or the pipe used to handle the signals asynchronously.
+    wxScopedPtr<wxFDIOHandler> exitHandler;
+    if ( execData.GetPidFD() != -1 )
+        exitHandler.reset(new wxExecutePidFDIOHandler(dispatcher, execData));
+    else
+        exitHandler.reset(wxTheApp->RegisterSignalWakeUpPipe(dispatcher));
 
 #if wxUSE_STREAMS
     // And then the two for the child output and error streams if necessary.
     wxScopedPtr<wxFDIOHandler>
         stdoutHandler,
         stderrHandler;
-    if ( execData.IsRedirected() )
+    if ( execData.m_fdOut != wxPipe::INVALID_FD )
     {
         stdoutHandler.reset(new wxExecuteFDIOHandler
                                 (
@@ -535,6 +615,9 @@ int BlockUntilChildExit(wxExecuteData& execData)
                                     execData.m_fdOut,
                                     execData.m_bufOut
                                 ));
+    }
+    if ( execData.m_fdErr != wxPipe::INVALID_FD )
+    {
         stderrHandler.reset(new wxExecuteFDIOHandler
                                 (
                                     dispatcher,
@@ -542,6 +625,29 @@ int BlockUntilChildExit(wxExecuteData& execData)
                                     execData.m_bufErr
                                 ));
     }
+
+    // Or the sinks the output is sent to.
+    wxScopedPtr<wxFDIOHandler>
+        sinkOutHandler,
+        sinkErrHandler;
+    if ( execData.m_sinkOut.IsOk() )
+    {
+        sinkOutHandler.reset(new wxExecuteFDIOHandlerT<wxExecuteSinkBuffer>
+                                 (
+                                    dispatcher,
+                                    execData.m_sinkOut.GetFD(),
+                                    execData.m_sinkOut
+                                 ));
+    }
+    if ( execData.m_sinkErr.IsOk() )
+    {
+        sinkErrHandler.reset(new wxExecuteFDIOHandlerT<wxExecuteSinkBuffer>
+                                 (
+                                    dispatcher,
+                                    execData.m_sinkErr.GetFD(),
+                                    execData.m_sinkErr
+                                 ));
+    }
 #endif // wxUSE_STREAMS
 
     // And dispatch until the PID is reset from wxExecuteData::OnExit().
@@ -558,6 +664,155 @@ int BlockUntilChildExit(wxExecuteData& execData)
 #endif // wxUSE_SELECT_DISPATCHER/!wxUSE_SELECT_DISPATCHER
 }
 
+#if HAS_PIPE_STREAMS
+
+// Return the descriptor of the file used as the sink for the child output or
+// -1 if the sink is not a file.
+int GetSinkFileFD(wxOutputStream *sink)
+{
+#ifndef wxNO_RTTI
+    wxFileOutputStream * const
+        fileStream = dynamic_cast<wxFileOutputStream *>(sink);
+    if ( fileStream && fileStream->IsOk() )
+        return fileStream->GetFile()->fd();
+#else // wxNO_RTTI
+    wxUnusedVar(sink);
+#endif // !wxNO_RTTI/wxNO_RTTI
+
+    return -1;
+}
+
+// Set up the parent side of the pipe connected to the child stdout or stderr:
+// the output is either copied to the sink, if any, or made available via the
+// returned stream, which is also buffered in synchronous case.
+wxPipeInputStream *SetupChildOutput(wxPipe& pipe,
+                                    wxOutputStream *sink,
+                                    wxExecuteSinkBuffer& sinkBuf,
+                                    wxStreamTempInputBuffer& tempBuf,
+                                    int& fdSync,
+                                    int flags)
+{
+    // The pipe is not created if the child writes directly to the sink file.
+    if ( !pipe.IsOk() )
+        return NULL;
+
+    const int fd = pipe.Detach(wxPipe::Read);
+    if ( sink )
+    {
+        sinkBuf.Init(fd, sink);
+        return NULL;
+    }
+
+    wxPipeInputStream * const stream = new wxPipeInputStream(fd);
+    if ( flags & wxEXEC_SYNC )
+    {
+        tempBuf.Init(stream);
+        fdSync = fd;
+    }
+
+    return stream;
+}
+
+#endif // HAS_PIPE_STREAMS
+
+#ifdef wxHAS_POSIX_SPAWN
+
+// Launch the child process using posix_spawnp(), which doesn't copy the page
+// tables of this process as fork() does and so is much faster when this
+// process uses a lot of memory.
+//
+// Returns false if posix_spawnp() can't be used because the child process
+// needs some customization not supported by it, in which case fork() must be
+// used instead. Otherwise fills in either the PID of the new process or the
+// error code.
+bool SpawnChild(const char* const* argv,
+                int flags,
+                int prio,
+                const wxExecuteEnv *env,
+                const int childFDs[3],
+                pid_t& pid,
+                int& err)
+{
+    if ( prio )
+        return false;
+
+    short spawnFlags = 0;
+    if ( flags & wxEXEC_MAKE_GROUP_LEADER )
+    {
+#ifdef POSIX_SPAWN_SETSID
+        spawnFlags |= POSIX_SPAWN_SETSID;
+#else
+        return false;
+#endif
+    }
+
+#ifndef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP
+    if ( env && !env->cwd.empty() )
+        return false;
+#endif
+
+    // Build the child environment if it's different from ours.
+    wxVector<wxCharBuffer> envStrings;
+    wxVector<char *> envp;
+    if ( env && !env->env.empty() )
+    {
+        // posix_spawnp() looks up the program in our PATH and not in the
+        // one from the child environment, as execvp() called after changing
+        // the environment does, so we can't use it if they're different.
+        wxString path;
+        const bool hasPath = wxGetEnv("PATH", &path);
+        const wxEnvVariableHashMap::const_iterator
+            itPath = env->env.find("PATH");
+        if ( itPath == env->env.end() ? hasPath
+                                      : !hasPath || itPath->second != path )
+            return false;
+
+        for ( wxEnvVariableHashMap::const_iterator it = env->env.begin();
+              it != env->env.end();
+              ++it )
+        {
+            envStrings.push_back((it->first + '=' + it->second).mb_str());
+        }
+
+        for ( size_t n = 0; n < envStrings.size(); n++ )
+            envp.push_back(envStrings[n].data());
+        envp.push_back(NULL);
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+
+    if ( childFDs[0] != -1 )
+    {
+        posix_spawn_file_actions_adddup2(&actions, childFDs[0], STDIN_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, childFDs[1], STDOUT_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, childFDs[2], STDERR_FILENO);
+    }
+
+    // Close all the other descriptors, as we do after fork().
+    posix_spawn_file_actions_addclosefrom_np(&actions, STDERR_FILENO + 1);
+
+#ifdef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP
+    if ( env && !env->cwd.empty() )
+        posix_spawn_file_actions_addchdir_np(&actions, env->cwd.fn_str());
+#endif
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, spawnFlags);
+
+    err = posix_spawnp(&pid, *argv, &actions, &attr,
+                       const_cast<char**>(argv),
+                       envp.empty() ? environ : &envp[0]);
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+
+    return true;
+}
+
+#endif // wxHAS_POSIX_SPAWN
+
 } // anonymous namespace
 
 // wxExecute: the real worker function
@@ -606,14 +861,32 @@ long wxExecute(const char* const* argv, int flags, wxProcess* process,
            pipeOut,     // stdout
            pipeErr;     // stderr
 
+    // the descriptors to use as stdin, stdout and stderr in the child
+    int childFDs[3] = { -1, -1, -1 };
+
     if ( process && process->IsRedirected() )
     {
-        if ( !pipeIn.Create() || !pipeOut.Create() || !pipeErr.Create() )
+        // If the output is sent to a file anyhow, let the child write to it
+        // directly instead of copying all the data through a pipe.
+        int fdOutFile = -1,
+            fdErrFile = -1;
+#if HAS_PIPE_STREAMS
+        fdOutFile = GetSinkFileFD(process->GetOutputSink());
+        fdErrFile = GetSinkFileFD(process->GetErrorSink());
+#endif // HAS_PIPE_STREAMS
+
+        if ( !pipeIn.Create() ||
+                (fdOutFile == -1 && !pipeOut.Create()) ||
+                    (fdErrFile == -1 && !pipeErr.Create()) )
         {
             wxLogError( _("Failed to execute '%s'\n"), *argv );
 
             return ERROR_RETURN_CODE;
         }
+
+        childFDs[0] = pipeIn[wxPipe::Read];
+        childFDs[1] = fdOutFile != -1 ? fdOutFile : pipeOut[wxPipe::Write];
+        childFDs[2] = fdErrFile != -1 ? fdErrFile : pipeErr[wxPipe::Write];
     }
 
     // priority: we need to map wxWidgets priority which is in the range 0..100
@@ -631,231 +904,239 @@ long wxExecute(const char* const* argv, int flags, wxProcess* process,
     else
         prio = (2*prio)/5 - 21;
 
-    // fork the process
-    //
-    // NB: do *not* use vfork() here, it completely breaks this code for some
-    //     reason under Solaris (and maybe others, although not under Linux)
-    //     But on OpenVMS we do not have fork so we have to use vfork and
-    //     cross our fingers that it works.
-#ifdef __VMS
-   pid = vfork();
-#else
-   pid = fork();
-#endif
-   if ( pid == -1 )     // error?
+    pid = -1;
+
+#ifdef wxHAS_POSIX_SPAWN
+    // Prefer using posix_spawn() if possible: as it uses vfork() or
+    // equivalent, it is much faster than fork() for big processes.
+    int spawnErr;
+    if ( SpawnChild(argv, flags, prio, env, childFDs, pid, spawnErr) )
     {
-        wxLogSysError( _("Fork failed") );
+        if ( spawnErr )
+        {
+            wxLogSysError(spawnErr, _("Failed to execute '%s'\n"), *argv);
 
-        return ERROR_RETURN_CODE;
+            return ERROR_RETURN_CODE;
+        }
     }
-    else if ( pid == 0 )  // we're in child
+    else
+#endif // wxHAS_POSIX_SPAWN
     {
-        // NB: we used to close all the unused descriptors of the child here
-        //     but this broke some programs which relied on e.g. FD 1 being
-        //     always opened so don't do it any more, after all there doesn't
-        //     seem to be any real problem with keeping them opened
-
-#if !defined(__VMS)
-        if ( flags & wxEXEC_MAKE_GROUP_LEADER )
+        // fork the process
+        //
+        // NB: do *not* use vfork() here, it completely breaks this code for some
+        //     reason under Solaris (and maybe others, although not under Linux)
+        //     But on OpenVMS we do not have fork so we have to use vfork and
+        //     cross our fingers that it works.
+#ifdef __VMS
+        pid = vfork();
+#else
+        pid = fork();
+#endif
+        if ( pid == -1 )     // error?
         {
-            // Set process group to child process' pid.  Then killing -pid
-            // of the parent will kill the process and all of its children.
-            setsid();
+            wxLogSysError( _("Fork failed") );
+
+            return ERROR_RETURN_CODE;
         }
+        else if ( pid == 0 )  // we're in child
+        {
+            // NB: we used to close all the unused descriptors of the child here
+            //     but this broke some programs which relied on e.g. FD 1 being
+            //     always opened so don't do it any more, after all there doesn't
+            //     seem to be any real problem with keeping them opened
+
+#if !defined(__VMS)
+            if ( flags & wxEXEC_MAKE_GROUP_LEADER )
+            {
+                // Set process group to child process' pid.  Then killing -pid
+                // of the parent will kill the process and all of its children.
+                setsid();
+            }
 #endif // !__VMS
 
 #if defined(HAVE_SETPRIORITY)
-        if ( prio && setpriority(PRIO_PROCESS, 0, prio) != 0 )
-        {
-            wxLogSysError(_("Failed to set process priority"));
-        }
+            if ( prio && setpriority(PRIO_PROCESS, 0, prio) != 0 )
+            {
+                wxLogSysError(_("Failed to set process priority"));
+            }
 #endif // HAVE_SETPRIORITY
 
-        // redirect stdin, stdout and stderr
-        if ( pipeIn.IsOk() )
-        {
-            if ( dup2(pipeIn[wxPipe::Read], STDIN_FILENO) == -1 ||
-                 dup2(pipeOut[wxPipe::Write], STDOUT_FILENO) == -1 ||
-                 dup2(pipeErr[wxPipe::Write], STDERR_FILENO) == -1 )
+            // redirect stdin, stdout and stderr
+            if ( pipeIn.IsOk() )
             {
-                wxLogSysError(_("Failed to redirect child process input/output"));
-            }
+                if ( dup2(childFDs[0], STDIN_FILENO) == -1 ||
+                     dup2(childFDs[1], STDOUT_FILENO) == -1 ||
+                     dup2(childFDs[2], STDERR_FILENO) == -1 )
+                {
+                    wxLogSysError(_("Failed to redirect child process input/output"));
+                }
 
-            pipeIn.Close();
-            pipeOut.Close();
-            pipeErr.Close();
-        }
+                pipeIn.Close();
+                pipeOut.Close();
+                pipeErr.Close();
+            }
 
-        // Close all (presumably accidentally) inherited file descriptors to
-        // avoid descriptor leaks. This means that we don't allow inheriting
-        // them purposefully but this seems like a lesser evil in wx code.
-        // Ideally we'd provide some flag to indicate that none (or some?) of
-        // the descriptors do not need to be closed but for now this is better
-        // than never closing them at all as wx code never used FD_CLOEXEC.
-
-        // TODO: Iterating up to FD_SETSIZE is both inefficient (because it may
-        //       be quite big) and incorrect (because in principle we could
-        //       have more opened descriptions than this number). Unfortunately
-        //       there is no good portable solution for closing all descriptors
-        //       above a certain threshold but non-portable solutions exist for
-        //       most platforms, see [https://stackoverflow.com/questions/899038/
-        //          getting-the-highest-allocated-file-descriptor]
-        for ( int fd = 0; fd < (int)FD_SETSIZE; ++fd )
-        {
-            if ( fd != STDIN_FILENO  &&
-                 fd != STDOUT_FILENO &&
-                 fd != STDERR_FILENO )
+            // Close all (presumably accidentally) inherited file descriptors to
+            // avoid descriptor leaks. This means that we don't allow inheriting
+            // them purposefully but this seems like a lesser evil in wx code.
+            // Ideally we'd provide some flag to indicate that none (or some?) of
+            // the descriptors do not need to be closed but for now this is better
+            // than never closing them at all as wx code never used FD_CLOEXEC.
+
+            // TODO: Iterating up to FD_SETSIZE is both inefficient (because it may
+            //       be quite big) and incorrect (because in principle we could
+            //       have more opened descriptions than this number). Unfortunately
+            //       there is no good portable solution for closing all descriptors
+            //       above a certain threshold but non-portable solutions exist for
+            //       most platforms, see [https://stackoverflow.com/questions/899038/
+            //          getting-the-highest-allocated-file-descriptor]
+            for ( int fd = 0; fd < (int)FD_SETSIZE; ++fd )
             {
-                close(fd);
+                if ( fd != STDIN_FILENO  &&
+                     fd != STDOUT_FILENO &&
+                     fd != STDERR_FILENO )
+                {
+                    close(fd);
+                }
             }
-        }
-
 
-        // Process additional options if we have any
-        if ( env )
-        {
-            // Change working directory if it is specified
-            if ( !env->cwd.empty() )
-                wxSetWorkingDirectory(env->cwd);
 
-            // Change environment if needed.
-            //
-            // NB: We can't use execve() currently because we allow using
-            //     non full paths to wxExecute(), i.e. we want to search for
-            //     the program in PATH. However it just might be simpler/better
-            //     to do the search manually and use execve() envp parameter to
-            //     set up the environment of the child process explicitly
-            //     instead of doing what we do below.
-            if ( !env->env.empty() )
+            // Process additional options if we have any
+            if ( env )
             {
-                wxEnvVariableHashMap oldenv;
-                wxGetEnvMap(&oldenv);
-
-                // Remove unwanted variables
-                wxEnvVariableHashMap::const_iterator it;
-                for ( it = oldenv.begin(); it != oldenv.end(); ++it )
+                // Change working directory if it is specified
+                if ( !env->cwd.empty() )
+                    wxSetWorkingDirectory(env->cwd);
+
+                // Change environment if needed.
+                //
+                // NB: We can't use execve() currently because we allow using
+                //     non full paths to wxExecute(), i.e. we want to search for
+                //     the program in PATH. However it just might be simpler/better
+                //     to do the search manually and use execve() envp parameter to
+                //     set up the environment of the child process explicitly
+                //     instead of doing what we do below.
+                if ( !env->env.empty() )
                 {
-                    if ( env->env.find(it->first) == env->env.end() )
-                        wxUnsetEnv(it->first);
-                }
+                    wxEnvVariableHashMap oldenv;
+                    wxGetEnvMap(&oldenv);
+
+                    // Remove unwanted variables
+                    wxEnvVariableHashMap::const_iterator it;
+                    for ( it = oldenv.begin(); it != oldenv.end(); ++it )
+                    {
+                        if ( env->env.find(it->first) == env->env.end() )
+                            wxUnsetEnv(it->first);
+                    }
 
-                // And add the new ones (possibly replacing the old values)
-                for ( it = env->env.begin(); it != env->env.end(); ++it )
-                    wxSetEnv(it->first, it->second);
+                    // And add the new ones (possibly replacing the old values)
+                    for ( it = env->env.begin(); it != env->env.end(); ++it )
+                        wxSetEnv(it->first, it->second);
+                }
             }
-        }
 
-        execvp(*argv, const_cast<char**>(argv));
+            execvp(*argv, const_cast<char**>(argv));
 
-        fprintf(stderr, "execvp(");
-        for (const char* const* a = argv; *a; a++)
-            fprintf(stderr, "%s%s", a == argv ? "" : ", ", *a);
-        fprintf(stderr, ") failed with error %d!\n", errno);
+            fprintf(stderr, "execvp(");
+            for (const char* const* a = argv; *a; a++)
+                fprintf(stderr, "%s%s", a == argv ? "" : ", ", *a);
+            fprintf(stderr, ") failed with error %d!\n", errno);
 
-        // there is no return after successful exec()
-        _exit(-1);
+            // there is no return after successful exec()
+            _exit(-1);
 
-        // some compilers complain about missing return - of course, they
-        // should know that exit() doesn't return but what else can we do if
-        // they don't?
-        //
-        // and, sure enough, other compilers complain about unreachable code
-        // after exit() call, so we can just always have return here...
+            // some compilers complain about missing return - of course, they
+            // should know that exit() doesn't return but what else can we do if
+            // they don't?
+            //
+            // and, sure enough, other compilers complain about unreachable code
+            // after exit() call, so we can just always have return here...
 #if defined(__VMS) || defined(__INTEL_COMPILER)
-        return 0;
+            return 0;
 #endif
+        }
     }
-    else // we're in parent
-    {
-        // prepare for IO redirection
+
+    // we're in parent: prepare for IO redirection
 
 #if HAS_PIPE_STREAMS
 
-        if ( process && process->IsRedirected() )
+    if ( process && process->IsRedirected() )
+    {
+        // Avoid deadlocks which could result from trying to write to the
+        // child input pipe end while the child itself is writing to its
+        // output end and waiting for us to read from it.
+        if ( !pipeIn.MakeNonBlocking(wxPipe::Write) )
         {
-            // Avoid deadlocks which could result from trying to write to the
-            // child input pipe end while the child itself is writing to its
-            // output end and waiting for us to read from it.
-            if ( !pipeIn.MakeNonBlocking(wxPipe::Write) )
-            {
-                // This message is not terrible useful for the user but what
-                // else can we do? Also, should we fail here or take the risk
-                // to continue and deadlock? Currently we choose the latter but
-                // it might not be the best idea.
-                wxLogSysError(_("Failed to set up non-blocking pipe, "
-                                "the program might hang."));
+            // This message is not terrible useful for the user but what
+            // else can we do? Also, should we fail here or take the risk
+            // to continue and deadlock? Currently we choose the latter but
+            // it might not be the best idea.
+            wxLogSysError(_("Failed to set up non-blocking pipe, "
+                            "the program might hang."));
 #if wxUSE_LOG
-                wxLog::FlushActive();
+            wxLog::FlushActive();
 #endif
-            }
-
-            wxOutputStream *inStream =
-                new wxPipeOutputStream(pipeIn.Detach(wxPipe::Write));
-
-            const int fdOut = pipeOut.Detach(wxPipe::Read);
-            wxPipeInputStream *outStream = new wxPipeInputStream(fdOut);
+        }
 
-            const int fdErr = pipeErr.Detach(wxPipe::Read);
-            wxPipeInputStream *errStream = new wxPipeInputStream(fdErr);
+        wxOutputStream *inStream =
+            new wxPipeOutputStream(pipeIn.Detach(wxPipe::Write));
 
-            process->SetPipeStreams(outStream, inStream, errStream);
+        wxPipeInputStream * const outStream =
+            SetupChildOutput(pipeOut, process->GetOutputSink(),
+                             execData.m_sinkOut, execData.m_bufOut,
+                             execData.m_fdOut, flags);
 
-            if ( flags & wxEXEC_SYNC )
-            {
-                execData.m_bufOut.Init(outStream);
-                execData.m_bufErr.Init(errStream);
+        wxPipeInputStream * const errStream =
+            SetupChildOutput(pipeErr, process->GetErrorSink(),
+                             execData.m_sinkErr, execData.m_bufErr,
+                             execData.m_fdErr, flags);
 
-                execData.m_fdOut = fdOut;
-                execData.m_fdErr = fdErr;
-            }
-        }
+        process->SetPipeStreams(outStream, inStream, errStream);
+    }
 #endif // HAS_PIPE_STREAMS
 
-        if ( pipeIn.IsOk() )
-        {
-            pipeIn.Close();
-            pipeOut.Close();
-            pipeErr.Close();
-        }
-
-        if ( !(flags & wxEXEC_SYNC) )
-        {
-            // Ensure that the housekeeping data is kept alive, it will be
-            // destroyed only when the child terminates.
-            execDataPtr.release();
-        }
-
-        // Put the housekeeping data into the child process lookup table.
-        // Note that when running asynchronously, if the child has already
-        // finished this call will delete the execData and call any
-        // wxProcess's OnTerminate() handler immediately.
-        execData.OnStart(pid);
+    if ( pipeIn.IsOk() )
+    {
+        pipeIn.Close();
+        pipeOut.Close();
+        pipeErr.Close();
+    }
 
-        // For the asynchronous case we don't have to do anything else, just
-        // let the process run (if not already finished).
-        if ( !(flags & wxEXEC_SYNC) )
-            return pid;
+    if ( !(flags & wxEXEC_SYNC) )
+    {
+        // Ensure that the housekeeping data is kept alive, it will be
+        // destroyed only when the child terminates.
+        execDataPtr.release();
+    }
 
+    // Put the housekeeping data into the child process lookup table.
+    // Note that when running asynchronously, if the child has already
+    // finished this call will delete the execData and call any
+    // wxProcess's OnTerminate() handler immediately.
+    execData.OnStart(pid);
 
-        // If we don't need to dispatch any events, things are relatively
-        // simple and we don't need to delegate to wxAppTraits.
-        if ( flags & wxEXEC_NOEVENTS )
-        {
-            return BlockUntilChildExit(execData);
-        }
+    // For the asynchronous case we don't have to do anything else, just
+    // let the process run (if not already finished).
+    if ( !(flags & wxEXEC_SYNC) )
+        return pid;
 
 
-        // If we do need to dispatch events, enter a local event loop waiting
-        // until the child exits. As the exact kind of event loop depends on
-        // the sort of application we're in (console or GUI), we delegate this
-        // to wxAppTraits which virtualizes all the differences between the
-        // console and the GUI programs.
-        return wxApp::GetValidTraits().WaitForChild(execData);
+    // If we don't need to dispatch any events, things are relatively
+    // simple and we don't need to delegate to wxAppTraits.
+    if ( flags & wxEXEC_NOEVENTS )
+    {
+        return BlockUntilChildExit(execData);
     }
 
-#if !defined(__VMS) && !defined(__INTEL_COMPILER)
-    return ERROR_RETURN_CODE;
-#endif
+
+    // If we do need to dispatch events, enter a local event loop waiting
+    // until the child exits. As the exact kind of event loop depends on
+    // the sort of application we're in (console or GUI), we delegate this
+    // to wxAppTraits which virtualizes all the differences between the
+    // console and the GUI programs.
+    return wxApp::GetValidTraits().WaitForChild(execData);
 }
 
 #undef ERROR_RETURN_CODE
@@ -1513,12 +1794,18 @@ wxAppTraits::RunLoopUntilChildExit(wxExecuteData& execData,
     wxScopedPtr<wxEventLoopSourceHandler>
         stdoutHandler,
         stderrHandler;
-    if ( execData.IsRedirected() )
+    //
+    // Notice that the output sent to wxProcess sinks doesn't need to be
+    // handled here, this is already done by wxExecuteData itself.
+    if ( execData.m_fdOut != wxPipe::INVALID_FD )
     {
         stdoutHandler.reset(new wxExecuteEventLoopSourceHandler
                                 (
                                     execData.m_fdOut, execData.m_bufOut
                                 ));
+    }
+    if ( execData.m_fdErr != wxPipe::INVALID_FD )
+    {
         stderrHandler.reset(new wxExecuteEventLoopSourceHandler
                                 (
                                     execData.m_fdErr, execData.m_bufErr
@@ -1537,6 +1824,72 @@ wxAppTraits::RunLoopUntilChildExit(wxExecuteData& execData,
     return execData.m_exitcode;
 }
 
+#if wxUSE_STREAMS
+
+// ----------------------------------------------------------------------------
+// wxExecuteSinkBuffer
+// ----------------------------------------------------------------------------
+
+wxExecuteSinkBuffer::~wxExecuteSinkBuffer()
+{
+    if ( IsOk() )
+        close(m_fd);
+}
+
+void wxExecuteSinkBuffer::Init(int fd, wxOutputStream *sink)
+{
+    wxASSERT_MSG( !IsOk(), "shouldn't be initialized more than once" );
+
+    m_fd = fd;
+    m_sink = sink;
+
+    // We must never block when reading from the pipe as we're called whenever
+    // it becomes readable and we don't know how much data it has.
+    const int flags = fcntl(m_fd, F_GETFL, 0);
+    if ( flags == -1 || fcntl(m_fd, F_SETFL, flags | O_NONBLOCK) == -1 )
+    {
+        wxLogSysError(_("Failed to set up non-blocking pipe, "
+                        "the program might hang."));
+    }
+}
+
+void wxExecuteSinkBuffer::Update()
+{
+    if ( Eof() )
+        return;
+
+    char buf[16384];
+    for ( ;; )
+    {
+        const ssize_t rc = read(m_fd, buf, sizeof(buf));
+        if ( rc > 0 )
+        {
+            // Notice that we keep reading even if writing to the sink failed
+            // as otherwise the child process could block on a full pipe, the
+            // data is just lost in this case.
+            if ( m_sink->IsOk() )
+                m_sink->WriteAll(buf, rc);
+            continue;
+        }
+
+        if ( rc == -1 )
+        {
+            if ( errno == EINTR )
+                continue;
+
+            if ( errno == EAGAIN || errno == EWOULDBLOCK )
+                break;
+        }
+
+        // Either EOF or an unexpected error, in both cases there is nothing
+        // more to read.
+        m_eof = true;
+        break;
+    }
+}
+
+#endif // wxUSE_STREAMS
+
 // ----------------------------------------------------------------------------
 // wxExecuteData
 // ----------------------------------------------------------------------------
@@ -1633,19 +1986,71 @@ void wxExecuteData::OnSomeChildExited(int WXUNUSED(sig))
     }
 }
 
+wxExecuteData::~wxExecuteData()
+{
+    RemoveEventLoopSources();
+
+    if ( m_pidfd != -1 )
+        close(m_pidfd);
+}
+
+void wxExecuteData::AddEventLoopSources()
+{
+#if wxUSE_EVENTLOOP_SOURCE
+    if ( m_pidfd != -1 )
+    {
+        m_pidfdHandler = new wxExecutePidFDEventLoopSourceHandler(*this);
+        m_pidfdSource = wxEventLoop::AddSourceForFD(m_pidfd,
+                                                    m_pidfdHandler,
+                                                    wxEVENT_SOURCE_INPUT);
+        if ( !m_pidfdSource )
+        {
+            // We will have to rely on SIGCHLD instead.
+            wxDELETE(m_pidfdHandler);
+
+            close(m_pidfd);
+            m_pidfd = -1;
+        }
+    }
+
+#if wxUSE_STREAMS
+    if ( m_sinkOut.IsOk() )
+    {
+        m_sinkOutHandler =
+            new wxExecuteEventLoopSourceHandlerT<wxExecuteSinkBuffer>
+                (
+                    m_sinkOut.GetFD(), m_sinkOut
+                );
+    }
+
+    if ( m_sinkErr.IsOk() )
+    {
+        m_sinkErrHandler =
+            new wxExecuteEventLoopSourceHandlerT<wxExecuteSinkBuffer>
+                (
+                    m_sinkErr.GetFD(), m_sinkErr
+                );
+    }
+#endif // wxUSE_STREAMS
+#endif // wxUSE_EVENTLOOP_SOURCE
+}
+
+void wxExecuteData::RemoveEventLoopSources()
+{
+    wxDELETE(m_pidfdSource);
+    wxDELETE(m_pidfdHandler);
+
+#if wxUSE_STREAMS
+    wxDELETE(m_sinkOutHandler);
+    wxDELETE(m_sinkErrHandler);
+#endif // wxUSE_STREAMS
+}
+
 void wxExecuteData::OnStart(int pid)
 {
     wxCHECK_RET( wxTheApp,
                  wxS("Ensure wxTheApp is set before calling wxExecute()") );
 
-    // Setup the signal handler for SIGCHLD to be able to detect the child
-    // termination.
-    //
-    // Notice that SetSignalHandler() is idempotent, so it's fine to call
-    // it more than once with the same handler.
-    wxTheApp->SetSignalHandler(SIGCHLD, OnSomeChildExited);
-
-
     // Remember the child PID to be able to wait for it later.
     m_pid = pid;
 
@@ -1657,6 +2062,25 @@ void wxExecuteData::OnStart(int pid)
     // we can check for its termination the next time we get SIGCHLD.
     ms_childProcesses[m_pid] = this;
 
+#ifdef wxHAS_PIDFD
+    // Under Linux we can get notified about this particular child exit
+    // directly instead of handling SIGCHLD and checking all the children.
+    m_pidfd = syscall(SYS_pidfd_open, m_pid, 0);
+#endif // wxHAS_PIDFD
+
+    // In wxEXEC_NOEVENTS case, BlockUntilChildExit() monitors all the
+    // descriptors itself.
+    if ( !(m_flags & wxEXEC_SYNC) || !(m_flags & wxEXEC_NOEVENTS) )
+        AddEventLoopSources();
+
+    // Setup the signal handler for SIGCHLD to be able to detect the child
+    // termination if we can't use the pidfd.
+    //
+    // Notice that SetSignalHandler() is idempotent, so it's fine to call
+    // it more than once with the same handler.
+    if ( m_pidfd == -1 )
+        wxTheApp->SetSignalHandler(SIGCHLD, OnSomeChildExited);
+
     // However, if the child exited before we finished setting up above,
     // we may have already missed its SIGCHLD.  So we also do an explicit
     // check here before returning.
@@ -1670,6 +2094,15 @@ void wxExecuteData::OnStart(int pid)
     }
 }
 
+void wxExecuteData::OnPidFDReady()
+{
+    // Check that the child has really exited and wasn't already handled by
+    // the SIGCHLD handler.
+    int exitcode;
+    if ( m_pid && CheckForChildExit(m_pid, &exitcode) )
+        OnExit(exitcode);
+}
+
 void wxExecuteData::OnExit(int exitcode)
 {
     // Remove this process from the hash list of child processes that are
@@ -1691,9 +2124,17 @@ void wxExecuteData::OnExit(int exitcode)
         // available in the streams buffers.
         m_bufOut.ReadAll();
         m_bufErr.ReadAll();
+
+        // Also pass all the remaining output to the sinks before notifying
+        // the user code about the process termination.
+        m_sinkOut.Update();
+        m_sinkErr.Update();
     }
 #endif // wxUSE_STREAMS
 
+    // We don't need to monitor the child any longer.
+    RemoveEventLoopSources();
+
     // Notify user about termination if required
     if ( !(m_flags & wxEXEC_SYNC) )
     {
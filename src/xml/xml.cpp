@@ -30,6 +30,8 @@
 
 #include "expat.h" // from Expat
 
+#include <limits.h>
+
 // DLL options compatibility check:
 WX_CHECK_BUILD_OPTIONS("wxXML")
 
@@ -517,7 +519,7 @@ void wxXmlDocument::DoCopy(const wxXmlDocument& doc)
 
 bool wxXmlDocument::Load(const wxString& filename, const wxString& encoding, int flags)
 {
-    wxFileInputStream stream(filename);
+    wxMappedFileInputStream stream(filename, wxMAPPED_FILE_ACCESS_SEQUENTIAL);
     if (!stream.IsOk())
         return false;
     return Load(stream, encoding, flags);
@@ -913,12 +915,42 @@ bool wxXmlDocument::Load(wxInputStream& stream, const wxString& encoding, int fl
     XML_SetDefaultHandler(parser, DefaultHnd);
     XML_SetUnknownEncodingHandler(parser, UnknownEncodingHnd, NULL);
 
+    // If the entire file is mapped into memory, let expat parse it directly
+    // instead of copying it into our buffer chunk by chunk.
+    const char* data = NULL;
+    size_t dataLen = 0;
+    wxMappedFileInputStream* const
+        mapped = wxDynamicCast(&stream, wxMappedFileInputStream);
+    if ( mapped && mapped->IsMapped() )
+    {
+        const wxFileOffset pos = mapped->TellI();
+        if ( pos != wxInvalidOffset &&
+                mapped->GetLength() - pos <= INT_MAX )
+        {
+            data = static_cast<const char*>(mapped->GetData()) + pos;
+            dataLen = mapped->GetDataLength() - static_cast<size_t>(pos);
+        }
+    }
+
     bool ok = true;
     do
     {
-        size_t len = stream.Read(buf, BUFSIZE).LastRead();
-        done = (len < BUFSIZE);
-        if (!XML_Parse(parser, buf, len, done))
+        const char* chunk;
+        size_t len;
+        if ( data )
+        {
+            chunk = data;
+            len = dataLen;
+            done = true;
+        }
+        else
+        {
+            chunk = buf;
+            len = stream.Read(buf, BUFSIZE).LastRead();
+            done = (len < BUFSIZE);
+        }
+
+        if (!XML_Parse(parser, chunk, len, done))
         {
             wxString error(XML_ErrorString(XML_GetErrorCode(parser)),
                            *wxConvCurrent);
@@ -930,6 +962,11 @@ bool wxXmlDocument::Load(wxInputStream& stream, const wxString& encoding, int fl
         }
     } while (!done);
 
+    // Leave the stream positioned after the parsed data, as it would have
+    // been if we had read it.
+    if ( data )
+        stream.SeekI(0, wxFromEnd);
+
     if (ok)
     {
         if (!ctx.version.empty())
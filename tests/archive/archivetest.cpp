@@ -1413,13 +1413,62 @@ string ArchiveTestSuite::Description(const wxString& type,
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Helpers for testing the random access to the entries of an archive
+
+#if wxUSE_ZIPSTREAM
+#include "wx/zipstrm.h"
+#endif
+
+wxString GetIndexTestData(int n)
+{
+    return wxString::Format("Entry %d ", n).Pad(n*10, 'x');
+}
+
+void CreateIndexTestArchive(const wxArchiveClassFactory& factory,
+                            wxOutputStream& out,
+                            int count)
+{
+    wxScopedPtr<wxArchiveOutputStream> arc(factory.NewStream(out));
+    REQUIRE( arc );
+
+#if wxUSE_ZIPSTREAM
+    // the streams have no RTTI of their own, but the factories do
+    wxZipOutputStream * const zip = wxDynamicCast(&factory, wxZipClassFactory)
+        ? static_cast<wxZipOutputStream*>(arc.get()) : NULL;
+#endif
+
+    for ( int n = 0; n < count; n++ )
+    {
+#if wxUSE_ZIPSTREAM
+        if ( zip )
+            zip->SetLevel(n % 10 ? -1 : 0);
+#endif
+
+        const wxCharBuffer data(GetIndexTestData(n).utf8_str());
+        REQUIRE( arc->PutNextEntry(wxString::Format("dir/entry%d.txt", n),
+                                   wxDateTime::Now(), data.length()) );
+        REQUIRE( arc->WriteAll(data, data.length()) );
+    }
+    REQUIRE( arc->Close() );
+}
+
+wxString ReadAllFrom(wxInputStream& in)
+{
+    wxString s;
+    char buf[256];
+    while ( in.Read(buf, sizeof(buf)).LastRead() )
+        s += wxString::FromUTF8(buf, in.LastRead());
+    return s;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Instantiations
 
 template class ArchiveTestCase<wxArchiveClassFactory>;
 
 #if wxUSE_ZIPSTREAM
-#include "wx/zipstrm.h"
 template class ArchiveTestCase<wxZipClassFactory>;
 #endif
 
@@ -245,6 +245,23 @@ private:
 };
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Helpers for testing the random access to the entries of an archive
+
+// Returns the contents of the n-th entry of the archive created below.
+wxString GetIndexTestData(int n);
+
+// Writes an archive of the type created by the given factory with the given
+// number of entries named "dir/entryN.txt". For zips every 10th entry is
+// stored and the others are deflated.
+void CreateIndexTestArchive(const wxArchiveClassFactory& factory,
+                            wxOutputStream& out,
+                            int count);
+
+// Reads the stream up to its end and returns what was read as UTF-8 text.
+wxString ReadAllFrom(wxInputStream& in);
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Base class for the archive test suites
 
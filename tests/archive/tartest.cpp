@@ -69,4 +69,154 @@ CppUnit::Test *tartest::makeTest(
 CPPUNIT_TEST_SUITE_REGISTRATION(tartest);
 CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(tartest, "archive/tar");
 
+
+///////////////////////////////////////////////////////////////////////////////
+// Random access to the entries using the index
+
+#include "wx/mstream.h"
+#include "wx/scopedptr.h"
+
+#if wxUSE_LIBLZMA
+#include "wx/lzmastream.h"
+#include <lzma.h>
+#endif
+
+TEST_CASE("wxTarInputStream::LoadIndex", "[archive][tar]")
+{
+    const int count = 100;
+    wxMemoryOutputStream mo;
+    CreateIndexTestArchive(wxTarClassFactory(), mo, count);
+
+    wxMemoryInputStream mi(mo);
+    wxTarInputStream tar(mi);
+
+    CHECK( !tar.HasIndex() );
+    CHECK( !tar.FindEntry("dir/entry1.txt") );
+
+    // Reading some entries before loading the index doesn't matter.
+    wxScopedPtr<wxTarEntry> first(tar.GetNextEntry());
+    REQUIRE( first );
+
+    REQUIRE( tar.LoadIndex() );
+    CHECK( tar.HasIndex() );
+    CHECK( tar.GetIndexedCount() == size_t(count) );
+    CHECK( tar.GetIndexedEntry(count - 1)->GetInternalName() == "dir/entry99.txt" );
+    CHECK( !tar.GetIndexedEntry(count) );
+    CHECK( !tar.FindEntry("dir/entry100.txt") );
+
+    const wxTarEntry* const entry20 = tar.FindEntry("dir/entry20.txt", wxPATH_UNIX);
+    REQUIRE( entry20 );
+    CHECK( entry20->GetSize() == wxFileOffset(GetIndexTestData(20).length()) );
+
+    SECTION("OpenEntry")
+    {
+        CHECK( !tar.OpenEntry("nonexistent") );
+
+        REQUIRE( tar.OpenEntry("dir/entry77.txt", wxPATH_UNIX) );
+        CHECK( ReadAllFrom(tar) == GetIndexTestData(77) );
+        CHECK( tar.Eof() );
+
+        REQUIRE( tar.OpenEntry("dir/entry3.txt", wxPATH_UNIX) );
+        CHECK( ReadAllFrom(tar) == GetIndexTestData(3) );
+    }
+
+    SECTION("SaveIndex")
+    {
+        wxMemoryOutputStream idxOut;
+        REQUIRE( tar.SaveIndex(idxOut) );
+
+        wxMemoryInputStream mi2(mo);
+        wxTarInputStream tar2(mi2);
+
+        wxMemoryInputStream idxIn(idxOut);
+        REQUIRE( tar2.LoadIndex(idxIn) );
+        CHECK( tar2.GetIndexedCount() == size_t(count) );
+
+        const wxTarEntry* const entry = tar2.FindEntry("dir/entry20.txt", wxPATH_UNIX);
+        REQUIRE( entry );
+        CHECK( entry->GetOffset() == entry20->GetOffset() );
+        CHECK( entry->GetDateTime() == entry20->GetDateTime() );
+        CHECK( entry->GetMode() == entry20->GetMode() );
+
+        REQUIRE( tar2.OpenEntry("dir/entry42.txt", wxPATH_UNIX) );
+        CHECK( ReadAllFrom(tar2) == GetIndexTestData(42) );
+
+        // An index for a different archive is rejected.
+        wxMemoryOutputStream other;
+        CreateIndexTestArchive(wxTarClassFactory(), other, 3);
+        wxMemoryInputStream mi3(other);
+        wxTarInputStream tar3(mi3);
+        wxMemoryInputStream idxIn2(idxOut);
+        CHECK( !tar3.LoadIndex(idxIn2) );
+
+        // And so is garbage.
+        const char junk[] = "not an index";
+        wxMemoryInputStream idxJunk(junk, sizeof(junk));
+        CHECK( !tar3.LoadIndex(idxJunk) );
+        CHECK( !tar3.HasIndex() );
+    }
+}
+
+TEST_CASE("wxTarInputStream::LoadIndex::Offset", "[archive][tar]")
+{
+    // The archive doesn't have to be at the start of the parent stream.
+    wxMemoryOutputStream mo;
+    mo.Write("prefix", 6);
+    CreateIndexTestArchive(wxTarClassFactory(), mo, 10);
+
+    wxMemoryInputStream mi(mo);
+    char prefix[6];
+    REQUIRE( mi.Read(prefix, sizeof(prefix)).LastRead() == sizeof(prefix) );
+
+    wxTarInputStream tar(mi);
+
+    // Read an entry first to check that LoadIndex() rewinds to the start of
+    // the archive and not of the parent stream.
+    wxScopedPtr<wxTarEntry> first(tar.GetNextEntry());
+    REQUIRE( first );
+    CHECK( first->GetInternalName() == "dir/entry0.txt" );
+
+    REQUIRE( tar.LoadIndex() );
+    CHECK( tar.GetIndexedCount() == 10 );
+
+    REQUIRE( tar.OpenEntry("dir/entry7.txt", wxPATH_UNIX) );
+    CHECK( ReadAllFrom(tar) == GetIndexTestData(7) );
+
+    REQUIRE( tar.SeekI(3) == 3 );
+    CHECK( ReadAllFrom(tar) == GetIndexTestData(7).substr(3) );
+}
+
+// Seeking in xz streams requires liblzma 5.4 or later.
+#if wxUSE_LIBLZMA && LZMA_VERSION >= 50040002
+
+TEST_CASE("wxTarInputStream::LoadIndex::xz", "[archive][tar][lzma]")
+{
+    const int count = 100;
+    wxMemoryOutputStream mo;
+    {
+        wxLZMAOutputStream xz(mo);
+        REQUIRE( xz.SetThreadCount(2, 4096) );
+        CreateIndexTestArchive(wxTarClassFactory(), xz, count);
+        REQUIRE( xz.Close() );
+    }
+
+    wxMemoryInputStream mi(mo);
+    wxLZMAInputStream xz(mi);
+    REQUIRE( xz.LoadIndex() );
+    CHECK( xz.IsSeekable() );
+
+    wxTarInputStream tar(xz);
+    REQUIRE( tar.LoadIndex() );
+    CHECK( tar.GetIndexedCount() == size_t(count) );
+
+    for ( int n = count - 1; n >= 0; n -= 9 )
+    {
+        REQUIRE( tar.OpenEntry(wxString::Format("dir/entry%d.txt", n),
+                               wxPATH_UNIX) );
+        CHECK( ReadAllFrom(tar) == GetIndexTestData(n) );
+    }
+}
+
+#endif // wxUSE_LIBLZMA && liblzma >= 5.4
+
 #endif // wxUSE_STREAMS
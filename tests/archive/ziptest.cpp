@@ -248,4 +248,273 @@ CppUnit::Test *ziptest::makeTest(
 CPPUNIT_TEST_SUITE_REGISTRATION(ziptest);
 CPPUNIT_TEST_SUITE_NAMED_REGISTRATION(ziptest, "archive/zip");
 
+
+///////////////////////////////////////////////////////////////////////////////
+// Compressing entries concurrently
+
+#if wxUSE_THREADS
+
+#include "wx/mstream.h"
+
+TEST_CASE("wxZipOutputStream::SetThreadCount", "[archive][zip][threads]")
+{
+    // Use many small entries and a few big ones, which are written directly
+    // instead of being compressed in memory.
+    const size_t bigSize = 5*1024*1024 + 17;
+    wxCharBuffer big(bigSize);
+    for ( size_t n = 0; n < bigSize; n++ )
+        big.data()[n] = "0123456789"[(n*n) % 10];
+
+    wxVector<wxString> names;
+    wxVector<wxCharBuffer> contents;
+    for ( int n = 0; n < 100; n++ )
+    {
+        wxString name;
+        wxCharBuffer data;
+        if ( n % 40 == 20 )
+        {
+            name = wxString::Format("big%d.dat", n);
+            data = big;
+        }
+        else
+        {
+            name = wxString::Format("dir/file%d.txt", n);
+            data = wxString::Format("Contents of the file %d. ", n)
+                        .Pad(n*100, '*').utf8_str();
+        }
+
+        names.push_back(name);
+        contents.push_back(data);
+    }
+
+    wxMemoryOutputStream mo;
+    {
+        wxZipOutputStream zip(mo);
+        zip.SetThreadCount(4);
+        CHECK( zip.GetThreadCount() == 4 );
+
+        for ( size_t n = 0; n < names.size(); n++ )
+        {
+            REQUIRE( zip.PutNextEntry(names[n]) );
+
+            const wxCharBuffer& data = contents[n];
+            const size_t len = data.length();
+            REQUIRE( zip.WriteAll(data, len/2) );
+
+            // Flushing the entry forces it to be written immediately.
+            if ( n == 50 )
+                zip.Sync();
+
+            REQUIRE( zip.WriteAll(data.data() + len/2, len - len/2) );
+            CHECK( zip.TellO() == wxFileOffset(len) );
+        }
+
+        REQUIRE( zip.PutNextDirEntry("empty") );
+        REQUIRE( zip.Close() );
+    }
+
+    wxMemoryInputStream mi(mo);
+    wxZipInputStream zip(mi);
+    CHECK( zip.GetTotalEntries() == int(names.size() + 1) );
+
+    for ( size_t n = 0; n < names.size(); n++ )
+    {
+        wxScopedPtr<wxZipEntry> entry(zip.GetNextEntry());
+        REQUIRE( entry );
+        CHECK( entry->GetInternalName() == names[n] );
+
+        const wxCharBuffer& data = contents[n];
+        CHECK( entry->GetSize() == wxFileOffset(data.length()) );
+
+        wxCharBuffer buf(data.length());
+        CHECK( zip.ReadAll(buf.data(), data.length()) );
+        CHECK( memcmp(buf, data, data.length()) == 0 );
+
+        // This checks the entry CRC too.
+        CHECK( zip.GetC() == wxEOF );
+        CHECK( zip.Eof() );
+    }
+
+    wxScopedPtr<wxZipEntry> entry(zip.GetNextEntry());
+    REQUIRE( entry );
+    CHECK( entry->IsDir() );
+    CHECK( !zip.GetNextEntry() );
+}
+
+#endif // wxUSE_THREADS
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Random access to the entries using the central directory index
+
+#include "wx/mstream.h"
+#include "wx/scopedptr.h"
+
+namespace
+{
+
+// Stream hiding the seekability of its parent.
+class NonSeekableInputStream : public wxFilterInputStream
+{
+public:
+    explicit NonSeekableInputStream(wxInputStream& stream)
+        : wxFilterInputStream(stream)
+    {
+    }
+
+    virtual bool IsSeekable() const wxOVERRIDE { return false; }
+
+protected:
+    virtual size_t OnSysRead(void *buffer, size_t size) wxOVERRIDE
+    {
+        size_t count = m_parent_i_stream->Read(buffer, size).LastRead();
+        m_lasterror = m_parent_i_stream->GetLastError();
+        return count;
+    }
+};
+
+} // anonymous namespace
+
+TEST_CASE("wxZipInputStream::LoadIndex", "[archive][zip]")
+{
+    const int count = 200;
+    wxMemoryOutputStream mo;
+    CreateIndexTestArchive(wxZipClassFactory(), mo, count);
+
+    wxMemoryInputStream mi(mo);
+    wxZipInputStream zip(mi);
+
+    CHECK( !zip.HasIndex() );
+    CHECK( !zip.FindEntry("dir/entry1.txt") );
+    REQUIRE( zip.LoadIndex() );
+    CHECK( zip.HasIndex() );
+    CHECK( zip.GetIndexedCount() == size_t(count) );
+    CHECK( zip.GetIndexedEntry(count - 1)->GetInternalName() == "dir/entry199.txt" );
+    CHECK( !zip.GetIndexedEntry(count) );
+
+    CHECK( !zip.FindEntry("dir/entry200.txt") );
+    const wxZipEntry* const entry20 = zip.FindEntry("dir/entry20.txt", wxPATH_UNIX);
+    REQUIRE( entry20 );
+    CHECK( entry20->GetSize() == wxFileOffset(GetIndexTestData(20).length()) );
+
+    SECTION("OpenEntry")
+    {
+        CHECK( !zip.OpenEntry("nonexistent") );
+
+        REQUIRE( zip.OpenEntry("dir/entry123.txt", wxPATH_UNIX) );
+        CHECK( ReadAllFrom(zip) == GetIndexTestData(123) );
+        CHECK( zip.Eof() );
+
+        REQUIRE( zip.OpenEntry("dir/entry10.txt", wxPATH_UNIX) );
+        CHECK( ReadAllFrom(zip) == GetIndexTestData(10) );
+
+        // Sequential access still works after using the index.
+        wxScopedPtr<wxZipEntry> entry(zip.GetNextEntry());
+        REQUIRE( entry );
+        CHECK( entry->GetInternalName() == "dir/entry0.txt" );
+    }
+
+    SECTION("OpenEntryStream")
+    {
+        for ( int n = 0; n < count; n += 7 )
+        {
+            const wxZipEntry* const entry = zip.GetIndexedEntry(n);
+            REQUIRE( entry );
+
+            wxScopedPtr<wxInputStream> in(zip.OpenEntryStream(*entry));
+            REQUIRE( in );
+            CHECK( in->GetLength() == entry->GetSize() );
+            CHECK( ReadAllFrom(*in) == GetIndexTestData(n) );
+            CHECK( in->Eof() );
+        }
+    }
+}
+
+TEST_CASE("wxZipInputStream::OpenEntryByName", "[archive][zip]")
+{
+    wxMemoryOutputStream mo;
+    CreateIndexTestArchive(wxZipClassFactory(), mo, 20);
+
+    // Without the index the entries can still be found, but only forwards.
+    wxMemoryInputStream mi(mo);
+    NonSeekableInputStream ns(mi);
+    wxZipInputStream zip(ns);
+
+    CHECK( !zip.LoadIndex() );
+    REQUIRE( zip.OpenEntry("dir/entry5.txt", wxPATH_UNIX) );
+    CHECK( ReadAllFrom(zip) == GetIndexTestData(5) );
+    REQUIRE( zip.OpenEntry("dir/entry15.txt", wxPATH_UNIX) );
+    CHECK( ReadAllFrom(zip) == GetIndexTestData(15) );
+    CHECK( !zip.OpenEntry("dir/entry10.txt", wxPATH_UNIX) );
+}
+
+#if wxUSE_THREADS
+
+#include "wx/private/threadpool.h"
+
+namespace
+{
+
+class ExtractTask : public wxThreadPoolTask
+{
+public:
+    ExtractTask(const wxZipInputStream& zip, int first, int count)
+        : m_zip(zip), m_first(first), m_count(count), m_errors(0)
+    {
+    }
+
+    int GetErrors() const { return m_errors; }
+
+protected:
+    virtual void Run() wxOVERRIDE
+    {
+        for ( int n = m_first; n < m_first + m_count; n++ )
+        {
+            // Don't use CATCH macros here as they're not thread-safe.
+            wxScopedPtr<wxInputStream> in(
+                m_zip.OpenEntryStream(*m_zip.GetIndexedEntry(n)));
+            if ( !in || ReadAllFrom(*in) != GetIndexTestData(n) )
+                m_errors++;
+        }
+    }
+
+private:
+    const wxZipInputStream& m_zip;
+    const int m_first;
+    const int m_count;
+    int m_errors;
+};
+
+} // anonymous namespace
+
+TEST_CASE("wxZipInputStream::OpenEntryStream", "[archive][zip][threads]")
+{
+    const int count = 400;
+    wxMemoryOutputStream mo;
+    CreateIndexTestArchive(wxZipClassFactory(), mo, count);
+
+    wxMemoryInputStream mi(mo);
+    wxZipInputStream zip(mi);
+    REQUIRE( zip.LoadIndex() );
+
+    wxVector<ExtractTask*> tasks;
+    {
+        wxThreadPool pool(4);
+        for ( int n = 0; n < count; n += 50 )
+        {
+            tasks.push_back(new ExtractTask(zip, n, 50));
+            pool.Submit(tasks.back());
+        }
+    }
+
+    for ( size_t n = 0; n < tasks.size(); n++ )
+    {
+        CHECK( tasks[n]->IsDone() );
+        CHECK( tasks[n]->GetErrors() == 0 );
+        delete tasks[n];
+    }
+}
+
+#endif // wxUSE_THREADS
+
 #endif // wxUSE_STREAMS && wxUSE_ZIPSTREAM
@@ -0,0 +1,305 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        tests/benchmarks/archive.cpp
+// Purpose:     Compression and archive benchmarks
+// Author:      wxWidgets team
+// Created:     2020-10-07
+// Copyright:   (c) 2020 wxWidgets development team
+// Licence:     wxWindows licence
+/////////////////////////////////////////////////////////////////////////////
+
+#include "wx/buffer.h"
+#include "wx/mstream.h"
+#include "wx/scopedptr.h"
+#include "wx/stream.h"
+#include "wx/utils.h"
+#include "wx/zipstrm.h"
+#include "wx/zstream.h"
+
+#include "wx/private/threadpool.h"
+
+#include "bench.h"
+
+#if wxUSE_ZLIB && wxUSE_ZIPSTREAM
+
+// ----------------------------------------------------------------------------
+// test data
+// ----------------------------------------------------------------------------
+
+// The numeric parameter is used as the size of the data in MiB.
+static wxCharBuffer gs_archiveData;
+
+static bool InitArchiveData()
+{
+    const size_t size = 1024*1024*Bench::GetNumericParameter();
+    gs_archiveData = wxCharBuffer(size);
+    if ( !gs_archiveData.data() )
+        return false;
+
+    // Generate something compressible, but not too much, as deflate is
+    // very fast for highly redundant data.
+    static const char *const words[] =
+    {
+        "archive ", "stream ", "compress ", "entry ", "zip ", "deflate ",
+        "thread ", "block ", "data ", "\n", "wxWidgets ", "benchmark ",
+    };
+
+    char *p = gs_archiveData.data();
+    unsigned seed = 1;
+    for ( size_t n = 0; n < size; )
+    {
+        seed = seed*1103515245 + 12345;
+        const char *word = words[(seed >> 16) % WXSIZEOF(words)];
+        for ( ; *word && n < size; word++ )
+            p[n++] = *word;
+    }
+
+    return true;
+}
+
+static void DoneArchiveData()
+{
+    gs_archiveData.reset();
+}
+
+// ----------------------------------------------------------------------------
+// zlib stream benchmarks
+// ----------------------------------------------------------------------------
+
+static bool CompressZlib(int threads)
+{
+    wxCountingOutputStream out;
+    wxZlibOutputStream zout(out, wxZ_DEFAULT_COMPRESSION, wxZLIB_GZIP);
+    if ( threads != 1 && !zout.SetThreadCount(threads) )
+        return false;
+
+    return zout.WriteAll(gs_archiveData, gs_archiveData.length()) &&
+                zout.Close() && out.GetLength() > 0;
+}
+
+BENCHMARK_FUNC_WITH_INIT(ZlibCompress, InitArchiveData, DoneArchiveData)
+{
+    return CompressZlib(1);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ZlibCompress2Threads, InitArchiveData, DoneArchiveData)
+{
+    return CompressZlib(2);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ZlibCompress4Threads, InitArchiveData, DoneArchiveData)
+{
+    return CompressZlib(4);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ZlibCompressAllThreads, InitArchiveData, DoneArchiveData)
+{
+    return CompressZlib(0);
+}
+
+// ----------------------------------------------------------------------------
+// zip archive benchmarks
+// ----------------------------------------------------------------------------
+
+// Store the test data in the archive as entries of the given size, named after
+// their offset in the data.
+static bool PutArchiveEntries(wxZipOutputStream& zip, size_t entrySize)
+{
+    const char *p = gs_archiveData;
+    for ( size_t n = 0; n < gs_archiveData.length(); n += entrySize )
+    {
+        const size_t len = wxMin(entrySize, gs_archiveData.length() - n);
+        if ( !zip.PutNextEntry(wxString::Format("entry%lu.txt",
+                                                static_cast<unsigned long>(n))) ||
+                !zip.WriteAll(p + n, len) )
+            return false;
+    }
+
+    return true;
+}
+
+// Create an archive with many entries of 64KiB each.
+static bool CompressZip(int threads)
+{
+    wxCountingOutputStream out;
+    wxZipOutputStream zip(out);
+    zip.SetThreadCount(threads);
+
+    return PutArchiveEntries(zip, 64*1024) && zip.Close() && out.GetLength() > 0;
+}
+
+BENCHMARK_FUNC_WITH_INIT(ZipCompress, InitArchiveData, DoneArchiveData)
+{
+    return CompressZip(1);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ZipCompress2Threads, InitArchiveData, DoneArchiveData)
+{
+    return CompressZip(2);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ZipCompress4Threads, InitArchiveData, DoneArchiveData)
+{
+    return CompressZip(4);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ZipCompressAllThreads, InitArchiveData, DoneArchiveData)
+{
+    return CompressZip(0);
+}
+
+// ----------------------------------------------------------------------------
+// zip extraction benchmarks
+// ----------------------------------------------------------------------------
+
+static wxMemoryOutputStream *gs_zipArchive;
+
+static bool InitZipArchive()
+{
+    if ( !InitArchiveData() )
+        return false;
+
+    gs_zipArchive = new wxMemoryOutputStream;
+    wxZipOutputStream zip(*gs_zipArchive);
+
+    return PutArchiveEntries(zip, 16*1024) && zip.Close();
+}
+
+static void DoneZipArchive()
+{
+    wxDELETE(gs_zipArchive);
+    DoneArchiveData();
+}
+
+static bool ReadEntryData(wxInputStream& in)
+{
+    char buf[4096];
+    while ( in.Read(buf, sizeof(buf)).LastRead() )
+        ;
+
+    return in.Eof();
+}
+
+// Look up the entries in the reverse order, which is the worst case for the
+// sequential search.
+BENCHMARK_FUNC_WITH_INIT(ZipFindEntries, InitZipArchive, DoneZipArchive)
+{
+    wxMemoryInputStream mi(*gs_zipArchive);
+    wxZipInputStream zip(mi);
+
+    for ( int n = zip.GetTotalEntries() - 1; n >= 0; n -= 10 )
+    {
+        const wxString name = wxString::Format("entry%lu.txt",
+                                               static_cast<unsigned long>(n*16*1024));
+
+        mi.SeekI(0);
+        wxZipInputStream seq(mi);
+        wxScopedPtr<wxZipEntry> entry;
+        while ( entry.reset(seq.GetNextEntry()), entry )
+        {
+            if ( entry->GetInternalName() == name )
+                break;
+        }
+
+        if ( !entry )
+            return false;
+    }
+
+    return true;
+}
+
+BENCHMARK_FUNC_WITH_INIT(ZipFindEntriesIndexed, InitZipArchive, DoneZipArchive)
+{
+    wxMemoryInputStream mi(*gs_zipArchive);
+    wxZipInputStream zip(mi);
+    if ( !zip.LoadIndex() )
+        return false;
+
+    for ( int n = zip.GetTotalEntries() - 1; n >= 0; n -= 10 )
+    {
+        const wxString name = wxString::Format("entry%lu.txt",
+                                               static_cast<unsigned long>(n*16*1024));
+        if ( !zip.FindEntry(name) )
+            return false;
+    }
+
+    return true;
+}
+
+BENCHMARK_FUNC_WITH_INIT(ZipExtract, InitZipArchive, DoneZipArchive)
+{
+    wxMemoryInputStream mi(*gs_zipArchive);
+    wxZipInputStream zip(mi);
+
+    wxScopedPtr<wxZipEntry> entry;
+    while ( entry.reset(zip.GetNextEntry()), entry )
+    {
+        if ( !ReadEntryData(zip) )
+            return false;
+    }
+
+    return zip.Eof();
+}
+
+#if wxUSE_THREADS
+
+class ZipExtractTask : public wxThreadPoolTask
+{
+public:
+    ZipExtractTask(const wxZipInputStream& zip, size_t first, size_t step)
+        : m_zip(zip), m_first(first), m_step(step), m_ok(true)
+    {
+    }
+
+    bool IsOk() const { return m_ok; }
+
+protected:
+    virtual void Run() wxOVERRIDE
+    {
+        for ( size_t n = m_first; n < m_zip.GetIndexedCount(); n += m_step )
+        {
+            wxScopedPtr<wxInputStream>
+                in(m_zip.OpenEntryStream(*m_zip.GetIndexedEntry(n)));
+            if ( !in || !ReadEntryData(*in) )
+                m_ok = false;
+        }
+    }
+
+private:
+    const wxZipInputStream& m_zip;
+    const size_t m_first;
+    const size_t m_step;
+    bool m_ok;
+};
+
+BENCHMARK_FUNC_WITH_INIT(ZipExtractAllThreads, InitZipArchive, DoneZipArchive)
+{
+    wxMemoryInputStream mi(*gs_zipArchive);
+    wxZipInputStream zip(mi);
+    if ( !zip.LoadIndex() )
+        return false;
+
+    wxVector<ZipExtractTask*> tasks;
+    {
+        wxThreadPool pool;
+        const int threads = pool.GetThreadCount() ? pool.GetThreadCount() : 1;
+        for ( int n = 0; n < threads; n++ )
+        {
+            tasks.push_back(new ZipExtractTask(zip, n, threads));
+            pool.Submit(tasks.back());
+        }
+    }
+
+    bool ok = true;
+    for ( size_t n = 0; n < tasks.size(); n++ )
+    {
+        if ( !tasks[n]->IsOk() )
+            ok = false;
+        delete tasks[n];
+    }
+
+    return ok;
+}
+
+#endif // wxUSE_THREADS
+
+#endif // wxUSE_ZLIB && wxUSE_ZIPSTREAM
@@ -0,0 +1,93 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        tests/benchmarks/exec.cpp
+// Purpose:     wxExecute() benchmarks
+// Author:      wxWidgets team
+// Created:     2020-10-20
+// Copyright:   (c) 2020 wxWidgets development team
+// Licence:     wxWindows licence
+/////////////////////////////////////////////////////////////////////////////
+
+#include "wx/defs.h"
+
+#ifdef __UNIX__
+
+#include "wx/buffer.h"
+#include "wx/mstream.h"
+#include "wx/process.h"
+#include "wx/utils.h"
+
+#include "bench.h"
+
+// ----------------------------------------------------------------------------
+// test data
+// ----------------------------------------------------------------------------
+
+namespace
+{
+
+// The numeric parameter is the size, in MiB, of the memory allocated and
+// touched by this process before launching the children, as the cost of
+// fork() is proportional to it.
+wxCharBuffer gs_heap;
+
+bool InitExec()
+{
+    const size_t size = 1024*1024*Bench::GetNumericParameter();
+    if ( !size )
+        return true;
+
+    gs_heap = wxCharBuffer(size);
+    if ( !gs_heap.data() )
+        return false;
+
+    // Touch every page to ensure it's really mapped.
+    for ( size_t n = 0; n < size; n += 4096 )
+        gs_heap.data()[n] = static_cast<char>(n);
+
+    return true;
+}
+
+void DoneExec()
+{
+    gs_heap.reset();
+}
+
+// Run a trivial command, optionally setting its priority: this prevents
+// wxExecute() from using posix_spawn() and forces it to use fork().
+bool ExecOnce(unsigned priority, bool sink)
+{
+    wxProcess process;
+    process.SetPriority(priority);
+
+    wxMemoryOutputStream out;
+    if ( sink )
+        process.SetOutputSink(&out);
+    else
+        process.Redirect();
+
+    return wxExecute("echo hello", wxEXEC_SYNC | wxEXEC_NOEVENTS,
+                     &process) == 0;
+}
+
+} // anonymous namespace
+
+// ----------------------------------------------------------------------------
+// benchmarks
+// ----------------------------------------------------------------------------
+
+BENCHMARK_FUNC_WITH_INIT(ExecSpawn, InitExec, DoneExec)
+{
+    return ExecOnce(wxPRIORITY_DEFAULT, false);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ExecSpawnSink, InitExec, DoneExec)
+{
+    return ExecOnce(wxPRIORITY_DEFAULT, true);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ExecFork, InitExec, DoneExec)
+{
+    return ExecOnce(wxPRIORITY_DEFAULT + 1, false);
+}
+
+#endif // __UNIX__
@@ -0,0 +1,221 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        tests/benchmarks/fdio.cpp
+// Purpose:     wxFDIODispatcher benchmarks
+// Author:      wxWidgets team
+// Created:     2020-10-12
+// Copyright:   (c) 2020 wxWidgets development team
+// Licence:     wxWindows licence
+/////////////////////////////////////////////////////////////////////////////
+
+#include "wx/defs.h"
+
+#ifdef __UNIX__
+
+#include "wx/vector.h"
+
+#include "wx/private/fdiodispatcher.h"
+#include "wx/private/selectdispatcher.h"
+#include "wx/unix/private/epolldispatcher.h"
+#include "wx/unix/private/iouringdispatcher.h"
+
+#include "bench.h"
+
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// ----------------------------------------------------------------------------
+// test data
+// ----------------------------------------------------------------------------
+
+namespace
+{
+
+// Handler reading everything available from its socket.
+class ReadHandler : public wxFDIOHandler
+{
+public:
+    ReadHandler(int fd, int& received) : m_fd(fd), m_received(received) { }
+
+    virtual void OnReadWaiting() wxOVERRIDE
+    {
+        char buf[64];
+        ssize_t rc;
+        while ( (rc = read(m_fd, buf, sizeof(buf))) > 0 )
+            m_received += rc;
+    }
+
+    virtual void OnWriteWaiting() wxOVERRIDE { }
+    virtual void OnExceptionWaiting() wxOVERRIDE { }
+
+private:
+    const int m_fd;
+    int& m_received;
+};
+
+wxFDIODispatcher *gs_dispatcher = NULL;
+
+// Pairs of connected sockets: we write to the first one of each pair and the
+// dispatcher waits for the data on the second one.
+wxVector<int> gs_writeFDs;
+wxVector<int> gs_readFDs;
+wxVector<ReadHandler *> gs_handlers;
+
+int gs_received = 0;
+
+// The numeric parameter is the number of socket pairs in hundreds.
+bool InitFDIO(wxFDIODispatcher *dispatcher, int flags)
+{
+    gs_dispatcher = dispatcher;
+    if ( !gs_dispatcher )
+        return false;
+
+    const long count = 100*Bench::GetNumericParameter();
+    for ( long n = 0; n < count; n++ )
+    {
+        int fds[2];
+        if ( socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0 )
+            return false;
+
+        fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+
+        gs_writeFDs.push_back(fds[0]);
+        gs_readFDs.push_back(fds[1]);
+        gs_handlers.push_back(new ReadHandler(fds[1], gs_received));
+
+        if ( !gs_dispatcher->RegisterFD(fds[1], gs_handlers.back(), flags) )
+            return false;
+    }
+
+    return true;
+}
+
+void DoneFDIO()
+{
+    for ( size_t n = 0; n < gs_readFDs.size(); n++ )
+    {
+        if ( gs_dispatcher )
+            gs_dispatcher->UnregisterFD(gs_readFDs[n]);
+
+        close(gs_readFDs[n]);
+        close(gs_writeFDs[n]);
+        delete gs_handlers[n];
+    }
+
+    gs_readFDs.clear();
+    gs_writeFDs.clear();
+    gs_handlers.clear();
+
+    wxDELETE(gs_dispatcher);
+}
+
+// Write a byte to every socket and dispatch the events until all of them are
+// received, using HasPending() as the event loop does.
+bool DispatchAll()
+{
+    const int count = static_cast<int>(gs_writeFDs.size());
+
+    gs_received = 0;
+    for ( int n = 0; n < count; n++ )
+    {
+        if ( write(gs_writeFDs[n], "x", 1) != 1 )
+            return false;
+    }
+
+    while ( gs_received < count )
+    {
+        if ( gs_dispatcher->HasPending() )
+            gs_dispatcher->Dispatch(0);
+        else if ( gs_dispatcher->Dispatch(1000) <= 0 )
+            return false;
+    }
+
+    return gs_received == count;
+}
+
+} // anonymous namespace
+
+// ----------------------------------------------------------------------------
+// benchmarks
+// ----------------------------------------------------------------------------
+
+#if wxUSE_SELECT_DISPATCHER
+
+static bool InitSelect()
+{
+    return InitFDIO(new wxSelectDispatcher(), wxFDIO_INPUT);
+}
+
+BENCHMARK_FUNC_WITH_INIT(FDIOSelect, InitSelect, DoneFDIO)
+{
+    return DispatchAll();
+}
+
+#endif // wxUSE_SELECT_DISPATCHER
+
+#if wxUSE_EPOLL_DISPATCHER
+
+// Using batch size of 16 corresponds to the behaviour of the old versions.
+static bool InitEpoll16()
+{
+    wxEpollDispatcher * const dispatcher = wxEpollDispatcher::Create();
+    if ( dispatcher )
+        dispatcher->SetBatchSize(16);
+
+    return InitFDIO(dispatcher, wxFDIO_INPUT);
+}
+
+BENCHMARK_FUNC_WITH_INIT(FDIOEpoll16, InitEpoll16, DoneFDIO)
+{
+    return DispatchAll();
+}
+
+static bool InitEpoll()
+{
+    return InitFDIO(wxEpollDispatcher::Create(), wxFDIO_INPUT);
+}
+
+BENCHMARK_FUNC_WITH_INIT(FDIOEpoll, InitEpoll, DoneFDIO)
+{
+    return DispatchAll();
+}
+
+static bool InitEpollEdge()
+{
+    return InitFDIO(wxEpollDispatcher::Create(),
+                    wxFDIO_INPUT | wxFDIO_EDGE_TRIGGERED);
+}
+
+BENCHMARK_FUNC_WITH_INIT(FDIOEpollEdge, InitEpollEdge, DoneFDIO)
+{
+    return DispatchAll();
+}
+
+#endif // wxUSE_EPOLL_DISPATCHER
+
+#ifdef wxHAS_IO_URING_DISPATCHER
+
+static bool InitIOUring()
+{
+    return InitFDIO(wxIOUringDispatcher::Create(), wxFDIO_INPUT);
+}
+
+BENCHMARK_FUNC_WITH_INIT(FDIOIOUring, InitIOUring, DoneFDIO)
+{
+    return DispatchAll();
+}
+
+static bool InitIOUringEdge()
+{
+    return InitFDIO(wxIOUringDispatcher::Create(),
+                    wxFDIO_INPUT | wxFDIO_EDGE_TRIGGERED);
+}
+
+BENCHMARK_FUNC_WITH_INIT(FDIOIOUringEdge, InitIOUringEdge, DoneFDIO)
+{
+    return DispatchAll();
+}
+
+#endif // wxHAS_IO_URING_DISPATCHER
+
+#endif // __UNIX__
@@ -8,6 +8,12 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #include "wx/image.h"
+#include "wx/anidecod.h" // wxImageArray
+#include "wx/gifdecod.h"
+#include "wx/math.h"
+#include "wx/mstream.h"
+#include "wx/palette.h"
+#include "wx/quantize.h"
 
 #include "bench.h"
 
@@ -90,3 +96,603 @@ BENCHMARK_FUNC(ShrinkHighQuality)
 {
     return GetTestImage().Scale(50, 50, wxIMAGE_QUALITY_HIGH).IsOk();
 }
+
+// ----------------------------------------------------------------------------
+// Resampling throughput
+// ----------------------------------------------------------------------------
+
+// The numeric parameter is the size of the image in megapixels, 16 by default.
+static wxImage gs_bigImage;
+
+static bool InitBigImage()
+{
+    long megapixels = Bench::GetNumericParameter();
+    if ( !megapixels )
+        megapixels = 16;
+
+    const int width = static_cast<int>(sqrt(megapixels*1024.*1024*3/2));
+    const int height = width*2/3;
+    if ( !gs_bigImage.Create(width, height, false) )
+        return false;
+
+    // Use some non-uniform contents to avoid any special cases.
+    unsigned char *p = gs_bigImage.GetData();
+    for ( int y = 0; y < height; y++ )
+    {
+        for ( int x = 0; x < width; x++ )
+        {
+            *p++ = static_cast<unsigned char>(x);
+            *p++ = static_cast<unsigned char>(y);
+            *p++ = static_cast<unsigned char>(x ^ y);
+        }
+    }
+
+    return true;
+}
+
+static bool InitBigImageSingleThread()
+{
+    wxImage::SetMaxThreads(1);
+
+    return InitBigImage();
+}
+
+static void DoneBigImage()
+{
+    gs_bigImage.Destroy();
+
+    wxImage::SetMaxThreads(0);
+}
+
+// Scale the image by num/den factor.
+static bool ScaleBigImage(int num, int den, wxImageResizeQuality quality)
+{
+    return gs_bigImage.Scale(gs_bigImage.GetWidth()*num/den,
+                             gs_bigImage.GetHeight()*num/den,
+                             quality).IsOk();
+}
+
+BENCHMARK_FUNC_WITH_INIT(ScaleBoxDiv2, InitBigImage, DoneBigImage)
+{
+    return ScaleBigImage(1, 2, wxIMAGE_QUALITY_BOX_AVERAGE);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ScaleBoxDiv8, InitBigImage, DoneBigImage)
+{
+    return ScaleBigImage(1, 8, wxIMAGE_QUALITY_BOX_AVERAGE);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ScaleBoxDiv32, InitBigImage, DoneBigImage)
+{
+    return ScaleBigImage(1, 32, wxIMAGE_QUALITY_BOX_AVERAGE);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ScaleBoxDiv8SingleThread,
+                         InitBigImageSingleThread, DoneBigImage)
+{
+    return ScaleBigImage(1, 8, wxIMAGE_QUALITY_BOX_AVERAGE);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ScaleBilinearDiv2, InitBigImage, DoneBigImage)
+{
+    return ScaleBigImage(1, 2, wxIMAGE_QUALITY_BILINEAR);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ScaleBilinearDiv8, InitBigImage, DoneBigImage)
+{
+    return ScaleBigImage(1, 8, wxIMAGE_QUALITY_BILINEAR);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ScaleBilinearMul2, InitBigImage, DoneBigImage)
+{
+    return ScaleBigImage(2, 1, wxIMAGE_QUALITY_BILINEAR);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ScaleBicubicDiv2, InitBigImage, DoneBigImage)
+{
+    return ScaleBigImage(1, 2, wxIMAGE_QUALITY_BICUBIC);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ScaleBicubicDiv8, InitBigImage, DoneBigImage)
+{
+    return ScaleBigImage(1, 8, wxIMAGE_QUALITY_BICUBIC);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ScaleBicubicMul2, InitBigImage, DoneBigImage)
+{
+    return ScaleBigImage(2, 1, wxIMAGE_QUALITY_BICUBIC);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ScaleBicubicMul2SingleThread,
+                         InitBigImageSingleThread, DoneBigImage)
+{
+    return ScaleBigImage(2, 1, wxIMAGE_QUALITY_BICUBIC);
+}
+
+// ----------------------------------------------------------------------------
+// Blurring
+// ----------------------------------------------------------------------------
+
+// The blur benchmarks use a screen-sized image with alpha, as when drawing
+// shadows, and the numeric parameter specifies the blur radius, 8 by default.
+static wxImage gs_screenImage;
+
+static bool InitScreenImage()
+{
+    const int width = 1920,
+              height = 1080;
+    if ( !gs_screenImage.Create(width, height, false) )
+        return false;
+
+    gs_screenImage.SetAlpha();
+
+    unsigned char *p = gs_screenImage.GetData();
+    unsigned char *alpha = gs_screenImage.GetAlpha();
+    for ( int y = 0; y < height; y++ )
+    {
+        for ( int x = 0; x < width; x++ )
+        {
+            *p++ = static_cast<unsigned char>(x);
+            *p++ = static_cast<unsigned char>(y);
+            *p++ = static_cast<unsigned char>(x ^ y);
+            *alpha++ = static_cast<unsigned char>(x + y);
+        }
+    }
+
+    return true;
+}
+
+static void DoneScreenImage()
+{
+    gs_screenImage.Destroy();
+}
+
+static int GetBlurRadius()
+{
+    const long radius = Bench::GetNumericParameter();
+    return radius ? static_cast<int>(radius) : 8;
+}
+
+BENCHMARK_FUNC_WITH_INIT(BlurBox, InitScreenImage, DoneScreenImage)
+{
+    return gs_screenImage.Blur(GetBlurRadius()).IsOk();
+}
+
+BENCHMARK_FUNC_WITH_INIT(BlurBoxRadius2, InitScreenImage, DoneScreenImage)
+{
+    return gs_screenImage.Blur(2).IsOk();
+}
+
+BENCHMARK_FUNC_WITH_INIT(BlurBoxRadius64, InitScreenImage, DoneScreenImage)
+{
+    return gs_screenImage.Blur(64).IsOk();
+}
+
+BENCHMARK_FUNC_WITH_INIT(BlurGaussian, InitScreenImage, DoneScreenImage)
+{
+    return gs_screenImage.GaussianBlur(GetBlurRadius()).IsOk();
+}
+
+BENCHMARK_FUNC_WITH_INIT(BlurGaussianRadius2, InitScreenImage, DoneScreenImage)
+{
+    return gs_screenImage.GaussianBlur(2).IsOk();
+}
+
+BENCHMARK_FUNC_WITH_INIT(BlurGaussianRadius64, InitScreenImage, DoneScreenImage)
+{
+    return gs_screenImage.GaussianBlur(64).IsOk();
+}
+
+// ----------------------------------------------------------------------------
+// Pixel formats
+// ----------------------------------------------------------------------------
+
+// Convert the screen image to a packed format and back to RGB, as happens when
+// processing an image drawn using Cairo.
+static bool ConvertScreenImage(wxImagePixelFormat format)
+{
+    wxImage image = gs_screenImage;
+    return image.SetPixelFormat(format) && image.GetData() != NULL;
+}
+
+BENCHMARK_FUNC_WITH_INIT(PixelFormatRGBA, InitScreenImage, DoneScreenImage)
+{
+    return ConvertScreenImage(wxIMAGE_PIXEL_FORMAT_RGBA);
+}
+
+BENCHMARK_FUNC_WITH_INIT(PixelFormatARGB32, InitScreenImage, DoneScreenImage)
+{
+    return ConvertScreenImage(wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED);
+}
+
+// ----------------------------------------------------------------------------
+// Rotation
+// ----------------------------------------------------------------------------
+
+BENCHMARK_FUNC_WITH_INIT(Rotate90, InitScreenImage, DoneScreenImage)
+{
+    return gs_screenImage.Rotate90().IsOk();
+}
+
+BENCHMARK_FUNC_WITH_INIT(Rotate180, InitScreenImage, DoneScreenImage)
+{
+    return gs_screenImage.Rotate180().IsOk();
+}
+
+BENCHMARK_FUNC_WITH_INIT(Mirror, InitScreenImage, DoneScreenImage)
+{
+    return gs_screenImage.Mirror().IsOk();
+}
+
+BENCHMARK_FUNC_WITH_INIT(RotateNearest, InitScreenImage, DoneScreenImage)
+{
+    return gs_screenImage.Rotate(0.3, wxPoint(960, 540), false).IsOk();
+}
+
+BENCHMARK_FUNC_WITH_INIT(RotateInterpolating, InitScreenImage, DoneScreenImage)
+{
+    return gs_screenImage.Rotate(0.3, wxPoint(960, 540), true).IsOk();
+}
+
+// ----------------------------------------------------------------------------
+// Colour operations
+// ----------------------------------------------------------------------------
+
+// These benchmarks use an image of the number of megapixels given by the
+// numeric parameter, 1 by default, so that their times give the cost of the
+// operation per megapixel by default.
+static wxImage gs_colourImage;
+
+static bool InitColourImage()
+{
+    const long megapixels = Bench::GetNumericParameter();
+
+    const int width = 1000,
+              height = 1000*(megapixels > 0 ? megapixels : 1);
+    if ( !gs_colourImage.Create(width, height, false) )
+        return false;
+
+    unsigned char *p = gs_colourImage.GetData();
+    for ( int y = 0; y < height; y++ )
+    {
+        for ( int x = 0; x < width; x++ )
+        {
+            *p++ = static_cast<unsigned char>(x);
+            *p++ = static_cast<unsigned char>(y);
+            *p++ = static_cast<unsigned char>(x ^ y);
+        }
+    }
+
+    // Use a colour present in the image as the mask one, as icons do.
+    gs_colourImage.SetMaskColour(0, 0, 0);
+
+    return true;
+}
+
+static void DoneColourImage()
+{
+    gs_colourImage.Destroy();
+}
+
+BENCHMARK_FUNC_WITH_INIT(ColourGreyscale, InitColourImage, DoneColourImage)
+{
+    return gs_colourImage.ConvertToGreyscale().IsOk();
+}
+
+BENCHMARK_FUNC_WITH_INIT(ColourDisabled, InitColourImage, DoneColourImage)
+{
+    return gs_colourImage.ConvertToDisabled().IsOk();
+}
+
+BENCHMARK_FUNC_WITH_INIT(ColourMono, InitColourImage, DoneColourImage)
+{
+    return gs_colourImage.ConvertToMono(0, 0, 0).IsOk();
+}
+
+BENCHMARK_FUNC_WITH_INIT(ColourLightness, InitColourImage, DoneColourImage)
+{
+    return gs_colourImage.ChangeLightness(150).IsOk();
+}
+
+BENCHMARK_FUNC_WITH_INIT(ColourRotateHue, InitColourImage, DoneColourImage)
+{
+    gs_colourImage.RotateHue(0.25);
+    return true;
+}
+
+BENCHMARK_FUNC_WITH_INIT(ColourReplace, InitColourImage, DoneColourImage)
+{
+    // Alternate between the two colours to always have something to replace.
+    static bool s_swap = false;
+    s_swap = !s_swap;
+    if ( s_swap )
+        gs_colourImage.Replace(0, 0, 0, 1, 2, 3);
+    else
+        gs_colourImage.Replace(1, 2, 3, 0, 0, 0);
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Histogram
+// ----------------------------------------------------------------------------
+
+BENCHMARK_FUNC_WITH_INIT(ComputeHistogram, InitScreenImage, DoneScreenImage)
+{
+    wxImageHistogram h;
+    return gs_screenImage.ComputeHistogram(h) != 0;
+}
+
+BENCHMARK_FUNC_WITH_INIT(CountColours, InitScreenImage, DoneScreenImage)
+{
+    return gs_screenImage.CountColours() != 0;
+}
+
+BENCHMARK_FUNC_WITH_INIT(FindFirstUnusedColour, InitScreenImage, DoneScreenImage)
+{
+    unsigned char r, g, b;
+    return gs_screenImage.FindFirstUnusedColour(&r, &g, &b);
+}
+
+// ----------------------------------------------------------------------------
+// Quantization
+// ----------------------------------------------------------------------------
+
+static bool QuantizeScreenImage(int flags)
+{
+    wxImage dest;
+    unsigned char *data8bit = NULL;
+    if ( !wxQuantize::Quantize(gs_screenImage, dest, NULL, 236, &data8bit,
+                               flags | wxQUANTIZE_RETURN_8BIT_DATA) )
+        return false;
+
+    delete [] data8bit;
+    return true;
+}
+
+BENCHMARK_FUNC_WITH_INIT(QuantizeDither, InitScreenImage, DoneScreenImage)
+{
+    return QuantizeScreenImage(0);
+}
+
+BENCHMARK_FUNC_WITH_INIT(QuantizeNoDither, InitScreenImage, DoneScreenImage)
+{
+    return QuantizeScreenImage(wxQUANTIZE_NO_DITHER);
+}
+
+BENCHMARK_FUNC_WITH_INIT(QuantizeOrderedDither, InitScreenImage, DoneScreenImage)
+{
+    return QuantizeScreenImage(wxQUANTIZE_ORDERED_DITHER);
+}
+
+// ----------------------------------------------------------------------------
+// JPEG thumbnails
+// ----------------------------------------------------------------------------
+
+static wxMemoryOutputStream *gs_jpegData = NULL;
+
+static bool InitJPEGData()
+{
+    if ( !wxImage::FindHandler(wxBITMAP_TYPE_JPEG) )
+        wxImage::AddHandler(new wxJPEGHandler);
+
+    if ( !InitScreenImage() )
+        return false;
+
+    gs_jpegData = new wxMemoryOutputStream;
+    const bool ok = gs_screenImage.SaveFile(*gs_jpegData, wxBITMAP_TYPE_JPEG);
+
+    DoneScreenImage();
+
+    return ok;
+}
+
+static void DoneJPEGData()
+{
+    wxDELETE(gs_jpegData);
+}
+
+static bool LoadJPEGThumbnail(bool reduced)
+{
+    wxImage image;
+    if ( reduced )
+    {
+        image.SetOption(wxIMAGE_OPTION_MIN_WIDTH, 256);
+        image.SetOption(wxIMAGE_OPTION_JPEG_FAST_IDCT, 1);
+    }
+
+    wxMemoryInputStream mis(*gs_jpegData);
+    if ( !image.LoadFile(mis, wxBITMAP_TYPE_JPEG) )
+        return false;
+
+    image.Rescale(256, 144, wxIMAGE_QUALITY_BILINEAR);
+
+    return image.IsOk();
+}
+
+BENCHMARK_FUNC_WITH_INIT(JPEGThumbnailFull, InitJPEGData, DoneJPEGData)
+{
+    return LoadJPEGThumbnail(false);
+}
+
+BENCHMARK_FUNC_WITH_INIT(JPEGThumbnailReduced, InitJPEGData, DoneJPEGData)
+{
+    return LoadJPEGThumbnail(true);
+}
+
+// ----------------------------------------------------------------------------
+// PNG saving and loading
+// ----------------------------------------------------------------------------
+
+static bool InitPNGScreenImage()
+{
+    if ( !wxImage::FindHandler(wxBITMAP_TYPE_PNG) )
+        wxImage::AddHandler(new wxPNGHandler);
+
+    return InitScreenImage();
+}
+
+static bool InitPNGScreenImageSingleThread()
+{
+    wxImage::SetMaxThreads(1);
+
+    return InitPNGScreenImage();
+}
+
+static void DonePNGScreenImage()
+{
+    DoneScreenImage();
+
+    wxImage::SetMaxThreads(0);
+}
+
+BENCHMARK_FUNC_WITH_INIT(SavePNG, InitPNGScreenImage, DonePNGScreenImage)
+{
+    wxMemoryOutputStream mos;
+    return gs_screenImage.SaveFile(mos, wxBITMAP_TYPE_PNG);
+}
+
+BENCHMARK_FUNC_WITH_INIT(SavePNGSingleThread,
+                         InitPNGScreenImageSingleThread, DonePNGScreenImage)
+{
+    wxMemoryOutputStream mos;
+    return gs_screenImage.SaveFile(mos, wxBITMAP_TYPE_PNG);
+}
+
+static wxMemoryOutputStream *gs_pngData = NULL;
+
+static bool InitPNGData()
+{
+    if ( !InitPNGScreenImage() )
+        return false;
+
+    gs_pngData = new wxMemoryOutputStream;
+    const bool ok = gs_screenImage.SaveFile(*gs_pngData, wxBITMAP_TYPE_PNG);
+
+    DoneScreenImage();
+
+    return ok;
+}
+
+static void DonePNGData()
+{
+    wxDELETE(gs_pngData);
+}
+
+static bool LoadPNGWithAlpha(wxImagePixelFormat format)
+{
+    wxImage image;
+    image.SetOption(wxIMAGE_OPTION_PNG_PIXEL_FORMAT, format);
+
+    wxMemoryInputStream mis(*gs_pngData);
+    return image.LoadFile(mis, wxBITMAP_TYPE_PNG);
+}
+
+BENCHMARK_FUNC_WITH_INIT(LoadPNGAlpha, InitPNGData, DonePNGData)
+{
+    return LoadPNGWithAlpha(wxIMAGE_PIXEL_FORMAT_RGB);
+}
+
+BENCHMARK_FUNC_WITH_INIT(LoadPNGAlphaRGBA, InitPNGData, DonePNGData)
+{
+    return LoadPNGWithAlpha(wxIMAGE_PIXEL_FORMAT_RGBA);
+}
+
+// ----------------------------------------------------------------------------
+// GIF animations
+// ----------------------------------------------------------------------------
+
+#if wxUSE_GIF && wxUSE_PALETTE
+
+static const int GIF_FRAMES = 32;
+
+static wxMemoryOutputStream *gs_gifData = NULL;
+
+static bool InitGIFAnimation()
+{
+    // Use a palette of 64 colours with 4 levels of each component.
+    unsigned char r[64], g[64], b[64];
+    for ( int n = 0; n < 64; n++ )
+    {
+        r[n] = static_cast<unsigned char>(85*(n & 3));
+        g[n] = static_cast<unsigned char>(85*((n >> 2) & 3));
+        b[n] = static_cast<unsigned char>(85*(n >> 4));
+    }
+
+    const wxPalette palette(64, r, g, b);
+
+    const int width = 640,
+              height = 480;
+
+    wxImageArray frames;
+    for ( int i = 0; i < GIF_FRAMES; i++ )
+    {
+        wxImage image(width, height, false);
+        image.SetPalette(palette);
+
+        unsigned char *p = image.GetData();
+        for ( int y = 0; y < height; y++ )
+        {
+            for ( int x = 0; x < width; x++ )
+            {
+                const int n = (((x + 4*i) >> 4) ^ ((y - 2*i) >> 3)) & 63;
+                *p++ = r[n];
+                *p++ = g[n];
+                *p++ = b[n];
+            }
+        }
+
+        frames.Add(image);
+    }
+
+    gs_gifData = new wxMemoryOutputStream;
+
+    wxGIFHandler handler;
+    return handler.SaveAnimation(frames, gs_gifData, false, 40);
+}
+
+static void DoneGIFAnimation()
+{
+    wxDELETE(gs_gifData);
+}
+
+static bool LoadGIFFrames(unsigned int first, unsigned int maxCached)
+{
+    wxGIFDecoder decoder;
+    decoder.SetMaxCachedFrames(maxCached);
+
+    wxMemoryInputStream mis(*gs_gifData);
+    if ( decoder.LoadGIF(mis) != wxGIF_OK )
+        return false;
+
+    wxImage image;
+    for ( unsigned int n = first; n < decoder.GetFrameCount(); n++ )
+    {
+        if ( !decoder.ConvertToImage(n, &image) )
+            return false;
+    }
+
+    return true;
+}
+
+// Decoding of all the frames, as done when playing the animation.
+BENCHMARK_FUNC_WITH_INIT(LoadGIFAnimation, InitGIFAnimation, DoneGIFAnimation)
+{
+    return LoadGIFFrames(0, 4);
+}
+
+// The same but keeping all the decoded frames in memory.
+BENCHMARK_FUNC_WITH_INIT(LoadGIFAnimationCacheAll,
+                         InitGIFAnimation, DoneGIFAnimation)
+{
+    return LoadGIFFrames(0, 0);
+}
+
+// Loading the animation and getting just its last frame only decodes the
+// first and the last ones.
+BENCHMARK_FUNC_WITH_INIT(LoadGIFLastFrame, InitGIFAnimation, DoneGIFAnimation)
+{
+    return LoadGIFFrames(GIF_FRAMES - 1, 4);
+}
+
+#endif // wxUSE_GIF && wxUSE_PALETTE
@@ -0,0 +1,242 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        tests/benchmarks/ipc.cpp
+// Purpose:     wxIPC data transfer benchmarks
+// Author:      wxWidgets team
+// Created:     2020-10-19
+// Copyright:   (c) 2020 wxWidgets development team
+// Licence:     wxWindows licence
+/////////////////////////////////////////////////////////////////////////////
+
+#include "wx/defs.h"
+
+#if defined(__UNIX__) && wxUSE_THREADS
+
+#include "wx/app.h"
+#include "wx/buffer.h"
+#include "wx/evtloop.h"
+#include "wx/filename.h"
+#include "wx/thread.h"
+#include "wx/utils.h"
+
+// do this before including wx/ipc.h under Windows to use TCP even there
+#define wxUSE_DDE_FOR_IPC 0
+#include "wx/ipc.h"
+
+#include "bench.h"
+
+// ----------------------------------------------------------------------------
+// test data
+// ----------------------------------------------------------------------------
+
+namespace
+{
+
+const char *IPC_BENCH_TOPIC = "wxIPC transfer";
+
+// The numeric parameter is the size of the data transferred in KiB.
+wxCharBuffer gs_data;
+
+// Server connection checking the data received.
+class ReceiverConnection : public wxConnection
+{
+public:
+    ReceiverConnection() : m_ok(true) { }
+
+    // wait until the data is received
+    bool WaitForData()
+    {
+        return m_received.WaitTimeout(60000) == wxSEMA_NO_ERROR && m_ok;
+    }
+
+    virtual bool OnExecute(const wxString& WXUNUSED(topic),
+                           const void *data,
+                           size_t size,
+                           wxIPCFormat WXUNUSED(format)) wxOVERRIDE
+    {
+        const char * const p = static_cast<const char *>(data);
+        if ( size != gs_data.length() ||
+                p[0] != gs_data[0] || p[size - 1] != gs_data[size - 1] )
+            m_ok = false;
+
+        m_received.Post();
+
+        return true;
+    }
+
+    // wait until the client disconnects
+    bool WaitForDisconnect()
+    {
+        return m_disconnected.WaitTimeout(60000) == wxSEMA_NO_ERROR;
+    }
+
+    // the connection is deleted by the server, don't do it here
+    virtual bool OnDisconnect() wxOVERRIDE
+    {
+        m_disconnected.Post();
+        return true;
+    }
+
+private:
+    wxSemaphore m_received,
+                m_disconnected;
+    volatile bool m_ok;
+};
+
+class ReceiverServer : public wxServer
+{
+public:
+    ReceiverServer() : m_conn(NULL) { }
+    virtual ~ReceiverServer() { delete m_conn; }
+
+    ReceiverConnection *GetConnection() const { return m_conn; }
+
+    virtual wxConnectionBase *
+    OnAcceptConnection(const wxString& topic) wxOVERRIDE
+    {
+        if ( topic != IPC_BENCH_TOPIC || m_conn )
+            return NULL;
+
+        m_conn = new ReceiverConnection;
+        return m_conn;
+    }
+
+private:
+    ReceiverConnection *m_conn;
+};
+
+// The events, and hence the server side of the connection, are handled in
+// a secondary thread as the client blocks the main one while sending the
+// data, as in the IPC unit test.
+class EventThread : public wxThread
+{
+public:
+    EventThread()
+        : wxThread(wxTHREAD_JOINABLE),
+          m_stop(false)
+    {
+    }
+
+    void Stop()
+    {
+        m_stop = true;
+        Wait();
+    }
+
+protected:
+    virtual ExitCode Entry() wxOVERRIDE
+    {
+        while ( !m_stop )
+        {
+            wxTheApp->ProcessPendingEvents();
+            m_loop.DispatchTimeout(10);
+        }
+
+        return NULL;
+    }
+
+private:
+    wxEventLoop m_loop;
+    volatile bool m_stop;
+};
+
+ReceiverServer *gs_server = NULL;
+wxClient *gs_client = NULL;
+wxConnection *gs_conn = NULL;
+EventThread *gs_thread = NULL;
+
+bool InitTransfer(size_t sharedMemorySize)
+{
+    gs_data = wxCharBuffer(1024*Bench::GetNumericParameter());
+    if ( !gs_data.data() || !gs_data.length() )
+        return false;
+
+    for ( size_t n = 0; n < gs_data.length(); n++ )
+        gs_data.data()[n] = static_cast<char>(n);
+
+    // use a Unix domain socket as shared memory is only used with them
+    const wxString service = wxString::Format("%s/wxbench_ipc_%lu",
+                                              wxFileName::GetTempDir(),
+                                              wxGetProcessId());
+
+    gs_server = new ReceiverServer;
+    if ( !gs_server->Create(service) )
+        return false;
+
+    gs_thread = new EventThread;
+    if ( gs_thread->Run() != wxTHREAD_NO_ERROR )
+    {
+        wxDELETE(gs_thread);
+        return false;
+    }
+
+    gs_client = new wxClient;
+    gs_client->SetSharedMemorySize(sharedMemorySize);
+
+    gs_conn = static_cast<wxConnection *>(
+                gs_client->MakeConnection("localhost", service, IPC_BENCH_TOPIC));
+
+    return gs_conn && gs_server->GetConnection();
+}
+
+void DoneTransfer()
+{
+    if ( gs_conn )
+    {
+        wxDELETE(gs_conn);
+
+        // let the server handle the disconnection before stopping the thread
+        if ( gs_server->GetConnection() )
+            gs_server->GetConnection()->WaitForDisconnect();
+    }
+
+    wxDELETE(gs_client);
+
+    if ( gs_thread )
+    {
+        gs_thread->Stop();
+        wxDELETE(gs_thread);
+    }
+
+    wxDELETE(gs_server);
+    gs_data.reset();
+}
+
+bool TransferOnce()
+{
+    return gs_conn->Execute(gs_data, gs_data.length()) &&
+                gs_server->GetConnection()->WaitForData();
+}
+
+} // anonymous namespace
+
+// ----------------------------------------------------------------------------
+// benchmarks
+// ----------------------------------------------------------------------------
+
+static bool InitSocketTransfer()
+{
+    return InitTransfer(0);
+}
+
+BENCHMARK_FUNC_WITH_INIT(IPCExecuteSocket, InitSocketTransfer, DoneTransfer)
+{
+    return TransferOnce();
+}
+
+static bool InitSharedMemoryTransfer()
+{
+    if ( !InitTransfer(4*1024*1024) )
+        return false;
+
+    // there is no point in running this benchmark if shared memory is not
+    // supported, it would just duplicate the one above
+    return gs_conn->UsesSharedMemory();
+}
+
+BENCHMARK_FUNC_WITH_INIT(IPCExecuteSharedMemory, InitSharedMemoryTransfer,
+                         DoneTransfer)
+{
+    return TransferOnce();
+}
+
+#endif // __UNIX__ && wxUSE_THREADS
@@ -0,0 +1,176 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        tests/benchmarks/socket.cpp
+// Purpose:     wxSocket benchmarks
+// Author:      wxWidgets team
+// Created:     2020-10-19
+// Copyright:   (c) 2020 wxWidgets development team
+// Licence:     wxWindows licence
+/////////////////////////////////////////////////////////////////////////////
+
+#include "wx/socket.h"
+
+#ifdef wxHAS_SOCKET_SERVER_POOL
+
+#include "wx/private/threadpool.h"
+
+#include "bench.h"
+
+// ----------------------------------------------------------------------------
+// test data
+// ----------------------------------------------------------------------------
+
+namespace
+{
+
+// Handler echoing back the data received by the server sockets.
+class EchoHandler : public wxEvtHandler
+{
+public:
+    EchoHandler()
+    {
+        Bind(wxEVT_SOCKET, &EchoHandler::OnSocketEvent, this);
+    }
+
+private:
+    void OnSocketEvent(wxSocketEvent& event)
+    {
+        wxSocketBase * const sock = event.GetSocket();
+
+        char buf[64];
+        sock->Read(buf, sizeof(buf));
+        if ( sock->LastReadCount() )
+            sock->Write(buf, sock->LastReadCount());
+    }
+};
+
+EchoHandler *gs_handler = NULL;
+wxSocketServerPool *gs_pool = NULL;
+wxIPV4address *gs_address = NULL;
+
+bool InitPool(int threads, wxSocketFlags flags)
+{
+    wxIPV4address addr;
+    addr.LocalHost();
+    addr.Service(0);
+
+    gs_pool = new wxSocketServerPool(addr, threads, flags);
+    if ( !gs_pool->IsOk() )
+        return false;
+
+    gs_handler = new EchoHandler;
+    gs_pool->SetEventHandler(*gs_handler);
+    gs_pool->SetNotify(wxSOCKET_INPUT_FLAG);
+
+    gs_address = new wxIPV4address;
+    return gs_pool->GetLocal(*gs_address) && gs_pool->Start();
+}
+
+void DonePool()
+{
+    wxDELETE(gs_pool);
+    wxDELETE(gs_handler);
+    wxDELETE(gs_address);
+}
+
+// Task connecting to the server the given number of times, exchanging a byte
+// with it and disconnecting.
+class ConnectTask : public wxThreadPoolTask
+{
+public:
+    explicit ConnectTask(long count) : m_count(count), m_ok(true) { }
+
+    bool IsOk() const { return m_ok; }
+
+protected:
+    virtual void Run() wxOVERRIDE
+    {
+        for ( long n = 0; n < m_count; n++ )
+        {
+            wxSocketClient client(wxSOCKET_BLOCK | wxSOCKET_WAITALL);
+            client.SetTimeout(10);
+
+            char ch = 'x';
+            if ( !client.Connect(*gs_address) ||
+                    client.Write(&ch, 1).LastWriteCount() != 1 ||
+                        client.Read(&ch, 1).LastReadCount() != 1 )
+            {
+                m_ok = false;
+                break;
+            }
+        }
+    }
+
+private:
+    const long m_count;
+    bool m_ok;
+};
+
+// The numeric parameter is the number of connections in hundreds, which are
+// made from 4 client threads.
+bool ConnectAll()
+{
+    static const int CLIENT_THREADS = 4;
+
+    const long count = 100*Bench::GetNumericParameter();
+
+    wxVector<ConnectTask *> tasks;
+    {
+        wxThreadPool pool(CLIENT_THREADS);
+        for ( int n = 0; n < CLIENT_THREADS; n++ )
+        {
+            tasks.push_back(new ConnectTask(count / CLIENT_THREADS));
+            pool.Submit(tasks.back());
+        }
+    }
+
+    bool ok = true;
+    for ( size_t n = 0; n < tasks.size(); n++ )
+    {
+        if ( !tasks[n]->IsOk() )
+            ok = false;
+        delete tasks[n];
+    }
+
+    return ok;
+}
+
+} // anonymous namespace
+
+// ----------------------------------------------------------------------------
+// benchmarks
+// ----------------------------------------------------------------------------
+
+// A single thread handling all connections, as the main event loop does.
+static bool InitPool1Thread()
+{
+    return InitPool(1, wxSOCKET_NONE);
+}
+
+BENCHMARK_FUNC_WITH_INIT(SocketConnect1Thread, InitPool1Thread, DonePool)
+{
+    return ConnectAll();
+}
+
+// A single thread accepting the connections and distributing them.
+static bool InitPoolAllThreads()
+{
+    return InitPool(0, wxSOCKET_NONE);
+}
+
+BENCHMARK_FUNC_WITH_INIT(SocketConnectAllThreads, InitPoolAllThreads, DonePool)
+{
+    return ConnectAll();
+}
+
+// Each thread accepting the connections itself.
+static bool InitPoolReusePort()
+{
+    return InitPool(0, wxSOCKET_REUSEPORT);
+}
+
+BENCHMARK_FUNC_WITH_INIT(SocketConnectReusePort, InitPoolReusePort, DonePool)
+{
+    return ConnectAll();
+}
+
+#endif // wxHAS_SOCKET_SERVER_POOL
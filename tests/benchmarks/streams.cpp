@@ -0,0 +1,195 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        tests/benchmarks/streams.cpp
+// Purpose:     Streams benchmarks
+// Author:      wxWidgets team
+// Created:     2020-10-05
+// Copyright:   (c) 2020 wxWidgets development team
+// Licence:     wxWindows licence
+/////////////////////////////////////////////////////////////////////////////
+
+#include "wx/filename.h"
+#include "wx/mstream.h"
+#include "wx/wfstream.h"
+
+#include "bench.h"
+
+// ----------------------------------------------------------------------------
+// file reading benchmarks
+// ----------------------------------------------------------------------------
+
+// The numeric parameter is used as the size of the test file in MiB.
+static wxString gs_streamsFile;
+
+static bool InitStreamsFile()
+{
+    gs_streamsFile = wxFileName::CreateTempFileName("wxbench");
+    if ( gs_streamsFile.empty() )
+        return false;
+
+    wxFileOutputStream out(gs_streamsFile);
+
+    char buf[1024];
+    for ( size_t n = 0; n < sizeof(buf); n++ )
+        buf[n] = static_cast<char>(n % 251);
+
+    for ( long n = 0; n < 1024*Bench::GetNumericParameter(); n++ )
+    {
+        if ( !out.WriteAll(buf, sizeof(buf)) )
+            return false;
+    }
+
+    return out.Close();
+}
+
+static void DoneStreamsFile()
+{
+    wxRemoveFile(gs_streamsFile);
+    gs_streamsFile.clear();
+}
+
+// Read the entire stream using small chunks, as the image decoders do.
+static bool ReadInChunks(wxInputStream& stream)
+{
+    char buf[256];
+    unsigned sum = 0;
+    while ( stream.Read(buf, sizeof(buf)).LastRead() )
+        sum += static_cast<unsigned char>(buf[0]);
+
+    return sum != 0;
+}
+
+BENCHMARK_FUNC_WITH_INIT(ReadFileStream, InitStreamsFile, DoneStreamsFile)
+{
+    wxFileInputStream stream(gs_streamsFile);
+    return ReadInChunks(stream);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ReadBufferedFileStream, InitStreamsFile, DoneStreamsFile)
+{
+    wxFileInputStream stream(gs_streamsFile);
+    wxBufferedInputStream bstream(stream);
+    return ReadInChunks(bstream);
+}
+
+BENCHMARK_FUNC_WITH_INIT(ReadMappedFileStream, InitStreamsFile, DoneStreamsFile)
+{
+    wxMappedFileInputStream stream(gs_streamsFile, wxMAPPED_FILE_ACCESS_SEQUENTIAL);
+    return ReadInChunks(stream);
+}
+
+BENCHMARK_FUNC_WITH_INIT(MemoryStreamFromFile, InitStreamsFile, DoneStreamsFile)
+{
+    wxFileInputStream stream(gs_streamsFile);
+    wxMemoryInputStream mstream(stream);
+    return mstream.GetLength() != 0;
+}
+
+BENCHMARK_FUNC_WITH_INIT(MemoryStreamFromMappedFile, InitStreamsFile, DoneStreamsFile)
+{
+    wxMappedFileInputStream stream(gs_streamsFile);
+    wxMemoryInputStream mstream(stream);
+    return mstream.GetLength() != 0;
+}
+
+// Read the entire stream using big chunks, which shouldn't be buffered.
+static bool ReadInBigChunks(wxInputStream& stream)
+{
+    static char buf[256*1024];
+    unsigned sum = 0;
+    while ( stream.Read(buf, sizeof(buf)).LastRead() )
+        sum += static_cast<unsigned char>(buf[1]);
+
+    return sum != 0;
+}
+
+BENCHMARK_FUNC_WITH_INIT(ReadBufferedFileStreamBigChunks, InitStreamsFile, DoneStreamsFile)
+{
+    wxFileInputStream stream(gs_streamsFile);
+    wxBufferedInputStream bstream(stream);
+    return ReadInBigChunks(bstream);
+}
+
+// Read the stream as a sequence of small headers followed by bigger records.
+BENCHMARK_FUNC_WITH_INIT(ReadFileStreamRecords, InitStreamsFile, DoneStreamsFile)
+{
+    wxFileInputStream stream(gs_streamsFile);
+
+    char header[16];
+    char record[4096];
+    unsigned sum = 0;
+    for ( ;; )
+    {
+        if ( !stream.Read(header, sizeof(header)).LastRead() ||
+                !stream.Read(record, sizeof(record)).LastRead() )
+            break;
+
+        sum += static_cast<unsigned char>(header[1]);
+    }
+
+    return sum != 0;
+}
+
+BENCHMARK_FUNC_WITH_INIT(ReadVFileStreamRecords, InitStreamsFile, DoneStreamsFile)
+{
+    wxFileInputStream stream(gs_streamsFile);
+
+    char header[16];
+    char record[4096];
+    const wxIOVec vec[] =
+    {
+        wxIOVec(header, sizeof(header)),
+        wxIOVec(record, sizeof(record)),
+    };
+
+    unsigned sum = 0;
+    while ( stream.ReadV(vec, WXSIZEOF(vec)).LastRead() )
+        sum += static_cast<unsigned char>(header[1]);
+
+    return sum != 0;
+}
+
+// ----------------------------------------------------------------------------
+// file writing benchmarks
+// ----------------------------------------------------------------------------
+
+// The numeric parameter is used as the size of the written data in MiB.
+static bool WriteInChunks(wxOutputStream& stream, size_t chunk)
+{
+    wxCharBuffer buf(chunk);
+    memset(buf.data(), 17, chunk);
+
+    const size_t total = 1024*1024*Bench::GetNumericParameter();
+    for ( size_t n = 0; n < total; n += chunk )
+    {
+        if ( !stream.WriteAll(buf, chunk) )
+            return false;
+    }
+
+    return stream.Close();
+}
+
+static bool WriteBuffered(size_t chunk)
+{
+    const wxString name = wxFileName::CreateTempFileName("wxbench");
+
+    bool ok;
+    {
+        wxFileOutputStream stream(name);
+        wxBufferedOutputStream bstream(stream);
+        ok = WriteInChunks(bstream, chunk);
+    }
+
+    wxRemoveFile(name);
+
+    return ok;
+}
+
+BENCHMARK_FUNC(WriteBufferedFileStream)
+{
+    return WriteBuffered(256);
+}
+
+BENCHMARK_FUNC(WriteBufferedFileStreamBigChunks)
+{
+    return WriteBuffered(256*1024);
+}
@@ -0,0 +1,183 @@
+/////////////////////////////////////////////////////////////////////////////
+// Name:        tests/benchmarks/webrequest.cpp
+// Purpose:     wxWebRequest throughput benchmarks
+// Author:      wxWidgets team
+// Created:     2020-10-20
+// Copyright:   (c) 2020 wxWidgets development team
+// Licence:     wxWindows licence
+/////////////////////////////////////////////////////////////////////////////
+
+#include "wx/defs.h"
+
+#if wxUSE_WEBREQUEST
+
+#include "wx/evtloop.h"
+#include "wx/socket.h"
+#include "wx/timer.h"
+#include "wx/vector.h"
+#include "wx/webrequest.h"
+
+#include "bench.h"
+
+#include "../net/httpserver.h"
+
+#ifdef wxHAS_SOCKET_SERVER_POOL
+
+// ----------------------------------------------------------------------------
+// test data
+// ----------------------------------------------------------------------------
+
+namespace
+{
+
+// Client starting the requests and waiting for all of them to complete.
+class RequestRunner : public wxTimer
+{
+public:
+    RequestRunner() : m_count(0), m_completed(0), m_succeeded(0)
+    {
+        Bind(wxEVT_WEBREQUEST_STATE, &RequestRunner::OnRequestState, this);
+    }
+
+    bool Run(wxWebSession& session, const wxString& url, int count)
+    {
+        m_count = count;
+        m_completed =
+        m_succeeded = 0;
+
+        wxVector<wxWebRequest> requests;
+        for ( int n = 0; n < count; n++ )
+        {
+            requests.push_back(session.CreateRequest(this, url));
+            requests.back().Start();
+        }
+
+        StartOnce(60000);
+        m_loop.Run();
+        Stop();
+
+        return m_succeeded == count;
+    }
+
+    virtual void Notify() wxOVERRIDE
+    {
+        m_loop.Exit();
+    }
+
+private:
+    void OnRequestState(wxWebRequestEvent& evt)
+    {
+        switch ( evt.GetState() )
+        {
+            case wxWebRequest::State_Completed:
+                m_succeeded++;
+                wxFALLTHROUGH;
+
+            case wxWebRequest::State_Unauthorized:
+            case wxWebRequest::State_Failed:
+            case wxWebRequest::State_Cancelled:
+                if ( ++m_completed == m_count )
+                    m_loop.Exit();
+                break;
+
+            case wxWebRequest::State_Idle:
+            case wxWebRequest::State_Active:
+                break;
+        }
+    }
+
+    wxEventLoop m_loop;
+    int m_count;
+    int m_completed;
+    int m_succeeded;
+};
+
+LoopbackHTTPServer *gs_server = NULL;
+RequestRunner *gs_runner = NULL;
+wxWebSession *gs_session = NULL;
+wxString *gs_url = NULL;
+
+// Options applied to the session used by the benchmark, 0 means to keep the
+// default values.
+bool InitRequests(int maxConnectionsPerHost, bool sharedCache)
+{
+    if ( !wxWebSession::IsBackendAvailable(wxWebSessionBackendCURL) )
+        return false;
+
+    gs_server = new LoopbackHTTPServer;
+    if ( !gs_server->Start() )
+        return false;
+
+    gs_url = new wxString(gs_server->GetURL());
+
+    gs_session = new wxWebSession(wxWebSession::New(wxWebSessionBackendCURL));
+    if ( !gs_session->IsOpened() )
+        return false;
+
+    if ( maxConnectionsPerHost &&
+            !gs_session->SetMaxConnectionsPerHost(maxConnectionsPerHost) )
+        return false;
+
+    if ( sharedCache && !gs_session->EnableSharedCache() )
+        return false;
+
+    gs_runner = new RequestRunner;
+
+    return true;
+}
+
+void DoneRequests()
+{
+    wxDELETE(gs_runner);
+    wxDELETE(gs_session);
+    wxDELETE(gs_url);
+    wxDELETE(gs_server);
+}
+
+// The numeric parameter is the number of requests made concurrently.
+bool RunRequests()
+{
+    return gs_runner->Run(*gs_session, *gs_url, Bench::GetNumericParameter());
+}
+
+} // anonymous namespace
+
+// ----------------------------------------------------------------------------
+// benchmarks
+// ----------------------------------------------------------------------------
+
+static bool InitDefault()
+{
+    return InitRequests(0, false);
+}
+
+BENCHMARK_FUNC_WITH_INIT(WebRequestDefault, InitDefault, DoneRequests)
+{
+    return RunRequests();
+}
+
+static bool InitSingleConnection()
+{
+    return InitRequests(1, true);
+}
+
+BENCHMARK_FUNC_WITH_INIT(WebRequestSingleConnection, InitSingleConnection,
+                         DoneRequests)
+{
+    return RunRequests();
+}
+
+static bool InitEightConnections()
+{
+    return InitRequests(8, true);
+}
+
+BENCHMARK_FUNC_WITH_INIT(WebRequest8Connections, InitEightConnections,
+                         DoneRequests)
+{
+    return RunRequests();
+}
+
+#endif // wxHAS_SOCKET_SERVER_POOL
+
+#endif // wxUSE_WEBREQUEST
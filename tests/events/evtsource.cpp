@@ -12,3 +12,384 @@
 // ----------------------------------------------------------------------------
 
 #include "testprec.h"
+
+#ifdef __UNIX__
+
+#include "wx/atomic.h"
+#include "wx/private/fdiodispatcher.h"
+#include "wx/private/selectdispatcher.h"
+#include "wx/unix/private/epolldispatcher.h"
+#include "wx/unix/private/iouringdispatcher.h"
+#include "wx/scopedptr.h"
+#include "wx/stopwatch.h"
+#include "wx/thread.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// ----------------------------------------------------------------------------
+// wxFDIODispatcher tests
+// ----------------------------------------------------------------------------
+
+namespace
+{
+
+class TestFDIOHandler : public wxFDIOHandler
+{
+public:
+    TestFDIOHandler() : m_reads(0), m_writes(0) { }
+
+    virtual void OnReadWaiting() wxOVERRIDE { m_reads++; }
+    virtual void OnWriteWaiting() wxOVERRIDE { m_writes++; }
+    virtual void OnExceptionWaiting() wxOVERRIDE { }
+
+    int m_reads,
+        m_writes;
+};
+
+// Handler unregistering another descriptor when it's notified.
+class UnregisteringHandler : public TestFDIOHandler
+{
+public:
+    UnregisteringHandler(wxFDIODispatcher& dispatcher, int fd)
+        : m_dispatcher(dispatcher), m_fd(fd)
+    {
+    }
+
+    virtual void OnReadWaiting() wxOVERRIDE
+    {
+        TestFDIOHandler::OnReadWaiting();
+        m_dispatcher.UnregisterFD(m_fd);
+    }
+
+private:
+    wxFDIODispatcher& m_dispatcher;
+    const int m_fd;
+};
+
+class Pipe
+{
+public:
+    Pipe()
+    {
+        REQUIRE( pipe(m_fds) == 0 );
+        fcntl(m_fds[0], F_SETFL, O_NONBLOCK);
+    }
+
+    ~Pipe()
+    {
+        close(m_fds[0]);
+        close(m_fds[1]);
+    }
+
+    int GetReadFD() const { return m_fds[0]; }
+    int GetWriteFD() const { return m_fds[1]; }
+
+    void Write() { REQUIRE( write(m_fds[1], "x", 1) == 1 ); }
+
+    void Drain()
+    {
+        char buf[16];
+        while ( read(m_fds[0], buf, sizeof(buf)) > 0 )
+            ;
+    }
+
+private:
+    int m_fds[2];
+};
+
+void TestDispatcher(wxFDIODispatcher& dispatcher, bool edgeTriggered)
+{
+    Pipe p;
+    TestFDIOHandler handler;
+
+    int flags = wxFDIO_INPUT;
+    if ( edgeTriggered )
+        flags |= wxFDIO_EDGE_TRIGGERED;
+
+    REQUIRE( dispatcher.RegisterFD(p.GetReadFD(), &handler, flags) );
+    CHECK( !dispatcher.HasPending() );
+    CHECK( dispatcher.Dispatch(0) == 0 );
+
+    p.Write();
+    CHECK( dispatcher.HasPending() );
+    CHECK( dispatcher.Dispatch(1000) == 1 );
+    CHECK( handler.m_reads == 1 );
+
+    // Without reading the data, we keep getting notifications in the level
+    // triggered mode, but not in the edge-triggered one.
+    CHECK( dispatcher.Dispatch(edgeTriggered ? 10 : 1000) == (edgeTriggered ? 0 : 1) );
+    CHECK( handler.m_reads == (edgeTriggered ? 1 : 2) );
+
+    // But we do get a notification when more data arrives.
+    p.Write();
+    CHECK( dispatcher.Dispatch(1000) == 1 );
+    handler.m_reads = 0;
+
+    p.Drain();
+    CHECK( !dispatcher.HasPending() );
+    CHECK( dispatcher.Dispatch(10) == 0 );
+
+    // Check that modifying the flags works.
+    REQUIRE( dispatcher.ModifyFD(p.GetReadFD(), &handler, wxFDIO_OUTPUT) );
+    CHECK( dispatcher.Dispatch(10) == 0 );
+    p.Write();
+    CHECK( dispatcher.Dispatch(10) == 0 );
+    CHECK( handler.m_reads == 0 );
+
+    REQUIRE( dispatcher.ModifyFD(p.GetReadFD(), &handler, flags) );
+    CHECK( dispatcher.Dispatch(1000) == 1 );
+    CHECK( handler.m_reads == 1 );
+
+    REQUIRE( dispatcher.UnregisterFD(p.GetReadFD()) );
+    p.Write();
+    CHECK( dispatcher.Dispatch(10) == 0 );
+    CHECK( handler.m_reads == 1 );
+}
+
+// Check that a handler unregistered by another one during the same dispatch
+// is not called.
+void TestUnregisterWhileDispatching(wxFDIODispatcher& dispatcher)
+{
+    Pipe p1, p2;
+    UnregisteringHandler h1(dispatcher, p2.GetReadFD());
+    UnregisteringHandler h2(dispatcher, p1.GetReadFD());
+
+    REQUIRE( dispatcher.RegisterFD(p1.GetReadFD(), &h1, wxFDIO_INPUT) );
+    REQUIRE( dispatcher.RegisterFD(p2.GetReadFD(), &h2, wxFDIO_INPUT) );
+
+    p1.Write();
+    p2.Write();
+
+    // Wait until both events are available to make sure that both of them
+    // are retrieved together.
+    wxMilliSleep(10);
+    CHECK( dispatcher.Dispatch(1000) == 1 );
+    CHECK( h1.m_reads + h2.m_reads == 1 );
+
+    // The handler which was called is still registered.
+    dispatcher.UnregisterFD(h1.m_reads ? p1.GetReadFD() : p2.GetReadFD());
+}
+
+// Check that registering the same descriptor again with different flags
+// works, as it's explicitly allowed.
+void TestReregister(wxFDIODispatcher& dispatcher)
+{
+    Pipe p;
+    TestFDIOHandler handler;
+
+    REQUIRE( dispatcher.RegisterFD(p.GetReadFD(), &handler, wxFDIO_OUTPUT) );
+    REQUIRE( dispatcher.RegisterFD(p.GetReadFD(), &handler, wxFDIO_INPUT) );
+
+    p.Write();
+    CHECK( dispatcher.Dispatch(1000) == 1 );
+    CHECK( handler.m_reads == 1 );
+
+    REQUIRE( dispatcher.UnregisterFD(p.GetReadFD()) );
+}
+
+#if wxUSE_THREADS
+
+// Handler reading all the available data and counting the bytes read.
+class DrainingHandler : public TestFDIOHandler
+{
+public:
+    DrainingHandler(int fd, wxAtomicInt& total) : m_fd(fd), m_total(total) { }
+
+    virtual void OnReadWaiting() wxOVERRIDE
+    {
+        char buf[16];
+        ssize_t n;
+        while ( (n = read(m_fd, buf, sizeof(buf))) > 0 )
+        {
+            for ( ssize_t i = 0; i < n; i++ )
+                wxAtomicInc(m_total);
+        }
+    }
+
+private:
+    const int m_fd;
+    wxAtomicInt& m_total;
+};
+
+// Thread dispatching the events until the expected number of bytes is read.
+class DispatchingThread : public wxThread
+{
+public:
+    DispatchingThread(wxFDIODispatcher& dispatcher,
+                      const wxAtomicInt& total,
+                      int expected)
+        : wxThread(wxTHREAD_JOINABLE),
+          m_dispatcher(dispatcher),
+          m_total(total),
+          m_expected(expected)
+    {
+    }
+
+protected:
+    virtual void *Entry() wxOVERRIDE
+    {
+        const wxMilliClock_t timeEnd = wxGetLocalTimeMillis() + 10000;
+        while ( m_total < m_expected && wxGetLocalTimeMillis() < timeEnd )
+        {
+            if ( m_dispatcher.HasPending() )
+                m_dispatcher.Dispatch(0);
+            else
+                m_dispatcher.Dispatch(10);
+        }
+
+        return NULL;
+    }
+
+private:
+    wxFDIODispatcher& m_dispatcher;
+    const wxAtomicInt& m_total;
+    const int m_expected;
+};
+
+// Check that the same dispatcher can be used from several threads at once,
+// as happens with the global one used by all the event loops.
+void TestMultipleThreads(wxFDIODispatcher& dispatcher)
+{
+    static const int NUM_PIPES = 8;
+    static const int NUM_THREADS = 4;
+    static const int NUM_WRITES = 100;
+
+    wxAtomicInt total = 0;
+
+    Pipe pipes[NUM_PIPES];
+    wxScopedPtr<DrainingHandler> handlers[NUM_PIPES];
+    for ( int n = 0; n < NUM_PIPES; n++ )
+    {
+        handlers[n].reset(new DrainingHandler(pipes[n].GetReadFD(), total));
+        REQUIRE( dispatcher.RegisterFD(pipes[n].GetReadFD(), handlers[n].get(),
+                                       wxFDIO_INPUT) );
+    }
+
+    const int expected = NUM_PIPES*NUM_WRITES;
+
+    DispatchingThread* threads[NUM_THREADS];
+    for ( int n = 0; n < NUM_THREADS; n++ )
+    {
+        threads[n] = new DispatchingThread(dispatcher, total, expected);
+        REQUIRE( threads[n]->Run() == wxTHREAD_NO_ERROR );
+    }
+
+    for ( int i = 0; i < NUM_WRITES; i++ )
+    {
+        for ( int n = 0; n < NUM_PIPES; n++ )
+            pipes[n].Write();
+    }
+
+    for ( int n = 0; n < NUM_THREADS; n++ )
+    {
+        threads[n]->Wait();
+        delete threads[n];
+    }
+
+    CHECK( total == expected );
+
+    for ( int n = 0; n < NUM_PIPES; n++ )
+        dispatcher.UnregisterFD(pipes[n].GetReadFD());
+}
+
+#endif // wxUSE_THREADS
+
+} // anonymous namespace
+
+#if wxUSE_SELECT_DISPATCHER
+
+TEST_CASE("wxSelectDispatcher", "[fdio]")
+{
+    wxSelectDispatcher dispatcher;
+    TestDispatcher(dispatcher, false);
+}
+
+#endif // wxUSE_SELECT_DISPATCHER
+
+#if wxUSE_EPOLL_DISPATCHER
+
+TEST_CASE("wxEpollDispatcher", "[fdio]")
+{
+    wxScopedPtr<wxEpollDispatcher> dispatcher(wxEpollDispatcher::Create());
+    REQUIRE( dispatcher );
+
+    SECTION("Level")
+    {
+        TestDispatcher(*dispatcher, false);
+    }
+
+    SECTION("Edge")
+    {
+        TestDispatcher(*dispatcher, true);
+    }
+
+    SECTION("SmallBatch")
+    {
+        dispatcher->SetBatchSize(1);
+        CHECK( dispatcher->GetBatchSize() == 1 );
+        TestDispatcher(*dispatcher, false);
+    }
+
+    SECTION("Unregister")
+    {
+        TestUnregisterWhileDispatching(*dispatcher);
+    }
+
+    SECTION("Reregister")
+    {
+        TestReregister(*dispatcher);
+    }
+
+#if wxUSE_THREADS
+    SECTION("Threads")
+    {
+        TestMultipleThreads(*dispatcher);
+    }
+#endif // wxUSE_THREADS
+}
+
+#endif // wxUSE_EPOLL_DISPATCHER
+
+#ifdef wxHAS_IO_URING_DISPATCHER
+
+TEST_CASE("wxIOUringDispatcher", "[fdio]")
+{
+    wxScopedPtr<wxIOUringDispatcher> dispatcher(wxIOUringDispatcher::Create());
+    if ( !dispatcher )
+    {
+        WARN("Skipping the test as io_uring is not available.");
+        return;
+    }
+
+    SECTION("Level")
+    {
+        TestDispatcher(*dispatcher, false);
+    }
+
+    SECTION("Edge")
+    {
+        TestDispatcher(*dispatcher, true);
+    }
+
+    SECTION("Unregister")
+    {
+        TestUnregisterWhileDispatching(*dispatcher);
+    }
+
+    SECTION("Reregister")
+    {
+        TestReregister(*dispatcher);
+    }
+
+#if wxUSE_THREADS
+    SECTION("Threads")
+    {
+        TestMultipleThreads(*dispatcher);
+    }
+#endif // wxUSE_THREADS
+}
+
+#endif // wxHAS_IO_URING_DISPATCHER
+
+#endif // __UNIX__
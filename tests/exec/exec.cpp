@@ -26,6 +26,7 @@
 #include "wx/scopeguard.h"
 #include "wx/txtstrm.h"
 #include "wx/timer.h"
+#include "wx/wfstream.h"
 
 #ifdef __UNIX__
     #define COMMAND "echo hi"
@@ -537,4 +538,104 @@ TEST_CASE("wxExecute::RedirectUTF8", "[exec][unicode][.]")
     FAIL("Expected output fragment not found.");
 }
 
+namespace
+{
+
+// Command writing more data than fits into a pipe buffer to stdout and a short
+// string to stderr.
+const char* const SINK_COMMAND =
+    "/bin/sh -c 'head -c 200000 /dev/zero; echo error >&2'";
+const size_t SINK_OUTPUT_SIZE = 200000;
+
+// Process checking that all the output was passed to the sink by the time it
+// terminates and exiting the event loop.
+class SinkAsyncProcess : public wxProcess
+{
+public:
+    SinkAsyncProcess() : m_outputSize(0), m_status(-1) { }
+
+    virtual void OnTerminate(int WXUNUSED(pid), int status) wxOVERRIDE
+    {
+        m_outputSize = m_sink.GetLength();
+        m_status = status;
+
+        wxEventLoop::GetActive()->ScheduleExit();
+    }
+
+    wxMemoryOutputStream m_sink;
+    size_t m_outputSize;
+    int m_status;
+};
+
+} // anonymous namespace
+
+TEST_CASE("wxExecute::OutputSink", "[exec]")
+{
+    SECTION("Memory")
+    {
+        wxMemoryOutputStream out,
+                             err;
+
+        wxProcess proc;
+        proc.SetOutputSink(&out, &err);
+        CHECK( proc.IsRedirected() );
+
+        REQUIRE( wxExecute(SINK_COMMAND, wxEXEC_SYNC, &proc) == 0 );
+        CHECK( !proc.GetInputStream() );
+        CHECK( !proc.GetErrorStream() );
+        CHECK( out.GetLength() == SINK_OUTPUT_SIZE );
+        CHECK( err.GetLength() == 6 );
+    }
+
+    SECTION("NoEvents")
+    {
+        wxMemoryOutputStream out;
+
+        wxProcess proc;
+        proc.SetOutputSink(&out);
+
+        REQUIRE( wxExecute(SINK_COMMAND, wxEXEC_SYNC | wxEXEC_NOEVENTS,
+                           &proc) == 0 );
+        CHECK( out.GetLength() == SINK_OUTPUT_SIZE );
+
+        // The error stream is still available in the usual way.
+        REQUIRE( proc.GetErrorStream() );
+        wxStringOutputStream err;
+        proc.GetErrorStream()->Read(err);
+        CHECK( err.GetString() == "error\n" );
+    }
+
+    SECTION("File")
+    {
+        const wxString filename = wxFileName::CreateTempFileName("wxexec");
+        wxON_BLOCK_EXIT1( wxRemoveFile, filename );
+
+        {
+            wxFileOutputStream out(filename);
+            REQUIRE( out.IsOk() );
+
+            wxProcess proc;
+            proc.SetOutputSink(&out);
+
+            REQUIRE( wxExecute(SINK_COMMAND, wxEXEC_SYNC, &proc) == 0 );
+        }
+
+        CHECK( wxFileName::GetSize(filename) == SINK_OUTPUT_SIZE );
+    }
+
+    SECTION("Async")
+    {
+        SinkAsyncProcess proc;
+        proc.SetOutputSink(&proc.m_sink);
+
+        wxEventLoop loop;
+        REQUIRE( wxExecute(SINK_COMMAND, wxEXEC_ASYNC, &proc) );
+
+        loop.Run();
+
+        CHECK( proc.m_status == 0 );
+        CHECK( proc.m_outputSize == SINK_OUTPUT_SIZE );
+    }
+}
+
 #endif // __UNIX__
@@ -21,8 +21,12 @@
 
 #if wxUSE_FILESYSTEM
 
+#include "wx/fs_arc.h"
 #include "wx/fs_mem.h"
+#include "wx/mstream.h"
 #include "wx/scopedptr.h"
+#include "wx/tarstrm.h"
+#include "wx/zipstrm.h"
 
 // ----------------------------------------------------------------------------
 // helpers
@@ -176,28 +180,33 @@ TEST_CASE("wxFileSystem::UnicodeFileNameToUrlConversion", "[filesys][url][filena
     CHECK( filename.SameAs(wxFileName::URLToFileName(url)) );
 }
 
+// Install a file system handler just for the duration of a test.
+template <class T>
+class AutoFSHandler
+{
+public:
+    AutoFSHandler()
+        : m_handler(new T())
+    {
+        wxFileSystem::AddHandler(m_handler.get());
+    }
+
+    ~AutoFSHandler()
+    {
+        wxFileSystem::RemoveHandler(m_handler.get());
+    }
+
+private:
+    wxScopedPtr<T> const m_handler;
+};
+
+typedef AutoFSHandler<wxMemoryFSHandler> AutoMemoryFSHandler;
+
 // Test that using FindFirst() after removing a previously found URL works:
 // this used to be broken, see https://trac.wxwidgets.org/ticket/18744
 TEST_CASE("wxFileSystem::MemoryFSHandler", "[filesys][memoryfshandler][find]")
 {
-    // Install wxMemoryFSHandler just for the duration of this test.
-    class AutoMemoryFSHandler
-    {
-    public:
-        AutoMemoryFSHandler()
-            : m_handler(new wxMemoryFSHandler())
-        {
-            wxFileSystem::AddHandler(m_handler.get());
-        }
-
-        ~AutoMemoryFSHandler()
-        {
-            wxFileSystem::RemoveHandler(m_handler.get());
-        }
-
-    private:
-        wxScopedPtr<wxMemoryFSHandler> const m_handler;
-    } autoMemoryFSHandler;
+    AutoMemoryFSHandler autoMemoryFSHandler;
 
     wxMemoryFSHandler::AddFile("foo.txt", "foo contents");
     wxMemoryFSHandler::AddFile("bar.txt", "bar contents");
@@ -224,4 +233,116 @@ TEST_CASE("wxFileSystem::MemoryFSHandler", "[filesys][memoryfshandler][find]")
     CHECK( fs.FindNext() == "" );
 }
 
+TEST_CASE("wxFileSystem::MemoryFSHandlerLimit", "[filesys][memoryfshandler]")
+{
+    AutoMemoryFSHandler autoMemoryFSHandler;
+
+    wxMemoryFSHandler::ResetStatistics();
+    wxMemoryFSHandler::SetMaxSize(10);
+
+    wxMemoryFSHandler::AddFile("1", "1234");
+    wxMemoryFSHandler::AddFile("2", "1234");
+
+    wxFileSystem fs;
+
+    // Open the first file to make it the most recently used one and keep the
+    // stream to check that it's still usable after the file is removed.
+    wxScopedPtr<wxFSFile> f(fs.OpenFile("memory:1"));
+    REQUIRE( f );
+
+    CHECK( !fs.OpenFile("memory:nonexistent") );
+
+    wxMemoryFSHandler::AddFile("3", "1234");
+
+    wxMemoryFSStatistics stats = wxMemoryFSHandler::GetStatistics();
+    CHECK( stats.hits == 1 );
+    CHECK( stats.misses == 1 );
+    CHECK( stats.evictions == 1 );
+    CHECK( stats.filesCount == 2 );
+    CHECK( stats.totalSize == 8 );
+
+    CHECK( fs.FindFirst("memory:2") == "" );
+    CHECK( fs.FindFirst("memory:1") == "memory:1" );
+    CHECK( fs.FindFirst("memory:3") == "memory:3" );
+
+    // Adding a file bigger than the limit removes all the other ones.
+    wxMemoryFSHandler::AddFile("4", "12345678901");
+    CHECK( fs.FindFirst("memory:*") == "memory:4" );
+    CHECK( fs.FindNext() == "" );
+
+    stats = wxMemoryFSHandler::GetStatistics();
+    CHECK( stats.evictions == 3 );
+    CHECK( stats.filesCount == 1 );
+    CHECK( stats.totalSize == 11 );
+
+    char buf[5] = { 0 };
+    CHECK( f->GetStream()->Read(buf, 4).LastRead() == 4 );
+    CHECK( wxString(buf) == "1234" );
+    f.reset();
+
+    wxMemoryFSHandler::SetMaxSize(0);
+    wxMemoryFSHandler::RemoveFile("4");
+
+    CHECK( wxMemoryFSHandler::GetStatistics().totalSize == 0 );
+}
+
+#if wxUSE_FS_ARCHIVE && wxUSE_ZIPSTREAM && wxUSE_TARSTREAM
+
+namespace
+{
+
+// Adds an archive containing "dup.txt" twice, with different contents, to the
+// memory file system.
+void AddArchiveWithDuplicates(const wxString& filename,
+                              const wxArchiveClassFactory& factory)
+{
+    wxMemoryOutputStream mo;
+    {
+        wxScopedPtr<wxArchiveOutputStream> arc(factory.NewStream(mo));
+        REQUIRE( arc->PutNextEntry("dup.txt", wxDateTime::Now(), 5) );
+        REQUIRE( arc->WriteAll("first", 5) );
+        REQUIRE( arc->PutNextEntry("dup.txt", wxDateTime::Now(), 6) );
+        REQUIRE( arc->WriteAll("second", 6) );
+        REQUIRE( arc->Close() );
+    }
+
+    wxMemoryFSHandler::AddFile(filename,
+                               mo.GetOutputStreamBuffer()->GetBufferStart(),
+                               mo.GetSize());
+}
+
+wxString ReadFSFile(wxFileSystem& fs, const wxString& url)
+{
+    wxScopedPtr<wxFSFile> f(fs.OpenFile(url));
+    if ( !f )
+        return "<not found>";
+
+    char buf[16] = { 0 };
+    f->GetStream()->Read(buf, sizeof(buf) - 1);
+    return buf;
+}
+
+} // anonymous namespace
+
+TEST_CASE("wxFileSystem::ArchiveFSHandler", "[filesys][archive]")
+{
+    AutoMemoryFSHandler autoMemoryFSHandler;
+    AutoFSHandler<wxArchiveFSHandler> autoArchiveFSHandler;
+
+    AddArchiveWithDuplicates("dup.zip", wxZipClassFactory());
+    AddArchiveWithDuplicates("dup.tar", wxTarClassFactory());
+
+    wxFileSystem fs;
+
+    // As with a sequential search, the first of the duplicates is found,
+    // whether the zip central directory index is used or not.
+    CHECK( ReadFSFile(fs, "memory:dup.zip#zip:dup.txt") == "first" );
+    CHECK( ReadFSFile(fs, "memory:dup.tar#tar:dup.txt") == "first" );
+
+    wxMemoryFSHandler::RemoveFile("dup.zip");
+    wxMemoryFSHandler::RemoveFile("dup.tar");
+}
+
+#endif // wxUSE_FS_ARCHIVE && wxUSE_ZIPSTREAM && wxUSE_TARSTREAM
+
 #endif // wxUSE_FILESYSTEM
@@ -605,6 +605,190 @@ TEST_CASE_METHOD(FileSystemWatcherTestCase,
     EventTester tester;
     tester.Run();
 }
+
+// ----------------------------------------------------------------------------
+// TestCoalescing: several changes to the same file result in a single event
+// ----------------------------------------------------------------------------
+
+TEST_CASE_METHOD(FileSystemWatcherTestCase,
+                 "wxFileSystemWatcher::Coalescing", "[fsw]")
+{
+    class EventTester : public FSWTesterBase
+    {
+    public:
+        virtual bool Init() wxOVERRIDE
+        {
+            REQUIRE(FSWTesterBase::Init());
+
+            return m_watcher->SetCoalescingDelay(100);
+        }
+
+        virtual void GenerateEvent() wxOVERRIDE
+        {
+            CHECK(eg.CreateFile());
+            CHECK(eg.ModifyFile());
+            CHECK(eg.ModifyFile());
+            CHECK(eg.TouchFile());
+        }
+
+        virtual wxFileSystemWatcherEvent ExpectedEvent() wxOVERRIDE
+        {
+            wxFileSystemWatcherEvent event(wxFSW_EVENT_CREATE);
+            event.SetPath(eg.m_file);
+            event.SetNewPath(eg.m_file);
+            return event;
+        }
+    };
+
+    EventTester tester;
+    tester.Run();
+}
+
+// ----------------------------------------------------------------------------
+// TestBatching: all changes are delivered in a single event
+// ----------------------------------------------------------------------------
+
+TEST_CASE_METHOD(FileSystemWatcherTestCase,
+                 "wxFileSystemWatcher::Batching", "[fsw]")
+{
+    class EventTester : public FSWTesterBase
+    {
+    public:
+        virtual bool Init() wxOVERRIDE
+        {
+            REQUIRE(FSWTesterBase::Init());
+
+            return m_watcher->SetCoalescingDelay(100) &&
+                        m_watcher->EnableBatching();
+        }
+
+        virtual void GenerateEvent() wxOVERRIDE
+        {
+            CHECK(eg.CreateFile());
+            CHECK(eg.ModifyFile());
+            CHECK(eg.RenameFile());
+        }
+
+        virtual void CheckResult() wxOVERRIDE
+        {
+            REQUIRE( m_events.size() == 1 );
+
+            const wxFileSystemWatcherEvent* const e = m_events.front();
+            CHECK( e->GetChangeType() == wxFSW_EVENT_BATCH );
+
+            const wxFileSystemWatcherChanges& changes = e->GetChanges();
+            REQUIRE( changes.size() == 2 );
+
+            CHECK( changes[0].GetChangeType() == wxFSW_EVENT_CREATE );
+            CHECK( changes[0].GetPath() == eg.m_old );
+
+            CHECK( changes[1].GetChangeType() == wxFSW_EVENT_RENAME );
+            CHECK( changes[1].GetPath() == eg.m_old );
+            CHECK( changes[1].GetNewPath() == eg.m_file );
+
+            delete e;
+        }
+
+        virtual wxFileSystemWatcherEvent ExpectedEvent() wxOVERRIDE
+        {
+            FAIL( "Shouldn't be called" );
+
+            return wxFileSystemWatcherEvent(wxFSW_EVENT_ERROR);
+        }
+    };
+
+    EventTester tester;
+    tester.Run();
+}
+
+// ----------------------------------------------------------------------------
+// TestOverflowRecovery: directories created during overflow are watched
+// ----------------------------------------------------------------------------
+
+TEST_CASE_METHOD(FileSystemWatcherTestCase,
+                 "wxFileSystemWatcher::OverflowRecovery", "[fsw]")
+{
+    class EventTester : public FSWTesterBase
+    {
+    public:
+        virtual bool Init() wxOVERRIDE
+        {
+            m_watcher.reset(new wxFileSystemWatcher());
+            m_watcher->SetOwner(this);
+
+            // Use a long delay to ensure all the events are read before the
+            // timer expires: the pairs of creation and deletion events
+            // generated below cancel out and are not delivered at all then.
+            CHECK(m_watcher->SetCoalescingDelay(5000));
+            CHECK(m_watcher->EnableBatching());
+            CHECK(m_watcher->EnableOverflowRecovery());
+
+            return m_watcher->AddTree(EventGenerator::GetWatchDir());
+        }
+
+        virtual void GenerateEvent() wxOVERRIDE
+        {
+            // Generate more events than can be queued by the kernel.
+            long maxEvents = 16384;
+            wxFile("/proc/sys/fs/inotify/max_queued_events").
+                ReadAll(&m_maxEvents);
+            m_maxEvents.Trim().ToLong(&maxEvents);
+
+            for ( long n = 0; n < maxEvents; n += 2 )
+            {
+                REQUIRE(eg.CreateFile());
+                REQUIRE(wxRemoveFile(eg.m_file.GetFullPath()));
+            }
+
+            // The event about creating this directory must be lost.
+            m_newDir = EventGenerator::GetWatchDir();
+            m_newDir.AppendDir("newdir");
+            REQUIRE(m_newDir.Mkdir());
+        }
+
+        virtual void CheckResult() wxOVERRIDE
+        {
+            // The changes preceding the overflow may or may not be reported,
+            // depending on where exactly the kernel queue was cut, but the
+            // last batch must contain the creation of the new directory and be
+            // followed by the overflow warning.
+            REQUIRE( m_events.size() >= 2 );
+
+            const wxFileSystemWatcherEvent* const e = m_events[m_events.size() - 2];
+            CHECK( e->GetChangeType() == wxFSW_EVENT_BATCH );
+
+            const wxFileSystemWatcherChanges& changes = e->GetChanges();
+            REQUIRE( changes.size() == 1 );
+            CHECK( changes[0].GetChangeType() == wxFSW_EVENT_CREATE );
+            CHECK( changes[0].GetPath() == m_newDir );
+
+            const wxFileSystemWatcherEvent* const w = m_events.back();
+            CHECK( w->GetChangeType() == wxFSW_EVENT_WARNING );
+            CHECK( w->GetWarningType() == wxFSW_WARNING_OVERFLOW );
+            CHECK( w->GetPath() == EventGenerator::GetWatchDir() );
+
+            // The new directory is watched now.
+            CHECK( m_watcher->GetWatchedPathsCount() == 2 );
+
+            for ( size_t n = 0; n < m_events.size(); n++ )
+                delete m_events[n];
+        }
+
+        virtual wxFileSystemWatcherEvent ExpectedEvent() wxOVERRIDE
+        {
+            FAIL( "Shouldn't be called" );
+
+            return wxFileSystemWatcherEvent(wxFSW_EVENT_ERROR);
+        }
+
+    private:
+        wxString m_maxEvents;
+        wxFileName m_newDir;
+    };
+
+    EventTester tester;
+    tester.Run();
+}
 #endif // wxHAS_INOTIFY
 
 // ----------------------------------------------------------------------------
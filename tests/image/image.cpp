@@ -20,6 +20,7 @@
 #endif // WX_PRECOMP
 
 #include "wx/anidecod.h" // wxImageArray
+#include "wx/gifdecod.h"
 #include "wx/palette.h"
 #include "wx/url.h"
 #include "wx/log.h"
@@ -28,6 +29,12 @@
 #include "wx/wfstream.h"
 #include "wx/clipbrd.h"
 #include "wx/dataobj.h"
+#include "wx/math.h"
+#include "wx/quantize.h"
+#include "wx/scopedarray.h"
+#include "wx/scopedptr.h"
+#include "wx/thread.h"
+#include "wx/private/image.h"
 
 #include "testimage.h"
 
@@ -2108,6 +2115,1780 @@ TEST_CASE("wxImage::InitAlpha", "[image][initalpha]")
     }
 }
 
+// Straightforward implementation of the box blur in one direction, with the
+// pixels outside of the image replaced by the closest edge pixels.
+static wxImage BlurReference(const wxImage& image, int radius, bool horz)
+{
+    const int width = image.GetWidth(),
+              height = image.GetHeight();
+
+    wxImage result(width, height);
+    if ( image.HasAlpha() )
+        result.SetAlpha();
+
+    for ( int y = 0; y < height; y++ )
+    {
+        for ( int x = 0; x < width; x++ )
+        {
+            int r = 0, g = 0, b = 0, a = 0;
+            for ( int i = -radius; i <= radius; i++ )
+            {
+                const int px = horz ? wxMin(wxMax(x + i, 0), width - 1) : x;
+                const int py = horz ? y : wxMin(wxMax(y + i, 0), height - 1);
+
+                r += image.GetRed(px, py);
+                g += image.GetGreen(px, py);
+                b += image.GetBlue(px, py);
+                if ( image.HasAlpha() )
+                    a += image.GetAlpha(px, py);
+            }
+
+            const int area = 2*radius + 1;
+            result.SetRGB(x, y, r / area, g / area, b / area);
+            if ( image.HasAlpha() )
+                result.SetAlpha(x, y, a / area);
+        }
+    }
+
+    return result;
+}
+
+TEST_CASE("wxImage::Blur", "[image][blur]")
+{
+    wxImage image(37, 23);
+    image.SetAlpha();
+    for ( int y = 0; y < image.GetHeight(); y++ )
+    {
+        for ( int x = 0; x < image.GetWidth(); x++ )
+        {
+            image.SetRGB(x, y, (x*37 + y*11) % 256, (x*y*5) % 256, (x ^ y)*7);
+            image.SetAlpha(x, y, (x*y + 3*x) % 256);
+        }
+    }
+
+    // Notice that the radius must be less than the image size.
+    const int radii[] = { 0, 1, 3, 10, 22 };
+    for ( unsigned n = 0; n < WXSIZEOF(radii); n++ )
+    {
+        const int radius = radii[n];
+        INFO("Radius " << radius);
+
+        const wxImage horz = BlurReference(image, radius, true);
+        CHECK_THAT( image.BlurHorizontal(radius), RGBASameAs(horz) );
+        CHECK_THAT( image.BlurVertical(radius),
+                    RGBASameAs(BlurReference(image, radius, false)) );
+        CHECK_THAT( image.Blur(radius),
+                    RGBASameAs(BlurReference(horz, radius, false)) );
+    }
+
+    SECTION("Without alpha")
+    {
+        image.ClearAlpha();
+        CHECK_THAT( image.Blur(5),
+                    RGBASameAs(BlurReference(BlurReference(image, 5, true),
+                                             5, false)) );
+    }
+}
+
+TEST_CASE("wxImage::GaussianBlur", "[image][blur]")
+{
+    SECTION("Uniform image")
+    {
+        wxImage image(50, 30);
+        image.SetRGB(wxRect(0, 0, 50, 30), 10, 200, 255);
+        image.SetAlpha();
+        memset(image.GetAlpha(), 128, 50*30);
+
+        CHECK_THAT( image.GaussianBlur(7.5), RGBASameAs(image) );
+    }
+
+    SECTION("Single point")
+    {
+        // Blurring a single bright pixel must give a symmetric result.
+        wxImage image(61, 61);
+        image.SetRGB(30, 30, 255, 255, 255);
+
+        const wxImage blurred = image.GaussianBlur(4);
+        REQUIRE( blurred.IsOk() );
+
+        const int centre = blurred.GetRed(30, 30);
+        CHECK( centre > 0 );
+        CHECK( centre < 255 );
+
+        for ( int d = 1; d < 30; d++ )
+        {
+            INFO("Distance " << d);
+
+            const int value = blurred.GetRed(30 + d, 30);
+            CHECK( value <= blurred.GetRed(30 + d - 1, 30) );
+            CHECK( blurred.GetRed(30 - d, 30) == value );
+
+            // The vertical values are not exactly the same due to rounding
+            // of the intermediate results.
+            const int valueVert = blurred.GetGreen(30, 30 + d);
+            CHECK( blurred.GetBlue(30, 30 - d) == valueVert );
+            CHECK( abs(valueVert - value) <= 1 );
+        }
+
+        CHECK( blurred.GetRed(0, 0) == 0 );
+    }
+
+    SECTION("Zero sigma")
+    {
+        wxImage image(10, 10);
+        image.SetRGB(3, 4, 1, 2, 3);
+
+        CHECK_THAT( image.GaussianBlur(0), RGBASameAs(image) );
+    }
+}
+
+TEST_CASE("wxImage::PixelFormat", "[image][pixelformat]")
+{
+    // Use odd width to test the conversion of the last pixels of each row.
+    wxImage image(37, 23);
+    image.SetAlpha();
+    for ( int y = 0; y < image.GetHeight(); y++ )
+    {
+        for ( int x = 0; x < image.GetWidth(); x++ )
+        {
+            image.SetRGB(x, y, (x*37 + y*11) % 256, (x*y*5) % 256, (x ^ y)*7);
+            image.SetAlpha(x, y, y == 1 ? 255 : (x*y + 3*x) % 256);
+        }
+    }
+
+    const wxImage orig = image.Copy();
+    const int width = image.GetWidth();
+
+    CHECK( image.GetPixelFormat() == wxIMAGE_PIXEL_FORMAT_RGB );
+    CHECK( image.GetPixels() == NULL );
+
+    SECTION("RGBA")
+    {
+        REQUIRE( image.SetPixelFormat(wxIMAGE_PIXEL_FORMAT_RGBA) );
+        CHECK( image.GetPixelFormat() == wxIMAGE_PIXEL_FORMAT_RGBA );
+        CHECK( image.HasAlpha() );
+
+        const unsigned char* const p = image.GetPixels() + 4*(5*width + 7);
+        CHECK( p[0] == orig.GetRed(7, 5) );
+        CHECK( p[1] == orig.GetGreen(7, 5) );
+        CHECK( p[2] == orig.GetBlue(7, 5) );
+        CHECK( p[3] == orig.GetAlpha(7, 5) );
+
+        // Accessing RGB data converts the image back to RGB format.
+        CHECK_THAT( image, RGBASameAs(orig) );
+        CHECK( image.GetPixelFormat() == wxIMAGE_PIXEL_FORMAT_RGB );
+        CHECK( image.GetPixels() == NULL );
+    }
+
+    SECTION("Premultiplied ARGB32")
+    {
+        REQUIRE( image.SetPixelFormat(wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED) );
+
+        int mismatches = 0;
+        const wxUint32* const
+            pixels = reinterpret_cast<wxUint32*>(image.GetPixels());
+        for ( int y = 0; y < orig.GetHeight(); y++ )
+        {
+            for ( int x = 0; x < width; x++ )
+            {
+                const unsigned a = orig.GetAlpha(x, y);
+                const wxUint32 expected = a << 24 |
+                                          (orig.GetRed(x, y)*a + 127)/255 << 16 |
+                                          (orig.GetGreen(x, y)*a + 127)/255 << 8 |
+                                          (orig.GetBlue(x, y)*a + 127)/255;
+                if ( pixels[y*width + x] != expected )
+                    mismatches++;
+            }
+        }
+        CHECK( mismatches == 0 );
+
+        // Converting from RGBA must give the same result.
+        wxImage viaRGBA = orig.Copy();
+        REQUIRE( viaRGBA.SetPixelFormat(wxIMAGE_PIXEL_FORMAT_RGBA) );
+        REQUIRE( viaRGBA.SetPixelFormat(wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED) );
+        CHECK( memcmp(viaRGBA.GetPixels(), pixels, 4*width*orig.GetHeight()) == 0 );
+
+        // Converting back is lossless only for the opaque pixels.
+        REQUIRE( image.SetPixelFormat(wxIMAGE_PIXEL_FORMAT_RGB) );
+        REQUIRE( image.HasAlpha() );
+        mismatches = 0;
+        for ( int y = 0; y < orig.GetHeight(); y++ )
+        {
+            for ( int x = 0; x < width; x++ )
+            {
+                const int a = orig.GetAlpha(x, y);
+                if ( image.GetAlpha(x, y) != a )
+                    mismatches++;
+
+                if ( a == 0 )
+                    continue;
+
+                const int diff = wxMax(abs(image.GetRed(x, y) - orig.GetRed(x, y)),
+                                 wxMax(abs(image.GetGreen(x, y) - orig.GetGreen(x, y)),
+                                       abs(image.GetBlue(x, y) - orig.GetBlue(x, y))));
+                // The error is at most 255/(2a) because of rounding when
+                // premultiplying plus 1 because of truncation when undoing it.
+                if ( 2*a*diff > 255 + 2*a )
+                    mismatches++;
+            }
+        }
+        CHECK( mismatches == 0 );
+    }
+
+    SECTION("Unpremultiply")
+    {
+        // Check all valid combinations of colour and alpha values.
+        wxImage all;
+        REQUIRE( all.Create(256, 256, wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED) );
+
+        wxUint32* const pixels = reinterpret_cast<wxUint32*>(all.GetPixels());
+        for ( wxUint32 a = 0; a < 256; a++ )
+        {
+            for ( wxUint32 c = 0; c <= a; c++ )
+                pixels[a*256 + c] = a << 24 | c << 16 | c << 8 | c;
+        }
+
+        REQUIRE( all.SetPixelFormat(wxIMAGE_PIXEL_FORMAT_RGBA) );
+
+        int mismatches = 0;
+        const unsigned char* const p = all.GetPixels();
+        for ( unsigned a = 1; a < 256; a++ )
+        {
+            for ( unsigned c = 0; c <= a; c++ )
+            {
+                // This must be the same as wxGraphicsContext used to do.
+                const unsigned expected = c*255/a;
+                const unsigned char* const q = p + 4*(a*256 + c);
+                if ( q[0] != expected || q[2] != expected || q[3] != a )
+                    mismatches++;
+            }
+        }
+        CHECK( mismatches == 0 );
+    }
+
+    SECTION("Without alpha")
+    {
+        image.ClearAlpha();
+        REQUIRE( image.SetPixelFormat(wxIMAGE_PIXEL_FORMAT_RGBA) );
+        CHECK( image.GetPixels()[4*(3*width + 5) + 3] == wxIMAGE_ALPHA_OPAQUE );
+
+        // The alpha channel is always kept when converting back to RGB.
+        CHECK( image.GetRed(5, 3) == orig.GetRed(5, 3) );
+        CHECK( image.GetPixelFormat() == wxIMAGE_PIXEL_FORMAT_RGB );
+        CHECK( image.HasAlpha() );
+        CHECK( image.GetAlpha(5, 3) == wxIMAGE_ALPHA_OPAQUE );
+    }
+
+    SECTION("Shared data")
+    {
+        wxImage copy = image;
+        REQUIRE( copy.SetPixelFormat(wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED) );
+        CHECK( image.GetPixelFormat() == wxIMAGE_PIXEL_FORMAT_RGB );
+
+        // Modifying the packed image must not affect the images sharing it.
+        wxImage copy2 = copy;
+        copy.SetRGB(10, 1, 1, 2, 3);
+        CHECK( copy2.GetPixelFormat() == wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED );
+        CHECK( copy2.GetRed(10, 1) == orig.GetRed(10, 1) );
+        CHECK( copy.GetRed(10, 1) == 1 );
+
+        // But just reading the pixels converts the shared data without
+        // unsharing it.
+        wxImage copy3 = copy2;
+        CHECK( copy3.GetRed(10, 1) == orig.GetRed(10, 1) );
+        CHECK( copy3.GetPixelFormat() == wxIMAGE_PIXEL_FORMAT_RGB );
+        CHECK( copy2.GetPixelFormat() == wxIMAGE_PIXEL_FORMAT_RGB );
+        CHECK( copy3.IsSameAs(copy2) );
+    }
+
+    SECTION("Create")
+    {
+        wxImage packed;
+        REQUIRE( packed.Create(10, 5, wxIMAGE_PIXEL_FORMAT_RGBA) );
+        CHECK( packed.GetPixelFormat() == wxIMAGE_PIXEL_FORMAT_RGBA );
+        CHECK( packed.GetPixels()[4*12 + 3] == wxIMAGE_ALPHA_TRANSPARENT );
+        CHECK( packed.GetAlpha(2, 1) == wxIMAGE_ALPHA_TRANSPARENT );
+    }
+}
+
+// Create an image with alpha filled with some non-uniform pattern.
+static wxImage CreateRotateTestImage(int width, int height)
+{
+    wxImage image(width, height);
+    image.SetAlpha();
+    for ( int y = 0; y < height; y++ )
+    {
+        for ( int x = 0; x < width; x++ )
+        {
+            image.SetRGB(x, y, (x*37 + y*11) % 256, (x*y*5) % 256, (x ^ y)*7);
+            image.SetAlpha(x, y, (x*y + 3*x) % 256);
+        }
+    }
+
+    return image;
+}
+
+enum FlipReferenceKind
+{
+    Flip_Rotate90,
+    Flip_Rotate90CCW,
+    Flip_Rotate180,
+    Flip_MirrorHorz,
+    Flip_MirrorVert
+};
+
+// Straightforward implementation of the rotations by multiples of 90 degrees
+// and mirroring copying one pixel at a time.
+static wxImage FlipReference(const wxImage& image, FlipReferenceKind kind)
+{
+    const int width = image.GetWidth(),
+              height = image.GetHeight();
+
+    const bool swap = kind == Flip_Rotate90 || kind == Flip_Rotate90CCW;
+    wxImage result(swap ? height : width, swap ? width : height);
+    if ( image.HasAlpha() )
+        result.SetAlpha();
+
+    for ( int y = 0; y < result.GetHeight(); y++ )
+    {
+        for ( int x = 0; x < result.GetWidth(); x++ )
+        {
+            int sx = x, sy = y;
+            switch ( kind )
+            {
+                case Flip_Rotate90:
+                    sx = y;
+                    sy = height - 1 - x;
+                    break;
+
+                case Flip_Rotate90CCW:
+                    sx = width - 1 - y;
+                    sy = x;
+                    break;
+
+                case Flip_Rotate180:
+                    sx = width - 1 - x;
+                    sy = height - 1 - y;
+                    break;
+
+                case Flip_MirrorHorz:
+                    sx = width - 1 - x;
+                    break;
+
+                case Flip_MirrorVert:
+                    sy = height - 1 - y;
+                    break;
+            }
+
+            result.SetRGB(x, y, image.GetRed(sx, sy),
+                                image.GetGreen(sx, sy),
+                                image.GetBlue(sx, sy));
+            if ( image.HasAlpha() )
+                result.SetAlpha(x, y, image.GetAlpha(sx, sy));
+        }
+    }
+
+    return result;
+}
+
+static void CheckFlips(const wxImage& image)
+{
+    CHECK_THAT( image.Rotate90(),
+                RGBASameAs(FlipReference(image, Flip_Rotate90)) );
+    CHECK_THAT( image.Rotate90(false),
+                RGBASameAs(FlipReference(image, Flip_Rotate90CCW)) );
+    CHECK_THAT( image.Rotate180(),
+                RGBASameAs(FlipReference(image, Flip_Rotate180)) );
+    CHECK_THAT( image.Mirror(),
+                RGBASameAs(FlipReference(image, Flip_MirrorHorz)) );
+    CHECK_THAT( image.Mirror(false),
+                RGBASameAs(FlipReference(image, Flip_MirrorVert)) );
+}
+
+TEST_CASE("wxImage::Rotate90", "[image][rotate]")
+{
+    SECTION("Small")
+    {
+        // Use the size which is not a multiple of the tile size used by the
+        // implementation.
+        CheckFlips(CreateRotateTestImage(150, 77));
+    }
+
+    SECTION("Without alpha")
+    {
+        wxImage image = CreateRotateTestImage(41, 97);
+        image.ClearAlpha();
+        CheckFlips(image);
+    }
+
+    SECTION("Single row")
+    {
+        CheckFlips(CreateRotateTestImage(35, 1));
+        CheckFlips(CreateRotateTestImage(1, 35));
+    }
+
+    SECTION("Big")
+    {
+        // This image is big enough to be processed by several threads.
+        CheckFlips(CreateRotateTestImage(701, 403));
+    }
+
+    SECTION("Hotspot")
+    {
+        wxImage image = CreateRotateTestImage(20, 10);
+        image.SetOption(wxIMAGE_OPTION_CUR_HOTSPOT_X, 3);
+        image.SetOption(wxIMAGE_OPTION_CUR_HOTSPOT_Y, 2);
+
+        wxImage rotated = image.Rotate90();
+        CHECK( rotated.GetOptionInt(wxIMAGE_OPTION_CUR_HOTSPOT_X) == 7 );
+        CHECK( rotated.GetOptionInt(wxIMAGE_OPTION_CUR_HOTSPOT_Y) == 3 );
+
+        rotated = image.Rotate90(false);
+        CHECK( rotated.GetOptionInt(wxIMAGE_OPTION_CUR_HOTSPOT_X) == 2 );
+        CHECK( rotated.GetOptionInt(wxIMAGE_OPTION_CUR_HOTSPOT_Y) == 16 );
+
+        rotated = image.Rotate180();
+        CHECK( rotated.GetOptionInt(wxIMAGE_OPTION_CUR_HOTSPOT_X) == 16 );
+        CHECK( rotated.GetOptionInt(wxIMAGE_OPTION_CUR_HOTSPOT_Y) == 7 );
+    }
+}
+
+// Reference implementation of the rotation by an arbitrary angle computing
+// the source point of each pixel independently in floating point. Returns
+// the offset of the rotated image in the output parameter.
+static wxImage
+RotateReference(const wxImage& image, double angle, const wxPoint& centre,
+                bool interpolating, wxPoint& offset)
+{
+    const int w = image.GetWidth(),
+              h = image.GetHeight();
+
+    const double c = cos(-angle),
+                 s = sin(-angle);
+
+    // Find the bounding box of the rotated image corners.
+    double xMin = 0, yMin = 0, xMax = 0, yMax = 0;
+    for ( int n = 0; n < 4; n++ )
+    {
+        const double dx = (n & 1 ? w : 0) - centre.x,
+                     dy = (n & 2 ? h : 0) - centre.y;
+        const double x = centre.x + dx*c - dy*s,
+                     y = centre.y + dy*c + dx*s;
+        if ( n == 0 || x < xMin ) xMin = x;
+        if ( n == 0 || x > xMax ) xMax = x;
+        if ( n == 0 || y < yMin ) yMin = y;
+        if ( n == 0 || y > yMax ) yMax = y;
+    }
+
+    offset = wxPoint(static_cast<int>(floor(xMin)),
+                     static_cast<int>(floor(yMin)));
+
+    wxImage result(static_cast<int>(ceil(xMax)) - offset.x + 1,
+                   static_cast<int>(ceil(yMax)) - offset.y + 1);
+    if ( image.HasAlpha() )
+        result.SetAlpha();
+
+    for ( int y = 0; y < result.GetHeight(); y++ )
+    {
+        for ( int x = 0; x < result.GetWidth(); x++ )
+        {
+            // Inverse rotation of the destination point.
+            const double dx = x + offset.x - centre.x,
+                         dy = y + offset.y - centre.y;
+            const double sx = centre.x + dx*c + dy*s,
+                         sy = centre.y + dy*c - dx*s;
+
+            const bool covered = interpolating
+                ? sx > -0.25 && sx < w - 0.75 && sy > -0.25 && sy < h - 0.75
+                : wxRound(sx) >= 0 && wxRound(sx) < w &&
+                    wxRound(sy) >= 0 && wxRound(sy) < h;
+
+            unsigned char rgba[4] = { 0, 0, 0, 0 };
+            if ( !covered )
+            {
+                // Uncovered pixels use the mask colour, if any.
+                if ( image.HasMask() )
+                {
+                    rgba[0] = image.GetMaskRed();
+                    rgba[1] = image.GetMaskGreen();
+                    rgba[2] = image.GetMaskBlue();
+                }
+
+                rgba[3] = interpolating ? 0 : 255;
+            }
+            else if ( !interpolating )
+            {
+                const int xs = wxRound(sx),
+                          ys = wxRound(sy);
+                rgba[0] = image.GetRed(xs, ys);
+                rgba[1] = image.GetGreen(xs, ys);
+                rgba[2] = image.GetBlue(xs, ys);
+                if ( image.HasAlpha() )
+                    rgba[3] = image.GetAlpha(xs, ys);
+            }
+            else
+            {
+                const double cx = wxMin(wxMax(sx, 0.), w - 1.),
+                             cy = wxMin(wxMax(sy, 0.), h - 1.);
+                const int x1 = static_cast<int>(cx),
+                          y1 = static_cast<int>(cy);
+                const int xs[2] = { x1, wxMin(x1 + 1, w - 1) };
+                const int ys[2] = { y1, wxMin(y1 + 1, h - 1) };
+                const double fx = cx - x1,
+                             fy = cy - y1;
+
+                for ( int i = 0; i < 4; i++ )
+                {
+                    double v[2][2];
+                    for ( int j = 0; j < 2; j++ )
+                    {
+                        for ( int k = 0; k < 2; k++ )
+                        {
+                            const int px = xs[k], py = ys[j];
+                            switch ( i )
+                            {
+                                case 0: v[j][k] = image.GetRed(px, py); break;
+                                case 1: v[j][k] = image.GetGreen(px, py); break;
+                                case 2: v[j][k] = image.GetBlue(px, py); break;
+                                case 3:
+                                    v[j][k] = image.HasAlpha()
+                                                ? image.GetAlpha(px, py) : 0;
+                                    break;
+                            }
+                        }
+                    }
+
+                    const double value =
+                        (v[0][0]*(1 - fx) + v[0][1]*fx)*(1 - fy) +
+                        (v[1][0]*(1 - fx) + v[1][1]*fx)*fy;
+                    rgba[i] = static_cast<unsigned char>(value + 0.5);
+                }
+            }
+
+            result.SetRGB(x, y, rgba[0], rgba[1], rgba[2]);
+            if ( image.HasAlpha() )
+                result.SetAlpha(x, y, rgba[3]);
+        }
+    }
+
+    return result;
+}
+
+TEST_CASE("wxImage::Rotate", "[image][rotate]")
+{
+    wxImage image = CreateRotateTestImage(37, 23);
+    image.SetMaskColour(1, 2, 3);
+
+    const double angles[] = { 0.3, 1.0, -2.5, M_PI/2, 4 };
+    const wxPoint centres[] = { wxPoint(10, 7), wxPoint(0, 0), wxPoint(50, -3) };
+
+    for ( unsigned n = 0; n < WXSIZEOF(angles); n++ )
+    {
+        for ( unsigned m = 0; m < WXSIZEOF(centres); m++ )
+        {
+            const double angle = angles[n];
+            const wxPoint& centre = centres[m];
+            INFO("Angle " << angle << ", "
+                 "centre (" << centre.x << ", " << centre.y << ")");
+
+            wxPoint offset, offsetExpected;
+            wxImage rotated = image.Rotate(angle, centre, false, &offset);
+            CHECK_THAT( rotated,
+                        RGBASameAs(RotateReference(image, angle, centre, false,
+                                                   offsetExpected)) );
+            CHECK( offset == offsetExpected );
+            CHECK( rotated.HasMask() );
+
+            rotated = image.Rotate(angle, centre, true, &offset);
+            CHECK_THAT( rotated,
+                        RGBASimilarTo(RotateReference(image, angle, centre,
+                                                      true, offsetExpected),
+                                      1) );
+            CHECK( offset == offsetExpected );
+        }
+    }
+
+    SECTION("Zero angle")
+    {
+        // The rotated image is 1 pixel bigger than the original one, but its
+        // remaining part must be identical to it.
+        const wxImage rotated = image.Rotate(0, wxPoint(5, 5));
+        REQUIRE( rotated.GetSize() == wxSize(38, 24) );
+        CHECK_THAT( rotated.GetSubImage(wxRect(0, 0, 37, 23)),
+                    RGBASameAs(image) );
+        CHECK( rotated.GetAlpha(37, 0) == 0 );
+        CHECK( rotated.GetRed(37, 0) == 1 );
+    }
+
+    SECTION("Without alpha")
+    {
+        image.ClearAlpha();
+
+        wxPoint offset;
+        CHECK_THAT( image.Rotate(0.7, wxPoint(3, 4), false),
+                    RGBASameAs(RotateReference(image, 0.7, wxPoint(3, 4), false,
+                                               offset)) );
+        CHECK_THAT( image.Rotate(0.7, wxPoint(3, 4), true),
+                    RGBASimilarTo(RotateReference(image, 0.7, wxPoint(3, 4),
+                                                  true, offset),
+                                  1) );
+    }
+
+    SECTION("Big")
+    {
+        image = CreateRotateTestImage(613, 407);
+
+        wxPoint offset;
+        CHECK_THAT( image.Rotate(-0.2, wxPoint(300, 200), false),
+                    RGBASameAs(RotateReference(image, -0.2, wxPoint(300, 200),
+                                               false, offset)) );
+        CHECK_THAT( image.Rotate(-0.2, wxPoint(300, 200), true),
+                    RGBASimilarTo(RotateReference(image, -0.2,
+                                                  wxPoint(300, 200),
+                                                  true, offset),
+                                  1) );
+    }
+
+    SECTION("Compatibility")
+    {
+        // The results of the nearest neighbour rotation must be exactly the
+        // same as those produced by the previous versions which computed all
+        // points in floating point and rounded them using wxRound(), even for
+        // the points exactly in the middle between two pixels. Each pixel of
+        // the expected images is encoded as a single character: '.' for 0 and
+        // 'A', 'B', ... for 1, 2, ... up to 'i' for 35.
+        image.Create(7, 5);
+        for ( int y = 0; y < 5; y++ )
+        {
+            for ( int x = 0; x < 7; x++ )
+                image.SetRGB(x, y, y*7 + x + 1, 0, 0);
+        }
+
+        static const struct RotateGolden
+        {
+            double angle;
+            wxPoint centre;
+            wxPoint offset;
+            const char *rows[11];
+        } golden[] =
+        {
+        {
+            M_PI/6, wxPoint(0, 0), wxPoint(0, -4),
+            {
+                "..........",
+                ".....G....",
+                "...EEMN...",
+                ".BCKLTU...",
+                "ABJKRSab..",
+                "HHPQYZhi..",
+                ".OWXef....",
+                "..cd......",
+                "..c.......",
+                ".........."
+            }
+        },
+        {
+            M_PI/4, wxPoint(3, 2), wxPoint(-1, -3),
+            {
+                "..........",
+                "..........",
+                "....FN....",
+                "...ELMU...",
+                "..CKLSab..",
+                ".BJJRZZh..",
+                ".HIQXYg...",
+                "..OWXe....",
+                "...Vd.....",
+                "..........",
+                ".........."
+            }
+        },
+        {
+            M_PI/2, wxPoint(1, 1), wxPoint(-1, -5),
+            {
+                ".......",
+                ".GNUbi.",
+                ".FMTah.",
+                ".ELSZg.",
+                ".DKRYf.",
+                ".CJQXe.",
+                ".BIPWd.",
+                ".AHOVc."
+            }
+        },
+        {
+            2.5, wxPoint(2, 3), wxPoint(-4, -2),
+            {
+                "..........",
+                "..........",
+                "...ih.....",
+                "..Ubag....",
+                "..NTZYfe..",
+                ".GMLSRXdc.",
+                "..FEKQPWV.",
+                "...DCJIO..",
+                ".....BH...",
+                "......A..."
+            }
+        },
+        {
+            -M_PI/3, wxPoint(4, 1), wxPoint(-2, -3),
+            {
+                "....HA....",
+                "...OHB....",
+                ".cVWPJC...",
+                "..dXQKDE..",
+                "..eeYSLF..",
+                "...fZSTMG.",
+                "....haUN..",
+                "....ib....",
+                "..........",
+                ".........."
+            }
+        },
+        {
+            -atan2(3., 4.), wxPoint(5, 3), wxPoint(-1, -3),
+            {
+                "...........",
+                "...HAB.....",
+                "...OICD....",
+                "..VPQJKE...",
+                ".cdWXRLMFG.",
+                "...eYZSTN..",
+                "....fgaU...",
+                ".....hib...",
+                "...........",
+                "..........."
+            }
+        }
+        };
+
+        for ( unsigned n = 0; n < WXSIZEOF(golden); n++ )
+        {
+            const RotateGolden& g = golden[n];
+            INFO("Angle " << g.angle << ", "
+                 "centre (" << g.centre.x << ", " << g.centre.y << ")");
+
+            int height = 0;
+            while ( height < (int)WXSIZEOF(g.rows) && g.rows[height] )
+                height++;
+
+            wxImage expected(wxStrlen(g.rows[0]), height);
+            for ( int y = 0; y < height; y++ )
+            {
+                for ( int x = 0; g.rows[y][x]; x++ )
+                {
+                    const char c = g.rows[y][x];
+                    const int red = c == '.' ? 0
+                                             : c <= 'Z' ? c - 'A' + 1
+                                                        : c - 'a' + 27;
+                    expected.SetRGB(x, y, red, 0, 0);
+                }
+            }
+
+            wxPoint offset;
+            const wxImage rotated = image.Rotate(g.angle, g.centre, false,
+                                                 &offset);
+            CHECK( offset == g.offset );
+            CHECK_THAT( rotated, RGBASameAs(expected) );
+        }
+    }
+}
+
+// Create an image with many different colours, some pixels of which, at
+// various positions in the rows, have the given colour.
+static wxImage
+CreateColourTestImage(int width, int height, const wxColour& special)
+{
+    wxImage image(width, height);
+    image.SetAlpha();
+    for ( int y = 0; y < height; y++ )
+    {
+        for ( int x = 0; x < width; x++ )
+        {
+            if ( (x + 3*y) % 7 == 0 )
+                image.SetRGB(x, y, special.Red(), special.Green(), special.Blue());
+            else
+                image.SetRGB(x, y, (x*37 + y*11) % 256, (x*y*5) % 256, (x ^ y)*7);
+            image.SetAlpha(x, y, (x*y + 3*x) % 256);
+        }
+    }
+
+    return image;
+}
+
+enum ColourReferenceOp
+{
+    Colour_Greyscale,
+    Colour_Disabled,
+    Colour_Lightness,
+    Colour_RotateHue
+};
+
+// Straightforward implementation of the pixel-wise colour operations using
+// wxColour functions and leaving the pixels of the mask colour unchanged.
+static wxImage
+ColourReference(const wxImage& image, ColourReferenceOp op, double param)
+{
+    wxImage result = image.Copy();
+    unsigned char *p = result.GetData();
+    for ( int n = 0; n < image.GetWidth()*image.GetHeight(); n++, p += 3 )
+    {
+        if ( image.HasMask() && p[0] == image.GetMaskRed() &&
+                p[1] == image.GetMaskGreen() && p[2] == image.GetMaskBlue() )
+            continue;
+
+        switch ( op )
+        {
+            case Colour_Greyscale:
+                wxColour::MakeGrey(p, p + 1, p + 2, param, 0.5, 0.125);
+                break;
+
+            case Colour_Disabled:
+                wxColour::MakeDisabled(p, p + 1, p + 2,
+                                       static_cast<unsigned char>(param));
+                break;
+
+            case Colour_Lightness:
+                wxColour::ChangeLightness(p, p + 1, p + 2,
+                                          static_cast<int>(param));
+                break;
+
+            case Colour_RotateHue:
+                {
+                    wxImage::HSVValue
+                        hsv = wxImage::RGBtoHSV(wxImage::RGBValue(p[0], p[1], p[2]));
+                    hsv.hue += param;
+                    if ( hsv.hue >= 1.0 )
+                        hsv.hue -= 1.0;
+                    else if ( hsv.hue < 0.0 )
+                        hsv.hue += 1.0;
+
+                    const wxImage::RGBValue rgb = wxImage::HSVtoRGB(hsv);
+                    p[0] = rgb.red;
+                    p[1] = rgb.green;
+                    p[2] = rgb.blue;
+                }
+                break;
+        }
+    }
+
+    return result;
+}
+
+TEST_CASE("wxImage::ColourOperations", "[image][colour]")
+{
+    // Use the width which is not a multiple of the number of pixels processed
+    // at once by the implementation.
+    const wxColour special(1, 2, 3);
+    wxImage image = CreateColourTestImage(53, 29, special);
+
+    SECTION("Replace")
+    {
+        wxImage expected = image.Copy();
+        unsigned char *p = expected.GetData();
+        for ( int n = 0; n < 53*29; n++, p += 3 )
+        {
+            if ( p[0] == 1 && p[1] == 2 && p[2] == 3 )
+            {
+                p[0] = 10;
+                p[1] = 20;
+                p[2] = 30;
+            }
+        }
+
+        image.Replace(1, 2, 3, 10, 20, 30);
+        CHECK_THAT( image, RGBASameAs(expected) );
+    }
+
+    SECTION("Mono")
+    {
+        wxImage expected(53, 29);
+        for ( int y = 0; y < 29; y++ )
+        {
+            for ( int x = 0; x < 53; x++ )
+            {
+                const bool on = image.GetRed(x, y) == 1 &&
+                                    image.GetGreen(x, y) == 2 &&
+                                        image.GetBlue(x, y) == 3;
+                const unsigned char v = on ? 255 : 0;
+                expected.SetRGB(x, y, v, v, v);
+            }
+        }
+
+        CHECK_THAT( image.ConvertToMono(1, 2, 3), RGBASameAs(expected) );
+    }
+
+    SECTION("Greyscale")
+    {
+        CHECK_THAT( image.ConvertToGreyscale(0.25, 0.5, 0.125),
+                    RGBASameAs(ColourReference(image, Colour_Greyscale,
+                                               0.25)) );
+
+        image.SetMaskColour(1, 2, 3);
+        const wxImage grey = image.ConvertToGreyscale(0.25, 0.5, 0.125);
+        CHECK_THAT( grey,
+                    RGBASameAs(ColourReference(image, Colour_Greyscale,
+                                               0.25)) );
+        CHECK( grey.HasMask() );
+        CHECK( grey.GetRed(0, 0) == 1 );
+
+        // Check the default weights too.
+        const wxImage greyDefault = image.ConvertToGreyscale();
+        CHECK( greyDefault.GetRed(1, 1) == wxRound(48*0.299 + 5*0.587) );
+    }
+
+    SECTION("Disabled")
+    {
+        CHECK_THAT( image.ConvertToDisabled(),
+                    RGBASameAs(ColourReference(image, Colour_Disabled, 255)) );
+
+        image.SetMaskColour(1, 2, 3);
+        CHECK_THAT( image.ConvertToDisabled(100),
+                    RGBASameAs(ColourReference(image, Colour_Disabled, 100)) );
+    }
+
+    SECTION("Lightness")
+    {
+        const int values[] = { 0, 30, 100, 170, 200 };
+        for ( unsigned n = 0; n < WXSIZEOF(values); n++ )
+        {
+            INFO("Lightness " << values[n]);
+            CHECK_THAT( image.ChangeLightness(values[n]),
+                        RGBASameAs(ColourReference(image, Colour_Lightness,
+                                                   values[n])) );
+        }
+
+        image.SetMaskColour(1, 2, 3);
+        CHECK_THAT( image.ChangeLightness(150),
+                    RGBASameAs(ColourReference(image, Colour_Lightness, 150)) );
+    }
+
+    SECTION("RotateHue")
+    {
+        const double angles[] = { 0.1, 0.5, -0.3, 1.0, -0.75 };
+        for ( unsigned n = 0; n < WXSIZEOF(angles); n++ )
+        {
+            INFO("Angle " << angles[n]);
+
+            wxImage rotated = image.Copy();
+            rotated.RotateHue(angles[n]);
+
+            // The results of the integer implementation may differ slightly.
+            CHECK_THAT( rotated,
+                        RGBASimilarTo(ColourReference(image, Colour_RotateHue,
+                                                      angles[n]),
+                                      1) );
+        }
+    }
+
+    SECTION("SetMaskFromImage")
+    {
+        wxImage mask(53, 29);
+        mask.SetRGB(wxRect(10, 5, 20, 10), 255, 255, 255);
+
+        REQUIRE( image.SetMaskFromImage(mask, 255, 255, 255) );
+        REQUIRE( image.HasMask() );
+
+        const unsigned char r = image.GetMaskRed(),
+                            g = image.GetMaskGreen(),
+                            b = image.GetMaskBlue();
+        for ( int y = 0; y < 29; y++ )
+        {
+            for ( int x = 0; x < 53; x++ )
+            {
+                const bool masked = image.GetRed(x, y) == r &&
+                                        image.GetGreen(x, y) == g &&
+                                            image.GetBlue(x, y) == b;
+                CHECK( masked == wxRect(10, 5, 20, 10).Contains(x, y) );
+            }
+        }
+    }
+
+    SECTION("Big")
+    {
+        // This image is big enough to be processed by several threads.
+        image = CreateColourTestImage(701, 403, special);
+        image.SetMaskColour(1, 2, 3);
+
+        CHECK_THAT( image.ConvertToDisabled(),
+                    RGBASameAs(ColourReference(image, Colour_Disabled, 255)) );
+
+        wxImage expected = image.Copy();
+        expected.ClearAlpha();
+        unsigned char *p = expected.GetData();
+        for ( int n = 0; n < 701*403; n++, p += 3 )
+        {
+            const bool on = p[0] == 1 && p[1] == 2 && p[2] == 3;
+            p[0] = p[1] = p[2] = on ? 255 : 0;
+        }
+
+        const wxImage mono = image.ConvertToMono(1, 2, 3);
+        CHECK( mono.GetMaskRed() == 255 );
+        CHECK( memcmp(mono.GetData(), expected.GetData(), 3*701*403) == 0 );
+    }
+}
+
+// Straightforward implementation of wxImage::ComputeHistogram().
+static unsigned long HistogramReference(const wxImage& image, wxImageHistogram& h)
+{
+    unsigned long nentries = 0;
+    const unsigned char *p = image.GetData();
+    for ( int n = 0; n < image.GetWidth()*image.GetHeight(); n++, p += 3 )
+    {
+        wxImageHistogramEntry& entry = h[wxImageHistogram::MakeKey(p[0], p[1], p[2])];
+        if ( entry.value++ == 0 )
+            entry.index = nentries++;
+    }
+
+    return nentries;
+}
+
+// Change the maximal number of threads used by wxImage for the lifetime of
+// this object, restoring the previous value even if the test fails.
+class ImageMaxThreadsSetter
+{
+public:
+    explicit ImageMaxThreadsSetter(int threads)
+        : m_threadsOld(wxImage::GetMaxThreads())
+    {
+        wxImage::SetMaxThreads(threads);
+    }
+
+    ~ImageMaxThreadsSetter()
+    {
+        wxImage::SetMaxThreads(m_threadsOld);
+    }
+
+private:
+    const int m_threadsOld;
+
+    wxDECLARE_NO_COPY_CLASS(ImageMaxThreadsSetter);
+};
+
+#if wxUSE_THREADS
+
+// Data used by CountRows(): the number of times each row was processed and
+// the threads processing them.
+struct RowsCounter
+{
+    explicit RowsCounter(int height) : counts(height, 0) { }
+
+    wxCriticalSection cs;
+    wxVector<int> counts;
+    wxVector<wxThreadIdType> threads;
+};
+
+static void CountRows(const void *data, int y0, int y1)
+{
+    RowsCounter& counter = *static_cast<RowsCounter *>(const_cast<void *>(data));
+
+    wxCriticalSectionLocker lock(counter.cs);
+
+    for ( int y = y0; y < y1; y++ )
+        counter.counts[y]++;
+
+    const wxThreadIdType id = wxThread::GetCurrentId();
+    for ( size_t n = 0; n < counter.threads.size(); n++ )
+    {
+        if ( counter.threads[n] == id )
+            return;
+    }
+
+    counter.threads.push_back(id);
+}
+
+TEST_CASE("wxProcessImageRows", "[image][threads]")
+{
+    const size_t bigPixels = 4*1024*1024;
+
+    SECTION("Threads")
+    {
+        ImageMaxThreadsSetter setThreads(4);
+
+        CHECK( wxGetImageRowsThreads(1000, bigPixels) == 4 );
+        CHECK( wxGetImageRowsThreads(2, bigPixels) == 2 );
+        CHECK( wxGetImageRowsThreads(1000, 1000) == 1 );
+
+        wxImage::SetMaxThreads(1);
+        CHECK( wxGetImageRowsThreads(1000, bigPixels) == 1 );
+    }
+
+    SECTION("Rows")
+    {
+        // Use different numbers of threads, to check that the threads are
+        // reused and that more of them are created when needed.
+        const int threads[] = { 4, 2, 4, 7, 1, 3 };
+        for ( size_t n = 0; n < WXSIZEOF(threads); n++ )
+        {
+            INFO("Threads: " << threads[n]);
+
+            ImageMaxThreadsSetter setThreads(threads[n]);
+
+            RowsCounter counter(1001);
+            wxProcessImageRows(CountRows, &counter, 1001, bigPixels);
+
+            int wrong = 0;
+            for ( int y = 0; y < 1001; y++ )
+            {
+                if ( counter.counts[y] != 1 )
+                    wrong++;
+            }
+            CHECK( wrong == 0 );
+
+            // Rows must have been processed by several threads if possible,
+            // although not necessarily by as many of them as we asked for.
+            if ( threads[n] > 1 )
+                CHECK( counter.threads.size() > 1 );
+            else
+                CHECK( counter.threads.size() == 1 );
+        }
+    }
+}
+
+#endif // wxUSE_THREADS
+
+static void CheckHistogram(const wxImage& image)
+{
+    wxImageHistogram expected;
+    const unsigned long numColours = HistogramReference(image, expected);
+
+    wxImageHistogram h;
+    CHECK( image.ComputeHistogram(h) == numColours );
+    REQUIRE( h.size() == expected.size() );
+
+    unsigned long mismatches = 0;
+    for ( wxImageHistogram::const_iterator it = expected.begin();
+          it != expected.end();
+          ++it )
+    {
+        wxImageHistogram::const_iterator found = h.find(it->first);
+        if ( found == h.end() ||
+                found->second.index != it->second.index ||
+                    found->second.value != it->second.value )
+            mismatches++;
+    }
+
+    CHECK( mismatches == 0 );
+
+    CHECK( image.CountColours() == numColours );
+    CHECK( image.CountColours(numColours) == numColours );
+    if ( numColours > 10 )
+        CHECK( image.CountColours(10) == 11 );
+}
+
+TEST_CASE("wxImage::Histogram", "[image][histogram]")
+{
+    SECTION("Small")
+    {
+        wxImage image(20, 10);
+        for ( int y = 0; y < 10; y++ )
+            for ( int x = 0; x < 20; x++ )
+                image.SetRGB(x, y, x % 3, y, 17);
+
+        CheckHistogram(image);
+    }
+
+    SECTION("Big")
+    {
+        // This image is big enough to use the direct-indexed arrays.
+        wxImage image(300, 200);
+        for ( int y = 0; y < 200; y++ )
+            for ( int x = 0; x < 300; x++ )
+                image.SetRGB(x, y, (x*y) % 256, y % 7, x % 5);
+
+        CheckHistogram(image);
+    }
+
+    SECTION("Threads")
+    {
+        // Force using several threads even on single CPU machines.
+        ImageMaxThreadsSetter setThreads(4);
+
+        wxImage image(701, 403);
+        for ( int y = 0; y < 403; y++ )
+            for ( int x = 0; x < 701; x++ )
+                image.SetRGB(x, y, (x + y) % 256, (x*y) % 11, x % 3);
+
+        CheckHistogram(image);
+    }
+}
+
+TEST_CASE("wxImage::FindFirstUnusedColour", "[image][histogram]")
+{
+    // Check both small and big images, using different implementations.
+    const int widths[] = { 10, 500 };
+    for ( unsigned n = 0; n < WXSIZEOF(widths); n++ )
+    {
+        const int width = widths[n];
+        INFO("Width " << width);
+
+        wxImage image(width, 100);
+        image.SetRGB(wxRect(0, 0, width, 100), 1, 0, 0);
+        image.SetRGB(0, 1, 2, 0, 0);
+        image.SetRGB(0, 2, 3, 0, 0);
+        image.SetRGB(1, 2, 5, 0, 0);
+        image.SetRGB(2, 2, 254, 0, 0);
+        image.SetRGB(3, 2, 0, 1, 0);
+
+        unsigned char r, g, b;
+        REQUIRE( image.FindFirstUnusedColour(&r, &g, &b) );
+        CHECK( r == 4 );
+        CHECK( g == 0 );
+        CHECK( b == 0 );
+
+        REQUIRE( image.FindFirstUnusedColour(&r, &g, &b, 5) );
+        CHECK( r == 6 );
+
+        // Notice that 255 is never used as component value and that the
+        // search wraps to the next green value.
+        REQUIRE( image.FindFirstUnusedColour(&r, &g, &b, 254) );
+        CHECK( r == 1 );
+        CHECK( g == 1 );
+        CHECK( b == 0 );
+    }
+}
+
+#if wxUSE_LIBJPEG
+
+static wxImage LoadReducedJPEG(const wxMemoryOutputStream& mos,
+                               int minWidth, int minHeight,
+                               int maxWidth = 0, int maxHeight = 0)
+{
+    wxImage image;
+    image.SetOption(wxIMAGE_OPTION_MIN_WIDTH, minWidth);
+    image.SetOption(wxIMAGE_OPTION_MIN_HEIGHT, minHeight);
+    if ( maxWidth || maxHeight )
+    {
+        image.SetOption(wxIMAGE_OPTION_MAX_WIDTH, maxWidth);
+        image.SetOption(wxIMAGE_OPTION_MAX_HEIGHT, maxHeight);
+    }
+
+    wxMemoryInputStream mis(mos);
+    REQUIRE( image.LoadFile(mis, wxBITMAP_TYPE_JPEG) );
+
+    return image;
+}
+
+TEST_CASE("wxImage::LoadReducedJPEG", "[image][jpeg]")
+{
+    if ( !wxImage::FindHandler(wxBITMAP_TYPE_JPEG) )
+        wxImage::AddHandler(new wxJPEGHandler);
+
+    wxImage original(400, 300);
+    for ( int y = 0; y < 300; y++ )
+        for ( int x = 0; x < 400; x++ )
+            original.SetRGB(x, y, x / 2, y, (x + y) / 3);
+
+    wxMemoryOutputStream mos;
+    REQUIRE( original.SaveFile(mos, wxBITMAP_TYPE_JPEG) );
+
+    wxImage image = LoadReducedJPEG(mos, 100, 50);
+    CHECK( image.GetSize() == wxSize(100, 75) );
+    CHECK( image.GetOptionInt(wxIMAGE_OPTION_ORIGINAL_WIDTH) == 400 );
+    CHECK( image.GetOptionInt(wxIMAGE_OPTION_ORIGINAL_HEIGHT) == 300 );
+
+    CHECK( LoadReducedJPEG(mos, 101, 50).GetSize() == wxSize(200, 150) );
+    CHECK( LoadReducedJPEG(mos, 0, 40).GetSize() == wxSize(100, 75) );
+    CHECK( LoadReducedJPEG(mos, 0, 10).GetSize() == wxSize(50, 38) );
+    CHECK( LoadReducedJPEG(mos, 400, 300).GetSize() == wxSize(400, 300) );
+
+    // The maximal size takes precedence.
+    CHECK( LoadReducedJPEG(mos, 300, 300, 150, 0).GetSize() == wxSize(100, 75) );
+
+    // Fast IDCT should give almost the same results.
+    wxImage fast;
+    fast.SetOption(wxIMAGE_OPTION_JPEG_FAST_IDCT, 1);
+    wxMemoryInputStream mis(mos);
+    REQUIRE( fast.LoadFile(mis, wxBITMAP_TYPE_JPEG) );
+    REQUIRE( fast.GetSize() == original.GetSize() );
+
+    unsigned long totalDiff = 0;
+    const unsigned char *p = original.GetData();
+    const unsigned char *q = fast.GetData();
+    for ( int n = 0; n < 3*400*300; n++ )
+        totalDiff += abs(p[n] - q[n]);
+
+    CHECK( totalDiff < 3*400*300*3 );
+}
+
+#endif // wxUSE_LIBJPEG
+
+#if wxUSE_PALETTE
+
+// Check that the image pixels correspond to the palette indices.
+static void CheckQuantized(const wxImage& image, const unsigned char *data8bit,
+                           const wxPalette& palette)
+{
+    REQUIRE( palette.IsOk() );
+
+    unsigned long mismatches = 0;
+    const unsigned char *p = image.GetData();
+    for ( int n = 0; n < image.GetWidth()*image.GetHeight(); n++, p += 3 )
+    {
+        unsigned char r, g, b;
+        if ( !palette.GetRGB(data8bit[n], &r, &g, &b) ||
+                p[0] != r || p[1] != g || p[2] != b )
+            mismatches++;
+    }
+
+    CHECK( mismatches == 0 );
+}
+
+TEST_CASE("wxQuantize", "[image][quantize]")
+{
+    const int flags = wxQUANTIZE_FILL_DESTINATION_IMAGE |
+                      wxQUANTIZE_RETURN_8BIT_DATA;
+
+    wxImage image(701, 403);
+    for ( int y = 0; y < 403; y++ )
+        for ( int x = 0; x < 701; x++ )
+            image.SetRGB(x, y, x % 256, (x + 2*y) % 256, (x*y) % 256);
+
+    SECTION("Dithering")
+    {
+        const int ditherFlags[] =
+        {
+            0,
+            wxQUANTIZE_NO_DITHER,
+            wxQUANTIZE_ORDERED_DITHER
+        };
+
+        for ( unsigned n = 0; n < WXSIZEOF(ditherFlags); n++ )
+        {
+            INFO("Flags " << ditherFlags[n]);
+
+            wxImage dest;
+            wxPalette *palette = NULL;
+            unsigned char *data8bit = NULL;
+            REQUIRE( wxQuantize::Quantize(image, dest, &palette, 100, &data8bit,
+                                          flags | ditherFlags[n]) );
+            wxScopedPtr<wxPalette> paletteOwner(palette);
+            wxScopedArray<unsigned char> dataOwner(data8bit);
+
+            CheckQuantized(dest, data8bit, *palette);
+
+            // Using several threads must give the same results.
+            ImageMaxThreadsSetter setThreads(4);
+
+            wxImage dest2;
+            wxPalette *palette2 = NULL;
+            unsigned char *data8bit2 = NULL;
+            REQUIRE( wxQuantize::Quantize(image, dest2, &palette2, 100, &data8bit2,
+                                          flags | ditherFlags[n]) );
+            delete palette2;
+            wxScopedArray<unsigned char> dataOwner2(data8bit2);
+
+            CHECK( memcmp(data8bit, data8bit2, 701*403) == 0 );
+        }
+    }
+
+    SECTION("NoDither")
+    {
+        // All colours of this image fall in different cells of the histogram
+        // used by the quantizer, so they must all be preserved approximately.
+        wxImage small(16, 16);
+        for ( int y = 0; y < 16; y++ )
+            for ( int x = 0; x < 16; x++ )
+                small.SetRGB(x, y, 32*(x % 8), 64*(y % 4), 128*(x/8));
+
+        wxImage dest;
+        REQUIRE( wxQuantize::Quantize(small, dest, NULL, 236, NULL,
+                                      flags | wxQUANTIZE_NO_DITHER) );
+
+        unsigned long mismatches = 0;
+        const unsigned char *p = small.GetData();
+        const unsigned char *q = dest.GetData();
+        for ( int n = 0; n < 16*16; n++, p += 3, q += 3 )
+        {
+            if ( abs(p[0] - q[0]) > 4 || abs(p[1] - q[1]) > 2 ||
+                    abs(p[2] - q[2]) > 4 )
+                mismatches++;
+        }
+
+        CHECK( mismatches == 0 );
+    }
+
+    SECTION("UsePalette")
+    {
+        wxImage dest;
+        wxPalette *palette = NULL;
+        REQUIRE( wxQuantize::Quantize(image, dest, &palette, 64, NULL, flags) );
+        wxScopedPtr<wxPalette> paletteOwner(palette);
+
+        wxImage frame = image.Mirror();
+        const int paletteFlags[] =
+        {
+            wxQUANTIZE_USE_PALETTE,
+            wxQUANTIZE_USE_PALETTE | wxQUANTIZE_ORDERED_DITHER
+        };
+
+        for ( unsigned n = 0; n < WXSIZEOF(paletteFlags); n++ )
+        {
+            INFO("Flags " << paletteFlags[n]);
+
+            wxPalette *framePalette = palette;
+            unsigned char *data8bit = NULL;
+            REQUIRE( wxQuantize::Quantize(frame, dest, &framePalette, 236,
+                                          &data8bit, flags | paletteFlags[n]) );
+            wxScopedArray<unsigned char> dataOwner(data8bit);
+
+            CHECK( framePalette == palette );
+            CheckQuantized(dest, data8bit, *palette);
+        }
+
+        // The overload setting the palette of the destination image must
+        // reuse it too.
+        wxImage frameDest(701, 403);
+        frameDest.SetPalette(*palette);
+
+        unsigned char *data8bit = NULL;
+        REQUIRE( wxQuantize::Quantize(frame, frameDest, 236, &data8bit,
+                                      flags | wxQUANTIZE_USE_PALETTE) );
+        wxScopedArray<unsigned char> dataOwner(data8bit);
+
+        CHECK( frameDest.GetPalette().IsSameAs(*palette) );
+        CheckQuantized(frameDest, data8bit, *palette);
+    }
+}
+
+#endif // wxUSE_PALETTE
+
+#if wxUSE_GIF
+
+// Helper for writing the LZW codes of the specified size.
+class GIFCodeWriter
+{
+public:
+    GIFCodeWriter() : m_bits(0), m_nbits(0) { }
+
+    void Add(int code, int size)
+    {
+        m_bits |= code << m_nbits;
+        m_nbits += size;
+        while ( m_nbits >= 8 )
+        {
+            m_data.AppendByte(static_cast<char>(m_bits & 0xff));
+            m_bits >>= 8;
+            m_nbits -= 8;
+        }
+    }
+
+    const wxMemoryBuffer& Finish()
+    {
+        if ( m_nbits )
+            m_data.AppendByte(static_cast<char>(m_bits));
+        m_nbits = 0;
+        return m_data;
+    }
+
+private:
+    wxMemoryBuffer m_data;
+    int m_bits;
+    int m_nbits;
+};
+
+TEST_CASE("wxGIFDecoder", "[image][gif]")
+{
+    SECTION("Interlaced")
+    {
+        // Create an interlaced GIF with 4 colours, using a clear code every 2
+        // pixels to keep the code size constant.
+        const int width = 3,
+                  height = 10;
+        static const int rowsOrder[] = { 0, 8, 4, 2, 6, 1, 3, 5, 7, 9 };
+        GIFCodeWriter codes;
+        for ( int n = 0; n < height; n++ )
+        {
+            for ( int x = 0; x < width; x++ )
+            {
+                if ( (n*width + x) % 2 == 0 )
+                    codes.Add(4, 3);
+                codes.Add((x + rowsOrder[n]) % 4, 3);
+            }
+        }
+        codes.Add(5, 3);
+        const wxMemoryBuffer& lzw = codes.Finish();
+
+        static const unsigned char header[] =
+        {
+            'G', 'I', 'F', '8', '9', 'a',
+            width, 0, height, 0, 0x81, 0, 0,
+            0, 0, 0,  255, 0, 0,  0, 255, 0,  0, 0, 255,
+            ',', 0, 0, 0, 0, width, 0, height, 0, 0x40,
+            2
+        };
+
+        wxMemoryOutputStream mos;
+        mos.Write(header, sizeof(header));
+        mos.PutC(static_cast<char>(lzw.GetDataLen()));
+        mos.Write(lzw.GetData(), lzw.GetDataLen());
+        mos.PutC(0);
+        mos.PutC(';');
+
+        wxMemoryInputStream mis(mos);
+        wxGIFDecoder decoder;
+        REQUIRE( decoder.LoadGIF(mis) == wxGIF_OK );
+        REQUIRE( decoder.GetFrameCount() == 1 );
+
+        const unsigned char *data = decoder.GetData(0);
+        REQUIRE( data );
+
+        int mismatches = 0;
+        for ( int y = 0; y < height; y++ )
+        {
+            for ( int x = 0; x < width; x++ )
+            {
+                if ( *data++ != (x + y) % 4 )
+                    mismatches++;
+            }
+        }
+        CHECK( mismatches == 0 );
+    }
+
+    SECTION("Wrong block size")
+    {
+        // Some encoders write the size of the last data sub-block one too
+        // big, so that it includes the terminating empty sub-block, check
+        // that such images can still be loaded, including the frames
+        // following them.
+        static const unsigned char data[] =
+        {
+            'G', 'I', 'F', '8', '9', 'a',
+            1, 0, 1, 0, 0x80, 0, 0,
+            0, 0, 0,  255, 255, 255,
+
+            // The first frame with the wrong block size: clear code and 0.
+            ',', 0, 0, 0, 0, 1, 0, 1, 0, 0,
+            2, 2, 0x44, 0,
+
+            // The second one, correctly encoded: clear code, 1 and end code.
+            ',', 0, 0, 0, 0, 1, 0, 1, 0, 0,
+            2, 2, 0x4c, 0x01, 0,
+
+            ';'
+        };
+
+        wxMemoryInputStream mis(data, sizeof(data));
+        wxGIFDecoder decoder;
+        REQUIRE( decoder.LoadGIF(mis) == wxGIF_OK );
+        REQUIRE( decoder.GetFrameCount() == 2 );
+
+        const unsigned char *pixels = decoder.GetData(0);
+        REQUIRE( pixels );
+        CHECK( pixels[0] == 0 );
+
+        pixels = decoder.GetData(1);
+        REQUIRE( pixels );
+        CHECK( pixels[0] == 1 );
+
+        // And the same for a single frame image.
+        static const unsigned char single[] =
+        {
+            'G', 'I', 'F', '8', '7', 'a',
+            1, 0, 1, 0, 0x80, 0, 0,
+            0, 0, 0,  255, 255, 255,
+            ',', 0, 0, 0, 0, 1, 0, 1, 0, 0,
+            2, 2, 0x44, 0,
+            ';'
+        };
+
+        wxMemoryInputStream mis2(single, sizeof(single));
+        wxGIFDecoder decoder2;
+        REQUIRE( decoder2.LoadGIF(mis2) == wxGIF_OK );
+        REQUIRE( decoder2.GetFrameCount() == 1 );
+    }
+
+#if wxUSE_PALETTE
+    SECTION("Cache")
+    {
+        wxImage image("horse.gif");
+        REQUIRE( image.IsOk() );
+
+        wxImageArray images;
+        images.Add(image);
+        for ( int i = 0; i < 5; ++i )
+        {
+            images.Add(i % 2 ? images[i].Mirror() : images[i].Rotate90());
+            images[i+1].SetPalette(images[0].GetPalette());
+        }
+
+        wxMemoryOutputStream mos;
+        REQUIRE( wxGIFHandler().SaveAnimation(images, &mos) );
+
+        wxMemoryInputStream mis(mos);
+        wxGIFDecoder decoder;
+        REQUIRE( decoder.LoadGIF(mis) == wxGIF_OK );
+        REQUIRE( decoder.GetFrameCount() == images.size() );
+
+        // Access the frames in different orders with different cache sizes.
+        static const unsigned int order[] = { 5, 0, 3, 3, 1, 4, 0, 2, 5 };
+        const unsigned int cacheSizes[] = { 1, 2, 0 };
+        for ( size_t n = 0; n < WXSIZEOF(cacheSizes); n++ )
+        {
+            decoder.SetMaxCachedFrames(cacheSizes[n]);
+            CHECK( decoder.GetMaxCachedFrames() == cacheSizes[n] );
+
+            for ( size_t i = 0; i < WXSIZEOF(order); i++ )
+            {
+                INFO("Frame " << order[i] << " with cache size " << cacheSizes[n]);
+
+                wxImage frame;
+                REQUIRE( decoder.ConvertToImage(order[i], &frame) );
+                CHECK_THAT( frame, RGBSameAs(images[order[i]]) );
+            }
+        }
+    }
+#endif // wxUSE_PALETTE
+}
+
+#endif // wxUSE_GIF
+
+#if wxUSE_LIBPNG
+
+static wxImage SaveAndLoadPNG(const wxImage& image, size_t* size = NULL)
+{
+    wxMemoryOutputStream mos;
+    REQUIRE( image.SaveFile(mos, wxBITMAP_TYPE_PNG) );
+
+    if ( size )
+        *size = mos.GetSize();
+
+    wxMemoryInputStream mis(mos);
+    wxImage loaded;
+    REQUIRE( loaded.LoadFile(mis, wxBITMAP_TYPE_PNG) );
+    return loaded;
+}
+
+TEST_CASE("wxImage::PNG", "[image][png]")
+{
+    if ( !wxImage::FindHandler(wxBITMAP_TYPE_PNG) )
+        wxImage::AddHandler(new wxPNGHandler);
+
+    // Make the image big enough to be saved using 4 threads.
+    const int width = 1024,
+              height = 512;
+    wxImage original(width, height, false);
+    original.SetAlpha();
+    unsigned char *p = original.GetData();
+    unsigned char *alpha = original.GetAlpha();
+    for ( int y = 0; y < height; y++ )
+    {
+        for ( int x = 0; x < width; x++ )
+        {
+            *p++ = static_cast<unsigned char>(x);
+            *p++ = static_cast<unsigned char>(y + x / 3);
+            *p++ = static_cast<unsigned char>((x * y) >> 6);
+            *alpha++ = static_cast<unsigned char>(x < 10 ? 255 : x ^ y);
+        }
+    }
+
+    SECTION("PixelFormat")
+    {
+        wxMemoryOutputStream mos;
+        REQUIRE( original.SaveFile(mos, wxBITMAP_TYPE_PNG) );
+
+        wxImage image;
+        image.SetOption(wxIMAGE_OPTION_PNG_PIXEL_FORMAT,
+                        wxIMAGE_PIXEL_FORMAT_RGBA);
+        wxMemoryInputStream mis(mos);
+        REQUIRE( image.LoadFile(mis, wxBITMAP_TYPE_PNG) );
+        CHECK( image.GetPixelFormat() == wxIMAGE_PIXEL_FORMAT_RGBA );
+        CHECK_THAT( image, RGBASameAs(original) );
+
+        wxImage premultiplied;
+        premultiplied.SetOption(wxIMAGE_OPTION_PNG_PIXEL_FORMAT,
+                                wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED);
+        mis.SeekI(0);
+        REQUIRE( premultiplied.LoadFile(mis, wxBITMAP_TYPE_PNG) );
+        CHECK( premultiplied.GetPixelFormat() ==
+                wxIMAGE_PIXEL_FORMAT_ARGB32_PREMULTIPLIED );
+        CHECK( premultiplied.GetRed(5, 7) == original.GetRed(5, 7) );
+        CHECK( premultiplied.GetGreen(5, 7) == original.GetGreen(5, 7) );
+        CHECK( premultiplied.GetBlue(5, 7) == original.GetBlue(5, 7) );
+
+        // The images without alpha are still loaded in the default format.
+        wxImage opaque = original.Copy();
+        opaque.ClearAlpha();
+        wxMemoryOutputStream mos2;
+        REQUIRE( opaque.SaveFile(mos2, wxBITMAP_TYPE_PNG) );
+
+        wxImage image2;
+        image2.SetOption(wxIMAGE_OPTION_PNG_PIXEL_FORMAT,
+                         wxIMAGE_PIXEL_FORMAT_RGBA);
+        wxMemoryInputStream mis2(mos2);
+        REQUIRE( image2.LoadFile(mis2, wxBITMAP_TYPE_PNG) );
+        CHECK( image2.GetPixelFormat() == wxIMAGE_PIXEL_FORMAT_RGB );
+        CHECK_THAT( image2, RGBASameAs(opaque) );
+    }
+
+    SECTION("Alpha")
+    {
+        CHECK_THAT( SaveAndLoadPNG(original), RGBASameAs(original) );
+
+        // Alpha channel is not created if all pixels are opaque.
+        wxImage opaque = original.Copy();
+        memset(opaque.GetAlpha(), 255, width*height);
+        wxImage loaded = SaveAndLoadPNG(opaque);
+        CHECK( !loaded.HasAlpha() );
+        opaque.ClearAlpha();
+        CHECK_THAT( loaded, RGBASameAs(opaque) );
+    }
+
+    SECTION("Threads")
+    {
+        wxImage opaque = original.Copy();
+        opaque.ClearAlpha();
+
+        wxImage palettised(width, height);
+        for ( int y = 0; y < height; y++ )
+            for ( int x = 0; x < width; x++ )
+                palettised.SetRGB(x, y, x / 128 * 32, y / 128 * 64, 0);
+        palettised.SetOption(wxIMAGE_OPTION_PNG_FORMAT, wxPNG_TYPE_PALETTE);
+
+        wxImage grey = original.Copy();
+        grey.SetOption(wxIMAGE_OPTION_PNG_FORMAT, wxPNG_TYPE_GREY);
+        grey.SetOption(wxIMAGE_OPTION_PNG_BITDEPTH, 16);
+
+        wxImage sub = opaque.Copy();
+        sub.SetOption(wxIMAGE_OPTION_PNG_FILTER, 0x18); // PNG_FILTER_NONE|SUB
+        sub.SetOption(wxIMAGE_OPTION_PNG_COMPRESSION_LEVEL, 1);
+
+        wxImage paeth = original.Copy();
+        paeth.SetOption(wxIMAGE_OPTION_PNG_FILTER, 4); // PNG_FILTER_VALUE_PAETH
+        paeth.SetOption(wxIMAGE_OPTION_PNG_COMPRESSION_LEVEL, 9);
+
+        wxImage huffman = opaque.Copy();
+        huffman.SetOption(wxIMAGE_OPTION_PNG_COMPRESSION_STRATEGY, 2);
+        huffman.SetOption(wxIMAGE_OPTION_PNG_COMPRESSION_BUFFER_SIZE, 100000);
+
+        const wxImage images[] =
+            { original, opaque, palettised, grey, sub, paeth, huffman };
+
+        for ( size_t n = 0; n < WXSIZEOF(images); n++ )
+        {
+            INFO("Image #" << n);
+
+            size_t sizeSequential = 0;
+            wxImage expected;
+            {
+                ImageMaxThreadsSetter setThreads(1);
+                expected = SaveAndLoadPNG(images[n], &sizeSequential);
+            }
+
+            ImageMaxThreadsSetter setThreads(4);
+            size_t sizeParallel = 0;
+            CHECK_THAT( SaveAndLoadPNG(images[n], &sizeParallel),
+                        RGBASameAs(expected) );
+
+            // Compressing the bands separately shouldn't lose much.
+            CHECK( sizeParallel < sizeSequential + sizeSequential / 10 );
+        }
+    }
+}
+
+#endif // wxUSE_LIBPNG
+
 /*
     TODO: add lots of more tests to wxImage functions
 */
@@ -0,0 +1,215 @@
+///////////////////////////////////////////////////////////////////////////////
+// Name:        tests/net/http.cpp
+// Purpose:     wxHTTP unit tests using a local server
+// Author:      wxWidgets team
+// Created:     2020-10-19
+// Copyright:   (c) 2020 wxWidgets development team
+// Licence:     wxWindows licence
+///////////////////////////////////////////////////////////////////////////////
+
+// For compilers that support precompilation, includes "wx/wx.h".
+#include "testprec.h"
+
+
+#if wxUSE_PROTOCOL_HTTP
+
+#include "wx/socket.h"
+
+#ifdef wxHAS_SOCKET_SERVER_POOL
+
+#include "wx/protocol/http.h"
+#include "wx/mstream.h"
+#include "wx/scopedptr.h"
+
+#include "httpserver.h"
+
+namespace
+{
+
+// Fixture starting the local server used by all tests.
+class HTTPServerFixture
+{
+public:
+    HTTPServerFixture()
+        : m_port(0)
+    {
+        if ( m_server.Start() )
+            m_port = m_server.GetPort();
+    }
+
+    // Connect the given object to the server.
+    bool Connect(wxHTTP& http)
+    {
+        http.SetTimeout(10);
+        return m_port && http.Connect("127.0.0.1", m_port);
+    }
+
+    // Perform a request and return the response body.
+    static wxString Get(wxHTTP& http, const wxString& path)
+    {
+        wxScopedPtr<wxInputStream> in(http.GetInputStream(path));
+        if ( !in )
+            return "<error>";
+
+        wxMemoryOutputStream out;
+        in->Read(out);
+
+        const wxStreamBuffer& sb = *out.GetOutputStreamBuffer();
+        return wxString::From8BitData(static_cast<const char *>(sb.GetBufferStart()),
+                                      sb.GetIntPosition());
+    }
+
+    LoopbackHTTPServer m_server;
+    unsigned short m_port;
+};
+
+// Return a string of the given length which is easy to check.
+wxString MakeBody(size_t len)
+{
+    wxString s;
+    s.reserve(len);
+    for ( size_t n = 0; n < len; n++ )
+        s += static_cast<char>('a' + n % 26);
+
+    return s;
+}
+
+} // anonymous namespace
+
+TEST_CASE_METHOD(HTTPServerFixture, "wxHTTP::KeepAlive", "[net][http]")
+{
+    REQUIRE( m_port );
+
+    wxHTTP http;
+    REQUIRE( Connect(http) );
+
+    SECTION("Disabled")
+    {
+        CHECK( Get(http, "/") == "OK" );
+        CHECK( Get(http, "/") == "OK" );
+        CHECK( m_server.GetConnections() == 2 );
+    }
+
+    SECTION("Enabled")
+    {
+        http.SetKeepAlive();
+        for ( int n = 0; n < 5; n++ )
+        {
+            CHECK( Get(http, "/") == "OK" );
+            CHECK( http.GetResponse() == 200 );
+        }
+
+        CHECK( m_server.GetConnections() == 1 );
+        CHECK( m_server.GetRequests() == 5 );
+    }
+
+    SECTION("Closed by server")
+    {
+        http.SetKeepAlive();
+        CHECK( Get(http, "/close") == "OK" );
+        CHECK( Get(http, "/") == "OK" );
+        CHECK( Get(http, "/") == "OK" );
+        CHECK( m_server.GetConnections() == 2 );
+    }
+
+    SECTION("Incomplete read")
+    {
+        http.SetKeepAlive();
+        {
+            wxScopedPtr<wxInputStream> in(http.GetInputStream("/"));
+            REQUIRE( in );
+            CHECK( in->GetC() == 'O' );
+        }
+
+        // The connection can't be reused if the response wasn't read fully.
+        CHECK( Get(http, "/") == "OK" );
+        CHECK( m_server.GetConnections() == 2 );
+    }
+}
+
+TEST_CASE_METHOD(HTTPServerFixture, "wxHTTP::Chunked", "[net][http]")
+{
+    REQUIRE( m_port );
+
+    wxHTTP http;
+    http.SetKeepAlive();
+    REQUIRE( Connect(http) );
+
+    CHECK( Get(http, "/chunked") == LoopbackHTTPServer::GetChunkedText() );
+    CHECK( Get(http, "/") == "OK" );
+    CHECK( Get(http, "/chunked") == LoopbackHTTPServer::GetChunkedText() );
+    CHECK( m_server.GetConnections() == 1 );
+}
+
+TEST_CASE_METHOD(HTTPServerFixture, "wxHTTP::PostStream", "[net][http]")
+{
+    REQUIRE( m_port );
+
+    wxHTTP http;
+    http.SetKeepAlive();
+    REQUIRE( Connect(http) );
+
+    // Use a body bigger than the block size used for sending it.
+    const wxString body = MakeBody(200000);
+    const wxCharBuffer data = body.To8BitData();
+
+    SECTION("Chunked")
+    {
+        REQUIRE( http.SetPostStream("text/plain",
+                                    new wxMemoryInputStream(data, data.length())) );
+        CHECK( Get(http, "/echo") == body );
+    }
+
+    SECTION("Fixed size")
+    {
+        REQUIRE( http.SetPostStream("text/plain",
+                                    new wxMemoryInputStream(data, data.length()),
+                                    data.length()) );
+        CHECK( Get(http, "/echo") == body );
+    }
+
+    // The stream is only used for a single request.
+    CHECK( Get(http, "/echo") == "" );
+
+    CHECK( http.SetPostText("text/plain", "Hello") );
+    CHECK( Get(http, "/echo") == "Hello" );
+
+    CHECK( m_server.GetConnections() == 1 );
+}
+
+TEST_CASE_METHOD(HTTPServerFixture, "wxHTTP::ConnectionPool", "[net][http]")
+{
+    REQUIRE( m_port );
+
+    wxHTTPConnectionPool pool("127.0.0.1", m_port, 1);
+
+    wxHTTP * const http1 = pool.Acquire();
+    wxHTTP * const http2 = pool.Acquire();
+    REQUIRE( http1 );
+    REQUIRE( http2 );
+    CHECK( http1->IsKeepAlive() );
+
+    CHECK( HTTPServerFixture::Get(*http1, "/") == "OK" );
+    CHECK( HTTPServerFixture::Get(*http2, "/chunked") ==
+            LoopbackHTTPServer::GetChunkedText() );
+
+    // Only one connection is kept in the pool.
+    pool.Release(http1);
+    pool.Release(http2);
+    CHECK( pool.GetIdleCount() == 1 );
+
+    for ( int n = 0; n < 3; n++ )
+    {
+        wxHTTP * const http = pool.Acquire();
+        REQUIRE( http );
+        CHECK( HTTPServerFixture::Get(*http, "/") == "OK" );
+        pool.Release(http);
+    }
+
+    CHECK( pool.GetIdleCount() == 1 );
+    CHECK( m_server.GetConnections() == 2 );
+}
+
+#endif // wxHAS_SOCKET_SERVER_POOL
+
+#endif // wxUSE_PROTOCOL_HTTP
@@ -0,0 +1,292 @@
+///////////////////////////////////////////////////////////////////////////////
+// Name:        tests/net/httpserver.h
+// Purpose:     Minimal local HTTP server used by the network tests
+// Author:      wxWidgets team
+// Created:     2020-10-21
+// Copyright:   (c) 2020 wxWidgets development team
+// Licence:     wxWindows licence
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _WX_TESTS_NET_HTTPSERVER_H_
+#define _WX_TESTS_NET_HTTPSERVER_H_
+
+#include "wx/socket.h"
+
+#ifdef wxHAS_SOCKET_SERVER_POOL
+
+#include "wx/atomic.h"
+#include "wx/buffer.h"
+#include "wx/event.h"
+#include "wx/string.h"
+#include "wx/thread.h"
+#include "wx/vector.h"
+
+// ----------------------------------------------------------------------------
+// LoopbackHTTPServer: HTTP/1.1 server listening on the loopback interface
+// ----------------------------------------------------------------------------
+
+// The requests are handled on the sockets of a wxSocketServerPool and the
+// connections are kept alive. Both Content-Length and chunked request bodies
+// are supported and the server responds to the following paths:
+//
+//  - "/echo" sends back the request body.
+//  - "/chunked" sends GetChunkedText() using chunked encoding.
+//  - "/close" sends "OK" and closes the connection.
+//  - anything else sends the body set by SetBody(), "OK" by default.
+class LoopbackHTTPServer : public wxEvtHandler
+{
+public:
+    LoopbackHTTPServer()
+        : m_pool(MakeLocalAddress(), 1, wxSOCKET_WAITALL_WRITE),
+          m_body("OK"),
+          m_port(0),
+          m_connections(0),
+          m_requests(0)
+    {
+        Bind(wxEVT_SOCKET, &LoopbackHTTPServer::OnSocketEvent, this);
+
+        m_pool.SetEventHandler(*this);
+        m_pool.SetNotify(wxSOCKET_CONNECTION_FLAG |
+                         wxSOCKET_INPUT_FLAG |
+                         wxSOCKET_LOST_FLAG);
+    }
+
+    virtual ~LoopbackHTTPServer()
+    {
+        m_pool.Stop();
+
+        for ( size_t n = 0; n < m_buffers.size(); n++ )
+            delete m_buffers[n];
+    }
+
+    // Must be called before Start().
+    void SetBody(const wxCharBuffer& body) { m_body = body; }
+
+    // Start accepting the connections, returns false if it failed.
+    bool Start()
+    {
+        wxIPV4address local;
+        if ( !m_pool.IsOk() || !m_pool.Start() || !m_pool.GetLocal(local) )
+            return false;
+
+        m_port = local.Service();
+        return true;
+    }
+
+    // Only valid after a successful call to Start().
+    unsigned short GetPort() const { return m_port; }
+
+    wxString GetURL(const wxString& path = "/") const
+    {
+        return wxString::Format("http://127.0.0.1:%u", m_port) + path;
+    }
+
+    int GetConnections() const { return m_connections; }
+    int GetRequests() const { return m_requests; }
+
+    // The text sent by "/chunked" handler.
+    static wxString GetChunkedText()
+    {
+        return "Hello, chunked world!";
+    }
+
+private:
+    static wxIPV4address MakeLocalAddress()
+    {
+        wxIPV4address addr;
+        addr.LocalHost();
+        addr.Service(0);
+        return addr;
+    }
+
+    void OnSocketEvent(wxSocketEvent& event)
+    {
+        wxSocketBase * const sock = event.GetSocket();
+        switch ( event.GetSocketEvent() )
+        {
+            case wxSOCKET_CONNECTION:
+                m_connections++;
+                {
+                    // Keep the data received so far in a buffer associated
+                    // with the socket as the requests may be split between
+                    // several reads.
+                    wxMemoryBuffer * const buf = new wxMemoryBuffer;
+                    sock->SetClientData(buf);
+
+                    wxCRIT_SECT_LOCKER(lock, m_cs);
+                    m_buffers.push_back(buf);
+                }
+                break;
+
+            case wxSOCKET_INPUT:
+                OnInput(sock);
+                break;
+
+            case wxSOCKET_LOST:
+            case wxSOCKET_OUTPUT:
+                break;
+        }
+    }
+
+    void OnInput(wxSocketBase* sock)
+    {
+        wxMemoryBuffer& buf = *static_cast<wxMemoryBuffer *>(sock->GetClientData());
+
+        void * const p = buf.GetAppendBuf(4096);
+        sock->Read(p, 4096);
+        buf.UngetAppendBuf(sock->LastReadCount());
+
+        for ( ;; )
+        {
+            const wxString data = wxString::From8BitData
+                                  (
+                                    static_cast<const char *>(buf.GetData()),
+                                    buf.GetDataLen()
+                                  );
+
+            size_t consumed;
+            wxString path,
+                     body;
+            if ( !ParseRequest(data, consumed, path, body) )
+                break;
+
+            // Remove the request from the buffer.
+            const wxString rest = data.substr(consumed);
+            buf.SetDataLen(0);
+            buf.AppendData(rest.To8BitData(), rest.length());
+
+            m_requests++;
+
+            if ( !SendResponse(sock, path, body) )
+                break;
+        }
+    }
+
+    // Returns false if the request is incomplete.
+    static bool ParseRequest(const wxString& data,
+                             size_t& consumed,
+                             wxString& path,
+                             wxString& body)
+    {
+        const size_t endHeaders = data.find("\r\n\r\n");
+        if ( endHeaders == wxString::npos )
+            return false;
+
+        const wxString head = data.substr(0, endHeaders + 2).Lower();
+        path = data.AfterFirst(' ').BeforeFirst(' ');
+
+        size_t pos = endHeaders + 4;
+        if ( head.Contains("\r\ntransfer-encoding: chunked\r\n") )
+        {
+            for ( ;; )
+            {
+                const size_t eol = data.find("\r\n", pos);
+                if ( eol == wxString::npos )
+                    return false;
+
+                unsigned long size;
+                if ( !data.substr(pos, eol - pos).ToULong(&size, 16) )
+                    return false;
+
+                pos = eol + 2;
+                if ( data.length() < pos + size + 2 )
+                    return false;
+
+                body += data.substr(pos, size);
+                pos += size + 2;
+
+                if ( !size )
+                    break;
+            }
+        }
+        else
+        {
+            const size_t lenPos = head.find("\r\ncontent-length: ");
+            if ( lenPos != wxString::npos )
+            {
+                unsigned long size;
+                if ( !head.substr(lenPos + 18).BeforeFirst('\r').ToULong(&size) )
+                    return false;
+
+                if ( data.length() < pos + size )
+                    return false;
+
+                body = data.substr(pos, size);
+                pos += size;
+            }
+        }
+
+        consumed = pos;
+        return true;
+    }
+
+    // Returns false if the connection was closed.
+    bool SendResponse(wxSocketBase* sock,
+                      const wxString& path,
+                      const wxString& body) const
+    {
+        wxString response = "HTTP/1.1 200 OK\r\n";
+        if ( path == "/chunked" )
+        {
+            response += "Transfer-Encoding: chunked\r\n\r\n";
+
+            // Send the text in several chunks, using an upper case hex number
+            // and a chunk extension for the first one to check that they're
+            // handled correctly.
+            const wxString text = GetChunkedText();
+            response += wxString::Format("%X;ext=1\r\n", 16u);
+            response += text.substr(0, 16) + "\r\n";
+            response += wxString::Format("%x\r\n", unsigned(text.length() - 16));
+            response += text.substr(16) + "\r\n";
+            response += "0\r\n\r\n";
+        }
+        else if ( path == "/echo" || path == "/close" )
+        {
+            const wxString content = path == "/echo" ? body : wxString("OK");
+
+            if ( path == "/close" )
+                response += "Connection: close\r\n";
+
+            response += wxString::Format("Content-Length: %zu\r\n\r\n",
+                                         content.length());
+            response += content;
+        }
+        else
+        {
+            // The body may be big, so send it directly instead of copying it
+            // into the response string.
+            response += wxString::Format("Content-Length: %zu\r\n\r\n",
+                                         m_body.length());
+            sock->Write(response.To8BitData(), response.length());
+            sock->Write(m_body.data(), m_body.length());
+
+            return true;
+        }
+
+        sock->Write(response.To8BitData(), response.length());
+
+        if ( path == "/close" )
+        {
+            sock->Close();
+            return false;
+        }
+
+        return true;
+    }
+
+    wxSocketServerPool m_pool;
+    wxCharBuffer m_body;
+    unsigned short m_port;
+
+    wxAtomicInt m_connections;
+    wxAtomicInt m_requests;
+
+    wxVector<wxMemoryBuffer *> m_buffers;
+    wxCriticalSection m_cs;
+
+    wxDECLARE_NO_COPY_CLASS(LoopbackHTTPServer);
+};
+
+#endif // wxHAS_SOCKET_SERVER_POOL
+
+#endif // _WX_TESTS_NET_HTTPSERVER_H_
@@ -259,3 +259,299 @@ void IPCTestCase::Disconnect()
 #endif // wxUSE_THREADS
 
 #endif // !__WINDOWS__
+
+// ----------------------------------------------------------------------------
+// shared memory transport test
+// ----------------------------------------------------------------------------
+
+// Shared memory is only supported under Linux. The client runs in a child
+// process, executing the hidden test case below, so that both sides can block
+// while sending the data without preventing the other one from receiving it
+// and all the events are still handled in the main thread of each process.
+#if defined(__LINUX__) && wxUSE_SOCKETS && wxUSE_IPC
+
+#ifndef WX_PRECOMP
+    #include "wx/app.h"
+#endif
+
+#include "wx/buffer.h"
+#include "wx/evtloop.h"
+#include "wx/filename.h"
+#include "wx/ipc.h"
+#include "wx/mstream.h"
+#include "wx/process.h"
+#include "wx/scopedptr.h"
+#include "wx/stdpaths.h"
+#include "wx/stopwatch.h"
+#include "wx/utils.h"
+
+namespace
+{
+
+const char *IPC_SHM_TEST_TOPIC = "IPC shared memory test";
+const char *IPC_SHM_TEST_CLIENT = "wxTCPConnection::SharedMemory::Client";
+const char *IPC_SHM_TEST_SERVICE_VAR = "WX_TEST_IPC_SERVICE";
+
+// Return the data sent in both directions: it's much bigger than the ring
+// used and has an odd size to have partial copies wrapping around its end.
+wxCharBuffer GetSharedMemoryTestData()
+{
+    wxCharBuffer data(1024*1024 + 17);
+    for ( size_t n = 0; n < data.length(); n++ )
+        data.data()[n] = static_cast<char>(n % 251);
+
+    return data;
+}
+
+// Dispatch the events in the main thread until the given flag is set.
+bool DispatchUntil(const bool& done)
+{
+    wxEventLoop loop;
+    wxEventLoopActivator activate(&loop);
+
+    wxStopWatch sw;
+    while ( !done )
+    {
+        if ( sw.Time() > 60000 )
+            return false;
+
+        wxTheApp->ProcessPendingEvents();
+        loop.DispatchTimeout(10);
+    }
+
+    return true;
+}
+
+// Connection storing the data it receives, used on both sides: the server
+// gets it with Execute() and the client with Advise().
+class DataConnection : public wxConnection
+{
+public:
+    DataConnection() : m_received(false), m_disconnected(false) { }
+
+    bool WaitForData() { return DispatchUntil(m_received); }
+    bool WaitForDisconnect() { return DispatchUntil(m_disconnected); }
+
+    const wxMemoryBuffer& GetData() const { return m_data; }
+
+    virtual bool OnExecute(const wxString& WXUNUSED(topic),
+                           const void *data,
+                           size_t size,
+                           wxIPCFormat WXUNUSED(format)) wxOVERRIDE
+    {
+        StoreData(data, size);
+        return true;
+    }
+
+    virtual bool OnAdvise(const wxString& WXUNUSED(topic),
+                          const wxString& WXUNUSED(item),
+                          const void *data,
+                          size_t size,
+                          wxIPCFormat WXUNUSED(format)) wxOVERRIDE
+    {
+        StoreData(data, size);
+        return true;
+    }
+
+    // the connection is deleted by its owner, don't do it here
+    virtual bool OnDisconnect() wxOVERRIDE
+    {
+        m_disconnected = true;
+        return true;
+    }
+
+private:
+    void StoreData(const void *data, size_t size)
+    {
+        m_data.Clear();
+        m_data.AppendData(data, size);
+
+        m_received = true;
+    }
+
+    wxMemoryBuffer m_data;
+    bool m_received,
+         m_disconnected;
+
+    wxDECLARE_NO_COPY_CLASS(DataConnection);
+};
+
+class DataServer : public wxServer
+{
+public:
+    DataServer() : m_conn(NULL), m_connected(false) { }
+    virtual ~DataServer() { delete m_conn; }
+
+    bool WaitForConnection() { return DispatchUntil(m_connected); }
+
+    DataConnection *GetConnection() const { return m_conn; }
+
+    virtual wxConnectionBase *
+    OnAcceptConnection(const wxString& topic) wxOVERRIDE
+    {
+        if ( topic != IPC_SHM_TEST_TOPIC || m_conn )
+            return NULL;
+
+        m_conn = new DataConnection;
+        m_connected = true;
+        return m_conn;
+    }
+
+private:
+    DataConnection *m_conn;
+    bool m_connected;
+
+    wxDECLARE_NO_COPY_CLASS(DataServer);
+};
+
+class DataClient : public wxClient
+{
+public:
+    DataClient() { }
+
+    virtual wxConnectionBase *OnMakeConnection() wxOVERRIDE
+    {
+        return new DataConnection;
+    }
+
+private:
+    wxDECLARE_NO_COPY_CLASS(DataClient);
+};
+
+// Child process running the client, with its output collected to be shown
+// if it fails.
+class ClientProcess : public wxProcess
+{
+public:
+    ClientProcess() : m_terminated(false), m_status(-1)
+    {
+        SetOutputSink(&m_output, &m_output);
+    }
+
+    bool WaitForTermination() { return DispatchUntil(m_terminated); }
+
+    int GetStatus() const { return m_status; }
+
+    wxString GetOutput() const
+    {
+        const wxStreamBuffer * const buf = m_output.GetOutputStreamBuffer();
+        return wxString::From8BitData
+               (
+                static_cast<const char *>(buf->GetBufferStart()),
+                buf->GetIntPosition()
+               );
+    }
+
+    virtual void OnTerminate(int WXUNUSED(pid), int status) wxOVERRIDE
+    {
+        m_status = status;
+        m_terminated = true;
+    }
+
+private:
+    wxMemoryOutputStream m_output;
+    bool m_terminated;
+    int m_status;
+
+    wxDECLARE_NO_COPY_CLASS(ClientProcess);
+};
+
+} // anonymous namespace
+
+TEST_CASE("wxTCPConnection::SharedMemory", "[net][ipc]")
+{
+    // use a Unix domain socket as shared memory is only used with them
+    const wxString service = wxString::Format("%s/wxtest_ipc_%lu",
+                                              wxFileName::GetTempDir(),
+                                              wxGetProcessId());
+
+    DataServer server;
+    REQUIRE( server.Create(service) );
+
+    wxExecuteEnv env;
+    REQUIRE( wxGetEnvMap(&env.env) );
+    env.env[IPC_SHM_TEST_SERVICE_VAR] = service;
+
+    const wxString exe = wxStandardPaths::Get().GetExecutablePath();
+    const wxCharBuffer exeBuf(exe.mb_str());
+    const char *argv[] = { exeBuf, IPC_SHM_TEST_CLIENT, NULL };
+
+    ClientProcess process;
+    REQUIRE( wxExecute(argv, wxEXEC_ASYNC, &process, &env) );
+
+    const wxCharBuffer data = GetSharedMemoryTestData();
+
+    if ( server.WaitForConnection() )
+    {
+        DataConnection * const serverConn = server.GetConnection();
+
+        // The client sends the data as soon as it is connected.
+        INFO( "Receiving the data from the client" );
+        if ( serverConn->WaitForData() )
+        {
+            // the shared memory setup is only done after accepting the
+            // connection, so check for it only now
+            CHECK( serverConn->UsesSharedMemory() );
+
+            const wxMemoryBuffer& received = serverConn->GetData();
+            CHECK( received.GetDataLen() == data.length() );
+            CHECK( memcmp(received.GetData(), data, data.length()) == 0 );
+        }
+        else
+        {
+            FAIL_CHECK( "No data received" );
+        }
+
+        // This blocks until the client reads all the data which is checked
+        // by it, the client disconnects and exits after doing it.
+        INFO( "Sending the data to the client" );
+        CHECK( serverConn->Advise("data", data, data.length(), wxIPC_PRIVATE) );
+        CHECK( serverConn->WaitForDisconnect() );
+    }
+    else
+    {
+        FAIL_CHECK( "The client didn't connect to the server" );
+    }
+
+    if ( process.WaitForTermination() )
+    {
+        INFO( "Client output:\n" << process.GetOutput() );
+        CHECK( process.GetStatus() == 0 );
+    }
+    else
+    {
+        FAIL_CHECK( "The client didn't terminate" );
+        wxProcess::Kill(process.GetPid(), wxSIGKILL);
+        process.WaitForTermination();
+    }
+}
+
+// This test is only run by the test above in a child process.
+TEST_CASE("wxTCPConnection::SharedMemory::Client", "[.]")
+{
+    wxString service;
+    if ( !wxGetEnv(IPC_SHM_TEST_SERVICE_VAR, &service) )
+        return;
+
+    // use the smallest possible ring
+    DataClient client;
+    client.SetSharedMemorySize(64*1024);
+
+    wxScopedPtr<DataConnection> conn(static_cast<DataConnection *>(
+        client.MakeConnection("localhost", service, IPC_SHM_TEST_TOPIC)));
+    REQUIRE( conn );
+
+    CHECK( conn->UsesSharedMemory() );
+
+    // This blocks until the server reads all the data.
+    const wxCharBuffer data = GetSharedMemoryTestData();
+    CHECK( conn->Execute(data, data.length(), wxIPC_PRIVATE) );
+
+    REQUIRE( conn->WaitForData() );
+
+    const wxMemoryBuffer& received = conn->GetData();
+    CHECK( received.GetDataLen() == data.length() );
+    CHECK( memcmp(received.GetData(), data, data.length()) == 0 );
+}
+
+#endif // __LINUX__ && wxUSE_SOCKETS && wxUSE_IPC
@@ -26,6 +26,16 @@
 #include "wx/scopedptr.h"
 #include "wx/sstream.h"
 #include "wx/evtloop.h"
+#include "wx/file.h"
+#include "wx/filename.h"
+#include "wx/atomic.h"
+#include "wx/thread.h"
+
+#include "testfile.h"
+
+#ifdef __UNIX__
+    #include <unistd.h>
+#endif
 
 typedef wxScopedPtr<wxSockAddress> wxSockAddressPtr;
 typedef wxScopedPtr<wxSocketClient> wxSocketClientPtr;
@@ -301,4 +311,440 @@ void SocketTestCase::UrlTest()
     CPPUNIT_ASSERT_EQUAL( wxSTREAM_EOF, in->Read(out).GetLastError() );
 }
 
+// ----------------------------------------------------------------------------
+// tests using a pair of sockets connected over the loopback interface
+// ----------------------------------------------------------------------------
+
+namespace
+{
+
+// Client socket connected to a server socket accepting connections on the
+// local host, both of them blocking.
+class LoopbackSockets
+{
+public:
+    LoopbackSockets()
+    {
+        wxIPV4address addr;
+        addr.LocalHost();
+        addr.Service(0);
+
+        m_server.reset(new wxSocketServer(addr, wxSOCKET_BLOCK));
+        REQUIRE( m_server->IsOk() );
+
+        // use the port chosen by the system
+        wxIPV4address local;
+        REQUIRE( m_server->GetLocal(local) );
+
+        m_client.reset(new wxSocketClient(wxSOCKET_BLOCK));
+        m_client->SetTimeout(10);
+        REQUIRE( m_client->Connect(local) );
+
+        m_accepted.reset(m_server->Accept());
+        REQUIRE( m_accepted );
+        m_accepted->SetTimeout(10);
+    }
+
+    wxSocketBase& Client() { return *m_client; }
+    wxSocketBase& Accepted() { return *m_accepted; }
+
+private:
+    wxScopedPtr<wxSocketServer> m_server;
+    wxScopedPtr<wxSocketClient> m_client;
+    wxScopedPtr<wxSocketBase> m_accepted;
+};
+
+// Thread reading all the data from the socket: this is needed when writing
+// more data than fits into the socket buffers.
+class ReaderThread : public wxThread
+{
+public:
+    ReaderThread(wxSocketBase& sock, size_t size)
+        : wxThread(wxTHREAD_JOINABLE),
+          m_sock(sock),
+          m_data(size)
+    {
+        m_sock.SetFlags(wxSOCKET_WAITALL | wxSOCKET_BLOCK);
+        Run();
+    }
+
+    // wait for the thread termination and return the data read by it
+    const wxCharBuffer& GetData()
+    {
+        Wait();
+
+        return m_data;
+    }
+
+protected:
+    virtual void* Entry() wxOVERRIDE
+    {
+        m_sock.Read(m_data.data(), m_data.length());
+
+        return NULL;
+    }
+
+private:
+    wxSocketBase& m_sock;
+    wxCharBuffer m_data;
+};
+
+wxCharBuffer MakeData(size_t size)
+{
+    wxCharBuffer data(size);
+    for ( size_t n = 0; n < size; n++ )
+        data.data()[n] = static_cast<char>(n % 251);
+
+    return data;
+}
+
+} // anonymous namespace
+
+TEST_CASE("wxSocket::WriteV", "[net][socket]")
+{
+    LoopbackSockets sockets;
+
+    const wxCharBuffer big = MakeData(1024*1024);
+
+    const wxSocketBuffer buffers[] =
+    {
+        wxSocketBuffer("Hello, ", 7),
+        wxSocketBuffer(),
+        wxSocketBuffer("world", 5),
+        wxSocketBuffer(big.data(), big.length()),
+    };
+
+    const size_t total = 12 + big.length();
+    ReaderThread reader(sockets.Accepted(), total);
+
+    sockets.Client().SetFlags(wxSOCKET_WAITALL | wxSOCKET_BLOCK);
+    sockets.Client().WriteV(buffers, WXSIZEOF(buffers));
+    CHECK( !sockets.Client().Error() );
+    CHECK( sockets.Client().LastWriteCount() == total );
+
+    const wxCharBuffer& data = reader.GetData();
+    CHECK( memcmp(data.data(), "Hello, world", 12) == 0 );
+    CHECK( memcmp(data.data() + 12, big.data(), big.length()) == 0 );
+}
+
+TEST_CASE("wxSocket::ReadV", "[net][socket]")
+{
+    LoopbackSockets sockets;
+
+    sockets.Client().Write("abcdefghij", 10);
+    REQUIRE( sockets.Client().LastWriteCount() == 10 );
+
+    char buf1[3],
+         buf2[4],
+         buf3[3];
+    wxSocketBuffer buffers[] =
+    {
+        wxSocketBuffer(buf1, sizeof(buf1)),
+        wxSocketBuffer(buf2, sizeof(buf2)),
+        wxSocketBuffer(buf3, sizeof(buf3)),
+    };
+
+    // check that the pushed back data is used too
+    sockets.Accepted().Unread("xy", 2);
+
+    sockets.Accepted().SetFlags(wxSOCKET_WAITALL | wxSOCKET_BLOCK);
+    sockets.Accepted().ReadV(buffers, WXSIZEOF(buffers));
+    CHECK( !sockets.Accepted().Error() );
+    CHECK( sockets.Accepted().LastReadCount() == 10 );
+    CHECK( memcmp(buf1, "xya", 3) == 0 );
+    CHECK( memcmp(buf2, "bcde", 4) == 0 );
+    CHECK( memcmp(buf3, "fgh", 3) == 0 );
+
+    // the buffers passed to ReadV() must not be modified
+    CHECK( buffers[0].data == buf1 );
+    CHECK( buffers[0].size == sizeof(buf1) );
+
+    char rest[2];
+    sockets.Accepted().Read(rest, sizeof(rest));
+    CHECK( memcmp(rest, "ij", 2) == 0 );
+}
+
+TEST_CASE("wxSocket::Msg", "[net][socket]")
+{
+    LoopbackSockets sockets;
+
+    wxSocketBase& client = sockets.Client();
+    wxSocketBase& server = sockets.Accepted();
+
+    char buf[16];
+
+    client.WriteMsg("message", 7);
+    CHECK( !client.Error() );
+    CHECK( client.LastWriteCount() == 7 );
+
+    server.ReadMsg(buf, sizeof(buf));
+    CHECK( !server.Error() );
+    CHECK( server.LastReadCount() == 7 );
+    CHECK( memcmp(buf, "message", 7) == 0 );
+
+    // empty messages must work too
+    client.WriteMsg(NULL, 0);
+    CHECK( !client.Error() );
+
+    server.ReadMsg(buf, sizeof(buf));
+    CHECK( !server.Error() );
+    CHECK( server.LastReadCount() == 0 );
+
+    // and the message must be truncated if it doesn't fit in the buffer
+    client.WriteMsg("a longer message", 16);
+    CHECK( !client.Error() );
+
+    server.ReadMsg(buf, 8);
+    CHECK( !server.Error() );
+    CHECK( server.LastReadCount() == 8 );
+    CHECK( memcmp(buf, "a longer", 8) == 0 );
+
+    // check that the stream is still in sync after discarding the rest
+    client.WriteMsg("next", 4);
+    server.ReadMsg(buf, sizeof(buf));
+    CHECK( !server.Error() );
+    CHECK( server.LastReadCount() == 4 );
+    CHECK( memcmp(buf, "next", 4) == 0 );
+
+    // finally check that a big message is sent correctly
+    const wxCharBuffer big = MakeData(1024*1024);
+
+    ReaderThread reader(server, big.length() + 16);
+    client.WriteMsg(big.data(), big.length());
+    CHECK( !client.Error() );
+    CHECK( client.LastWriteCount() == big.length() );
+
+    const wxCharBuffer& data = reader.GetData();
+    CHECK( memcmp(data.data() + 8, big.data(), big.length()) == 0 );
+}
+
+#if wxUSE_FILE
+
+TEST_CASE("wxSocket::SendFile", "[net][socket]")
+{
+    LoopbackSockets sockets;
+
+    const wxCharBuffer contents = MakeData(3*1024*1024 + 17);
+
+    TempFile tmp(wxFileName::CreateTempFileName("wxtest"));
+    {
+        wxFile file(tmp.GetName(), wxFile::write);
+        REQUIRE( file.Write(contents.data(), contents.length()) == contents.length() );
+    }
+
+    wxFile file(tmp.GetName());
+    REQUIRE( file.IsOpened() );
+
+    wxSocketBase& client = sockets.Client();
+
+    SECTION("Whole")
+    {
+        ReaderThread reader(sockets.Accepted(), contents.length());
+
+        client.SendFile(file);
+        CHECK( !client.Error() );
+        CHECK( client.LastWriteCount() == contents.length() );
+
+        const wxCharBuffer& data = reader.GetData();
+        CHECK( memcmp(data.data(), contents.data(), contents.length()) == 0 );
+    }
+
+    SECTION("Part")
+    {
+        const size_t offset = 1000,
+                     size = 100000;
+
+        ReaderThread reader(sockets.Accepted(), size);
+
+        client.SendFile(file, offset, size);
+        CHECK( !client.Error() );
+        CHECK( client.LastWriteCount() == size );
+
+        const wxCharBuffer& data = reader.GetData();
+        CHECK( memcmp(data.data(), contents.data() + offset, size) == 0 );
+    }
+
+    SECTION("Beyond EOF")
+    {
+        ReaderThread reader(sockets.Accepted(), 17);
+
+        client.SendFile(file, contents.length() - 17, 100);
+        CHECK( client.Error() );
+        CHECK( client.LastWriteCount() == 17 );
+
+        const wxCharBuffer& data = reader.GetData();
+        CHECK( memcmp(data.data(), contents.data() + contents.length() - 17, 17) == 0 );
+    }
+
+#ifdef __UNIX__
+    SECTION("Pipe")
+    {
+        int fds[2];
+        REQUIRE( pipe(fds) == 0 );
+
+        // the data must fit into the pipe buffer
+        const size_t size = 4096;
+        REQUIRE( write(fds[1], contents.data(), size) == (ssize_t)size );
+        close(fds[1]);
+
+        wxFile pipeFile(fds[0]);
+
+        ReaderThread reader(sockets.Accepted(), size);
+
+        client.SendFile(pipeFile);
+        CHECK( !client.Error() );
+        CHECK( client.LastWriteCount() == size );
+
+        const wxCharBuffer& data = reader.GetData();
+        CHECK( memcmp(data.data(), contents.data(), size) == 0 );
+    }
+#endif // __UNIX__
+}
+
+#endif // wxUSE_FILE
+
+#ifdef wxHAS_SOCKET_SERVER_POOL
+
+namespace
+{
+
+// Handler echoing back all the data received by the pool sockets.
+class EchoHandler : public wxEvtHandler
+{
+public:
+    EchoHandler() : m_connections(0), m_lost(0), m_mainThreadEvents(0)
+    {
+        Bind(wxEVT_SOCKET, &EchoHandler::OnSocketEvent, this);
+    }
+
+    int GetConnections() const { return m_connections; }
+    int GetLost() const { return m_lost; }
+    int GetMainThreadEvents() const { return m_mainThreadEvents; }
+
+private:
+    void OnSocketEvent(wxSocketEvent& event)
+    {
+        if ( wxIsMainThread() )
+            m_mainThreadEvents++;
+
+        wxSocketBase * const sock = event.GetSocket();
+        switch ( event.GetSocketEvent() )
+        {
+            case wxSOCKET_CONNECTION:
+                m_connections++;
+                break;
+
+            case wxSOCKET_INPUT:
+                {
+                    char buf[256];
+                    sock->Read(buf, sizeof(buf));
+                    if ( sock->LastReadCount() )
+                        sock->Write(buf, sock->LastReadCount());
+                }
+                break;
+
+            case wxSOCKET_LOST:
+                m_lost++;
+                break;
+
+            case wxSOCKET_OUTPUT:
+                break;
+        }
+    }
+
+    wxAtomicInt m_connections;
+    wxAtomicInt m_lost;
+    wxAtomicInt m_mainThreadEvents;
+};
+
+// Wait until the pool has the expected number of connections for at most 10
+// seconds.
+bool WaitForConnections(const wxSocketServerPool& pool, int expected)
+{
+    for ( int n = 0; n < 1000; n++ )
+    {
+        if ( pool.GetConnectionCount() == expected )
+            return true;
+
+        wxMilliSleep(10);
+    }
+
+    return false;
+}
+
+void TestServerPool(wxSocketFlags flags)
+{
+    wxIPV4address addr;
+    addr.LocalHost();
+    addr.Service(0);
+
+    wxSocketServerPool pool(addr, 4, flags);
+    REQUIRE( pool.IsOk() );
+    CHECK( pool.GetThreadCount() == 4 );
+#ifdef __LINUX__
+    CHECK( pool.UsesReusePort() == ((flags & wxSOCKET_REUSEPORT) != 0) );
+#endif
+
+    EchoHandler handler;
+    pool.SetEventHandler(handler);
+    pool.SetNotify(wxSOCKET_CONNECTION_FLAG |
+                   wxSOCKET_INPUT_FLAG |
+                   wxSOCKET_LOST_FLAG);
+    REQUIRE( pool.Start() );
+
+    wxIPV4address local;
+    REQUIRE( pool.GetLocal(local) );
+
+    static const int NUM_CLIENTS = 20;
+    wxVector<wxSocketClient *> clients;
+    for ( int n = 0; n < NUM_CLIENTS; n++ )
+    {
+        wxSocketClient * const client = new wxSocketClient(wxSOCKET_BLOCK |
+                                                           wxSOCKET_WAITALL);
+        client->SetTimeout(10);
+        clients.push_back(client);
+        REQUIRE( client->Connect(local) );
+
+        const wxString msg = wxString::Format("ping %d", n);
+        client->Write(msg.utf8_str(), msg.length());
+
+        char buf[64];
+        client->Read(buf, msg.length());
+        CHECK( client->LastReadCount() == msg.length() );
+        CHECK( wxString::FromUTF8(buf, msg.length()) == msg );
+    }
+
+    CHECK( WaitForConnections(pool, NUM_CLIENTS) );
+    CHECK( handler.GetConnections() == NUM_CLIENTS );
+
+    for ( int n = 0; n < NUM_CLIENTS; n++ )
+        delete clients[n];
+
+    // the pool must close the lost connections itself
+    CHECK( WaitForConnections(pool, 0) );
+    CHECK( handler.GetLost() == NUM_CLIENTS );
+
+    CHECK( handler.GetMainThreadEvents() == 0 );
+
+    pool.Stop();
+    CHECK( !pool.IsOk() );
+}
+
+} // anonymous namespace
+
+TEST_CASE("wxSocketServerPool", "[net][socket]")
+{
+    SECTION("Single listening socket")
+    {
+        TestServerPool(wxSOCKET_NONE);
+    }
+
+    SECTION("SO_REUSEPORT")
+    {
+        TestServerPool(wxSOCKET_REUSEPORT);
+    }
+}
+
+#endif // wxHAS_SOCKET_SERVER_POOL
+
 #endif // wxUSE_SOCKETS
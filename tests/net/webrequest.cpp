@@ -25,8 +25,12 @@
 
 #include "wx/webrequest.h"
 #include "wx/filename.h"
+#include "wx/mstream.h"
+#include "wx/socket.h"
 #include "wx/wfstream.h"
 
+#include "httpserver.h"
+
 // This test uses httpbin service and by default uses the mirror at the
 // location below, which seems to be more reliable than the main site at
 // https://httpbin.org. Any other mirror, including a local one, which can be
@@ -464,4 +468,262 @@ TEST_CASE("WebRequestUtils", "[net][webrequest]")
     CHECK( params["boundary"] == "MIME_boundary_01234567" );
 }
 
+#ifdef wxHAS_SOCKET_SERVER_POOL
+
+namespace
+{
+
+// Fixture starting the server and running many requests to it concurrently.
+class LoopbackFixture : public wxTimer
+{
+public:
+    LoopbackFixture()
+        : m_expected("OK"),
+          m_count(0),
+          m_completed(0),
+          m_succeeded(0),
+          m_progressEvents(0)
+    {
+        Bind(wxEVT_WEBREQUEST_STATE, &LoopbackFixture::OnRequestState, this);
+        Bind(wxEVT_WEBREQUEST_PROGRESS, &LoopbackFixture::OnProgress, this);
+    }
+
+    bool StartServer()
+    {
+        if ( !m_server.Start() )
+            return false;
+
+        m_url = m_server.GetURL();
+        return true;
+    }
+
+    // Start all the requests at once and wait until they complete.
+    void RunRequests(wxWebSession& session, int count)
+    {
+        m_count = count;
+
+        wxVector<wxWebRequest> requests;
+        for ( int n = 0; n < count; n++ )
+        {
+            requests.push_back(session.CreateRequest(this, m_url));
+            requests.back().Start();
+        }
+
+        RunLoop();
+    }
+
+    // Run the single request stored in m_request.
+    void RunRequest()
+    {
+        m_count = 1;
+        m_request.Start();
+
+        RunLoop();
+    }
+
+    void ResumeRequest()
+    {
+        m_request.Resume();
+    }
+
+    void RunLoop()
+    {
+        StartOnce(30000);
+        m_loop.Run();
+        Stop();
+    }
+
+    void Notify() wxOVERRIDE
+    {
+        WARN("Exiting loop on timeout");
+        m_loop.Exit();
+    }
+
+    LoopbackHTTPServer m_server;
+    wxEventLoop m_loop;
+    wxString m_url;
+    wxString m_expected;
+    wxWebRequest m_request;
+    int m_count;
+    int m_completed;
+    int m_succeeded;
+    int m_progressEvents;
+
+private:
+    void OnRequestState(wxWebRequestEvent& evt)
+    {
+        switch ( evt.GetState() )
+        {
+            case wxWebRequest::State_Completed:
+                if ( evt.GetResponse().GetStatus() == 200 &&
+                        evt.GetResponse().AsString() == m_expected )
+                    m_succeeded++;
+                wxFALLTHROUGH;
+
+            case wxWebRequest::State_Unauthorized:
+            case wxWebRequest::State_Failed:
+            case wxWebRequest::State_Cancelled:
+                if ( ++m_completed == m_count )
+                    m_loop.Exit();
+                break;
+
+            case wxWebRequest::State_Idle:
+            case wxWebRequest::State_Active:
+                break;
+        }
+    }
+
+    void OnProgress(wxWebRequestEvent& WXUNUSED(evt))
+    {
+        m_progressEvents++;
+    }
+};
+
+// Sink checking the received data and pausing the transfer after every other
+// block, the transfer is resumed later from the main loop.
+class PausingSink : public wxWebRequestSink
+{
+public:
+    explicit PausingSink(LoopbackFixture& fixture)
+        : m_fixture(fixture),
+          m_received(0),
+          m_blocks(0),
+          m_pauses(0),
+          m_ok(true)
+    {
+    }
+
+    virtual Result OnData(const void* data, size_t size) wxOVERRIDE
+    {
+        if ( ++m_blocks % 2 == 0 )
+        {
+            m_pauses++;
+            m_fixture.CallAfter(&LoopbackFixture::ResumeRequest);
+            return Result_Pause;
+        }
+
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for ( size_t n = 0; n < size; n++ )
+        {
+            if ( p[n] != (m_received + n) % 251 )
+                m_ok = false;
+        }
+
+        m_received += size;
+
+        return Result_Continue;
+    }
+
+    LoopbackFixture& m_fixture;
+    size_t m_received;
+    int m_blocks;
+    int m_pauses;
+    bool m_ok;
+};
+
+} // anonymous namespace
+
+TEST_CASE_METHOD(LoopbackFixture,
+                 "WebRequest::Session::Connections", "[net][webrequest]")
+{
+    if ( !wxWebSession::IsBackendAvailable(wxWebSessionBackendCURL) )
+        return;
+
+    REQUIRE( StartServer() );
+
+    static const int NUM_REQUESTS = 20;
+
+    wxWebSession session = wxWebSession::New(wxWebSessionBackendCURL);
+    REQUIRE( session.IsOpened() );
+
+    SECTION("Single connection")
+    {
+        REQUIRE( session.SetMaxConnectionsPerHost(1) );
+        CHECK( session.EnableSharedCache() );
+        CHECK( session.SetKeepAlive(30) );
+
+        RunRequests(session, NUM_REQUESTS);
+
+        CHECK( m_succeeded == NUM_REQUESTS );
+        CHECK( m_server.GetRequests() == NUM_REQUESTS );
+        CHECK( m_server.GetConnections() == 1 );
+    }
+
+    SECTION("Limited connections")
+    {
+        REQUIRE( session.SetMaxConnections(4) );
+
+        RunRequests(session, NUM_REQUESTS);
+
+        CHECK( m_succeeded == NUM_REQUESTS );
+        CHECK( m_server.GetConnections() <= 4 );
+    }
+
+    SECTION("Invalid values")
+    {
+        WX_ASSERT_FAILS_WITH_ASSERT( session.SetMaxConnectionsPerHost(-1) );
+        WX_ASSERT_FAILS_WITH_ASSERT( session.SetMaxIdleTime(-1) );
+    }
+}
+
+TEST_CASE_METHOD(LoopbackFixture,
+                 "WebRequest::Sink", "[net][webrequest]")
+{
+    if ( !wxWebSession::IsBackendAvailable(wxWebSessionBackendCURL) )
+        return;
+
+    static const size_t BODY_SIZE = 4*1024*1024;
+
+    wxCharBuffer body(BODY_SIZE);
+    for ( size_t n = 0; n < BODY_SIZE; n++ )
+        body.data()[n] = static_cast<char>(n % 251);
+    m_server.SetBody(body);
+
+    REQUIRE( StartServer() );
+
+    wxWebSession session = wxWebSession::New(wxWebSessionBackendCURL);
+    REQUIRE( session.IsOpened() );
+
+    m_expected.clear();
+    m_request = session.CreateRequest(this, m_url);
+    m_request.SetProgressInterval(1);
+
+    SECTION("Pausing")
+    {
+        PausingSink* const sink = new PausingSink(*this);
+        REQUIRE( m_request.SetDataSink(sink) );
+        CHECK( m_request.GetStorage() == wxWebRequest::Storage_None );
+
+        RunRequest();
+
+        CHECK( m_succeeded == 1 );
+        CHECK( sink->m_ok );
+        CHECK( sink->m_received == BODY_SIZE );
+        CHECK( sink->m_pauses > 0 );
+    }
+
+    SECTION("Stream")
+    {
+        wxMemoryOutputStream out;
+        REQUIRE( m_request.SetDataSink(new wxWebRequestStreamSink(out)) );
+
+        RunRequest();
+
+        CHECK( m_succeeded == 1 );
+        REQUIRE( out.GetLength() == static_cast<wxFileOffset>(BODY_SIZE) );
+        CHECK( memcmp(out.GetOutputStreamBuffer()->GetBufferStart(),
+                      body.data(), BODY_SIZE) == 0 );
+    }
+
+    CHECK( m_request.GetBytesReceived() == static_cast<wxFileOffset>(BODY_SIZE) );
+
+    // There must be at least one progress event, but not too many of them.
+    CHECK( m_progressEvents > 0 );
+    CHECK( m_progressEvents < 1000 );
+
+    m_request = wxWebRequest();
+}
+
+#endif // wxHAS_SOCKET_SERVER_POOL
+
 #endif // wxUSE_WEBREQUEST
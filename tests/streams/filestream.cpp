@@ -144,3 +144,234 @@ wxString fileStream::GetInFileName() const
 // Register the stream sub suite, by using some stream helper macro.
 // Note: Don't forget to connect it to the base suite (See: bstream.cpp => StreamCase::suite())
 STREAM_TEST_SUBSUITE_NAMED_REGISTRATION(fileStream)
+
+// ----------------------------------------------------------------------------
+// wxMappedFileInputStream
+// ----------------------------------------------------------------------------
+
+#include "wx/mstream.h"
+#include "wx/scopedptr.h"
+
+#include "testfile.h"
+
+TEST_CASE("wxMappedFileInputStream", "[stream][file][mapped]")
+{
+    TempFile tmp("mappedstream.test");
+
+    char buf[DATABUFFER_SIZE];
+    for ( size_t i = 0; i < DATABUFFER_SIZE; i++ )
+        buf[i] = (i % 0xFF);
+
+    {
+        wxFileOutputStream out(tmp.GetName());
+        REQUIRE( out.WriteAll(buf, DATABUFFER_SIZE) );
+    }
+
+    wxMappedFileInputStream in(tmp.GetName(), wxMAPPED_FILE_ACCESS_SEQUENTIAL);
+    REQUIRE( in.IsOk() );
+    CHECK( in.IsSeekable() );
+    CHECK( in.GetLength() == DATABUFFER_SIZE );
+
+    SECTION("Data")
+    {
+#if defined(__UNIX__) || defined(__WINDOWS__)
+        REQUIRE( in.IsMapped() );
+        REQUIRE( in.GetDataLength() == DATABUFFER_SIZE );
+        CHECK( memcmp(in.GetData(), buf, DATABUFFER_SIZE) == 0 );
+#endif
+    }
+
+    SECTION("Read")
+    {
+        char data[DATABUFFER_SIZE];
+        CHECK( in.ReadAll(data, DATABUFFER_SIZE) );
+        CHECK( memcmp(data, buf, DATABUFFER_SIZE) == 0 );
+
+        CHECK( !in.CanRead() );
+        CHECK( in.GetC() == wxEOF );
+        CHECK( in.Eof() );
+    }
+
+    SECTION("Seek")
+    {
+        CHECK( in.SeekI(100) == 100 );
+        CHECK( in.GetC() == buf[100] );
+        CHECK( in.TellI() == 101 );
+
+        CHECK( in.SeekI(-1, wxFromEnd) == DATABUFFER_SIZE - 1 );
+        CHECK( in.GetC() == buf[DATABUFFER_SIZE - 1] );
+    }
+
+    SECTION("Memory")
+    {
+        in.SeekI(10);
+
+        wxMemoryInputStream mem(in);
+        REQUIRE( mem.GetLength() == DATABUFFER_SIZE - 10 );
+
+        // The data is shared with the mapped stream if it's really mapped.
+        if ( in.IsMapped() )
+        {
+            CHECK( mem.GetInputStreamBuffer()->GetBufferStart() ==
+                    static_cast<const char*>(in.GetData()) + 10 );
+        }
+
+        // And the mapped stream data is consumed as usual.
+        CHECK( in.TellI() == DATABUFFER_SIZE );
+
+        char data[DATABUFFER_SIZE - 10];
+        CHECK( mem.ReadAll(data, sizeof(data)) );
+        CHECK( memcmp(data, buf + 10, sizeof(data)) == 0 );
+    }
+
+    SECTION("Lifetime")
+    {
+        wxScopedPtr<wxMappedFileInputStream>
+            mapped(new wxMappedFileInputStream(tmp.GetName()));
+        wxMemoryInputStream mem(*mapped);
+
+        // The memory stream must remain usable after the mapped one is gone.
+        mapped.reset();
+
+        char data[DATABUFFER_SIZE];
+        CHECK( mem.ReadAll(data, DATABUFFER_SIZE) );
+        CHECK( memcmp(data, buf, DATABUFFER_SIZE) == 0 );
+    }
+}
+
+TEST_CASE("wxFileStream::ReadV/WriteV", "[stream][file][iovec]")
+{
+    TempFile tmp("iovecstream.test");
+
+    static const char hdr[] = "header";
+    char buf[DATABUFFER_SIZE];
+    for ( size_t i = 0; i < DATABUFFER_SIZE; i++ )
+        buf[i] = (i % 0xFF);
+
+    {
+        wxFileOutputStream out(tmp.GetName());
+        const wxIOVec vec[] =
+        {
+            wxIOVec(hdr, strlen(hdr)),
+            wxIOVec(),
+            wxIOVec(buf, DATABUFFER_SIZE),
+        };
+
+        out.WriteV(vec, WXSIZEOF(vec));
+        CHECK( out.LastWrite() == strlen(hdr) + DATABUFFER_SIZE );
+        CHECK( out.IsOk() );
+    }
+
+    wxFileInputStream in(tmp.GetName());
+    REQUIRE( in.GetLength() == wxFileOffset(strlen(hdr) + DATABUFFER_SIZE) );
+
+    char hdrIn[sizeof(hdr)] = { 0 };
+    char bufIn[DATABUFFER_SIZE];
+    char extra[10];
+    const wxIOVec vec[] =
+    {
+        wxIOVec(hdrIn, strlen(hdr)),
+        wxIOVec(bufIn, DATABUFFER_SIZE),
+        wxIOVec(extra, WXSIZEOF(extra)),
+    };
+
+    in.ReadV(vec, WXSIZEOF(vec));
+    CHECK( in.LastRead() == strlen(hdr) + DATABUFFER_SIZE );
+    CHECK( strcmp(hdrIn, hdr) == 0 );
+    CHECK( memcmp(bufIn, buf, DATABUFFER_SIZE) == 0 );
+
+    in.ReadV(vec, WXSIZEOF(vec));
+    CHECK( in.LastRead() == 0 );
+    CHECK( in.Eof() );
+}
+
+TEST_CASE("wxBufferedStream::Large", "[stream][buffered]")
+{
+    TempFile tmp("bufferedstream.test");
+
+    // Use a buffer big enough to be not buffered at all.
+    const size_t size = 256*1024;
+    wxCharBuffer buf(size);
+    for ( size_t i = 0; i < size; i++ )
+        buf.data()[i] = (i % 0x7D);
+
+    {
+        wxFileOutputStream file(tmp.GetName());
+        wxBufferedOutputStream out(file);
+
+        // Mix small writes, which are buffered, with the big ones, which are
+        // not.
+        out.Write(buf.data(), 10);
+        CHECK( out.LastWrite() == 10 );
+        out.Write(buf.data() + 10, size/2 - 10);
+        CHECK( out.LastWrite() == size/2 - 10 );
+
+        const wxIOVec vec[] =
+        {
+            wxIOVec(buf.data() + size/2, 1),
+            wxIOVec(buf.data() + size/2 + 1, size/2 - 1),
+        };
+        out.WriteV(vec, WXSIZEOF(vec));
+        CHECK( out.LastWrite() == size/2 );
+
+        CHECK( out.TellO() == wxFileOffset(size) );
+        CHECK( out.Close() );
+    }
+
+    wxFileInputStream file(tmp.GetName());
+    wxBufferedInputStream in(file);
+    REQUIRE( in.GetLength() == wxFileOffset(size) );
+
+    wxCharBuffer data(size);
+
+    SECTION("Read")
+    {
+        CHECK( in.GetC() == buf[0] );
+        CHECK( in.ReadAll(data.data() + 1, size - 1) );
+        CHECK( memcmp(data.data() + 1, buf.data() + 1, size - 1) == 0 );
+        CHECK( in.GetC() == wxEOF );
+    }
+
+    SECTION("Seek")
+    {
+        // Read a big chunk which doesn't go through the buffer and check that
+        // we can still seek back inside it.
+        CHECK( in.Read(data.data(), size/2).LastRead() == size/2 );
+        CHECK( in.TellI() == wxFileOffset(size/2) );
+        CHECK( in.SeekI(-10, wxFromCurrent) == wxFileOffset(size/2 - 10) );
+        CHECK( in.GetC() == buf[size/2 - 10] );
+
+        CHECK( in.SeekI(1000) == 1000 );
+        CHECK( in.GetC() == buf[1000] );
+    }
+
+    SECTION("Small")
+    {
+        // Read the data in small chunks to let the buffer grow.
+        for ( size_t n = 0; n < size/2; n += 100 )
+        {
+            const size_t len = wxMin(100, size/2 - n);
+            REQUIRE( in.Read(data.data() + n, len).LastRead() == len );
+        }
+
+        CHECK( memcmp(data.data(), buf.data(), size/2) == 0 );
+        CHECK( in.GetInputStreamBuffer()->GetBufferSize() > 1024 );
+
+        // Seeking resets the buffer size back to its initial value.
+        CHECK( in.SeekI(0) == 0 );
+        CHECK( in.GetC() == buf[0] );
+        CHECK( in.GetInputStreamBuffer()->GetBufferSize() == 1024 );
+    }
+
+    SECTION("ReadV")
+    {
+        const wxIOVec vec[] =
+        {
+            wxIOVec(data.data(), 3),
+            wxIOVec(data.data() + 3, size - 3),
+        };
+        in.ReadV(vec, WXSIZEOF(vec));
+        CHECK( in.LastRead() == size );
+        CHECK( memcmp(data.data(), buf.data(), size) == 0 );
+    }
+}
@@ -17,6 +17,8 @@
 
 #include "bstream.h"
 
+#include <lzma.h>
+
 class LZMAStream : public BaseStreamTestCase<wxLZMAInputStream, wxLZMAOutputStream>
 {
 public:
@@ -84,4 +86,79 @@ wxLZMAOutputStream *LZMAStream::DoCreateOutStream()
     return new wxLZMAOutputStream(new wxMemoryOutputStream());
 }
 
+// Both seeking and multi-threaded decompression require liblzma 5.4 or later.
+#if LZMA_VERSION >= 50040002
+
+TEST_CASE("wxLZMAStream::Seek", "[stream][lzma]")
+{
+    // Create data in several xz blocks, which is required for seeking.
+    wxCharBuffer data(100000);
+    for ( size_t n = 0; n < data.length(); n++ )
+        data.data()[n] = static_cast<char>((n*7 + n/1000) & 0xff);
+
+    wxMemoryOutputStream outmem;
+    {
+        wxLZMAOutputStream outz(outmem);
+        REQUIRE( outz.SetThreadCount(2, 16384) );
+        CHECK( outz.GetThreadCount() == 2 );
+        REQUIRE( outz.WriteAll(data, data.length()) );
+        REQUIRE( outz.Close() );
+    }
+
+    wxMemoryInputStream inmem(outmem);
+    wxLZMAInputStream inz(inmem);
+    CHECK( !inz.IsSeekable() );
+    CHECK( inz.GetLength() == wxInvalidOffset );
+
+    REQUIRE( inz.LoadIndex() );
+    CHECK( inz.IsSeekable() );
+    CHECK( inz.GetLength() == wxFileOffset(data.length()) );
+
+    const size_t offsets[] = { 50000, 10, 99999, 16384, 16383, 70000 };
+    for ( size_t n = 0; n < WXSIZEOF(offsets); n++ )
+    {
+        const size_t ofs = offsets[n];
+        INFO("Offset " << ofs);
+        REQUIRE( inz.SeekI(ofs) == wxFileOffset(ofs) );
+        CHECK( inz.TellI() == wxFileOffset(ofs) );
+
+        char buf[100];
+        const size_t len = wxMin(sizeof(buf), data.length() - ofs);
+        REQUIRE( inz.Read(buf, len).LastRead() == len );
+        CHECK( memcmp(buf, data.data() + ofs, len) == 0 );
+    }
+
+    // Reading everything after a seek must work too.
+    REQUIRE( inz.SeekI(1000) == 1000 );
+    wxCharBuffer rest(data.length() - 1000);
+    REQUIRE( inz.Read(rest.data(), rest.length()).LastRead() == rest.length() );
+    CHECK( memcmp(rest, data.data() + 1000, rest.length()) == 0 );
+
+    REQUIRE( inz.SeekI(0, wxFromEnd) == wxFileOffset(data.length()) );
+    CHECK( inz.GetC() == wxEOF );
+}
+
+TEST_CASE("wxLZMAStream::Threads", "[stream][lzma]")
+{
+    const char data[] = "Some data compressed and decompressed using threads";
+
+    wxMemoryOutputStream outmem;
+    wxLZMAOutputStream outz(outmem);
+    REQUIRE( outz.SetThreadCount(0) );
+    CHECK( outz.GetThreadCount() >= 1 );
+    REQUIRE( outz.WriteAll(data, sizeof(data)) );
+    REQUIRE( outz.Close() );
+
+    wxMemoryInputStream inmem(outmem);
+    wxLZMAInputStream inz(inmem);
+    REQUIRE( inz.SetThreadCount(4) );
+    CHECK( inz.GetThreadCount() == 4 );
+
+    char buf[sizeof(data)];
+    REQUIRE( inz.Read(buf, sizeof(buf)).LastRead() == sizeof(buf) );
+    CHECK( memcmp(buf, data, sizeof(data)) == 0 );
+}
+
+#endif // liblzma >= 5.4
+
 #endif // wxUSE_LIBLZMA && wxUSE_STREAMS
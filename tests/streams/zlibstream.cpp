@@ -548,3 +548,68 @@ void zlibStream::genExtTestData(wxTextOutputStream &out, const char *buf, int fl
 // Note: Don't forget to connect it to the base suite (See: bstream.cpp => StreamCase::suite())
 STREAM_TEST_SUBSUITE_NAMED_REGISTRATION(zlibStream)
 
+
+// ----------------------------------------------------------------------------
+// Parallel compression tests
+// ----------------------------------------------------------------------------
+
+#if wxUSE_THREADS
+
+TEST_CASE("wxZlibOutputStream::SetThreadCount", "[stream][zlib][threads]")
+{
+    // Generate some compressible, but not too much, data spanning several
+    // blocks.
+    const size_t size = 1024*1024 + 123;
+    wxCharBuffer data(size);
+    unsigned seed = 17;
+    for ( size_t n = 0; n < size; n++ )
+    {
+        seed = seed*1103515245 + 12345;
+        data.data()[n] = "abcdefgh"[(seed >> 16) % 8];
+    }
+
+    static const char dict[] = "hgfedcba";
+
+    int flags = wxZLIB_NO_HEADER;
+    bool useDict = false;
+
+    SECTION("Raw") { }
+    SECTION("Zlib") { flags = wxZLIB_ZLIB; }
+    SECTION("Gzip") { flags = wxZLIB_GZIP; }
+    SECTION("Dictionary") { useDict = true; }
+
+    wxMemoryOutputStream mo;
+    {
+        wxZlibOutputStream zo(mo, wxZ_DEFAULT_COMPRESSION, flags);
+        REQUIRE( zo.SetThreadCount(4, 64*1024) );
+        CHECK( zo.GetThreadCount() == 4 );
+
+        if ( useDict )
+            REQUIRE( zo.SetDictionary(dict, strlen(dict)) );
+
+        // Write the data using chunks of different sizes and flush it once
+        // in the middle.
+        REQUIRE( zo.WriteAll(data, 1000) );
+        REQUIRE( zo.WriteAll(data.data() + 1000, size/2 - 1000) );
+        zo.Sync();
+        REQUIRE( zo.WriteAll(data.data() + size/2, size - size/2) );
+        CHECK( zo.TellO() == wxFileOffset(size) );
+        CHECK( zo.Close() );
+    }
+
+    // The output must be really compressed and readable by the usual stream.
+    CHECK( mo.GetSize() < size/2 );
+
+    wxMemoryInputStream mi(mo);
+    wxZlibInputStream zi(mi, flags);
+    if ( useDict )
+        REQUIRE( zi.SetDictionary(dict, strlen(dict)) );
+
+    wxCharBuffer result(size);
+    CHECK( zi.ReadAll(result.data(), size) );
+    CHECK( memcmp(result, data, size) == 0 );
+    CHECK( zi.GetC() == wxEOF );
+    CHECK( zi.Eof() );
+}
+
+#endif // wxUSE_THREADS
@@ -175,6 +175,12 @@ inline ImageRGBMatcher RGBSimilarTo(const wxImage& image, int tolerance)
     return ImageRGBMatcher(image, tolerance, false);
 }
 
+// Same as RGBSimilarTo() but also checks the alpha channel.
+inline ImageRGBMatcher RGBASimilarTo(const wxImage& image, int tolerance)
+{
+    return ImageRGBMatcher(image, tolerance, true);
+}
+
 class ImageAlphaMatcher : public Catch::MatcherBase<wxImage>
 {
 public: